@@ -8,6 +8,10 @@
 #include "legato.h"
 #include "interfaces.h"
 #include "lwm2mcorePackageDownloader.h"
+#include "healthCheck.h"
+#include "downloadShaper.h"
+#include "natKeepalive.h"
+#include "osUdp.h"
 
 
 //--------------------------------------------------------------------------------------------------
@@ -294,6 +298,20 @@ le_result_t packageDownloader_GetResumeInfo
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a package URI identifies a pushed package
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+bool packagePush_IsPushUri
+(
+    const char* uriPtr      ///< [IN] Package URI
+)
+{
+    return false;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get the number of bytes to download on resume. Function will give valid data if suspend
@@ -563,6 +581,155 @@ void avcApp_DeletePackage
     return;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a SOTA transaction
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_BeginTransaction
+(
+    void
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Commit the SOTA transaction
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_CommitTransaction
+(
+    void
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the health check
+ */
+//--------------------------------------------------------------------------------------------------
+void healthCheck_Init
+(
+    void
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a health check is running
+ */
+//--------------------------------------------------------------------------------------------------
+bool healthCheck_IsRunning
+(
+    void
+)
+{
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the probation of an install: the installs are not checked
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t healthCheck_Start
+(
+    healthCheck_Update_t update,
+    const char* const* appNamesPtr,
+    size_t appCount,
+    healthCheck_ResultHandlerFunc_t handler,
+    void* contextPtr
+)
+{
+    return LE_NOT_PERMITTED;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report a registration to the AirVantage server
+ */
+//--------------------------------------------------------------------------------------------------
+void healthCheck_ReportRegistration
+(
+    void
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set and store the download shaper configuration
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_SetConfig
+(
+    const downloadShaper_Config_t* configPtr
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the NAT keepalive
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_Init
+(
+    void
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the NAT keepalive: the keepalive is disabled
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t natKeepalive_Start
+(
+    const char* keyPtr,
+    natKeepalive_ProbeFunc_t probeFunc,
+    natKeepalive_BindingLostFunc_t lostFunc
+)
+{
+    return LE_NOT_PERMITTED;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the NAT keepalive
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_Stop
+(
+    void
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the handler reconnecting the session on the other address family
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_SetFamilyFallbackHandler
+(
+    osUdp_FamilyFallbackFunc_t handlerPtr
+)
+{
+    return;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Config Tree service stubbing
 //--------------------------------------------------------------------------------------------------
@@ -754,6 +921,82 @@ bool le_cfg_GetBool
     return true;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_AddChangeHandler() stub.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_ChangeHandlerRef_t le_cfg_AddChangeHandler
+(
+    const char* newPath,                    ///< [IN] Path to the node to watch
+    le_cfg_ChangeHandlerFunc_t handlerPtr,  ///< [IN] Handler called on a change
+    void* contextPtr                        ///< [IN] Handler context
+)
+{
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GoToFirstChild() stub.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GoToFirstChild
+(
+    le_cfg_IteratorRef_t iteratorRef
+        ///< [IN]
+        ///< Iterator object to move.
+)
+{
+    return LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GoToNextSibling() stub.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GoToNextSibling
+(
+    le_cfg_IteratorRef_t iteratorRef
+        ///< [IN]
+        ///< Iterator to iterate.
+)
+{
+    return LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetNodeName() stub.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GetNodeName
+(
+    le_cfg_IteratorRef_t iteratorRef,
+        ///< [IN]
+        ///< Iterator object to use to read from the tree.
+
+    const char* path,
+        ///< [IN]
+        ///< Path to the target node. Can be an absolute path, or
+        ///< a path relative from the iterator's current position.
+
+    char* name,
+        ///< [OUT]
+        ///< Read the name of the node object.
+
+    size_t nameNumElements
+        ///< [IN]
+)
+{
+    return LE_NOT_FOUND;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function must be called to retrieve the International Mobile Equipment Identity (IMEI).
@@ -799,6 +1042,30 @@ void le_data_ConnectService
    return;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulated data connection state handler
+ */
+//--------------------------------------------------------------------------------------------------
+static le_data_ConnectionStateHandlerFunc_t ConnectionStateHandler = NULL;
+static void* ConnectionStateContextPtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate a data connection state change
+ */
+//--------------------------------------------------------------------------------------------------
+void le_avcTest_SimulateDataConnection
+(
+    bool connected      ///< [IN] Connection state
+)
+{
+    if (NULL != ConnectionStateHandler)
+    {
+        ConnectionStateHandler("rmnet_data0", connected, ConnectionStateContextPtr);
+    }
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function adds a handler...
@@ -810,6 +1077,8 @@ le_data_ConnectionStateHandlerRef_t le_data_AddConnectionStateHandler
     void* contextPtr                                    ///< [IN] Associated context pointer
 )
 {
+    ConnectionStateHandler = handlerPtr;
+    ConnectionStateContextPtr = contextPtr;
     return (le_data_ConnectionStateHandlerRef_t)0x100A;
 }
 
@@ -883,7 +1152,8 @@ void le_data_RemoveConnectionStateHandler
     le_data_ConnectionStateHandlerRef_t addHandlerRef   ///< [IN] Connection state handler reference
 )
 {
-    return;
+    ConnectionStateHandler = NULL;
+    ConnectionStateContextPtr = NULL;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -7,6 +7,7 @@
 
 #include "legato.h"
 #include "interfaces.h"
+#include <lwm2mcore/connectivity.h>
 
 
 //--------------------------------------------------------------------------------------------------
@@ -21,6 +22,28 @@
 static lwm2mcore_Status_t Status = {0};
 static lwm2mcore_StatusCb_t EventCb;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulated LwM2MCore instance: the port serves a single instance
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_INSTANCE_REF  ((lwm2mcore_Ref_t)(0x1009))
+static bool InstanceCreated = false;
+static bool InstanceConnected = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a connection was initiated on a given instance
+ */
+//--------------------------------------------------------------------------------------------------
+bool le_avcTest_IsInstanceConnected
+(
+    lwm2mcore_Ref_t instanceRef     ///< Instance reference
+)
+{
+    return (InstanceCreated && (STUB_INSTANCE_REF == instanceRef) && InstanceConnected);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Simulated lifetime
@@ -73,8 +96,10 @@ lwm2mcore_Ref_t lwm2mcore_Init
     }
 
     EventCb = eventCb;
+    InstanceCreated = true;
+    InstanceConnected = false;
 
-    return (lwm2mcore_Ref_t)(0x1009);
+    return STUB_INSTANCE_REF;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -154,6 +179,7 @@ bool lwm2mcore_Disconnect
     lwm2mcore_Ref_t instanceRef     ///< [IN] instance reference
 )
 {
+    InstanceConnected = false;
     return true;
 }
 
@@ -168,7 +194,8 @@ void lwm2mcore_Free
     lwm2mcore_Ref_t instanceRef     ///< [IN] instance reference
 )
 {
-    return;
+    InstanceCreated = false;
+    InstanceConnected = false;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -199,6 +226,7 @@ bool lwm2mcore_Connect
     lwm2mcore_Ref_t instanceRef     ///< [IN] instance reference
 )
 {
+    InstanceConnected = true;
     return true;
 }
 
@@ -308,7 +336,8 @@ uint16_t lwm2mcore_ObjectRegister
     void * const servicePtr                  ///< [IN] Client service API table
 )
 {
-    return 0;
+    // The standard object list is registered
+    return 1;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -397,3 +426,45 @@ lwm2mcore_Sid_t lwm2mcore_ComputeHmacSHA256
 {
     return LWM2MCORE_ERR_COMPLETED_OK;
 }
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Retrieve the network bearer used for the current LWM2M communication session
+ *
+ * @return
+ *      - LWM2MCORE_ERR_COMPLETED_OK if the treatment succeeds
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_Sid_t lwm2mcore_GetNetworkBearer
+(
+    lwm2mcore_networkBearer_enum_t* valuePtr    ///< [INOUT] data buffer
+)
+{
+    *valuePtr = LWM2MCORE_NETWORK_BEARER_LTE_FDD;
+    return LWM2MCORE_ERR_COMPLETED_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Retrieve the serving Mobile Network Code and/or the serving Mobile Country Code
+ *
+ * @return
+ *      - LWM2MCORE_ERR_COMPLETED_OK if the treatment succeeds
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_Sid_t lwm2mcore_GetMncMcc
+(
+    uint16_t* mncPtr,   ///< [INOUT] MNC buffer, NULL if not needed
+    uint16_t* mccPtr    ///< [INOUT] MCC buffer, NULL if not needed
+)
+{
+    if (mncPtr)
+    {
+        *mncPtr = 1;
+    }
+    if (mccPtr)
+    {
+        *mccPtr = 208;
+    }
+    return LWM2MCORE_ERR_COMPLETED_OK;
+}
@@ -429,6 +429,26 @@ void le_avcTest_SimulateLwm2mEvent
     uint32_t progress                ///< For package download, package download progress in %
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a connection was initiated on a given instance
+ */
+//--------------------------------------------------------------------------------------------------
+bool le_avcTest_IsInstanceConnected
+(
+    lwm2mcore_Ref_t instanceRef     ///< Instance reference
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate a data connection state change
+ */
+//--------------------------------------------------------------------------------------------------
+void le_avcTest_SimulateDataConnection
+(
+    bool connected      ///< [IN] Connection state
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Adaptation function for timer state
@@ -8,6 +8,7 @@
 #include"packageDownloader.h"
 #include "interfaces.h"
 #include"avcServer.h"
+#include "avcClient.h"
 
 //--------------------------------------------------------------------------------------------------
 // Symbol and Enum definitions
@@ -27,6 +28,13 @@
 //--------------------------------------------------------------------------------------------------
 #define LONG_TIMEOUT    10
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Short server Id of the additional LwM2M server
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_SERVER_ID  2
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  Application context structure
@@ -391,6 +399,76 @@ static void RestartSession
     le_sem_Post(appCtxPtr->appSemaphore);
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test: configuration of several LwM2M servers.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestMultiServer
+(
+    void* param1Ptr, /// Value to be passed as param1Ptr to the function
+    void* param2Ptr  /// Value to be passed as param2Ptr to the function
+)
+{
+    LE_INFO("======== Test multi-server ========");
+    AppContext_t* appCtxPtr = (AppContext_t*) param1Ptr;
+
+    uint16_t serverIds[AVC_CLIENT_MAX_SERVERS];
+    size_t numServers = NUM_ARRAY_MEMBERS(serverIds);
+    char name[AVC_CLIENT_SERVER_NAME_BYTES];
+
+    // Only the default server is configured
+    LE_ASSERT_OK(avcClient_GetServerList(serverIds, &numServers));
+    LE_ASSERT(1 == numServers);
+    LE_ASSERT(AVC_CLIENT_DEFAULT_SERVER_ID == serverIds[0]);
+
+    // Add a second server
+    LE_ASSERT(LE_BAD_PARAMETER == avcClient_AddServer(AVC_CLIENT_ANY_SERVER_ID, "any"));
+    LE_ASSERT(LE_DUPLICATE == avcClient_AddServer(AVC_CLIENT_DEFAULT_SERVER_ID, "default"));
+    LE_ASSERT_OK(avcClient_AddServer(TEST_SERVER_ID, "test"));
+    LE_ASSERT(LE_DUPLICATE == avcClient_AddServer(TEST_SERVER_ID, "test"));
+
+    numServers = 1;
+    LE_ASSERT(LE_OVERFLOW == avcClient_GetServerList(serverIds, &numServers));
+    numServers = NUM_ARRAY_MEMBERS(serverIds);
+    LE_ASSERT_OK(avcClient_GetServerList(serverIds, &numServers));
+    LE_ASSERT(2 == numServers);
+    LE_ASSERT(AVC_CLIENT_DEFAULT_SERVER_ID == serverIds[0]);
+    LE_ASSERT(TEST_SERVER_ID == serverIds[1]);
+
+    // Only the default server has a LwM2MCore instance and a session
+    LE_ASSERT_OK(avcClient_Connect());
+    lwm2mcore_Ref_t defaultRef = avcClient_GetInstance();
+    LE_ASSERT(NULL != defaultRef);
+    LE_ASSERT(!le_avcTest_IsInstanceConnected(defaultRef));
+
+    le_avcTest_SimulateDataConnection(true);
+    LE_ASSERT(le_avcTest_IsInstanceConnected(defaultRef));
+
+    // The additional server only provides a credential namespace
+    LE_ASSERT_OK(avcClient_GetServerName(AVC_CLIENT_DEFAULT_SERVER_ID, name, sizeof(name)));
+    LE_ASSERT(0 == strcmp("AirVantage", name));
+    LE_ASSERT_OK(avcClient_GetServerName(TEST_SERVER_ID, name, sizeof(name)));
+    LE_ASSERT(0 == strcmp("test", name));
+    LE_ASSERT(LE_OVERFLOW == avcClient_GetServerName(TEST_SERVER_ID, name, 2));
+    LE_ASSERT(LE_NOT_FOUND == avcClient_GetServerName(TEST_SERVER_ID + 1, name, sizeof(name)));
+
+    // Remove the second server, the default server stays connected
+    LE_ASSERT(LE_NOT_PERMITTED == avcClient_RemoveServer(AVC_CLIENT_DEFAULT_SERVER_ID));
+    LE_ASSERT_OK(avcClient_RemoveServer(TEST_SERVER_ID));
+    LE_ASSERT(LE_NOT_FOUND == avcClient_RemoveServer(TEST_SERVER_ID));
+    LE_ASSERT(le_avcTest_IsInstanceConnected(defaultRef));
+    numServers = NUM_ARRAY_MEMBERS(serverIds);
+    LE_ASSERT_OK(avcClient_GetServerList(serverIds, &numServers));
+    LE_ASSERT(1 == numServers);
+
+    LE_ASSERT_OK(avcClient_Disconnect(true));
+    LE_ASSERT(NULL == avcClient_GetInstance());
+
+    le_sem_Post(appCtxPtr->appSemaphore);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Thread used to simulate an application
@@ -483,6 +561,11 @@ static void* AirVantageUnitTestThread
                                    Testle_avc_Polling, &AppCtx, NULL);
     SynchronizeTest();
 
+    // Test multi-server sessions
+    le_event_QueueFunctionToThread(AppCtx.appThreadRef,
+                                   TestMultiServer, &AppCtx, NULL);
+    SynchronizeTest();
+
     LE_INFO("======== UnitTest of airVantage Connector Passed ========");
 
     exit(EXIT_SUCCESS);
@@ -0,0 +1,458 @@
+/**
+ * This module implements some stubs for appTransaction unit tests.
+ *
+ * The update daemon, the update control and the application removal are stubbed: their calls are
+ * appended to a log checked by the test. A package is a file containing the application name. The
+ * AVC filesystem is stubbed with a single in-memory file.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "avcFs.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of the stubbed file
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_FILE_MAX_BYTES     2048
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Log of the calls
+ */
+//--------------------------------------------------------------------------------------------------
+static char Log[1024] = "";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed systems: current index, index of the last good system and state of the current system
+ */
+//--------------------------------------------------------------------------------------------------
+static int32_t SysIndex = 1;
+static int32_t GoodSysIndex = 1;
+static le_updateCtrl_SystemState_t SystemState = LE_UPDATECTRL_SYSTEMSTATE_GOOD;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Whether the probation failure restores the last good system
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsRollbackWorking = true;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result of the probation lock
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t LockResult = LE_OK;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Application whose removal fails, empty if none
+ */
+//--------------------------------------------------------------------------------------------------
+static char FailingRemoval[LE_LIMIT_APP_NAME_LEN + 1] = "";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Package being unpacked
+ */
+//--------------------------------------------------------------------------------------------------
+static char Package[LE_LIMIT_APP_NAME_LEN + 1] = "";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed file
+ */
+//--------------------------------------------------------------------------------------------------
+static char    FilePath[PATH_MAX];
+static uint8_t FileData[STUB_FILE_MAX_BYTES];
+static size_t  FileSize = 0;
+static bool    FileExists = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an entry to the log
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_Log
+(
+    const char* entryPtr
+)
+{
+    if ('\0' != Log[0])
+    {
+        le_utf8_Append(Log, ",", sizeof(Log), NULL);
+    }
+    LE_ASSERT(LE_OK == le_utf8_Append(Log, entryPtr, sizeof(Log), NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the log and clear it
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_CheckLog
+(
+    const char* expectedPtr
+)
+{
+    LE_INFO("Log: %s", Log);
+    LE_ASSERT(0 == strcmp(Log, expectedPtr));
+    Log[0] = '\0';
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the stubs: good system 1, no journal
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_Reset
+(
+    void
+)
+{
+    Log[0] = '\0';
+    SysIndex = 1;
+    GoodSysIndex = 1;
+    SystemState = LE_UPDATECTRL_SYSTEMSTATE_GOOD;
+    IsRollbackWorking = true;
+    LockResult = LE_OK;
+    FailingRemoval[0] = '\0';
+    FileExists = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the index of the current system
+ */
+//--------------------------------------------------------------------------------------------------
+int32_t stub_GetSysIndex
+(
+    void
+)
+{
+    return SysIndex;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the state of the current system
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetSystemState
+(
+    le_updateCtrl_SystemState_t state
+)
+{
+    SystemState = state;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set whether the probation failure restores the last good system
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetRollbackWorking
+(
+    bool isWorking
+)
+{
+    IsRollbackWorking = isWorking;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the result of the probation lock
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetLockResult
+(
+    le_result_t result
+)
+{
+    LockResult = result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Make the removal of an application fail
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetFailingRemoval
+(
+    const char* appNamePtr
+)
+{
+    le_utf8_Copy(FailingRemoval, appNamePtr, sizeof(FailingRemoval), NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the stubbed file exists
+ */
+//--------------------------------------------------------------------------------------------------
+bool stub_IsJournalSaved
+(
+    void
+)
+{
+    return FileExists;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Update daemon stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_update_Start() stub: the package is read to log its application name
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_update_Start
+(
+    int fd
+)
+{
+    char entry[sizeof(Package) + 8];
+    ssize_t size = read(fd, Package, sizeof(Package) - 1);
+
+    close(fd);
+    LE_ASSERT(size > 0);
+    Package[size] = '\0';
+
+    snprintf(entry, sizeof(entry), "start:%s", Package);
+    stub_Log(entry);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_update_Install() stub: the install creates a new system
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_update_Install
+(
+    void
+)
+{
+    char entry[sizeof(Package) + 8];
+
+    snprintf(entry, sizeof(entry), "install:%s", Package);
+    stub_Log(entry);
+    SysIndex++;
+    SystemState = LE_UPDATECTRL_SYSTEMSTATE_PROBATION;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_update_End() stub
+ */
+//--------------------------------------------------------------------------------------------------
+void le_update_End
+(
+    void
+)
+{
+    stub_Log("end");
+    Package[0] = '\0';
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_update_GetCurrentSysIndex() stub
+ */
+//--------------------------------------------------------------------------------------------------
+int32_t le_update_GetCurrentSysIndex
+(
+    void
+)
+{
+    return SysIndex;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_appRemove_Remove() stub: the removal creates a new system
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_appRemove_Remove
+(
+    const char* appNamePtr
+)
+{
+    char entry[LE_LIMIT_APP_NAME_LEN + 8];
+
+    snprintf(entry, sizeof(entry), "remove:%s", appNamePtr);
+    stub_Log(entry);
+
+    if (0 == strcmp(appNamePtr, FailingRemoval))
+    {
+        return LE_FAULT;
+    }
+
+    SysIndex++;
+    SystemState = LE_UPDATECTRL_SYSTEMSTATE_PROBATION;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Update control stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_updateCtrl_GetSystemState() stub
+ */
+//--------------------------------------------------------------------------------------------------
+le_updateCtrl_SystemState_t le_updateCtrl_GetSystemState
+(
+    void
+)
+{
+    return SystemState;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_updateCtrl_LockProbation() stub
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_updateCtrl_LockProbation
+(
+    void
+)
+{
+    stub_Log("lock");
+    return LockResult;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_updateCtrl_UnlockProbation() stub
+ */
+//--------------------------------------------------------------------------------------------------
+void le_updateCtrl_UnlockProbation
+(
+    void
+)
+{
+    stub_Log("unlock");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_updateCtrl_FailProbation() stub: the framework restarts on the last good system, the test
+ * simulates the restart
+ */
+//--------------------------------------------------------------------------------------------------
+void le_updateCtrl_FailProbation
+(
+    void
+)
+{
+    stub_Log("failProbation");
+
+    if (IsRollbackWorking)
+    {
+        SysIndex = GoodSysIndex;
+        SystemState = LE_UPDATECTRL_SYSTEMSTATE_GOOD;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+// File system stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * ReadFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t ReadFs
+(
+    const char* pathPtr,   ///< File path
+    uint8_t*    bufPtr,    ///< Data buffer
+    size_t*     sizePtr    ///< Buffer size
+)
+{
+    if ((!FileExists) || (0 != strcmp(pathPtr, FilePath)))
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (*sizePtr < FileSize)
+    {
+        return LE_OVERFLOW;
+    }
+
+    memcpy(bufPtr, FileData, FileSize);
+    *sizePtr = FileSize;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * WriteFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t WriteFs
+(
+    const char* pathPtr,   ///< File path
+    uint8_t*    bufPtr,    ///< Data buffer
+    size_t      size       ///< Buffer size
+)
+{
+    if (size > STUB_FILE_MAX_BYTES)
+    {
+        return LE_NO_MEMORY;
+    }
+
+    LE_ASSERT(LE_OK == le_utf8_Copy(FilePath, pathPtr, sizeof(FilePath), NULL));
+    memcpy(FileData, bufPtr, size);
+    FileSize = size;
+    FileExists = true;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * DeleteFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t DeleteFs
+(
+    const char* pathPtr    ///< File path
+)
+{
+    if ((!FileExists) || (0 != strcmp(pathPtr, FilePath)))
+    {
+        return LE_NOT_FOUND;
+    }
+
+    FileExists = false;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * ExistsFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t ExistsFs
+(
+    const char* pathPtr ///< File path
+)
+{
+    if ((FileExists) && (0 == strcmp(pathPtr, FilePath)))
+    {
+        return LE_OK;
+    }
+
+    return LE_NOT_FOUND;
+}
@@ -0,0 +1,15 @@
+/**
+ * This module implements some stubs for appTransaction unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _INTERFACES_H
+#define _INTERFACES_H
+
+#include "le_update_interface.h"
+#include "le_updateCtrl_interface.h"
+#include "le_appRemove_interface.h"
+
+#endif /* interfaces.h */
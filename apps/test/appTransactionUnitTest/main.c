@@ -0,0 +1,406 @@
+/**
+ * This module implements the unit tests for the SOTA transactions.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "appTransaction.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Directories of the downloaded and staged packages
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_DIR            "/tmp/appTransactionUnitTest"
+#define STAGING_DIR         TEST_DIR "/staging"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub functions
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_Log(const char* entryPtr);
+void stub_CheckLog(const char* expectedPtr);
+void stub_Reset(void);
+int32_t stub_GetSysIndex(void);
+void stub_SetSystemState(le_updateCtrl_SystemState_t state);
+void stub_SetRollbackWorking(bool isWorking);
+void stub_SetLockResult(le_result_t result);
+void stub_SetFailingRemoval(const char* appNamePtr);
+bool stub_IsJournalSaved(void);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Last reported transaction result
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsResultReported = false;
+static le_result_t Result = LE_OK;
+static appTransaction_Item_t ResultItems[APP_TRANSACTION_MAX_ITEMS];
+static size_t ResultCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Step handler: the operations are logged
+ */
+//--------------------------------------------------------------------------------------------------
+static void StepHandler
+(
+    const appTransaction_Item_t* itemPtr,
+    void* contextPtr
+)
+{
+    char entry[LE_LIMIT_APP_NAME_LEN + 8];
+
+    snprintf(entry, sizeof(entry), "step:%s", itemPtr->appName);
+    stub_Log(entry);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResultHandler
+(
+    le_result_t result,
+    const appTransaction_Item_t* itemsPtr,
+    size_t count,
+    void* contextPtr
+)
+{
+    LE_ASSERT(!IsResultReported);
+    LE_ASSERT(count <= APP_TRANSACTION_MAX_ITEMS);
+
+    IsResultReported = true;
+    Result = result;
+    memcpy(ResultItems, itemsPtr, count * sizeof(appTransaction_Item_t));
+    ResultCount = count;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the reported result and clear it
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckResult
+(
+    le_result_t expectedResult,
+    size_t expectedCount
+)
+{
+    LE_ASSERT(IsResultReported);
+    LE_ASSERT(expectedResult == Result);
+    LE_ASSERT(expectedCount == ResultCount);
+    LE_ASSERT(APP_TRANSACTION_STATE_IDLE == appTransaction_GetState());
+    LE_ASSERT(!stub_IsJournalSaved());
+    LE_ASSERT(!le_dir_IsDir(STAGING_DIR));
+
+    IsResultReported = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate a restart of avcService
+ */
+//--------------------------------------------------------------------------------------------------
+static void Restart
+(
+    void
+)
+{
+    appTransaction_Init(STAGING_DIR, StepHandler, ResultHandler, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download a package, and stage its installation
+ */
+//--------------------------------------------------------------------------------------------------
+static void StagePackage
+(
+    uint16_t instanceId,
+    const char* appNamePtr,         ///< Application name known by the object 9 instance
+    const char* contentPtr          ///< Application in the package
+)
+{
+    char path[PATH_MAX];
+    FILE* filePtr;
+
+    snprintf(path, sizeof(path), "%s/%s.update", TEST_DIR, contentPtr);
+    filePtr = fopen(path, "w");
+    LE_ASSERT(NULL != filePtr);
+    LE_ASSERT(strlen(contentPtr) == fwrite(contentPtr, 1, strlen(contentPtr), filePtr));
+    fclose(filePtr);
+
+    LE_ASSERT_OK(appTransaction_StageInstall(instanceId, appNamePtr, path));
+    LE_ASSERT(0 != access(path, F_OK));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Install and remove several applications in dependency order
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestCommit
+(
+    void
+)
+{
+    LE_INFO("======== Test transaction commit ========");
+    stub_Reset();
+
+    LE_ASSERT(LE_BAD_PARAMETER == appTransaction_StageUninstall(1, "client"));
+    LE_ASSERT_OK(appTransaction_Begin());
+    LE_ASSERT(LE_BUSY == appTransaction_Begin());
+
+    StagePackage(1, "client", "client");
+    StagePackage(2, "server", "server");
+    LE_ASSERT_OK(appTransaction_StageUninstall(3, "oldClient"));
+    LE_ASSERT_OK(appTransaction_StageUninstall(4, "oldServer"));
+    LE_ASSERT(LE_DUPLICATE == appTransaction_StageUninstall(4, "otherApp"));
+    LE_ASSERT(LE_DUPLICATE == appTransaction_StageUninstall(5, "client"));
+    LE_ASSERT_OK(appTransaction_AddDependency("client", "server"));
+    LE_ASSERT_OK(appTransaction_AddDependency("client", "notStagedApp"));
+    LE_ASSERT_OK(appTransaction_AddDependency("oldClient", "oldServer"));
+    LE_ASSERT(LE_NOT_FOUND == appTransaction_AddDependency("notStagedApp", "server"));
+
+    // The packages are checked before the system is modified
+    LE_ASSERT_OK(appTransaction_Commit());
+    LE_ASSERT(APP_TRANSACTION_STATE_VALIDATING == appTransaction_GetState());
+    LE_ASSERT(appTransaction_IsRunning());
+    LE_ASSERT(LE_BUSY == appTransaction_Abort());
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_UNPACKING);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    stub_CheckLog("start:server,end,start:client,end,lock,step:server,start:server");
+    LE_ASSERT(APP_TRANSACTION_STATE_INSTALLING == appTransaction_GetState());
+    LE_ASSERT(stub_IsJournalSaved());
+
+    // The servers are installed first, the clients are removed first
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_APPLYING);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_SUCCESS);
+    stub_CheckLog("install:server,end,step:client,start:client");
+    LE_ASSERT(!IsResultReported);
+
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_SUCCESS);
+    stub_CheckLog("install:client,end,step:oldClient,remove:oldClient,"
+                  "step:oldServer,remove:oldServer,unlock");
+
+    CheckResult(LE_OK, 4);
+    LE_ASSERT((1 == ResultItems[0].instanceId) && (ResultItems[0].isDone));
+    LE_ASSERT((APP_TRANSACTION_UNINSTALL == ResultItems[3].operation) && (ResultItems[3].isDone));
+    LE_ASSERT(5 == stub_GetSysIndex());
+
+    // An empty transaction
+    LE_ASSERT_OK(appTransaction_Begin());
+    LE_ASSERT_OK(appTransaction_Commit());
+    CheckResult(LE_OK, 0);
+    stub_CheckLog("");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Transactions rejected before the system is modified
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestRejected
+(
+    void
+)
+{
+    LE_INFO("======== Test rejected transactions ========");
+    stub_Reset();
+
+    // Invalid package: the name of a new application is only known from its package
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "", "newApp");
+    StagePackage(2, "badApp", "badApp");
+    LE_ASSERT_OK(appTransaction_Commit());
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_FAILED);
+    stub_CheckLog("start:newApp,end,start:badApp,end");
+    CheckResult(LE_FORMAT_ERROR, 2);
+    LE_ASSERT(1 == stub_GetSysIndex());
+
+    // A new package depends on an application which is removed
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "client", "client");
+    LE_ASSERT_OK(appTransaction_StageUninstall(2, "server"));
+    LE_ASSERT_OK(appTransaction_AddDependency("client", "server"));
+    LE_ASSERT(LE_NOT_PERMITTED == appTransaction_Commit());
+    CheckResult(LE_NOT_PERMITTED, 2);
+
+    // Circular dependency
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "appA", "appA");
+    StagePackage(2, "appB", "appB");
+    LE_ASSERT_OK(appTransaction_AddDependency("appA", "appB"));
+    LE_ASSERT_OK(appTransaction_AddDependency("appB", "appA"));
+    LE_ASSERT(LE_NOT_PERMITTED == appTransaction_Commit());
+    CheckResult(LE_NOT_PERMITTED, 2);
+    stub_CheckLog("");
+
+    // The system of the previous update is still in probation
+    stub_SetSystemState(LE_UPDATECTRL_SYSTEMSTATE_PROBATION);
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "appA", "appA");
+    LE_ASSERT(LE_BUSY == appTransaction_Commit());
+    LE_ASSERT(APP_TRANSACTION_STATE_STAGING == appTransaction_GetState());
+    LE_ASSERT_OK(appTransaction_Abort());
+    LE_ASSERT(LE_BAD_PARAMETER == appTransaction_Abort());
+    LE_ASSERT(!le_dir_IsDir(STAGING_DIR));
+    LE_ASSERT(!IsResultReported);
+    stub_SetSystemState(LE_UPDATECTRL_SYSTEMSTATE_GOOD);
+
+    // The first install fails: nothing to roll back
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "appA", "appA");
+    LE_ASSERT_OK(appTransaction_Commit());
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_FAILED);
+    stub_CheckLog("start:appA,end,lock,step:appA,start:appA,install:appA,end,unlock");
+    CheckResult(LE_FAULT, 1);
+    LE_ASSERT(!ResultItems[0].isDone);
+
+    // The probation cannot be locked: the system is not modified
+    stub_Reset();
+    stub_SetLockResult(LE_NO_MEMORY);
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "appA", "appA");
+    LE_ASSERT_OK(appTransaction_Commit());
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    stub_CheckLog("start:appA,end,lock");
+    CheckResult(LE_NOT_POSSIBLE, 1);
+    LE_ASSERT(!ResultItems[0].isDone);
+    LE_ASSERT(1 == stub_GetSysIndex());
+    stub_SetLockResult(LE_OK);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Roll back to the system of the start of the transaction
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestRollback
+(
+    void
+)
+{
+    LE_INFO("======== Test transaction rollback ========");
+    stub_Reset();
+
+    // The second install fails
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "appA", "appA");
+    StagePackage(2, "appB", "appB");
+    LE_ASSERT_OK(appTransaction_StageUninstall(3, "appC"));
+    LE_ASSERT_OK(appTransaction_Commit());
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_FAILED);
+    stub_CheckLog("start:appA,end,start:appB,end,lock,step:appA,start:appA,install:appA,end,"
+                  "step:appB,start:appB,install:appB,end,failProbation");
+    LE_ASSERT(APP_TRANSACTION_STATE_ROLLING_BACK == appTransaction_GetState());
+    LE_ASSERT(!appTransaction_IsRunning());
+    LE_ASSERT(!IsResultReported);
+
+    // The result is reported after the restart on the previous system
+    LE_ASSERT(1 == stub_GetSysIndex());
+    Restart();
+    CheckResult(LE_FAULT, 3);
+    LE_ASSERT((ResultItems[0].isDone) && (!ResultItems[1].isDone) && (!ResultItems[2].isDone));
+    stub_CheckLog("");
+
+    // A removal fails
+    stub_SetFailingRemoval("appC");
+    LE_ASSERT_OK(appTransaction_Begin());
+    LE_ASSERT_OK(appTransaction_StageUninstall(2, "appB"));
+    LE_ASSERT_OK(appTransaction_StageUninstall(3, "appC"));
+    LE_ASSERT_OK(appTransaction_Commit());
+    stub_CheckLog("lock,step:appB,remove:appB,step:appC,remove:appC,failProbation");
+    Restart();
+    CheckResult(LE_FAULT, 2);
+    stub_SetFailingRemoval("");
+
+    // The current system is already good: the probation of the new system is locked after the
+    // first operation, the transaction is rolled back if it cannot be locked
+    stub_SetLockResult(LE_DUPLICATE);
+    LE_ASSERT_OK(appTransaction_Begin());
+    LE_ASSERT_OK(appTransaction_StageUninstall(2, "appB"));
+    LE_ASSERT_OK(appTransaction_StageUninstall(3, "appC"));
+    LE_ASSERT_OK(appTransaction_Commit());
+    stub_CheckLog("lock,step:appB,remove:appB,lock,failProbation");
+    Restart();
+    CheckResult(LE_FAULT, 2);
+    LE_ASSERT((ResultItems[0].isDone) && (!ResultItems[1].isDone));
+    stub_SetLockResult(LE_OK);
+
+    // The framework restarts during the installation: the transaction is rolled back
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "appA", "appA");
+    StagePackage(2, "appB", "appB");
+    LE_ASSERT_OK(appTransaction_Commit());
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_DOWNLOAD_SUCCESS);
+    appTransaction_UpdateProgress(LE_UPDATE_STATE_SUCCESS);
+    stub_CheckLog("start:appA,end,start:appB,end,lock,step:appA,start:appA,install:appA,end,"
+                  "step:appB,start:appB");
+    LE_ASSERT(2 == stub_GetSysIndex());
+
+    stub_SetRollbackWorking(false);
+    Restart();
+    stub_CheckLog("failProbation");
+    LE_ASSERT(APP_TRANSACTION_STATE_ROLLING_BACK == appTransaction_GetState());
+    LE_ASSERT(!IsResultReported);
+
+    // The previous system could not be restored
+    Restart();
+    CheckResult(LE_UNAVAILABLE, 2);
+
+    // Without journal, the operations staged before the restart are discarded
+    LE_ASSERT_OK(appTransaction_Begin());
+    StagePackage(1, "appA", "appA");
+    Restart();
+    LE_ASSERT(APP_TRANSACTION_STATE_IDLE == appTransaction_GetState());
+    LE_ASSERT(!le_dir_IsDir(STAGING_DIR));
+    LE_ASSERT(!IsResultReported);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the test.
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start appTransactionUnitTest =====================");
+
+    LE_ASSERT_OK(le_dir_MakePath(TEST_DIR, S_IRWXU));
+    Restart();
+
+    // Test - transaction applied in dependency order
+    TestCommit();
+
+    // Test - transactions rejected without modifying the system
+    TestRejected();
+
+    // Test - rollback of a failed transaction
+    TestRollback();
+
+    le_dir_RemoveRecursive(TEST_DIR);
+
+    LE_INFO("=============== appTransactionUnitTest successful ===================");
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,377 @@
+/**
+ * This module implements some stubs for assetData unit tests.
+ *
+ * The config tree is stubbed with a single asset model, served for any application asset: the
+ * asset has a configurable number of read/write integer fields, with field ids starting at 0.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the stubbed asset model
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_ASSET_NAME         "bench"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Position of the stubbed config iterator in the asset model
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    NODE_NONE,          ///< Outside of the asset model
+    NODE_ASSET,         ///< Asset node
+    NODE_FIELDS,        ///< Field list node
+    NODE_FIELD          ///< A field node
+}
+NodeLevel_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed config iterator; only one transaction is opened at a time by assetData
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    NodeLevel_t level;  ///< Position in the asset model
+    int fieldId;        ///< Current field, if level is NODE_FIELD
+}
+Iterator;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of fields of the stubbed asset model
+ */
+//--------------------------------------------------------------------------------------------------
+static int NumFields = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the number of fields of the asset model used by the next instance creation
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetAssetModel
+(
+    int numFields       ///< [IN] Number of fields
+)
+{
+    NumFields = numFields;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Config Tree service stubbing
+//--------------------------------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_CreateReadTxn() stub.
+ */
+// -------------------------------------------------------------------------------------------------
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn
+(
+    const char* basePath
+        ///< [IN]
+        ///< Path to the location to create the new iterator.
+)
+{
+    // Only the models of application assets are served, e.g. /apps/<app>/assets/<id>
+    if ( (0 == strncmp(basePath, "/apps/", 6)) && (NULL != strstr(basePath, "/assets/")) )
+    {
+        Iterator.level = NODE_ASSET;
+    }
+    else
+    {
+        Iterator.level = NODE_NONE;
+    }
+
+    return (le_cfg_IteratorRef_t)&Iterator;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_CancelTxn() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_CancelTxn
+(
+    le_cfg_IteratorRef_t iteratorRef
+        ///< [IN]
+        ///< Iterator object to close.
+)
+{
+    Iterator.level = NODE_NONE;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_IsEmpty() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+bool le_cfg_IsEmpty
+(
+    le_cfg_IteratorRef_t iteratorRef,
+        ///< [IN]
+        ///< Iterator to use as a basis for the transaction.
+
+    const char* path
+        ///< [IN]
+        ///< Path to the target node. Can be an absolute path, or
+        ///< a path relative from the iterator's current position.
+)
+{
+    switch (Iterator.level)
+    {
+        case NODE_ASSET:
+        case NODE_FIELD:
+            return false;
+
+        case NODE_FIELDS:
+            return (0 == NumFields);
+
+        default:
+            return true;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GoToNode() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_GoToNode
+(
+    le_cfg_IteratorRef_t iteratorRef,
+        ///< [IN]
+        ///< Iterator to move.
+
+    const char* newPath
+        ///< [IN]
+        ///< Absolute or relative path from the current location.
+)
+{
+    if ( (NODE_ASSET == Iterator.level) && (0 == strcmp(newPath, "fields")) )
+    {
+        Iterator.level = NODE_FIELDS;
+    }
+    else
+    {
+        Iterator.level = NODE_NONE;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GoToFirstChild() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GoToFirstChild
+(
+    le_cfg_IteratorRef_t iteratorRef
+        ///< [IN]
+        ///< Iterator object to move.
+)
+{
+    if ( (NODE_FIELDS != Iterator.level) || (0 == NumFields) )
+    {
+        return LE_NOT_FOUND;
+    }
+
+    Iterator.level = NODE_FIELD;
+    Iterator.fieldId = 0;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GoToNextSibling() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GoToNextSibling
+(
+    le_cfg_IteratorRef_t iteratorRef
+        ///< [IN]
+        ///< Iterator to iterate.
+)
+{
+    if ( (NODE_FIELD != Iterator.level) || ((Iterator.fieldId + 1) >= NumFields) )
+    {
+        return LE_NOT_FOUND;
+    }
+
+    Iterator.fieldId++;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetNodeName() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GetNodeName
+(
+    le_cfg_IteratorRef_t iteratorRef,
+        ///< [IN]
+        ///< Iterator object to use to read from the tree.
+
+    const char* path,
+        ///< [IN]
+        ///< Path to the target node. Can be an absolute path, or
+        ///< a path relative from the iterator's current position.
+
+    char* name,
+        ///< [OUT]
+        ///< Read the name of the node object.
+
+    size_t nameNumElements
+        ///< [IN]
+)
+{
+    if (NODE_FIELD != Iterator.level)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    snprintf(name, nameNumElements, "%d", Iterator.fieldId);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetNodeType() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_nodeType_t le_cfg_GetNodeType
+(
+    le_cfg_IteratorRef_t iteratorRef,
+        ///< [IN]
+        ///< Iterator object to use to read from the tree.
+
+    const char* path
+        ///< [IN]
+        ///< Path to the target node. Can be an absolute path, or
+        ///< a path relative from the iterator's current position.
+)
+{
+    // Fields of the model have no default value
+    return LE_CFG_TYPE_DOESNT_EXIST;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetString() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GetString
+(
+    le_cfg_IteratorRef_t iteratorRef,
+        ///< [IN]
+        ///< Iterator to use as a basis for the transaction.
+
+    const char* path,
+        ///< [IN]
+        ///< Path to the target node. Can be an absolute path,
+        ///< or a path relative from the iterator's current
+        ///< position.
+
+    char* value,
+        ///< [OUT]
+        ///< Buffer to write the value into.
+
+    size_t valueNumElements,
+        ///< [IN]
+
+    const char* defaultValue
+        ///< [IN]
+        ///< Default value to use if the original can't be
+        ///<   read.
+)
+{
+    if ( (NODE_ASSET == Iterator.level) && (0 == strcmp(path, "name")) )
+    {
+        return le_utf8_Copy(value, STUB_ASSET_NAME, valueNumElements, NULL);
+    }
+
+    if (NODE_FIELD == Iterator.level)
+    {
+        if (0 == strcmp(path, "name"))
+        {
+            snprintf(value, valueNumElements, "field%d", Iterator.fieldId);
+            return LE_OK;
+        }
+        if (0 == strcmp(path, "type"))
+        {
+            return le_utf8_Copy(value, "int", valueNumElements, NULL);
+        }
+        if (0 == strcmp(path, "access"))
+        {
+            return le_utf8_Copy(value, "rw", valueNumElements, NULL);
+        }
+    }
+
+    return le_utf8_Copy(value, defaultValue, valueNumElements, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetInt() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+int32_t le_cfg_GetInt
+(
+    le_cfg_IteratorRef_t iteratorRef,
+        ///< [IN]
+        ///< Iterator to use as a basis for the transaction.
+
+    const char* path,
+        ///< [IN]
+        ///< Path to the target node. Can be an absolute path, or
+        ///< a path relative from the iterator's current position.
+
+    int32_t defaultValue
+        ///< [IN]
+        ///< Default value to use if the original can't be
+        ///<   read.
+)
+{
+    return defaultValue;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetFloat() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+double le_cfg_GetFloat
+(
+    le_cfg_IteratorRef_t iteratorRef, ///< [IN] Iterator to use as a basis for the transaction.
+    const char* path,                 ///< [IN] Path to the target node. Can be an absolute path, or
+                                      ///< a path relative from the iterator's current position.
+    double defaultValue               ///< [IN] Default value to use if the original can't be read.
+)
+{
+    return defaultValue;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetBool() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+bool le_cfg_GetBool
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator to use as a basis for the transaction.
+    const char* path,                   ///< [IN] Path to the target node. Can be an absolute path,
+                                        ///<      or a path relative from the iterator's current
+                                        ///<      position
+    bool defaultValue                   ///< [IN] Default value to use if the original can't be
+                                        ///<      read.
+)
+{
+    return defaultValue;
+}
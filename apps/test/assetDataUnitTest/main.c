@@ -0,0 +1,352 @@
+/**
+ * This module implements the unit tests for the field action handlers of assetData.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "assetData.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Registration test layout
+ */
+//--------------------------------------------------------------------------------------------------
+#define REG_APP_NAME                        "regApp"
+#define REG_NUM_FIELDS                      4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Benchmark layout: an asset with hundreds of fields, handlers registered on half of them
+ */
+//--------------------------------------------------------------------------------------------------
+#define BENCH_APP_NAME                      "benchApp"
+#define BENCH_NUM_FIELDS                    500
+#define BENCH_NUM_ITERATIONS                200
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Context of a handler removing itself when called
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    assetData_FieldActionHandlerRef_t handlerRef;   ///< Reference of the handler
+    int count;                                      ///< Number of calls
+}
+OneShotContext_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub function to set the number of fields of the asset model
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetAssetModel
+(
+    int numFields
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Field action handler counting its calls in the integer pointed by the context
+ */
+//--------------------------------------------------------------------------------------------------
+static void CountingHandler
+(
+    assetData_InstanceDataRef_t instanceRef,
+    int fieldId,
+    assetData_ActionTypes_t action,
+    void* contextPtr
+)
+{
+    (*(int*)contextPtr)++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Field action handler removing itself from the client handlers when called
+ */
+//--------------------------------------------------------------------------------------------------
+static void OneShotHandler
+(
+    assetData_InstanceDataRef_t instanceRef,
+    int fieldId,
+    assetData_ActionTypes_t action,
+    void* contextPtr
+)
+{
+    OneShotContext_t* oneShotPtr = contextPtr;
+
+    oneShotPtr->count++;
+    assetData_client_RemoveFieldActionHandler(oneShotPtr->handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create an instance of an asset following the stubbed model
+ */
+//--------------------------------------------------------------------------------------------------
+static assetData_InstanceDataRef_t CreateInstance
+(
+    const char* appNamePtr,
+    int numFields,
+    assetData_AssetDataRef_t* assetRefPtr
+)
+{
+    assetData_InstanceDataRef_t instanceRef;
+
+    stub_SetAssetModel(numFields);
+    LE_ASSERT_OK(assetData_CreateInstanceById(appNamePtr, 0, 0, &instanceRef));
+    LE_ASSERT_OK(assetData_GetAssetRefById(appNamePtr, 0, assetRefPtr));
+
+    return instanceRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the consistency of the field action handlers through registration and removal
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestHandlerRegistration
+(
+    void
+)
+{
+    assetData_AssetDataRef_t assetRef;
+    assetData_InstanceDataRef_t instanceRef;
+    assetData_FieldActionHandlerRef_t clientRef;
+    assetData_FieldActionHandlerRef_t serverRef;
+    assetData_FieldActionHandlerRef_t firstRef;
+    assetData_FieldActionHandlerRef_t secondRef;
+    assetData_FieldActionHandlerRef_t thirdRef;
+    OneShotContext_t oneShot = { .handlerRef = NULL, .count = 0 };
+    int clientCount = 0;
+    int serverCount = 0;
+    int firstCount = 0;
+    int secondCount = 0;
+    int thirdCount = 0;
+    int value;
+
+    LE_INFO("============= Field action handler registration ==============");
+
+    instanceRef = CreateInstance(REG_APP_NAME, REG_NUM_FIELDS, &assetRef);
+
+    // Client handlers are called on server actions, server handlers on client actions.
+    clientRef = assetData_client_AddFieldActionHandler(assetRef, 0, CountingHandler, &clientCount);
+    serverRef = assetData_server_AddFieldActionHandler(assetRef, 0, CountingHandler, &serverCount);
+    LE_ASSERT(NULL != clientRef);
+    LE_ASSERT(NULL != serverRef);
+
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 0, 1));
+    LE_ASSERT((1 == clientCount) && (0 == serverCount));
+    LE_ASSERT_OK(assetData_client_SetInt(instanceRef, 0, 2));
+    LE_ASSERT((1 == clientCount) && (1 == serverCount));
+    LE_ASSERT_OK(assetData_client_GetInt(instanceRef, 0, &value));
+    LE_ASSERT(2 == value);
+    LE_ASSERT((1 == clientCount) && (2 == serverCount));
+
+    // Actions on fields without handler do not reach the handlers of other fields.
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 1, 1));
+    LE_ASSERT_OK(assetData_client_SetInt(instanceRef, 1, 1));
+    LE_ASSERT((1 == clientCount) && (2 == serverCount));
+
+    // Removing with the wrong origin is refused.
+    assetData_server_RemoveFieldActionHandler(clientRef);
+    assetData_client_RemoveFieldActionHandler(serverRef);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 0, 3));
+    LE_ASSERT_OK(assetData_client_SetInt(instanceRef, 0, 3));
+    LE_ASSERT((2 == clientCount) && (3 == serverCount));
+
+    // Removing a handler keeps the other origin.
+    assetData_client_RemoveFieldActionHandler(clientRef);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 0, 4));
+    LE_ASSERT_OK(assetData_client_SetInt(instanceRef, 0, 4));
+    LE_ASSERT((2 == clientCount) && (4 == serverCount));
+
+    assetData_server_RemoveFieldActionHandler(serverRef);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 0, 5));
+    LE_ASSERT_OK(assetData_client_SetInt(instanceRef, 0, 5));
+    LE_ASSERT((2 == clientCount) && (4 == serverCount));
+
+    // Several handlers on a field are called in registration order, and removed independently.
+    firstRef = assetData_client_AddFieldActionHandler(assetRef, 2, CountingHandler, &firstCount);
+    secondRef = assetData_client_AddFieldActionHandler(assetRef, 2, CountingHandler, &secondCount);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 2, 1));
+    LE_ASSERT((1 == firstCount) && (1 == secondCount));
+
+    assetData_client_RemoveFieldActionHandler(firstRef);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 2, 2));
+    LE_ASSERT((1 == firstCount) && (2 == secondCount));
+
+    // The field is indexed again after all its handlers were removed.
+    assetData_client_RemoveFieldActionHandler(secondRef);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 2, 3));
+    LE_ASSERT((1 == firstCount) && (2 == secondCount));
+
+    firstRef = assetData_client_AddFieldActionHandler(assetRef, 2, CountingHandler, &firstCount);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 2, 4));
+    LE_ASSERT((2 == firstCount) && (2 == secondCount));
+
+    // A handler can remove itself while it is called, with other handlers on the same field.
+    oneShot.handlerRef = assetData_client_AddFieldActionHandler(assetRef, 2,
+                                                                OneShotHandler, &oneShot);
+    secondRef = assetData_client_AddFieldActionHandler(assetRef, 2, CountingHandler, &secondCount);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 2, 5));
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 2, 6));
+    LE_ASSERT(1 == oneShot.count);
+    LE_ASSERT((4 == firstCount) && (4 == secondCount));
+
+    // ... and as the only handler of the field.
+    oneShot.handlerRef = assetData_client_AddFieldActionHandler(assetRef, 3,
+                                                                OneShotHandler, &oneShot);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 3, 1));
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 3, 2));
+    LE_ASSERT(2 == oneShot.count);
+
+    // A handler can remove the next handler of the field while it is called: the removed handler
+    // is not called anymore, and the field is indexed again afterwards.
+    oneShot.count = 0;
+    thirdRef = assetData_client_AddFieldActionHandler(assetRef, 3, OneShotHandler, &oneShot);
+    oneShot.handlerRef = assetData_client_AddFieldActionHandler(assetRef, 3,
+                                                                CountingHandler, &thirdCount);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 3, 3));
+    LE_ASSERT((1 == oneShot.count) && (0 == thirdCount));
+
+    assetData_client_RemoveFieldActionHandler(thirdRef);
+    thirdRef = assetData_client_AddFieldActionHandler(assetRef, 3, CountingHandler, &thirdCount);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 3, 4));
+    LE_ASSERT((1 == oneShot.count) && (1 == thirdCount));
+    assetData_client_RemoveFieldActionHandler(thirdRef);
+
+    // Deleting the asset releases its handlers; a new asset does not inherit them.
+    assetData_DeleteInstanceAndAsset(instanceRef);
+
+    instanceRef = CreateInstance(REG_APP_NAME, REG_NUM_FIELDS, &assetRef);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 2, 1));
+    LE_ASSERT_OK(assetData_client_SetInt(instanceRef, 2, 1));
+    LE_ASSERT((4 == firstCount) && (4 == secondCount));
+
+    clientRef = assetData_client_AddFieldActionHandler(assetRef, 2, CountingHandler, &clientCount);
+    LE_ASSERT_OK(assetData_server_SetInt(instanceRef, 2, 2));
+    LE_ASSERT(3 == clientCount);
+    assetData_client_RemoveFieldActionHandler(clientRef);
+
+    assetData_DeleteInstanceAndAsset(instanceRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time server writes on the given fields of an instance
+ *
+ * @return Average time per write in nanoseconds
+ */
+//--------------------------------------------------------------------------------------------------
+static double BenchmarkWrites
+(
+    assetData_InstanceDataRef_t instanceRef,
+    int firstFieldId,
+    int fieldStep
+)
+{
+    int iteration;
+    int fieldId;
+    int numWrites = 0;
+
+    le_clk_Time_t start = le_clk_GetRelativeTime();
+    for (iteration = 0; iteration < BENCH_NUM_ITERATIONS; iteration++)
+    {
+        for (fieldId = firstFieldId; fieldId < BENCH_NUM_FIELDS; fieldId += fieldStep)
+        {
+            LE_ASSERT_OK(assetData_server_SetInt(instanceRef, fieldId, iteration));
+            numWrites++;
+        }
+    }
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), start);
+
+    return ((double)elapsed.sec * 1000000000 + (double)elapsed.usec * 1000) / numWrites;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Microbenchmark of the field action dispatch on an asset with hundreds of fields
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestDispatchBenchmark
+(
+    void
+)
+{
+    static int counts[BENCH_NUM_FIELDS];
+    static assetData_FieldActionHandlerRef_t handlerRefs[BENCH_NUM_FIELDS];
+    assetData_AssetDataRef_t assetRef;
+    assetData_InstanceDataRef_t instanceRef;
+    double nsNoHandler;
+    double nsUnhandled;
+    double nsHandled;
+    int fieldId;
+
+    LE_INFO("============= Field action dispatch benchmark ==============");
+
+    instanceRef = CreateInstance(BENCH_APP_NAME, BENCH_NUM_FIELDS, &assetRef);
+
+    nsNoHandler = BenchmarkWrites(instanceRef, 1, 2);
+
+    // Register a client handler on every even field.
+    for (fieldId = 0; fieldId < BENCH_NUM_FIELDS; fieldId += 2)
+    {
+        handlerRefs[fieldId] = assetData_client_AddFieldActionHandler(assetRef, fieldId,
+                                                                      CountingHandler,
+                                                                      &counts[fieldId]);
+        LE_ASSERT(NULL != handlerRefs[fieldId]);
+    }
+
+    nsUnhandled = BenchmarkWrites(instanceRef, 1, 2);
+    nsHandled = BenchmarkWrites(instanceRef, 0, 2);
+
+    for (fieldId = 0; fieldId < BENCH_NUM_FIELDS; fieldId++)
+    {
+        LE_ASSERT(counts[fieldId] == ((0 == (fieldId % 2)) ? BENCH_NUM_ITERATIONS : 0));
+    }
+
+    LE_INFO("%d fields, %d handlers: %.0f ns/write without handler, "
+            "%.0f ns/write on unhandled field, %.0f ns/write on handled field",
+            BENCH_NUM_FIELDS, BENCH_NUM_FIELDS / 2, nsNoHandler, nsUnhandled, nsHandled);
+
+    // Remove the handlers, no handler must be called anymore.
+    for (fieldId = 0; fieldId < BENCH_NUM_FIELDS; fieldId += 2)
+    {
+        assetData_client_RemoveFieldActionHandler(handlerRefs[fieldId]);
+    }
+
+    BenchmarkWrites(instanceRef, 0, 1);
+    for (fieldId = 0; fieldId < BENCH_NUM_FIELDS; fieldId++)
+    {
+        LE_ASSERT(counts[fieldId] == ((0 == (fieldId % 2)) ? BENCH_NUM_ITERATIONS : 0));
+    }
+
+    assetData_DeleteInstanceAndAsset(instanceRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * main of the test
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start assetDataUnitTest =====================");
+
+    LE_ASSERT_OK(assetData_Init());
+
+    // Test - handler registration and removal
+    TestHandlerRegistration();
+
+    // Benchmark - dispatch on an asset with hundreds of fields
+    TestDispatchBenchmark();
+
+    LE_INFO("=============== assetDataUnitTest successful ===================");
+
+    exit(EXIT_SUCCESS);
+}
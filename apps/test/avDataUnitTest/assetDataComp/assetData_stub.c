@@ -11,6 +11,97 @@
 #include "coapHandlers.h"
 #include "cbor.h"
 #include "watchdogChain.h"
+#include "push.h"
+#include "limit.h"
+#include "resourceIndex.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push acknowledgement handler registered by the push module
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_PushAckCallback_t PushAckCallback = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Message identifier of the last push, 0 if none
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t PushMid = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Payload of the last push, for the test to decode it
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t PushPayload[MAX_PUSH_BUFFER_BYTES];
+static size_t PushPayloadLength = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Session and application of the current client
+ */
+//--------------------------------------------------------------------------------------------------
+static le_msg_SessionRef_t ClientSessionRef = (le_msg_SessionRef_t)0x1001;
+static char ClientAppName[LE_LIMIT_APP_NAME_LEN + 1] = "test";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Session close handlers registered by the avData and change stream modules
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_CLOSE_HANDLERS  4
+
+static struct
+{
+    le_msg_SessionEventHandler_t handlerFunc;
+    void*                        contextPtr;
+}
+CloseHandlers[MAX_CLOSE_HANDLERS];
+static int CloseHandlerCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Integer nodes set by the test in the config tree, and base path of the last read transaction
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_CFG_INT_NODES   16
+
+static struct
+{
+    char    path[LE_CFG_STR_LEN_BYTES];
+    int32_t value;
+}
+CfgIntNodes[MAX_CFG_INT_NODES];
+static int CfgIntNodeCount = 0;
+static char CfgBasePath[LE_CFG_STR_LEN_BYTES] = "";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * AV server request handler registered by the avData module, current server request, and last
+ * response sent to the server
+ */
+//--------------------------------------------------------------------------------------------------
+static coap_request_handler_t CoapRequestHandler = NULL;
+
+static struct
+{
+    coap_method_t  method;
+    const char*    uriPtr;
+    const uint8_t* payloadPtr;
+    size_t         payloadLength;
+}
+ServerRequest = { COAP_GET, "coap://leshan.eclipse.org:5784", (const uint8_t*)"1234", 4 };
+
+static struct
+{
+    lwm2mcore_CoapResponseCode_t code;
+    uint16_t                     contentType;
+    uint8_t                      payload[4096];
+    size_t                       payloadLength;
+}
+ServerResponse;
+static int ServerResponseCount = 0;
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -22,7 +113,130 @@ le_msg_SessionRef_t le_avdata_GetClientSessionRef
     void
 )
 {
-    return (le_msg_SessionRef_t)0x1001;
+    return ClientSessionRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the client session reference for the current message of the le_avdataStream service
+ */
+//--------------------------------------------------------------------------------------------------
+le_msg_SessionRef_t le_avdataStream_GetClientSessionRef
+(
+    void
+)
+{
+    return ClientSessionRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the session and the application of the current client (test helper, not part of the
+ * stubbed APIs).
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetClient
+(
+    le_msg_SessionRef_t sessionRef,         ///< [IN] Client session
+    const char* appNamePtr                  ///< [IN] Client application name
+)
+{
+    ClientSessionRef = sessionRef;
+    le_utf8_Copy(ClientAppName, appNamePtr, sizeof(ClientAppName), NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close a client session, as the framework does when the client exits (test helper, not part of
+ * the stubbed APIs).
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_CloseClient
+(
+    le_msg_SessionRef_t sessionRef          ///< [IN] Client session
+)
+{
+    int i;
+
+    for (i = 0; i < CloseHandlerCount; i++)
+    {
+        CloseHandlers[i].handlerFunc(sessionRef, CloseHandlers[i].contextPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set an integer node of the config tree, read by le_cfg_GetInt() (test helper, not part of the
+ * stubbed APIs).
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetCfgInt
+(
+    const char* pathPtr,                    ///< [IN] Absolute path of the node
+    int32_t value                           ///< [IN] Value
+)
+{
+    int i;
+
+    for (i = 0; i < CfgIntNodeCount; i++)
+    {
+        if (0 == strcmp(CfgIntNodes[i].path, pathPtr))
+        {
+            CfgIntNodes[i].value = value;
+            return;
+        }
+    }
+
+    LE_ASSERT(CfgIntNodeCount < MAX_CFG_INT_NODES);
+    le_utf8_Copy(CfgIntNodes[i].path, pathPtr, sizeof(CfgIntNodes[i].path), NULL);
+    CfgIntNodes[i].value = value;
+    CfgIntNodeCount++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request of the AV server to the avData module (test helper, not part of the stubbed APIs).
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SendServerRequest
+(
+    coap_method_t method,                   ///< [IN] CoAP method
+    const char* uriPtr,                     ///< [IN] Request URI
+    const uint8_t* payloadPtr,              ///< [IN] Request payload
+    size_t payloadLength                    ///< [IN] Request payload length
+)
+{
+    LE_ASSERT(NULL != CoapRequestHandler);
+
+    ServerRequest.method = method;
+    ServerRequest.uriPtr = uriPtr;
+    ServerRequest.payloadPtr = payloadPtr;
+    ServerRequest.payloadLength = payloadLength;
+
+    CoapRequestHandler((lwm2mcore_CoapRequest_t*)&ServerRequest);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the last response sent to the AV server (test helper, not part of the stubbed APIs).
+ *
+ * @return
+ *      - Number of responses sent since the start of the test
+ */
+//--------------------------------------------------------------------------------------------------
+int stub_GetServerResponse
+(
+    lwm2mcore_CoapResponseCode_t* codePtr,  ///< [OUT] Response code
+    uint16_t* contentTypePtr,               ///< [OUT] Content format
+    const uint8_t** payloadPtr,             ///< [OUT] Response payload
+    size_t* payloadLengthPtr                ///< [OUT] Response payload length
+)
+{
+    *codePtr = ServerResponse.code;
+    *contentTypePtr = ServerResponse.contentType;
+    *payloadPtr = ServerResponse.payload;
+    *payloadLengthPtr = ServerResponse.payloadLength;
+    return ServerResponseCount;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -38,6 +252,19 @@ le_msg_ServiceRef_t le_avdata_GetServiceRef
     return (le_msg_ServiceRef_t)0x1002;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the server service reference of the le_avdataStream service
+ */
+//--------------------------------------------------------------------------------------------------
+le_msg_ServiceRef_t le_avdataStream_GetServiceRef
+(
+    void
+)
+{
+    return (le_msg_ServiceRef_t)0x1003;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Registers a function to be called whenever one of this service's sessions is closed by
@@ -51,6 +278,10 @@ le_msg_SessionEventHandlerRef_t MyAddServiceCloseHandler
     void*                           contextPtr  ///< [in] Opaque pointer value to pass to handler.
 )
 {
+    LE_ASSERT(CloseHandlerCount < MAX_CLOSE_HANDLERS);
+    CloseHandlers[CloseHandlerCount].handlerFunc = handlerFunc;
+    CloseHandlers[CloseHandlerCount].contextPtr = contextPtr;
+    CloseHandlerCount++;
     return NULL;
 }
 
@@ -107,6 +338,7 @@ le_cfg_IteratorRef_t le_cfg_CreateReadTxn
         ///< Path to the location to create the new iterator.
 )
 {
+    le_utf8_Copy(CfgBasePath, basePath, sizeof(CfgBasePath), NULL);
     return NULL;
 }
 
@@ -230,6 +462,24 @@ int32_t le_cfg_GetInt
         ///<   read.
 )
 {
+    char fullPath[LE_CFG_STR_LEN_BYTES];
+    int i;
+
+    snprintf(fullPath, sizeof(fullPath), "%s/%s", CfgBasePath, path);
+    for (i = 0; i < CfgIntNodeCount; i++)
+    {
+        if (0 == strcmp(CfgIntNodes[i].path, fullPath))
+        {
+            return CfgIntNodes[i].value;
+        }
+    }
+
+    // The quotas which are not set by the test are not limited
+    if (0 == strncmp(CfgBasePath, "/apps/avcService/quotas", strlen("/apps/avcService/quotas")))
+    {
+        return defaultValue;
+    }
+
     return 1;
 }
 //--------------------------------------------------------------------------------------------------
@@ -484,8 +734,7 @@ le_result_t le_appInfo_GetName
         ///< [IN]
 )
 {
-    memcpy(appName, "test", sizeof("test"));
-    return LE_OK;
+    return le_utf8_Copy(appName, ClientAppName, appNameNumElements, NULL);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -504,6 +753,17 @@ bool lwm2mcore_SendAsyncResponse
     lwm2mcore_CoapResponse_t* responsePtr       ///< [IN] CoAP response
 )
 {
+    LE_ASSERT(NULL != instanceRef);
+    LE_ASSERT(responsePtr->payloadLength <= sizeof(ServerResponse.payload));
+
+    ServerResponse.code = responsePtr->code;
+    ServerResponse.contentType = (uint16_t)responsePtr->contentType;
+    if (0 != responsePtr->payloadLength)
+    {
+        memcpy(ServerResponse.payload, responsePtr->payload, responsePtr->payloadLength);
+    }
+    ServerResponse.payloadLength = responsePtr->payloadLength;
+    ServerResponseCount++;
     return true;
 }
 
@@ -517,7 +777,7 @@ const char* lwm2mcore_GetRequestUri
     lwm2mcore_CoapRequest_t* requestRef    ///< [IN] Coap request reference
 )
 {
-    return "coap://leshan.eclipse.org:5784";
+    return ServerRequest.uriPtr;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -530,7 +790,7 @@ coap_method_t lwm2mcore_GetRequestMethod
     lwm2mcore_CoapRequest_t* requestRef        ///< [IN] Coap request reference
 )
 {
-    return COAP_GET;
+    return ServerRequest.method;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -543,7 +803,7 @@ const uint8_t* lwm2mcore_GetRequestPayload
     lwm2mcore_CoapRequest_t* requestRef    ///< [IN] Coap request reference
 )
 {
-    return "1234";
+    return ServerRequest.payloadPtr;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -556,7 +816,7 @@ size_t lwm2mcore_GetRequestPayloadLength
     lwm2mcore_CoapRequest_t* requestRef    ///< [IN] Coap request reference
 )
 {
-    return 4;
+    return ServerRequest.payloadLength;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -595,6 +855,7 @@ void lwm2mcore_SetCoapEventHandler
     coap_request_handler_t handlerRef    ///< [IN] Coap action handler
 )
 {
+    CoapRequestHandler = handlerRef;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -607,6 +868,7 @@ void lwm2mcore_SetPushCallback
     lwm2mcore_PushAckCallback_t callbackP  ///< [IN] push callback pointer
 )
 {
+    PushAckCallback = callbackP;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -941,9 +1203,37 @@ le_result_t avcClient_Push
     uint16_t* midPtr                        ///< [OUT] Message identifier.
 )
 {
+    // The server acknowledges the previous push before receiving this one, so that the push queue
+    // does not fill up over the test
+    if ((0 != PushMid) && (NULL != PushAckCallback))
+    {
+        PushAckCallback(LWM2MCORE_ACK_RECEIVED, PushMid);
+    }
+
+    PushPayloadLength = (payloadLength < sizeof(PushPayload)) ? payloadLength : sizeof(PushPayload);
+    memcpy(PushPayload, payload, PushPayloadLength);
+
+    *midPtr = ++PushMid;
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the payload of the last push (test helper, not part of the stubbed APIs).
+ *
+ * @return
+ *      - Payload of the last push
+ */
+//--------------------------------------------------------------------------------------------------
+const uint8_t* stub_GetLastPushPayload
+(
+    size_t* lenPtr                          ///< [OUT] Payload length.
+)
+{
+    *lenPtr = PushPayloadLength;
+    return PushPayload;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Returns the instance reference of this client.
@@ -954,7 +1244,7 @@ lwm2mcore_Ref_t avcClient_GetInstance
     void
 )
 {
-    return NULL;
+    return (lwm2mcore_Ref_t)0x5001;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -977,6 +1267,12 @@ void le_wdogChain_Kick
 //--------------------------------------------------------------------------------------------------
 COMPONENT_INIT
 {
+    // The resource index of a previous run is only restored when the test restarts itself
+    if ((0 == le_arg_NumArgs()) || (0 != strcmp(le_arg_GetArg(0), "restarted")))
+    {
+        le_fs_Delete(RESOURCE_INDEX_PATH);
+    }
+
     avData_Init();
     push_Init();
     timeSeries_Init();
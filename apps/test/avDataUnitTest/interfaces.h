@@ -9,6 +9,7 @@
 #define _INTERFACES_H
 
 #include "le_avdata_interface.h"
+#include "le_avdataStream_interface.h"
 #include "le_avc_interface.h"
 #include "le_cfg_interface.h"
 #include "lwm2mcore.h"
@@ -34,6 +35,26 @@ le_msg_ServiceRef_t le_avcData_GetServiceRef
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the client session reference for the current message of the le_avdataStream service
+ */
+//--------------------------------------------------------------------------------------------------
+le_msg_SessionRef_t le_avdataStream_GetClientSessionRef
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the server service reference of the le_avdataStream service
+ */
+//--------------------------------------------------------------------------------------------------
+le_msg_ServiceRef_t le_avdataStream_GetServiceRef
+(
+    void
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Registers a function to be called whenever one of this service's sessions is closed by
@@ -7,6 +7,13 @@
 
 #include "legato.h"
 #include "interfaces.h"
+#include "avData.h"
+#include "quota.h"
+#include "changeStream.h"
+#include "push.h"
+#include "coapHandlers.h"
+
+#include <math.h>
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -91,6 +98,245 @@
 #define GLOBAL_RESOURCE_C_INT_VAL           33
 #define GLOBAL_RESOURCE_D_INT_VAL           44
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Server side paths for composite read test. Application namespaced paths are prefixed with the
+ *   application name returned by the le_appInfo_GetName stub.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SERVER_TEST2_RESOURCE_INT           "/test/test2/resourceInt"
+#define SERVER_TEST2_RESOURCE_STRING        "/test/test2/resourceString"
+#define SERVER_TEST2_RESOURCE_UNAVAILABLE   "/test/test2/unAvailable"
+#define SERVER_TEST2_RESOURCE_COMMAND       "/test/test2/resourcecommand"
+#define SERVER_LOCAL_RESOURCE_A             "/test/test/resourceA"
+#define SERVER_LOCAL_RESOURCE_PARENT        "/test/test"
+#define SERVER_GLOBAL_RESOURCE_A            "/test/resourceA"
+#define COMPOSITE_BULK_RESOURCE_FMT         "/bulk/res%03d"
+#define COMPOSITE_BULK_PARENT               "/test/bulk"
+#define COMPOSITE_BULK_COUNT                200
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Timeseries aggregation test: samples every 10 ms, starting at an arbitrary time
+ */
+//--------------------------------------------------------------------------------------------------
+#define AGGREGATION_NUM_SAMPLES             20000
+#define AGGREGATION_SAMPLE_PERIOD_MS        10
+#define AGGREGATION_START_MS                1500000000123ULL
+#define AGGREGATION_MAX_RANK_ERROR          0.02
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Timeseries filter test: signals sampled every 100 ms
+ */
+//--------------------------------------------------------------------------------------------------
+#define FILTER_NUM_SAMPLES                  400
+#define FILTER_SAMPLE_PERIOD_MS             100
+#define FILTER_START_MS                     1500000000000ULL
+#define FILTER_PATH                         "/filter/value"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Timeseries read-back test: samples every second on several resources, recorded backwards
+ */
+//--------------------------------------------------------------------------------------------------
+#define READBACK_NUM_SAMPLES                10
+#define READBACK_SAMPLE_PERIOD_MS           1000
+#define READBACK_START_MS                   1500000000000ULL
+#define READBACK_TIME(i)                    (READBACK_START_MS + \
+                                             ((uint64_t)(i) * READBACK_SAMPLE_PERIOD_MS))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Change stream test: resources of an application observed by subscribers of the whole tree, of
+ *   a subtree and of a single resource with a small queue
+ */
+//--------------------------------------------------------------------------------------------------
+#define STREAM_RES_X                        "/stream/a/x"
+#define STREAM_RES_Y                        "/stream/a/y"
+#define STREAM_RES_Z                        "/stream/b/z"
+#define STREAM_RES_AB                       "/stream/ab"
+#define STREAM_PATH_X                       "/streamApp/stream/a/x"
+#define STREAM_PATH_Y                       "/streamApp/stream/a/y"
+#define STREAM_PATH_Z                       "/streamApp/stream/b/z"
+#define STREAM_PATH_AB                      "/streamApp/stream/ab"
+#define STREAM_SUBTREE_A                    "/streamApp/stream/a/"
+#define STREAM_MAX_LOGGED                   16
+#define STREAM_SMALL_QUEUE                  2
+#define STREAM_CLIENT_SESSION               ((le_msg_SessionRef_t)0x5002)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Command execution test: command resource, its arguments {"n": 5}, and deadline of the command
+ *   checked after a margin
+ */
+//--------------------------------------------------------------------------------------------------
+#define EXEC_RESOURCE                       "/exec/cmd"
+#define SERVER_EXEC_RESOURCE                "/test/exec/cmd"
+#define EXEC_ARG_NAME                       "n"
+#define EXEC_ARG_VALUE                      5
+#define EXEC_TIMEOUT_MS                     100
+#define EXEC_TIMEOUT_CHECK_MS               500
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   CoAP codes of the command execution responses which are not part of
+ *   lwm2mcore_CoapResponseCode_t
+ */
+//--------------------------------------------------------------------------------------------------
+#define EXEC_SERVICE_UNAVAILABLE            163
+#define EXEC_GATEWAY_TIMEOUT                164
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sample decoded from a pushed SenML-JSON record
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t timestamp;
+    double   numValue;          ///< Numeric or boolean value
+    char     strValue[16];      ///< String value
+}
+PushedSample_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change events received by a subscriber of the change stream test
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t   numBatches;                    ///< Number of received batches
+    size_t   numEvents;                     ///< Number of received events
+    uint32_t numLost;                       ///< Number of reported lost events
+    changeStream_SubscriberRef_t unsubscribeRef;    ///< Subscriber to unsubscribe in the handler
+    struct
+    {
+        char                  path[LE_AVDATA_PATH_NAME_BYTES];
+        le_avdata_DataType_t  dataType;
+        changeStream_Value_t  value;        ///< Value, the string is copied in strValue
+        char                  strValue[16];
+        changeStream_Origin_t origin;
+    }
+    event[STREAM_MAX_LOGGED];               ///< Received events
+}
+ChangeLog_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Changes received by the handler of a le_avdataStream client in the change stream test
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    int                      numCalls;                      ///< Number of handler calls
+    uint32_t                 numLost;                       ///< Number of reported lost changes
+    char                     path[LE_AVDATA_PATH_NAME_BYTES];   ///< Path of the last change
+    char                     strValue[16];                  ///< String value of the last change
+    le_avdataStream_Origin_t origin;                        ///< Origin of the last change
+}
+ClientChangeLog_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the payload of the last push, implemented by the avcClient_Push() stub
+ */
+//--------------------------------------------------------------------------------------------------
+const uint8_t* stub_GetLastPushPayload
+(
+    size_t* lenPtr
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the session and the application of the current client, implemented by the stubs
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetClient
+(
+    le_msg_SessionRef_t sessionRef,
+    const char* appNamePtr
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close a client session, implemented by the stubs
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_CloseClient
+(
+    le_msg_SessionRef_t sessionRef
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set an integer node of the config tree, implemented by the le_cfg stubs
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetCfgInt
+(
+    const char* pathPtr,
+    int32_t value
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request of the AV server, implemented by the lwm2mcore stubs
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SendServerRequest
+(
+    coap_method_t method,
+    const char* uriPtr,
+    const uint8_t* payloadPtr,
+    size_t payloadLength
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the last response sent to the AV server and the number of responses, implemented by the
+ * lwm2mcore stubs
+ */
+//--------------------------------------------------------------------------------------------------
+int stub_GetServerResponse
+(
+    lwm2mcore_CoapResponseCode_t* codePtr,
+    uint16_t* contentTypePtr,
+    const uint8_t** payloadPtr,
+    size_t* payloadLengthPtr
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Argument list of the last command execution, and number of the server responses before it
+ */
+//--------------------------------------------------------------------------------------------------
+static le_avdata_ArgumentListRef_t ExecArgListRef = NULL;
+static int ExecResponseCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deadline check timer of the command execution test
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t ExecTimerRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Subscribers of the change stream test and their received events
+ */
+//--------------------------------------------------------------------------------------------------
+static changeStream_SubscriberRef_t StreamAllRef;
+static changeStream_SubscriberRef_t StreamSubtreeRef;
+static changeStream_SubscriberRef_t StreamSmallRef;
+static ChangeLog_t StreamAllLog;
+static ChangeLog_t StreamSubtreeLog;
+static ChangeLog_t StreamSmallLog;
+static le_avdataStream_ChangeHandlerRef_t StreamClientRef;
+static ClientChangeLog_t StreamClientLog;
+
 
 //-------------------------------------------------------------------------------------------------
 /**
@@ -488,6 +734,111 @@ LE_INFO("================ Test avdata Namespace  =================");
     LE_INFO("================ Test avdata Namespace passed =================");
 }
 
+//-------------------------------------------------------------------------------------------------
+/**
+ * Test composite read from the server: mixed valid and invalid paths, namespaced paths and large
+ * result sets.
+ */
+//-------------------------------------------------------------------------------------------------
+static void TestCompositeRead
+(
+    void
+)
+{
+    avData_ReadEntry_t entryArr[AVDATA_COMPOSITE_READ_MAX_ENTRIES];
+    size_t numEntries;
+    int i;
+
+    LE_INFO("================ Test avdata composite read =================");
+
+    // Mixed valid and invalid paths: entries are returned in request order with their own result.
+    const char* mixedPaths[] =
+    {
+        SERVER_TEST2_RESOURCE_INT,
+        SERVER_TEST2_RESOURCE_UNAVAILABLE,
+        SERVER_TEST2_RESOURCE_COMMAND,
+        "bad//path",
+        SERVER_TEST2_RESOURCE_STRING
+    };
+
+    numEntries = NUM_ARRAY_MEMBERS(entryArr);
+    LE_ASSERT_OK(avData_ReadComposite(mixedPaths, NUM_ARRAY_MEMBERS(mixedPaths),
+                                      entryArr, &numEntries));
+    LE_ASSERT(NUM_ARRAY_MEMBERS(mixedPaths) == numEntries);
+
+    LE_ASSERT(0 == strcmp(entryArr[0].path, SERVER_TEST2_RESOURCE_INT));
+    LE_ASSERT(LE_OK == entryArr[0].result);
+    LE_ASSERT(LE_AVDATA_DATA_TYPE_INT == entryArr[0].dataType);
+    LE_ASSERT(TEST_INT_VAL == entryArr[0].value.intValue);
+    LE_ASSERT(LE_NOT_FOUND == entryArr[1].result);
+    LE_ASSERT(LE_NOT_PERMITTED == entryArr[2].result);
+    LE_ASSERT(LE_BAD_PARAMETER == entryArr[3].result);
+    LE_ASSERT(0 == strcmp(entryArr[3].path, "bad//path"));
+    LE_ASSERT(LE_OK == entryArr[4].result);
+    LE_ASSERT(LE_AVDATA_DATA_TYPE_STRING == entryArr[4].dataType);
+    LE_ASSERT(0 == strcmp(entryArr[4].value.strValuePtr, TEST_STRING_VAL));
+
+    // The snapshot holds its own copy of the values.
+    LE_ASSERT_OK(le_avdata_SetString(TEST2_RESOURCE_STRING, "updated"));
+    LE_ASSERT(0 == strcmp(entryArr[4].value.strValuePtr, TEST_STRING_VAL));
+    LE_ASSERT_OK(le_avdata_SetString(TEST2_RESOURCE_STRING, TEST_STRING_VAL));
+    avData_ReleaseComposite(entryArr, numEntries);
+
+    // Application and global namespaced paths, and a parent path expanded into its children.
+    const char* namespacedPaths[] =
+    {
+        SERVER_LOCAL_RESOURCE_A,
+        SERVER_GLOBAL_RESOURCE_A,
+        SERVER_LOCAL_RESOURCE_PARENT
+    };
+
+    numEntries = NUM_ARRAY_MEMBERS(entryArr);
+    LE_ASSERT_OK(avData_ReadComposite(namespacedPaths, NUM_ARRAY_MEMBERS(namespacedPaths),
+                                      entryArr, &numEntries));
+    LE_ASSERT(6 == numEntries);
+    LE_ASSERT(LOCAL_RESOURCE_A_INT_VAL == entryArr[0].value.intValue);
+    LE_ASSERT(GLOBAL_RESOURCE_A_INT_VAL == entryArr[1].value.intValue);
+    LE_ASSERT(0 == strcmp(entryArr[2].path, SERVER_LOCAL_RESOURCE_A));
+    LE_ASSERT(LOCAL_RESOURCE_A_INT_VAL == entryArr[2].value.intValue);
+    LE_ASSERT(LOCAL_RESOURCE_B_INT_VAL == entryArr[3].value.intValue);
+    LE_ASSERT(LOCAL_RESOURCE_C_INT_VAL == entryArr[4].value.intValue);
+    LE_ASSERT(LOCAL_RESOURCE_D_INT_VAL == entryArr[5].value.intValue);
+    avData_ReleaseComposite(entryArr, numEntries);
+
+    // Large result set: a parent path expanded into many sorted children.
+    for (i = 0; i < COMPOSITE_BULK_COUNT; i++)
+    {
+        char path[LE_AVDATA_PATH_NAME_BYTES];
+        snprintf(path, sizeof(path), COMPOSITE_BULK_RESOURCE_FMT, i);
+        LE_ASSERT_OK(le_avdata_CreateResource(path, LE_AVDATA_ACCESS_VARIABLE));
+        LE_ASSERT_OK(le_avdata_SetInt(path, i));
+    }
+
+    const char* bulkPaths[] = { COMPOSITE_BULK_PARENT, SERVER_TEST2_RESOURCE_INT };
+
+    numEntries = NUM_ARRAY_MEMBERS(entryArr);
+    LE_ASSERT_OK(avData_ReadComposite(bulkPaths, NUM_ARRAY_MEMBERS(bulkPaths),
+                                      entryArr, &numEntries));
+    LE_ASSERT((COMPOSITE_BULK_COUNT + 1) == numEntries);
+    for (i = 0; i < COMPOSITE_BULK_COUNT; i++)
+    {
+        LE_ASSERT(LE_OK == entryArr[i].result);
+        LE_ASSERT(i == entryArr[i].value.intValue);
+    }
+    LE_ASSERT(TEST_INT_VAL == entryArr[COMPOSITE_BULK_COUNT].value.intValue);
+    avData_ReleaseComposite(entryArr, numEntries);
+
+    // Result set larger than the entry array: nothing is returned.
+    numEntries = COMPOSITE_BULK_COUNT;
+    LE_ASSERT(LE_OVERFLOW == avData_ReadComposite(bulkPaths, NUM_ARRAY_MEMBERS(bulkPaths),
+                                                  entryArr, &numEntries));
+    LE_ASSERT(0 == numEntries);
+
+    LE_ASSERT(LE_BAD_PARAMETER == avData_ReadComposite(bulkPaths, 1, entryArr, NULL));
+
+    LE_INFO("================ Test avdata composite read passed =================");
+}
+
 //-------------------------------------------------------------------------------------------------
 /**
  * Test Airvantage server APIs: le_avdata_CreateRecord(), le_avdata_PushRecord(),
@@ -586,103 +937,1714 @@ static void TestTimeseries
 }
 
 
-//-------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------
 /**
- * Test Airvantage server APIs:  le_avdata_PushStream()
+ * Test time series pushed in SenML. The CBOR encoder is stubbed in this test, so SenML-JSON is
+ * used to check that the record fills up at the buffer size.
  */
-//-------------------------------------------------------------------------------------------------
-static void TestPushStream
+//--------------------------------------------------------------------------------------------------
+static void TestTimeseriesSenml
 (
     void
 )
 {
-    int fd;
-    char dummyData[512];
+    uint64_t timestamp = 1500000000000ULL;
+    le_result_t result = LE_OK;
+    int numSamples = 0;
 
-    LE_INFO("============= Test le_avdata_PushStream() API ==============");
+    LE_INFO("============= Test avdata with times series in SenML ==============");
 
-    // Use an invalid file descriptor
-    fd = -5;
-    LE_ASSERT(LE_FAULT == le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
+    le_avdata_RecordRef_t recRef = le_avdata_CreateRecord();
 
-    fd = 10;
-    LE_ASSERT(LE_FAULT == le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordFormat(NULL, TIMESERIES_FORMAT_SENML_JSON));
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordFormat(recRef, (timeSeries_Format_t)42));
 
-    //Push a huge amount of data
-    fd = open("/dev/urandom", O_RDONLY);
-    if (-1 == fd)
+    // Data accumulated before the format is selected is re-encoded
+    LE_ASSERT_OK(le_avdata_RecordInt(recRef, "/senml/intValue", 1, timestamp));
+    LE_ASSERT_OK(avData_SetRecordFormat(recRef, TIMESERIES_FORMAT_SENML_JSON));
+    LE_ASSERT_OK(le_avdata_RecordString(recRef, "/senml/stringValue", "hello", timestamp));
+    LE_ASSERT_OK(le_avdata_PushRecord(recRef, PushCallbackHandler, NULL));
+
+    // The format is kept after a push, and the record fills up at the buffer size
+    while ((LE_OK == result) && (numSamples < 1000))
     {
-        LE_ERROR("Failed to open file descriptor, errno %d.", errno);
-        return;
+        timestamp += 250;
+        result = le_avdata_RecordInt(recRef, "/senml/intValue", numSamples, timestamp);
+        if (LE_OK == result)
+        {
+            numSamples++;
+        }
     }
 
-    LE_ASSERT(LE_OVERFLOW == le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
-    close(fd);
+    LE_INFO("%d SenML-JSON samples in a record", numSamples);
+    LE_ASSERT(LE_NO_MEMORY == result);
+    LE_ASSERT(numSamples > 50);
+    LE_ASSERT_OK(le_avdata_PushRecord(recRef, PushCallbackHandler, NULL));
 
-    // Create a file and populate it with data, then push it.
-    fd = open("/tmp/PushSteamFile.txt", O_RDWR | O_CREAT | O_TRUNC, 0644);
-    if (-1 == fd)
-    {
-        LE_ERROR("Failed to create file, errno %d.", errno);
-        return;
-    }
+    le_avdata_DeleteRecord(recRef);
+    LE_INFO("============= Test avdata with times series in SenML passed ==============");
+}
 
-    if (-1 == FdWrite(fd, dummyData, sizeof(dummyData)))
-    {
-        LE_ERROR("Unable to write buffer in file, errno %d.", errno);
-        goto end;
-    }
 
-    if (-1 == lseek(fd, 0, SEEK_SET))
-    {
-        LE_ERROR("Unable to reach start of the file, errno %d.", errno);
-        goto end;
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Samples fed to the aggregation windows, kept to compute the statistics by brute force
+ */
+//--------------------------------------------------------------------------------------------------
+static double AggregationSamples[AGGREGATION_NUM_SAMPLES];
 
-    LE_ASSERT_OK(le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
-    LE_ASSERT(LE_NO_MEMORY == le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
 
-end:
-    close(fd);
-    if (-1 != remove("/tmp/PushSteamFile.txt"))
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pseudo-random sample: a slow sine with uniform noise and a few spikes, from a fixed seed so that
+ * the test is reproducible
+ */
+//--------------------------------------------------------------------------------------------------
+static double GetAggregationSample
+(
+    int index
+)
+{
+    static uint32_t seed = 12345;
+    double noise;
+
+    seed = (seed * 1103515245) + 12345;
+    noise = ((seed >> 8) & 0xFFFF) / 65536.0;
+
+    return (20 * sin(index / 300.0)) + (5 * noise) + ((0 == (seed % 97)) ? 50 : 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the statistics of a closed window against the ones computed over the raw samples
+ *
+ * @return
+ *      - Rank error of the estimated quantile
+ */
+//--------------------------------------------------------------------------------------------------
+static double CheckAggregatedWindow
+(
+    const aggregation_Config_t* configPtr,
+    const aggregation_Result_t* resultPtr
+)
+{
+    uint32_t count = 0;
+    uint32_t below = 0;
+    uint32_t belowOrEqual = 0;
+    double min = INFINITY;
+    double max = -INFINITY;
+    double sum = 0;
+    double last = 0;
+    int i;
+
+    for (i = 0; i < AGGREGATION_NUM_SAMPLES; i++)
     {
-        LE_ERROR("Unable to remove the file");
+        uint64_t timestamp = AGGREGATION_START_MS + ((uint64_t)i * AGGREGATION_SAMPLE_PERIOD_MS);
+
+        if ((timestamp < resultPtr->timestamp) ||
+            (timestamp >= (resultPtr->timestamp + configPtr->windowMs)))
+        {
+            continue;
+        }
+
+        count++;
+        min = fmin(min, AggregationSamples[i]);
+        max = fmax(max, AggregationSamples[i]);
+        sum += AggregationSamples[i];
+        last = AggregationSamples[i];
+        below += (AggregationSamples[i] < resultPtr->quantile);
+        belowOrEqual += (AggregationSamples[i] <= resultPtr->quantile);
     }
+
+    LE_ASSERT(count == resultPtr->count);
+    LE_ASSERT(min == resultPtr->min);
+    LE_ASSERT(max == resultPtr->max);
+    LE_ASSERT(last == resultPtr->last);
+    LE_ASSERT(fabs((sum / count) - resultPtr->mean) <= 1e-9 * fmax(1, fabs(resultPtr->mean)));
+
+    // distance from the quantile to the ranks covered by the estimate
+    return fmax(0, fmax(((double)below / count) - configPtr->quantile,
+                        configPtr->quantile - ((double)belowOrEqual / count)));
 }
 
+
 //--------------------------------------------------------------------------------------------------
 /**
- * main of the test
+ * Feed the samples to an aggregation window and check every closed window
  */
 //--------------------------------------------------------------------------------------------------
-COMPONENT_INIT
+static void CheckAggregation
+(
+    const aggregation_Config_t* configPtr
+)
 {
-    LE_INFO("=============== Start avDataUnitTest =====================");
+    aggregation_Ref_t windowRef = aggregation_Create(configPtr);
+    aggregation_Result_t result;
+    size_t memorySize;
+    double rankError;
+    double maxRankError = 0;
+    int numWindows = 0;
+    int i;
+
+    LE_ASSERT(NULL != windowRef);
+    memorySize = aggregation_GetMemorySize(windowRef);
+
+    for (i = 0; i <= AGGREGATION_NUM_SAMPLES; i++)
+    {
+        uint64_t timestamp = AGGREGATION_START_MS + ((uint64_t)i * AGGREGATION_SAMPLE_PERIOD_MS);
 
-    // Test - le_avdata_PushStream() API
-    TestPushStream();
+        // flush all the windows after the last sample
+        if (AGGREGATION_NUM_SAMPLES == i)
+        {
+            timestamp += 2 * configPtr->windowMs;
+        }
 
-    // Test - using dot as delimiter
-    // Check if uncreated resources return LE_NOT_FOUND
-    TestDotDelimitedPath();
+        while (aggregation_GetClosedWindow(windowRef, timestamp, &result))
+        {
+            rankError = CheckAggregatedWindow(configPtr, &result);
+            maxRankError = fmax(maxRankError, rankError);
+            numWindows++;
+            aggregation_Advance(windowRef);
+        }
 
-    // Test - using slash as delimiter
-    // Check if uncreated resources return LE_NOT_FOUND
-    TestSlashDelimitedPath();
+        if (i < AGGREGATION_NUM_SAMPLES)
+        {
+            aggregation_Add(windowRef, timestamp, AggregationSamples[i]);
+        }
+    }
 
-    // Test - check if an error occurs in case of BAD paths
-    TestBadPath();
+    LE_INFO("Window %" PRIu32 " ms, hop %" PRIu32 " ms: %d windows, p%g max rank error %f",
+            configPtr->windowMs, configPtr->hopMs, numWindows, configPtr->quantile * 100,
+            maxRankError);
+    LE_INFO("Aggregation memory %zu bytes, raw samples %zu bytes",
+            memorySize, sizeof(AggregationSamples));
 
-    // Test - airvantage server APIs
-    TestAirVantageServerAPIs();
+    LE_ASSERT(maxRankError <= AGGREGATION_MAX_RANK_ERROR);
+    LE_ASSERT(memorySize == aggregation_GetMemorySize(windowRef));
 
-    //Test namespace
-    NamespaceTest();
+    // every sample is in window / hop windows
+    LE_ASSERT(numWindows >= (int)(((uint64_t)AGGREGATION_NUM_SAMPLES * AGGREGATION_SAMPLE_PERIOD_MS)
+                                  / (configPtr->hopMs ? configPtr->hopMs : configPtr->windowMs)));
 
-    //Test - time series
-    TestTimeseries();
+    aggregation_Delete(windowRef);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the aggregation of timeseries samples over windows: numerical accuracy against brute force,
+ * memory footprint and encoded size of the record.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestTimeseriesAggregation
+(
+    void
+)
+{
+    aggregation_Config_t fixedConfig =
+    {
+        .windowMs = 2000,
+        .hopMs = 0,
+        .stats = AGGREGATION_STAT_ALL,
+        .quantile = 0.9
+    };
+    aggregation_Config_t slidingConfig =
+    {
+        .windowMs = 4000,
+        .hopMs = 1000,
+        .stats = AGGREGATION_STAT_ALL,
+        .quantile = 0.99
+    };
+    aggregation_Config_t invalidConfig;
+    timeSeries_RecordRef_t rawRecRef;
+    timeSeries_RecordRef_t aggrRecRef;
+    le_result_t result = LE_OK;
+    size_t rawSize;
+    size_t aggrSize;
+    int numRawSamples = 0;
+    int i;
+
+    LE_INFO("============= Test avdata with times series aggregation ==============");
+
+    for (i = 0; i < AGGREGATION_NUM_SAMPLES; i++)
+    {
+        AggregationSamples[i] = GetAggregationSample(i);
+    }
+
+    // Accuracy against brute force
+    CheckAggregation(&fixedConfig);
+    CheckAggregation(&slidingConfig);
+    slidingConfig.quantile = 0.5;
+    CheckAggregation(&slidingConfig);
+
+    // Invalid configurations
+    invalidConfig = fixedConfig;
+    invalidConfig.windowMs = 0;
+    LE_ASSERT(LE_BAD_PARAMETER == aggregation_CheckConfig(&invalidConfig));
+    invalidConfig = slidingConfig;
+    invalidConfig.hopMs = 3000;
+    LE_ASSERT(LE_BAD_PARAMETER == aggregation_CheckConfig(&invalidConfig));
+    invalidConfig.hopMs = 100;
+    LE_ASSERT(LE_BAD_PARAMETER == aggregation_CheckConfig(&invalidConfig));
+    invalidConfig = fixedConfig;
+    invalidConfig.stats = 0;
+    LE_ASSERT(LE_BAD_PARAMETER == aggregation_CheckConfig(&invalidConfig));
+    invalidConfig.stats = AGGREGATION_STAT_QUANTILE;
+    invalidConfig.quantile = 1.5;
+    LE_ASSERT(LE_BAD_PARAMETER == aggregation_CheckConfig(&invalidConfig));
+    LE_ASSERT(NULL == aggregation_Create(&invalidConfig));
+
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordAggregation(NULL, "/aggr/value", &fixedConfig));
+
+    // Encoded size: the same samples recorded raw and aggregated, in SenML-JSON since the CBOR
+    // encoder is stubbed in this test
+    LE_ASSERT_OK(timeSeries_Create(&rawRecRef));
+    LE_ASSERT_OK(timeSeries_Create(&aggrRecRef));
+    LE_ASSERT_OK(timeSeries_SetFormat(rawRecRef, TIMESERIES_FORMAT_SENML_JSON));
+    LE_ASSERT_OK(timeSeries_SetFormat(aggrRecRef, TIMESERIES_FORMAT_SENML_JSON));
+
+    fixedConfig.stats = AGGREGATION_STAT_MIN | AGGREGATION_STAT_MAX | AGGREGATION_STAT_MEAN;
+    LE_ASSERT(LE_BAD_PARAMETER == timeSeries_SetAggregation(aggrRecRef, "/aggr/value",
+                                                            &invalidConfig));
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_SetAggregation(aggrRecRef, "/aggr/value", NULL));
+    LE_ASSERT(LE_OVERFLOW == timeSeries_SetAggregation(aggrRecRef,
+        "/aggr/a_very_long_path_with_no_room_left_for_the_names_of_the_aggregated_resources",
+        &fixedConfig));
+    LE_ASSERT_OK(timeSeries_SetAggregation(aggrRecRef, "/aggr/value", &fixedConfig));
+
+    while ((LE_OK == result) && (numRawSamples < AGGREGATION_NUM_SAMPLES))
+    {
+        result = timeSeries_AddFloat(rawRecRef, "/aggr/value", AggregationSamples[numRawSamples],
+                                     AGGREGATION_START_MS +
+                                     ((uint64_t)numRawSamples * AGGREGATION_SAMPLE_PERIOD_MS));
+        if (LE_OK == result)
+        {
+            numRawSamples++;
+        }
+    }
+    LE_ASSERT(LE_NO_MEMORY == result);
+    rawSize = timeSeries_GetEncodedSize(rawRecRef);
+
+    for (i = 0; i < numRawSamples * 10; i++)
+    {
+        LE_ASSERT_OK(timeSeries_AddFloat(aggrRecRef, "/aggr/value", AggregationSamples[i],
+                                         AGGREGATION_START_MS +
+                                         ((uint64_t)i * AGGREGATION_SAMPLE_PERIOD_MS)));
+    }
+    aggrSize = timeSeries_GetEncodedSize(aggrRecRef);
+
+    LE_INFO("Raw: %d samples in %zu bytes, aggregated: %d samples in %zu bytes",
+            numRawSamples, rawSize, numRawSamples * 10, aggrSize);
+    LE_ASSERT(aggrSize < rawSize);
+
+    // Only numeric samples of a single type can be aggregated
+    LE_ASSERT(LE_FAULT == timeSeries_AddInt(aggrRecRef, "/aggr/value", 1, AGGREGATION_START_MS));
+    LE_ASSERT(LE_FAULT == timeSeries_AddBool(aggrRecRef, "/aggr/value", true,
+                                             AGGREGATION_START_MS));
+    LE_ASSERT(LE_FAULT == timeSeries_AddString(aggrRecRef, "/aggr/value", "1",
+                                               AGGREGATION_START_MS));
+
+    // Integer samples keep their type for min, max and last
+    fixedConfig.stats = AGGREGATION_STAT_ALL;
+    LE_ASSERT_OK(timeSeries_SetAggregation(aggrRecRef, "/aggr/intValue", &fixedConfig));
+    for (i = 0; i < 1000; i++)
+    {
+        LE_ASSERT_OK(timeSeries_AddInt(aggrRecRef, "/aggr/intValue", i % 17,
+                                       AGGREGATION_START_MS +
+                                       ((uint64_t)i * AGGREGATION_SAMPLE_PERIOD_MS)));
+    }
+    LE_ASSERT(LE_FAULT == timeSeries_AddFloat(aggrRecRef, "/aggr/intValue/min", 1.5,
+                                              AGGREGATION_START_MS));
+    LE_ASSERT(LE_FAULT == timeSeries_AddFloat(aggrRecRef, "/aggr/intValue/count", 1.5,
+                                              AGGREGATION_START_MS));
+    LE_ASSERT(LE_FAULT == timeSeries_AddInt(aggrRecRef, "/aggr/intValue/mean", 1,
+                                            AGGREGATION_START_MS));
+    LE_ASSERT(LE_FAULT == timeSeries_AddInt(aggrRecRef, "/aggr/intValue/p90", 1,
+                                            AGGREGATION_START_MS));
+    LE_ASSERT_OK(timeSeries_SetAggregation(aggrRecRef, "/aggr/intValue", NULL));
+    LE_ASSERT_OK(timeSeries_AddFloat(aggrRecRef, "/aggr/intValue", 1.5, AGGREGATION_START_MS));
+
+    // The push reports the windows ended by now
+    LE_ASSERT_OK(timeSeries_PushRecord(aggrRecRef, PushCallbackHandler, NULL));
+    LE_ASSERT_OK(timeSeries_PushRecord(rawRecRef, PushCallbackHandler, NULL));
+
+    timeSeries_Delete(rawRecRef);
+    timeSeries_Delete(aggrRecRef);
+    LE_INFO("============= Test avdata with times series aggregation passed ==============");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the samples of the last pushed record, encoded in SenML-JSON. The test values contain no
+ * brace, so that every record is delimited by braces.
+ *
+ * @return
+ *      - Number of decoded samples
+ */
+//--------------------------------------------------------------------------------------------------
+static int DecodePushedSamples
+(
+    PushedSample_t* samplesPtr,
+    int maxSamples
+)
+{
+    size_t len;
+    const uint8_t* payloadPtr = stub_GetLastPushPayload(&len);
+    char pack[len + 1];
+    char* recordPtr = pack;
+    char* fieldPtr;
+    double baseTime = 0;
+    double baseValue = 0;
+    int numSamples = 0;
+
+    memcpy(pack, payloadPtr, len);
+    pack[len] = '\0';
+
+    while ((numSamples < maxSamples) && (NULL != (recordPtr = strchr(recordPtr, '{'))))
+    {
+        PushedSample_t* samplePtr = &samplesPtr[numSamples++];
+        char* endPtr = strchr(recordPtr, '}');
+        double time = 0;
+
+        LE_ASSERT(NULL != endPtr);
+        *endPtr = '\0';
+        memset(samplePtr, 0, sizeof(PushedSample_t));
+
+        if (NULL != (fieldPtr = strstr(recordPtr, "\"bt\":")))
+        {
+            baseTime = strtod(fieldPtr + 5, NULL);
+        }
+        if (NULL != (fieldPtr = strstr(recordPtr, "\"bv\":")))
+        {
+            baseValue = strtod(fieldPtr + 5, NULL);
+        }
+        if (NULL != (fieldPtr = strstr(recordPtr, "\"t\":")))
+        {
+            time = strtod(fieldPtr + 4, NULL);
+        }
+        samplePtr->timestamp = (uint64_t)llround((baseTime + time) * 1000);
+
+        if (NULL != (fieldPtr = strstr(recordPtr, "\"v\":")))
+        {
+            samplePtr->numValue = baseValue + strtod(fieldPtr + 4, NULL);
+        }
+        else if (NULL != (fieldPtr = strstr(recordPtr, "\"vb\":")))
+        {
+            samplePtr->numValue = (0 == strncmp(fieldPtr + 5, "true", 4));
+        }
+        else if (NULL != (fieldPtr = strstr(recordPtr, "\"vs\":\"")))
+        {
+            fieldPtr += 6;
+            *strchr(fieldPtr, '"') = '\0';
+            LE_ASSERT_OK(le_utf8_Copy(samplePtr->strValue, fieldPtr, sizeof(samplePtr->strValue),
+                                      NULL));
+        }
+
+        recordPtr = endPtr + 1;
+    }
+
+    return numSamples;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the recorded sample held at a given time, i.e. the last one recorded before it
+ *
+ * @return
+ *      - Recorded sample
+ */
+//--------------------------------------------------------------------------------------------------
+static const PushedSample_t* GetHeldSample
+(
+    const PushedSample_t* samplesPtr,
+    int numSamples,
+    uint64_t timestamp
+)
+{
+    const PushedSample_t* heldPtr = NULL;
+    int i;
+
+    for (i = 0; i < numSamples; i++)
+    {
+        if (samplesPtr[i].timestamp <= timestamp)
+        {
+            heldPtr = &samplesPtr[i];
+        }
+    }
+
+    LE_ASSERT(NULL != heldPtr);
+    return heldPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a numeric signal through a filter, then check the number of recorded samples and the
+ * largest error of the signal reconstructed by holding the recorded samples
+ *
+ * @return
+ *      - Number of recorded samples
+ */
+//--------------------------------------------------------------------------------------------------
+static int CheckFilteredSignal
+(
+    const timeSeries_Filter_t* filterPtr,
+    const double* signalPtr,
+    bool isInt,
+    double* maxErrorPtr
+)
+{
+    static PushedSample_t samples[FILTER_NUM_SAMPLES];
+    le_avdata_RecordRef_t recRef = le_avdata_CreateRecord();
+    int numSamples;
+    int i;
+
+    LE_ASSERT_OK(avData_SetRecordFormat(recRef, TIMESERIES_FORMAT_SENML_JSON));
+    LE_ASSERT_OK(avData_SetRecordFilter(recRef, FILTER_PATH, filterPtr));
+
+    for (i = 0; i < FILTER_NUM_SAMPLES; i++)
+    {
+        uint64_t timestamp = FILTER_START_MS + ((uint64_t)i * FILTER_SAMPLE_PERIOD_MS);
+
+        if (isInt)
+        {
+            LE_ASSERT_OK(le_avdata_RecordInt(recRef, FILTER_PATH, (int32_t)signalPtr[i],
+                                             timestamp));
+        }
+        else
+        {
+            LE_ASSERT_OK(le_avdata_RecordFloat(recRef, FILTER_PATH, signalPtr[i], timestamp));
+        }
+    }
+
+    LE_ASSERT_OK(le_avdata_PushRecord(recRef, PushCallbackHandler, NULL));
+    le_avdata_DeleteRecord(recRef);
+
+    numSamples = DecodePushedSamples(samples, NUM_ARRAY_MEMBERS(samples));
+    LE_ASSERT(numSamples > 0);
+    LE_ASSERT(FILTER_START_MS == samples[0].timestamp);
+
+    *maxErrorPtr = 0;
+    for (i = 0; i < FILTER_NUM_SAMPLES; i++)
+    {
+        const PushedSample_t* heldPtr = GetHeldSample(samples, numSamples, FILTER_START_MS +
+                                                      ((uint64_t)i * FILTER_SAMPLE_PERIOD_MS));
+
+        *maxErrorPtr = fmax(*maxErrorPtr, fabs(signalPtr[i] - heldPtr->numValue));
+    }
+
+    return numSamples;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the filtering of timeseries samples: deadbands, change-only mode and heartbeat, with
+ * synthetic noisy signals.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestTimeseriesFilter
+(
+    void
+)
+{
+    static const char* states[] = { "idle", "run", "stop" };
+    static double signal[FILTER_NUM_SAMPLES];
+    static PushedSample_t samples[FILTER_NUM_SAMPLES];
+    timeSeries_Filter_t filter;
+    le_avdata_RecordRef_t recRef;
+    double maxError;
+    int numSamples;
+    int i;
+
+    LE_INFO("============= Test avdata with times series filter ==============");
+
+    // Invalid filters
+    recRef = le_avdata_CreateRecord();
+    memset(&filter, 0, sizeof(filter));
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordFilter(recRef, FILTER_PATH, &filter));
+    filter.heartbeatMs = 1000;
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordFilter(recRef, FILTER_PATH, &filter));
+    filter.absDeadband = -1;
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordFilter(recRef, FILTER_PATH, &filter));
+    filter.absDeadband = NAN;
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordFilter(recRef, FILTER_PATH, &filter));
+    filter.absDeadband = 0;
+    filter.pctDeadband = INFINITY;
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordFilter(recRef, FILTER_PATH, &filter));
+    filter.pctDeadband = 0;
+    filter.isChangeOnly = true;
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetRecordFilter(NULL, FILTER_PATH, &filter));
+    LE_ASSERT(LE_NOT_FOUND == avData_SetRecordFilter(recRef, FILTER_PATH, NULL));
+    LE_ASSERT_OK(avData_SetRecordFilter(recRef, FILTER_PATH, &filter));
+    LE_ASSERT_OK(avData_SetRecordFilter(recRef, FILTER_PATH, NULL));
+    le_avdata_DeleteRecord(recRef);
+
+    // Noisy ramp with an absolute deadband: the reconstruction error is bounded by the deadband
+    for (i = 0; i < FILTER_NUM_SAMPLES; i++)
+    {
+        signal[i] = (0.05 * i) + (0.2 * sin(i * 2.1)) + (0.1 * cos(i * 7.3));
+    }
+    memset(&filter, 0, sizeof(filter));
+    filter.absDeadband = 1;
+    numSamples = CheckFilteredSignal(&filter, signal, false, &maxError);
+    LE_INFO("Absolute deadband: %d samples recorded out of %d, max error %f",
+            numSamples, FILTER_NUM_SAMPLES, maxError);
+    LE_ASSERT(numSamples < (FILTER_NUM_SAMPLES / 10));
+    LE_ASSERT(maxError <= filter.absDeadband);
+
+    // Noisy sine around 100 with a percentage deadband
+    for (i = 0; i < FILTER_NUM_SAMPLES; i++)
+    {
+        signal[i] = 100 + (5 * sin(i / 40.0)) + (0.3 * sin(i * 3.7));
+    }
+    memset(&filter, 0, sizeof(filter));
+    filter.pctDeadband = 2;
+    numSamples = CheckFilteredSignal(&filter, signal, false, &maxError);
+    LE_INFO("Percentage deadband: %d samples recorded out of %d, max error %f",
+            numSamples, FILTER_NUM_SAMPLES, maxError);
+    LE_ASSERT(numSamples < (FILTER_NUM_SAMPLES / 4));
+    LE_ASSERT(maxError <= (105.3 * filter.pctDeadband / 100));
+
+    // Integer steps of 5 s with change-only mode and a 2 s heartbeat: one sample per change and
+    // two heartbeats per step, and an exact reconstruction
+    for (i = 0; i < FILTER_NUM_SAMPLES; i++)
+    {
+        signal[i] = i / 50;
+    }
+    memset(&filter, 0, sizeof(filter));
+    filter.isChangeOnly = true;
+    filter.heartbeatMs = 2000;
+    numSamples = CheckFilteredSignal(&filter, signal, true, &maxError);
+    LE_INFO("Change-only with heartbeat: %d samples recorded out of %d",
+            numSamples, FILTER_NUM_SAMPLES);
+    LE_ASSERT(((FILTER_NUM_SAMPLES / 50) * 3) == numSamples);
+    LE_ASSERT(0 == maxError);
+
+    // Boolean and string samples are only filtered by the change-only mode
+    memset(&filter, 0, sizeof(filter));
+    filter.isChangeOnly = true;
+    filter.absDeadband = 10;
+    recRef = le_avdata_CreateRecord();
+    LE_ASSERT_OK(avData_SetRecordFormat(recRef, TIMESERIES_FORMAT_SENML_JSON));
+    LE_ASSERT_OK(avData_SetRecordFilter(recRef, "/filter/bool", &filter));
+    for (i = 0; i < FILTER_NUM_SAMPLES; i++)
+    {
+        LE_ASSERT_OK(le_avdata_RecordBool(recRef, "/filter/bool", (i / 40) % 2,
+                                          FILTER_START_MS +
+                                          ((uint64_t)i * FILTER_SAMPLE_PERIOD_MS)));
+    }
+    LE_ASSERT_OK(le_avdata_PushRecord(recRef, PushCallbackHandler, NULL));
+    numSamples = DecodePushedSamples(samples, NUM_ARRAY_MEMBERS(samples));
+    LE_ASSERT((FILTER_NUM_SAMPLES / 40) == numSamples);
+    for (i = 0; i < numSamples; i++)
+    {
+        LE_ASSERT((i % 2) == samples[i].numValue);
+    }
+
+    LE_ASSERT_OK(avData_SetRecordFilter(recRef, "/filter/string", &filter));
+    for (i = 0; i < FILTER_NUM_SAMPLES; i++)
+    {
+        LE_ASSERT_OK(le_avdata_RecordString(recRef, "/filter/string",
+                                            states[(i / 25) % NUM_ARRAY_MEMBERS(states)],
+                                            FILTER_START_MS +
+                                            ((uint64_t)i * FILTER_SAMPLE_PERIOD_MS)));
+    }
+    LE_ASSERT_OK(le_avdata_PushRecord(recRef, PushCallbackHandler, NULL));
+    numSamples = DecodePushedSamples(samples, NUM_ARRAY_MEMBERS(samples));
+    LE_ASSERT((FILTER_NUM_SAMPLES / 25) == numSamples);
+    for (i = 0; i < numSamples; i++)
+    {
+        LE_ASSERT(0 == strcmp(states[i % NUM_ARRAY_MEMBERS(states)], samples[i].strValue));
+    }
+
+    // Without filter, all the samples are recorded again
+    LE_ASSERT_OK(avData_SetRecordFilter(recRef, "/filter/string", NULL));
+    LE_ASSERT_OK(le_avdata_RecordString(recRef, "/filter/string", "idle", FILTER_START_MS));
+    LE_ASSERT_OK(le_avdata_RecordString(recRef, "/filter/string", "idle",
+                                        FILTER_START_MS + FILTER_SAMPLE_PERIOD_MS));
+    LE_ASSERT_OK(le_avdata_PushRecord(recRef, PushCallbackHandler, NULL));
+    LE_ASSERT(2 == DecodePushedSamples(samples, NUM_ARRAY_MEMBERS(samples)));
+
+    le_avdata_DeleteRecord(recRef);
+    LE_INFO("============= Test avdata with times series filter passed ==============");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the next sample returned by a record iterator
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckNextSample
+(
+    timeSeries_IteratorRef_t iterRef,
+    const char* expectedPath,
+    uint64_t expectedTimestamp
+)
+{
+    const char* path;
+    le_avdata_DataType_t type;
+    uint64_t timestamp;
+
+    LE_ASSERT_OK(timeSeries_NextSample(iterRef));
+    LE_ASSERT_OK(timeSeries_GetSampleInfo(iterRef, &path, &type, &timestamp));
+    LE_ASSERT(0 == strcmp(expectedPath, path));
+    LE_ASSERT(expectedTimestamp == timestamp);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the local read-back of timeseries records: iteration order, resource and time range
+ * filters, samples added while iterating, and samples dropped without pushing them.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestTimeseriesReadBack
+(
+    void
+)
+{
+    static PushedSample_t samples[4 * READBACK_NUM_SAMPLES];
+    timeSeries_IteratorRef_t iterRef;
+    timeSeries_IteratorRef_t dropIterRef;
+    le_avdata_RecordRef_t recRef;
+    le_avdata_DataType_t type;
+    const char* strValue;
+    char expectedStr[8];
+    int32_t intValue;
+    double floatValue;
+    bool boolValue;
+    size_t numDropped;
+    int i;
+
+    LE_INFO("============= Test avdata with times series read-back ==============");
+
+    // Samples recorded backwards: the resources are created in the order int, state, bool, float
+    recRef = le_avdata_CreateRecord();
+    LE_ASSERT_OK(avData_SetRecordFormat(recRef, TIMESERIES_FORMAT_SENML_JSON));
+    for (i = READBACK_NUM_SAMPLES - 1; i >= 0; i--)
+    {
+        LE_ASSERT_OK(le_avdata_RecordInt(recRef, "/rb/int", i, READBACK_TIME(i)));
+        if (0 == (i % 3))
+        {
+            snprintf(expectedStr, sizeof(expectedStr), "s%d", i);
+            LE_ASSERT_OK(le_avdata_RecordString(recRef, "/rb/state", expectedStr,
+                                                READBACK_TIME(i)));
+        }
+        LE_ASSERT_OK(le_avdata_RecordBool(recRef, "/other/bool", i % 2, READBACK_TIME(i)));
+        if (0 == (i % 2))
+        {
+            LE_ASSERT_OK(le_avdata_RecordFloat(recRef, "/rb/float", i * 0.5, READBACK_TIME(i)));
+        }
+    }
+
+    // Invalid parameters
+    LE_ASSERT(LE_BAD_PARAMETER == avData_CreateRecordIterator(NULL, NULL, 0, UINT64_MAX,
+                                                              &iterRef));
+    LE_ASSERT(LE_BAD_PARAMETER == avData_CreateRecordIterator(recRef, NULL, 2, 1, &iterRef));
+
+    // All the samples, by timestamp then by resource creation order, with typed accessors
+    LE_ASSERT_OK(avData_CreateRecordIterator(recRef, NULL, 0, UINT64_MAX, &iterRef));
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_GetSampleInfo(iterRef, NULL, NULL, NULL));
+    for (i = 0; i < READBACK_NUM_SAMPLES; i++)
+    {
+        CheckNextSample(iterRef, "/rb/int", READBACK_TIME(i));
+        LE_ASSERT_OK(timeSeries_GetSampleInfo(iterRef, NULL, &type, NULL));
+        LE_ASSERT(LE_AVDATA_DATA_TYPE_INT == type);
+        LE_ASSERT_OK(timeSeries_GetSampleInt(iterRef, &intValue));
+        LE_ASSERT(i == intValue);
+        LE_ASSERT(LE_FAULT == timeSeries_GetSampleFloat(iterRef, &floatValue));
+
+        if (0 == (i % 3))
+        {
+            CheckNextSample(iterRef, "/rb/state", READBACK_TIME(i));
+            snprintf(expectedStr, sizeof(expectedStr), "s%d", i);
+            LE_ASSERT_OK(timeSeries_GetSampleString(iterRef, &strValue));
+            LE_ASSERT(0 == strcmp(expectedStr, strValue));
+        }
+
+        CheckNextSample(iterRef, "/other/bool", READBACK_TIME(i));
+        LE_ASSERT_OK(timeSeries_GetSampleBool(iterRef, &boolValue));
+        LE_ASSERT((i % 2) == boolValue);
+
+        if (0 == (i % 2))
+        {
+            CheckNextSample(iterRef, "/rb/float", READBACK_TIME(i));
+            LE_ASSERT_OK(timeSeries_GetSampleFloat(iterRef, &floatValue));
+            LE_ASSERT((i * 0.5) == floatValue);
+        }
+    }
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_NextSample(iterRef));
+    timeSeries_DeleteIterator(iterRef);
+
+    // Resource and time range filters: the children of /rb between the samples 2 and 5
+    LE_ASSERT_OK(avData_CreateRecordIterator(recRef, "/rb", READBACK_TIME(2), READBACK_TIME(5),
+                                             &iterRef));
+    CheckNextSample(iterRef, "/rb/int", READBACK_TIME(2));
+    CheckNextSample(iterRef, "/rb/float", READBACK_TIME(2));
+    CheckNextSample(iterRef, "/rb/int", READBACK_TIME(3));
+    CheckNextSample(iterRef, "/rb/state", READBACK_TIME(3));
+    CheckNextSample(iterRef, "/rb/int", READBACK_TIME(4));
+    CheckNextSample(iterRef, "/rb/float", READBACK_TIME(4));
+    CheckNextSample(iterRef, "/rb/int", READBACK_TIME(5));
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_NextSample(iterRef));
+    timeSeries_DeleteIterator(iterRef);
+
+    // A path filter only matches whole path components
+    LE_ASSERT_OK(avData_CreateRecordIterator(recRef, "/rb/in", 0, UINT64_MAX, &iterRef));
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_NextSample(iterRef));
+    timeSeries_DeleteIterator(iterRef);
+
+    // Samples added while iterating are returned if they come after the current one, including
+    // once the end was reached
+    LE_ASSERT_OK(avData_CreateRecordIterator(recRef, "/rb/int", 0, UINT64_MAX, &iterRef));
+    LE_ASSERT_OK(avData_CreateRecordIterator(recRef, "/rb/int", 0, UINT64_MAX, &dropIterRef));
+    CheckNextSample(iterRef, "/rb/int", READBACK_TIME(0));
+    LE_ASSERT_OK(le_avdata_RecordInt(recRef, "/rb/int", 10, READBACK_TIME(10)));
+    LE_ASSERT_OK(le_avdata_RecordInt(recRef, "/rb/int", -1, READBACK_TIME(0) - 1));
+    for (i = 1; i <= READBACK_NUM_SAMPLES; i++)
+    {
+        CheckNextSample(iterRef, "/rb/int", READBACK_TIME(i));
+        LE_ASSERT_OK(timeSeries_GetSampleInt(iterRef, &intValue));
+        LE_ASSERT(i == intValue);
+    }
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_NextSample(iterRef));
+    LE_ASSERT_OK(le_avdata_RecordInt(recRef, "/rb/int", 11, READBACK_TIME(11)));
+    CheckNextSample(iterRef, "/rb/int", READBACK_TIME(11));
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_NextSample(iterRef));
+
+    // Samples dropped under an iterator: the iterator goes on with the next kept sample
+    CheckNextSample(dropIterRef, "/rb/int", READBACK_TIME(0) - 1);
+    CheckNextSample(dropIterRef, "/rb/int", READBACK_TIME(0));
+    LE_ASSERT_OK(avData_DropRecordSamples(recRef, READBACK_TIME(5), &numDropped));
+    LE_ASSERT(16 == numDropped);
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_GetSampleInt(dropIterRef, &intValue));
+    CheckNextSample(dropIterRef, "/rb/int", READBACK_TIME(5));
+    LE_ASSERT_OK(avData_DropRecordSamples(recRef, READBACK_TIME(5), &numDropped));
+    LE_ASSERT(0 == numDropped);
+
+    // Only the kept samples are pushed, and the push empties the record under the iterators
+    LE_ASSERT_OK(le_avdata_PushRecord(recRef, PushCallbackHandler, NULL));
+    LE_ASSERT(16 == DecodePushedSamples(samples, NUM_ARRAY_MEMBERS(samples)));
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_GetSampleInt(iterRef, &intValue));
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_NextSample(iterRef));
+
+    // An iterator outlives its record
+    le_avdata_DeleteRecord(recRef);
+    LE_ASSERT(LE_NOT_FOUND == timeSeries_NextSample(dropIterRef));
+    timeSeries_DeleteIterator(dropIterRef);
+    timeSeries_DeleteIterator(iterRef);
+
+    LE_INFO("============= Test avdata with times series read-back passed ==============");
+}
+
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Test Airvantage server APIs:  le_avdata_PushStream()
+ */
+//-------------------------------------------------------------------------------------------------
+static void TestPushStream
+(
+    void
+)
+{
+    int fd;
+    char dummyData[512];
+
+    LE_INFO("============= Test le_avdata_PushStream() API ==============");
+
+    // Use an invalid file descriptor
+    fd = -5;
+    LE_ASSERT(LE_FAULT == le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
+
+    fd = 10;
+    LE_ASSERT(LE_FAULT == le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
+
+    //Push a huge amount of data
+    fd = open("/dev/urandom", O_RDONLY);
+    if (-1 == fd)
+    {
+        LE_ERROR("Failed to open file descriptor, errno %d.", errno);
+        return;
+    }
+
+    LE_ASSERT(LE_OVERFLOW == le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
+    close(fd);
+
+    // Create a file and populate it with data, then push it.
+    fd = open("/tmp/PushSteamFile.txt", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (-1 == fd)
+    {
+        LE_ERROR("Failed to create file, errno %d.", errno);
+        return;
+    }
+
+    if (-1 == FdWrite(fd, dummyData, sizeof(dummyData)))
+    {
+        LE_ERROR("Unable to write buffer in file, errno %d.", errno);
+        goto end;
+    }
+
+    if (-1 == lseek(fd, 0, SEEK_SET))
+    {
+        LE_ERROR("Unable to reach start of the file, errno %d.", errno);
+        goto end;
+    }
+
+    LE_ASSERT_OK(le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
+    LE_ASSERT(LE_NO_MEMORY == le_avdata_PushStream("data", fd, PushCallbackHandler, NULL));
+
+end:
+    close(fd);
+    if (-1 != remove("/tmp/PushSteamFile.txt"))
+    {
+        LE_ERROR("Unable to remove the file");
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Test the per-application quotas: an application exceeding its quotas is rejected, without
+ * affecting another application.
+ */
+//-------------------------------------------------------------------------------------------------
+static void TestQuota
+(
+    void
+)
+{
+    le_msg_SessionRef_t sessionA = (le_msg_SessionRef_t)0x2001;
+    le_msg_SessionRef_t sessionB = (le_msg_SessionRef_t)0x2002;
+    uint64_t timestamp = 1500000000000ULL;
+    le_avdata_RecordRef_t recRefA;
+    le_avdata_RecordRef_t recRefB;
+    quota_Usage_t usage;
+    le_result_t result = LE_OK;
+    int numSamples = 0;
+    int i;
+
+    LE_INFO("============= Test avdata per-application quotas ==============");
+
+    // Application A is limited, application B is not
+    stub_SetCfgInt("/apps/avcService/quotas/quotaAppA/maxResources", 3);
+    stub_SetCfgInt("/apps/avcService/quotas/quotaAppA/maxStringBytes", 32);
+    stub_SetCfgInt("/apps/avcService/quotas/quotaAppA/maxRecordBytes", 512);
+    stub_SetCfgInt("/apps/avcService/quotas/quotaAppA/maxQueuedPushes", 1);
+
+    // Resources
+    stub_SetClient(sessionA, "quotaAppA");
+    LE_ASSERT_OK(le_avdata_CreateResource("/quota/res1", LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT_OK(le_avdata_CreateResource("/quota/res2", LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT_OK(le_avdata_CreateResource("/quota/res3", LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT(QUOTA_EXCEEDED == le_avdata_CreateResource("/quota/res4",
+                                                         LE_AVDATA_ACCESS_VARIABLE));
+
+    stub_SetClient(sessionB, "quotaAppB");
+    for (i = 1; i <= 4; i++)
+    {
+        char path[LE_AVDATA_PATH_NAME_BYTES];
+        snprintf(path, sizeof(path), "/quota/res%d", i);
+        LE_ASSERT_OK(le_avdata_CreateResource(path, LE_AVDATA_ACCESS_VARIABLE));
+    }
+
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_RESOURCES, &usage));
+    LE_ASSERT((3 == usage.used) && (3 == usage.limit) && (1 == usage.rejected));
+    LE_ASSERT_OK(quota_GetUsage("quotaAppB", QUOTA_RESOURCES, &usage));
+    LE_ASSERT((4 == usage.used) && (QUOTA_UNLIMITED == usage.limit));
+    LE_ASSERT(LE_NOT_FOUND == quota_GetUsage("quotaAppC", QUOTA_RESOURCES, &usage));
+    LE_ASSERT(LE_BAD_PARAMETER == quota_GetUsage("quotaAppA", QUOTA_MAX, &usage));
+
+    // String values: a shorter value frees room for another one
+    stub_SetClient(sessionA, "quotaAppA");
+    LE_ASSERT_OK(le_avdata_SetString("/quota/res1", "0123456789abcdefghij"));
+    LE_ASSERT(QUOTA_EXCEEDED == le_avdata_SetString("/quota/res2", "0123456789abcdefghij"));
+    LE_ASSERT_OK(le_avdata_SetString("/quota/res1", "short"));
+    LE_ASSERT_OK(le_avdata_SetString("/quota/res2", "0123456789abcdefghij"));
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_STRING_BYTES, &usage));
+    LE_ASSERT((27 == usage.used) && (1 == usage.rejected));
+
+    stub_SetClient(sessionB, "quotaAppB");
+    LE_ASSERT_OK(le_avdata_SetString("/quota/res1", "0123456789abcdefghij"));
+    LE_ASSERT_OK(le_avdata_SetString("/quota/res2", "0123456789abcdefghij"));
+
+    // Records fill up at the quota instead of the buffer size
+    stub_SetClient(sessionA, "quotaAppA");
+    recRefA = le_avdata_CreateRecord();
+    LE_ASSERT_OK(avData_SetRecordFormat(recRefA, TIMESERIES_FORMAT_SENML_JSON));
+    while ((LE_OK == result) && (numSamples < 1000))
+    {
+        timestamp += 250;
+        result = le_avdata_RecordInt(recRefA, "/quota/record", numSamples, timestamp);
+        if (LE_OK == result)
+        {
+            numSamples++;
+        }
+    }
+
+    LE_INFO("%d samples in a record limited by the quota", numSamples);
+    LE_ASSERT(QUOTA_EXCEEDED == result);
+    LE_ASSERT(numSamples > 0);
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_RECORD_BYTES, &usage));
+    LE_ASSERT((usage.used > 0) && (usage.used <= 512) && (1 == usage.rejected));
+
+    stub_SetClient(sessionB, "quotaAppB");
+    recRefB = le_avdata_CreateRecord();
+    LE_ASSERT_OK(avData_SetRecordFormat(recRefB, TIMESERIES_FORMAT_SENML_JSON));
+    for (i = 0; i < numSamples * 2; i++)
+    {
+        timestamp += 250;
+        LE_ASSERT_OK(le_avdata_RecordInt(recRefB, "/quota/record", i, timestamp));
+    }
+
+    // A push empties the record and takes the only queued push of application A
+    stub_SetClient(sessionA, "quotaAppA");
+    LE_ASSERT_OK(le_avdata_PushRecord(recRefA, PushCallbackHandler, NULL));
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_RECORD_BYTES, &usage));
+    LE_ASSERT(usage.used < 512 / 4);
+    LE_ASSERT_OK(le_avdata_RecordInt(recRefA, "/quota/record", 0, timestamp));
+
+    LE_ASSERT(QUOTA_EXCEEDED == le_avdata_Push("/quota/res1", PushCallbackHandler, NULL));
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_QUEUED_PUSHES, &usage));
+    LE_ASSERT((1 == usage.used) && (1 == usage.rejected));
+
+    // The push of application B is sent once the push of application A is acknowledged
+    stub_SetClient(sessionB, "quotaAppB");
+    LE_ASSERT_OK(le_avdata_PushRecord(recRefB, PushCallbackHandler, NULL));
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_QUEUED_PUSHES, &usage));
+    LE_ASSERT(0 == usage.used);
+
+    stub_SetClient(sessionA, "quotaAppA");
+    LE_ASSERT_OK(le_avdata_Push("/quota/res1", PushCallbackHandler, NULL));
+
+    quota_Dump();
+
+    // Everything but the queued push is released when the application exits
+    stub_CloseClient(sessionA);
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_RESOURCES, &usage));
+    LE_ASSERT((0 == usage.used) && (3 == usage.peak));
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_STRING_BYTES, &usage));
+    LE_ASSERT(0 == usage.used);
+    LE_ASSERT_OK(quota_GetUsage("quotaAppA", QUOTA_RECORD_BYTES, &usage));
+    LE_ASSERT(0 == usage.used);
+
+    stub_CloseClient(sessionB);
+    LE_ASSERT_OK(quota_GetUsage("quotaAppB", QUOTA_RESOURCES, &usage));
+    LE_ASSERT(0 == usage.used);
+
+    stub_SetClient((le_msg_SessionRef_t)0x1001, "test");
+    LE_INFO("============= Test avdata per-application quotas passed ==============");
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Change handler of the change stream test: log the received events
+ */
+//-------------------------------------------------------------------------------------------------
+static void LogChanges
+(
+    const changeStream_Event_t* eventArr,
+    size_t numEvents,
+    uint32_t numLost,
+    void* contextPtr
+)
+{
+    ChangeLog_t* logPtr = contextPtr;
+    size_t i;
+
+    LE_ASSERT((numEvents > 0) || (numLost > 0));
+
+    logPtr->numBatches++;
+    logPtr->numLost += numLost;
+
+    for (i = 0; i < numEvents; i++)
+    {
+        LE_ASSERT(logPtr->numEvents < STREAM_MAX_LOGGED);
+
+        size_t index = logPtr->numEvents++;
+        LE_ASSERT_OK(le_utf8_Copy(logPtr->event[index].path, eventArr[i].path,
+                                  sizeof(logPtr->event[index].path), NULL));
+        logPtr->event[index].dataType = eventArr[i].dataType;
+        logPtr->event[index].value = eventArr[i].value;
+        logPtr->event[index].origin = eventArr[i].origin;
+
+        if (LE_AVDATA_DATA_TYPE_STRING == eventArr[i].dataType)
+        {
+            LE_ASSERT_OK(le_utf8_Copy(logPtr->event[index].strValue, eventArr[i].value.strValuePtr,
+                                      sizeof(logPtr->event[index].strValue), NULL));
+        }
+    }
+
+    // Unsubscribe another subscriber while the batches are delivered
+    if (NULL != logPtr->unsubscribeRef)
+    {
+        LE_ASSERT_OK(changeStream_Unsubscribe(logPtr->unsubscribeRef));
+        logPtr->unsubscribeRef = NULL;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Change handler of the le_avdataStream client of the change stream test: log the last change
+ */
+//-------------------------------------------------------------------------------------------------
+static void LogClientChange
+(
+    const char* path,
+    le_avdata_DataType_t dataType,
+    int32_t intValue,
+    double floatValue,
+    bool boolValue,
+    const char* strValue,
+    le_avdataStream_Origin_t origin,
+    uint32_t numLost,
+    void* contextPtr
+)
+{
+    ClientChangeLog_t* logPtr = contextPtr;
+
+    logPtr->numCalls++;
+    logPtr->numLost += numLost;
+    logPtr->origin = origin;
+    LE_ASSERT_OK(le_utf8_Copy(logPtr->path, path, sizeof(logPtr->path), NULL));
+    LE_ASSERT_OK(le_utf8_Copy(logPtr->strValue, strValue, sizeof(logPtr->strValue), NULL));
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Check an integer change event received by a subscriber of the change stream test
+ */
+//-------------------------------------------------------------------------------------------------
+static void CheckIntChange
+(
+    const ChangeLog_t* logPtr,
+    size_t index,
+    const char* path,
+    int value
+)
+{
+    LE_ASSERT(index < logPtr->numEvents);
+    LE_ASSERT(0 == strcmp(logPtr->event[index].path, path));
+    LE_ASSERT(LE_AVDATA_DATA_TYPE_INT == logPtr->event[index].dataType);
+    LE_ASSERT(value == logPtr->event[index].value.intValue);
+    LE_ASSERT(CHANGESTREAM_ORIGIN_CLIENT == logPtr->event[index].origin);
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Check that the handler of the le_avdataStream client was removed with its session, and end the
+ * test.
+ */
+//-------------------------------------------------------------------------------------------------
+static void CheckChangeStreamClosed
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    LE_ASSERT(1 == StreamClientLog.numCalls);
+
+    stub_CloseClient((le_msg_SessionRef_t)0x5001);
+    stub_SetClient((le_msg_SessionRef_t)0x1001, "test");
+    LE_INFO("============= Test avdata change streams passed ==============");
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Check the changes received by the le_avdataStream client, then close its session.
+ */
+//-------------------------------------------------------------------------------------------------
+static void CheckChangeStreamClient
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    // Only the latest change was kept, the other one is reported as lost
+    LE_ASSERT((1 == StreamClientLog.numCalls) && (1 == StreamClientLog.numLost));
+    LE_ASSERT(0 == strcmp(StreamClientLog.path, STREAM_PATH_Y));
+    LE_ASSERT(0 == strcmp(StreamClientLog.strValue, "again"));
+    LE_ASSERT(LE_AVDATASTREAM_ORIGIN_CLIENT == StreamClientLog.origin);
+
+    // The handler is removed when the client session is closed
+    stub_CloseClient(STREAM_CLIENT_SESSION);
+    LE_ASSERT_OK(le_avdata_SetInt(STREAM_RES_X, 6));
+    le_event_QueueFunction(CheckChangeStreamClosed, NULL, NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Check the change stream test once a subscriber was unsubscribed by the handler of another one,
+ * and end the test.
+ */
+//-------------------------------------------------------------------------------------------------
+static void CheckChangeStreamUnsubscribe
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    changeStream_Stats_t stats;
+
+    // Only the remaining subscriber observing the resource got the change
+    LE_ASSERT((1 == StreamAllLog.numBatches) && (1 == StreamAllLog.numEvents));
+    CheckIntChange(&StreamAllLog, 0, STREAM_PATH_X, 4);
+    LE_ASSERT(0 == StreamSubtreeLog.numBatches);
+    LE_ASSERT(0 == StreamSmallLog.numBatches);
+    LE_ASSERT(LE_BAD_PARAMETER == changeStream_GetStats(StreamSmallRef, &stats));
+
+    LE_ASSERT_OK(changeStream_GetStats(StreamAllRef, &stats));
+    LE_ASSERT((9 == stats.delivered) && (0 == stats.lost) && (0 == stats.queued));
+    LE_ASSERT_OK(changeStream_Unsubscribe(StreamAllRef));
+    LE_ASSERT(LE_BAD_PARAMETER == changeStream_Unsubscribe(StreamAllRef));
+
+    // A client of the le_avdataStream service observes the subtree with a queue of one change
+    stub_SetClient(STREAM_CLIENT_SESSION, "streamClient");
+    LE_ASSERT(NULL == le_avdataStream_AddChangeHandler(STREAM_SUBTREE_A, 0, LogClientChange,
+                                                       &StreamClientLog));
+    LE_ASSERT(NULL == le_avdataStream_AddChangeHandler(STREAM_SUBTREE_A, 1, NULL, NULL));
+    StreamClientRef = le_avdataStream_AddChangeHandler(STREAM_SUBTREE_A, 1, LogClientChange,
+                                                       &StreamClientLog);
+    LE_ASSERT(NULL != StreamClientRef);
+
+    // The handler cannot be removed by another client
+    stub_SetClient((le_msg_SessionRef_t)0x5001, "streamApp");
+    le_avdataStream_RemoveChangeHandler(StreamClientRef);
+
+    LE_ASSERT_OK(le_avdata_SetInt(STREAM_RES_X, 5));
+    LE_ASSERT_OK(le_avdata_SetString(STREAM_RES_Y, "again"));
+    le_event_QueueFunction(CheckChangeStreamClient, NULL, NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Check the batches delivered to the subscribers of the change stream test, then unsubscribe
+ * subscribers before and during the next delivery.
+ */
+//-------------------------------------------------------------------------------------------------
+static void CheckChangeStream
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    changeStream_Stats_t stats;
+
+    // The whole tree: every change in one batch, in order
+    LE_ASSERT(1 == StreamAllLog.numBatches);
+    LE_ASSERT((8 == StreamAllLog.numEvents) && (0 == StreamAllLog.numLost));
+    CheckIntChange(&StreamAllLog, 0, STREAM_PATH_X, 1);
+    LE_ASSERT(0 == strcmp(StreamAllLog.event[1].path, STREAM_PATH_Y));
+    LE_ASSERT(0 == strcmp(StreamAllLog.event[1].strValue, "hello"));
+    LE_ASSERT(0 == strcmp(StreamAllLog.event[2].path, STREAM_PATH_Z));
+    LE_ASSERT(LE_AVDATA_DATA_TYPE_FLOAT == StreamAllLog.event[2].dataType);
+    LE_ASSERT(1.5 == StreamAllLog.event[2].value.floatValue);
+    LE_ASSERT(0 == strcmp(StreamAllLog.event[3].path, STREAM_PATH_AB));
+    LE_ASSERT(LE_AVDATA_DATA_TYPE_BOOL == StreamAllLog.event[3].dataType);
+    LE_ASSERT(StreamAllLog.event[3].value.boolValue);
+    LE_ASSERT(0 == strcmp(StreamAllLog.event[4].strValue, "world"));
+    CheckIntChange(&StreamAllLog, 5, STREAM_PATH_X, 2);
+    CheckIntChange(&StreamAllLog, 6, STREAM_PATH_X, 3);
+    LE_ASSERT(0 == strcmp(StreamAllLog.event[7].path, STREAM_PATH_Z));
+    LE_ASSERT(LE_AVDATA_DATA_TYPE_NONE == StreamAllLog.event[7].dataType);
+
+    // The subtree: not its sibling with the same prefix, nor the other subtree
+    LE_ASSERT(1 == StreamSubtreeLog.numBatches);
+    LE_ASSERT((5 == StreamSubtreeLog.numEvents) && (0 == StreamSubtreeLog.numLost));
+    CheckIntChange(&StreamSubtreeLog, 0, STREAM_PATH_X, 1);
+    LE_ASSERT(0 == strcmp(StreamSubtreeLog.event[1].strValue, "hello"));
+    LE_ASSERT(0 == strcmp(StreamSubtreeLog.event[2].strValue, "world"));
+    CheckIntChange(&StreamSubtreeLog, 3, STREAM_PATH_X, 2);
+    CheckIntChange(&StreamSubtreeLog, 4, STREAM_PATH_X, 3);
+
+    // The small queue kept the latest changes and reported the oldest one as lost
+    LE_ASSERT(1 == StreamSmallLog.numBatches);
+    LE_ASSERT((2 == StreamSmallLog.numEvents) && (1 == StreamSmallLog.numLost));
+    CheckIntChange(&StreamSmallLog, 0, STREAM_PATH_X, 2);
+    CheckIntChange(&StreamSmallLog, 1, STREAM_PATH_X, 3);
+    LE_ASSERT_OK(changeStream_GetStats(StreamSmallRef, &stats));
+    LE_ASSERT((2 == stats.delivered) && (1 == stats.lost) && (0 == stats.queued));
+
+    // Unsubscribe the subtree now, and the small queue from the handler of the whole tree, which
+    // is called first
+    memset(&StreamAllLog, 0, sizeof(StreamAllLog));
+    memset(&StreamSubtreeLog, 0, sizeof(StreamSubtreeLog));
+    memset(&StreamSmallLog, 0, sizeof(StreamSmallLog));
+    LE_ASSERT_OK(changeStream_Unsubscribe(StreamSubtreeRef));
+    StreamAllLog.unsubscribeRef = StreamSmallRef;
+
+    LE_ASSERT_OK(le_avdata_SetInt(STREAM_RES_X, 4));
+    le_event_QueueFunction(CheckChangeStreamUnsubscribe, NULL, NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Test the local change streams: several subscribers of the whole tree, of a subtree and of a
+ * resource receive the changes of an application in batches, checked from the event loop.
+ */
+//-------------------------------------------------------------------------------------------------
+static void TestChangeStream
+(
+    void
+)
+{
+    changeStream_Stats_t stats;
+
+    LE_INFO("============= Test avdata change streams ==============");
+
+    LE_ASSERT(NULL == changeStream_Subscribe("/", 1, NULL, NULL));
+    LE_ASSERT(NULL == changeStream_Subscribe("/", 0, LogChanges, &StreamAllLog));
+    LE_ASSERT(NULL == changeStream_Subscribe("/", CHANGESTREAM_MAX_EVENTS + 1, LogChanges,
+                                             &StreamAllLog));
+    LE_ASSERT(LE_BAD_PARAMETER == changeStream_Unsubscribe(NULL));
+
+    stub_SetClient((le_msg_SessionRef_t)0x5001, "streamApp");
+    LE_ASSERT_OK(le_avdata_CreateResource(STREAM_RES_X, LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT_OK(le_avdata_CreateResource(STREAM_RES_Y, LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT_OK(le_avdata_CreateResource(STREAM_RES_Z, LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT_OK(le_avdata_CreateResource(STREAM_RES_AB, LE_AVDATA_ACCESS_VARIABLE));
+
+    StreamAllRef = changeStream_Subscribe("/", STREAM_MAX_LOGGED, LogChanges, &StreamAllLog);
+    StreamSubtreeRef = changeStream_Subscribe(STREAM_SUBTREE_A, STREAM_MAX_LOGGED, LogChanges,
+                                              &StreamSubtreeLog);
+    StreamSmallRef = changeStream_Subscribe(STREAM_PATH_X, STREAM_SMALL_QUEUE, LogChanges,
+                                            &StreamSmallLog);
+    LE_ASSERT((NULL != StreamAllRef) && (NULL != StreamSubtreeRef) && (NULL != StreamSmallRef));
+
+    LE_ASSERT_OK(le_avdata_SetInt(STREAM_RES_X, 1));
+    LE_ASSERT_OK(le_avdata_SetString(STREAM_RES_Y, "hello"));
+    LE_ASSERT_OK(le_avdata_SetFloat(STREAM_RES_Z, 1.5));
+    LE_ASSERT_OK(le_avdata_SetBool(STREAM_RES_AB, true));
+    LE_ASSERT_OK(le_avdata_SetString(STREAM_RES_Y, "world"));
+    LE_ASSERT_OK(le_avdata_SetInt(STREAM_RES_X, 2));
+    LE_ASSERT_OK(le_avdata_SetInt(STREAM_RES_X, 3));
+    LE_ASSERT_OK(le_avdata_SetNull(STREAM_RES_Z));
+    LE_ASSERT(LE_NOT_FOUND == le_avdata_SetInt("/stream/missing", 0));
+
+    // Nothing is delivered before the next event loop turn
+    LE_ASSERT(0 == StreamAllLog.numBatches);
+    LE_ASSERT_OK(changeStream_GetStats(StreamSmallRef, &stats));
+    LE_ASSERT((0 == stats.delivered) && (1 == stats.lost) && (2 == stats.queued));
+
+    le_event_QueueFunction(CheckChangeStream, NULL, NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Command handler of the command execution test: the result is replied later by the test.
+ */
+//-------------------------------------------------------------------------------------------------
+static void ExecHandler
+(
+    const char* path,                          ///< [IN] Asset data path.
+    le_avdata_AccessType_t accessType,         ///< [IN] Permitted server access to this asset data.
+    le_avdata_ArgumentListRef_t argumentList,  ///< [IN] Argument list.
+    void* contextPtr                           ///< [IN] Associated context pointer.
+)
+{
+    int arg = 0;
+
+    LE_ASSERT(LE_AVDATA_ACCESS_EXEC == accessType);
+    LE_ASSERT_OK(le_avdata_GetIntArg(argumentList, EXEC_ARG_NAME, &arg));
+    LE_ASSERT(EXEC_ARG_VALUE == arg);
+    ExecArgListRef = argumentList;
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Send a command execution request of the server, and check that the command handler is called
+ */
+//-------------------------------------------------------------------------------------------------
+static le_avdata_ArgumentListRef_t SendExecRequest
+(
+    void
+)
+{
+    static const uint8_t args[] = { 0xA1, 0x61, 'n', EXEC_ARG_VALUE };
+    lwm2mcore_CoapResponseCode_t code;
+    uint16_t contentType;
+    const uint8_t* payloadPtr;
+    size_t payloadLength;
+
+    ExecArgListRef = NULL;
+    ExecResponseCount = stub_GetServerResponse(&code, &contentType, &payloadPtr, &payloadLength);
+    stub_SendServerRequest(COAP_POST, SERVER_EXEC_RESOURCE, args, sizeof(args));
+    LE_ASSERT(NULL != ExecArgListRef);
+
+    return ExecArgListRef;
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Check the response sent to the server since the last command execution request
+ */
+//-------------------------------------------------------------------------------------------------
+static void CheckExecResponse
+(
+    int expectedCode,
+    uint16_t expectedContentType,
+    const uint8_t* expectedPayloadPtr,
+    size_t expectedPayloadLength
+)
+{
+    lwm2mcore_CoapResponseCode_t code;
+    uint16_t contentType;
+    const uint8_t* payloadPtr;
+    size_t payloadLength;
+
+    LE_ASSERT((ExecResponseCount + 1) == stub_GetServerResponse(&code, &contentType, &payloadPtr,
+                                                                &payloadLength));
+    LE_ASSERT(expectedCode == (int)code);
+    LE_ASSERT(expectedPayloadLength == payloadLength);
+    if (0 != payloadLength)
+    {
+        LE_ASSERT(expectedContentType == contentType);
+        LE_ASSERT(0 == memcmp(payloadPtr, expectedPayloadPtr, payloadLength));
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Test the command execution results replied with a payload, and the replies without pending
+ * command execution
+ */
+//-------------------------------------------------------------------------------------------------
+static void TestExecResult
+(
+    void
+)
+{
+    static const uint8_t cborResult[] = { 0xA1, 0x61, 'r', 0x01 };
+    static const uint8_t truncatedCbor[] = { 0xA1, 0x61 };
+    static const uint8_t trailingCbor[] = { 0xA0, 0xA0 };
+    static const uint8_t largeResult[AVDATA_EXEC_RESULT_MAX_BYTES + 1];
+    static const char stringResult[] = "failed";
+    le_avdata_ArgumentListRef_t argListRef;
+
+    LE_INFO("============= Test avdata command execution result ==============");
+
+    LE_ASSERT_OK(le_avdata_CreateResource(EXEC_RESOURCE, LE_AVDATA_ACCESS_COMMAND));
+    LE_ASSERT(NULL != le_avdata_AddResourceEventHandler(EXEC_RESOURCE, ExecHandler, NULL));
+
+    // CBOR result of a successful command
+    argListRef = SendExecRequest();
+    LE_ASSERT_OK(avData_ReplyExecResultPayload(argListRef, LE_OK, AVDATA_EXEC_RESULT_CBOR,
+                                               cborResult, sizeof(cborResult)));
+    CheckExecResponse(COAP_CONTENT_AVAILABLE, LWM2MCORE_PUSH_CONTENT_CBOR,
+                      cborResult, sizeof(cborResult));
+
+    // A second reply is ignored
+    LE_ASSERT(LE_NOT_FOUND == avData_ReplyExecResultPayload(argListRef, LE_OK,
+                                                            AVDATA_EXEC_RESULT_CBOR, NULL, 0));
+    le_avdata_ReplyExecResult(argListRef, LE_OK);
+    CheckExecResponse(COAP_CONTENT_AVAILABLE, LWM2MCORE_PUSH_CONTENT_CBOR,
+                      cborResult, sizeof(cborResult));
+
+    // Invalid payloads are rejected, and the command is still pending
+    argListRef = SendExecRequest();
+    LE_ASSERT(LE_FORMAT_ERROR == avData_ReplyExecResultPayload(argListRef, LE_OK,
+                                                               AVDATA_EXEC_RESULT_CBOR,
+                                                               truncatedCbor,
+                                                               sizeof(truncatedCbor)));
+    LE_ASSERT(LE_FORMAT_ERROR == avData_ReplyExecResultPayload(argListRef, LE_OK,
+                                                               AVDATA_EXEC_RESULT_CBOR,
+                                                               trailingCbor,
+                                                               sizeof(trailingCbor)));
+    LE_ASSERT(LE_OVERFLOW == avData_ReplyExecResultPayload(argListRef, LE_OK,
+                                                           AVDATA_EXEC_RESULT_STRING,
+                                                           largeResult, sizeof(largeResult)));
+    LE_ASSERT(LE_BAD_PARAMETER == avData_ReplyExecResultPayload(argListRef, LE_OK,
+                                                                AVDATA_EXEC_RESULT_STRING,
+                                                                NULL, 1));
+
+    // The server cannot execute the command again while it is pending
+    stub_SendServerRequest(COAP_POST, SERVER_EXEC_RESOURCE, cborResult, sizeof(cborResult));
+    CheckExecResponse(EXEC_SERVICE_UNAVAILABLE, 0, NULL, 0);
+    ExecResponseCount++;
+
+    // String result of a failed command
+    LE_ASSERT_OK(avData_ReplyExecResultPayload(argListRef, LE_FAULT, AVDATA_EXEC_RESULT_STRING,
+                                               (const uint8_t*)stringResult,
+                                               strlen(stringResult)));
+    CheckExecResponse(COAP_INTERNAL_ERROR, PUSH_CONTENT_TEXT_PLAIN,
+                      (const uint8_t*)stringResult, strlen(stringResult));
+
+    // Result without payload
+    argListRef = SendExecRequest();
+    le_avdata_ReplyExecResult(argListRef, LE_OK);
+    CheckExecResponse(COAP_RESOURCE_CHANGED, 0, NULL, 0);
+
+    LE_INFO("============= Test avdata command execution result passed ==============");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Argument of the test when it restarts itself to check the restored resource index
+ */
+//--------------------------------------------------------------------------------------------------
+#define RESTARTED_ARG   "restarted"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the owner of a resource
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckResourceOwner
+(
+    const char* pathPtr,
+    const char* expectedAppPtr,
+    bool expectedPending
+)
+{
+    char appName[LE_LIMIT_APP_NAME_LEN + 1];
+    bool isPending;
+
+    LE_ASSERT_OK(avData_GetResourceOwner(pathPtr, appName, sizeof(appName), &isPending));
+    LE_ASSERT(0 == strcmp(appName, expectedAppPtr));
+    LE_ASSERT(isPending == expectedPending);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the resource index: define resources of several applications, save the index and restart
+ * the test to check the restored resources
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestResourceIndex
+(
+    void
+)
+{
+    char appName[LE_LIMIT_APP_NAME_LEN + 1];
+    bool isPending;
+
+    LE_INFO("============= Test avdata resource index ==============");
+
+    stub_SetClient((le_msg_SessionRef_t)0x3001, "indexApp");
+    LE_ASSERT_OK(le_avdata_CreateResource("/index/var", LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT_OK(le_avdata_CreateResource("/index/setting", LE_AVDATA_ACCESS_SETTING));
+    LE_ASSERT_OK(le_avdata_CreateResource("/index/cmd", LE_AVDATA_ACCESS_COMMAND));
+    CheckResourceOwner("/indexApp/index/var", "indexApp", false);
+
+    stub_SetClient((le_msg_SessionRef_t)0x3002, "indexGlobalApp");
+    LE_ASSERT_OK(le_avdata_SetNamespace(LE_AVDATA_NAMESPACE_GLOBAL));
+    LE_ASSERT_OK(le_avdata_CreateResource("/indexGlobal/var", LE_AVDATA_ACCESS_VARIABLE));
+
+    // The resources of an application which exited are kept, waiting for it to come back
+    stub_SetClient((le_msg_SessionRef_t)0x3003, "indexGoneApp");
+    LE_ASSERT_OK(le_avdata_CreateResource("/indexGone/var", LE_AVDATA_ACCESS_VARIABLE));
+    stub_CloseClient((le_msg_SessionRef_t)0x3003);
+    CheckResourceOwner("/indexGoneApp/indexGone/var", "indexGoneApp", true);
+
+    // The resources of an uninstalled application are removed from the index
+    stub_SetClient((le_msg_SessionRef_t)0x3004, "indexRemovedApp");
+    LE_ASSERT_OK(le_avdata_CreateResource("/indexRemoved/var", LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT(LE_NOT_FOUND == avData_DeleteAppResources("indexRemovedApp"));
+    stub_CloseClient((le_msg_SessionRef_t)0x3004);
+    LE_ASSERT_OK(avData_DeleteAppResources("indexRemovedApp"));
+    LE_ASSERT(LE_NOT_FOUND == avData_GetResourceOwner("/indexRemovedApp/indexRemoved/var",
+                                                      appName, sizeof(appName), &isPending));
+
+    LE_ASSERT_OK(avData_SaveResourceIndex());
+    stub_SetClient((le_msg_SessionRef_t)0x1001, "test");
+
+    LE_INFO("============= Restart to check the restored resource index ==============");
+
+    execl("/proc/self/exe", "avDataUnitTest", RESTARTED_ARG, (char*)NULL);
+    LE_FATAL("Failed to restart the test: %m");
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Check the command execution once its deadline passed: the server got a timeout, and the late
+ * replies are ignored. Then run the resource index test.
+ */
+//-------------------------------------------------------------------------------------------------
+static void CheckExecDeadline
+(
+    le_timer_Ref_t timerRef
+)
+{
+    static const uint8_t cborResult[] = { 0xA0 };
+
+    CheckExecResponse(EXEC_GATEWAY_TIMEOUT, 0, NULL, 0);
+
+    LE_ASSERT(LE_NOT_FOUND == avData_ReplyExecResultPayload(ExecArgListRef, LE_OK,
+                                                            AVDATA_EXEC_RESULT_CBOR,
+                                                            cborResult, sizeof(cborResult)));
+    le_avdata_ReplyExecResult(ExecArgListRef, LE_OK);
+    CheckExecResponse(EXEC_GATEWAY_TIMEOUT, 0, NULL, 0);
+
+    // The command can be executed again
+    le_avdata_ArgumentListRef_t argListRef = SendExecRequest();
+    LE_ASSERT_OK(avData_SetExecTimeout(SERVER_EXEC_RESOURCE, 0));
+    le_avdata_ReplyExecResult(argListRef, LE_FAULT);
+    CheckExecResponse(COAP_INTERNAL_ERROR, 0, NULL, 0);
+
+    le_timer_Delete(timerRef);
+    LE_INFO("============= Test avdata command execution deadline passed ==============");
+
+    //Test - resource index, the test restarts itself and does not return
+    TestResourceIndex();
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Test the deadline of a command execution, checked from the event loop
+ */
+//-------------------------------------------------------------------------------------------------
+static void TestExecDeadline
+(
+    void
+)
+{
+    LE_INFO("============= Test avdata command execution deadline ==============");
+
+    LE_ASSERT(LE_NOT_FOUND == avData_SetExecTimeout("/test/exec/unknown", EXEC_TIMEOUT_MS));
+    LE_ASSERT(LE_BAD_PARAMETER == avData_SetExecTimeout(NULL, EXEC_TIMEOUT_MS));
+    LE_ASSERT_OK(avData_SetExecTimeout(SERVER_EXEC_RESOURCE, EXEC_TIMEOUT_MS));
+
+    SendExecRequest();
+
+    ExecTimerRef = le_timer_Create("Exec deadline check");
+    le_timer_SetMsInterval(ExecTimerRef, EXEC_TIMEOUT_CHECK_MS);
+    le_timer_SetHandler(ExecTimerRef, CheckExecDeadline);
+    le_timer_Start(ExecTimerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the resources restored from the resource index, after the restart of the test
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestRestoredResourceIndex
+(
+    void
+)
+{
+    char appName[LE_LIMIT_APP_NAME_LEN + 1];
+    bool isPending;
+
+    LE_INFO("============= Test avdata restored resource index ==============");
+
+    CheckResourceOwner("/indexApp/index/var", "indexApp", true);
+    CheckResourceOwner("/indexApp/index/setting", "indexApp", true);
+    CheckResourceOwner("/indexApp/index/cmd", "indexApp", true);
+    CheckResourceOwner("/indexGlobal/var", "indexGlobalApp", true);
+
+    // The tree of an application whose client closed before the restart is restored
+    CheckResourceOwner("/indexGoneApp/indexGone/var", "indexGoneApp", true);
+    LE_ASSERT(LE_NOT_FOUND == avData_GetResourceOwner("/indexRemovedApp/indexRemoved/var",
+                                                      appName, sizeof(appName), &isPending));
+
+    // Another application cannot claim a restored resource
+    stub_SetClient((le_msg_SessionRef_t)0x4001, "intruderApp");
+    LE_ASSERT_OK(le_avdata_SetNamespace(LE_AVDATA_NAMESPACE_GLOBAL));
+    LE_ASSERT(LE_DUPLICATE == le_avdata_CreateResource("/indexGlobal/var",
+                                                       LE_AVDATA_ACCESS_VARIABLE));
+    CheckResourceOwner("/indexGlobal/var", "indexGlobalApp", true);
+
+    // The owning application claims its resources by defining them again or by registering a handler
+    stub_SetClient((le_msg_SessionRef_t)0x4002, "indexApp");
+    LE_ASSERT_OK(le_avdata_CreateResource("/index/var", LE_AVDATA_ACCESS_VARIABLE));
+    CheckResourceOwner("/indexApp/index/var", "indexApp", false);
+    LE_ASSERT(LE_DUPLICATE == le_avdata_CreateResource("/index/var", LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT_OK(le_avdata_SetInt("/index/var", 42));
+
+    LE_ASSERT(NULL != le_avdata_AddResourceEventHandler("/index/cmd", AccessTest2ExecuteHandler,
+                                                        NULL));
+    CheckResourceOwner("/indexApp/index/cmd", "indexApp", false);
+
+    stub_SetClient((le_msg_SessionRef_t)0x4003, "indexGlobalApp");
+    LE_ASSERT_OK(le_avdata_SetNamespace(LE_AVDATA_NAMESPACE_GLOBAL));
+    LE_ASSERT_OK(le_avdata_CreateResource("/indexGlobal/var", LE_AVDATA_ACCESS_VARIABLE));
+    CheckResourceOwner("/indexGlobal/var", "indexGlobalApp", false);
+
+    // The claimed resources wait again for their application when it exits
+    stub_CloseClient((le_msg_SessionRef_t)0x4002);
+    CheckResourceOwner("/indexApp/index/var", "indexApp", true);
+    CheckResourceOwner("/indexApp/index/cmd", "indexApp", true);
+    CheckResourceOwner("/indexApp/index/setting", "indexApp", true);
+
+    // The application claims them again when it restarts
+    stub_SetClient((le_msg_SessionRef_t)0x4004, "indexApp");
+    LE_ASSERT_OK(le_avdata_CreateResource("/index/var", LE_AVDATA_ACCESS_VARIABLE));
+    CheckResourceOwner("/indexApp/index/var", "indexApp", false);
+    stub_CloseClient((le_msg_SessionRef_t)0x4004);
+
+    stub_SetClient((le_msg_SessionRef_t)0x1001, "test");
+    LE_INFO("============= Test avdata restored resource index passed ==============");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * main of the test
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start avDataUnitTest =====================");
+
+    // Test - resources restored from the resource index, once the test restarted itself
+    if ((le_arg_NumArgs() >= 1) && (0 == strcmp(le_arg_GetArg(0), RESTARTED_ARG)))
+    {
+        TestRestoredResourceIndex();
+        LE_INFO("=============== avDataTest successful ===================");
+        exit(EXIT_SUCCESS);
+    }
+
+    // Test - le_avdata_PushStream() API
+    TestPushStream();
+
+    // Test - using dot as delimiter
+    // Check if uncreated resources return LE_NOT_FOUND
+    TestDotDelimitedPath();
+
+    // Test - using slash as delimiter
+    // Check if uncreated resources return LE_NOT_FOUND
+    TestSlashDelimitedPath();
+
+    // Test - check if an error occurs in case of BAD paths
+    TestBadPath();
+
+    // Test - airvantage server APIs
+    TestAirVantageServerAPIs();
+
+    //Test namespace
+    NamespaceTest();
+
+    // Test - composite read from the server
+    TestCompositeRead();
+
+    //Test - time series
+    TestTimeseries();
+
+    //Test - time series pushed in SenML
+    TestTimeseriesSenml();
+
+    //Test - time series aggregation windows
+    TestTimeseriesAggregation();
+
+    //Test - time series filter
+    TestTimeseriesFilter();
+
+    //Test - time series local read-back
+    TestTimeseriesReadBack();
+
+    //Test - per-application quotas
+    TestQuota();
+
+    //Test - command execution results
+    TestExecResult();
 
-    LE_INFO("=============== avDataTest successful ===================");
+    //Test - local change streams, checked from the event loop before the command deadline passes
+    TestChangeStream();
 
-    exit(EXIT_SUCCESS);
+    //Test - command execution deadline, followed by the resource index test once the deadline
+    //passed. The test then restarts itself to check the restored resource index.
+    TestExecDeadline();
 }
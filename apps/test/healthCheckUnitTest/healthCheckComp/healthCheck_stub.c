@@ -0,0 +1,237 @@
+/**
+ * This module implements some stubs for healthCheck unit tests.
+ *
+ * The config tree holds a short probation. The update control calls are appended to a log checked
+ * by the test. The state of a single application is stubbed.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configured probation period and poll interval, in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_PROBATION_PERIOD   2
+#define STUB_POLL_INTERVAL      1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Log of the calls
+ */
+//--------------------------------------------------------------------------------------------------
+static char Log[256] = "";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed system state
+ */
+//--------------------------------------------------------------------------------------------------
+static le_updateCtrl_SystemState_t SystemState = LE_UPDATECTRL_SYSTEMSTATE_GOOD;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed application and its state
+ */
+//--------------------------------------------------------------------------------------------------
+static char AppName[LE_LIMIT_APP_NAME_LEN + 1] = "";
+static le_appInfo_State_t AppState = LE_APPINFO_STATE_STOPPED;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append an entry to the log
+ */
+//--------------------------------------------------------------------------------------------------
+static void Append
+(
+    const char* entryPtr
+)
+{
+    if ('\0' != Log[0])
+    {
+        le_utf8_Append(Log, ",", sizeof(Log), NULL);
+    }
+    LE_ASSERT(LE_OK == le_utf8_Append(Log, entryPtr, sizeof(Log), NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the log and clear it
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_CheckLog
+(
+    const char* expectedPtr
+)
+{
+    LE_INFO("Log: %s", Log);
+    LE_ASSERT(0 == strcmp(Log, expectedPtr));
+    Log[0] = '\0';
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the state of the current system
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetSystemState
+(
+    le_updateCtrl_SystemState_t state
+)
+{
+    SystemState = state;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the state of an application
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetAppState
+(
+    const char* appNamePtr,
+    le_appInfo_State_t state
+)
+{
+    le_utf8_Copy(AppName, appNamePtr, sizeof(AppName), NULL);
+    AppState = state;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Config Tree service stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_CreateReadTxn() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn
+(
+    const char* basePath
+)
+{
+    return (le_cfg_IteratorRef_t)1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetInt() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+int32_t le_cfg_GetInt
+(
+    le_cfg_IteratorRef_t iteratorRef,
+    const char* path,
+    int32_t defaultValue
+)
+{
+    if (0 == strcmp(path, "probationPeriod"))
+    {
+        return STUB_PROBATION_PERIOD;
+    }
+
+    if (0 == strcmp(path, "pollInterval"))
+    {
+        return STUB_POLL_INTERVAL;
+    }
+
+    return defaultValue;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_CancelTxn() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_CancelTxn
+(
+    le_cfg_IteratorRef_t iteratorRef
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Application information stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_appInfo_GetState() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_appInfo_State_t le_appInfo_GetState
+(
+    const char* appNamePtr
+)
+{
+    if (0 == strcmp(appNamePtr, AppName))
+    {
+        return AppState;
+    }
+
+    return LE_APPINFO_STATE_STOPPED;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Update control stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_updateCtrl_GetSystemState() stub
+ */
+//--------------------------------------------------------------------------------------------------
+le_updateCtrl_SystemState_t le_updateCtrl_GetSystemState
+(
+    void
+)
+{
+    return SystemState;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_updateCtrl_LockProbation() stub
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_updateCtrl_LockProbation
+(
+    void
+)
+{
+    Append("lock");
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_updateCtrl_UnlockProbation() stub
+ */
+//--------------------------------------------------------------------------------------------------
+void le_updateCtrl_UnlockProbation
+(
+    void
+)
+{
+    Append("unlock");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_updateCtrl_FailProbation() stub: the framework would restart on the last good system
+ */
+//--------------------------------------------------------------------------------------------------
+void le_updateCtrl_FailProbation
+(
+    void
+)
+{
+    Append("failProbation");
+    SystemState = LE_UPDATECTRL_SYSTEMSTATE_GOOD;
+}
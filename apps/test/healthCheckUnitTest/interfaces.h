@@ -0,0 +1,15 @@
+/**
+ * This module implements some stubs for healthCheck unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _INTERFACES_H
+#define _INTERFACES_H
+
+#include "le_cfg_interface.h"
+#include "le_appInfo_interface.h"
+#include "le_updateCtrl_interface.h"
+
+#endif /* interfaces.h */
@@ -0,0 +1,333 @@
+/**
+ * This module implements the unit tests for the post-install health check.
+ *
+ * The tests run one after the other from the event loop, as the probation is timed.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "healthCheck.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Installed application
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_APP            "appA"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub functions
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_CheckLog(const char* expectedPtr);
+void stub_SetSystemState(le_updateCtrl_SystemState_t state);
+void stub_SetAppState(const char* appNamePtr, le_appInfo_State_t state);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test case: start function and expected result
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char* namePtr;            ///< Test name
+    void (*startFunc)(void);        ///< Function starting the check
+    le_result_t result;             ///< Expected result
+    bool isRollingBack;             ///< Expected rollback
+    const char* logPtr;             ///< Expected update control calls
+}
+TestCase_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Verdict of the stub probe, and number of the evaluation stopping the application (0 if none)
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ProbeResult = LE_OK;
+static int ProbeCalls = 0;
+static int AppStopCall = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current test and whether its result is reported
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t TestIndex = 0;
+static bool IsResultReported = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub probe, standing for the checks of an application
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StubProbe
+(
+    healthCheck_Update_t update,
+    void* contextPtr
+)
+{
+    ProbeCalls++;
+    if (ProbeCalls == AppStopCall)
+    {
+        LE_INFO("%s crashes", TEST_APP);
+        stub_SetAppState(TEST_APP, LE_APPINFO_STATE_STOPPED);
+    }
+
+    return ProbeResult;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prepare a test: system state, application state and probe verdict
+ */
+//--------------------------------------------------------------------------------------------------
+static void Prepare
+(
+    le_updateCtrl_SystemState_t systemState,
+    le_appInfo_State_t appState,
+    le_result_t probeResult,
+    int appStopCall
+)
+{
+    stub_SetSystemState(systemState);
+    stub_SetAppState(TEST_APP, appState);
+    ProbeResult = probeResult;
+    ProbeCalls = 0;
+    AppStopCall = appStopCall;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResultHandler
+(
+    le_result_t result,
+    bool isRollingBack,
+    void* contextPtr
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the check of an application install
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartAppCheck
+(
+    void
+)
+{
+    const char* appNames[] = { TEST_APP };
+
+    LE_ASSERT_OK(healthCheck_Start(HEALTH_CHECK_APPLICATION, appNames, 1, ResultHandler, NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Healthy application and registration: the check passes at the end of the probation
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestPass
+(
+    void
+)
+{
+    Prepare(LE_UPDATECTRL_SYSTEMSTATE_PROBATION, LE_APPINFO_STATE_RUNNING, LE_OK, 0);
+    StartAppCheck();
+    healthCheck_ReportRegistration();
+
+    LE_ASSERT(healthCheck_IsRunning());
+    LE_ASSERT(!IsResultReported);
+    LE_ASSERT(LE_BUSY == healthCheck_Start(HEALTH_CHECK_FIRMWARE, NULL, 0, ResultHandler, NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Failing application probe: the check fails immediately and the system is rolled back
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestProbeFailure
+(
+    void
+)
+{
+    Prepare(LE_UPDATECTRL_SYSTEMSTATE_PROBATION, LE_APPINFO_STATE_RUNNING, LE_FAULT, 0);
+    StartAppCheck();
+
+    LE_ASSERT(IsResultReported);
+    LE_ASSERT(!healthCheck_IsRunning());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Application stopping during the probation: the liveness probe fails
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestAppCrash
+(
+    void
+)
+{
+    Prepare(LE_UPDATECTRL_SYSTEMSTATE_PROBATION, LE_APPINFO_STATE_RUNNING, LE_OK, 2);
+    StartAppCheck();
+    healthCheck_ReportRegistration();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Probe not answering: the check times out, a system out of probation cannot be rolled back
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestProbeTimeout
+(
+    void
+)
+{
+    Prepare(LE_UPDATECTRL_SYSTEMSTATE_GOOD, LE_APPINFO_STATE_STOPPED, LE_BUSY, 0);
+    LE_ASSERT_OK(healthCheck_Start(HEALTH_CHECK_FIRMWARE, NULL, 0, ResultHandler, NULL));
+    healthCheck_ReportRegistration();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * No registration after the install: the check times out and the system is rolled back
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestRegistrationTimeout
+(
+    void
+)
+{
+    Prepare(LE_UPDATECTRL_SYSTEMSTATE_PROBATION, LE_APPINFO_STATE_RUNNING, LE_OK, 0);
+    StartAppCheck();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test cases
+ */
+//--------------------------------------------------------------------------------------------------
+static const TestCase_t TestCases[] =
+{
+    { "Test pass",                  TestPass,                LE_OK,      false, "lock,unlock" },
+    { "Test probe failure",         TestProbeFailure,        LE_FAULT,   true,  "lock,failProbation" },
+    { "Test application crash",     TestAppCrash,            LE_FAULT,   true,  "lock,failProbation" },
+    { "Test probe timeout",         TestProbeTimeout,        LE_TIMEOUT, false, "" },
+    { "Test registration timeout",  TestRegistrationTimeout, LE_TIMEOUT, true,  "lock,failProbation" },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the current test, or end the tests
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunTest
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    if (TestIndex >= NUM_ARRAY_MEMBERS(TestCases))
+    {
+        LE_INFO("=============== healthCheckUnitTest successful ===================");
+        exit(EXIT_SUCCESS);
+    }
+
+    LE_INFO("======== %s ========", TestCases[TestIndex].namePtr);
+    IsResultReported = false;
+    TestCases[TestIndex].startFunc();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the update control calls of the ended test, and run the next one
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckTest
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    stub_CheckLog(TestCases[TestIndex].logPtr);
+    TestIndex++;
+    RunTest(NULL, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResultHandler
+(
+    le_result_t result,
+    bool isRollingBack,
+    void* contextPtr
+)
+{
+    LE_INFO("Health check result: %s, rolling back: %d", LE_RESULT_TXT(result), isRollingBack);
+
+    LE_ASSERT(!IsResultReported);
+    LE_ASSERT(TestCases[TestIndex].result == result);
+    LE_ASSERT(TestCases[TestIndex].isRollingBack == isRollingBack);
+    IsResultReported = true;
+
+    // The rollback or the probation unlock follows the result
+    le_event_QueueFunction(CheckTest, NULL, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the probe registration
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestProbes
+(
+    void
+)
+{
+    healthCheck_ProbeRef_t probeRefs[HEALTH_CHECK_MAX_PROBES];
+    int i;
+
+    LE_ASSERT(NULL == healthCheck_AddProbe(NULL, StubProbe, NULL));
+    LE_ASSERT(NULL == healthCheck_AddProbe("", StubProbe, NULL));
+    LE_ASSERT(NULL == healthCheck_AddProbe("probe", NULL, NULL));
+    LE_ASSERT(NULL == healthCheck_AddProbe("a probe name longer than the limit", StubProbe, NULL));
+
+    for (i = 0; i < HEALTH_CHECK_MAX_PROBES; i++)
+    {
+        probeRefs[i] = healthCheck_AddProbe("probe", StubProbe, NULL);
+        LE_ASSERT(NULL != probeRefs[i]);
+    }
+    LE_ASSERT(NULL == healthCheck_AddProbe("probe", StubProbe, NULL));
+
+    for (i = 0; i < HEALTH_CHECK_MAX_PROBES; i++)
+    {
+        healthCheck_RemoveProbe(probeRefs[i]);
+    }
+
+    LE_ASSERT(NULL != healthCheck_AddProbe("stub", StubProbe, NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the test.
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start healthCheckUnitTest ===================");
+
+    healthCheck_Init();
+    LE_ASSERT(healthCheck_IsEnabled());
+    LE_ASSERT(!healthCheck_IsRunning());
+
+    TestProbes();
+    RunTest(NULL, NULL);
+}
@@ -0,0 +1,656 @@
+/**
+ * @file coap.c
+ *
+ * Minimal CoAP message codec (RFC 7252) used by the LwM2M server simulator.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "coap.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP protocol version
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_VERSION                1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the CoAP header
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_HEADER_BYTES           4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Payload marker
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_PAYLOAD_MARKER         0xFF
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Option delta and length encodings
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_OPTION_EXT_8BITS       13
+#define COAP_OPTION_EXT_16BITS      14
+#define COAP_OPTION_EXT_RESERVED    15
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode an option delta or length nibble and its extended bytes
+ *
+ * @return
+ *  - Nibble value
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t EncodeOptionField
+(
+    uint32_t    value,      ///< [IN] Option delta or length
+    uint8_t*    extPtr,     ///< [OUT] Extended bytes
+    size_t*     extLenPtr   ///< [OUT] Number of extended bytes
+)
+{
+    if (value < COAP_OPTION_EXT_8BITS)
+    {
+        *extLenPtr = 0;
+        return (uint8_t)value;
+    }
+
+    if (value < 269)
+    {
+        extPtr[0] = (uint8_t)(value - 13);
+        *extLenPtr = 1;
+        return COAP_OPTION_EXT_8BITS;
+    }
+
+    value -= 269;
+    extPtr[0] = (uint8_t)(value >> 8);
+    extPtr[1] = (uint8_t)value;
+    *extLenPtr = 2;
+    return COAP_OPTION_EXT_16BITS;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode an option delta or length nibble and its extended bytes
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_FORMAT_ERROR   Invalid encoding
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t DecodeOptionField
+(
+    uint8_t         nibble,     ///< [IN] Nibble value
+    const uint8_t** posPtr,     ///< [INOUT] Current position in the datagram
+    const uint8_t*  endPtr,     ///< [IN] End of the datagram
+    uint32_t*       valuePtr    ///< [OUT] Option delta or length
+)
+{
+    const uint8_t* pos = *posPtr;
+
+    switch (nibble)
+    {
+        case COAP_OPTION_EXT_8BITS:
+            if (pos + 1 > endPtr)
+            {
+                return LE_FORMAT_ERROR;
+            }
+            *valuePtr = pos[0] + 13;
+            pos += 1;
+            break;
+
+        case COAP_OPTION_EXT_16BITS:
+            if (pos + 2 > endPtr)
+            {
+                return LE_FORMAT_ERROR;
+            }
+            *valuePtr = ((pos[0] << 8) | pos[1]) + 269;
+            pos += 2;
+            break;
+
+        case COAP_OPTION_EXT_RESERVED:
+            return LE_FORMAT_ERROR;
+
+        default:
+            *valuePtr = nibble;
+            break;
+    }
+
+    *posPtr = pos;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+void coap_Init
+(
+    coap_Message_t* msgPtr,     ///< [OUT] Message
+    coap_Type_t     type,       ///< [IN] Message type
+    uint8_t         code,       ///< [IN] Method or response code
+    uint16_t        mid         ///< [IN] Message Id
+)
+{
+    memset(msgPtr, 0, sizeof(coap_Message_t));
+    msgPtr->type = type;
+    msgPtr->code = code;
+    msgPtr->mid = mid;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the token of a CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+void coap_SetToken
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    const uint8_t*  tokenPtr,   ///< [IN] Token
+    uint8_t         tokenLen    ///< [IN] Token length
+)
+{
+    if (tokenLen > COAP_MAX_TOKEN_BYTES)
+    {
+        tokenLen = COAP_MAX_TOKEN_BYTES;
+    }
+
+    memcpy(msgPtr->token, tokenPtr, tokenLen);
+    msgPtr->tokenLen = tokenLen;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an option to a CoAP message. The option value is copied in the message.
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   Too many options or option values too large
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_AddOption
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    uint16_t        number,     ///< [IN] Option number
+    const uint8_t*  valuePtr,   ///< [IN] Option value
+    size_t          length      ///< [IN] Option value length
+)
+{
+    size_t index;
+
+    if (   (msgPtr->optionCount >= COAP_MAX_OPTIONS)
+        || (msgPtr->optionDataLen + length > COAP_MAX_OPTIONS_BYTES))
+    {
+        return LE_OVERFLOW;
+    }
+
+    // Keep the options sorted by number, the options with the same number keep their order
+    index = msgPtr->optionCount;
+    while ((index > 0) && (msgPtr->options[index - 1].number > number))
+    {
+        msgPtr->options[index] = msgPtr->options[index - 1];
+        index--;
+    }
+
+    memcpy(&msgPtr->optionData[msgPtr->optionDataLen], valuePtr, length);
+    msgPtr->options[index].number = number;
+    msgPtr->options[index].length = (uint16_t)length;
+    msgPtr->options[index].valuePtr = &msgPtr->optionData[msgPtr->optionDataLen];
+    msgPtr->optionDataLen += length;
+    msgPtr->optionCount++;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an unsigned integer option to a CoAP message, using the shortest encoding
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   Too many options or option values too large
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_AddUintOption
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    uint16_t        number,     ///< [IN] Option number
+    uint32_t        value       ///< [IN] Option value
+)
+{
+    uint8_t buf[sizeof(uint32_t)];
+    size_t len = 0;
+    int shift;
+
+    for (shift = 24; shift >= 0; shift -= 8)
+    {
+        if ((len) || ((value >> shift) & 0xFF))
+        {
+            buf[len++] = (uint8_t)(value >> shift);
+        }
+    }
+
+    return coap_AddOption(msgPtr, number, buf, len);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a path, e.g. "/3/0/1" or "rd/1", as a list of path segment options
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   Too many options or option values too large
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_AddPath
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    uint16_t        number,     ///< [IN] COAP_OPTION_URI_PATH or COAP_OPTION_LOCATION_PATH
+    const char*     pathPtr     ///< [IN] Path
+)
+{
+    while ('\0' != *pathPtr)
+    {
+        const char* segmentEndPtr;
+
+        if ('/' == *pathPtr)
+        {
+            pathPtr++;
+            continue;
+        }
+
+        segmentEndPtr = strchr(pathPtr, '/');
+        if (!segmentEndPtr)
+        {
+            segmentEndPtr = pathPtr + strlen(pathPtr);
+        }
+
+        if (LE_OK != coap_AddOption(msgPtr, number, (const uint8_t*)pathPtr,
+                                    (size_t)(segmentEndPtr - pathPtr)))
+        {
+            return LE_OVERFLOW;
+        }
+
+        pathPtr = segmentEndPtr;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the payload of a CoAP message. The payload is not copied.
+ */
+//--------------------------------------------------------------------------------------------------
+void coap_SetPayload
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    const uint8_t*  payloadPtr, ///< [IN] Payload
+    size_t          payloadLen  ///< [IN] Payload length
+)
+{
+    msgPtr->payloadPtr = payloadPtr;
+    msgPtr->payloadLen = payloadLen;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize a CoAP message
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   The buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_Serialize
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    uint8_t*                bufPtr,     ///< [OUT] Datagram
+    size_t*                 lenPtr      ///< [INOUT] Datagram buffer size, then datagram length
+)
+{
+    size_t size = *lenPtr;
+    size_t pos = 0;
+    uint16_t previousNumber = 0;
+    size_t i;
+
+    if (size < (size_t)(COAP_HEADER_BYTES + msgPtr->tokenLen))
+    {
+        return LE_OVERFLOW;
+    }
+
+    bufPtr[pos++] = (uint8_t)((COAP_VERSION << 6) | (msgPtr->type << 4) | msgPtr->tokenLen);
+    bufPtr[pos++] = msgPtr->code;
+    bufPtr[pos++] = (uint8_t)(msgPtr->mid >> 8);
+    bufPtr[pos++] = (uint8_t)msgPtr->mid;
+    memcpy(&bufPtr[pos], msgPtr->token, msgPtr->tokenLen);
+    pos += msgPtr->tokenLen;
+
+    for (i = 0; i < msgPtr->optionCount; i++)
+    {
+        const coap_Option_t* optionPtr = &msgPtr->options[i];
+        uint8_t deltaExt[2], lengthExt[2];
+        size_t deltaExtLen, lengthExtLen;
+        uint8_t deltaNibble, lengthNibble;
+
+        deltaNibble = EncodeOptionField(optionPtr->number - previousNumber, deltaExt, &deltaExtLen);
+        lengthNibble = EncodeOptionField(optionPtr->length, lengthExt, &lengthExtLen);
+
+        if (pos + 1 + deltaExtLen + lengthExtLen + optionPtr->length > size)
+        {
+            return LE_OVERFLOW;
+        }
+
+        bufPtr[pos++] = (uint8_t)((deltaNibble << 4) | lengthNibble);
+        memcpy(&bufPtr[pos], deltaExt, deltaExtLen);
+        pos += deltaExtLen;
+        memcpy(&bufPtr[pos], lengthExt, lengthExtLen);
+        pos += lengthExtLen;
+        memcpy(&bufPtr[pos], optionPtr->valuePtr, optionPtr->length);
+        pos += optionPtr->length;
+
+        previousNumber = optionPtr->number;
+    }
+
+    if (msgPtr->payloadLen)
+    {
+        if (pos + 1 + msgPtr->payloadLen > size)
+        {
+            return LE_OVERFLOW;
+        }
+
+        bufPtr[pos++] = COAP_PAYLOAD_MARKER;
+        memcpy(&bufPtr[pos], msgPtr->payloadPtr, msgPtr->payloadLen);
+        pos += msgPtr->payloadLen;
+    }
+
+    *lenPtr = pos;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a CoAP datagram. The options and the payload point in the datagram.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_FORMAT_ERROR   The datagram is not a valid CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_Parse
+(
+    const uint8_t*  bufPtr,     ///< [IN] Datagram
+    size_t          len,        ///< [IN] Datagram length
+    coap_Message_t* msgPtr      ///< [OUT] Message
+)
+{
+    const uint8_t* pos = bufPtr + COAP_HEADER_BYTES;
+    const uint8_t* endPtr = bufPtr + len;
+    uint32_t number = 0;
+
+    if (   (len < COAP_HEADER_BYTES)
+        || (COAP_VERSION != (bufPtr[0] >> 6))
+        || ((bufPtr[0] & 0x0F) > COAP_MAX_TOKEN_BYTES))
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    coap_Init(msgPtr, (coap_Type_t)((bufPtr[0] >> 4) & 0x03), bufPtr[1],
+              (uint16_t)((bufPtr[2] << 8) | bufPtr[3]));
+
+    msgPtr->tokenLen = bufPtr[0] & 0x0F;
+    if (pos + msgPtr->tokenLen > endPtr)
+    {
+        return LE_FORMAT_ERROR;
+    }
+    memcpy(msgPtr->token, pos, msgPtr->tokenLen);
+    pos += msgPtr->tokenLen;
+
+    while (pos < endPtr)
+    {
+        uint32_t delta, length;
+        uint8_t byte = *pos++;
+
+        if (COAP_PAYLOAD_MARKER == byte)
+        {
+            // A payload marker followed by an empty payload is a format error
+            if (pos == endPtr)
+            {
+                return LE_FORMAT_ERROR;
+            }
+            msgPtr->payloadPtr = pos;
+            msgPtr->payloadLen = (size_t)(endPtr - pos);
+            break;
+        }
+
+        if (   (LE_OK != DecodeOptionField(byte >> 4, &pos, endPtr, &delta))
+            || (LE_OK != DecodeOptionField(byte & 0x0F, &pos, endPtr, &length))
+            || (pos + length > endPtr)
+            || (msgPtr->optionCount >= COAP_MAX_OPTIONS))
+        {
+            return LE_FORMAT_ERROR;
+        }
+
+        number += delta;
+        msgPtr->options[msgPtr->optionCount].number = (uint16_t)number;
+        msgPtr->options[msgPtr->optionCount].length = (uint16_t)length;
+        msgPtr->options[msgPtr->optionCount].valuePtr = pos;
+        msgPtr->optionCount++;
+        pos += length;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get an option of a CoAP message
+ *
+ * @return
+ *  - Option pointer, NULL if the message does not have this option
+ */
+//--------------------------------------------------------------------------------------------------
+const coap_Option_t* coap_GetOption
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    uint16_t                number      ///< [IN] Option number
+)
+{
+    size_t i;
+
+    for (i = 0; i < msgPtr->optionCount; i++)
+    {
+        if (number == msgPtr->options[i].number)
+        {
+            return &msgPtr->options[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of an unsigned integer option
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_NOT_FOUND  The message does not have this option
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_GetUintOption
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    uint16_t                number,     ///< [IN] Option number
+    uint32_t*               valuePtr    ///< [OUT] Option value
+)
+{
+    const coap_Option_t* optionPtr = coap_GetOption(msgPtr, number);
+    uint16_t i;
+
+    if (!optionPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    *valuePtr = 0;
+    for (i = 0; (i < optionPtr->length) && (i < sizeof(uint32_t)); i++)
+    {
+        *valuePtr = (*valuePtr << 8) | optionPtr->valuePtr[i];
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the path built from the path segment options, e.g. "/3/0/1"
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   The buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_GetPath
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    uint16_t                number,     ///< [IN] COAP_OPTION_URI_PATH or COAP_OPTION_LOCATION_PATH
+    char*                   bufPtr,     ///< [OUT] Path
+    size_t                  bufSize     ///< [IN] Path buffer size
+)
+{
+    size_t pos = 0;
+    size_t i;
+
+    for (i = 0; i < msgPtr->optionCount; i++)
+    {
+        const coap_Option_t* optionPtr = &msgPtr->options[i];
+
+        if (number != optionPtr->number)
+        {
+            continue;
+        }
+
+        if (pos + 1 + optionPtr->length >= bufSize)
+        {
+            return LE_OVERFLOW;
+        }
+
+        bufPtr[pos++] = '/';
+        memcpy(&bufPtr[pos], optionPtr->valuePtr, optionPtr->length);
+        pos += optionPtr->length;
+    }
+
+    if (0 == pos)
+    {
+        if (bufSize < 2)
+        {
+            return LE_OVERFLOW;
+        }
+        bufPtr[pos++] = '/';
+    }
+
+    bufPtr[pos] = '\0';
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of a query parameter, e.g. "ep" in "ep=device1"
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_NOT_FOUND  The message does not have this query parameter
+ *  - LE_OVERFLOW   The buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_GetQuery
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    const char*             namePtr,    ///< [IN] Parameter name
+    char*                   bufPtr,     ///< [OUT] Parameter value
+    size_t                  bufSize     ///< [IN] Parameter value buffer size
+)
+{
+    size_t nameLen = strlen(namePtr);
+    size_t i;
+
+    for (i = 0; i < msgPtr->optionCount; i++)
+    {
+        const coap_Option_t* optionPtr = &msgPtr->options[i];
+        size_t valueLen;
+
+        if (   (COAP_OPTION_URI_QUERY != optionPtr->number)
+            || (optionPtr->length <= nameLen)
+            || (0 != memcmp(optionPtr->valuePtr, namePtr, nameLen))
+            || ('=' != optionPtr->valuePtr[nameLen]))
+        {
+            continue;
+        }
+
+        valueLen = optionPtr->length - nameLen - 1;
+        if (valueLen >= bufSize)
+        {
+            return LE_OVERFLOW;
+        }
+
+        memcpy(bufPtr, &optionPtr->valuePtr[nameLen + 1], valueLen);
+        bufPtr[valueLen] = '\0';
+        return LE_OK;
+    }
+
+    return LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a CoAP code as text, e.g. "2.05"
+ */
+//--------------------------------------------------------------------------------------------------
+void coap_FormatCode
+(
+    uint8_t code,       ///< [IN] CoAP code
+    char*   bufPtr,     ///< [OUT] Text, at least 5 bytes
+    size_t  bufSize     ///< [IN] Text buffer size
+)
+{
+    snprintf(bufPtr, bufSize, "%u.%02u", code >> 5, code & 0x1F);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a CoAP code from text, e.g. "2.05"
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_FORMAT_ERROR   The text is not a CoAP code
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_ParseCode
+(
+    const char* textPtr,    ///< [IN] Text
+    uint8_t*    codePtr     ///< [OUT] CoAP code
+)
+{
+    unsigned int codeClass, detail;
+    char end;
+
+    if (   (2 != sscanf(textPtr, "%1u.%2u%c", &codeClass, &detail, &end))
+        || (codeClass > 7)
+        || (detail > 31))
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    *codePtr = COAP_CODE(codeClass, detail);
+    return LE_OK;
+}
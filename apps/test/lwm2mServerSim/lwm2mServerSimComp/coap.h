@@ -0,0 +1,348 @@
+/**
+ * @file coap.h
+ *
+ * Minimal CoAP message codec (RFC 7252) used by the LwM2M server simulator.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _COAP_H
+#define _COAP_H
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a CoAP datagram
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_MAX_DATAGRAM_BYTES     1280
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of options in a CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_MAX_OPTIONS            16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of the options values of a built CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_MAX_OPTIONS_BYTES      256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum token length
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_MAX_TOKEN_BYTES        8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build a CoAP code from its class and detail, e.g. COAP_CODE(2, 5) for 2.05
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_CODE(class, detail)    ((uint8_t)(((class) << 5) | (detail)))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP method and response codes
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_EMPTY                  COAP_CODE(0, 0)
+#define COAP_GET                    COAP_CODE(0, 1)
+#define COAP_POST                   COAP_CODE(0, 2)
+#define COAP_PUT                    COAP_CODE(0, 3)
+#define COAP_DELETE                 COAP_CODE(0, 4)
+#define COAP_201_CREATED            COAP_CODE(2, 1)
+#define COAP_202_DELETED            COAP_CODE(2, 2)
+#define COAP_204_CHANGED            COAP_CODE(2, 4)
+#define COAP_205_CONTENT            COAP_CODE(2, 5)
+#define COAP_400_BAD_REQUEST        COAP_CODE(4, 0)
+#define COAP_404_NOT_FOUND          COAP_CODE(4, 4)
+#define COAP_405_NOT_ALLOWED        COAP_CODE(4, 5)
+#define COAP_500_INTERNAL_ERROR     COAP_CODE(5, 0)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP option numbers
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_OPTION_OBSERVE         6
+#define COAP_OPTION_LOCATION_PATH   8
+#define COAP_OPTION_URI_PATH        11
+#define COAP_OPTION_CONTENT_FORMAT  12
+#define COAP_OPTION_URI_QUERY       15
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP content formats
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_FORMAT_TEXT            0
+#define COAP_FORMAT_LINK            40
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP message types
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    COAP_TYPE_CON = 0,      ///< Confirmable
+    COAP_TYPE_NON = 1,      ///< Non-confirmable
+    COAP_TYPE_ACK = 2,      ///< Acknowledgement
+    COAP_TYPE_RST = 3       ///< Reset
+}
+coap_Type_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP option
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint16_t        number;     ///< Option number
+    uint16_t        length;     ///< Option value length
+    const uint8_t*  valuePtr;   ///< Option value, in the parsed datagram or in the message buffer
+}
+coap_Option_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    coap_Type_t     type;                               ///< Message type
+    uint8_t         code;                               ///< Method or response code
+    uint16_t        mid;                                ///< Message Id
+    uint8_t         tokenLen;                           ///< Token length
+    uint8_t         token[COAP_MAX_TOKEN_BYTES];        ///< Token
+    size_t          optionCount;                        ///< Number of options
+    coap_Option_t   options[COAP_MAX_OPTIONS];          ///< Options, sorted by number
+    uint8_t         optionData[COAP_MAX_OPTIONS_BYTES]; ///< Values of the added options
+    size_t          optionDataLen;                      ///< Used length of optionData
+    const uint8_t*  payloadPtr;                         ///< Payload
+    size_t          payloadLen;                         ///< Payload length
+}
+coap_Message_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+void coap_Init
+(
+    coap_Message_t* msgPtr,     ///< [OUT] Message
+    coap_Type_t     type,       ///< [IN] Message type
+    uint8_t         code,       ///< [IN] Method or response code
+    uint16_t        mid         ///< [IN] Message Id
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the token of a CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+void coap_SetToken
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    const uint8_t*  tokenPtr,   ///< [IN] Token
+    uint8_t         tokenLen    ///< [IN] Token length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an option to a CoAP message. The option value is copied in the message.
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   Too many options or option values too large
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_AddOption
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    uint16_t        number,     ///< [IN] Option number
+    const uint8_t*  valuePtr,   ///< [IN] Option value
+    size_t          length      ///< [IN] Option value length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an unsigned integer option to a CoAP message, using the shortest encoding
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   Too many options or option values too large
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_AddUintOption
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    uint16_t        number,     ///< [IN] Option number
+    uint32_t        value       ///< [IN] Option value
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a path, e.g. "/3/0/1" or "rd/1", as a list of path segment options
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   Too many options or option values too large
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_AddPath
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    uint16_t        number,     ///< [IN] COAP_OPTION_URI_PATH or COAP_OPTION_LOCATION_PATH
+    const char*     pathPtr     ///< [IN] Path
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the payload of a CoAP message. The payload is not copied.
+ */
+//--------------------------------------------------------------------------------------------------
+void coap_SetPayload
+(
+    coap_Message_t* msgPtr,     ///< [INOUT] Message
+    const uint8_t*  payloadPtr, ///< [IN] Payload
+    size_t          payloadLen  ///< [IN] Payload length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize a CoAP message
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   The buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_Serialize
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    uint8_t*                bufPtr,     ///< [OUT] Datagram
+    size_t*                 lenPtr      ///< [INOUT] Datagram buffer size, then datagram length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a CoAP datagram. The options and the payload point in the datagram.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_FORMAT_ERROR   The datagram is not a valid CoAP message
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_Parse
+(
+    const uint8_t*  bufPtr,     ///< [IN] Datagram
+    size_t          len,        ///< [IN] Datagram length
+    coap_Message_t* msgPtr      ///< [OUT] Message
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get an option of a CoAP message
+ *
+ * @return
+ *  - Option pointer, NULL if the message does not have this option
+ */
+//--------------------------------------------------------------------------------------------------
+const coap_Option_t* coap_GetOption
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    uint16_t                number      ///< [IN] Option number
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of an unsigned integer option
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_NOT_FOUND  The message does not have this option
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_GetUintOption
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    uint16_t                number,     ///< [IN] Option number
+    uint32_t*               valuePtr    ///< [OUT] Option value
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the path built from the path segment options, e.g. "/3/0/1"
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   The buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_GetPath
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    uint16_t                number,     ///< [IN] COAP_OPTION_URI_PATH or COAP_OPTION_LOCATION_PATH
+    char*                   bufPtr,     ///< [OUT] Path
+    size_t                  bufSize     ///< [IN] Path buffer size
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of a query parameter, e.g. "ep" in "ep=device1"
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_NOT_FOUND  The message does not have this query parameter
+ *  - LE_OVERFLOW   The buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_GetQuery
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Message
+    const char*             namePtr,    ///< [IN] Parameter name
+    char*                   bufPtr,     ///< [OUT] Parameter value
+    size_t                  bufSize     ///< [IN] Parameter value buffer size
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a CoAP code as text, e.g. "2.05"
+ */
+//--------------------------------------------------------------------------------------------------
+void coap_FormatCode
+(
+    uint8_t code,       ///< [IN] CoAP code
+    char*   bufPtr,     ///< [OUT] Text, at least 5 bytes
+    size_t  bufSize     ///< [IN] Text buffer size
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a CoAP code from text, e.g. "2.05"
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_FORMAT_ERROR   The text is not a CoAP code
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t coap_ParseCode
+(
+    const char* textPtr,    ///< [IN] Text
+    uint8_t*    codePtr     ///< [OUT] CoAP code
+);
+
+#endif /* _COAP_H */
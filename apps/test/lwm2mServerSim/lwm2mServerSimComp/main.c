@@ -0,0 +1,298 @@
+/**
+ * @file main.c
+ *
+ * Host-side LwM2M server simulator, used for end-to-end and load testing of the AirVantage
+ * connector without AirVantage server and without network access.
+ *
+ * The simulator waits for the registration of a number of devices over plain UDP (CoAP, no DTLS)
+ * and runs a scenario script for each of them concurrently (see simScript.c for the commands).
+ * Packages can be served to the devices by a local HTTP fixture.
+ *
+ * Usage: lwm2mServerSim [options] <script>
+ *  -p, --port <port>           CoAP UDP port, 5683 by default, 0 for an ephemeral port
+ *  -n, --devices <count>       Number of devices to wait for, 1 by default
+ *  -s, --simulate <count>      Start simulated devices in the simulator, to test it
+ *  -H, --http-dir <dir>        Serve the packages of a directory with the HTTP fixture
+ *      --http-port <port>      HTTP fixture TCP port, 0 (ephemeral) by default
+ *      --http-host <host>      Host used in the ${HTTP} URL, 127.0.0.1 by default
+ *  -t, --timeout <ms>          Registration timeout, 60000 by default
+ *  -l, --load                  Print the request latency statistics at the end of the run
+ *      --pid <pid>             Print the CPU load and resident memory of a process, e.g. avcDaemon
+ *
+ * The daemon is pointed to the simulator with a coap:// device management server URL, e.g.
+ * coap://192.168.2.1:5683, and its security mode set to NoSec.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "simServer.h"
+#include "simHttp.h"
+#include "simScript.h"
+#include "simDevice.h"
+#include "simMonitor.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default values of the options
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFAULT_COAP_PORT           5683
+#define DEFAULT_HTTP_HOST           "127.0.0.1"
+#define DEFAULT_TIMEOUT_MS          60000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Script run of a device
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    simServer_DeviceRef_t   devRef;         ///< Device reference
+    le_thread_Ref_t         threadRef;      ///< Script thread
+    le_result_t             result;         ///< Script result
+}
+Run_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Script runs
+ */
+//--------------------------------------------------------------------------------------------------
+static Run_t Runs[SIMSERVER_MAX_DEVICES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the usage and exit
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintUsage
+(
+    void
+)
+{
+    fprintf(stderr,
+            "Usage: lwm2mServerSim [options] <script>\n"
+            "  -p, --port <port>         CoAP UDP port (default %d, 0 for an ephemeral port)\n"
+            "  -n, --devices <count>     Number of devices to wait for (default 1)\n"
+            "  -s, --simulate <count>    Start simulated devices in the simulator\n"
+            "  -H, --http-dir <dir>      Serve the packages of a directory over HTTP\n"
+            "      --http-port <port>    HTTP fixture TCP port (default ephemeral)\n"
+            "      --http-host <host>    Host used in the ${HTTP} URL (default %s)\n"
+            "  -t, --timeout <ms>        Registration timeout (default %d)\n"
+            "  -l, --load                Print the request latency statistics\n"
+            "      --pid <pid>           Print the CPU load and resident memory of a process\n",
+            DEFAULT_COAP_PORT, DEFAULT_HTTP_HOST, DEFAULT_TIMEOUT_MS);
+    exit(EXIT_FAILURE);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of an option
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* GetOptionValue
+(
+    size_t* indexPtr    ///< [INOUT] Index of the option, then of its value
+)
+{
+    const char* valuePtr;
+
+    (*indexPtr)++;
+    valuePtr = le_arg_GetArg(*indexPtr);
+    if (!valuePtr)
+    {
+        PrintUsage();
+    }
+
+    return valuePtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Script thread of a device
+ */
+//--------------------------------------------------------------------------------------------------
+static void* ScriptThread
+(
+    void* contextPtr
+)
+{
+    Run_t* runPtr = contextPtr;
+
+    runPtr->result = simScript_Run(runPtr->devRef);
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the simulator.
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    const char* scriptPtr = NULL;
+    const char* httpDirPtr = NULL;
+    const char* httpHostPtr = DEFAULT_HTTP_HOST;
+    unsigned long coapPort = DEFAULT_COAP_PORT;
+    unsigned long httpPort = 0;
+    unsigned long deviceCount = 0;
+    unsigned long simulatedCount = 0;
+    unsigned long timeoutMs = DEFAULT_TIMEOUT_MS;
+    long pid = 0;
+    bool isLoad = false;
+    unsigned int failures = 0;
+    unsigned long i;
+    size_t index;
+
+    for (index = 0; index < le_arg_NumArgs(); index++)
+    {
+        const char* argPtr = le_arg_GetArg(index);
+
+        if ((0 == strcmp(argPtr, "-p")) || (0 == strcmp(argPtr, "--port")))
+        {
+            coapPort = strtoul(GetOptionValue(&index), NULL, 10);
+        }
+        else if ((0 == strcmp(argPtr, "-n")) || (0 == strcmp(argPtr, "--devices")))
+        {
+            deviceCount = strtoul(GetOptionValue(&index), NULL, 10);
+        }
+        else if ((0 == strcmp(argPtr, "-s")) || (0 == strcmp(argPtr, "--simulate")))
+        {
+            simulatedCount = strtoul(GetOptionValue(&index), NULL, 10);
+        }
+        else if ((0 == strcmp(argPtr, "-H")) || (0 == strcmp(argPtr, "--http-dir")))
+        {
+            httpDirPtr = GetOptionValue(&index);
+        }
+        else if (0 == strcmp(argPtr, "--http-port"))
+        {
+            httpPort = strtoul(GetOptionValue(&index), NULL, 10);
+        }
+        else if (0 == strcmp(argPtr, "--http-host"))
+        {
+            httpHostPtr = GetOptionValue(&index);
+        }
+        else if ((0 == strcmp(argPtr, "-t")) || (0 == strcmp(argPtr, "--timeout")))
+        {
+            timeoutMs = strtoul(GetOptionValue(&index), NULL, 10);
+        }
+        else if ((0 == strcmp(argPtr, "-l")) || (0 == strcmp(argPtr, "--load")))
+        {
+            isLoad = true;
+        }
+        else if (0 == strcmp(argPtr, "--pid"))
+        {
+            pid = strtol(GetOptionValue(&index), NULL, 10);
+        }
+        else if (('-' != argPtr[0]) && (!scriptPtr))
+        {
+            scriptPtr = argPtr;
+        }
+        else
+        {
+            PrintUsage();
+        }
+    }
+
+    // The simulated devices are waited for by default
+    if (0 == deviceCount)
+    {
+        deviceCount = (simulatedCount) ? simulatedCount : 1;
+    }
+
+    if (   (!scriptPtr)
+        || (coapPort > UINT16_MAX)
+        || (httpPort > UINT16_MAX)
+        || (deviceCount > SIMSERVER_MAX_DEVICES)
+        || (simulatedCount > SIMSERVER_MAX_DEVICES))
+    {
+        PrintUsage();
+    }
+
+    if (LE_OK != simScript_Load(scriptPtr))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (LE_OK != simServer_Start((uint16_t)coapPort))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (httpDirPtr)
+    {
+        char url[128];
+
+        if (LE_OK != simHttp_Start(httpDirPtr, (uint16_t)httpPort))
+        {
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(url, sizeof(url), "http://%s:%"PRIu16, httpHostPtr, simHttp_GetPort());
+        simScript_SetHttpUrl(url);
+    }
+
+    if ((simulatedCount) && (LE_OK != simDevice_Start(simulatedCount, simServer_GetPort())))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if ((pid > 0) && (LE_OK != simMonitor_Start((pid_t)pid)))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    // Run the script for each device as soon as it registers
+    for (i = 0; i < deviceCount; i++)
+    {
+        char name[32];
+
+        Runs[i].devRef = simServer_WaitRegistration((uint32_t)timeoutMs);
+        if (!Runs[i].devRef)
+        {
+            LE_ERROR("Only %lu of %lu devices registered", i, deviceCount);
+            failures += (unsigned int)(deviceCount - i);
+            deviceCount = i;
+            break;
+        }
+
+        snprintf(name, sizeof(name), "SimScript%lu", i);
+        Runs[i].threadRef = le_thread_Create(name, ScriptThread, &Runs[i]);
+        le_thread_SetJoinable(Runs[i].threadRef);
+        le_thread_Start(Runs[i].threadRef);
+    }
+
+    for (i = 0; i < deviceCount; i++)
+    {
+        le_thread_Join(Runs[i].threadRef, NULL);
+        if (LE_OK != Runs[i].result)
+        {
+            failures++;
+        }
+    }
+
+    if (isLoad)
+    {
+        simScript_PrintStats(stdout);
+    }
+    simMonitor_Stop(stdout);
+
+    if (simulatedCount)
+    {
+        simDevice_Stop();
+    }
+    simServer_Stop();
+
+    if (failures)
+    {
+        LE_ERROR("Script failed for %u devices", failures);
+        exit(EXIT_FAILURE);
+    }
+
+    LE_INFO("Script succeeded for %lu devices", deviceCount);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,770 @@
+/**
+ * @file simDevice.c
+ *
+ * Simulated LwM2M devices, used to test the simulator itself and to load it without target.
+ *
+ * Each device runs in its own thread with its own UDP socket. It registers, updates its
+ * registration every half lifetime, and answers the read, write, execute and observe requests on
+ * a few resources of the LwM2M Server, Device and Firmware Update objects. Writing an HTTP URI in
+ * the firmware package URI downloads it, and executing the firmware update completes it.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include "coap.h"
+#include "simServer.h"
+#include "simDevice.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registration lifetime of the simulated devices, in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define LIFETIME_S                  4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registration retransmission period and maximum number of attempts
+ */
+//--------------------------------------------------------------------------------------------------
+#define REGISTER_RETRY_MS           1000
+#define REGISTER_MAX_ATTEMPTS       30
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Device thread polling period, to check the stop request
+ */
+//--------------------------------------------------------------------------------------------------
+#define POLL_PERIOD_MS              100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resource and observation limits
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_RESOURCES               12
+#define MAX_OBSERVATIONS            4
+#define VALUE_BYTES                 256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Firmware update resources and states
+ */
+//--------------------------------------------------------------------------------------------------
+#define FW_PACKAGE_URI_PATH         "/5/0/1"
+#define FW_UPDATE_PATH              "/5/0/2"
+#define FW_STATE_PATH               "/5/0/3"
+#define FW_RESULT_PATH              "/5/0/5"
+#define FW_STATE_IDLE               "0"
+#define FW_STATE_DOWNLOADING        "1"
+#define FW_STATE_DOWNLOADED         "2"
+#define FW_RESULT_SUCCESS           "1"
+#define FW_RESULT_CONNECTION_LOST   "4"
+#define FW_RESULT_INVALID_URI       "7"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current time resource, computed when it is read
+ */
+//--------------------------------------------------------------------------------------------------
+#define CURRENT_TIME_PATH           "/3/0/13"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resource
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char* pathPtr;                ///< Resource path
+    bool        isExecutable;           ///< Is the resource executable?
+    char        value[VALUE_BYTES];     ///< Text value
+}
+Resource_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Observation
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool        isUsed;                         ///< Is the observation used?
+    char        path[SIMSERVER_PATH_BYTES];     ///< Observed path
+    uint8_t     token[COAP_MAX_TOKEN_BYTES];    ///< Observation token
+    uint8_t     tokenLen;                       ///< Token length
+    uint32_t    sequence;                       ///< Observe sequence number
+}
+Observation_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulated device
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char                endpoint[SIMSERVER_ENDPOINT_BYTES];     ///< Endpoint name
+    int                 socket;                                 ///< UDP socket
+    struct sockaddr_in  server;                                 ///< Server address
+    char                location[SIMSERVER_PATH_BYTES];         ///< Registration location
+    uint16_t            nextMid;                                ///< Next message Id
+    Resource_t          resources[MAX_RESOURCES];               ///< Resources
+    Observation_t       observations[MAX_OBSERVATIONS];         ///< Observations
+    le_thread_Ref_t     threadRef;                              ///< Device thread
+}
+Device_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initial resources of a simulated device
+ */
+//--------------------------------------------------------------------------------------------------
+static const Resource_t InitialResources[] =
+{
+    { "/1/0/1",             false,  STRINGIZE(LIFETIME_S)   },
+    { "/3/0/0",             false,  "Sierra Wireless"       },
+    { "/3/0/1",             false,  "simDevice"             },
+    { "/3/0/3",             false,  "1.0"                   },
+    { "/3/0/4",             true,   ""                      },
+    { CURRENT_TIME_PATH,    false,  ""                      },
+    { FW_PACKAGE_URI_PATH,  false,  ""                      },
+    { FW_UPDATE_PATH,       true,   ""                      },
+    { FW_STATE_PATH,        false,  FW_STATE_IDLE           },
+    { FW_RESULT_PATH,       false,  "0"                     },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulated devices
+ */
+//--------------------------------------------------------------------------------------------------
+static Device_t* DevicesPtr = NULL;
+static unsigned int DeviceCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop request of the device threads
+ */
+//--------------------------------------------------------------------------------------------------
+static volatile bool IsStopping = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize and send a message to the server
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendMessage
+(
+    Device_t*               devPtr,     ///< [IN] Device
+    const coap_Message_t*   msgPtr      ///< [IN] Message
+)
+{
+    uint8_t buf[COAP_MAX_DATAGRAM_BYTES];
+    size_t len = sizeof(buf);
+
+    if (LE_OK != coap_Serialize(msgPtr, buf, &len))
+    {
+        LE_ERROR("%s: message too large", devPtr->endpoint);
+        return;
+    }
+
+    if (0 > sendto(devPtr->socket, buf, len, 0,
+                   (const struct sockaddr*)&devPtr->server, sizeof(devPtr->server)))
+    {
+        LE_ERROR("%s: sendto failed: %m", devPtr->endpoint);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find a resource
+ *
+ * @return
+ *  - Resource pointer, NULL if the resource does not exist
+ */
+//--------------------------------------------------------------------------------------------------
+static Resource_t* FindResource
+(
+    Device_t*   devPtr,     ///< [IN] Device
+    const char* pathPtr     ///< [IN] Resource path
+)
+{
+    int i;
+
+    for (i = 0; (i < MAX_RESOURCES) && (devPtr->resources[i].pathPtr); i++)
+    {
+        if (0 == strcmp(devPtr->resources[i].pathPtr, pathPtr))
+        {
+            return &devPtr->resources[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the text value of a resource
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* GetValue
+(
+    Resource_t* resourcePtr     ///< [IN] Resource
+)
+{
+    if (0 == strcmp(resourcePtr->pathPtr, CURRENT_TIME_PATH))
+    {
+        snprintf(resourcePtr->value, sizeof(resourcePtr->value), "%ld", (long)time(NULL));
+    }
+
+    return resourcePtr->value;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the value of a resource and notify its observers
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetValue
+(
+    Device_t*   devPtr,     ///< [IN] Device
+    const char* pathPtr,    ///< [IN] Resource path
+    const char* valuePtr    ///< [IN] Text value
+)
+{
+    Resource_t* resourcePtr = FindResource(devPtr, pathPtr);
+    int i;
+
+    if (!resourcePtr)
+    {
+        return;
+    }
+
+    LE_ASSERT_OK(le_utf8_Copy(resourcePtr->value, valuePtr, sizeof(resourcePtr->value), NULL));
+
+    for (i = 0; i < MAX_OBSERVATIONS; i++)
+    {
+        Observation_t* obsPtr = &devPtr->observations[i];
+        coap_Message_t msg;
+
+        if ((!obsPtr->isUsed) || (0 != strcmp(obsPtr->path, pathPtr)))
+        {
+            continue;
+        }
+
+        coap_Init(&msg, COAP_TYPE_NON, COAP_205_CONTENT, devPtr->nextMid++);
+        coap_SetToken(&msg, obsPtr->token, obsPtr->tokenLen);
+        coap_AddUintOption(&msg, COAP_OPTION_OBSERVE, ++obsPtr->sequence);
+        coap_AddUintOption(&msg, COAP_OPTION_CONTENT_FORMAT, COAP_FORMAT_TEXT);
+        coap_SetPayload(&msg, (const uint8_t*)resourcePtr->value, strlen(resourcePtr->value));
+        SendMessage(devPtr, &msg);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download a package from an HTTP URI, e.g. "http://127.0.0.1:8080/package.bin"
+ *
+ * @return
+ *  - LE_OK             The package is downloaded
+ *  - LE_BAD_PARAMETER  The URI is not supported
+ *  - LE_FAULT          The download failed
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Download
+(
+    const char* uriPtr      ///< [IN] Package URI
+)
+{
+    char host[64], port[8] = "80", target[VALUE_BYTES] = "/";
+    char request[VALUE_BYTES + 128];
+    char buf[4096];
+    struct addrinfo hints, *resultPtr = NULL;
+    unsigned long long contentLength = 0;
+    unsigned long long received = 0;
+    size_t headerLen = 0;
+    bool isHeaderDone = false;
+    int fd, len;
+
+    if (   (0 != strncmp(uriPtr, "http://", 7))
+        || (1 > sscanf(uriPtr + 7, "%63[^:/]:%7[0-9]%255s", host, port, target)))
+    {
+        return LE_BAD_PARAMETER;
+    }
+    if (!strchr(uriPtr + 7, ':'))
+    {
+        sscanf(uriPtr + 7, "%63[^/]%255s", host, target);
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (0 != getaddrinfo(host, port, &hints, &resultPtr))
+    {
+        return LE_FAULT;
+    }
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if ((fd < 0) || (0 != connect(fd, resultPtr->ai_addr, resultPtr->ai_addrlen)))
+    {
+        freeaddrinfo(resultPtr);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return LE_FAULT;
+    }
+    freeaddrinfo(resultPtr);
+
+    len = snprintf(request, sizeof(request),
+                   "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", target, host);
+    if (len != send(fd, request, (size_t)len, MSG_NOSIGNAL))
+    {
+        close(fd);
+        return LE_FAULT;
+    }
+
+    // Read the response: the header is parsed once complete, then the body bytes are counted
+    for (;;)
+    {
+        ssize_t chunk = recv(fd, buf + headerLen, sizeof(buf) - headerLen - 1, 0);
+        char* bodyPtr;
+
+        if (chunk <= 0)
+        {
+            break;
+        }
+
+        if (isHeaderDone)
+        {
+            received += (unsigned long long)chunk;
+            continue;
+        }
+
+        headerLen += (size_t)chunk;
+        buf[headerLen] = '\0';
+        bodyPtr = strstr(buf, "\r\n\r\n");
+        if (!bodyPtr)
+        {
+            if (headerLen + 1 >= sizeof(buf))
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (   (0 != strncmp(buf, "HTTP/1.1 200", 12))
+            || (!strstr(buf, "Content-Length:"))
+            || (1 != sscanf(strstr(buf, "Content-Length:") + 15, "%llu", &contentLength)))
+        {
+            break;
+        }
+
+        isHeaderDone = true;
+        received = headerLen - (size_t)((bodyPtr + 4) - buf);
+        headerLen = 0;
+    }
+
+    close(fd);
+
+    return ((isHeaderDone) && (received == contentLength)) ? LE_OK : LE_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a request of the server
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandleRequest
+(
+    Device_t*               devPtr,     ///< [IN] Device
+    const coap_Message_t*   reqPtr      ///< [IN] Request
+)
+{
+    char path[SIMSERVER_PATH_BYTES];
+    char value[VALUE_BYTES];
+    Resource_t* resourcePtr = NULL;
+    Observation_t* obsPtr = NULL;
+    coap_Message_t rsp;
+    const char* payloadPtr = NULL;
+    uint32_t observe = 0;
+    bool isObserve = false;
+    bool isDownload = false;
+    int i;
+
+    coap_Init(&rsp, (COAP_TYPE_CON == reqPtr->type) ? COAP_TYPE_ACK : COAP_TYPE_NON,
+              COAP_404_NOT_FOUND, reqPtr->mid);
+    coap_SetToken(&rsp, reqPtr->token, reqPtr->tokenLen);
+
+    if (LE_OK == coap_GetPath(reqPtr, COAP_OPTION_URI_PATH, path, sizeof(path)))
+    {
+        resourcePtr = FindResource(devPtr, path);
+    }
+
+    if (!resourcePtr)
+    {
+        rsp.code = COAP_404_NOT_FOUND;
+    }
+    else if (COAP_GET == reqPtr->code)
+    {
+        if (resourcePtr->isExecutable)
+        {
+            rsp.code = COAP_405_NOT_ALLOWED;
+        }
+        else
+        {
+            isObserve = (LE_OK == coap_GetUintOption(reqPtr, COAP_OPTION_OBSERVE, &observe));
+
+            for (i = 0; i < MAX_OBSERVATIONS; i++)
+            {
+                if (   (devPtr->observations[i].isUsed)
+                    && (0 == strcmp(devPtr->observations[i].path, path)))
+                {
+                    obsPtr = &devPtr->observations[i];
+                }
+            }
+
+            if ((isObserve) && (0 == observe))
+            {
+                for (i = 0; (!obsPtr) && (i < MAX_OBSERVATIONS); i++)
+                {
+                    if (!devPtr->observations[i].isUsed)
+                    {
+                        obsPtr = &devPtr->observations[i];
+                    }
+                }
+
+                if (obsPtr)
+                {
+                    memset(obsPtr, 0, sizeof(*obsPtr));
+                    obsPtr->isUsed = true;
+                    LE_ASSERT_OK(le_utf8_Copy(obsPtr->path, path, sizeof(obsPtr->path), NULL));
+                    memcpy(obsPtr->token, reqPtr->token, reqPtr->tokenLen);
+                    obsPtr->tokenLen = reqPtr->tokenLen;
+                    coap_AddUintOption(&rsp, COAP_OPTION_OBSERVE, obsPtr->sequence);
+                }
+            }
+            else if ((isObserve) && (obsPtr))
+            {
+                obsPtr->isUsed = false;
+            }
+
+            payloadPtr = GetValue(resourcePtr);
+            rsp.code = COAP_205_CONTENT;
+        }
+    }
+    else if (COAP_PUT == reqPtr->code)
+    {
+        if (resourcePtr->isExecutable)
+        {
+            rsp.code = COAP_405_NOT_ALLOWED;
+        }
+        else
+        {
+            size_t len = (reqPtr->payloadLen < sizeof(value)) ?
+                         reqPtr->payloadLen : (sizeof(value) - 1);
+
+            memcpy(value, reqPtr->payloadPtr, len);
+            value[len] = '\0';
+            SetValue(devPtr, path, value);
+            rsp.code = COAP_204_CHANGED;
+
+            isDownload = ((0 == strcmp(path, FW_PACKAGE_URI_PATH)) && ('\0' != value[0]));
+        }
+    }
+    else if (COAP_POST == reqPtr->code)
+    {
+        if (!resourcePtr->isExecutable)
+        {
+            rsp.code = COAP_405_NOT_ALLOWED;
+        }
+        else if (0 == strcmp(path, FW_UPDATE_PATH))
+        {
+            if (0 != strcmp(FindResource(devPtr, FW_STATE_PATH)->value, FW_STATE_DOWNLOADED))
+            {
+                rsp.code = COAP_405_NOT_ALLOWED;
+            }
+            else
+            {
+                SetValue(devPtr, FW_STATE_PATH, FW_STATE_IDLE);
+                SetValue(devPtr, FW_RESULT_PATH, FW_RESULT_SUCCESS);
+                rsp.code = COAP_204_CHANGED;
+            }
+        }
+        else
+        {
+            rsp.code = COAP_204_CHANGED;
+        }
+    }
+    else
+    {
+        rsp.code = COAP_405_NOT_ALLOWED;
+    }
+
+    if (payloadPtr)
+    {
+        coap_AddUintOption(&rsp, COAP_OPTION_CONTENT_FORMAT, COAP_FORMAT_TEXT);
+        coap_SetPayload(&rsp, (const uint8_t*)payloadPtr, strlen(payloadPtr));
+    }
+
+    SendMessage(devPtr, &rsp);
+
+    // The download is done after the response, as the package downloader does
+    if (isDownload)
+    {
+        le_result_t result;
+
+        SetValue(devPtr, FW_STATE_PATH, FW_STATE_DOWNLOADING);
+        result = Download(value);
+        if (LE_OK == result)
+        {
+            SetValue(devPtr, FW_STATE_PATH, FW_STATE_DOWNLOADED);
+        }
+        else
+        {
+            LE_ERROR("%s: download of %s failed", devPtr->endpoint, value);
+            SetValue(devPtr, FW_RESULT_PATH, (LE_BAD_PARAMETER == result) ?
+                                             FW_RESULT_INVALID_URI : FW_RESULT_CONNECTION_LOST);
+            SetValue(devPtr, FW_STATE_PATH, FW_STATE_IDLE);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request of the registration interface
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendRegistration
+(
+    Device_t*   devPtr,     ///< [IN] Device
+    uint8_t     method      ///< [IN] COAP_POST to register or update, COAP_DELETE to deregister
+)
+{
+    static const char links[] = "</1/0>,</3/0>,</5/0>";
+    char query[SIMSERVER_ENDPOINT_BYTES + 8];
+    coap_Message_t msg;
+    uint8_t token = 0;
+
+    coap_Init(&msg, COAP_TYPE_CON, method, devPtr->nextMid++);
+    coap_SetToken(&msg, &token, sizeof(token));
+
+    if ('\0' == devPtr->location[0])
+    {
+        coap_AddPath(&msg, COAP_OPTION_URI_PATH, "/rd");
+        snprintf(query, sizeof(query), "ep=%s", devPtr->endpoint);
+        coap_AddOption(&msg, COAP_OPTION_URI_QUERY, (const uint8_t*)query, strlen(query));
+        snprintf(query, sizeof(query), "lt=%d", LIFETIME_S);
+        coap_AddOption(&msg, COAP_OPTION_URI_QUERY, (const uint8_t*)query, strlen(query));
+        coap_AddOption(&msg, COAP_OPTION_URI_QUERY, (const uint8_t*)"lwm2m=1.0", 9);
+        coap_AddOption(&msg, COAP_OPTION_URI_QUERY, (const uint8_t*)"b=U", 3);
+        coap_AddUintOption(&msg, COAP_OPTION_CONTENT_FORMAT, COAP_FORMAT_LINK);
+        coap_SetPayload(&msg, (const uint8_t*)links, strlen(links));
+    }
+    else
+    {
+        coap_AddPath(&msg, COAP_OPTION_URI_PATH, devPtr->location);
+    }
+
+    SendMessage(devPtr, &msg);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Receive a message
+ *
+ * @return
+ *  - LE_OK         A message is received
+ *  - LE_TIMEOUT    No message received
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReceiveMessage
+(
+    Device_t*       devPtr,     ///< [IN] Device
+    uint8_t*        bufPtr,     ///< [OUT] Datagram
+    coap_Message_t* msgPtr      ///< [OUT] Message
+)
+{
+    struct pollfd pfd = { .fd = devPtr->socket, .events = POLLIN };
+    ssize_t len;
+
+    if (0 >= poll(&pfd, 1, POLL_PERIOD_MS))
+    {
+        return LE_TIMEOUT;
+    }
+
+    len = recv(devPtr->socket, bufPtr, COAP_MAX_DATAGRAM_BYTES, 0);
+    if ((len <= 0) || (LE_OK != coap_Parse(bufPtr, (size_t)len, msgPtr)))
+    {
+        return LE_TIMEOUT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Device thread
+ */
+//--------------------------------------------------------------------------------------------------
+static void* DeviceThread
+(
+    void* contextPtr
+)
+{
+    Device_t* devPtr = contextPtr;
+    uint8_t buf[COAP_MAX_DATAGRAM_BYTES];
+    coap_Message_t msg;
+    uint64_t nextUs = 0;
+    int attempts = 0;
+
+    // Registration
+    while ((!IsStopping) && ('\0' == devPtr->location[0]))
+    {
+        if (simServer_NowUs() >= nextUs)
+        {
+            if (attempts++ >= REGISTER_MAX_ATTEMPTS)
+            {
+                LE_ERROR("%s: registration failed", devPtr->endpoint);
+                return NULL;
+            }
+            SendRegistration(devPtr, COAP_POST);
+            nextUs = simServer_NowUs() + (REGISTER_RETRY_MS * 1000);
+        }
+
+        if (   (LE_OK == ReceiveMessage(devPtr, buf, &msg))
+            && (COAP_201_CREATED == msg.code))
+        {
+            coap_GetPath(&msg, COAP_OPTION_LOCATION_PATH, devPtr->location,
+                         sizeof(devPtr->location));
+        }
+    }
+
+    // Registered: answer the requests and update the registration every half lifetime
+    nextUs = simServer_NowUs() + (LIFETIME_S * 1000000 / 2);
+    while (!IsStopping)
+    {
+        if (simServer_NowUs() >= nextUs)
+        {
+            SendRegistration(devPtr, COAP_POST);
+            nextUs += LIFETIME_S * 1000000 / 2;
+        }
+
+        if (LE_OK != ReceiveMessage(devPtr, buf, &msg))
+        {
+            continue;
+        }
+
+        if ((COAP_EMPTY != msg.code) && (0 == (msg.code >> 5)))
+        {
+            HandleRequest(devPtr, &msg);
+        }
+        else if (COAP_TYPE_RST == msg.type)
+        {
+            // The server is not interested anymore in a notification
+            int i;
+
+            for (i = 0; i < MAX_OBSERVATIONS; i++)
+            {
+                devPtr->observations[i].isUsed = false;
+            }
+        }
+    }
+
+    if ('\0' != devPtr->location[0])
+    {
+        SendRegistration(devPtr, COAP_DELETE);
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start simulated devices registering to a local server
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_OUT_OF_RANGE   Too many devices
+ *  - LE_FAULT          A device socket could not be created
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simDevice_Start
+(
+    unsigned int    count,          ///< [IN] Number of devices
+    uint16_t        serverPort      ///< [IN] UDP port of the server on the loopback interface
+)
+{
+    unsigned int i;
+
+    if ((0 == count) || (count > SIMSERVER_MAX_DEVICES))
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    DevicesPtr = calloc(count, sizeof(Device_t));
+    LE_ASSERT(DevicesPtr);
+    IsStopping = false;
+
+    for (i = 0; i < count; i++)
+    {
+        Device_t* devPtr = &DevicesPtr[i];
+        char name[32];
+
+        snprintf(devPtr->endpoint, sizeof(devPtr->endpoint), "simDevice%u", i);
+        memcpy(devPtr->resources, InitialResources, sizeof(InitialResources));
+        devPtr->nextMid = (uint16_t)(i * 1000);
+
+        devPtr->server.sin_family = AF_INET;
+        devPtr->server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        devPtr->server.sin_port = htons(serverPort);
+
+        devPtr->socket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (devPtr->socket < 0)
+        {
+            LE_ERROR("socket failed: %m");
+            return LE_FAULT;
+        }
+
+        snprintf(name, sizeof(name), "SimDevice%u", i);
+        devPtr->threadRef = le_thread_Create(name, DeviceThread, devPtr);
+        le_thread_SetJoinable(devPtr->threadRef);
+        le_thread_Start(devPtr->threadRef);
+        DeviceCount++;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deregister and stop the simulated devices
+ */
+//--------------------------------------------------------------------------------------------------
+void simDevice_Stop
+(
+    void
+)
+{
+    unsigned int i;
+
+    IsStopping = true;
+
+    for (i = 0; i < DeviceCount; i++)
+    {
+        le_thread_Join(DevicesPtr[i].threadRef, NULL);
+        close(DevicesPtr[i].socket);
+    }
+
+    free(DevicesPtr);
+    DevicesPtr = NULL;
+    DeviceCount = 0;
+}
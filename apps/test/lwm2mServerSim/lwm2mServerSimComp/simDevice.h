@@ -0,0 +1,43 @@
+/**
+ * @file simDevice.h
+ *
+ * Simulated LwM2M devices, used to test the simulator itself and to load it without target.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _SIMDEVICE_H
+#define _SIMDEVICE_H
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start simulated devices registering to a local server
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_OUT_OF_RANGE   Too many devices
+ *  - LE_FAULT          A device socket could not be created
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simDevice_Start
+(
+    unsigned int    count,          ///< [IN] Number of devices
+    uint16_t        serverPort      ///< [IN] UDP port of the server on the loopback interface
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deregister and stop the simulated devices
+ */
+//--------------------------------------------------------------------------------------------------
+void simDevice_Stop
+(
+    void
+);
+
+#endif /* _SIMDEVICE_H */
@@ -0,0 +1,514 @@
+/**
+ * @file simHttp.c
+ *
+ * HTTP fixture of the simulator, serving the FOTA/SOTA packages from a local directory.
+ *
+ * Only the requests needed by the package downloader are supported: HEAD and GET, with an
+ * optional byte range to resume a download. Each connection is closed after its response.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include "simServer.h"
+#include "simHttp.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a request header
+ */
+//--------------------------------------------------------------------------------------------------
+#define REQUEST_MAX_BYTES           4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a request target, including the null-terminator
+ */
+//--------------------------------------------------------------------------------------------------
+#define TARGET_MAX_BYTES            256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of request targets whose completed downloads are counted
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_TARGETS                 512
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the buffer used to send the files
+ */
+//--------------------------------------------------------------------------------------------------
+#define SEND_BUFFER_BYTES           4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pending connections queue length
+ */
+//--------------------------------------------------------------------------------------------------
+#define LISTEN_BACKLOG              32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completed downloads of a request target
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char            target[TARGET_MAX_BYTES];   ///< Request target
+    unsigned int    completed;                  ///< Completed downloads
+}
+Target_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completed downloads per request target
+ */
+//--------------------------------------------------------------------------------------------------
+static Target_t Targets[MAX_TARGETS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Served directory
+ */
+//--------------------------------------------------------------------------------------------------
+static char Directory[PATH_MAX];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Listening socket and its TCP port
+ */
+//--------------------------------------------------------------------------------------------------
+static int ListenSocket = -1;
+static uint16_t Port = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex protecting the completed downloads, and condition variable signaled on each completion
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t HttpMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t HttpCond;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&HttpMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&HttpMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the completed downloads counter of a request target. Should be called with the mutex
+ * locked.
+ *
+ * @return
+ *  - Target pointer, NULL if the table is full
+ */
+//--------------------------------------------------------------------------------------------------
+static Target_t* GetTarget
+(
+    const char* targetPtr   ///< [IN] Request target
+)
+{
+    int i;
+
+    for (i = 0; i < MAX_TARGETS; i++)
+    {
+        if ('\0' == Targets[i].target[0])
+        {
+            LE_ASSERT_OK(le_utf8_Copy(Targets[i].target, targetPtr, TARGET_MAX_BYTES, NULL));
+            return &Targets[i];
+        }
+
+        if (0 == strcmp(Targets[i].target, targetPtr))
+        {
+            return &Targets[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a whole buffer on a connection
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The connection is closed
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SendAll
+(
+    int         fd,         ///< [IN] Connection
+    const void* bufPtr,     ///< [IN] Data
+    size_t      len         ///< [IN] Data length
+)
+{
+    const uint8_t* posPtr = bufPtr;
+
+    while (len)
+    {
+        ssize_t sent = send(fd, posPtr, len, MSG_NOSIGNAL);
+
+        if (sent <= 0)
+        {
+            return LE_FAULT;
+        }
+
+        posPtr += sent;
+        len -= (size_t)sent;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a response without body
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendStatus
+(
+    int         fd,         ///< [IN] Connection
+    const char* statusPtr   ///< [IN] Status line, e.g. "404 Not Found"
+)
+{
+    char header[128];
+    int len;
+
+    len = snprintf(header, sizeof(header),
+                   "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", statusPtr);
+    SendAll(fd, header, (size_t)len);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the request header of a connection
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The connection is closed or the header is too large
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadRequest
+(
+    int     fd,         ///< [IN] Connection
+    char*   bufPtr,     ///< [OUT] Request header, null-terminated
+    size_t  bufSize     ///< [IN] Buffer size
+)
+{
+    size_t len = 0;
+
+    while (len + 1 < bufSize)
+    {
+        ssize_t received = recv(fd, bufPtr + len, bufSize - len - 1, 0);
+
+        if (received <= 0)
+        {
+            return LE_FAULT;
+        }
+
+        len += (size_t)received;
+        bufPtr[len] = '\0';
+
+        if (strstr(bufPtr, "\r\n\r\n"))
+        {
+            return LE_OK;
+        }
+    }
+
+    return LE_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the start offset of the Range header, e.g. "Range: bytes=1024-"
+ *
+ * @return
+ *  - Start offset, 0 if the request does not have any Range header
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetRangeStart
+(
+    const char* requestPtr  ///< [IN] Request header
+)
+{
+    const char* linePtr = requestPtr;
+
+    while (NULL != (linePtr = strstr(linePtr, "\r\n")))
+    {
+        uint64_t start;
+
+        linePtr += 2;
+        if (   (0 == strncasecmp(linePtr, "Range:", 6))
+            && (1 == sscanf(linePtr + 6, " bytes=%"SCNu64"-", &start)))
+        {
+            return start;
+        }
+    }
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a connection
+ */
+//--------------------------------------------------------------------------------------------------
+static void* ConnectionThread
+(
+    void* contextPtr
+)
+{
+    int fd = (int)(intptr_t)contextPtr;
+    char request[REQUEST_MAX_BYTES];
+    char method[8], target[TARGET_MAX_BYTES], path[PATH_MAX];
+    char header[256];
+    uint8_t buf[SEND_BUFFER_BYTES];
+    uint64_t start, remaining;
+    struct stat st;
+    bool isHead;
+    int len;
+    FILE* filePtr = NULL;
+
+    if (   (LE_OK != ReadRequest(fd, request, sizeof(request)))
+        || (2 != sscanf(request, "%7s %255s", method, target)))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    isHead = (0 == strcmp(method, "HEAD"));
+    if ((!isHead) && (0 != strcmp(method, "GET")))
+    {
+        SendStatus(fd, "405 Method Not Allowed");
+        close(fd);
+        return NULL;
+    }
+
+    // The query is ignored to find the file: it only identifies the downloading device
+    len = snprintf(path, sizeof(path), "%s/%.*s", Directory,
+                   (int)strcspn(target + 1, "?"), target + 1);
+    if (   ('/' != target[0])
+        || (strstr(target, ".."))
+        || (len >= (int)sizeof(path))
+        || (0 != stat(path, &st))
+        || (!S_ISREG(st.st_mode))
+        || (NULL == (filePtr = fopen(path, "rb"))))
+    {
+        SendStatus(fd, "404 Not Found");
+        close(fd);
+        return NULL;
+    }
+
+    start = GetRangeStart(request);
+    if (start > (uint64_t)st.st_size)
+    {
+        SendStatus(fd, "416 Range Not Satisfiable");
+        fclose(filePtr);
+        close(fd);
+        return NULL;
+    }
+
+    remaining = (uint64_t)st.st_size - start;
+    if (start)
+    {
+        len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 206 Partial Content\r\nContent-Length: %"PRIu64"\r\n"
+                       "Content-Range: bytes %"PRIu64"-%"PRIu64"/%"PRIu64"\r\n"
+                       "Connection: close\r\n\r\n",
+                       remaining, start, (uint64_t)st.st_size - 1, (uint64_t)st.st_size);
+    }
+    else
+    {
+        len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 200 OK\r\nContent-Length: %"PRIu64"\r\n"
+                       "Accept-Ranges: bytes\r\nConnection: close\r\n\r\n", remaining);
+    }
+
+    if ((LE_OK == SendAll(fd, header, (size_t)len)) && (!isHead))
+    {
+        fseek(filePtr, (long)start, SEEK_SET);
+
+        while (remaining)
+        {
+            size_t chunk = fread(buf, 1, sizeof(buf), filePtr);
+
+            if ((0 == chunk) || (LE_OK != SendAll(fd, buf, chunk)))
+            {
+                break;
+            }
+            remaining -= chunk;
+        }
+
+        if (0 == remaining)
+        {
+            Target_t* targetPtr;
+
+            LOCK();
+            targetPtr = GetTarget(target);
+            if (targetPtr)
+            {
+                targetPtr->completed++;
+            }
+            pthread_cond_broadcast(&HttpCond);
+            UNLOCK();
+
+            LE_INFO("Download of %s completed", target);
+        }
+    }
+
+    fclose(filePtr);
+    close(fd);
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Accept the connections
+ */
+//--------------------------------------------------------------------------------------------------
+static void* AcceptThread
+(
+    void* contextPtr
+)
+{
+    for (;;)
+    {
+        le_thread_Ref_t threadRef;
+        int fd = accept(ListenSocket, NULL, NULL);
+
+        if (fd < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            LE_ERROR("accept failed: %m");
+            break;
+        }
+
+        threadRef = le_thread_Create("SimHttpConn", ConnectionThread, (void*)(intptr_t)fd);
+        le_thread_Start(threadRef);
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start to serve the files of a directory
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The socket could not be created
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simHttp_Start
+(
+    const char* dirPtr,     ///< [IN] Served directory
+    uint16_t    port        ///< [IN] TCP port, 0 for an ephemeral port
+)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    int option = 1;
+
+    if (LE_OK != le_utf8_Copy(Directory, dirPtr, sizeof(Directory), NULL))
+    {
+        LE_ERROR("Directory path too long: %s", dirPtr);
+        return LE_FAULT;
+    }
+
+    simServer_InitCond(&HttpCond);
+
+    ListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (ListenSocket < 0)
+    {
+        LE_ERROR("socket failed: %m");
+        return LE_FAULT;
+    }
+    setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (   (0 != bind(ListenSocket, (struct sockaddr*)&addr, sizeof(addr)))
+        || (0 != listen(ListenSocket, LISTEN_BACKLOG))
+        || (0 != getsockname(ListenSocket, (struct sockaddr*)&addr, &addrLen)))
+    {
+        LE_ERROR("Unable to listen on TCP port %"PRIu16": %m", port);
+        close(ListenSocket);
+        ListenSocket = -1;
+        return LE_FAULT;
+    }
+
+    Port = ntohs(addr.sin_port);
+    le_thread_Start(le_thread_Create("SimHttpAccept", AcceptThread, NULL));
+
+    LE_INFO("HTTP fixture serving %s on TCP port %"PRIu16, Directory, Port);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the TCP port of the HTTP fixture
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t simHttp_GetPort
+(
+    void
+)
+{
+    return Port;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until a request target, e.g. "/package.bin?ep=device1", was served up to the end of the
+ * file a number of times
+ *
+ * @return
+ *  - LE_OK         The downloads are completed
+ *  - LE_TIMEOUT    Timeout
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simHttp_WaitDownloads
+(
+    const char*     targetPtr,  ///< [IN] Request target
+    unsigned int    count,      ///< [IN] Number of completed downloads
+    uint32_t        timeoutMs   ///< [IN] Timeout in milliseconds
+)
+{
+    uint64_t deadlineUs = simServer_NowUs() + ((uint64_t)timeoutMs * 1000);
+    le_result_t result = LE_OK;
+    Target_t* entryPtr;
+
+    LOCK();
+
+    while ((NULL == (entryPtr = GetTarget(targetPtr))) || (entryPtr->completed < count))
+    {
+        if (LE_OK != simServer_WaitCond(&HttpCond, &HttpMutex, deadlineUs))
+        {
+            result = LE_TIMEOUT;
+            break;
+        }
+    }
+
+    UNLOCK();
+
+    return result;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file simHttp.h
+ *
+ * HTTP fixture of the simulator, serving the FOTA/SOTA packages from a local directory.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _SIMHTTP_H
+#define _SIMHTTP_H
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start to serve the files of a directory
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The socket could not be created
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simHttp_Start
+(
+    const char* dirPtr,     ///< [IN] Served directory
+    uint16_t    port        ///< [IN] TCP port, 0 for an ephemeral port
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the TCP port of the HTTP fixture
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t simHttp_GetPort
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until a request target, e.g. "/package.bin?ep=device1", was served up to the end of the
+ * file a number of times
+ *
+ * @return
+ *  - LE_OK         The downloads are completed
+ *  - LE_TIMEOUT    Timeout
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simHttp_WaitDownloads
+(
+    const char*     targetPtr,  ///< [IN] Request target
+    unsigned int    count,      ///< [IN] Number of completed downloads
+    uint32_t        timeoutMs   ///< [IN] Timeout in milliseconds
+);
+
+#endif /* _SIMHTTP_H */
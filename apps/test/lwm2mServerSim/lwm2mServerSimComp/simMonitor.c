@@ -0,0 +1,219 @@
+/**
+ * @file simMonitor.c
+ *
+ * Sampling of the CPU time and resident memory of the tested daemon during a load run.
+ *
+ * The CPU time is read from /proc/<pid>/stat at the start and at the end of the run, the resident
+ * memory is sampled periodically from /proc/<pid>/status to find its peak.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "simServer.h"
+#include "simMonitor.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resident memory sampling period
+ */
+//--------------------------------------------------------------------------------------------------
+#define SAMPLING_PERIOD_MS          100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Process sample
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t    cpuTicks;       ///< User and system CPU time, in clock ticks
+    uint64_t    rssKb;          ///< Resident memory, in kilobytes
+    uint64_t    timeUs;         ///< Sample time
+}
+Sample_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Monitored process
+ */
+//--------------------------------------------------------------------------------------------------
+static pid_t Pid = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * First sample and peak resident memory
+ */
+//--------------------------------------------------------------------------------------------------
+static Sample_t FirstSample;
+static uint64_t PeakRssKb = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sampling thread and its stop request
+ */
+//--------------------------------------------------------------------------------------------------
+static le_thread_Ref_t SamplingThreadRef = NULL;
+static volatile bool IsStopping = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a sample of the monitored process
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_NOT_FOUND  The process does not exist anymore
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadSample
+(
+    Sample_t* samplePtr     ///< [OUT] Sample
+)
+{
+    char path[64];
+    char line[512];
+    unsigned long long utime, stime;
+    const char* fieldsPtr;
+    FILE* filePtr;
+    bool isRssFound = false;
+
+    samplePtr->timeUs = simServer_NowUs();
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)Pid);
+    filePtr = fopen(path, "r");
+    if (!filePtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    // The command name may contain spaces: the fields are parsed after its closing parenthesis.
+    // utime and stime are the 14th and 15th fields, the state is the 3rd one.
+    if (   (NULL == fgets(line, sizeof(line), filePtr))
+        || (NULL == (fieldsPtr = strrchr(line, ')')))
+        || (2 != sscanf(fieldsPtr + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                        &utime, &stime)))
+    {
+        fclose(filePtr);
+        return LE_NOT_FOUND;
+    }
+    fclose(filePtr);
+    samplePtr->cpuTicks = utime + stime;
+
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)Pid);
+    filePtr = fopen(path, "r");
+    if (!filePtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    while ((!isRssFound) && (NULL != fgets(line, sizeof(line), filePtr)))
+    {
+        unsigned long long rssKb;
+
+        if (1 == sscanf(line, "VmRSS: %llu kB", &rssKb))
+        {
+            samplePtr->rssKb = rssKb;
+            isRssFound = true;
+        }
+    }
+    fclose(filePtr);
+
+    return (isRssFound) ? LE_OK : LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sampling thread
+ */
+//--------------------------------------------------------------------------------------------------
+static void* SamplingThread
+(
+    void* contextPtr
+)
+{
+    while (!IsStopping)
+    {
+        Sample_t sample;
+
+        if ((LE_OK == ReadSample(&sample)) && (sample.rssKb > PeakRssKb))
+        {
+            PeakRssKb = sample.rssKb;
+        }
+
+        usleep(SAMPLING_PERIOD_MS * 1000);
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start to sample a process
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_NOT_FOUND  The process does not exist
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simMonitor_Start
+(
+    pid_t pid       ///< [IN] Process Id
+)
+{
+    Pid = pid;
+
+    if (LE_OK != ReadSample(&FirstSample))
+    {
+        LE_ERROR("Unable to read the statistics of process %d", (int)pid);
+        return LE_NOT_FOUND;
+    }
+
+    PeakRssKb = FirstSample.rssKb;
+    IsStopping = false;
+
+    SamplingThreadRef = le_thread_Create("SimMonitor", SamplingThread, NULL);
+    le_thread_SetJoinable(SamplingThreadRef);
+    le_thread_Start(SamplingThreadRef);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the sampling and print the CPU load and the resident memory of the process
+ */
+//--------------------------------------------------------------------------------------------------
+void simMonitor_Stop
+(
+    FILE* filePtr   ///< [IN] Output
+)
+{
+    Sample_t lastSample;
+    double elapsedS, cpuS;
+
+    if (!SamplingThreadRef)
+    {
+        return;
+    }
+
+    IsStopping = true;
+    le_thread_Join(SamplingThreadRef, NULL);
+    SamplingThreadRef = NULL;
+
+    if (LE_OK != ReadSample(&lastSample))
+    {
+        fprintf(filePtr, "process %d: exited during the run\n", (int)Pid);
+        return;
+    }
+
+    elapsedS = (double)(lastSample.timeUs - FirstSample.timeUs) / 1000000.0;
+    cpuS = (double)(lastSample.cpuTicks - FirstSample.cpuTicks) / (double)sysconf(_SC_CLK_TCK);
+
+    fprintf(filePtr, "process %d: cpu %.2f s in %.2f s (%.1f%%), rss start %"PRIu64" kB, "
+            "peak %"PRIu64" kB, end %"PRIu64" kB\n",
+            (int)Pid, cpuS, elapsedS, (elapsedS > 0) ? (100.0 * cpuS / elapsedS) : 0.0,
+            FirstSample.rssKb, PeakRssKb, lastSample.rssKb);
+}
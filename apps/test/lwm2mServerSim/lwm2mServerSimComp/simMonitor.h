@@ -0,0 +1,41 @@
+/**
+ * @file simMonitor.h
+ *
+ * Sampling of the CPU time and resident memory of the tested daemon during a load run.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _SIMMONITOR_H
+#define _SIMMONITOR_H
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start to sample a process
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_NOT_FOUND  The process does not exist
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simMonitor_Start
+(
+    pid_t pid       ///< [IN] Process Id
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the sampling and print the CPU load and the resident memory of the process
+ */
+//--------------------------------------------------------------------------------------------------
+void simMonitor_Stop
+(
+    FILE* filePtr   ///< [IN] Output
+);
+
+#endif /* _SIMMONITOR_H */
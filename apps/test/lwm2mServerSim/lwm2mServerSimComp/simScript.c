@@ -0,0 +1,946 @@
+/**
+ * @file simScript.c
+ *
+ * Scenario scripts of the simulator, run for each registered device.
+ *
+ * A script is a list of commands, one per line. Empty lines and text after '#' are ignored.
+ * ${HTTP}, ${EP} and ${ITER} are replaced by the HTTP fixture base URL, the device endpoint name
+ * and the iteration number of the innermost repeat block.
+ *
+ *  read <path> [<code>]                Read a resource, 2.05 expected by default
+ *  write <path> <value> [<code>]       Write a text value, 2.04 expected by default
+ *  exec <path> [<code>]                Execute a resource, 2.04 expected by default
+ *  observe <path> [<code>]             Observe a path, 2.05 expected by default
+ *  cancel-observe <path>               Cancel the observation of a path
+ *  wait-notify <path> <count> [<ms>]   Wait for a number of notifications of an observation
+ *  expect-payload <text>               Check that the last response or notification contains text
+ *  wait-download <target> [<ms>]       Wait for a complete download of an HTTP fixture target
+ *  wait-update [<ms>]                  Wait for the next registration update
+ *  wait-deregister [<ms>]              Wait for the deregistration
+ *  sleep <ms>                          Pause
+ *  log <text>                          Log a message
+ *  repeat <count> ... end              Repeat a block of commands
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "coap.h"
+#include "simHttp.h"
+#include "simScript.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Script limits
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_LINES                   1024
+#define LINE_BYTES                  256
+#define MAX_ARGS                    8
+#define MAX_LOOP_DEPTH              8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default timeout of the wait commands, in milliseconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFAULT_WAIT_TIMEOUT_MS     60000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of the HTTP fixture base URL, including the null-terminator
+ */
+//--------------------------------------------------------------------------------------------------
+#define URL_BYTES                   128
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request kinds for the latency statistics
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    KIND_READ = 0,
+    KIND_WRITE,
+    KIND_EXEC,
+    KIND_OBSERVE,
+    KIND_MAX
+}
+Kind_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Latency statistics of a request kind
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t*   samplesPtr;     ///< Latencies in microseconds
+    size_t      count;          ///< Number of samples
+    size_t      capacity;       ///< Allocated samples
+    size_t      errors;         ///< Failed requests
+}
+Stats_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Execution context of a script for a device
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    simServer_DeviceRef_t   devRef;             ///< Device reference
+    simServer_Response_t    last;               ///< Last response or notification
+    int                     loopDepth;          ///< Number of nested repeat blocks
+    struct
+    {
+        int             start;                  ///< Line of the repeat command
+        unsigned int    remaining;              ///< Remaining iterations
+        unsigned int    iteration;              ///< Current iteration
+    }
+    loops[MAX_LOOP_DEPTH];                      ///< Nested repeat blocks
+}
+Context_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Command handler
+ */
+//--------------------------------------------------------------------------------------------------
+typedef le_result_t (*CommandHandler_t)
+(
+    Context_t*  ctxPtr,     ///< [IN] Execution context
+    int         argc,       ///< [IN] Number of arguments, including the command name
+    char*       argv[]      ///< [IN] Arguments
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Command
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char*         namePtr;    ///< Command name
+    int                 minArgs;    ///< Minimum number of arguments, excluding the name
+    int                 maxArgs;    ///< Maximum number of arguments, excluding the name
+    CommandHandler_t    handler;    ///< Command handler, NULL for repeat and end
+}
+Command_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Script lines
+ */
+//--------------------------------------------------------------------------------------------------
+static char Lines[MAX_LINES][LINE_BYTES];
+static int LineNumbers[MAX_LINES];
+static const Command_t* LineCommands[MAX_LINES];
+static int LineCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Line of the end command matching each repeat command
+ */
+//--------------------------------------------------------------------------------------------------
+static int BlockEnds[MAX_LINES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * HTTP fixture base URL
+ */
+//--------------------------------------------------------------------------------------------------
+static char HttpUrl[URL_BYTES] = "";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Latency statistics per request kind
+ */
+//--------------------------------------------------------------------------------------------------
+static Stats_t Stats[KIND_MAX];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request kind names
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* KindNames[KIND_MAX] = { "read", "write", "exec", "observe" };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex protecting the statistics
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t StatsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&StatsMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&StatsMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record the result of a request in the statistics
+ */
+//--------------------------------------------------------------------------------------------------
+static void RecordRequest
+(
+    Kind_t                      kind,   ///< [IN] Request kind
+    bool                        isOk,   ///< [IN] Is the request successful?
+    const simServer_Response_t* rspPtr  ///< [IN] Response
+)
+{
+    Stats_t* statsPtr = &Stats[kind];
+
+    LOCK();
+
+    if (!isOk)
+    {
+        statsPtr->errors++;
+        UNLOCK();
+        return;
+    }
+
+    if (statsPtr->count == statsPtr->capacity)
+    {
+        size_t capacity = (statsPtr->capacity) ? (statsPtr->capacity * 2) : 1024;
+        uint64_t* samplesPtr = realloc(statsPtr->samplesPtr, capacity * sizeof(uint64_t));
+
+        LE_ASSERT(samplesPtr);
+        statsPtr->samplesPtr = samplesPtr;
+        statsPtr->capacity = capacity;
+    }
+
+    statsPtr->samplesPtr[statsPtr->count++] = rspPtr->latencyUs;
+
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the timeout argument of a wait command
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetTimeout
+(
+    int     argc,       ///< [IN] Number of arguments
+    char*   argv[],     ///< [IN] Arguments
+    int     index       ///< [IN] Index of the optional timeout argument
+)
+{
+    return (index < argc) ? (uint32_t)strtoul(argv[index], NULL, 10) : DEFAULT_WAIT_TIMEOUT_MS;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request and check its response code
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SendRequest
+(
+    Context_t*  ctxPtr,         ///< [IN] Execution context
+    Kind_t      kind,           ///< [IN] Request kind
+    uint8_t     method,         ///< [IN] CoAP method
+    const char* pathPtr,        ///< [IN] Resource path
+    const char* payloadPtr,     ///< [IN] Text payload, NULL if none
+    int         observe,        ///< [IN] SIMSERVER_OBSERVE_* value
+    const char* expectedPtr,    ///< [IN] Expected response code text, NULL for the default
+    uint8_t     defaultCode     ///< [IN] Default expected response code
+)
+{
+    uint8_t expected = defaultCode;
+    char codeText[8];
+    le_result_t result;
+
+    if ((expectedPtr) && (LE_OK != coap_ParseCode(expectedPtr, &expected)))
+    {
+        LE_ERROR("Invalid response code %s", expectedPtr);
+        return LE_FAULT;
+    }
+
+    memset(&ctxPtr->last, 0, sizeof(ctxPtr->last));
+    result = simServer_Request(ctxPtr->devRef, method, pathPtr, payloadPtr, observe,
+                               &ctxPtr->last);
+    RecordRequest(kind, (LE_OK == result), &ctxPtr->last);
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("%s %s: %s", KindNames[kind], pathPtr, LE_RESULT_TXT(result));
+        return LE_FAULT;
+    }
+
+    if (expected != ctxPtr->last.code)
+    {
+        coap_FormatCode(ctxPtr->last.code, codeText, sizeof(codeText));
+        LE_ERROR("%s %s: unexpected response code %s", KindNames[kind], pathPtr, codeText);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * read <path> [<code>]
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    return SendRequest(ctxPtr, KIND_READ, COAP_GET, argv[1], NULL, SIMSERVER_OBSERVE_NONE,
+                       (argc > 2) ? argv[2] : NULL, COAP_205_CONTENT);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * write <path> <value> [<code>]
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    return SendRequest(ctxPtr, KIND_WRITE, COAP_PUT, argv[1], argv[2], SIMSERVER_OBSERVE_NONE,
+                       (argc > 3) ? argv[3] : NULL, COAP_204_CHANGED);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * exec <path> [<code>]
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ExecCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    return SendRequest(ctxPtr, KIND_EXEC, COAP_POST, argv[1], NULL, SIMSERVER_OBSERVE_NONE,
+                       (argc > 2) ? argv[2] : NULL, COAP_204_CHANGED);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * observe <path> [<code>]
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ObserveCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    return SendRequest(ctxPtr, KIND_OBSERVE, COAP_GET, argv[1], NULL, SIMSERVER_OBSERVE_REGISTER,
+                       (argc > 2) ? argv[2] : NULL, COAP_205_CONTENT);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * cancel-observe <path>
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CancelObserveCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    return SendRequest(ctxPtr, KIND_OBSERVE, COAP_GET, argv[1], NULL,
+                       SIMSERVER_OBSERVE_DEREGISTER, NULL, COAP_205_CONTENT);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * wait-notify <path> <count> [<ms>]
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WaitNotifyCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    le_result_t result = simServer_WaitNotifications(ctxPtr->devRef, argv[1],
+                                                     (unsigned int)strtoul(argv[2], NULL, 10),
+                                                     GetTimeout(argc, argv, 3), &ctxPtr->last);
+    if (LE_OK != result)
+    {
+        LE_ERROR("Notifications of %s: %s", argv[1], LE_RESULT_TXT(result));
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * expect-payload <text>
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ExpectPayloadCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    char text[LINE_BYTES] = "";
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (i > 1)
+        {
+            strncat(text, " ", sizeof(text) - strlen(text) - 1);
+        }
+        strncat(text, argv[i], sizeof(text) - strlen(text) - 1);
+    }
+
+    if (!strstr(ctxPtr->last.payload, text))
+    {
+        LE_ERROR("Payload '%s' does not contain '%s'", ctxPtr->last.payload, text);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * wait-download <target> [<ms>]
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WaitDownloadCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    le_result_t result = simHttp_WaitDownloads(argv[1], 1, GetTimeout(argc, argv, 2));
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Download of %s: %s", argv[1], LE_RESULT_TXT(result));
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * wait-update [<ms>]
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WaitUpdateCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    le_result_t result = simServer_WaitUpdate(ctxPtr->devRef, GetTimeout(argc, argv, 1));
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Registration update: %s", LE_RESULT_TXT(result));
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * wait-deregister [<ms>]
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WaitDeregisterCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    le_result_t result = simServer_WaitDeregistration(ctxPtr->devRef, GetTimeout(argc, argv, 1));
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Deregistration: %s", LE_RESULT_TXT(result));
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * sleep <ms>
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SleepCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    unsigned long ms = strtoul(argv[1], NULL, 10);
+    struct timespec ts = { .tv_sec = (time_t)(ms / 1000), .tv_nsec = (long)(ms % 1000) * 1000000 };
+
+    while ((0 != nanosleep(&ts, &ts)) && (EINTR == errno));
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * log <text>
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t LogCommand
+(
+    Context_t*  ctxPtr,
+    int         argc,
+    char*       argv[]
+)
+{
+    char text[LINE_BYTES] = "";
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        strncat(text, argv[i], sizeof(text) - strlen(text) - 1);
+        strncat(text, " ", sizeof(text) - strlen(text) - 1);
+    }
+
+    LE_INFO("%s: %s", simServer_GetEndpoint(ctxPtr->devRef), text);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Commands
+ */
+//--------------------------------------------------------------------------------------------------
+static const Command_t Commands[] =
+{
+    { "read",            1, 2, ReadCommand          },
+    { "write",           2, 3, WriteCommand         },
+    { "exec",            1, 2, ExecCommand          },
+    { "observe",         1, 2, ObserveCommand       },
+    { "cancel-observe",  1, 1, CancelObserveCommand },
+    { "wait-notify",     2, 3, WaitNotifyCommand    },
+    { "expect-payload",  1, 7, ExpectPayloadCommand },
+    { "wait-download",   1, 2, WaitDownloadCommand  },
+    { "wait-update",     0, 1, WaitUpdateCommand    },
+    { "wait-deregister", 0, 1, WaitDeregisterCommand},
+    { "sleep",           1, 1, SleepCommand         },
+    { "log",             1, 7, LogCommand           },
+    { "repeat",          1, 1, NULL                 },
+    { "end",             0, 0, NULL                 },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Split a line in arguments. The line is modified.
+ *
+ * @return
+ *  - Number of arguments, -1 if there are too many arguments
+ */
+//--------------------------------------------------------------------------------------------------
+static int SplitLine
+(
+    char*   linePtr,    ///< [INOUT] Line
+    char*   argv[]      ///< [OUT] Arguments, MAX_ARGS entries
+)
+{
+    char* savePtr = NULL;
+    char* tokenPtr;
+    int argc = 0;
+
+    for (tokenPtr = strtok_r(linePtr, " \t", &savePtr);
+         tokenPtr;
+         tokenPtr = strtok_r(NULL, " \t", &savePtr))
+    {
+        if (argc >= MAX_ARGS)
+        {
+            return -1;
+        }
+        argv[argc++] = tokenPtr;
+    }
+
+    return argc;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find a command by name
+ *
+ * @return
+ *  - Command pointer, NULL if the command is unknown
+ */
+//--------------------------------------------------------------------------------------------------
+static const Command_t* FindCommand
+(
+    const char* namePtr     ///< [IN] Command name
+)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(Commands); i++)
+    {
+        if (0 == strcmp(Commands[i].namePtr, namePtr))
+        {
+            return &Commands[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Expand the variables of a line
+ *
+ * @return
+ *  - LE_OK         The function succeeded
+ *  - LE_OVERFLOW   The expanded line is too long
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ExpandLine
+(
+    const Context_t*    ctxPtr,     ///< [IN] Execution context
+    const char*         linePtr,    ///< [IN] Line
+    char*               bufPtr,     ///< [OUT] Expanded line
+    size_t              bufSize     ///< [IN] Buffer size
+)
+{
+    char iteration[16];
+    size_t len = 0;
+
+    snprintf(iteration, sizeof(iteration), "%u",
+             (ctxPtr->loopDepth) ? ctxPtr->loops[ctxPtr->loopDepth - 1].iteration : 0);
+
+    while ('\0' != *linePtr)
+    {
+        const char* valuePtr = NULL;
+        size_t nameLen = 0;
+        size_t valueLen;
+
+        if (0 == strncmp(linePtr, "${HTTP}", 7))
+        {
+            valuePtr = HttpUrl;
+            nameLen = 7;
+        }
+        else if (0 == strncmp(linePtr, "${EP}", 5))
+        {
+            valuePtr = simServer_GetEndpoint(ctxPtr->devRef);
+            nameLen = 5;
+        }
+        else if (0 == strncmp(linePtr, "${ITER}", 7))
+        {
+            valuePtr = iteration;
+            nameLen = 7;
+        }
+
+        if (!valuePtr)
+        {
+            valuePtr = linePtr;
+            nameLen = 1;
+            valueLen = 1;
+        }
+        else
+        {
+            valueLen = strlen(valuePtr);
+        }
+
+        if (len + valueLen >= bufSize)
+        {
+            return LE_OVERFLOW;
+        }
+
+        memcpy(bufPtr + len, valuePtr, valueLen);
+        len += valueLen;
+        linePtr += nameLen;
+    }
+
+    bufPtr[len] = '\0';
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load a script. The script is checked and kept in memory.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_NOT_FOUND      The script file could not be opened
+ *  - LE_FORMAT_ERROR   The script is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simScript_Load
+(
+    const char* pathPtr     ///< [IN] Script path
+)
+{
+    char line[LINE_BYTES];
+    int openBlocks[MAX_LOOP_DEPTH];
+    int depth = 0;
+    int lineNumber = 0;
+    FILE* filePtr;
+
+    filePtr = fopen(pathPtr, "r");
+    if (!filePtr)
+    {
+        LE_ERROR("Unable to open %s: %m", pathPtr);
+        return LE_NOT_FOUND;
+    }
+
+    LineCount = 0;
+
+    while (NULL != fgets(line, sizeof(line), filePtr))
+    {
+        char copy[LINE_BYTES];
+        char* argv[MAX_ARGS];
+        const Command_t* commandPtr;
+        int argc;
+
+        lineNumber++;
+        line[strcspn(line, "#\r\n")] = '\0';
+
+        LE_ASSERT_OK(le_utf8_Copy(copy, line, sizeof(copy), NULL));
+        argc = SplitLine(copy, argv);
+        if (0 == argc)
+        {
+            continue;
+        }
+
+        commandPtr = (argc > 0) ? FindCommand(argv[0]) : NULL;
+        if (   (!commandPtr)
+            || (argc - 1 < commandPtr->minArgs)
+            || (argc - 1 > commandPtr->maxArgs)
+            || (LineCount >= MAX_LINES))
+        {
+            LE_ERROR("%s:%d: invalid command", pathPtr, lineNumber);
+            fclose(filePtr);
+            return LE_FORMAT_ERROR;
+        }
+
+        if (0 == strcmp(argv[0], "repeat"))
+        {
+            if (depth >= MAX_LOOP_DEPTH)
+            {
+                LE_ERROR("%s:%d: too many nested repeat blocks", pathPtr, lineNumber);
+                fclose(filePtr);
+                return LE_FORMAT_ERROR;
+            }
+            openBlocks[depth++] = LineCount;
+        }
+        else if (0 == strcmp(argv[0], "end"))
+        {
+            if (0 == depth)
+            {
+                LE_ERROR("%s:%d: end without repeat", pathPtr, lineNumber);
+                fclose(filePtr);
+                return LE_FORMAT_ERROR;
+            }
+            BlockEnds[openBlocks[--depth]] = LineCount;
+        }
+
+        LE_ASSERT_OK(le_utf8_Copy(Lines[LineCount], line, LINE_BYTES, NULL));
+        LineNumbers[LineCount] = lineNumber;
+        LineCommands[LineCount] = commandPtr;
+        LineCount++;
+    }
+
+    fclose(filePtr);
+
+    if (depth)
+    {
+        LE_ERROR("%s: repeat without end", pathPtr);
+        return LE_FORMAT_ERROR;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the base URL of the HTTP fixture, used to expand ${HTTP} in the script
+ */
+//--------------------------------------------------------------------------------------------------
+void simScript_SetHttpUrl
+(
+    const char* urlPtr      ///< [IN] Base URL, e.g. "http://192.168.1.2:8080"
+)
+{
+    LE_ASSERT_OK(le_utf8_Copy(HttpUrl, urlPtr, sizeof(HttpUrl), NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the loaded script for a device
+ *
+ * @return
+ *  - LE_OK     The script succeeded
+ *  - LE_FAULT  A script command failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simScript_Run
+(
+    simServer_DeviceRef_t devRef    ///< [IN] Device reference
+)
+{
+    Context_t ctx;
+    int pc = 0;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.devRef = devRef;
+
+    LE_INFO("Running the script for device %s", simServer_GetEndpoint(devRef));
+
+    while (pc < LineCount)
+    {
+        const Command_t* commandPtr = LineCommands[pc];
+        char line[LINE_BYTES];
+        char* argv[MAX_ARGS];
+        int argc;
+
+        if (   (LE_OK != ExpandLine(&ctx, Lines[pc], line, sizeof(line)))
+            || (0 >= (argc = SplitLine(line, argv))))
+        {
+            LE_ERROR("%s: line %d: invalid expanded line",
+                     simServer_GetEndpoint(devRef), LineNumbers[pc]);
+            return LE_FAULT;
+        }
+
+        if (0 == strcmp(commandPtr->namePtr, "repeat"))
+        {
+            unsigned int count = (unsigned int)strtoul(argv[1], NULL, 10);
+
+            if (0 == count)
+            {
+                pc = BlockEnds[pc] + 1;
+                continue;
+            }
+
+            ctx.loops[ctx.loopDepth].start = pc;
+            ctx.loops[ctx.loopDepth].remaining = count;
+            ctx.loops[ctx.loopDepth].iteration = 0;
+            ctx.loopDepth++;
+            pc++;
+        }
+        else if (0 == strcmp(commandPtr->namePtr, "end"))
+        {
+            ctx.loops[ctx.loopDepth - 1].iteration++;
+            if (0 < --ctx.loops[ctx.loopDepth - 1].remaining)
+            {
+                pc = ctx.loops[ctx.loopDepth - 1].start + 1;
+            }
+            else
+            {
+                ctx.loopDepth--;
+                pc++;
+            }
+        }
+        else
+        {
+            if (LE_OK != commandPtr->handler(&ctx, argc, argv))
+            {
+                LE_ERROR("%s: line %d failed: %s",
+                         simServer_GetEndpoint(devRef), LineNumbers[pc], Lines[pc]);
+                return LE_FAULT;
+            }
+            pc++;
+        }
+    }
+
+    LE_INFO("Script succeeded for device %s", simServer_GetEndpoint(devRef));
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare two latency samples, for qsort()
+ */
+//--------------------------------------------------------------------------------------------------
+static int CompareSamples
+(
+    const void* aPtr,
+    const void* bPtr
+)
+{
+    uint64_t a = *(const uint64_t*)aPtr;
+    uint64_t b = *(const uint64_t*)bPtr;
+
+    return (a > b) - (a < b);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the latency statistics of the requests sent by all the scripts
+ */
+//--------------------------------------------------------------------------------------------------
+void simScript_PrintStats
+(
+    FILE* filePtr       ///< [IN] Output
+)
+{
+    int kind;
+
+    LOCK();
+
+    fprintf(filePtr, "%-8s %8s %7s %9s %9s %9s %9s %9s\n",
+            "request", "count", "errors", "min ms", "avg ms", "p50 ms", "p95 ms", "max ms");
+
+    for (kind = 0; kind < KIND_MAX; kind++)
+    {
+        Stats_t* statsPtr = &Stats[kind];
+        uint64_t total = 0;
+        size_t i;
+
+        if ((0 == statsPtr->count) && (0 == statsPtr->errors))
+        {
+            continue;
+        }
+
+        if (0 == statsPtr->count)
+        {
+            fprintf(filePtr, "%-8s %8zu %7zu\n", KindNames[kind], statsPtr->count,
+                    statsPtr->errors);
+            continue;
+        }
+
+        qsort(statsPtr->samplesPtr, statsPtr->count, sizeof(uint64_t), CompareSamples);
+        for (i = 0; i < statsPtr->count; i++)
+        {
+            total += statsPtr->samplesPtr[i];
+        }
+
+        fprintf(filePtr, "%-8s %8zu %7zu %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                KindNames[kind], statsPtr->count, statsPtr->errors,
+                statsPtr->samplesPtr[0] / 1000.0,
+                (double)total / statsPtr->count / 1000.0,
+                statsPtr->samplesPtr[statsPtr->count / 2] / 1000.0,
+                statsPtr->samplesPtr[(statsPtr->count * 95) / 100] / 1000.0,
+                statsPtr->samplesPtr[statsPtr->count - 1] / 1000.0);
+    }
+
+    UNLOCK();
+}
@@ -0,0 +1,67 @@
+/**
+ * @file simScript.h
+ *
+ * Scenario scripts of the simulator, run for each registered device.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _SIMSCRIPT_H
+#define _SIMSCRIPT_H
+
+#include "legato.h"
+#include "simServer.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load a script. The script is checked and kept in memory.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_NOT_FOUND      The script file could not be opened
+ *  - LE_FORMAT_ERROR   The script is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simScript_Load
+(
+    const char* pathPtr     ///< [IN] Script path
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the base URL of the HTTP fixture, used to expand ${HTTP} in the script
+ */
+//--------------------------------------------------------------------------------------------------
+void simScript_SetHttpUrl
+(
+    const char* urlPtr      ///< [IN] Base URL, e.g. "http://192.168.1.2:8080"
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the loaded script for a device
+ *
+ * @return
+ *  - LE_OK     The script succeeded
+ *  - LE_FAULT  A script command failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simScript_Run
+(
+    simServer_DeviceRef_t devRef    ///< [IN] Device reference
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the latency statistics of the requests sent by all the scripts
+ */
+//--------------------------------------------------------------------------------------------------
+void simScript_PrintStats
+(
+    FILE* filePtr       ///< [IN] Output
+);
+
+#endif /* _SIMSCRIPT_H */
@@ -0,0 +1,1002 @@
+/**
+ * @file simServer.c
+ *
+ * LwM2M server side of the simulator: registration interface and device management requests
+ * over plain UDP.
+ *
+ * A receiving thread handles the registration interface (register, update, deregister) and
+ * dispatches the responses and the notifications. The requests are sent by the script threads,
+ * one per device: each device has at most one pending request.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include <netinet/in.h>
+#include <poll.h>
+#include "coap.h"
+#include "simServer.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP transmission parameters (RFC 7252 section 4.8)
+ */
+//--------------------------------------------------------------------------------------------------
+#define ACK_TIMEOUT_MS              2000
+#define MAX_RETRANSMIT              4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum time to wait for a separate response once the request is acknowledged
+ */
+//--------------------------------------------------------------------------------------------------
+#define SEPARATE_RESPONSE_TIMEOUT_MS    30000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of observations per device
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_OBSERVATIONS            8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Token length used by the server
+ */
+//--------------------------------------------------------------------------------------------------
+#define TOKEN_BYTES                 4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registration interface path
+ */
+//--------------------------------------------------------------------------------------------------
+#define REGISTRATION_PATH           "/rd"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Receiving thread polling period, to check the stop request
+ */
+//--------------------------------------------------------------------------------------------------
+#define POLL_PERIOD_MS              200
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Observation
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool                    isUsed;                         ///< Is the observation used?
+    char                    path[SIMSERVER_PATH_BYTES];     ///< Observed path
+    uint8_t                 token[TOKEN_BYTES];             ///< Observation token
+    unsigned int            notifications;                  ///< Received notifications
+    simServer_Response_t    last;                           ///< Last notification
+}
+Observation_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registered device
+ */
+//--------------------------------------------------------------------------------------------------
+struct simServer_Device
+{
+    bool                    isUsed;                         ///< Is the slot used?
+    bool                    isRegistered;                   ///< Is the device registered?
+    bool                    isReturned;                     ///< Returned by WaitRegistration?
+    char                    endpoint[SIMSERVER_ENDPOINT_BYTES]; ///< Endpoint name
+    unsigned int            id;                             ///< Registration Id: rd/<id>
+    struct sockaddr_in      addr;                           ///< Device address
+    uint32_t                lifetime;                       ///< Registration lifetime
+    unsigned int            updates;                        ///< Registration updates
+    bool                    isPending;                      ///< Is a request pending?
+    bool                    isAcked;                        ///< Is the request acknowledged?
+    bool                    isDone;                         ///< Is the response received?
+    uint16_t                mid;                            ///< Pending request message Id
+    uint8_t                 token[TOKEN_BYTES];             ///< Pending request token
+    simServer_Response_t    response;                       ///< Pending request response
+    Observation_t           observations[MAX_OBSERVATIONS]; ///< Observations
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Devices
+ */
+//--------------------------------------------------------------------------------------------------
+static struct simServer_Device Devices[SIMSERVER_MAX_DEVICES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Server socket
+ */
+//--------------------------------------------------------------------------------------------------
+static int Socket = -1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Server UDP port
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t Port = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Next message Id and token used by the server
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t NextMid = 1;
+static uint32_t NextToken = 1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop request of the receiving thread
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsStopping = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Receiving thread
+ */
+//--------------------------------------------------------------------------------------------------
+static le_thread_Ref_t ReceiveThreadRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex protecting the devices, and condition variable signaled on each received message
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t ServerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ServerCond;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&ServerMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&ServerMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize and send a message to an address
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SendMessage
+(
+    const coap_Message_t*       msgPtr,     ///< [IN] Message
+    const struct sockaddr_in*   addrPtr     ///< [IN] Destination
+)
+{
+    uint8_t buf[COAP_MAX_DATAGRAM_BYTES];
+    size_t len = sizeof(buf);
+
+    if (LE_OK != coap_Serialize(msgPtr, buf, &len))
+    {
+        LE_ERROR("Message too large");
+        return LE_FAULT;
+    }
+
+    if (0 > sendto(Socket, buf, len, 0, (const struct sockaddr*)addrPtr, sizeof(*addrPtr)))
+    {
+        LE_ERROR("sendto failed: %m");
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send an empty message (ACK or RST) to a received message
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendEmpty
+(
+    coap_Type_t                 type,       ///< [IN] COAP_TYPE_ACK or COAP_TYPE_RST
+    uint16_t                    mid,        ///< [IN] Message Id of the received message
+    const struct sockaddr_in*   addrPtr     ///< [IN] Destination
+)
+{
+    coap_Message_t msg;
+
+    coap_Init(&msg, type, COAP_EMPTY, mid);
+    SendMessage(&msg, addrPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy a response. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CopyResponse
+(
+    const coap_Message_t*   msgPtr,     ///< [IN] Received message
+    simServer_Response_t*   rspPtr      ///< [OUT] Response
+)
+{
+    rspPtr->code = msgPtr->code;
+    rspPtr->payloadLen = (msgPtr->payloadLen > SIMSERVER_PAYLOAD_BYTES) ?
+                         SIMSERVER_PAYLOAD_BYTES : msgPtr->payloadLen;
+    if (rspPtr->payloadLen)
+    {
+        memcpy(rspPtr->payload, msgPtr->payloadPtr, rspPtr->payloadLen);
+    }
+    rspPtr->payload[rspPtr->payloadLen] = '\0';
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find a device by endpoint name or by registration Id. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct simServer_Device* FindDevice
+(
+    const char*     endpointPtr,    ///< [IN] Endpoint name, NULL to search by Id
+    unsigned int    id              ///< [IN] Registration Id
+)
+{
+    int i;
+
+    for (i = 0; i < SIMSERVER_MAX_DEVICES; i++)
+    {
+        if (!Devices[i].isUsed)
+        {
+            continue;
+        }
+
+        if (   ((endpointPtr) && (0 == strcmp(Devices[i].endpoint, endpointPtr)))
+            || ((!endpointPtr) && (Devices[i].id == id)))
+        {
+            return &Devices[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a request of the registration interface. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandleRegistration
+(
+    const coap_Message_t*       msgPtr,     ///< [IN] Received request
+    const struct sockaddr_in*   addrPtr     ///< [IN] Device address
+)
+{
+    char path[SIMSERVER_PATH_BYTES];
+    char endpoint[SIMSERVER_ENDPOINT_BYTES];
+    char location[SIMSERVER_PATH_BYTES];
+    char lifetime[16];
+    struct simServer_Device* devPtr = NULL;
+    coap_Message_t rsp;
+    unsigned int id;
+    int i;
+
+    coap_Init(&rsp, (COAP_TYPE_CON == msgPtr->type) ? COAP_TYPE_ACK : COAP_TYPE_NON,
+              COAP_404_NOT_FOUND, msgPtr->mid);
+    coap_SetToken(&rsp, msgPtr->token, msgPtr->tokenLen);
+
+    if (LE_OK != coap_GetPath(msgPtr, COAP_OPTION_URI_PATH, path, sizeof(path)))
+    {
+        rsp.code = COAP_400_BAD_REQUEST;
+    }
+    else if ((COAP_POST == msgPtr->code) && (0 == strcmp(path, REGISTRATION_PATH)))
+    {
+        // Registration: a device registering again keeps its registration Id
+        if (LE_OK != coap_GetQuery(msgPtr, "ep", endpoint, sizeof(endpoint)))
+        {
+            rsp.code = COAP_400_BAD_REQUEST;
+        }
+        else
+        {
+            devPtr = FindDevice(endpoint, 0);
+            for (i = 0; (!devPtr) && (i < SIMSERVER_MAX_DEVICES); i++)
+            {
+                if (!Devices[i].isUsed)
+                {
+                    devPtr = &Devices[i];
+                    memset(devPtr, 0, sizeof(*devPtr));
+                    devPtr->isUsed = true;
+                    devPtr->id = (unsigned int)i + 1;
+                    LE_ASSERT_OK(le_utf8_Copy(devPtr->endpoint, endpoint,
+                                              sizeof(devPtr->endpoint), NULL));
+                }
+            }
+        }
+
+        if (devPtr)
+        {
+            devPtr->lifetime = 86400;
+            if (LE_OK == coap_GetQuery(msgPtr, "lt", lifetime, sizeof(lifetime)))
+            {
+                devPtr->lifetime = (uint32_t)strtoul(lifetime, NULL, 10);
+            }
+            devPtr->addr = *addrPtr;
+            devPtr->isRegistered = true;
+
+            snprintf(location, sizeof(location), "%s/%u", REGISTRATION_PATH, devPtr->id);
+            coap_AddPath(&rsp, COAP_OPTION_LOCATION_PATH, location);
+            rsp.code = COAP_201_CREATED;
+
+            LE_INFO("Device %s registered as %s, lifetime %"PRIu32" s",
+                    devPtr->endpoint, location, devPtr->lifetime);
+        }
+        else if (COAP_404_NOT_FOUND == rsp.code)
+        {
+            LE_ERROR("Too many devices");
+            rsp.code = COAP_500_INTERNAL_ERROR;
+        }
+    }
+    else if (1 == sscanf(path, REGISTRATION_PATH "/%u", &id))
+    {
+        devPtr = FindDevice(NULL, id);
+
+        if ((!devPtr) || (!devPtr->isRegistered))
+        {
+            rsp.code = COAP_404_NOT_FOUND;
+        }
+        else if (COAP_POST == msgPtr->code)
+        {
+            // Registration update: the device address may have changed (NAT rebinding)
+            if (LE_OK == coap_GetQuery(msgPtr, "lt", lifetime, sizeof(lifetime)))
+            {
+                devPtr->lifetime = (uint32_t)strtoul(lifetime, NULL, 10);
+            }
+            devPtr->addr = *addrPtr;
+            devPtr->updates++;
+            rsp.code = COAP_204_CHANGED;
+            LE_DEBUG("Device %s updated its registration", devPtr->endpoint);
+        }
+        else if (COAP_DELETE == msgPtr->code)
+        {
+            devPtr->isRegistered = false;
+            memset(devPtr->observations, 0, sizeof(devPtr->observations));
+            rsp.code = COAP_202_DELETED;
+            LE_INFO("Device %s deregistered", devPtr->endpoint);
+        }
+        else
+        {
+            rsp.code = COAP_405_NOT_ALLOWED;
+        }
+    }
+
+    SendMessage(&rsp, addrPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a response, a notification or an empty message. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandleResponse
+(
+    const coap_Message_t*       msgPtr,     ///< [IN] Received message
+    const struct sockaddr_in*   addrPtr     ///< [IN] Device address
+)
+{
+    int i, j;
+
+    for (i = 0; i < SIMSERVER_MAX_DEVICES; i++)
+    {
+        struct simServer_Device* devPtr = &Devices[i];
+
+        if (!devPtr->isUsed)
+        {
+            continue;
+        }
+
+        // Empty acknowledgement or reset of the pending request, matched by message Id
+        if (COAP_EMPTY == msgPtr->code)
+        {
+            if ((devPtr->isPending) && (!devPtr->isDone) && (devPtr->mid == msgPtr->mid))
+            {
+                if (COAP_TYPE_RST == msgPtr->type)
+                {
+                    devPtr->response.code = COAP_EMPTY;
+                    devPtr->isDone = true;
+                }
+                else
+                {
+                    devPtr->isAcked = true;
+                }
+                return;
+            }
+            continue;
+        }
+
+        // Response of the pending request, matched by token
+        if (   (devPtr->isPending)
+            && (!devPtr->isDone)
+            && (TOKEN_BYTES == msgPtr->tokenLen)
+            && (0 == memcmp(devPtr->token, msgPtr->token, TOKEN_BYTES)))
+        {
+            CopyResponse(msgPtr, &devPtr->response);
+            devPtr->isDone = true;
+            if (COAP_TYPE_CON == msgPtr->type)
+            {
+                SendEmpty(COAP_TYPE_ACK, msgPtr->mid, addrPtr);
+            }
+            return;
+        }
+
+        // Notification of an observation
+        for (j = 0; j < MAX_OBSERVATIONS; j++)
+        {
+            Observation_t* obsPtr = &devPtr->observations[j];
+
+            if (   (obsPtr->isUsed)
+                && (TOKEN_BYTES == msgPtr->tokenLen)
+                && (0 == memcmp(obsPtr->token, msgPtr->token, TOKEN_BYTES)))
+            {
+                CopyResponse(msgPtr, &obsPtr->last);
+                obsPtr->notifications++;
+                if (COAP_TYPE_CON == msgPtr->type)
+                {
+                    SendEmpty(COAP_TYPE_ACK, msgPtr->mid, addrPtr);
+                }
+                return;
+            }
+        }
+    }
+
+    // Unknown token: the device should stop sending this notification
+    if ((COAP_EMPTY != msgPtr->code) && (COAP_TYPE_ACK != msgPtr->type))
+    {
+        SendEmpty(COAP_TYPE_RST, msgPtr->mid, addrPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Receiving thread
+ */
+//--------------------------------------------------------------------------------------------------
+static void* ReceiveThread
+(
+    void* contextPtr
+)
+{
+    uint8_t buf[COAP_MAX_DATAGRAM_BYTES];
+    struct pollfd pfd = { .fd = Socket, .events = POLLIN };
+
+    while (!IsStopping)
+    {
+        struct sockaddr_in addr;
+        socklen_t addrLen = sizeof(addr);
+        coap_Message_t msg;
+        ssize_t len;
+
+        if (0 >= poll(&pfd, 1, POLL_PERIOD_MS))
+        {
+            continue;
+        }
+
+        memset(&addr, 0, sizeof(addr));
+        len = recvfrom(Socket, buf, sizeof(buf), 0, (struct sockaddr*)&addr, &addrLen);
+        if ((len <= 0) || (LE_OK != coap_Parse(buf, (size_t)len, &msg)))
+        {
+            continue;
+        }
+
+        LOCK();
+
+        if ((COAP_EMPTY != msg.code) && (0 == (msg.code >> 5)))
+        {
+            HandleRegistration(&msg, &addr);
+        }
+        else
+        {
+            HandleResponse(&msg, &addr);
+        }
+
+        pthread_cond_broadcast(&ServerCond);
+        UNLOCK();
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find an observation of a device. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static Observation_t* FindObservation
+(
+    struct simServer_Device*    devPtr,     ///< [IN] Device
+    const char*                 pathPtr     ///< [IN] Observed path
+)
+{
+    int i;
+
+    for (i = 0; i < MAX_OBSERVATIONS; i++)
+    {
+        if ((devPtr->observations[i].isUsed) && (0 == strcmp(devPtr->observations[i].path, pathPtr)))
+        {
+            return &devPtr->observations[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a monotonic time in microseconds
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t simServer_NowUs
+(
+    void
+)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a condition variable using the monotonic clock
+ */
+//--------------------------------------------------------------------------------------------------
+void simServer_InitCond
+(
+    pthread_cond_t* condPtr     ///< [OUT] Condition variable
+)
+{
+    pthread_condattr_t attr;
+
+    LE_ASSERT(0 == pthread_condattr_init(&attr));
+    LE_ASSERT(0 == pthread_condattr_setclock(&attr, CLOCK_MONOTONIC));
+    LE_ASSERT(0 == pthread_cond_init(condPtr, &attr));
+    pthread_condattr_destroy(&attr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait on a condition variable initialized by simServer_InitCond() until a monotonic deadline
+ *
+ * @return
+ *  - LE_OK         The condition variable was signaled
+ *  - LE_TIMEOUT    The deadline is reached
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_WaitCond
+(
+    pthread_cond_t*     condPtr,    ///< [IN] Condition variable
+    pthread_mutex_t*    mutexPtr,   ///< [IN] Locked mutex
+    uint64_t            deadlineUs  ///< [IN] Deadline, in simServer_NowUs() time
+)
+{
+    struct timespec ts;
+
+    if (simServer_NowUs() >= deadlineUs)
+    {
+        return LE_TIMEOUT;
+    }
+
+    ts.tv_sec = (time_t)(deadlineUs / 1000000);
+    ts.tv_nsec = (long)(deadlineUs % 1000000) * 1000;
+
+    return (ETIMEDOUT == pthread_cond_timedwait(condPtr, mutexPtr, &ts)) ? LE_TIMEOUT : LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the server on a UDP port
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The socket could not be created
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_Start
+(
+    uint16_t port       ///< [IN] UDP port, 0 for an ephemeral port
+)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    simServer_InitCond(&ServerCond);
+
+    Socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (Socket < 0)
+    {
+        LE_ERROR("socket failed: %m");
+        return LE_FAULT;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (   (0 != bind(Socket, (struct sockaddr*)&addr, sizeof(addr)))
+        || (0 != getsockname(Socket, (struct sockaddr*)&addr, &addrLen)))
+    {
+        LE_ERROR("Unable to bind UDP port %"PRIu16": %m", port);
+        close(Socket);
+        Socket = -1;
+        return LE_FAULT;
+    }
+
+    Port = ntohs(addr.sin_port);
+    IsStopping = false;
+
+    ReceiveThreadRef = le_thread_Create("SimServerRx", ReceiveThread, NULL);
+    le_thread_SetJoinable(ReceiveThreadRef);
+    le_thread_Start(ReceiveThreadRef);
+
+    LE_INFO("LwM2M server simulator listening on UDP port %"PRIu16, Port);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the server
+ */
+//--------------------------------------------------------------------------------------------------
+void simServer_Stop
+(
+    void
+)
+{
+    if (!ReceiveThreadRef)
+    {
+        return;
+    }
+
+    IsStopping = true;
+    le_thread_Join(ReceiveThreadRef, NULL);
+    ReceiveThreadRef = NULL;
+
+    close(Socket);
+    Socket = -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the UDP port of the server
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t simServer_GetPort
+(
+    void
+)
+{
+    return Port;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for a registered device which has not been returned yet
+ *
+ * @return
+ *  - Device reference, NULL on timeout
+ */
+//--------------------------------------------------------------------------------------------------
+simServer_DeviceRef_t simServer_WaitRegistration
+(
+    uint32_t timeoutMs          ///< [IN] Timeout in milliseconds
+)
+{
+    uint64_t deadlineUs = simServer_NowUs() + ((uint64_t)timeoutMs * 1000);
+    simServer_DeviceRef_t devRef = NULL;
+    int i;
+
+    LOCK();
+
+    do
+    {
+        for (i = 0; (!devRef) && (i < SIMSERVER_MAX_DEVICES); i++)
+        {
+            if ((Devices[i].isRegistered) && (!Devices[i].isReturned))
+            {
+                devRef = &Devices[i];
+                devRef->isReturned = true;
+            }
+        }
+    }
+    while ((!devRef) && (LE_OK == simServer_WaitCond(&ServerCond, &ServerMutex, deadlineUs)));
+
+    UNLOCK();
+
+    return devRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the endpoint name of a device
+ */
+//--------------------------------------------------------------------------------------------------
+const char* simServer_GetEndpoint
+(
+    simServer_DeviceRef_t devRef    ///< [IN] Device reference
+)
+{
+    return devRef->endpoint;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a device management request and wait for its response
+ *
+ * @return
+ *  - LE_OK             The response is received
+ *  - LE_NOT_POSSIBLE   The device is not registered, or the observation to cancel is unknown
+ *  - LE_TIMEOUT        No response after all the retransmissions
+ *  - LE_FAULT          The request could not be sent or was rejected by the device
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_Request
+(
+    simServer_DeviceRef_t   devRef,     ///< [IN] Device reference
+    uint8_t                 method,     ///< [IN] CoAP method
+    const char*             pathPtr,    ///< [IN] Resource path
+    const char*             payloadPtr, ///< [IN] Text payload, NULL if none
+    int                     observe,    ///< [IN] SIMSERVER_OBSERVE_* value
+    simServer_Response_t*   rspPtr      ///< [OUT] Response
+)
+{
+    Observation_t* obsPtr = NULL;
+    coap_Message_t msg;
+    uint64_t startUs, deadlineUs;
+    uint32_t timeoutMs = ACK_TIMEOUT_MS;
+    le_result_t result = LE_TIMEOUT;
+    int attempt;
+
+    LOCK();
+
+    if (!devRef->isRegistered)
+    {
+        UNLOCK();
+        return LE_NOT_POSSIBLE;
+    }
+
+    coap_Init(&msg, COAP_TYPE_CON, method, NextMid++);
+
+    // An observation is cancelled with a request using the observation token
+    if (SIMSERVER_OBSERVE_DEREGISTER == observe)
+    {
+        obsPtr = FindObservation(devRef, pathPtr);
+        if (!obsPtr)
+        {
+            UNLOCK();
+            return LE_NOT_POSSIBLE;
+        }
+        memcpy(devRef->token, obsPtr->token, TOKEN_BYTES);
+    }
+    else
+    {
+        devRef->token[0] = (uint8_t)(NextToken >> 24);
+        devRef->token[1] = (uint8_t)(NextToken >> 16);
+        devRef->token[2] = (uint8_t)(NextToken >> 8);
+        devRef->token[3] = (uint8_t)NextToken;
+        NextToken++;
+    }
+    coap_SetToken(&msg, devRef->token, TOKEN_BYTES);
+
+    if (   ((SIMSERVER_OBSERVE_NONE != observe)
+            && (LE_OK != coap_AddUintOption(&msg, COAP_OPTION_OBSERVE, (uint32_t)observe)))
+        || (LE_OK != coap_AddPath(&msg, COAP_OPTION_URI_PATH, pathPtr)))
+    {
+        UNLOCK();
+        return LE_FAULT;
+    }
+
+    if (payloadPtr)
+    {
+        coap_AddUintOption(&msg, COAP_OPTION_CONTENT_FORMAT, COAP_FORMAT_TEXT);
+        coap_SetPayload(&msg, (const uint8_t*)payloadPtr, strlen(payloadPtr));
+    }
+
+    devRef->mid = msg.mid;
+    devRef->isPending = true;
+    devRef->isAcked = false;
+    devRef->isDone = false;
+    startUs = simServer_NowUs();
+
+    // Retransmit with an exponential back-off until the request is acknowledged
+    for (attempt = 0; (attempt <= MAX_RETRANSMIT) && (!devRef->isDone); attempt++)
+    {
+        if (LE_OK != SendMessage(&msg, &devRef->addr))
+        {
+            result = LE_FAULT;
+            break;
+        }
+
+        deadlineUs = simServer_NowUs() + ((uint64_t)timeoutMs * 1000);
+        while (   (!devRef->isDone)
+               && (!devRef->isAcked)
+               && (LE_OK == simServer_WaitCond(&ServerCond, &ServerMutex, deadlineUs)));
+
+        if (devRef->isAcked)
+        {
+            deadlineUs = simServer_NowUs() + ((uint64_t)SEPARATE_RESPONSE_TIMEOUT_MS * 1000);
+            while (   (!devRef->isDone)
+                   && (LE_OK == simServer_WaitCond(&ServerCond, &ServerMutex, deadlineUs)));
+            break;
+        }
+
+        timeoutMs *= 2;
+    }
+
+    if (devRef->isDone)
+    {
+        *rspPtr = devRef->response;
+        rspPtr->latencyUs = simServer_NowUs() - startUs;
+        result = (COAP_EMPTY == rspPtr->code) ? LE_FAULT : LE_OK;
+    }
+
+    if ((LE_OK == result) && (COAP_205_CONTENT == rspPtr->code))
+    {
+        if (SIMSERVER_OBSERVE_REGISTER == observe)
+        {
+            int i;
+
+            obsPtr = FindObservation(devRef, pathPtr);
+            for (i = 0; (!obsPtr) && (i < MAX_OBSERVATIONS); i++)
+            {
+                if (!devRef->observations[i].isUsed)
+                {
+                    obsPtr = &devRef->observations[i];
+                }
+            }
+
+            if (obsPtr)
+            {
+                memset(obsPtr, 0, sizeof(*obsPtr));
+                obsPtr->isUsed = true;
+                LE_ASSERT_OK(le_utf8_Copy(obsPtr->path, pathPtr, sizeof(obsPtr->path), NULL));
+                memcpy(obsPtr->token, devRef->token, TOKEN_BYTES);
+                obsPtr->last = *rspPtr;
+            }
+            else
+            {
+                LE_ERROR("Too many observations for device %s", devRef->endpoint);
+                result = LE_FAULT;
+            }
+        }
+        else if (SIMSERVER_OBSERVE_DEREGISTER == observe)
+        {
+            obsPtr->isUsed = false;
+        }
+    }
+
+    devRef->isPending = false;
+
+    UNLOCK();
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until an observation received a number of notifications since it started
+ *
+ * @return
+ *  - LE_OK             The notifications are received
+ *  - LE_NOT_POSSIBLE   The path is not observed
+ *  - LE_TIMEOUT        Timeout
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_WaitNotifications
+(
+    simServer_DeviceRef_t   devRef,     ///< [IN] Device reference
+    const char*             pathPtr,    ///< [IN] Observed path
+    unsigned int            count,      ///< [IN] Number of notifications
+    uint32_t                timeoutMs,  ///< [IN] Timeout in milliseconds
+    simServer_Response_t*   rspPtr      ///< [OUT] Last notification
+)
+{
+    uint64_t deadlineUs = simServer_NowUs() + ((uint64_t)timeoutMs * 1000);
+    le_result_t result = LE_OK;
+    Observation_t* obsPtr;
+
+    LOCK();
+
+    while (   (NULL != (obsPtr = FindObservation(devRef, pathPtr)))
+           && (obsPtr->notifications < count))
+    {
+        if (LE_OK != simServer_WaitCond(&ServerCond, &ServerMutex, deadlineUs))
+        {
+            result = LE_TIMEOUT;
+            break;
+        }
+    }
+
+    if (!obsPtr)
+    {
+        result = LE_NOT_POSSIBLE;
+    }
+    else
+    {
+        *rspPtr = obsPtr->last;
+    }
+
+    UNLOCK();
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the next registration update of a device
+ *
+ * @return
+ *  - LE_OK         The registration update is received
+ *  - LE_TIMEOUT    Timeout
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_WaitUpdate
+(
+    simServer_DeviceRef_t   devRef,     ///< [IN] Device reference
+    uint32_t                timeoutMs   ///< [IN] Timeout in milliseconds
+)
+{
+    uint64_t deadlineUs = simServer_NowUs() + ((uint64_t)timeoutMs * 1000);
+    le_result_t result = LE_OK;
+    unsigned int updates;
+
+    LOCK();
+
+    updates = devRef->updates;
+    while (updates == devRef->updates)
+    {
+        if (LE_OK != simServer_WaitCond(&ServerCond, &ServerMutex, deadlineUs))
+        {
+            result = LE_TIMEOUT;
+            break;
+        }
+    }
+
+    UNLOCK();
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the deregistration of a device
+ *
+ * @return
+ *  - LE_OK         The device is deregistered
+ *  - LE_TIMEOUT    Timeout
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_WaitDeregistration
+(
+    simServer_DeviceRef_t   devRef,     ///< [IN] Device reference
+    uint32_t                timeoutMs   ///< [IN] Timeout in milliseconds
+)
+{
+    uint64_t deadlineUs = simServer_NowUs() + ((uint64_t)timeoutMs * 1000);
+    le_result_t result = LE_OK;
+
+    LOCK();
+
+    while (devRef->isRegistered)
+    {
+        if (LE_OK != simServer_WaitCond(&ServerCond, &ServerMutex, deadlineUs))
+        {
+            result = LE_TIMEOUT;
+            break;
+        }
+    }
+
+    UNLOCK();
+
+    return result;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file simServer.h
+ *
+ * LwM2M server side of the simulator: registration interface and device management requests
+ * over plain UDP.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _SIMSERVER_H
+#define _SIMSERVER_H
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of registered devices
+ */
+//--------------------------------------------------------------------------------------------------
+#define SIMSERVER_MAX_DEVICES           256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a device endpoint name, including the null-terminator
+ */
+//--------------------------------------------------------------------------------------------------
+#define SIMSERVER_ENDPOINT_BYTES        64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a resource path, including the null-terminator
+ */
+//--------------------------------------------------------------------------------------------------
+#define SIMSERVER_PATH_BYTES            64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a response payload
+ */
+//--------------------------------------------------------------------------------------------------
+#define SIMSERVER_PAYLOAD_BYTES         1024
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Observe option values of a request
+ */
+//--------------------------------------------------------------------------------------------------
+#define SIMSERVER_OBSERVE_NONE          -1  ///< No Observe option
+#define SIMSERVER_OBSERVE_REGISTER      0   ///< Start to observe
+#define SIMSERVER_OBSERVE_DEREGISTER    1   ///< Cancel the observation
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registered device reference
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct simServer_Device* simServer_DeviceRef_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Response to a device management request
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t     code;                                   ///< CoAP response code
+    char        payload[SIMSERVER_PAYLOAD_BYTES + 1];   ///< Payload, null-terminated
+    size_t      payloadLen;                             ///< Payload length
+    uint64_t    latencyUs;                              ///< Time from request to response
+}
+simServer_Response_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a monotonic time in microseconds
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t simServer_NowUs
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a condition variable using the monotonic clock
+ */
+//--------------------------------------------------------------------------------------------------
+void simServer_InitCond
+(
+    pthread_cond_t* condPtr     ///< [OUT] Condition variable
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait on a condition variable initialized by simServer_InitCond() until a monotonic deadline
+ *
+ * @return
+ *  - LE_OK         The condition variable was signaled
+ *  - LE_TIMEOUT    The deadline is reached
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_WaitCond
+(
+    pthread_cond_t*     condPtr,    ///< [IN] Condition variable
+    pthread_mutex_t*    mutexPtr,   ///< [IN] Locked mutex
+    uint64_t            deadlineUs  ///< [IN] Deadline, in simServer_NowUs() time
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the server on a UDP port
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The socket could not be created
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_Start
+(
+    uint16_t port       ///< [IN] UDP port, 0 for an ephemeral port
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the server
+ */
+//--------------------------------------------------------------------------------------------------
+void simServer_Stop
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the UDP port of the server
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t simServer_GetPort
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for a registered device which has not been returned yet
+ *
+ * @return
+ *  - Device reference, NULL on timeout
+ */
+//--------------------------------------------------------------------------------------------------
+simServer_DeviceRef_t simServer_WaitRegistration
+(
+    uint32_t timeoutMs          ///< [IN] Timeout in milliseconds
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the endpoint name of a device
+ */
+//--------------------------------------------------------------------------------------------------
+const char* simServer_GetEndpoint
+(
+    simServer_DeviceRef_t devRef    ///< [IN] Device reference
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a device management request and wait for its response
+ *
+ * @return
+ *  - LE_OK             The response is received
+ *  - LE_NOT_POSSIBLE   The device is not registered, or the observation to cancel is unknown
+ *  - LE_TIMEOUT        No response after all the retransmissions
+ *  - LE_FAULT          The request could not be sent or was rejected by the device
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_Request
+(
+    simServer_DeviceRef_t   devRef,     ///< [IN] Device reference
+    uint8_t                 method,     ///< [IN] CoAP method
+    const char*             pathPtr,    ///< [IN] Resource path
+    const char*             payloadPtr, ///< [IN] Text payload, NULL if none
+    int                     observe,    ///< [IN] SIMSERVER_OBSERVE_* value
+    simServer_Response_t*   rspPtr      ///< [OUT] Response
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until an observation received a number of notifications since it started
+ *
+ * @return
+ *  - LE_OK             The notifications are received
+ *  - LE_NOT_POSSIBLE   The path is not observed
+ *  - LE_TIMEOUT        Timeout
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_WaitNotifications
+(
+    simServer_DeviceRef_t   devRef,     ///< [IN] Device reference
+    const char*             pathPtr,    ///< [IN] Observed path
+    unsigned int            count,      ///< [IN] Number of notifications
+    uint32_t                timeoutMs,  ///< [IN] Timeout in milliseconds
+    simServer_Response_t*   rspPtr      ///< [OUT] Last notification
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the next registration update of a device
+ *
+ * @return
+ *  - LE_OK         The registration update is received
+ *  - LE_TIMEOUT    Timeout
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_WaitUpdate
+(
+    simServer_DeviceRef_t   devRef,     ///< [IN] Device reference
+    uint32_t                timeoutMs   ///< [IN] Timeout in milliseconds
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the deregistration of a device
+ *
+ * @return
+ *  - LE_OK         The device is deregistered
+ *  - LE_TIMEOUT    Timeout
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t simServer_WaitDeregistration
+(
+    simServer_DeviceRef_t   devRef,     ///< [IN] Device reference
+    uint32_t                timeoutMs   ///< [IN] Timeout in milliseconds
+);
+
+#endif /* _SIMSERVER_H */
@@ -0,0 +1,13 @@
+/**
+ * This module implements some stubs for natKeepalive unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _INTERFACES_H
+#define _INTERFACES_H
+
+#include "le_cfg_interface.h"
+
+#endif /* interfaces.h */
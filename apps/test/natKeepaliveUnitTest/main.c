@@ -0,0 +1,312 @@
+/**
+ * This module implements the unit tests for the NAT keepalive of the LwM2M session.
+ *
+ * The session goes through a simulated NAT whose bindings expire after a silence of 2.5 s, within
+ * the configured intervals of 1 to 4 s. The discovery and the keepalive are timed, so each step
+ * is checked after a delay. A session secured by DTLS discovers its interval with probes sent
+ * through the DTLS session.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "natKeepalive.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Binding timeout of the simulated NAT, and interval expected from the discovery
+ */
+//--------------------------------------------------------------------------------------------------
+#define NAT_TIMEOUT_MS          2500
+#define EXPECTED_INTERVAL       2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keys of the bearers and operators
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_KEY                "bearer6_20801"
+#define OTHER_KEY               "bearer21"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delays of the steps, in ms
+ */
+//--------------------------------------------------------------------------------------------------
+#define DISCOVERY_DELAY_MS      7500
+#define KEEPALIVE_DELAY_MS      4500
+#define STOP_DELAY_MS           3000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub functions
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetNatTimeout(uint64_t timeoutMs);
+void stub_SetSecured(bool isSecured);
+void stub_Register(void);
+uint32_t stub_GetPingCount(void);
+uint32_t stub_GetRebindCount(void);
+uint32_t stub_GetProbeCount(void);
+le_result_t stub_SendProbe(void);
+bool stub_GetCfgValue(const char* pathPtr, int32_t* valuePtr);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of lost bindings reported by the keepalive
+ */
+//--------------------------------------------------------------------------------------------------
+static int LostCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counters at the start of the current step
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t StepPingCount = 0;
+static uint32_t StepRebindCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer checking each step after its delay, and check of the current step
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t StepTimerRef;
+static void (*StepCheckFunc)(void) = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of a lost binding: the session registers again, as avcClient does
+ */
+//--------------------------------------------------------------------------------------------------
+static void BindingLostHandler
+(
+    void
+)
+{
+    LostCount++;
+    stub_Register();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the step after a delay
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckStep
+(
+    uint32_t delayMs,
+    void (*checkFunc)(void)
+)
+{
+    StepPingCount = stub_GetPingCount();
+    StepRebindCount = stub_GetRebindCount();
+    StepCheckFunc = checkFunc;
+    le_timer_SetMsInterval(StepTimerRef, delayMs);
+    le_timer_Start(StepTimerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop: no ping is sent once the session is closed
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckStop
+(
+    void
+)
+{
+    LE_ASSERT(StepPingCount == stub_GetPingCount());
+
+    LE_INFO("=============== natKeepaliveUnitTest successful ===================");
+    exit(EXIT_SUCCESS);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Secured keepalive: the empty datagrams keep the binding
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckSecuredKeepalive
+(
+    void
+)
+{
+    LE_ASSERT(stub_GetPingCount() >= StepPingCount + 2);
+    LE_ASSERT(StepRebindCount == stub_GetRebindCount());
+    LE_ASSERT(2 == LostCount);
+
+    natKeepalive_Stop();
+    stub_SetSecured(false);
+    CheckStep(STOP_DELAY_MS, CheckStop);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Secured session: the interval is discovered with the probes sent through the DTLS session, and
+ * no ping is sent in clear
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckSecured
+(
+    void
+)
+{
+    int32_t storedInterval = 0;
+
+    LE_ASSERT(!natKeepalive_IsDiscovering());
+    LE_ASSERT(EXPECTED_INTERVAL == natKeepalive_GetInterval());
+    LE_ASSERT(stub_GetCfgValue("intervals/" OTHER_KEY, &storedInterval));
+    LE_ASSERT(EXPECTED_INTERVAL == storedInterval);
+    LE_ASSERT(0 != stub_GetProbeCount());
+
+    // The candidate above the NAT timeout lost the binding once more
+    LE_ASSERT(2 == LostCount);
+
+    LE_INFO("======== Test secured keepalive ========");
+    CheckStep(KEEPALIVE_DELAY_MS, CheckSecuredKeepalive);
+}
+
+static void TestSecured
+(
+    void
+)
+{
+    LE_INFO("======== Test secured session ========");
+
+    stub_SetSecured(true);
+    stub_Register();
+    LE_ASSERT_OK(natKeepalive_Start(OTHER_KEY, stub_SendProbe, BindingLostHandler));
+    LE_ASSERT(natKeepalive_IsDiscovering());
+
+    CheckStep(DISCOVERY_DELAY_MS, CheckSecured);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stored interval: the next session on the same network does not discover again, another network
+ * has its own interval
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestStoredInterval
+(
+    void
+)
+{
+    LE_INFO("======== Test stored interval ========");
+
+    natKeepalive_Stop();
+    LE_ASSERT(0 == natKeepalive_GetInterval());
+
+    LE_ASSERT_OK(natKeepalive_Start(TEST_KEY, stub_SendProbe, BindingLostHandler));
+    LE_ASSERT(!natKeepalive_IsDiscovering());
+    LE_ASSERT(EXPECTED_INTERVAL == natKeepalive_GetInterval());
+
+    LE_ASSERT_OK(natKeepalive_Start(OTHER_KEY, stub_SendProbe, BindingLostHandler));
+    LE_ASSERT(natKeepalive_IsDiscovering());
+
+    natKeepalive_Stop();
+    LE_ASSERT(!natKeepalive_IsDiscovering());
+
+    TestSecured();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keepalive: the pings keep the binding
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckKeepalive
+(
+    void
+)
+{
+    LE_ASSERT(stub_GetPingCount() >= StepPingCount + 2);
+    LE_ASSERT(StepRebindCount == stub_GetRebindCount());
+    LE_ASSERT(1 == LostCount);
+
+    TestStoredInterval();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Discovery: the largest interval keeping the binding is found and stored
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckDiscovery
+(
+    void
+)
+{
+    int32_t storedInterval = 0;
+
+    LE_ASSERT(!natKeepalive_IsDiscovering());
+    LE_ASSERT(EXPECTED_INTERVAL == natKeepalive_GetInterval());
+    LE_ASSERT(stub_GetCfgValue("intervals/" TEST_KEY, &storedInterval));
+    LE_ASSERT(EXPECTED_INTERVAL == storedInterval);
+
+    // The candidate above the NAT timeout lost the binding once
+    LE_ASSERT(1 == LostCount);
+
+    LE_INFO("======== Test keepalive ========");
+    CheckStep(KEEPALIVE_DELAY_MS, CheckKeepalive);
+}
+
+static void TestDiscovery
+(
+    void
+)
+{
+    uint8_t ping[NAT_KEEPALIVE_PING_LEN] = { 0x70, 0x00, 0x00, 0x00 };
+
+    LE_INFO("======== Test discovery ========");
+
+    LE_ASSERT(LE_BAD_PARAMETER == natKeepalive_Start(NULL, stub_SendProbe, BindingLostHandler));
+    LE_ASSERT(LE_BAD_PARAMETER == natKeepalive_Start("", stub_SendProbe, BindingLostHandler));
+    LE_ASSERT(LE_BAD_PARAMETER == natKeepalive_Start("bearer/6", stub_SendProbe,
+                                                     BindingLostHandler));
+    LE_ASSERT(LE_BAD_PARAMETER == natKeepalive_Start(TEST_KEY, NULL, BindingLostHandler));
+    LE_ASSERT(0 == natKeepalive_GetInterval());
+
+    stub_Register();
+    LE_ASSERT_OK(natKeepalive_Start(TEST_KEY, stub_SendProbe, BindingLostHandler));
+    LE_ASSERT(natKeepalive_IsDiscovering());
+
+    // No ping is pending: the datagrams are for the LwM2M stack
+    LE_ASSERT(!natKeepalive_ReceiveMessage(ping, sizeof(ping)));
+    LE_ASSERT(!natKeepalive_ReceiveMessage(ping, 3));
+
+    CheckStep(DISCOVERY_DELAY_MS, CheckDiscovery);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Step timer handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void StepTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    StepCheckFunc();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the test.
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start natKeepaliveUnitTest ===================");
+
+    StepTimerRef = le_timer_Create("Step timer");
+    le_timer_SetHandler(StepTimerRef, StepTimerHandler);
+
+    stub_SetNatTimeout(NAT_TIMEOUT_MS);
+    natKeepalive_Init();
+    TestDiscovery();
+}
@@ -0,0 +1,477 @@
+/**
+ * This module implements some stubs for natKeepalive unit tests.
+ *
+ * The config tree holds short intervals and stores the discovered ones. The session socket sends
+ * through a simulated NAT: a binding expires after a configurable silence, and the next datagram
+ * then opens a new binding. The simulated server answers the pings through the binding of the
+ * session only, as a server keying its sessions on their address. A secured session does not answer
+ * the pings in clear: its probes are DTLS records, answered through the session binding only.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "natKeepalive.h"
+#include "osUdp.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configured intervals, resolution and probe timeout, in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_MIN_INTERVAL       1
+#define STUB_MAX_INTERVAL       4
+#define STUB_RESOLUTION         1
+#define STUB_PROBE_TIMEOUT      1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of values stored in the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_CFG_MAX_VALUES     4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Value stored in the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char    path[LE_CFG_STR_LEN_BYTES];     ///< Path relative to the transaction
+    int32_t value;                          ///< Value
+}
+CfgValue_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Values stored in the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+static CfgValue_t CfgValues[STUB_CFG_MAX_VALUES];
+static size_t CfgValueCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulated NAT: binding timeout, time of the last outbound datagram and current binding
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t NatTimeoutMs = 0;
+static uint64_t LastOutboundMs = 0;
+static uint32_t Binding = 0;
+static uint32_t RebindCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Binding known by the simulated server, and number of pings and of DTLS probes sent
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t SessionBinding = 0;
+static uint32_t PingCount = 0;
+static uint32_t ProbeCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is the session secured by DTLS?
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSecured = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current time in ms
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetTimeMs
+(
+    void
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+
+    return ((uint64_t)now.sec * 1000) + ((uint64_t)now.usec / 1000);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a datagram through the simulated NAT, a new binding is opened if the current one expired
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendOutbound
+(
+    void
+)
+{
+    uint64_t nowMs = GetTimeMs();
+
+    if ((0 == Binding) || ((nowMs - LastOutboundMs) > NatTimeoutMs))
+    {
+        if (Binding)
+        {
+            LE_INFO("NAT binding %"PRIu32" expired", Binding);
+            RebindCount++;
+        }
+        Binding++;
+    }
+    LastOutboundMs = nowMs;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deliver the answer of the simulated server to a ping
+ */
+//--------------------------------------------------------------------------------------------------
+static void DeliverReset
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    uint16_t messageId = (uint16_t)(uintptr_t)param1Ptr;
+    uint8_t reset[NAT_KEEPALIVE_PING_LEN] = { 0x70, 0x00,
+                                              (uint8_t)(messageId >> 8),
+                                              (uint8_t)(messageId & 0xFF) };
+
+    LE_ASSERT(natKeepalive_ReceiveMessage(reset, sizeof(reset)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the binding timeout of the simulated NAT
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetNatTimeout
+(
+    uint64_t timeoutMs
+)
+{
+    NatTimeoutMs = timeoutMs;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Secure the session by DTLS
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetSecured
+(
+    bool isSecured
+)
+{
+    IsSecured = isSecured;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deliver the answer of the simulated server to a DTLS probe: the record is for the DTLS layer
+ */
+//--------------------------------------------------------------------------------------------------
+static void DeliverRecord
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    uint8_t record[] = { 0x17, 0xFE, 0xFD, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07 };
+
+    LE_ASSERT(!natKeepalive_ReceiveMessage(record, sizeof(record)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a probe through the DTLS session, as the registration update of avcClient: the server only
+ * knows the DTLS session by the binding it registered from
+ *
+ * @return
+ *  - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t stub_SendProbe
+(
+    void
+)
+{
+    LE_ASSERT(IsSecured);
+
+    SendOutbound();
+    ProbeCount++;
+    natKeepalive_ReportSent();
+
+    if (Binding == SessionBinding)
+    {
+        le_event_QueueFunction(DeliverRecord, NULL, NULL);
+    }
+    else
+    {
+        LE_INFO("DTLS record from the unknown binding %"PRIu32" dropped by the server", Binding);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register to the simulated server: the server learns the current binding
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_Register
+(
+    void
+)
+{
+    SendOutbound();
+    SessionBinding = Binding;
+    natKeepalive_ReportSent();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of pings sent and of bindings expired
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t stub_GetPingCount
+(
+    void
+)
+{
+    return PingCount;
+}
+
+uint32_t stub_GetRebindCount
+(
+    void
+)
+{
+    return RebindCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of probes sent through the DTLS session
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t stub_GetProbeCount
+(
+    void
+)
+{
+    return ProbeCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value stored in the config tree at a path
+ *
+ * @return
+ *  - true if the value is stored
+ */
+//--------------------------------------------------------------------------------------------------
+bool stub_GetCfgValue
+(
+    const char* pathPtr,
+    int32_t* valuePtr
+)
+{
+    size_t i;
+
+    for (i = 0; i < CfgValueCount; i++)
+    {
+        if (0 == strcmp(CfgValues[i].path, pathPtr))
+        {
+            *valuePtr = CfgValues[i].value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Session socket stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * osUdp_SendPing() stub: the ping goes through the simulated NAT, an empty datagram is not answered
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t osUdp_SendPing
+(
+    const uint8_t* bufferPtr,
+    size_t len
+)
+{
+    uint16_t messageId;
+
+    if (0 == len)
+    {
+        LE_ASSERT(NULL == bufferPtr);
+        SendOutbound();
+        PingCount++;
+        return LE_OK;
+    }
+
+    // No ping in clear on a secured session
+    LE_ASSERT(!IsSecured);
+    LE_ASSERT(NAT_KEEPALIVE_PING_LEN == len);
+    LE_ASSERT(0x40 == bufferPtr[0]);
+    LE_ASSERT(0x00 == bufferPtr[1]);
+
+    SendOutbound();
+    PingCount++;
+
+    if (Binding == SessionBinding)
+    {
+        messageId = (uint16_t)((bufferPtr[2] << 8) | bufferPtr[3]);
+        le_event_QueueFunction(DeliverReset, (void*)(uintptr_t)messageId, NULL);
+    }
+    else
+    {
+        LE_INFO("Ping from the unknown binding %"PRIu32" dropped by the server", Binding);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * osUdp_IsSecured() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+bool osUdp_IsSecured
+(
+    void
+)
+{
+    return IsSecured;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Config Tree service stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_CreateReadTxn() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn
+(
+    const char* basePath
+)
+{
+    return (le_cfg_IteratorRef_t)1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_CreateWriteTxn() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_IteratorRef_t le_cfg_CreateWriteTxn
+(
+    const char* basePath
+)
+{
+    return (le_cfg_IteratorRef_t)2;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_GetInt() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+int32_t le_cfg_GetInt
+(
+    le_cfg_IteratorRef_t iteratorRef,
+    const char* path,
+    int32_t defaultValue
+)
+{
+    int32_t value;
+
+    if (0 == strcmp(path, "minInterval"))
+    {
+        return STUB_MIN_INTERVAL;
+    }
+
+    if (0 == strcmp(path, "maxInterval"))
+    {
+        return STUB_MAX_INTERVAL;
+    }
+
+    if (0 == strcmp(path, "resolution"))
+    {
+        return STUB_RESOLUTION;
+    }
+
+    if (0 == strcmp(path, "probeTimeout"))
+    {
+        return STUB_PROBE_TIMEOUT;
+    }
+
+    if (stub_GetCfgValue(path, &value))
+    {
+        return value;
+    }
+
+    return defaultValue;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_SetInt() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_SetInt
+(
+    le_cfg_IteratorRef_t iteratorRef,
+    const char* path,
+    int32_t value
+)
+{
+    size_t i;
+
+    for (i = 0; i < CfgValueCount; i++)
+    {
+        if (0 == strcmp(CfgValues[i].path, path))
+        {
+            CfgValues[i].value = value;
+            return;
+        }
+    }
+
+    LE_ASSERT(CfgValueCount < STUB_CFG_MAX_VALUES);
+    LE_ASSERT(LE_OK == le_utf8_Copy(CfgValues[CfgValueCount].path, path,
+                                    sizeof(CfgValues[CfgValueCount].path), NULL));
+    CfgValues[CfgValueCount].value = value;
+    CfgValueCount++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_CommitTxn() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_CommitTxn
+(
+    le_cfg_IteratorRef_t iteratorRef
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfg_CancelTxn() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_CancelTxn
+(
+    le_cfg_IteratorRef_t iteratorRef
+)
+{
+    return;
+}
@@ -0,0 +1,14 @@
+/**
+ * This module implements some stubs for osPortSecurity unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _INTERFACES_H
+#define _INTERFACES_H
+
+#include "le_avc_interface.h"
+#include "le_secStore_interface.h"
+
+#endif /* interfaces.h */
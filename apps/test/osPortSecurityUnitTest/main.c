@@ -0,0 +1,378 @@
+/**
+ * This module implements the unit tests for the credential management of osPortSecurity.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include <lwm2mcore/security.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of simulated connection cycles
+ */
+//--------------------------------------------------------------------------------------------------
+#define CONNECT_CYCLES          50
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Id of an additional server, with its own device management credentials
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_SERVER_ID          2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of a credential too large for the credential cache
+ */
+//--------------------------------------------------------------------------------------------------
+#define LARGE_CREDENTIAL_BYTES  600
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Provisioned device management credentials
+ */
+//--------------------------------------------------------------------------------------------------
+#define DM_IDENTITY             "359377060000000"
+#define DM_SECRET               "0123456789abcdef"
+#define DM_SECRET_NEW           "fedcba9876543210"
+#define DM_ADDRESS              "coaps://dm.example.com:5686"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub functions of the secure storage
+ */
+//--------------------------------------------------------------------------------------------------
+bool stub_IsInSecStore(const char* name);
+void stub_ProvisionSecStore(const char* name, const uint8_t* bufPtr, size_t bufSize);
+int stub_GetSecStoreReadCount(void);
+int stub_GetSecStoreWriteCount(void);
+int stub_GetSecStoreDeleteCount(void);
+void stub_ResetSecStoreCounters(void);
+uint8_t* stub_GetLastReadBuffer(void);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that a memory area is zeroized
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsZeroized
+(
+    const uint8_t*  dataPtr,    ///< [IN] Memory area
+    size_t          len         ///< [IN] Memory area length
+)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (dataPtr[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a credential and check its value
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckCredentialValue
+(
+    lwm2mcore_Credentials_t credId,     ///< [IN] Credential identifier
+    uint16_t                serverId,   ///< [IN] Server Id
+    const char*             valuePtr    ///< [IN] Expected value
+)
+{
+    char buffer[LWM2MCORE_PUBLICKEY_LEN];
+    size_t len = sizeof(buffer);
+
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_GetCredential(credId, serverId,
+                                                                    buffer, &len));
+    LE_ASSERT(strlen(valuePtr) == len);
+    LE_ASSERT(0 == memcmp(buffer, valuePtr, len));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate the credential accesses of a connection to the device management server: bootstrap
+ * credentials are checked first, then the device management credentials are used by the DTLS
+ * handshake.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ConnectCycle
+(
+    void
+)
+{
+    LE_ASSERT(!lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_BS_PUBLIC_KEY,
+                                         LWM2MCORE_NO_SERVER_ID));
+    LE_ASSERT(!lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_BS_SECRET_KEY,
+                                         LWM2MCORE_NO_SERVER_ID));
+    LE_ASSERT(lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_DM_PUBLIC_KEY, 1));
+    LE_ASSERT(lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1));
+    LE_ASSERT(lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_DM_ADDRESS, 1));
+
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_ADDRESS, 1, DM_ADDRESS);
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_PUBLIC_KEY, 1, DM_IDENTITY);
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1, DM_SECRET);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test: repeated connections only access the secure storage once per credential
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestConnectCycles
+(
+    void
+)
+{
+    int i;
+
+    LE_INFO("======== TestConnectCycles ========");
+
+    stub_ProvisionSecStore("/avms/LWM2M_DM_PSK_IDENTITY",
+                           (const uint8_t*)DM_IDENTITY, strlen(DM_IDENTITY));
+    stub_ProvisionSecStore("/avms/LWM2M_DM_PSK_SECRET",
+                           (const uint8_t*)DM_SECRET, strlen(DM_SECRET));
+    stub_ProvisionSecStore("/avms/LWM2M_DM_SERVER_ADDR",
+                           (const uint8_t*)DM_ADDRESS, strlen(DM_ADDRESS));
+    stub_ResetSecStoreCounters();
+
+    // First connection: each credential is read once, absent credentials included
+    ConnectCycle();
+    LE_ASSERT(5 == stub_GetSecStoreReadCount());
+
+    // Next connections are served by the presence bitmap and the credential cache
+    for (i = 1; i < CONNECT_CYCLES; i++)
+    {
+        ConnectCycle();
+    }
+    LE_ASSERT(5 == stub_GetSecStoreReadCount());
+    LE_ASSERT(0 == stub_GetSecStoreWriteCount());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test: setting and deleting a credential invalidate and zeroize its cached copy
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestEviction
+(
+    void
+)
+{
+    char buffer[LWM2MCORE_PUBLICKEY_LEN];
+    size_t len = sizeof(buffer);
+    uint8_t* slotPtr;
+
+    LE_INFO("======== TestEviction ========");
+
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_SetCredential(
+                                                        LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1,
+                                                        DM_SECRET, strlen(DM_SECRET)));
+    stub_ResetSecStoreCounters();
+
+    // The credential is read in the cache
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1, DM_SECRET);
+    LE_ASSERT(1 == stub_GetSecStoreReadCount());
+    slotPtr = stub_GetLastReadBuffer();
+    LE_ASSERT(NULL != slotPtr);
+    LE_ASSERT(0 == memcmp(slotPtr, DM_SECRET, strlen(DM_SECRET)));
+
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1, DM_SECRET);
+    LE_ASSERT(1 == stub_GetSecStoreReadCount());
+
+    // Update: the cached copy is zeroized and the new value is read
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_SetCredential(
+                                                        LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1,
+                                                        DM_SECRET_NEW, strlen(DM_SECRET_NEW)));
+    LE_ASSERT(IsZeroized(slotPtr, strlen(DM_SECRET)));
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1, DM_SECRET_NEW);
+    LE_ASSERT(2 == stub_GetSecStoreReadCount());
+    LE_ASSERT(slotPtr == stub_GetLastReadBuffer());
+
+    // Deletion: the cached copy is zeroized and the absence is known without reading
+    lwm2mcore_DeleteCredential(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1);
+    LE_ASSERT(IsZeroized(slotPtr, strlen(DM_SECRET_NEW)));
+    LE_ASSERT(!stub_IsInSecStore("/avms/LWM2M_DM_PSK_SECRET"));
+    LE_ASSERT(!lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1));
+    LE_ASSERT(LWM2MCORE_ERR_GENERAL_ERROR == lwm2mcore_GetCredential(
+                                                        LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1,
+                                                        buffer, &len));
+    LE_ASSERT(2 == stub_GetSecStoreReadCount());
+    LE_ASSERT(1 == stub_GetSecStoreDeleteCount());
+
+    // A caller buffer too small for the cached credential is rejected
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_SetCredential(
+                                                        LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1,
+                                                        DM_SECRET, strlen(DM_SECRET)));
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1, DM_SECRET);
+    len = strlen(DM_SECRET) - 1;
+    LE_ASSERT(LWM2MCORE_ERR_GENERAL_ERROR == lwm2mcore_GetCredential(
+                                                        LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1,
+                                                        buffer, &len));
+    LE_ASSERT(3 == stub_GetSecStoreReadCount());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test: the credentials of an additional server are tracked in their own namespace
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestServerNamespace
+(
+    void
+)
+{
+    LE_INFO("======== TestServerNamespace ========");
+
+    stub_ResetSecStoreCounters();
+
+    // The absence of the credentials of another server is learnt once
+    LE_ASSERT(!lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, TEST_SERVER_ID));
+    LE_ASSERT(!lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, TEST_SERVER_ID));
+    LE_ASSERT(1 == stub_GetSecStoreReadCount());
+
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_SetCredential(
+                                                        LWM2MCORE_CREDENTIAL_DM_SECRET_KEY,
+                                                        TEST_SERVER_ID,
+                                                        DM_SECRET_NEW, strlen(DM_SECRET_NEW)));
+    LE_ASSERT(stub_IsInSecStore("/avms/server2/LWM2M_DM_PSK_SECRET"));
+    LE_ASSERT(lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, TEST_SERVER_ID));
+    LE_ASSERT(1 == stub_GetSecStoreReadCount());
+
+    // Both servers get their own credential, from their own cache slot
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, TEST_SERVER_ID, DM_SECRET_NEW);
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, 1, DM_SECRET);
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_DM_SECRET_KEY, TEST_SERVER_ID, DM_SECRET_NEW);
+    LE_ASSERT(2 == stub_GetSecStoreReadCount());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test: an empty credential is present, and is not confused with an absent one
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestEmptyCredential
+(
+    void
+)
+{
+    char buffer[LWM2MCORE_PUBLICKEY_LEN];
+    size_t len;
+    int i;
+
+    LE_INFO("======== TestEmptyCredential ========");
+
+    stub_ProvisionSecStore("/avms/LWM2M_BOOTSTRAP_SERVER_ADDR", (const uint8_t*)"", 0);
+    stub_ResetSecStoreCounters();
+
+    // Every read of the empty credential succeeds, the secure storage is only read once
+    for (i = 0; i < 3; i++)
+    {
+        len = sizeof(buffer);
+        LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_GetCredential(
+                                                        LWM2MCORE_CREDENTIAL_BS_ADDRESS,
+                                                        LWM2MCORE_NO_SERVER_ID, buffer, &len));
+        LE_ASSERT(0 == len);
+    }
+    LE_ASSERT(!lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_BS_ADDRESS,
+                                         LWM2MCORE_NO_SERVER_ID));
+    LE_ASSERT(1 == stub_GetSecStoreReadCount());
+
+    // Setting a value replaces the empty credential
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_SetCredential(
+                                                        LWM2MCORE_CREDENTIAL_BS_ADDRESS,
+                                                        LWM2MCORE_NO_SERVER_ID,
+                                                        DM_ADDRESS, strlen(DM_ADDRESS)));
+    LE_ASSERT(lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_BS_ADDRESS,
+                                        LWM2MCORE_NO_SERVER_ID));
+    CheckCredentialValue(LWM2MCORE_CREDENTIAL_BS_ADDRESS, LWM2MCORE_NO_SERVER_ID, DM_ADDRESS);
+    LE_ASSERT(2 == stub_GetSecStoreReadCount());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test: package keys and credentials too large for the cache are always read from storage
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestUncachedCredentials
+(
+    void
+)
+{
+    uint8_t large[LARGE_CREDENTIAL_BYTES];
+    char buffer[LARGE_CREDENTIAL_BYTES];
+    size_t len;
+    int i;
+
+    LE_INFO("======== TestUncachedCredentials ========");
+
+    memset(large, 0xA5, sizeof(large));
+    stub_ProvisionSecStore("/avms/LWM2M_FW_KEY", large, sizeof(large));
+    stub_ProvisionSecStore("/avms/dm_server_public_key", large, sizeof(large));
+    stub_ResetSecStoreCounters();
+
+    for (i = 0; i < 3; i++)
+    {
+        len = sizeof(buffer);
+        LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_GetCredential(
+                                                        LWM2MCORE_CREDENTIAL_FW_KEY,
+                                                        LWM2MCORE_NO_SERVER_ID, buffer, &len));
+        LE_ASSERT(sizeof(large) == len);
+        LE_ASSERT(0 == memcmp(buffer, large, len));
+    }
+    LE_ASSERT(3 == stub_GetSecStoreReadCount());
+
+    // The first read does not fit in the cache slot and is retried in the caller buffer, the next
+    // ones go directly to the caller buffer
+    stub_ResetSecStoreCounters();
+    for (i = 0; i < 3; i++)
+    {
+        len = sizeof(buffer);
+        LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_GetCredential(
+                                                        LWM2MCORE_CREDENTIAL_DM_SERVER_PUBLIC_KEY,
+                                                        1, buffer, &len));
+        LE_ASSERT(sizeof(large) == len);
+        LE_ASSERT(0 == memcmp(buffer, large, len));
+    }
+    LE_ASSERT(4 == stub_GetSecStoreReadCount());
+    LE_ASSERT(lwm2mcore_CheckCredential(LWM2MCORE_CREDENTIAL_DM_SERVER_PUBLIC_KEY, 1));
+    LE_ASSERT(4 == stub_GetSecStoreReadCount());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the test.
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start osPortSecurityUnitTest =====================");
+
+    // Test - secure storage accesses under repeated connections
+    TestConnectCycles();
+
+    // Test - cache invalidation and zeroization
+    TestEviction();
+
+    // Test - credentials of an additional server
+    TestServerNamespace();
+
+    // Test - empty credential
+    TestEmptyCredential();
+
+    // Test - credentials not kept in the cache
+    TestUncachedCredentials();
+
+    LE_INFO("=============== osPortSecurityUnitTest successful ===================");
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,349 @@
+/**
+ * This module implements some stubs for osPortSecurity unit tests.
+ *
+ * The secure storage is stubbed with an in-memory table counting its accesses, and keeping the
+ * address of the last buffer used to read a credential.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "avcFs.h"
+#include "sslUtilities.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of entries in the stubbed secure storage
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_SECSTORE_MAX_ENTRIES   16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of an entry of the stubbed secure storage
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_SECSTORE_MAX_BYTES     1024
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Entry of the stubbed secure storage
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool    isUsed;                             ///< Is the entry used?
+    char    name[LE_SECSTORE_MAX_NAME_BYTES];   ///< Entry name
+    uint8_t data[STUB_SECSTORE_MAX_BYTES];      ///< Entry data
+    size_t  len;                                ///< Entry data length
+}
+SecStoreEntry_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed secure storage
+ */
+//--------------------------------------------------------------------------------------------------
+static SecStoreEntry_t SecStore[STUB_SECSTORE_MAX_ENTRIES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Secure storage access counters
+ */
+//--------------------------------------------------------------------------------------------------
+static int ReadCount = 0;
+static int WriteCount = 0;
+static int DeleteCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffer used by the last secure storage read
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t* LastReadBufferPtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find an entry of the stubbed secure storage
+ */
+//--------------------------------------------------------------------------------------------------
+static SecStoreEntry_t* FindEntry
+(
+    const char* name    ///< [IN] Entry name
+)
+{
+    int i;
+
+    for (i = 0; i < STUB_SECSTORE_MAX_ENTRIES; i++)
+    {
+        if ((SecStore[i].isUsed) && (0 == strcmp(SecStore[i].name, name)))
+        {
+            return &SecStore[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if an entry exists in the secure storage, without counting the access
+ */
+//--------------------------------------------------------------------------------------------------
+bool stub_IsInSecStore
+(
+    const char* name    ///< [IN] Entry name
+)
+{
+    return (NULL != FindEntry(name));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write an entry in the secure storage behind the back of the tested module, without counting
+ * the access
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_ProvisionSecStore
+(
+    const char*     name,       ///< [IN] Entry name
+    const uint8_t*  bufPtr,     ///< [IN] Entry data
+    size_t          bufSize     ///< [IN] Entry data length
+)
+{
+    LE_ASSERT(LE_OK == le_secStore_Write(name, bufPtr, bufSize));
+    WriteCount--;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of secure storage reads since the last reset
+ */
+//--------------------------------------------------------------------------------------------------
+int stub_GetSecStoreReadCount
+(
+    void
+)
+{
+    return ReadCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of secure storage writes since the last reset
+ */
+//--------------------------------------------------------------------------------------------------
+int stub_GetSecStoreWriteCount
+(
+    void
+)
+{
+    return WriteCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of secure storage deletions since the last reset
+ */
+//--------------------------------------------------------------------------------------------------
+int stub_GetSecStoreDeleteCount
+(
+    void
+)
+{
+    return DeleteCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the secure storage access counters
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_ResetSecStoreCounters
+(
+    void
+)
+{
+    ReadCount = 0;
+    WriteCount = 0;
+    DeleteCount = 0;
+    LastReadBufferPtr = NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the buffer used by the last secure storage read
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t* stub_GetLastReadBuffer
+(
+    void
+)
+{
+    return LastReadBufferPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Secure storage service stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_secStore_Write() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_secStore_Write
+(
+    const char* name,
+        ///< [IN]
+        ///< Name of the secure storage item.
+
+    const uint8_t* bufPtr,
+        ///< [IN]
+        ///< Buffer containing the data to store.
+
+    size_t bufSize
+        ///< [IN]
+)
+{
+    SecStoreEntry_t* entryPtr = FindEntry(name);
+    int i;
+
+    WriteCount++;
+
+    if (bufSize > STUB_SECSTORE_MAX_BYTES)
+    {
+        return LE_NO_MEMORY;
+    }
+
+    for (i = 0; (!entryPtr) && (i < STUB_SECSTORE_MAX_ENTRIES); i++)
+    {
+        if (!SecStore[i].isUsed)
+        {
+            entryPtr = &SecStore[i];
+            entryPtr->isUsed = true;
+            LE_ASSERT(LE_OK == le_utf8_Copy(entryPtr->name, name, sizeof(entryPtr->name), NULL));
+        }
+    }
+
+    if (!entryPtr)
+    {
+        return LE_NO_MEMORY;
+    }
+
+    memcpy(entryPtr->data, bufPtr, bufSize);
+    entryPtr->len = bufSize;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_secStore_Read() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_secStore_Read
+(
+    const char* name,
+        ///< [IN]
+        ///< Name of the secure storage item.
+
+    uint8_t* bufPtr,
+        ///< [OUT]
+        ///< Buffer to store the data in.
+
+    size_t* bufSizePtr
+        ///< [INOUT]
+)
+{
+    SecStoreEntry_t* entryPtr = FindEntry(name);
+
+    ReadCount++;
+    LastReadBufferPtr = bufPtr;
+
+    if (!entryPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (*bufSizePtr < entryPtr->len)
+    {
+        return LE_OVERFLOW;
+    }
+
+    memcpy(bufPtr, entryPtr->data, entryPtr->len);
+    *bufSizePtr = entryPtr->len;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_secStore_Delete() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_secStore_Delete
+(
+    const char* name
+        ///< [IN]
+        ///< Name of the secure storage item.
+)
+{
+    SecStoreEntry_t* entryPtr = FindEntry(name);
+
+    DeleteCount++;
+
+    if (!entryPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    memset(entryPtr, 0, sizeof(SecStoreEntry_t));
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+// File system and SSL utilities stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * WriteFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t WriteFs
+(
+    const char* pathPtr,   ///< File path
+    uint8_t*    bufPtr,    ///< Data buffer
+    size_t      size       ///< Buffer size
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * DeleteFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t DeleteFs
+(
+    const char* pathPtr    ///< File path
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * ssl_LayOutPEM() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+int ssl_LayOutPEM
+(
+    char*   strPtr,
+    int     strLen
+)
+{
+    return strLen;
+}
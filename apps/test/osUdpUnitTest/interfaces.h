@@ -0,0 +1,15 @@
+/**
+ * This module implements some stubs for osUdp unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _INTERFACES_H
+#define _INTERFACES_H
+
+#include "le_avc_interface.h"
+#include "le_mdc_interface.h"
+#include "le_data_interface.h"
+
+#endif /* interfaces.h */
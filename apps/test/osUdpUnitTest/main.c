@@ -0,0 +1,696 @@
+/**
+ * This module implements the unit tests for the source filtering of the LwM2M session socket.
+ *
+ * Two server sockets and a foreign sender send datagrams to the session socket on the loopback.
+ * The datagrams are delivered by the event loop, so each step is checked after a delay.
+ *
+ * The family fallback is tested with a dual-stack server answering on both loopback addresses from
+ * its own thread. Each family can drop the traffic. The session is reconnected by the test when the
+ * server does not answer, as the AVC client does.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include <arpa/inet.h>
+#include <poll.h>
+#include <lwm2mcore/lwm2mcore.h>
+#include <lwm2mcore/udp.h>
+#include "osUdp.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Local port of the session socket, must match the osUdp module
+ */
+//--------------------------------------------------------------------------------------------------
+#define SESSION_PORT        56830
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delay for the datagrams to be delivered, in ms
+ */
+//--------------------------------------------------------------------------------------------------
+#define DELIVERY_DELAY_MS   200
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rate limit of the rate limit test: datagrams per second and burst
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_RATE           1
+#define TEST_BURST          5
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Dual-stack server name, and answer timeout of the test
+ */
+//--------------------------------------------------------------------------------------------------
+#define DUAL_STACK_HOST     "dualstack.test"
+#define ANSWER_TIMEOUT_MS   500
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub functions
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetDualStack(bool isDualStack);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Session socket configuration
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_SocketConfig_t Config;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sockets of the servers and of the foreign sender
+ */
+//--------------------------------------------------------------------------------------------------
+static int Server1 = -1;
+static int Server2 = -1;
+static int Foreign = -1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sockets of the dual-stack server, IPv6 then IPv4, their port, and whether they drop the traffic
+ */
+//--------------------------------------------------------------------------------------------------
+static int DualStackServers[2] = { -1, -1 };
+static char DualStackPort[8];
+static volatile bool IsDropping[2] = { false, false };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of datagrams forwarded to the LwM2M stack
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t ReceivedCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Session to the dual-stack server: start of its first connection, first answer of the server
+ * (0 if none) and number of reconnections on the fallback family
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t SessionStartMs = 0;
+static uint64_t SessionAnswerMs = 0;
+static int FallbackCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer checking each step after its delay, and check of the current step
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t StepTimerRef;
+static void (*StepCheckFunc)(void) = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current time in ms
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetTimeMs
+(
+    void
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+
+    return ((uint64_t)now.sec * 1000) + ((uint64_t)now.usec / 1000);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * UDP callback of the LwM2M stack
+ */
+//--------------------------------------------------------------------------------------------------
+static void UdpReceive
+(
+    uint8_t* bufferPtr,
+    uint32_t len,
+    struct sockaddr_storage* addrPtr,
+    socklen_t addrLen,
+    lwm2mcore_SocketConfig_t config
+)
+{
+    ReceivedCount++;
+
+    if ((0 != SessionStartMs) && (0 == SessionAnswerMs))
+    {
+        SessionAnswerMs = GetTimeMs();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a sender socket on the loopback
+ */
+//--------------------------------------------------------------------------------------------------
+static int OpenSender
+(
+    void
+)
+{
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    LE_ASSERT(fd >= 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    LE_ASSERT(0 == bind(fd, (struct sockaddr*)&addr, sizeof(addr)));
+
+    return fd;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send datagrams to the session socket
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendFrom
+(
+    int fd,
+    int count
+)
+{
+    struct sockaddr_in addr;
+    int i;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(SESSION_PORT);
+
+    for (i = 0; i < count; i++)
+    {
+        LE_ASSERT(4 == sendto(fd, "ping", 4, 0, (struct sockaddr*)&addr, sizeof(addr)));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connect the session to a server, as the LwM2M stack does
+ */
+//--------------------------------------------------------------------------------------------------
+static void ConnectServer
+(
+    int fd
+)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    struct sockaddr_storage serverAddr;
+    socklen_t serverAddrLen = sizeof(serverAddr);
+    char url[64];
+    char host[] = "127.0.0.1";
+    char port[8];
+    int sock = -1;
+
+    LE_ASSERT(0 == getsockname(fd, (struct sockaddr*)&addr, &addrLen));
+    snprintf(port, sizeof(port), "%hu", ntohs(addr.sin_port));
+    // The servers are secured, as the DM servers
+    snprintf(url, sizeof(url), "coaps://%s:%s", host, port);
+
+    LE_ASSERT(lwm2mcore_UdpConnect(url, host, port, AF_INET, (struct sockaddr*)&serverAddr,
+                                   &serverAddrLen, &sock));
+    LE_ASSERT(sock >= 0);
+    close(sock);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Thread of the dual-stack server: the pings are answered by a reset, unless the family drops them
+ */
+//--------------------------------------------------------------------------------------------------
+static void* DualStackServerThread
+(
+    void* contextPtr
+)
+{
+    for (;;)
+    {
+        struct pollfd fds[2];
+        int i;
+
+        for (i = 0; i < 2; i++)
+        {
+            fds[i].fd = DualStackServers[i];
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+
+        if (poll(fds, 2, -1) <= 0)
+        {
+            continue;
+        }
+
+        for (i = 0; i < 2; i++)
+        {
+            struct sockaddr_storage addr;
+            socklen_t addrLen = sizeof(addr);
+            uint8_t buffer[64];
+            ssize_t numBytes;
+
+            if (0 == (fds[i].revents & POLLIN))
+            {
+                continue;
+            }
+
+            numBytes = recvfrom(DualStackServers[i], buffer, sizeof(buffer), 0,
+                                (struct sockaddr*)&addr, &addrLen);
+            if ((4 == numBytes) && (!IsDropping[i]))
+            {
+                buffer[0] = 0x70;
+                sendto(DualStackServers[i], buffer, 4, 0, (struct sockaddr*)&addr, addrLen);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the dual-stack server on the same port of both loopback addresses
+ */
+//--------------------------------------------------------------------------------------------------
+static void OpenDualStackServer
+(
+    void
+)
+{
+    struct sockaddr_in6 addr6;
+    struct sockaddr_in addr4;
+    socklen_t addrLen = sizeof(addr6);
+    int v6Only = 1;
+
+    DualStackServers[0] = socket(AF_INET6, SOCK_DGRAM, 0);
+    LE_ASSERT(DualStackServers[0] >= 0);
+    LE_ASSERT(0 == setsockopt(DualStackServers[0], IPPROTO_IPV6, IPV6_V6ONLY,
+                              &v6Only, sizeof(v6Only)));
+    memset(&addr6, 0, sizeof(addr6));
+    addr6.sin6_family = AF_INET6;
+    addr6.sin6_addr = in6addr_loopback;
+    LE_ASSERT(0 == bind(DualStackServers[0], (struct sockaddr*)&addr6, sizeof(addr6)));
+    LE_ASSERT(0 == getsockname(DualStackServers[0], (struct sockaddr*)&addr6, &addrLen));
+
+    DualStackServers[1] = socket(AF_INET, SOCK_DGRAM, 0);
+    LE_ASSERT(DualStackServers[1] >= 0);
+    memset(&addr4, 0, sizeof(addr4));
+    addr4.sin_family = AF_INET;
+    addr4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr4.sin_port = addr6.sin6_port;
+    LE_ASSERT(0 == bind(DualStackServers[1], (struct sockaddr*)&addr4, sizeof(addr4)));
+
+    snprintf(DualStackPort, sizeof(DualStackPort), "%hu", ntohs(addr6.sin6_port));
+    le_thread_Start(le_thread_Create("DualStackServer", DualStackServerThread, NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the step after a delay
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckStep
+(
+    uint32_t delayMs,
+    void (*checkFunc)(void)
+)
+{
+    StepCheckFunc = checkFunc;
+    le_timer_SetMsInterval(StepTimerRef, delayMs);
+    le_timer_Start(StepTimerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the session socket, connect it to the dual-stack server and send the first flight, as the
+ * LwM2M stack does. Check that the connection does not wait for the server, and the family used.
+ */
+//--------------------------------------------------------------------------------------------------
+static void OpenDualStackSession
+(
+    int family
+)
+{
+    struct sockaddr_storage serverAddr;
+    socklen_t serverAddrLen = sizeof(serverAddr);
+    struct sockaddr_in6* sin6Ptr = (struct sockaddr_in6*)&serverAddr;
+    uint8_t ping[4] = { 0x40, 0x00, 0x12, 0x34 };
+    char url[64];
+    char host[] = DUAL_STACK_HOST;
+    uint64_t startMs;
+    uint64_t durationMs;
+    int sock = -1;
+
+    snprintf(url, sizeof(url), "coap://%s:%s", host, DualStackPort);
+
+    LE_ASSERT(lwm2mcore_UdpOpen(NULL, UdpReceive, &Config));
+    startMs = GetTimeMs();
+    LE_ASSERT(lwm2mcore_UdpConnect(url, host, DualStackPort, AF_UNSPEC,
+                                   (struct sockaddr*)&serverAddr, &serverAddrLen, &sock));
+    durationMs = GetTimeMs() - startMs;
+    LE_ASSERT(sock >= 0);
+    close(sock);
+
+    // The dual-stack session socket reaches the IPv4 server through its IPv4-mapped address
+    LE_ASSERT(AF_INET6 == serverAddr.ss_family);
+    LE_INFO("Connected on %s in %"PRIu64" ms",
+            IN6_IS_ADDR_V4MAPPED(&sin6Ptr->sin6_addr) ? "IPv4" : "IPv6", durationMs);
+
+    LE_ASSERT((AF_INET == family) == IN6_IS_ADDR_V4MAPPED(&sin6Ptr->sin6_addr));
+    LE_ASSERT(durationMs < ANSWER_TIMEOUT_MS);
+
+    LE_ASSERT(sizeof(ping) == lwm2mcore_UdpSend(Config.sock, ping, sizeof(ping), 0,
+                                                (struct sockaddr*)&serverAddr, serverAddrLen));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reconnect the session when the server does not answer, as the AVC client does
+ */
+//--------------------------------------------------------------------------------------------------
+static void FamilyFallbackHandler
+(
+    void
+)
+{
+    int family = osUdp_GetPreferredFamily(DUAL_STACK_HOST, DualStackPort);
+
+    LE_INFO("Reconnecting on family %d", family);
+    FallbackCount++;
+
+    LE_ASSERT(lwm2mcore_UdpClose(Config));
+    OpenDualStackSession(family);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a session to the dual-stack server, which drops the traffic of the given families
+ */
+//--------------------------------------------------------------------------------------------------
+static void ConnectDualStack
+(
+    bool isIpv6Dropping,
+    bool isIpv4Dropping,
+    int family
+)
+{
+    IsDropping[0] = isIpv6Dropping;
+    IsDropping[1] = isIpv4Dropping;
+    FallbackCount = 0;
+    SessionAnswerMs = 0;
+    SessionStartMs = GetTimeMs();
+
+    OpenDualStackSession(family);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the session to the dual-stack server, and check the preferred family
+ */
+//--------------------------------------------------------------------------------------------------
+static void CloseDualStack
+(
+    int preferredFamily
+)
+{
+    LE_ASSERT(preferredFamily == osUdp_GetPreferredFamily(DUAL_STACK_HOST, DualStackPort));
+    LE_ASSERT(lwm2mcore_UdpClose(Config));
+    SessionStartMs = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that the first connection of the session recovered on the fallback family: the server
+ * answered within the answer timeout and the delivery delay
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckRecovery
+(
+    void
+)
+{
+    LE_ASSERT(1 == FallbackCount);
+    LE_ASSERT(0 != SessionAnswerMs);
+
+    LE_INFO("Recovered in %"PRIu64" ms", SessionAnswerMs - SessionStartMs);
+    LE_ASSERT(SessionAnswerMs - SessionStartMs >= ANSWER_TIMEOUT_MS);
+    LE_ASSERT(SessionAnswerMs - SessionStartMs < ANSWER_TIMEOUT_MS + DELIVERY_DELAY_MS);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Both families broken: the session falls back once, then waits for the LwM2M retransmissions
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckBothBroken
+(
+    void
+)
+{
+    LE_ASSERT(1 == FallbackCount);
+    LE_ASSERT(0 == SessionAnswerMs);
+    CloseDualStack(AF_INET6);
+
+    osUdp_SetFamilyFallback(ANSWER_TIMEOUT_MS, 1);
+    usleep(1100 * 1000);
+    LE_ASSERT(AF_UNSPEC == osUdp_GetPreferredFamily(DUAL_STACK_HOST, DualStackPort));
+
+    LE_INFO("=============== osUdpUnitTest successful ===================");
+    exit(EXIT_SUCCESS);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Broken IPv4: the first connection recovers at once on IPv6
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckIpv4Broken
+(
+    void
+)
+{
+    CheckRecovery();
+    CloseDualStack(AF_INET6);
+
+    ConnectDualStack(true, true, AF_INET6);
+    CheckStep((2 * ANSWER_TIMEOUT_MS) + DELIVERY_DELAY_MS, CheckBothBroken);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Broken IPv6: the first connection recovers at once on IPv4, which is preferred by the next
+ * connection
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckIpv6Broken
+(
+    void
+)
+{
+    CheckRecovery();
+    CloseDualStack(AF_INET);
+
+    ConnectDualStack(false, true, AF_INET);
+    CheckStep(ANSWER_TIMEOUT_MS + DELIVERY_DELAY_MS, CheckIpv4Broken);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * IPv6 answers: IPv6 is preferred
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckIpv6Answer
+(
+    void
+)
+{
+    LE_ASSERT(0 == FallbackCount);
+    LE_ASSERT(0 != SessionAnswerMs);
+    CloseDualStack(AF_INET6);
+
+    osUdp_ClearPreferredFamilies();
+    ConnectDualStack(true, false, AF_INET6);
+    CheckStep(ANSWER_TIMEOUT_MS + DELIVERY_DELAY_MS, CheckIpv6Broken);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Family fallback: the connection starts at once on the preferred family, IPv6 first, and the
+ * session reconnects on the other family when the server does not answer
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestFamilyFallback
+(
+    void
+)
+{
+    LE_INFO("======== Test family fallback ========");
+
+    stub_SetDualStack(true);
+    osUdp_SetFamilyFallback(ANSWER_TIMEOUT_MS, OS_UDP_DEFAULT_FAMILY_EXPIRY);
+    osUdp_SetFamilyFallbackHandler(FamilyFallbackHandler);
+    OpenDualStackServer();
+
+    ConnectDualStack(false, false, AF_INET6);
+    CheckStep(DELIVERY_DELAY_MS, CheckIpv6Answer);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the datagram counters
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckCounters
+(
+    uint64_t received,
+    uint64_t droppedForeign,
+    uint64_t droppedRateLimit
+)
+{
+    osUdp_Counters_t counters;
+
+    osUdp_GetCounters(&counters);
+    LE_INFO("Received %"PRIu64", dropped foreign %"PRIu64", dropped rate limit %"PRIu64,
+            counters.received, counters.droppedForeign, counters.droppedRateLimit);
+
+    LE_ASSERT(received == ReceivedCount);
+    LE_ASSERT(received == counters.received);
+    LE_ASSERT(droppedForeign == counters.droppedForeign);
+    LE_ASSERT(droppedRateLimit == counters.droppedRateLimit);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rate limit: the datagrams exceeding the burst of a server are dropped, the other server has its
+ * own bucket
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckRateLimit
+(
+    void
+)
+{
+    CheckCounters(3 + TEST_BURST + 1, 1, 3);
+
+    LE_ASSERT(lwm2mcore_UdpClose(Config));
+    LE_ASSERT(!osUdp_IsConnected());
+
+    TestFamilyFallback();
+}
+
+static void TestRateLimit
+(
+    void
+)
+{
+    LE_INFO("======== Test rate limit ========");
+
+    osUdp_SetRateLimit(TEST_RATE, TEST_BURST);
+    SendFrom(Server1, TEST_BURST + 3);
+    SendFrom(Server2, 1);
+    CheckStep(DELIVERY_DELAY_MS, CheckRateLimit);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allow-list: with two servers, the socket is not connected and the foreign datagram is dropped by
+ * the allow-list check
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckAllowList
+(
+    void
+)
+{
+    CheckCounters(3, 1, 0);
+    TestRateLimit();
+}
+
+static void TestAllowList
+(
+    void
+)
+{
+    LE_INFO("======== Test allow-list ========");
+
+    ConnectServer(Server2);
+    LE_ASSERT(!osUdp_IsConnected());
+
+    SendFrom(Server1, 1);
+    SendFrom(Server2, 1);
+    SendFrom(Foreign, 1);
+    CheckStep(DELIVERY_DELAY_MS, CheckAllowList);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connected socket: the foreign datagram is dropped by the kernel and never read
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckConnected
+(
+    void
+)
+{
+    CheckCounters(1, 0, 0);
+    TestAllowList();
+}
+
+static void TestConnected
+(
+    void
+)
+{
+    LE_INFO("======== Test connected socket ========");
+
+    LE_ASSERT(lwm2mcore_UdpOpen(NULL, UdpReceive, &Config));
+    LE_ASSERT(!osUdp_IsConnected());
+
+    ConnectServer(Server1);
+    LE_ASSERT(osUdp_IsConnected());
+
+    SendFrom(Server1, 1);
+    SendFrom(Foreign, 1);
+    CheckStep(DELIVERY_DELAY_MS, CheckConnected);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Step timer handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void StepTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    StepCheckFunc();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the test.
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start osUdpUnitTest ===================");
+
+    Server1 = OpenSender();
+    Server2 = OpenSender();
+    Foreign = OpenSender();
+
+    StepTimerRef = le_timer_Create("Step timer");
+    le_timer_SetHandler(StepTimerRef, StepTimerHandler);
+
+    // No rate limit until the rate limit test
+    osUdp_SetRateLimit(0, 0);
+    TestConnected();
+}
@@ -0,0 +1,253 @@
+/**
+ * This module implements some stubs for osUdp unit tests.
+ *
+ * The data connection is an IPv4 or dual-stack one with a default route, the traffic is not
+ * accounted and no keepalive runs. The name of the dual-stack test server resolves to both
+ * loopback addresses.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <dlfcn.h>
+#include <netdb.h>
+#include "legato.h"
+#include "interfaces.h"
+#include "trafficAccounting.h"
+#include "natKeepalive.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the dual-stack test server
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_DUAL_STACK_HOST    "dualstack.test"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is the data connection dual-stack?
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsDualStack = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the data connection dual-stack
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_SetDualStack
+(
+    bool isDualStack
+)
+{
+    IsDualStack = isDualStack;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Name resolution stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * getaddrinfo() stub: the dual-stack test server resolves to the IPv6 then the IPv4 loopback
+ * addresses, the other names are resolved by the C library. The list is freed by freeaddrinfo(),
+ * which frees the entries one by one.
+ */
+//--------------------------------------------------------------------------------------------------
+int getaddrinfo
+(
+    const char* nodePtr,
+    const char* servicePtr,
+    const struct addrinfo* hintsPtr,
+    struct addrinfo** resPtr
+)
+{
+    int (*realGetAddrInfo)(const char*, const char*, const struct addrinfo*, struct addrinfo**);
+    struct addrinfo* ipv6Ptr = NULL;
+    struct addrinfo* ipv4Ptr = NULL;
+    struct addrinfo* lastPtr;
+
+    realGetAddrInfo = dlsym(RTLD_NEXT, "getaddrinfo");
+    LE_ASSERT(NULL != realGetAddrInfo);
+
+    if ((NULL == nodePtr) || (0 != strcmp(nodePtr, STUB_DUAL_STACK_HOST)))
+    {
+        return realGetAddrInfo(nodePtr, servicePtr, hintsPtr, resPtr);
+    }
+
+    LE_ASSERT(0 == realGetAddrInfo("::1", servicePtr, hintsPtr, &ipv6Ptr));
+    LE_ASSERT(0 == realGetAddrInfo("127.0.0.1", servicePtr, hintsPtr, &ipv4Ptr));
+
+    for (lastPtr = ipv6Ptr; NULL != lastPtr->ai_next; lastPtr = lastPtr->ai_next)
+    {
+    }
+    lastPtr->ai_next = ipv4Ptr;
+    *resPtr = ipv6Ptr;
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Data connection stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_data_GetTechnology() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_data_Technology_t le_data_GetTechnology
+(
+    void
+)
+{
+    return LE_DATA_CELLULAR;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_data_GetCellularProfileIndex() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+int32_t le_data_GetCellularProfileIndex
+(
+    void
+)
+{
+    return 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_data_GetDefaultRouteStatus() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+bool le_data_GetDefaultRouteStatus
+(
+    void
+)
+{
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_data_AddRoute() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_data_AddRoute
+(
+    const char* ipDestAddrStr
+)
+{
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Modem data control stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_mdc_GetProfile() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_mdc_ProfileRef_t le_mdc_GetProfile
+(
+    uint32_t index
+)
+{
+    return (le_mdc_ProfileRef_t)0x1001;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_mdc_IsIPv4() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+bool le_mdc_IsIPv4
+(
+    le_mdc_ProfileRef_t profileRef
+)
+{
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_mdc_IsIPv6() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+bool le_mdc_IsIPv6
+(
+    le_mdc_ProfileRef_t profileRef
+)
+{
+    return IsDualStack;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Traffic accounting stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * trafficAccounting_Add() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_Add
+(
+    trafficAccounting_Purpose_t purpose,
+    size_t                      txBytes,
+    size_t                      rxBytes
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+// NAT keepalive stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * natKeepalive_Stop() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_Stop
+(
+    void
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * natKeepalive_ReportSent() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_ReportSent
+(
+    void
+)
+{
+    return;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * natKeepalive_ReceiveMessage() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+bool natKeepalive_ReceiveMessage
+(
+    const uint8_t* bufferPtr,
+    size_t len
+)
+{
+    return false;
+}
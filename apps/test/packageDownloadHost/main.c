@@ -7,51 +7,126 @@
  *
  */
 
+#include <sys/statvfs.h>
 #include "main.h"
 #include "packageDownloader.h"
+#include "packageDownloaderCallbacks.h"
+#include "downloadShaper.h"
 #include "limit.h"
+#include "powerLoss.h"
+#include "packagePush.h"
+#include "packageLocal.h"
+#include "packageMirror.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Maximum path length
+ * Package size
  */
 //--------------------------------------------------------------------------------------------------
-#define PATH_MAX_LENGTH    LWM2MCORE_PACKAGE_URI_MAX_BYTES
+#define PACKAGE_SIZE    1024
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Package size
+ * Absolute location of the firmware image to be sent to the modem
  */
 //--------------------------------------------------------------------------------------------------
-#define PACKAGE_SIZE    1024
+#define FWUPDATE_ABS_PATH_FILE     "/tmp/data/le_fs/firmware.bin"
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Relative location to the test download image
+ * Image start offset in bytes
  */
 //--------------------------------------------------------------------------------------------------
-#define DOWNLOAD_URI    "../data/test.dwl"
+#define CWE_IMAGE_START_OFFSET     0x140
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Absolute location of the firmware image to be sent to the modem
+ * Image signature size in bytes
  */
 //--------------------------------------------------------------------------------------------------
-#define FWUPDATE_ABS_PATH_FILE     "/tmp/data/le_fs/firmware.bin"
+#define CWE_IMAGE_SIGNATURE_SIZE    0x120
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Image start offset in bytes
+ * Download rate limit used to test the download shaper, in bytes per second
  */
 //--------------------------------------------------------------------------------------------------
-#define CWE_IMAGE_START_OFFSET     0x140
+#define SHAPER_RATE_LIMIT           1000
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Image signature size in bytes
+ * Daily budget used to test the download shaper, in bytes
  */
 //--------------------------------------------------------------------------------------------------
-#define CWE_IMAGE_SIGNATURE_SIZE    0x120
+#define SHAPER_DAILY_BUDGET         4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start time of the fake clock used to test the download shaper
+ */
+//--------------------------------------------------------------------------------------------------
+#define SHAPER_START_TIME           1500000000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of seconds in a day
+ */
+//--------------------------------------------------------------------------------------------------
+#define SECONDS_PER_DAY             86400
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Period used to wait for the end of a suspended download, in us, and maximum number of periods
+ */
+//--------------------------------------------------------------------------------------------------
+#define IDLE_POLL_PERIOD_US         10000
+#define IDLE_POLL_MAX_COUNT         1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Local packages derived from the test package, in the allowed directory: a copy, truncated to
+ * half of its size, and tampered with one byte modified in the middle of the image
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCAL_DIR                   "/tmp/packageLocal"
+#define LOCAL_PACKAGE_PATH          LOCAL_DIR "/package.dwl"
+#define LOCAL_TRUNCATED_PATH        LOCAL_DIR "/truncated.dwl"
+#define LOCAL_TAMPERED_PATH         LOCAL_DIR "/tampered.dwl"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sources of the mirrored packages: the package URI, an unreachable URI, a server mirror serving
+ * another package, a slow server mirror and a configured cache
+ */
+//--------------------------------------------------------------------------------------------------
+#define MIRROR_DIR                  "/tmp/packageMirror"
+#define MIRROR_ORIGIN_PATH          MIRROR_DIR "/origin.dwl"
+#define MIRROR_MISSING_PATH         MIRROR_DIR "/missing.dwl"
+#define MIRROR_OTHER_PATH           MIRROR_DIR "/other.dwl"
+#define MIRROR_SLOW_PATH            MIRROR_DIR "/slow.dwl"
+#define MIRROR_CACHE_BASE           MIRROR_DIR "/cache"
+#define MIRROR_CACHE_PATH           MIRROR_CACHE_BASE MIRROR_ORIGIN_PATH
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mirror configuration and injected faults: the slow mirror sends 1 KiB every 2 ms, below the low
+ * throughput, and the package URI fails after a few ranges
+ */
+//--------------------------------------------------------------------------------------------------
+#define MIRROR_RANGE_SIZE           (64 * 1024)
+#define MIRROR_LOW_THROUGHPUT       (2 * 1024 * 1024)
+#define MIRROR_SLOW_CHUNK_DELAY_US  2000
+#define MIRROR_ORIGIN_FAIL_OFFSET   (5 * MIRROR_RANGE_SIZE + 100)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Storage fixture: directory used for the admission checks and file preallocated in it
+ */
+//--------------------------------------------------------------------------------------------------
+#define STORAGE_FIXTURE_DIR         "/dev/shm"
+#define STORAGE_FIXTURE_FALLBACK    "/tmp"
+#define STORAGE_FIXTURE_FILE        "packageStorage.bin"
+#define STORAGE_FIXTURE_SIZE        (64 * 1024)
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -74,6 +149,64 @@ static le_sem_Ref_t SyncSemRef;
 //--------------------------------------------------------------------------------------------------
 DownloadResult_t DownloadResult;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fake clock used to test the download shaper
+ */
+//--------------------------------------------------------------------------------------------------
+static le_clk_Time_t FakeTime;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of calls to the download resume function
+ */
+//--------------------------------------------------------------------------------------------------
+static int ResumeCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Get the time of the fake clock
+ */
+//--------------------------------------------------------------------------------------------------
+static le_clk_Time_t FakeGetTime
+(
+    void
+)
+{
+    return FakeTime;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Wait on the fake clock: the time is advanced without sleeping
+ */
+//--------------------------------------------------------------------------------------------------
+static void FakeSleep
+(
+    le_clk_Time_t duration
+)
+{
+    FakeTime = le_clk_Add(FakeTime, duration);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Download resume function called by the download shaper
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResumeDownload
+(
+    const char*            uriPtr,
+    lwm2mcore_UpdateType_t type,
+    bool                   resume
+)
+{
+    LE_ASSERT(0 == strcmp(uriPtr, DOWNLOAD_URI));
+    LE_ASSERT(LWM2MCORE_FW_UPDATE_TYPE == type);
+    LE_ASSERT(true == resume);
+    ResumeCount++;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Notify the end of download
@@ -123,7 +256,7 @@ le_result_t GetExecPath(char* buffer)
  * Compare the downloaded file regarding the source file
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t CheckDownloadedFile
+le_result_t CheckDownloadedFile
 (
     char* sourceFilePath
 )
@@ -277,6 +410,607 @@ static void Check_DownloadRegularFw
     le_sem_Post(SyncSemRef);
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Push the test package, as written by the server in the Package resource
+ *
+ *  @return
+ *      The result of the write of the Package resource
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_Sid_t PushPackage
+(
+    void
+)
+{
+    char        path[PATH_MAX_LENGTH] = {0};
+    struct stat st;
+    char*       packagePtr;
+    lwm2mcore_Sid_t sid;
+    int         fd;
+
+    GetExecPath(path);
+
+    LE_ASSERT((strlen(path) + strlen(DOWNLOAD_URI)) < LWM2MCORE_PACKAGE_URI_MAX_BYTES);
+    strncat(path, DOWNLOAD_URI, strlen(DOWNLOAD_URI));
+
+    fd = open(path, O_RDONLY);
+    LE_ASSERT(-1 != fd);
+    LE_ASSERT(0 == fstat(fd, &st));
+
+    packagePtr = malloc((size_t)st.st_size);
+    LE_ASSERT(NULL != packagePtr);
+    LE_ASSERT(st.st_size == read(fd, packagePtr, (size_t)st.st_size));
+    close(fd);
+
+    // The package is copied: the buffer of the write is released when the write is answered
+    sid = lwm2mcore_PushUpdatePackage(LWM2MCORE_FW_UPDATE_TYPE, 0, packagePtr,
+                                      (size_t)st.st_size);
+    free(packagePtr);
+
+    return sid;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Wait for the end of a suspended download
+ */
+//--------------------------------------------------------------------------------------------------
+static void WaitDownloadSuspended
+(
+    void
+)
+{
+    int count = 0;
+
+    while (packageDownloader_IsDownloadInProgress())
+    {
+        LE_ASSERT(count++ < IDLE_POLL_MAX_COUNT);
+        usleep(IDLE_POLL_PERIOD_US);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Push a firmware package written in the Package resource.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_PushFw
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    char     uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES] = {0};
+    size_t   uriLen = sizeof(uri);
+    lwm2mcore_UpdateType_t type;
+
+    LE_INFO("Running test: %s\n", __func__);
+
+    // An invalid write is refused before the update is changed
+    LE_ASSERT(LWM2MCORE_ERR_INVALID_ARG == lwm2mcore_PushUpdatePackage(LWM2MCORE_FW_UPDATE_TYPE,
+                                                                       0, NULL, 1024));
+    LE_ASSERT(LWM2MCORE_ERR_INVALID_ARG == lwm2mcore_PushUpdatePackage(LWM2MCORE_MAX_UPDATE_TYPE,
+                                                                       0, uri, sizeof(uri)));
+    LE_ASSERT(false == packagePush_IsStarted());
+    LE_ASSERT(false == packageDownloader_IsDownloadInProgress());
+    LE_ASSERT_OK(packageDownloader_GetResumeInfo(uri, &uriLen, &type));
+    LE_ASSERT(false == packagePush_IsPushUri(uri));
+
+    // The completion is notified by the download thread
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == PushPackage());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Interrupt a pushed firmware package. The download is suspended before the package is
+ *  written in the pipe, which is done from the event loop of the test thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_PushFwInterrupted
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    LE_INFO("Running test: %s\n", __func__);
+
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == PushPackage());
+    LE_ASSERT(true == packagePush_IsStarted());
+
+    // A package is not accepted while another one is stored
+    LE_ASSERT(LWM2MCORE_ERR_INVALID_STATE == PushPackage());
+
+    LE_ASSERT_OK(packageDownloader_SuspendDownload());
+
+    le_sem_Post(SyncSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Resume the interrupted firmware package. The server pushes the whole package again, the
+ *  bytes already stored are dropped.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_PushFwResumed
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    char     uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES] = {0};
+    size_t   uriLen = sizeof(uri);
+    lwm2mcore_UpdateType_t type;
+
+    LE_INFO("Running test: %s\n", __func__);
+
+    LE_ASSERT(false == packagePush_IsStarted());
+
+    // The pushed package is resumed by the server only
+    LE_ASSERT_OK(packageDownloader_GetResumeInfo(uri, &uriLen, &type));
+    LE_ASSERT(true == packagePush_IsPushUri(uri));
+    LE_ASSERT(LWM2MCORE_FW_UPDATE_TYPE == type);
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_ResumePackageDownload());
+    LE_ASSERT(false == packageDownloader_IsDownloadInProgress());
+
+    // The completion is notified by the download thread
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == PushPackage());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Write the URI of a local package in the Package URI resource
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetLocalPackageUri
+(
+    const char* pathPtr         ///< [IN] Absolute path of the local package
+)
+{
+    char uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES] = {0};
+
+    LE_ASSERT((strlen(PACKAGELOCAL_FILE_SCHEME) + strlen(pathPtr)) < sizeof(uri));
+    snprintf(uri, sizeof(uri), "%s%s", PACKAGELOCAL_FILE_SCHEME, pathPtr);
+    LE_ASSERT(true == packageLocal_IsLocalUri(uri));
+
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_SetUpdatePackageUri(LWM2MCORE_FW_UPDATE_TYPE,
+              0, uri, strlen(uri)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Wait for the end of a failed download: the update result is set and the download ended
+ */
+//--------------------------------------------------------------------------------------------------
+static void WaitDownloadFailed
+(
+    void
+)
+{
+    lwm2mcore_FwUpdateResult_t fwUpdateResult = LWM2MCORE_FW_UPDATE_RESULT_DEFAULT_NORMAL;
+    int count = 0;
+
+    while (   (LE_OK != packageDownloader_GetFwUpdateResult(&fwUpdateResult))
+           || (LWM2MCORE_FW_UPDATE_RESULT_DEFAULT_NORMAL == fwUpdateResult)
+           || (packageDownloader_IsDownloadInProgress()))
+    {
+        LE_ASSERT(count++ < IDLE_POLL_MAX_COUNT);
+        usleep(IDLE_POLL_PERIOD_US);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Install a firmware package from a local file.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_LocalFw
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    char     path[PATH_MAX_LENGTH] = {0};
+    uint64_t packageSize = 0;
+    char     uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES] = {0};
+
+    LE_INFO("Running test: %s\n", __func__);
+
+    GetExecPath(path);
+
+    LE_ASSERT((strlen(path) + strlen(DOWNLOAD_URI)) < LWM2MCORE_PACKAGE_URI_MAX_BYTES);
+    strncat(path, DOWNLOAD_URI, strlen(DOWNLOAD_URI));
+
+    // Only absolute paths are accepted
+    LE_ASSERT(LE_BAD_PARAMETER == packageLocal_GetPackageSize(PACKAGELOCAL_FILE_SCHEME DOWNLOAD_URI,
+                                                              &packageSize));
+
+    // Only packages in the allowed directory are accepted, '..' components included
+    snprintf(uri, sizeof(uri), "%s%s", PACKAGELOCAL_FILE_SCHEME, path);
+    LE_ASSERT(LE_NOT_PERMITTED == packageLocal_GetPackageSize(uri, &packageSize));
+    LE_ASSERT((strlen(PACKAGELOCAL_FILE_SCHEME LOCAL_DIR "/../..") + strlen(path)) < sizeof(uri));
+    snprintf(uri, sizeof(uri), "%s%s/../..%s", PACKAGELOCAL_FILE_SCHEME, LOCAL_DIR, path);
+    LE_ASSERT(LE_NOT_PERMITTED == packageLocal_GetPackageSize(uri, &packageSize));
+
+    CreateLocalPackage(LOCAL_PACKAGE_PATH, false, false);
+    snprintf(uri, sizeof(uri), "%s%s", PACKAGELOCAL_FILE_SCHEME, LOCAL_PACKAGE_PATH);
+    LE_ASSERT_OK(packageLocal_GetPackageSize(uri, &packageSize));
+    LE_ASSERT(packageSize > 0);
+
+    // The completion is notified by the download thread
+    SetLocalPackageUri(LOCAL_PACKAGE_PATH);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Install a truncated firmware package from a local file. The download fails.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_LocalFwTruncated
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    LE_INFO("Running test: %s\n", __func__);
+
+    LE_ASSERT(LE_BAD_PARAMETER == packageLocal_SetAllowedDir("tmp"));
+    LE_ASSERT_OK(le_dir_MakePath(LOCAL_DIR, S_IRWXU));
+    LE_ASSERT_OK(packageLocal_SetAllowedDir(LOCAL_DIR));
+
+    CreateLocalPackage(LOCAL_TRUNCATED_PATH, true, false);
+    SetLocalPackageUri(LOCAL_TRUNCATED_PATH);
+
+    le_sem_Post(SyncSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Install a tampered firmware package from a local file. The package is rejected by the
+ *  package verification.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_LocalFwTampered
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    LE_INFO("Running test: %s\n", __func__);
+
+    CreateLocalPackage(LOCAL_TAMPERED_PATH, false, true);
+    SetLocalPackageUri(LOCAL_TAMPERED_PATH);
+
+    le_sem_Post(SyncSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  This function checks the results of a failed local package: the failure is reported in the
+ *  firmware update object as for a remote download.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Check_LocalFwFailed
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    lwm2mcore_FwUpdateState_t fwUpdateState;
+    lwm2mcore_FwUpdateResult_t fwUpdateResult;
+
+    LE_ASSERT_OK(packageDownloader_GetFwUpdateState(&fwUpdateState));
+    LE_ASSERT(LWM2MCORE_FW_UPDATE_STATE_DOWNLOADED != fwUpdateState);
+    LE_ASSERT_OK(packageDownloader_GetFwUpdateResult(&fwUpdateResult));
+    LE_ASSERT(LWM2MCORE_FW_UPDATE_RESULT_DEFAULT_NORMAL != fwUpdateResult);
+    LE_ASSERT(false == packageDownloader_IsDownloadInProgress());
+
+    le_sem_Post(SyncSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Set the mirror configuration used by the tests, with or without the configured cache
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetMirrorConfig
+(
+    bool hasCache               ///< [IN] Configure the cache as a mirror
+)
+{
+    packageMirror_Config_t config;
+
+    memset(&config, 0, sizeof(config));
+    if (hasCache)
+    {
+        strcpy(config.baseUri[0], MIRROR_CACHE_BASE);
+    }
+    config.rangeSize = MIRROR_RANGE_SIZE;
+    config.lowThroughput = MIRROR_LOW_THROUGHPUT;
+
+    LE_ASSERT_OK(packageMirror_SetConfig(&config));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Write the URI of a mirrored package in the Package URI resource
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetMirroredPackageUri
+(
+    const char* uriPtr          ///< [IN] Package URI, with the server mirrors in its fragment
+)
+{
+    LE_ASSERT(strlen(uriPtr) < LWM2MCORE_PACKAGE_URI_MAX_BYTES);
+    LE_ASSERT(LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_SetUpdatePackageUri(LWM2MCORE_FW_UPDATE_TYPE,
+              0, (char*)uriPtr, strlen(uriPtr)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Build the source lists and select the sources according to their health
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_MirrorList
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    packageMirror_Config_t config;
+    packageMirror_Config_t defaultConfig;
+    packageMirror_List_t list;
+    int i;
+
+    LE_INFO("Running test: %s\n", __func__);
+
+    LE_ASSERT_OK(packageMirror_GetConfig(&defaultConfig));
+    LE_ASSERT(LE_BAD_PARAMETER == packageMirror_GetConfig(NULL));
+    LE_ASSERT(LE_BAD_PARAMETER == packageMirror_SetConfig(NULL));
+
+    memset(&config, 0, sizeof(config));
+    config.rangeSize = PACKAGEMIRROR_MIN_RANGE_SIZE - 1;
+    LE_ASSERT(LE_BAD_PARAMETER == packageMirror_SetConfig(&config));
+
+    config.rangeSize = PACKAGEMIRROR_MIN_RANGE_SIZE;
+    config.lowThroughput = 1000;
+    strcpy(config.baseUri[0], "http://cache.local/");
+    strcpy(config.baseUri[2], "http://proxy.local");
+    LE_ASSERT_OK(packageMirror_SetConfig(&config));
+
+    // Package URI, server mirrors without duplicates, then configured mirrors
+    LE_ASSERT(LE_BAD_PARAMETER == packageMirror_BuildList(NULL, &list));
+    LE_ASSERT(LE_BAD_PARAMETER == packageMirror_BuildList("", &list));
+    LE_ASSERT(LE_BAD_PARAMETER ==
+              packageMirror_BuildList(PACKAGEMIRROR_FRAGMENT "http://a", &list));
+    LE_ASSERT_OK(packageMirror_BuildList("https://server.com/pkg/fw.dwl" PACKAGEMIRROR_FRAGMENT
+                                         "http://m1.com/fw.dwl,,https://server.com/pkg/fw.dwl,"
+                                         "http://m2.com/fw.dwl", &list));
+    LE_ASSERT(5 == list.count);
+    LE_ASSERT(0 == list.current);
+    LE_ASSERT(0 == strcmp("https://server.com/pkg/fw.dwl", packageMirror_GetCurrentUri(&list)));
+    LE_ASSERT(PACKAGEMIRROR_ORIGIN_PACKAGE_URI == list.source[0].origin);
+    LE_ASSERT(0 == strcmp("http://m1.com/fw.dwl", list.source[1].uri));
+    LE_ASSERT(PACKAGEMIRROR_ORIGIN_SERVER == list.source[1].origin);
+    LE_ASSERT(0 == strcmp("http://m2.com/fw.dwl", list.source[2].uri));
+    LE_ASSERT(PACKAGEMIRROR_ORIGIN_SERVER == list.source[2].origin);
+    LE_ASSERT(0 == strcmp("http://cache.local/pkg/fw.dwl", list.source[3].uri));
+    LE_ASSERT(PACKAGEMIRROR_ORIGIN_CONFIG == list.source[3].origin);
+    LE_ASSERT(0 == strcmp("http://proxy.local/pkg/fw.dwl", list.source[4].uri));
+
+    // Another fragment is not a mirror list
+    LE_ASSERT_OK(packageMirror_BuildList("http://server.com/fw.dwl#part", &list));
+    LE_ASSERT(3 == list.count);
+    LE_ASSERT(0 == strcmp("http://server.com/fw.dwl", list.source[0].uri));
+
+    // A slow source is left for the next source not measured yet
+    packageMirror_RecordRange(&list, 500, 1000);
+    LE_ASSERT(500 == list.source[0].throughput);
+    LE_ASSERT(true == packageMirror_SelectAfterRange(&list));
+    LE_ASSERT(1 == list.current);
+    packageMirror_RecordRange(&list, 200, 1000);
+    LE_ASSERT(true == packageMirror_SelectAfterRange(&list));
+    LE_ASSERT(2 == list.current);
+
+    // All the sources are slow: back to a faster one
+    packageMirror_RecordRange(&list, 100, 1000);
+    LE_ASSERT(true == packageMirror_SelectAfterRange(&list));
+    LE_ASSERT(0 == list.current);
+
+    // A fast source is kept, until a source twice as fast is measured
+    packageMirror_RecordRange(&list, 4000, 1000);
+    LE_ASSERT(2250 == list.source[0].throughput);
+    LE_ASSERT(false == packageMirror_SelectAfterRange(&list));
+    LE_ASSERT(0 == list.current);
+    list.source[1].throughput = 10000;
+    LE_ASSERT(true == packageMirror_SelectAfterRange(&list));
+    LE_ASSERT(1 == list.current);
+
+    // A source failing with a fatal error is not used anymore
+    packageMirror_RecordFailure(&list, 100, true);
+    LE_ASSERT(true == list.source[1].isDisabled);
+    LE_ASSERT(300 == list.source[1].bytes);
+    LE_ASSERT_OK(packageMirror_SelectAfterFailure(&list));
+    LE_ASSERT(2 == list.current);
+
+    // A source failing too many times in a row is not used anymore
+    for (i = 0; i < PACKAGEMIRROR_MAX_FAILURES; i++)
+    {
+        LE_ASSERT(false == list.source[2].isDisabled);
+        list.current = 2;
+        packageMirror_RecordFailure(&list, 0, false);
+        LE_ASSERT_OK(packageMirror_SelectAfterFailure(&list));
+    }
+    LE_ASSERT(true == list.source[2].isDisabled);
+    LE_ASSERT(PACKAGEMIRROR_MAX_FAILURES == list.source[2].failures);
+    LE_ASSERT(0 == list.current);
+
+    // A range resets the consecutive failures
+    packageMirror_RecordFailure(&list, 0, false);
+    LE_ASSERT(1 == list.source[0].consecutiveFailures);
+    LE_ASSERT_OK(packageMirror_SelectAfterFailure(&list));
+    LE_ASSERT(0 == list.current);
+    packageMirror_RecordRange(&list, 4000, 1000);
+    LE_ASSERT(0 == list.source[0].consecutiveFailures);
+    LE_ASSERT(1 == list.source[0].failures);
+
+    for (i = 0; i < (int)list.count; i++)
+    {
+        list.current = i;
+        packageMirror_RecordFailure(&list, 0, true);
+    }
+    LE_ASSERT(LE_NOT_FOUND == packageMirror_SelectAfterFailure(&list));
+
+    LE_ASSERT_OK(packageMirror_SetConfig(&defaultConfig));
+
+    le_sem_Post(SyncSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Download a firmware package from several sources. The package URI fails after a few
+ *  ranges, the first server mirror serves another package, the second one is too slow and the
+ *  package is completed from the configured cache.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_MirrorFailover
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    LE_INFO("Running test: %s\n", __func__);
+
+    LE_ASSERT_OK(le_dir_MakePath(MIRROR_CACHE_BASE MIRROR_DIR, S_IRWXU));
+    CreateLocalPackage(MIRROR_ORIGIN_PATH, false, false);
+    CreateLocalPackage(MIRROR_OTHER_PATH, true, false);
+    CreateLocalPackage(MIRROR_SLOW_PATH, false, false);
+    CreateLocalPackage(MIRROR_CACHE_PATH, false, false);
+
+    SetCurlFixture(MIRROR_ORIGIN_PATH, 0, MIRROR_ORIGIN_FAIL_OFFSET);
+    SetCurlFixture(MIRROR_SLOW_PATH, MIRROR_SLOW_CHUNK_DELAY_US, 0);
+    SetMirrorConfig(true);
+
+    // The completion is notified by the download thread
+    SetMirroredPackageUri(MIRROR_ORIGIN_PATH PACKAGEMIRROR_FRAGMENT
+                          MIRROR_OTHER_PATH "," MIRROR_SLOW_PATH);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  This function checks the health recorded for the sources of the failover test
+ */
+//--------------------------------------------------------------------------------------------------
+static void Check_MirrorFailover
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    packageMirror_Source_t origin;
+    packageMirror_Source_t other;
+    packageMirror_Source_t slow;
+    packageMirror_Source_t cache;
+    packageMirror_Source_t source;
+    struct stat st;
+
+    LE_ASSERT(0 == stat(MIRROR_ORIGIN_PATH, &st));
+
+    LE_ASSERT(LE_BAD_PARAMETER == pkgDwlCb_GetSource(0, NULL));
+    LE_ASSERT_OK(pkgDwlCb_GetSource(0, &origin));
+    LE_ASSERT_OK(pkgDwlCb_GetSource(1, &other));
+    LE_ASSERT_OK(pkgDwlCb_GetSource(2, &slow));
+    LE_ASSERT_OK(pkgDwlCb_GetSource(3, &cache));
+    LE_ASSERT(LE_OUT_OF_RANGE == pkgDwlCb_GetSource(4, &source));
+
+    LE_ASSERT(0 == strcmp(MIRROR_CACHE_PATH, cache.uri));
+    LE_ASSERT(PACKAGEMIRROR_ORIGIN_CONFIG == cache.origin);
+
+    // The package URI served the first ranges, up to its failure
+    LE_ASSERT(origin.failures >= 1);
+    LE_ASSERT(origin.bytes >= MIRROR_ORIGIN_FAIL_OFFSET);
+
+    // The mirror serving another package was not used
+    LE_ASSERT(false == other.isVerified);
+    LE_ASSERT(true == other.isDisabled);
+    LE_ASSERT(0 == other.bytes);
+
+    // The slow mirror was left after its first range
+    LE_ASSERT(slow.isVerified);
+    LE_ASSERT(slow.ranges >= 1);
+    LE_ASSERT(slow.throughput < MIRROR_LOW_THROUGHPUT);
+
+    // The cache completed the package
+    LE_ASSERT(cache.isVerified);
+    LE_ASSERT(0 == cache.failures);
+    LE_ASSERT(cache.bytes > 0);
+
+    LE_ASSERT((origin.bytes + other.bytes + slow.bytes + cache.bytes) == (uint64_t)st.st_size);
+
+    SetCurlFixture(MIRROR_ORIGIN_PATH, 0, 0);
+    SetCurlFixture(MIRROR_SLOW_PATH, 0, 0);
+
+    le_sem_Post(SyncSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test: Download a firmware package whose URI is unreachable from a server mirror
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_MirrorUnreachable
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    LE_INFO("Running test: %s\n", __func__);
+
+    unlink(MIRROR_MISSING_PATH);
+    SetMirrorConfig(false);
+
+    // The completion is notified by the download thread
+    SetMirroredPackageUri(MIRROR_MISSING_PATH PACKAGEMIRROR_FRAGMENT MIRROR_ORIGIN_PATH);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  This function checks the health recorded for the sources of the unreachable URI test
+ */
+//--------------------------------------------------------------------------------------------------
+static void Check_MirrorUnreachable
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    packageMirror_Config_t config;
+    packageMirror_Source_t missing;
+    packageMirror_Source_t origin;
+    struct stat st;
+
+    LE_ASSERT(0 == stat(MIRROR_ORIGIN_PATH, &st));
+
+    LE_ASSERT_OK(pkgDwlCb_GetSource(0, &missing));
+    LE_ASSERT_OK(pkgDwlCb_GetSource(1, &origin));
+    LE_ASSERT(LE_OUT_OF_RANGE == pkgDwlCb_GetSource(2, &origin));
+
+    LE_ASSERT(true == missing.isDisabled);
+    LE_ASSERT(1 == missing.failures);
+    LE_ASSERT(0 == missing.bytes);
+    LE_ASSERT(0 == origin.failures);
+    LE_ASSERT((uint64_t)st.st_size == origin.bytes);
+
+    // Restore the default configuration
+    memset(&config, 0, sizeof(config));
+    config.rangeSize = PACKAGEMIRROR_DEFAULT_RANGE_SIZE;
+    config.lowThroughput = PACKAGEMIRROR_DEFAULT_LOW_THROUGHPUT;
+    LE_ASSERT_OK(packageMirror_SetConfig(&config));
+    LE_ASSERT_OK(le_dir_RemoveRecursive(MIRROR_DIR));
+
+    le_sem_Post(SyncSemRef);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Test 2: Test packageDownloader_SetFwUpdateState() and packageDownloader_GetFwUpdateState().
@@ -609,6 +1343,221 @@ static void Test_BytesLeftToDownload
     le_sem_Post(SyncSemRef);
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test the download shaper rate limit per bearer, using a fake clock.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_ShaperRateLimit
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    downloadShaper_Config_t config;
+
+    LE_INFO("Running test: %s\n", __func__);
+
+    memset(&config, 0, sizeof(config));
+    config.rateLimit[DOWNLOADSHAPER_BEARER_CELLULAR] = SHAPER_RATE_LIMIT;
+    config.isMetered[DOWNLOADSHAPER_BEARER_CELLULAR] = true;
+
+    FakeTime.sec = SHAPER_START_TIME;
+    FakeTime.usec = 0;
+    downloadShaper_SetClock(FakeGetTime, FakeSleep);
+    downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_CELLULAR);
+
+    LE_ASSERT(LE_BAD_PARAMETER == downloadShaper_SetConfig(NULL));
+    LE_ASSERT_OK(downloadShaper_SetConfig(&config));
+
+    // The bucket is full: one second worth of data is received without waiting
+    downloadShaper_Throttle(SHAPER_RATE_LIMIT);
+    LE_ASSERT(SHAPER_START_TIME == FakeTime.sec);
+    LE_ASSERT(0 == FakeTime.usec);
+
+    // The bucket is empty: wait for half a second, then for one and a half second
+    downloadShaper_Throttle(SHAPER_RATE_LIMIT / 2);
+    LE_ASSERT(SHAPER_START_TIME == FakeTime.sec);
+    LE_ASSERT(500000 == FakeTime.usec);
+    downloadShaper_Throttle((3 * SHAPER_RATE_LIMIT) / 2);
+    LE_ASSERT((SHAPER_START_TIME + 2) == FakeTime.sec);
+    LE_ASSERT(0 == FakeTime.usec);
+
+    // Tokens are refilled while the download is idle
+    FakeTime.sec += 1;
+    downloadShaper_Throttle(SHAPER_RATE_LIMIT);
+    LE_ASSERT((SHAPER_START_TIME + 3) == FakeTime.sec);
+
+    // No limit on Wi-Fi
+    downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_WIFI);
+    LE_ASSERT(DOWNLOADSHAPER_BEARER_WIFI == downloadShaper_GetBearer());
+    downloadShaper_Throttle(100 * SHAPER_RATE_LIMIT);
+    LE_ASSERT((SHAPER_START_TIME + 3) == FakeTime.sec);
+
+    // Back to cellular: the bucket is restarted
+    downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_CELLULAR);
+    downloadShaper_Throttle(2 * SHAPER_RATE_LIMIT);
+    LE_ASSERT((SHAPER_START_TIME + 4) == FakeTime.sec);
+
+    le_sem_Post(SyncSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test the storage admission and the preallocation of the stored packages. The sizes are derived
+ *  from the free space of the fixture filesystem.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_StorageAdmission
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    const char* dirPtr = STORAGE_FIXTURE_DIR;
+    char        path[PATH_MAX_LENGTH] = {0};
+    struct statvfs fsInfo;
+    struct stat fileStat;
+    uint64_t    freeBytes;
+    le_result_t result;
+    int         fd;
+
+    LE_INFO("Running test: %s\n", __func__);
+
+    if (-1 == statvfs(dirPtr, &fsInfo))
+    {
+        dirPtr = STORAGE_FIXTURE_FALLBACK;
+        LE_ASSERT(0 == statvfs(dirPtr, &fsInfo));
+    }
+    freeBytes = (uint64_t)fsInfo.f_bavail * (uint64_t)fsInfo.f_frsize;
+    LE_ASSERT(freeBytes > (PACKAGEDOWNLOADER_STORAGE_MARGIN + STORAGE_FIXTURE_SIZE));
+
+    // Admission: the storage margin is kept free
+    LE_ASSERT(LE_BAD_PARAMETER == packageDownloader_CheckStorage(NULL, STORAGE_FIXTURE_SIZE));
+    LE_ASSERT(LE_BAD_PARAMETER == packageDownloader_CheckStorage("download",
+                                                                 STORAGE_FIXTURE_SIZE));
+    LE_ASSERT_OK(packageDownloader_CheckStorage(dirPtr, STORAGE_FIXTURE_SIZE));
+    LE_ASSERT(LE_NO_MEMORY == packageDownloader_CheckStorage(dirPtr, freeBytes));
+    LE_ASSERT(LE_NO_MEMORY == packageDownloader_CheckStorage(dirPtr,
+                                      freeBytes - PACKAGEDOWNLOADER_STORAGE_MARGIN / 2));
+
+    // A directory not created yet is checked on its filesystem
+    snprintf(path, sizeof(path), "%s/legato/download", dirPtr);
+    LE_ASSERT_OK(packageDownloader_CheckStorage(path, STORAGE_FIXTURE_SIZE));
+
+    // Preallocation: the blocks are allocated, the file size is kept
+    snprintf(path, sizeof(path), "%s/%s", dirPtr, STORAGE_FIXTURE_FILE);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    LE_ASSERT(-1 != fd);
+
+    result = packageDownloader_PreallocateFile(fd, STORAGE_FIXTURE_SIZE);
+    LE_ASSERT((LE_OK == result) || (LE_UNSUPPORTED == result));
+    LE_ASSERT(0 == fstat(fd, &fileStat));
+    LE_ASSERT(0 == fileStat.st_size);
+    if (LE_OK == result)
+    {
+        LE_ASSERT(((uint64_t)fileStat.st_blocks * 512) >= STORAGE_FIXTURE_SIZE);
+
+        // A package larger than the free space is rejected before any write
+        result = packageDownloader_PreallocateFile(fd, freeBytes + PACKAGEDOWNLOADER_STORAGE_MARGIN);
+        LE_ASSERT(LE_NO_MEMORY == result);
+    }
+    LE_ASSERT(LE_FAULT == packageDownloader_PreallocateFile(-1, STORAGE_FIXTURE_SIZE));
+
+    close(fd);
+    unlink(path);
+
+    le_sem_Post(SyncSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Test the download shaper metered-data budget, the download hold and the automatic resume.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Test_ShaperBudget
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    downloadShaper_Config_t config;
+    uint64_t dailyBytes;
+    uint64_t monthlyBytes;
+
+    LE_INFO("Running test: %s\n", __func__);
+
+    memset(&config, 0, sizeof(config));
+    config.isMetered[DOWNLOADSHAPER_BEARER_CELLULAR] = true;
+    config.dailyBudget = SHAPER_DAILY_BUDGET;
+
+    // Start on a new day with an empty budget usage
+    FakeTime.sec = SHAPER_START_TIME + SECONDS_PER_DAY;
+    FakeTime.usec = 0;
+    downloadShaper_SetClock(FakeGetTime, FakeSleep);
+    downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_CELLULAR);
+    LE_ASSERT_OK(downloadShaper_SetConfig(&config));
+
+    LE_ASSERT(LE_BAD_PARAMETER == downloadShaper_GetUsage(NULL, NULL));
+    LE_ASSERT_OK(downloadShaper_GetUsage(&dailyBytes, &monthlyBytes));
+    LE_ASSERT(0 == dailyBytes);
+
+    // Consume the budget
+    downloadShaper_Consume(SHAPER_DAILY_BUDGET - 1);
+    LE_ASSERT(false == downloadShaper_IsBudgetExhausted());
+    downloadShaper_Consume(1);
+    LE_ASSERT(true == downloadShaper_IsBudgetExhausted());
+    LE_ASSERT_OK(downloadShaper_GetUsage(&dailyBytes, &monthlyBytes));
+    LE_ASSERT(SHAPER_DAILY_BUDGET == dailyBytes);
+    LE_ASSERT(SHAPER_DAILY_BUDGET <= monthlyBytes);
+
+    // The budget does not apply to Wi-Fi and bytes received over Wi-Fi are not accounted
+    downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_WIFI);
+    LE_ASSERT(false == downloadShaper_IsBudgetExhausted());
+    downloadShaper_Consume(SHAPER_DAILY_BUDGET);
+    LE_ASSERT_OK(downloadShaper_GetUsage(&dailyBytes, &monthlyBytes));
+    LE_ASSERT(SHAPER_DAILY_BUDGET == dailyBytes);
+    downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_CELLULAR);
+    LE_ASSERT(true == downloadShaper_IsBudgetExhausted());
+
+    // The usage is persisted
+    downloadShaper_SaveUsage();
+    LE_ASSERT_OK(downloadShaper_Init());
+    LE_ASSERT_OK(downloadShaper_GetUsage(&dailyBytes, &monthlyBytes));
+    LE_ASSERT(SHAPER_DAILY_BUDGET == dailyBytes);
+
+    // A held download is resumed on a bearer change
+    ResumeCount = 0;
+    downloadShaper_HoldDownload(DOWNLOAD_URI, LWM2MCORE_FW_UPDATE_TYPE, ResumeDownload);
+    LE_ASSERT(true == downloadShaper_IsDownloadHeld());
+    downloadShaper_CheckBudgetReset();
+    LE_ASSERT(true == downloadShaper_IsDownloadHeld());
+    LE_ASSERT(0 == ResumeCount);
+    downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_WIFI);
+    LE_ASSERT(false == downloadShaper_IsDownloadHeld());
+    LE_ASSERT(1 == ResumeCount);
+
+    // A held download is resumed when the budget is reset
+    downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_CELLULAR);
+    downloadShaper_HoldDownload(DOWNLOAD_URI, LWM2MCORE_FW_UPDATE_TYPE, ResumeDownload);
+    LE_ASSERT(true == downloadShaper_IsDownloadHeld());
+    FakeTime.sec += SECONDS_PER_DAY;
+    downloadShaper_CheckBudgetReset();
+    LE_ASSERT(false == downloadShaper_IsDownloadHeld());
+    LE_ASSERT(2 == ResumeCount);
+    LE_ASSERT(false == downloadShaper_IsBudgetExhausted());
+    LE_ASSERT_OK(downloadShaper_GetUsage(&dailyBytes, &monthlyBytes));
+    LE_ASSERT(0 == dailyBytes);
+
+    // Restore an unlimited configuration
+    memset(&config, 0, sizeof(config));
+    config.isMetered[DOWNLOADSHAPER_BEARER_CELLULAR] = true;
+    LE_ASSERT_OK(downloadShaper_SetConfig(&config));
+    downloadShaper_SetClock(NULL, NULL);
+
+    le_sem_Post(SyncSemRef);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Package Downloader Test Thread.
@@ -648,6 +1597,12 @@ COMPONENT_INIT
     le_thread_Start(TestRef);
     le_sem_Wait(SyncSemRef);
 
+    // Power-loss fault injection, run instead of the unit tests
+    if ((le_arg_NumArgs() > 0) && (0 == strcmp(le_arg_GetArg(0), "--power-loss")))
+    {
+        exit((LE_OK == powerLoss_Run(TestRef)) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     // Test 0: Initialize packet forwarder
     le_event_QueueFunctionToThread(TestRef, Test_InitPackageDownloader, NULL, NULL);
     le_sem_Wait(SyncSemRef);
@@ -658,6 +1613,55 @@ COMPONENT_INIT
     le_event_QueueFunctionToThread(TestRef, Check_DownloadRegularFw, NULL, NULL);
     le_sem_Wait(SyncSemRef);
 
+    // Push a firmware package and check results
+    le_event_QueueFunctionToThread(TestRef, Test_PushFw, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Check_DownloadRegularFw, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+
+    // Interrupt a pushed firmware package, resume it and check results
+    le_event_QueueFunctionToThread(TestRef, Test_PushFwInterrupted, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    WaitDownloadSuspended();
+    le_event_QueueFunctionToThread(TestRef, Test_PushFwResumed, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Check_DownloadRegularFw, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+
+    // Install truncated and tampered firmware packages from local files and check the failures
+    le_event_QueueFunctionToThread(TestRef, Test_LocalFwTruncated, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    WaitDownloadFailed();
+    le_event_QueueFunctionToThread(TestRef, Check_LocalFwFailed, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Test_LocalFwTampered, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    WaitDownloadFailed();
+    le_event_QueueFunctionToThread(TestRef, Check_LocalFwFailed, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+
+    // Install a firmware package from a local file and check results
+    le_event_QueueFunctionToThread(TestRef, Test_LocalFw, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Check_DownloadRegularFw, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+
+    // Download from mirrors
+    le_event_QueueFunctionToThread(TestRef, Test_MirrorList, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Test_MirrorFailover, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Check_DownloadRegularFw, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Check_MirrorFailover, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Test_MirrorUnreachable, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Check_DownloadRegularFw, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+    le_event_QueueFunctionToThread(TestRef, Check_MirrorUnreachable, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+
     le_event_QueueFunctionToThread(TestRef, Test_BytesLeftToDownload, NULL, NULL);
     le_sem_Wait(SyncSemRef);
 
@@ -697,6 +1701,15 @@ COMPONENT_INIT
     le_event_QueueFunctionToThread(TestRef, Test_DeleteFwUpdateInfo, NULL, NULL);
     le_sem_Wait(SyncSemRef);
 
+    le_event_QueueFunctionToThread(TestRef, Test_ShaperRateLimit, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+
+    le_event_QueueFunctionToThread(TestRef, Test_ShaperBudget, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+
+    le_event_QueueFunctionToThread(TestRef, Test_StorageAdmission, NULL, NULL);
+    le_sem_Wait(SyncSemRef);
+
     // Kill the test thread
     le_thread_Cancel(TestRef);
     le_thread_Join(TestRef, NULL);
@@ -15,6 +15,20 @@
 #include "interfaces.h"
 #include "legato.h"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum path length
+ */
+//--------------------------------------------------------------------------------------------------
+#define PATH_MAX_LENGTH    LWM2MCORE_PACKAGE_URI_MAX_BYTES
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Relative location to the test download image
+ */
+//--------------------------------------------------------------------------------------------------
+#define DOWNLOAD_URI    "../data/test.dwl"
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Test result structure
@@ -52,4 +66,57 @@ void NotifyCompletion
     DownloadResult_t* result
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Notify the registration update requested at the end of a download
+ */
+//--------------------------------------------------------------------------------------------------
+void NotifyClientUpdate
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the path containing the currently-running program executable
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t GetExecPath
+(
+    char* buffer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare the downloaded file regarding the source file
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t CheckDownloadedFile
+(
+    char* sourceFilePath
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of bytes transferred to the write callbacks since the start of the test
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t GetTransferredBytes
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Inject faults when a URL is downloaded: a delay before each sent chunk and a failure of the
+ * transfers at an offset. A null delay and offset remove the fixture.
+ */
+//--------------------------------------------------------------------------------------------------
+void SetCurlFixture
+(
+    const char* urlPtr,
+    uint32_t chunkDelayUs,
+    uint64_t failOffset
+);
+
 #endif
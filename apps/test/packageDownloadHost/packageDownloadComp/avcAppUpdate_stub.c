@@ -251,6 +251,25 @@ le_result_t avcApp_GetResumePosition
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a package can be stored in the download directory.
+ *
+ * @return
+ *      - LE_OK if the package can be stored.
+ *      - LE_NO_MEMORY if there is not enough free space.
+ *      - LE_FAULT if there is an error.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_CheckStorage
+(
+    uint64_t packageSize
+)
+{
+    LE_DEBUG("Stub");
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set software update state in asset data and SW update workspace for ongoing update.
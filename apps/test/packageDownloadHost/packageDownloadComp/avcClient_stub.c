@@ -8,6 +8,7 @@
 
 #include "legato.h"
 #include "avcClient.h"
+#include "main.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -25,6 +26,9 @@ le_result_t avcClient_Update
 )
 {
     LE_DEBUG("Stub");
+
+    // A registration update is requested at the end of a download
+    NotifyClientUpdate();
     return LE_OK;
 }
 //--------------------------------------------------------------------------------------------------
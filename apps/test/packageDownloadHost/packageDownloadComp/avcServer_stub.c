@@ -43,6 +43,21 @@ void avcServer_UpdateStatus
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report that a package download is held because the metered-data budget is exhausted, or that
+ * it resumes
+ */
+//--------------------------------------------------------------------------------------------------
+void avcServer_ReportDownloadHold
+(
+    bool isHeld,                    ///< [IN] The download is held, or resumes
+    lwm2mcore_UpdateType_t type     ///< [IN] Update type
+)
+{
+    LE_DEBUG("Stub");
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Resets user agreement query handlers of download, install and uninstall. This also stops
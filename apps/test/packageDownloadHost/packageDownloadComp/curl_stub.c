@@ -10,6 +10,7 @@
 #include <lwm2mcore/update.h>
 #include <stdarg.h>
 #include "legato.h"
+#include "main.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -26,6 +27,21 @@
 //--------------------------------------------------------------------------------------------------
 #define CURL_POOL_SIZE   2
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of fixtures with injected faults
+ */
+//--------------------------------------------------------------------------------------------------
+#define CURL_MAX_FIXTURES   4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * HTTP status codes returned by the stub
+ */
+//--------------------------------------------------------------------------------------------------
+#define HTTP_OK                 200
+#define HTTP_PARTIAL_CONTENT    206
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Curl callback prototype definition
@@ -48,11 +64,60 @@ typedef struct
     callback writeFnc;                          ///< User callback
     bool noBody;                                ///< Sends the header without the body
     int dataOffset;                             ///< Data offset to resume a transfert
+    uint64_t rangeOffset;                       ///< Start offset requested by CURLOPT_RANGE
+    uint64_t rangeEnd;                          ///< Last offset requested by CURLOPT_RANGE
+    bool isRange;                               ///< A range is requested
     void* contextPtr;                           ///< User context pointer
     char url[LWM2MCORE_PACKAGE_URI_MAX_BYTES];  ///< Download path
 }
 CurlTestHandler_t;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fixture structure definition: faults injected when a URL is downloaded
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char url[LWM2MCORE_PACKAGE_URI_MAX_BYTES];  ///< Fixture URL, empty if not used
+    uint32_t chunkDelayUs;                      ///< Delay before each sent chunk
+    uint64_t failOffset;                        ///< Offset at which the transfers fail, 0 if none
+}
+CurlFixture_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fixtures with injected faults
+ */
+//--------------------------------------------------------------------------------------------------
+static CurlFixture_t CurlFixtures[CURL_MAX_FIXTURES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the fixture of a URL
+ *
+ * @return
+ *  - Fixture of the URL, NULL if no fault is injected
+ */
+//--------------------------------------------------------------------------------------------------
+static const CurlFixture_t* GetFixture
+(
+    const char* urlPtr
+)
+{
+    int i;
+
+    for (i = 0; i < CURL_MAX_FIXTURES; i++)
+    {
+        if (('\0' != CurlFixtures[i].url[0]) && (0 == strcmp(CurlFixtures[i].url, urlPtr)))
+        {
+            return &CurlFixtures[i];
+        }
+    }
+
+    return NULL;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Curl handler
@@ -67,6 +132,13 @@ static CurlTestHandler_t* CurlTestHandler = NULL;
 //--------------------------------------------------------------------------------------------------
 le_mem_PoolRef_t CurlPool = NULL;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes transferred to the write callbacks since the start of the test
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t TransferredBytes = 0;
+
 //==================================================================================================
 //                                       Public API Functions
 //==================================================================================================
@@ -119,6 +191,7 @@ CURL *curl_easy_init
     // Zero-initialize the strucure and set a dummy handler
     memset(CurlTestHandler, 0, sizeof(CurlTestHandler_t));
     CurlTestHandler->handle = (CURL* )le_rand_GetNumBetween(0, 10000008);
+    CurlTestHandler->rangeEnd = UINT64_MAX;
 
     return CurlTestHandler->handle;
 }
@@ -184,6 +257,24 @@ CURLcode curl_easy_setopt
             CurlTestHandler->noBody = ((int*)paramPtr > 0) ? true : false;
             break;
 
+        case CURLOPT_RANGE:
+        {
+            // Open ranges "<offset>-" are used to resume a download, closed ranges
+            // "<offset>-<end>" to download from several sources
+            unsigned long long rangeOffset = 0;
+            unsigned long long rangeEnd = UINT64_MAX;
+            if (   (NULL != paramPtr)
+                && (1 > sscanf((const char*)paramPtr, "%llu-%llu", &rangeOffset, &rangeEnd)))
+            {
+                va_end(arg);
+                return CURLE_RANGE_ERROR;
+            }
+            CurlTestHandler->rangeOffset = (uint64_t)rangeOffset;
+            CurlTestHandler->rangeEnd = (uint64_t)rangeEnd;
+            CurlTestHandler->isRange = (NULL != paramPtr);
+        }
+        break;
+
         default:
             break;
     }
@@ -205,6 +296,8 @@ CURLcode curl_easy_perform
     int fd;
     ssize_t readBytes = 0, writeBytes = 0, totalBytes = 0;
     char buffer[1024] = {0};
+    const CurlFixture_t* fixturePtr;
+    uint64_t count;
 
     if (NULL == CurlTestHandler)
     {
@@ -221,21 +314,54 @@ CURLcode curl_easy_perform
         }
 
         // Since this function handles pause and resume, we adjust the read pointer in order
-        // to not re-send previous data
+        // to not re-send previous data. A paused transfer is restarted where it stopped, a new
+        // one at the requested range offset.
+        if (0 == CurlTestHandler->dataOffset)
+        {
+            CurlTestHandler->dataOffset = (int)CurlTestHandler->rangeOffset;
+        }
         if (lseek(fd, CurlTestHandler->dataOffset, SEEK_SET) == -1)
         {
             LE_ERROR("Seek file to offset %d failed.", CurlTestHandler->dataOffset);
             close(fd);
             return LE_FAULT;
         }
+        totalBytes = CurlTestHandler->dataOffset;
         CurlTestHandler->dataOffset = 0;
+        fixturePtr = GetFixture(CurlTestHandler->url);
 
         // Read the file by shrunks and send it to the callback
         do
         {
-            readBytes = read(fd, buffer, sizeof(buffer));
+            // Stop at the end of the requested range
+            if ((uint64_t)totalBytes > CurlTestHandler->rangeEnd)
+            {
+                break;
+            }
+            count = CurlTestHandler->rangeEnd - (uint64_t)totalBytes;
+            count = (count < sizeof(buffer)) ? count + 1 : sizeof(buffer);
+
+            if (NULL != fixturePtr)
+            {
+                // Injected failure: the connection is lost at the fail offset
+                if ((fixturePtr->failOffset) && ((uint64_t)totalBytes >= fixturePtr->failOffset))
+                {
+                    close(fd);
+                    return CURLE_RECV_ERROR;
+                }
+                if ((fixturePtr->failOffset) && ((fixturePtr->failOffset - totalBytes) < count))
+                {
+                    count = fixturePtr->failOffset - totalBytes;
+                }
+
+                // Injected slowness
+                usleep(fixturePtr->chunkDelayUs);
+            }
+
+            readBytes = read(fd, buffer, (size_t)count);
             if (readBytes > 0)
             {
+                TransferredBytes += (uint64_t)readBytes;
                 writeBytes = CurlTestHandler->writeFnc(buffer,readBytes,sizeof(char),
                                                        CurlTestHandler->contextPtr);
                 if (writeBytes != readBytes)
@@ -295,7 +421,8 @@ CURLcode curl_easy_getinfo
     switch (info)
     {
         case CURLINFO_RESPONSE_CODE:
-            *(int*)paramPtr = 200;
+            *(long*)paramPtr = ((CurlTestHandler->isRange) && (false == CurlTestHandler->noBody)) ?
+                               HTTP_PARTIAL_CONTENT : HTTP_OK;
             break;
 
         case CURLINFO_CONTENT_LENGTH_DOWNLOAD:
@@ -307,7 +434,8 @@ CURLcode curl_easy_getinfo
             }
             else
             {
-                *(double*)paramPtr = st.st_size;
+                // Like an HTTP server, only the length of the requested range is returned
+                *(double*)paramPtr = st.st_size - CurlTestHandler->rangeOffset;
             }
         }
         break;
@@ -366,6 +494,56 @@ const char *curl_easy_strerror
     return "ERROR";
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of bytes transferred to the write callbacks since the start of the test
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t GetTransferredBytes
+(
+    void
+)
+{
+    return TransferredBytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Inject faults when a URL is downloaded: a delay before each sent chunk and a failure of the
+ * transfers at an offset. A null delay and offset remove the fixture.
+ */
+//--------------------------------------------------------------------------------------------------
+void SetCurlFixture
+(
+    const char* urlPtr,
+    uint32_t chunkDelayUs,
+    uint64_t failOffset
+)
+{
+    CurlFixture_t* fixturePtr = (CurlFixture_t*)GetFixture(urlPtr);
+    int i;
+
+    for (i = 0; (NULL == fixturePtr) && (i < CURL_MAX_FIXTURES); i++)
+    {
+        if ('\0' == CurlFixtures[i].url[0])
+        {
+            fixturePtr = &CurlFixtures[i];
+        }
+    }
+    LE_ASSERT(NULL != fixturePtr);
+    LE_ASSERT(strlen(urlPtr) < sizeof(fixturePtr->url));
+
+    if ((0 == chunkDelayUs) && (0 == failOffset))
+    {
+        memset(fixturePtr, 0, sizeof(CurlFixture_t));
+        return;
+    }
+
+    strcpy(fixturePtr->url, urlPtr);
+    fixturePtr->chunkDelayUs = chunkDelayUs;
+    fixturePtr->failOffset = failOffset;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * curl_version
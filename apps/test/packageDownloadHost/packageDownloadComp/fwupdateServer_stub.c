@@ -55,7 +55,58 @@ static void ReadUint(uint8_t* dataPtr, uint32_t* valuePtr)
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Download the firmware image file into /tmp/fwupdate.txt
+ * Get the number of bytes of the image already stored, i.e. the resume position
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t GetStoredSize
+(
+    void
+)
+{
+    size_t size = 0;
+
+    if (LE_OK != le_fs_GetSize(FWUPDATE_STORE_FILE, &size))
+    {
+        return 0;
+    }
+
+    return size;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the beginning of the image already stored, to retrieve the CWE header of a resumed download
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t ReadStoredHeader
+(
+    uint8_t* headerPtr,     ///< [OUT] Header buffer
+    size_t   headerSize     ///< [IN] Header buffer size
+)
+{
+    le_fs_FileRef_t fileRef;
+    size_t readSize = headerSize;
+
+    if (LE_OK != le_fs_Open(FWUPDATE_STORE_FILE, LE_FS_RDONLY, &fileRef))
+    {
+        return 0;
+    }
+
+    if (LE_OK != le_fs_Read(fileRef, headerPtr, &readSize))
+    {
+        readSize = 0;
+    }
+    le_fs_Close(fileRef);
+
+    return readSize;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download the firmware image file into the firmware store file.
+ *
+ * The store file models the flash partition: the data received are appended to it, so that a
+ * download can be resumed at its size after a reset (see le_fwupdate_GetResumePosition).
  *
  * @return
  *      - LE_OK              On success
@@ -78,13 +129,18 @@ le_result_t le_fwupdate_Download
     le_fs_FileRef_t fileRef;
     le_result_t result;
     ssize_t readCount = 0;
-    size_t totalCount = 0;
+    size_t totalCount;
     size_t fullImageLength = 0;
     uint8_t bufPtr[512] = {0};
+    uint8_t header[CWE_IMAGE_SIZE_OFST + sizeof(uint32_t)];
+    size_t headerLength;
     uint32_t imageSize;
-    int cweImageSizeOffset = CWE_IMAGE_SIZE_OFST;
 
-    result = le_fs_Open(FWUPDATE_STORE_FILE, LE_FS_WRONLY | LE_FS_CREAT, &fileRef);
+    // Resume after the data already stored
+    totalCount = GetStoredSize();
+    headerLength = ReadStoredHeader(header, sizeof(header));
+
+    result = le_fs_Open(FWUPDATE_STORE_FILE, LE_FS_WRONLY | LE_FS_CREAT | LE_FS_APPEND, &fileRef);
     if (LE_OK != result)
     {
         LE_ERROR("failed to open %s: %s", FWUPDATE_STORE_FILE, LE_RESULT_TXT(result));
@@ -109,45 +165,54 @@ le_result_t le_fwupdate_Download
 
     while (true)
     {
+        if (0 == fullImageLength)
+        {
+            // Get application image size: the full length of the CWE image is provided inside
+            // the first CWE header
+            if (sizeof(header) == headerLength)
+            {
+                ReadUint(header + CWE_IMAGE_SIZE_OFST, &imageSize);
+                fullImageLength = imageSize + CWE_HEADER_SIZE;
+                LE_DEBUG("fullImageLength: %zu", fullImageLength);
+            }
+        }
+
+        if ((fullImageLength) && (totalCount >= fullImageLength))
+        {
+            break;
+        }
+
         do
         {
             readCount = read(fd, bufPtr, sizeof(bufPtr));
         }
         while ((-1 == readCount) && (EINTR == errno));
 
-        if (readCount > 0)
+        if (readCount <= 0)
         {
-            totalCount += readCount;
-            result = le_fs_Write(fileRef, (uint8_t* )bufPtr, readCount);
-            if (LE_OK != result)
-            {
-                LE_ERROR("failed to write %s: %s", FWUPDATE_STORE_FILE, LE_RESULT_TXT(result));
-            }
+            LE_ERROR("Image incomplete: received %zu bytes", totalCount);
+            le_fs_Close(fileRef);
+            return LE_CLOSED;
         }
 
-        if (0 == fullImageLength)
+        if (headerLength < sizeof(header))
         {
-            // Get application image size
-            if (totalCount >= CWE_IMAGE_SIZE_OFST + 4)
-            {
-                ReadUint((uint8_t* )(bufPtr + cweImageSizeOffset), &imageSize);
+            size_t copyLength = sizeof(header) - headerLength;
 
-                // Full length of the CWE image is provided inside the
-                // first CWE header
-                fullImageLength = imageSize + CWE_HEADER_SIZE;
-                LE_DEBUG("fullImageLength: %zu", fullImageLength);
-            }
-            else
+            if (copyLength > (size_t)readCount)
             {
-                cweImageSizeOffset = CWE_IMAGE_SIZE_OFST - totalCount;
+                copyLength = (size_t)readCount;
             }
+
+            memcpy(header + headerLength, bufPtr, copyLength);
+            headerLength += copyLength;
         }
-        else
+
+        totalCount += readCount;
+        result = le_fs_Write(fileRef, (uint8_t* )bufPtr, readCount);
+        if (LE_OK != result)
         {
-            if (totalCount >= fullImageLength)
-            {
-                break;
-            }
+            LE_ERROR("failed to write %s: %s", FWUPDATE_STORE_FILE, LE_RESULT_TXT(result));
         }
     }
 
@@ -192,6 +257,15 @@ le_result_t le_fwupdate_InitDownload
 )
 {
     LE_DEBUG("Stub");
+
+    // Erase the stored image: the resume position is reset
+    le_result_t result = le_fs_Delete(FWUPDATE_STORE_FILE);
+    if ((LE_OK != result) && (LE_NOT_FOUND != result))
+    {
+        LE_ERROR("failed to delete %s: %s", FWUPDATE_STORE_FILE, LE_RESULT_TXT(result));
+        return LE_FAULT;
+    }
+
     return LE_OK;
 }
 
@@ -211,6 +285,13 @@ le_result_t le_fwupdate_GetResumePosition
 )
 {
     LE_DEBUG("Stub");
+
+    if (NULL == positionPtr)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    *positionPtr = GetStoredSize();
     return LE_OK;
 }
 
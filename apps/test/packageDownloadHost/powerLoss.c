@@ -0,0 +1,1108 @@
+/**
+ * @file powerLoss.c
+ *
+ * Power-loss fault injection on the package download and persistence paths.
+ *
+ * The file system operations persisting the download state (le_fs_Write and le_fs_Delete, used by
+ * avcFs.c for the update states, the resume information and the LwM2MCore workspace, and by the
+ * flash model of the le_fwupdate stub) are intercepted with the linker option --wrap.
+ *
+ * A power loss before the Nth operation is simulated by copying the le_fs storage just before
+ * this operation is executed. The download then runs to its end, the storage is restored from the
+ * copy and the downloader is restarted from the persisted state, as after a reset: the download
+ * is resumed if resume information is stored, otherwise the server sends the package URI again.
+ *
+ * For each crash point, the test checks that the firmware image is byte-identical to the package,
+ * that no resume information is left and that the stored files are the same as after a download
+ * without power loss. The amount of data downloaded again because of the power loss is reported
+ * for each crash point, with the worst case.
+ *
+ * Usage: packageDownloadHost --power-loss [--stride <N>] [--metrics <file>]
+ *  --stride <N>        Simulate a power loss before every Nth write of the firmware image, about
+ *                      32 writes of the image are tested by default. A power loss is always
+ *                      simulated before each operation on the other files.
+ *  --metrics <file>    Write the re-download amount of each crash point to a CSV file
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+// FTW_DEPTH and FTW_PHYS are XSI extensions
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <ftw.h>
+#include "main.h"
+#include "powerLoss.h"
+#include "packageDownloader.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Location of the le_fs storage on the host
+ */
+//--------------------------------------------------------------------------------------------------
+#define LEFS_ROOT_PATH              "/tmp/data/le_fs"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Location of the copy of the le_fs storage taken at the power loss
+ */
+//--------------------------------------------------------------------------------------------------
+#define SNAPSHOT_PATH               "/tmp/data/le_fs.powerLoss"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Firmware image stored by the le_fwupdate stub, i.e. the flash partition
+ */
+//--------------------------------------------------------------------------------------------------
+#define FWUPDATE_STORE_FILE         "/firmware.bin"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default number of crash points in the firmware image writes
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFAULT_IMAGE_CRASH_POINTS  32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum duration of a download, in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define DOWNLOAD_TIMEOUT_SEC        60
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Polling period of the end of the download threads, in microseconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define IDLE_POLL_PERIOD_US         10000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of files opened at the same time through le_fs
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_OPEN_FILES              16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of files in the le_fs storage
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_STORED_FILES            64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a le_fs file path
+ */
+//--------------------------------------------------------------------------------------------------
+#define FILE_PATH_BYTES             128
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of file descriptors used to walk a directory tree
+ */
+//--------------------------------------------------------------------------------------------------
+#define NFTW_MAX_FDS                16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * File opened through le_fs
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_fs_FileRef_t fileRef;                    ///< File reference, NULL if the entry is unused
+    char            path[FILE_PATH_BYTES];      ///< File path
+}
+OpenFile_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * List of the files in the le_fs storage
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t  count;                                      ///< Number of files
+    char    paths[MAX_STORED_FILES][FILE_PATH_BYTES];   ///< Sorted file paths
+}
+FileList_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Crash point
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t    operation;                  ///< Index of the operation, starting at 1
+    bool        isReached;                  ///< Was the operation reached?
+    const char* typePtr;                    ///< Type of the operation
+    char        path[FILE_PATH_BYTES];      ///< File of the operation
+    uint64_t    transferredBytes;           ///< Counter of transferred bytes at the power loss
+}
+CrashPoint_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Real le_fs functions, see the linker option --wrap
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t __real_le_fs_Open(const char*, le_fs_AccessMode_t, le_fs_FileRef_t*);
+le_result_t __real_le_fs_Close(le_fs_FileRef_t);
+le_result_t __real_le_fs_Write(le_fs_FileRef_t, const uint8_t*, size_t);
+le_result_t __real_le_fs_Delete(const char*);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Files opened through le_fs
+ */
+//--------------------------------------------------------------------------------------------------
+static OpenFile_t OpenFiles[MAX_OPEN_FILES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of file operations since the start of the download
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t OperationCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is the type of the operations recorded? Set during the download without power loss.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsRecording = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Recorded operations: true for a write of the firmware image
+ */
+//--------------------------------------------------------------------------------------------------
+static bool* IsImageOperationPtr = NULL;
+static size_t RecordedOperations = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current crash point, the operation index is 0 when no power loss is simulated
+ */
+//--------------------------------------------------------------------------------------------------
+static CrashPoint_t CrashPoint;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex serializing the intercepted operations, so that the storage copy is consistent
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t FsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&FsMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&FsMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test thread, and semaphores signaling the end of a step and the end of a download
+ */
+//--------------------------------------------------------------------------------------------------
+static le_thread_Ref_t TestThreadRef = NULL;
+static le_sem_Ref_t StepSemRef = NULL;
+static le_sem_Ref_t EndSemRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result of the last step run in the test thread, and whether a download was started
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StepResult;
+static bool IsDownloadStarted;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Package to download
+ */
+//--------------------------------------------------------------------------------------------------
+static char PackagePath[PATH_MAX_LENGTH];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Source and destination of the directory tree copy, used by the nftw() callback
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* CopySrcPtr;
+static const char* CopyDstPtr;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * File list filled by the nftw() callback
+ */
+//--------------------------------------------------------------------------------------------------
+static FileList_t* ListPtr;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Files stored and update state after a download without power loss
+ */
+//--------------------------------------------------------------------------------------------------
+static FileList_t ReferenceFiles;
+static lwm2mcore_FwUpdateState_t ReferenceFwUpdateState;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * nftw() callback deleting a file or an empty directory
+ */
+//--------------------------------------------------------------------------------------------------
+static int RemoveEntry
+(
+    const char*         pathPtr,
+    const struct stat*  statPtr,
+    int                 typeFlag,
+    struct FTW*         ftwPtr
+)
+{
+    return remove(pathPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete a directory tree
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RemoveTree
+(
+    const char* pathPtr     ///< [IN] Directory
+)
+{
+    if ((0 != nftw(pathPtr, RemoveEntry, NFTW_MAX_FDS, FTW_DEPTH | FTW_PHYS)) && (ENOENT != errno))
+    {
+        LE_ERROR("Failed to delete %s: %m", pathPtr);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy a file
+ */
+//--------------------------------------------------------------------------------------------------
+static int CopyFile
+(
+    const char* srcPathPtr,     ///< [IN] Source file
+    const char* dstPathPtr,     ///< [IN] Destination file
+    mode_t      mode            ///< [IN] Destination file mode
+)
+{
+    uint8_t buffer[4096];
+    ssize_t readCount;
+    int srcFd;
+    int dstFd;
+    int result = 0;
+
+    srcFd = open(srcPathPtr, O_RDONLY);
+    if (-1 == srcFd)
+    {
+        LE_ERROR("Unable to open %s: %m", srcPathPtr);
+        return -1;
+    }
+
+    dstFd = open(dstPathPtr, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (-1 == dstFd)
+    {
+        LE_ERROR("Unable to create %s: %m", dstPathPtr);
+        close(srcFd);
+        return -1;
+    }
+
+    while ((readCount = read(srcFd, buffer, sizeof(buffer))) > 0)
+    {
+        if (readCount != write(dstFd, buffer, readCount))
+        {
+            LE_ERROR("Unable to write %s: %m", dstPathPtr);
+            result = -1;
+            break;
+        }
+    }
+
+    if (readCount < 0)
+    {
+        LE_ERROR("Unable to read %s: %m", srcPathPtr);
+        result = -1;
+    }
+
+    close(srcFd);
+    close(dstFd);
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * nftw() callback copying a file or a directory
+ */
+//--------------------------------------------------------------------------------------------------
+static int CopyEntry
+(
+    const char*         pathPtr,
+    const struct stat*  statPtr,
+    int                 typeFlag,
+    struct FTW*         ftwPtr
+)
+{
+    char dstPath[PATH_MAX];
+
+    snprintf(dstPath, sizeof(dstPath), "%s%s", CopyDstPtr, pathPtr + strlen(CopySrcPtr));
+
+    switch (typeFlag)
+    {
+        case FTW_D:
+            if ((0 != mkdir(dstPath, statPtr->st_mode & ACCESSPERMS)) && (EEXIST != errno))
+            {
+                LE_ERROR("Unable to create %s: %m", dstPath);
+                return -1;
+            }
+            return 0;
+
+        case FTW_F:
+            return CopyFile(pathPtr, dstPath, statPtr->st_mode & ACCESSPERMS);
+
+        default:
+            return 0;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Replace a directory tree by the copy of another one. The destination is only deleted if the
+ * source does not exist.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CopyTree
+(
+    const char* srcPathPtr,     ///< [IN] Source directory
+    const char* dstPathPtr      ///< [IN] Destination directory
+)
+{
+    if (LE_OK != RemoveTree(dstPathPtr))
+    {
+        return LE_FAULT;
+    }
+
+    CopySrcPtr = srcPathPtr;
+    CopyDstPtr = dstPathPtr;
+    if ((0 != nftw(srcPathPtr, CopyEntry, NFTW_MAX_FDS, FTW_PHYS)) && (ENOENT != errno))
+    {
+        LE_ERROR("Failed to copy %s to %s", srcPathPtr, dstPathPtr);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * nftw() callback adding a file to the file list
+ */
+//--------------------------------------------------------------------------------------------------
+static int ListEntry
+(
+    const char*         pathPtr,
+    const struct stat*  statPtr,
+    int                 typeFlag,
+    struct FTW*         ftwPtr
+)
+{
+    if (FTW_F != typeFlag)
+    {
+        return 0;
+    }
+
+    if (MAX_STORED_FILES <= ListPtr->count)
+    {
+        LE_ERROR("Too many files in %s", LEFS_ROOT_PATH);
+        return -1;
+    }
+
+    le_utf8_Copy(ListPtr->paths[ListPtr->count],
+                 pathPtr + strlen(LEFS_ROOT_PATH),
+                 FILE_PATH_BYTES,
+                 NULL);
+    ListPtr->count++;
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare two file paths, for qsort()
+ */
+//--------------------------------------------------------------------------------------------------
+static int ComparePaths
+(
+    const void* aPtr,
+    const void* bPtr
+)
+{
+    return strcmp((const char*)aPtr, (const char*)bPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * List the files of the le_fs storage, sorted by path
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ListFiles
+(
+    FileList_t* listPtr     ///< [OUT] File list
+)
+{
+    listPtr->count = 0;
+    ListPtr = listPtr;
+
+    if ((0 != nftw(LEFS_ROOT_PATH, ListEntry, NFTW_MAX_FDS, FTW_PHYS)) && (ENOENT != errno))
+    {
+        return LE_FAULT;
+    }
+
+    qsort(listPtr->paths, listPtr->count, FILE_PATH_BYTES, ComparePaths);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the path of a file opened through le_fs
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* GetOpenFilePath
+(
+    le_fs_FileRef_t fileRef     ///< [IN] File reference
+)
+{
+    int i;
+
+    for (i = 0; i < MAX_OPEN_FILES; i++)
+    {
+        if (fileRef == OpenFiles[i].fileRef)
+        {
+            return OpenFiles[i].path;
+        }
+    }
+
+    return "";
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Count an operation persisting data, and simulate a power loss before it if it is the crash
+ * point. Called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CountOperation
+(
+    const char* typePtr,    ///< [IN] Type of the operation
+    const char* pathPtr     ///< [IN] File of the operation
+)
+{
+    OperationCount++;
+
+    if (IsRecording)
+    {
+        bool* recordPtr = realloc(IsImageOperationPtr, OperationCount * sizeof(bool));
+        LE_ASSERT(recordPtr);
+        IsImageOperationPtr = recordPtr;
+        IsImageOperationPtr[OperationCount - 1] = (0 == strcmp(pathPtr, FWUPDATE_STORE_FILE));
+        RecordedOperations = OperationCount;
+    }
+
+    if ((OperationCount == CrashPoint.operation) && (!CrashPoint.isReached))
+    {
+        // Power loss: the storage is saved as it is before this operation
+        LE_ASSERT_OK(CopyTree(LEFS_ROOT_PATH, SNAPSHOT_PATH));
+        CrashPoint.isReached = true;
+        CrashPoint.typePtr = typePtr;
+        le_utf8_Copy(CrashPoint.path, pathPtr, sizeof(CrashPoint.path), NULL);
+        CrashPoint.transferredBytes = GetTransferredBytes();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Intercepted le_fs_Open(): the path of the file is kept to identify the written files
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t __wrap_le_fs_Open
+(
+    const char*         filePathPtr,
+    le_fs_AccessMode_t  accessMode,
+    le_fs_FileRef_t*    fileRefPtr
+)
+{
+    le_result_t result;
+    int i;
+
+    result = __real_le_fs_Open(filePathPtr, accessMode, fileRefPtr);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    LOCK();
+    for (i = 0; i < MAX_OPEN_FILES; i++)
+    {
+        if (NULL == OpenFiles[i].fileRef)
+        {
+            OpenFiles[i].fileRef = *fileRefPtr;
+            le_utf8_Copy(OpenFiles[i].path, filePathPtr, sizeof(OpenFiles[i].path), NULL);
+            break;
+        }
+    }
+    UNLOCK();
+
+    if (MAX_OPEN_FILES == i)
+    {
+        LE_WARN("Too many open files, path of %s not kept", filePathPtr);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Intercepted le_fs_Close()
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t __wrap_le_fs_Close
+(
+    le_fs_FileRef_t fileRef
+)
+{
+    int i;
+
+    LOCK();
+    for (i = 0; i < MAX_OPEN_FILES; i++)
+    {
+        if (fileRef == OpenFiles[i].fileRef)
+        {
+            OpenFiles[i].fileRef = NULL;
+            break;
+        }
+    }
+    UNLOCK();
+
+    return __real_le_fs_Close(fileRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Intercepted le_fs_Write(): a power loss can be simulated before the write
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t __wrap_le_fs_Write
+(
+    le_fs_FileRef_t fileRef,
+    const uint8_t*  bufPtr,
+    size_t          bufNumElements
+)
+{
+    le_result_t result;
+
+    LOCK();
+    CountOperation("write", GetOpenFilePath(fileRef));
+    result = __real_le_fs_Write(fileRef, bufPtr, bufNumElements);
+    UNLOCK();
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Intercepted le_fs_Delete(): a power loss can be simulated before the deletion
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t __wrap_le_fs_Delete
+(
+    const char* filePathPtr
+)
+{
+    le_result_t result;
+
+    LOCK();
+    CountOperation("delete", filePathPtr);
+    result = __real_le_fs_Delete(filePathPtr);
+    UNLOCK();
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Notify the registration update requested at the end of a download
+ */
+//--------------------------------------------------------------------------------------------------
+void NotifyClientUpdate
+(
+    void
+)
+{
+    if (EndSemRef)
+    {
+        le_sem_Post(EndSemRef);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a download from an empty storage, as requested by the server. Run in the test thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartNewDownload
+(
+    void* param1Ptr,    ///< [IN] Crash point operation, 0 for none
+    void* param2Ptr
+)
+{
+    StepResult = packageDownloader_Init();
+
+    // Operations are counted from the package URI reception
+    LOCK();
+    OperationCount = 0;
+    memset(&CrashPoint, 0, sizeof(CrashPoint));
+    CrashPoint.operation = (uint32_t)(uintptr_t)param1Ptr;
+    UNLOCK();
+
+    if (   (LE_OK == StepResult)
+        && (LWM2MCORE_ERR_COMPLETED_OK != lwm2mcore_SetUpdatePackageUri(LWM2MCORE_FW_UPDATE_TYPE,
+                                                                        0,
+                                                                        PackagePath,
+                                                                        strlen(PackagePath))))
+    {
+        StepResult = LE_FAULT;
+    }
+
+    le_sem_Post(StepSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restart the downloader from the persisted state, as after a reset. Run in the test thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RestartDownloader
+(
+    void* param1Ptr,
+    void* param2Ptr
+)
+{
+    char uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES];
+    size_t uriLen = sizeof(uri);
+    lwm2mcore_UpdateType_t type;
+    lwm2mcore_FwUpdateState_t fwUpdateState;
+
+    IsDownloadStarted = false;
+    StepResult = packageDownloader_Init();
+    if (LE_OK != StepResult)
+    {
+        le_sem_Post(StepSemRef);
+        return;
+    }
+
+    if (LE_OK == packageDownloader_GetResumeInfo(uri, &uriLen, &type))
+    {
+        // Download resume at start-up
+        IsDownloadStarted = true;
+        if (LWM2MCORE_ERR_COMPLETED_OK != lwm2mcore_ResumePackageDownload())
+        {
+            LE_ERROR("Download resume failed");
+            IsDownloadStarted = false;
+        }
+    }
+    else if (   (LE_OK == packageDownloader_GetFwUpdateState(&fwUpdateState))
+             && (LWM2MCORE_FW_UPDATE_STATE_DOWNLOADED == fwUpdateState))
+    {
+        LE_DEBUG("Download completed before the power loss");
+    }
+    else
+    {
+        // The package URI was not stored: the server sends it again
+        IsDownloadStarted = true;
+        if (LWM2MCORE_ERR_COMPLETED_OK != lwm2mcore_SetUpdatePackageUri(LWM2MCORE_FW_UPDATE_TYPE,
+                                                                        0,
+                                                                        PackagePath,
+                                                                        strlen(PackagePath)))
+        {
+            StepResult = LE_FAULT;
+            IsDownloadStarted = false;
+        }
+    }
+
+    le_sem_Post(StepSemRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the end of a download and of its threads
+ *
+ * @return
+ *  - LE_OK         The download ended
+ *  - LE_TIMEOUT    The download did not end in time
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WaitDownloadEnd
+(
+    void
+)
+{
+    le_clk_Time_t timeout = {DOWNLOAD_TIMEOUT_SEC, 0};
+
+    if (LE_OK != le_sem_WaitWithTimeOut(EndSemRef, timeout))
+    {
+        LE_ERROR("Download did not end in %d s", DOWNLOAD_TIMEOUT_SEC);
+        return LE_TIMEOUT;
+    }
+
+    // The registration update is requested just before the download thread ends
+    while (packageDownloader_IsDownloadInProgress())
+    {
+        usleep(IDLE_POLL_PERIOD_US);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run a step in the test thread and wait for the download it started, if any
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RunStep
+(
+    le_event_DeferredFunc_t stepFunc,   ///< [IN] Step function
+    void*                   param1Ptr   ///< [IN] Step parameter
+)
+{
+    // Discard the notifications of previous downloads
+    while (LE_OK == le_sem_TryWait(EndSemRef))
+    {
+    }
+
+    IsDownloadStarted = true;
+    le_event_QueueFunctionToThread(TestThreadRef, stepFunc, param1Ptr, NULL);
+    le_sem_Wait(StepSemRef);
+
+    if (LE_OK != StepResult)
+    {
+        return StepResult;
+    }
+
+    return (IsDownloadStarted) ? WaitDownloadEnd() : LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the state left by a download: the firmware image must be identical to the package, no
+ * resume information must be stored and the stored files must be the same as after a download
+ * without power loss.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CheckFinalState
+(
+    void
+)
+{
+    static FileList_t files;
+    char uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES];
+    size_t uriLen = sizeof(uri);
+    lwm2mcore_UpdateType_t type;
+    lwm2mcore_FwUpdateState_t fwUpdateState;
+    le_result_t result = LE_OK;
+    size_t i;
+
+    if (LE_OK != CheckDownloadedFile(PackagePath))
+    {
+        LE_ERROR("Firmware image differs from the package");
+        result = LE_FAULT;
+    }
+
+    if (LE_OK == packageDownloader_GetResumeInfo(uri, &uriLen, &type))
+    {
+        LE_ERROR("Resume information left: %s", uri);
+        result = LE_FAULT;
+    }
+
+    if (   (LE_OK != packageDownloader_GetFwUpdateState(&fwUpdateState))
+        || (ReferenceFwUpdateState != fwUpdateState))
+    {
+        LE_ERROR("Unexpected FW update state");
+        result = LE_FAULT;
+    }
+
+    if (LE_OK != ListFiles(&files))
+    {
+        return LE_FAULT;
+    }
+
+    for (i = 0; i < files.count; i++)
+    {
+        if (NULL == bsearch(files.paths[i], ReferenceFiles.paths, ReferenceFiles.count,
+                            FILE_PATH_BYTES, ComparePaths))
+        {
+            LE_ERROR("Orphaned file: %s", files.paths[i]);
+            result = LE_FAULT;
+        }
+    }
+
+    for (i = 0; i < ReferenceFiles.count; i++)
+    {
+        if (NULL == bsearch(ReferenceFiles.paths[i], files.paths, files.count,
+                            FILE_PATH_BYTES, ComparePaths))
+        {
+            LE_ERROR("Missing file: %s", ReferenceFiles.paths[i]);
+            result = LE_FAULT;
+        }
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate a power loss before an operation and check the download recovery
+ *
+ * @return
+ *  - LE_OK         The download was recovered
+ *  - LE_NOT_FOUND  The operation was not reached
+ *  - LE_FAULT      The download was not recovered
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t TestCrashPoint
+(
+    uint32_t  operation,            ///< [IN] Crash point operation
+    uint64_t  referenceBytes,       ///< [IN] Bytes downloaded without power loss
+    uint64_t* redownloadedPtr,      ///< [OUT] Bytes downloaded again because of the power loss
+    FILE*     metricsFilePtr        ///< [IN] Metrics file, NULL if not used
+)
+{
+    uint64_t startBytes;
+    uint64_t restartBytes;
+    uint64_t crashBytes;
+    uint64_t totalBytes;
+
+    LE_ASSERT_OK(RemoveTree(LEFS_ROOT_PATH));
+    startBytes = GetTransferredBytes();
+
+    if (LE_OK != RunStep(StartNewDownload, (void*)(uintptr_t)operation))
+    {
+        LE_ERROR("Crash point %"PRIu32": download failed", operation);
+        return LE_FAULT;
+    }
+
+    if (!CrashPoint.isReached)
+    {
+        LE_WARN("Crash point %"PRIu32": operation not reached", operation);
+        return LE_NOT_FOUND;
+    }
+
+    // Reset: the storage is restored as it was at the power loss
+    LE_ASSERT_OK(CopyTree(SNAPSHOT_PATH, LEFS_ROOT_PATH));
+    crashBytes = CrashPoint.transferredBytes - startBytes;
+    restartBytes = GetTransferredBytes();
+
+    if (LE_OK != RunStep(RestartDownloader, NULL))
+    {
+        LE_ERROR("Crash point %"PRIu32" (%s %s): restart failed",
+                 operation, CrashPoint.typePtr, CrashPoint.path);
+        return LE_FAULT;
+    }
+
+    restartBytes = GetTransferredBytes() - restartBytes;
+    totalBytes = crashBytes + restartBytes;
+    *redownloadedPtr = (totalBytes > referenceBytes) ? (totalBytes - referenceBytes) : 0;
+
+    printf("power loss before %s %s (operation %"PRIu32"): %"PRIu64" bytes downloaded before, "
+           "%"PRIu64" after, %"PRIu64" downloaded again\n",
+           CrashPoint.typePtr, CrashPoint.path, operation,
+           crashBytes, restartBytes, *redownloadedPtr);
+
+    if (metricsFilePtr)
+    {
+        fprintf(metricsFilePtr, "%"PRIu32",%s,%s,%"PRIu64",%"PRIu64",%"PRIu64"\n",
+                operation, CrashPoint.typePtr, CrashPoint.path,
+                crashBytes, restartBytes, *redownloadedPtr);
+    }
+
+    if (LE_OK != CheckFinalState())
+    {
+        LE_ERROR("Crash point %"PRIu32" (%s %s): download not recovered",
+                 operation, CrashPoint.typePtr, CrashPoint.path);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the power-loss fault injection test.
+ *
+ * The downloader functions are called in the test thread, which must run its event loop.
+ *
+ * @return
+ *  - LE_OK     The package was correctly recovered for all crash points
+ *  - LE_FAULT  Otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t powerLoss_Run
+(
+    le_thread_Ref_t testThreadRef   ///< [IN] Test thread
+)
+{
+    const char* metricsPathPtr = NULL;
+    FILE* metricsFilePtr = NULL;
+    unsigned long stride = 0;
+    uint64_t referenceBytes;
+    uint64_t worstRedownloaded = 0;
+    uint32_t worstOperation = 0;
+    char worstOperationName[FILE_PATH_BYTES + 8] = "";
+    unsigned int crashPoints = 0;
+    unsigned int failures = 0;
+    size_t imageOperations = 0;
+    size_t imageIndex = 0;
+    size_t i;
+
+    LE_INFO("======== START power-loss test of PACKAGE DOWNLOADER ========");
+
+    for (i = 0; i < le_arg_NumArgs(); i++)
+    {
+        const char* argPtr = le_arg_GetArg(i);
+
+        if ((0 == strcmp(argPtr, "--stride")) && (le_arg_GetArg(i + 1)))
+        {
+            stride = strtoul(le_arg_GetArg(++i), NULL, 10);
+        }
+        else if ((0 == strcmp(argPtr, "--metrics")) && (le_arg_GetArg(i + 1)))
+        {
+            metricsPathPtr = le_arg_GetArg(++i);
+        }
+    }
+
+    TestThreadRef = testThreadRef;
+    StepSemRef = le_sem_Create("powerLossStep", 0);
+    EndSemRef = le_sem_Create("powerLossEnd", 0);
+
+    LE_ASSERT_OK(GetExecPath(PackagePath));
+    LE_ASSERT((strlen(PackagePath) + strlen(DOWNLOAD_URI)) < sizeof(PackagePath));
+    strncat(PackagePath, DOWNLOAD_URI, strlen(DOWNLOAD_URI));
+
+    // Download without power loss: the operations are recorded and the final state is the
+    // reference state
+    LE_ASSERT_OK(RemoveTree(LEFS_ROOT_PATH));
+    referenceBytes = GetTransferredBytes();
+    IsRecording = true;
+    LE_ASSERT_OK(RunStep(StartNewDownload, NULL));
+    IsRecording = false;
+    referenceBytes = GetTransferredBytes() - referenceBytes;
+
+    LE_ASSERT_OK(CheckDownloadedFile(PackagePath));
+    LE_ASSERT_OK(ListFiles(&ReferenceFiles));
+    LE_ASSERT_OK(packageDownloader_GetFwUpdateState(&ReferenceFwUpdateState));
+
+    for (i = 0; i < RecordedOperations; i++)
+    {
+        if (IsImageOperationPtr[i])
+        {
+            imageOperations++;
+        }
+    }
+
+    if (0 == stride)
+    {
+        stride = imageOperations / DEFAULT_IMAGE_CRASH_POINTS;
+        if (0 == stride)
+        {
+            stride = 1;
+        }
+    }
+
+    LE_INFO("%zu operations, %zu image writes, %"PRIu64" bytes downloaded, stride %lu",
+            RecordedOperations, imageOperations, referenceBytes, stride);
+
+    if (metricsPathPtr)
+    {
+        metricsFilePtr = fopen(metricsPathPtr, "w");
+        if (!metricsFilePtr)
+        {
+            LE_ERROR("Unable to create %s: %m", metricsPathPtr);
+            return LE_FAULT;
+        }
+        fprintf(metricsFilePtr, "operation,type,file,downloaded_before,downloaded_after,"
+                                "downloaded_again\n");
+    }
+
+    for (i = 0; i < RecordedOperations; i++)
+    {
+        uint64_t redownloaded = 0;
+
+        // Every operation on the state files, every Nth write of the firmware image
+        if (IsImageOperationPtr[i])
+        {
+            imageIndex++;
+            if (0 != (imageIndex % stride))
+            {
+                continue;
+            }
+        }
+
+        switch (TestCrashPoint((uint32_t)(i + 1), referenceBytes, &redownloaded, metricsFilePtr))
+        {
+            case LE_OK:
+                crashPoints++;
+                if (redownloaded > worstRedownloaded)
+                {
+                    worstRedownloaded = redownloaded;
+                    worstOperation = (uint32_t)(i + 1);
+                    snprintf(worstOperationName, sizeof(worstOperationName), "%s %s",
+                             CrashPoint.typePtr, CrashPoint.path);
+                }
+                break;
+
+            case LE_NOT_FOUND:
+                break;
+
+            default:
+                crashPoints++;
+                failures++;
+                break;
+        }
+    }
+
+    if (metricsFilePtr)
+    {
+        fclose(metricsFilePtr);
+    }
+
+    printf("power loss: %u crash points, %u failures, worst-case %"PRIu64" bytes downloaded "
+           "again (operation %"PRIu32" %s), package %"PRIu64" bytes\n",
+           crashPoints, failures, worstRedownloaded, worstOperation, worstOperationName,
+           referenceBytes);
+
+    RemoveTree(SNAPSHOT_PATH);
+    free(IsImageOperationPtr);
+    IsImageOperationPtr = NULL;
+    le_sem_Delete(StepSemRef);
+    le_sem_Delete(EndSemRef);
+    EndSemRef = NULL;
+
+    LE_INFO("======== power-loss test of PACKAGE DOWNLOADER FINISHED ========");
+
+    return (failures) ? LE_FAULT : LE_OK;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file powerLoss.h
+ *
+ * Power-loss fault injection on the package download and persistence paths
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_PACKAGEDOWNLOADER_POWERLOSS
+#define LEGATO_PACKAGEDOWNLOADER_POWERLOSS
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the power-loss fault injection test.
+ *
+ * The downloader functions are called in the test thread, which must run its event loop.
+ *
+ * @return
+ *  - LE_OK     The package was correctly recovered for all crash points
+ *  - LE_FAULT  Otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t powerLoss_Run
+(
+    le_thread_Ref_t testThreadRef   ///< [IN] Test thread
+);
+
+#endif
@@ -0,0 +1,376 @@
+/**
+ * This module implements the unit tests for the SenML encoder.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "senml.h"
+
+#include <math.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Size of the encoding buffer
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_BUFFER_BYTES                   4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Benchmark layout: a record holding several resources sampled at a fixed period
+ */
+//--------------------------------------------------------------------------------------------------
+#define BENCH_RESOURCE_FMT                  "/myApp/sensors/sensor%02d/value"
+#define BENCH_NUM_RESOURCES                 8
+#define BENCH_NUM_SAMPLES                   16
+#define BENCH_START_TIME_MS                 1500000000000ULL
+#define BENCH_PERIOD_MS                     250
+#define BENCH_NUM_ITERATIONS                1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Golden vector 1: integer values sharing a path prefix and a timestamp
+ */
+//--------------------------------------------------------------------------------------------------
+static const senml_Record_t Vector1[] =
+{
+    { .name = "/app/sensor/temp", .timestamp = 1500000000000ULL,
+      .type = SENML_VALUE_INT, .value.intValue = 21 },
+    { .name = "/app/sensor/hum",  .timestamp = 1500000000000ULL,
+      .type = SENML_VALUE_INT, .value.intValue = 40 },
+};
+
+static const uint8_t Vector1FactoredCbor[] =
+{
+    0x82,
+    0xa5,
+    0x21, 0x6c, '/', 'a', 'p', 'p', '/', 's', 'e', 'n', 's', 'o', 'r', '/',
+    0x22, 0x1a, 0x59, 0x68, 0x2f, 0x00,
+    0x24, 0x15,
+    0x00, 0x64, 't', 'e', 'm', 'p',
+    0x02, 0x00,
+    0xa2,
+    0x00, 0x63, 'h', 'u', 'm',
+    0x02, 0x13,
+};
+
+static const char Vector1FactoredJson[] =
+    "[{\"bn\":\"/app/sensor/\",\"bt\":1500000000,\"bv\":21,\"n\":\"temp\",\"v\":0},"
+    "{\"n\":\"hum\",\"v\":19}]";
+
+static const char Vector1Json[] =
+    "[{\"n\":\"/app/sensor/temp\",\"t\":1500000000,\"v\":21},"
+    "{\"n\":\"/app/sensor/hum\",\"t\":1500000000,\"v\":40}]";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Golden vector 2: string and boolean values with sub-second timestamps
+ */
+//--------------------------------------------------------------------------------------------------
+static const senml_Record_t Vector2[] =
+{
+    { .name = "/dev/status", .timestamp = 1000, .type = SENML_VALUE_STRING,
+      .value.strValuePtr = "ok" },
+    { .name = "/dev/alarm",  .timestamp = 1500, .type = SENML_VALUE_BOOL,
+      .value.boolValue = true },
+};
+
+static const uint8_t Vector2FactoredCbor[] =
+{
+    0x82,
+    0xa4,
+    0x21, 0x65, '/', 'd', 'e', 'v', '/',
+    0x22, 0x01,
+    0x00, 0x66, 's', 't', 'a', 't', 'u', 's',
+    0x03, 0x62, 'o', 'k',
+    0xa3,
+    0x00, 0x65, 'a', 'l', 'a', 'r', 'm',
+    0x06, 0xfa, 0x3f, 0x00, 0x00, 0x00,
+    0x04, 0xf5,
+};
+
+static const char Vector2FactoredJson[] =
+    "[{\"bn\":\"/dev/\",\"bt\":1,\"n\":\"status\",\"vs\":\"ok\"},"
+    "{\"n\":\"alarm\",\"t\":0.5,\"vb\":true}]";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Golden vector 3: float value, string escaping, null value and per-record error
+ */
+//--------------------------------------------------------------------------------------------------
+static const senml_Record_t Vector3[] =
+{
+    { .name = "/a/float",  .type = SENML_VALUE_FLOAT, .value.floatValue = 0.1 },
+    { .name = "/a/string", .type = SENML_VALUE_STRING, .value.strValuePtr = "q\"\\\n\x01" },
+    { .name = "/a/null",   .type = SENML_VALUE_NONE },
+    { .name = "/a/denied", .errorCode = 132 },
+};
+
+static const uint8_t Vector3FactoredCbor[] =
+{
+    0x84,
+    0xa3,
+    0x21, 0x63, '/', 'a', '/',
+    0x00, 0x65, 'f', 'l', 'o', 'a', 't',
+    0x02, 0xfb, 0x3f, 0xb9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a,
+    0xa2,
+    0x00, 0x66, 's', 't', 'r', 'i', 'n', 'g',
+    0x03, 0x65, 'q', '"', '\\', '\n', 0x01,
+    0xa2,
+    0x00, 0x64, 'n', 'u', 'l', 'l',
+    0x03, 0x66, '(', 'n', 'u', 'l', 'l', ')',
+    0xa2,
+    0x00, 0x66, 'd', 'e', 'n', 'i', 'e', 'd',
+    0x63, 'e', 'r', 'r', 0x18, 0x84,
+};
+
+static const char Vector3FactoredJson[] =
+    "[{\"bn\":\"/a/\",\"n\":\"float\",\"v\":0.1},"
+    "{\"n\":\"string\",\"vs\":\"q\\\"\\\\\\n\\u0001\"},"
+    "{\"n\":\"null\",\"vs\":\"(null)\"},"
+    "{\"n\":\"denied\",\"err\":132}]";
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode records and compare the result with the expected encoding
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckEncoding
+(
+    senml_Format_t format,
+    const senml_Record_t* recordArr,
+    size_t numRecords,
+    bool isFactored,
+    const uint8_t* expectedPtr,
+    size_t expectedLen
+)
+{
+    uint8_t buf[TEST_BUFFER_BYTES];
+    size_t len = sizeof(buf);
+
+    LE_ASSERT_OK(senml_EncodePack(format, recordArr, numRecords, isFactored, buf, &len));
+
+    if ((len != expectedLen) || (0 != memcmp(buf, expectedPtr, len)))
+    {
+        LE_ERROR("Encoding mismatch, got %zu bytes, expected %zu bytes", len, expectedLen);
+        LE_DUMP(buf, len);
+        LE_DUMP(expectedPtr, expectedLen);
+        LE_FATAL("SenML golden vector mismatch");
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the encoders against the golden vectors
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestGoldenVectors
+(
+    void
+)
+{
+    LE_INFO("============= Test SenML golden vectors ==============");
+
+    CheckEncoding(SENML_FORMAT_CBOR, Vector1, NUM_ARRAY_MEMBERS(Vector1), true,
+                  Vector1FactoredCbor, sizeof(Vector1FactoredCbor));
+    CheckEncoding(SENML_FORMAT_JSON, Vector1, NUM_ARRAY_MEMBERS(Vector1), true,
+                  (const uint8_t*)Vector1FactoredJson, strlen(Vector1FactoredJson));
+    CheckEncoding(SENML_FORMAT_JSON, Vector1, NUM_ARRAY_MEMBERS(Vector1), false,
+                  (const uint8_t*)Vector1Json, strlen(Vector1Json));
+
+    CheckEncoding(SENML_FORMAT_CBOR, Vector2, NUM_ARRAY_MEMBERS(Vector2), true,
+                  Vector2FactoredCbor, sizeof(Vector2FactoredCbor));
+    CheckEncoding(SENML_FORMAT_JSON, Vector2, NUM_ARRAY_MEMBERS(Vector2), true,
+                  (const uint8_t*)Vector2FactoredJson, strlen(Vector2FactoredJson));
+
+    CheckEncoding(SENML_FORMAT_CBOR, Vector3, NUM_ARRAY_MEMBERS(Vector3), true,
+                  Vector3FactoredCbor, sizeof(Vector3FactoredCbor));
+    CheckEncoding(SENML_FORMAT_JSON, Vector3, NUM_ARRAY_MEMBERS(Vector3), true,
+                  (const uint8_t*)Vector3FactoredJson, strlen(Vector3FactoredJson));
+
+    // An empty pack is an empty array.
+    CheckEncoding(SENML_FORMAT_CBOR, NULL, 0, true, (const uint8_t*)"\x80", 1);
+    CheckEncoding(SENML_FORMAT_JSON, NULL, 0, true, (const uint8_t*)"[]", 2);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the error cases and the content format negotiation helpers
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestErrors
+(
+    void
+)
+{
+    uint8_t buf[TEST_BUFFER_BYTES];
+    size_t len;
+    senml_Format_t format;
+    senml_Record_t noName = { .name = NULL, .type = SENML_VALUE_INT };
+    senml_Record_t infinite = { .name = "/a/b", .type = SENML_VALUE_FLOAT,
+                                .value.floatValue = INFINITY };
+
+    LE_INFO("============= Test SenML errors ==============");
+
+    // Buffer too small for the pack
+    len = sizeof(Vector1FactoredCbor) - 1;
+    LE_ASSERT(LE_OVERFLOW == senml_EncodePack(SENML_FORMAT_CBOR, Vector1,
+                                              NUM_ARRAY_MEMBERS(Vector1), true, buf, &len));
+    len = strlen(Vector1FactoredJson) - 1;
+    LE_ASSERT(LE_OVERFLOW == senml_EncodePack(SENML_FORMAT_JSON, Vector1,
+                                              NUM_ARRAY_MEMBERS(Vector1), true, buf, &len));
+
+    // Invalid parameters
+    len = sizeof(buf);
+    LE_ASSERT(LE_BAD_PARAMETER == senml_EncodePack(SENML_FORMAT_MAX, Vector1,
+                                                   NUM_ARRAY_MEMBERS(Vector1), true, buf, &len));
+    LE_ASSERT(LE_BAD_PARAMETER == senml_EncodePack(SENML_FORMAT_CBOR, &noName, 1, true,
+                                                   buf, &len));
+    LE_ASSERT(LE_BAD_PARAMETER == senml_EncodePack(SENML_FORMAT_CBOR, Vector1,
+                                                   NUM_ARRAY_MEMBERS(Vector1), true, NULL, &len));
+
+    // JSON has no representation of infinity, CBOR has one.
+    LE_ASSERT(LE_BAD_PARAMETER == senml_EncodePack(SENML_FORMAT_JSON, &infinite, 1, true,
+                                                   buf, &len));
+    len = sizeof(buf);
+    LE_ASSERT_OK(senml_EncodePack(SENML_FORMAT_CBOR, &infinite, 1, true, buf, &len));
+
+    // Content formats
+    LE_ASSERT(SENML_CONTENT_FORMAT_CBOR == senml_GetContentFormat(SENML_FORMAT_CBOR));
+    LE_ASSERT(SENML_CONTENT_FORMAT_JSON == senml_GetContentFormat(SENML_FORMAT_JSON));
+    LE_ASSERT_OK(senml_GetFormat(SENML_CONTENT_FORMAT_JSON, &format));
+    LE_ASSERT(SENML_FORMAT_JSON == format);
+    LE_ASSERT_OK(senml_GetFormat(SENML_CONTENT_FORMAT_CBOR, &format));
+    LE_ASSERT(SENML_FORMAT_CBOR == format);
+    LE_ASSERT(LE_NOT_FOUND == senml_GetFormat(60, &format));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the benchmark records and return the encoded size and the mean encoding time
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t BenchmarkEncoding
+(
+    senml_Format_t format,
+    const senml_Record_t* recordArr,
+    size_t numRecords,
+    bool isFactored,
+    double* usPerPackPtr
+)
+{
+    static uint8_t buf[BENCH_NUM_RESOURCES * BENCH_NUM_SAMPLES * 128];
+    size_t len = 0;
+    int i;
+
+    le_clk_Time_t start = le_clk_GetRelativeTime();
+
+    for (i = 0; i < BENCH_NUM_ITERATIONS; i++)
+    {
+        len = sizeof(buf);
+        LE_ASSERT_OK(senml_EncodePack(format, recordArr, numRecords, isFactored, buf, &len));
+    }
+
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), start);
+    *usPerPackPtr = ((double)elapsed.sec * 1000000 + elapsed.usec) / BENCH_NUM_ITERATIONS;
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare the size of the SenML representations with and without factoring, on a typical time
+ * series record.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestSizeBenchmark
+(
+    void
+)
+{
+    char names[BENCH_NUM_RESOURCES][64];
+    senml_Record_t recordArr[BENCH_NUM_RESOURCES * BENCH_NUM_SAMPLES];
+    size_t numRecords = 0;
+    size_t sizes[SENML_FORMAT_MAX][2];
+    double usPerPack;
+    int sample;
+    int res;
+
+    LE_INFO("============= SenML size benchmark ==============");
+
+    for (res = 0; res < BENCH_NUM_RESOURCES; res++)
+    {
+        snprintf(names[res], sizeof(names[res]), BENCH_RESOURCE_FMT, res);
+    }
+
+    // Records are ordered by timestamp, then by resource, as a time series record is pushed.
+    for (sample = 0; sample < BENCH_NUM_SAMPLES; sample++)
+    {
+        for (res = 0; res < BENCH_NUM_RESOURCES; res++)
+        {
+            senml_Record_t* recordPtr = &recordArr[numRecords++];
+
+            memset(recordPtr, 0, sizeof(senml_Record_t));
+            recordPtr->name = names[res];
+            recordPtr->timestamp = BENCH_START_TIME_MS + (sample * BENCH_PERIOD_MS);
+            recordPtr->type = SENML_VALUE_INT;
+            recordPtr->value.intValue = 20000 + (res * 100) + (sample % 7);
+        }
+    }
+
+    senml_Format_t format;
+    for (format = 0; format < SENML_FORMAT_MAX; format++)
+    {
+        int factored;
+        for (factored = 0; factored < 2; factored++)
+        {
+            sizes[format][factored] = BenchmarkEncoding(format, recordArr, numRecords,
+                                                        factored, &usPerPack);
+            LE_INFO("%zu records, %s %s: %zu bytes (%.1f bytes/record), %.1f us/pack",
+                    numRecords,
+                    (SENML_FORMAT_CBOR == format) ? "SenML-CBOR" : "SenML-JSON",
+                    factored ? "factored" : "plain",
+                    sizes[format][factored],
+                    (double)sizes[format][factored] / numRecords,
+                    usPerPack);
+        }
+
+        // Factoring always saves the repeated path prefix and the absolute timestamps.
+        LE_ASSERT(sizes[format][1] < sizes[format][0]);
+    }
+
+    LE_ASSERT(sizes[SENML_FORMAT_CBOR][1] < sizes[SENML_FORMAT_JSON][1]);
+    LE_INFO("Factored SenML-CBOR is %.0f%% of plain SenML-JSON",
+            (100.0 * sizes[SENML_FORMAT_CBOR][1]) / sizes[SENML_FORMAT_JSON][0]);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * main of the test
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start senmlUnitTest =====================");
+
+    // Test - encodings against golden vectors
+    TestGoldenVectors();
+
+    // Test - error cases
+    TestErrors();
+
+    // Benchmark - encoded size with and without factoring
+    TestSizeBenchmark();
+
+    LE_INFO("=============== senmlUnitTest successful ===================");
+
+    exit(EXIT_SUCCESS);
+}
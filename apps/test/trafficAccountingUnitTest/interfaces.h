@@ -0,0 +1,13 @@
+/**
+ * This module implements some stubs for trafficAccounting unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _INTERFACES_H
+#define _INTERFACES_H
+
+#include "le_avc_interface.h"
+
+#endif /* interfaces.h */
@@ -0,0 +1,378 @@
+/**
+ * This module implements the unit tests for the traffic accounting.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "trafficAccounting.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fixture file providing the network interface counters
+ */
+//--------------------------------------------------------------------------------------------------
+#define COUNTERS_FILE           "/tmp/trafficAccountingUnitTest_dev"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Interface counters file header, as provided by /proc/net/dev
+ */
+//--------------------------------------------------------------------------------------------------
+#define COUNTERS_HEADER \
+    "Inter-|   Receive                                                |  Transmit\n" \
+    " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs " \
+    "drop fifo colls carrier compressed\n"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes after which the totals are stored, must match the traffic accounting module
+ */
+//--------------------------------------------------------------------------------------------------
+#define SAVE_THRESHOLD_BYTES    (64 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stub functions of the filesystem
+ */
+//--------------------------------------------------------------------------------------------------
+int stub_GetFsWriteCount(void);
+void stub_ResetFsWriteCount(void);
+void stub_EraseFs(void);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bytes expected for each purpose, counted by the stubbed transports
+ */
+//--------------------------------------------------------------------------------------------------
+static trafficAccounting_Counters_t Expected[TRAFFICACCOUNTING_PURPOSE_MAX];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the interface counters fixture file, with the lo, wlan0 and rmnet_data0 interfaces
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteCountersFile
+(
+    uint64_t wlanRx,        ///< [IN] Bytes received on wlan0
+    uint64_t wlanTx,        ///< [IN] Bytes sent on wlan0
+    uint64_t rmnetRx,       ///< [IN] Bytes received on rmnet_data0
+    uint64_t rmnetTx        ///< [IN] Bytes sent on rmnet_data0
+)
+{
+    FILE* filePtr = fopen(COUNTERS_FILE, "w");
+    LE_ASSERT(NULL != filePtr);
+
+    fprintf(filePtr, COUNTERS_HEADER);
+    fprintf(filePtr, "    lo:    1234      12    0    0    0     0          0         0"
+                     "     1234      12    0    0    0     0       0          0\n");
+    fprintf(filePtr, " wlan0: %"PRIu64"     100    0    0    0     0          0         0"
+                     " %"PRIu64"      90    0    0    0     0       0          0\n",
+            wlanRx, wlanTx);
+    fprintf(filePtr, "rmnet_data0:%"PRIu64"      50    0    0    0     0          0         0"
+                     " %"PRIu64"      40    0    0    0     0       0          0\n",
+            rmnetRx, rmnetTx);
+
+    LE_ASSERT(0 == fclose(filePtr));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed UDP transport: send a datagram of the LwM2M session
+ */
+//--------------------------------------------------------------------------------------------------
+static void StubUdpSend
+(
+    size_t length       ///< [IN] Datagram length
+)
+{
+    trafficAccounting_Add(TRAFFICACCOUNTING_PURPOSE_SESSION, length, 0);
+    Expected[TRAFFICACCOUNTING_PURPOSE_SESSION].txBytes += length;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed UDP transport: receive a datagram of the LwM2M session
+ */
+//--------------------------------------------------------------------------------------------------
+static void StubUdpReceive
+(
+    size_t length       ///< [IN] Datagram length
+)
+{
+    trafficAccounting_Add(TRAFFICACCOUNTING_PURPOSE_SESSION, 0, length);
+    Expected[TRAFFICACCOUNTING_PURPOSE_SESSION].rxBytes += length;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed push: the payload is sent within the LwM2M session
+ */
+//--------------------------------------------------------------------------------------------------
+static void StubPush
+(
+    size_t length       ///< [IN] Payload length
+)
+{
+    trafficAccounting_Add(TRAFFICACCOUNTING_PURPOSE_PUSH, length, 0);
+    Expected[TRAFFICACCOUNTING_PURPOSE_PUSH].txBytes += length;
+    StubUdpSend(length + 40);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed HTTP transport: receive a package chunk
+ */
+//--------------------------------------------------------------------------------------------------
+static void StubDownload
+(
+    trafficAccounting_Purpose_t purpose,    ///< [IN] FOTA or SOTA
+    size_t                      length      ///< [IN] Chunk length
+)
+{
+    trafficAccounting_Add(purpose, 0, length);
+    Expected[purpose].rxBytes += length;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the totals of all purposes against the bytes counted by the stubbed transports
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckPurposeCounters
+(
+    void
+)
+{
+    trafficAccounting_Counters_t counters;
+    int purpose;
+
+    for (purpose = 0; purpose < TRAFFICACCOUNTING_PURPOSE_MAX; purpose++)
+    {
+        LE_ASSERT_OK(trafficAccounting_GetPurposeCounters(purpose, &counters));
+        LE_ASSERT(Expected[purpose].txBytes == counters.txBytes);
+        LE_ASSERT(Expected[purpose].rxBytes == counters.rxBytes);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the interface counters parsing
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestInterfaceCounters
+(
+    void
+)
+{
+    trafficAccounting_Counters_t counters;
+
+    LE_INFO("======== TestInterfaceCounters ========");
+
+    WriteCountersFile(5000000000ULL, 2000, 300, 400);
+    trafficAccounting_SetInterfaceCountersFile(COUNTERS_FILE);
+
+    LE_ASSERT_OK(trafficAccounting_GetInterfaceCounters("wlan0", &counters));
+    LE_ASSERT(5000000000ULL == counters.rxBytes);
+    LE_ASSERT(2000 == counters.txBytes);
+
+    // No space between the interface name and the counters
+    LE_ASSERT_OK(trafficAccounting_GetInterfaceCounters("rmnet_data0", &counters));
+    LE_ASSERT(300 == counters.rxBytes);
+    LE_ASSERT(400 == counters.txBytes);
+
+    LE_ASSERT_OK(trafficAccounting_GetInterfaceCounters("lo", &counters));
+    LE_ASSERT(1234 == counters.rxBytes);
+
+    // Prefix of an existing interface name
+    LE_ASSERT(LE_NOT_FOUND == trafficAccounting_GetInterfaceCounters("wlan", &counters));
+    LE_ASSERT(LE_NOT_FOUND == trafficAccounting_GetInterfaceCounters("eth0", &counters));
+    LE_ASSERT(LE_BAD_PARAMETER == trafficAccounting_GetInterfaceCounters(NULL, &counters));
+    LE_ASSERT(LE_BAD_PARAMETER == trafficAccounting_GetInterfaceCounters("wlan0", NULL));
+
+    // Missing counters file
+    trafficAccounting_SetInterfaceCountersFile("/tmp/trafficAccountingUnitTest_missing");
+    LE_ASSERT(LE_FAULT == trafficAccounting_GetInterfaceCounters("wlan0", &counters));
+    trafficAccounting_SetInterfaceCountersFile(COUNTERS_FILE);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the bearer counters collection across bearer changes
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestBearerCollection
+(
+    void
+)
+{
+    trafficAccounting_Counters_t counters;
+
+    LE_INFO("======== TestBearerCollection ========");
+
+    WriteCountersFile(1000, 2000, 300, 400);
+    trafficAccounting_SetBearerInterface("wlan0");
+    trafficAccounting_StartBearerCollection();
+
+    LE_ASSERT_OK(trafficAccounting_GetBearerCounters(&counters));
+    LE_ASSERT((0 == counters.rxBytes) && (0 == counters.txBytes));
+
+    // Traffic on the Wi-Fi bearer only
+    WriteCountersFile(1500, 2100, 800, 400);
+    LE_ASSERT_OK(trafficAccounting_GetBearerCounters(&counters));
+    LE_ASSERT((500 == counters.rxBytes) && (100 == counters.txBytes));
+
+    // Switch to the cellular bearer: the Wi-Fi traffic is kept
+    trafficAccounting_SetBearerInterface("rmnet_data0");
+    WriteCountersFile(9999, 9999, 1800, 450);
+    LE_ASSERT_OK(trafficAccounting_GetBearerCounters(&counters));
+    LE_ASSERT((1500 == counters.rxBytes) && (150 == counters.txBytes));
+
+    // Same bearer notified again
+    trafficAccounting_SetBearerInterface("rmnet_data0");
+    LE_ASSERT_OK(trafficAccounting_GetBearerCounters(&counters));
+    LE_ASSERT((1500 == counters.rxBytes) && (150 == counters.txBytes));
+
+    // Interface recreated: its counters restart from zero
+    WriteCountersFile(9999, 9999, 100, 20);
+    LE_ASSERT_OK(trafficAccounting_GetBearerCounters(&counters));
+    LE_ASSERT((600 == counters.rxBytes) && (120 == counters.txBytes));
+
+    // Stopped collection: the counters are frozen
+    trafficAccounting_StopBearerCollection();
+    WriteCountersFile(9999, 9999, 5000, 5000);
+    LE_ASSERT_OK(trafficAccounting_GetBearerCounters(&counters));
+    LE_ASSERT((600 == counters.rxBytes) && (120 == counters.txBytes));
+
+    // Restarted collection: the counters are reset
+    trafficAccounting_StartBearerCollection();
+    LE_ASSERT_OK(trafficAccounting_GetBearerCounters(&counters));
+    LE_ASSERT((0 == counters.rxBytes) && (0 == counters.txBytes));
+    trafficAccounting_StopBearerCollection();
+
+    LE_ASSERT(LE_BAD_PARAMETER == trafficAccounting_GetBearerCounters(NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the traffic accounting per purpose, using stubbed transports
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestPurposeCounters
+(
+    void
+)
+{
+    trafficAccounting_Counters_t counters;
+    int i;
+
+    LE_INFO("======== TestPurposeCounters ========");
+
+    stub_EraseFs();
+    LE_ASSERT_OK(trafficAccounting_Init());
+    memset(Expected, 0, sizeof(Expected));
+    CheckPurposeCounters();
+
+    // LwM2M session with a push
+    for (i = 0; i < 10; i++)
+    {
+        StubUdpSend(120 + i);
+        StubUdpReceive(80 + i);
+    }
+    StubPush(512);
+    CheckPurposeCounters();
+
+    // Firmware and software package downloads
+    for (i = 0; i < 8; i++)
+    {
+        StubDownload(TRAFFICACCOUNTING_PURPOSE_FOTA, 4096);
+        StubDownload(TRAFFICACCOUNTING_PURPOSE_SOTA, 1024);
+    }
+    CheckPurposeCounters();
+
+    LE_ASSERT(LE_BAD_PARAMETER == trafficAccounting_GetPurposeCounters(
+                                                TRAFFICACCOUNTING_PURPOSE_MAX, &counters));
+    LE_ASSERT(LE_BAD_PARAMETER == trafficAccounting_GetPurposeCounters(
+                                                TRAFFICACCOUNTING_PURPOSE_SESSION, NULL));
+
+    // Invalid purpose is ignored
+    trafficAccounting_Add(TRAFFICACCOUNTING_PURPOSE_MAX, 100, 100);
+    CheckPurposeCounters();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the storage of the totals
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestPersistence
+(
+    void
+)
+{
+    LE_INFO("======== TestPersistence ========");
+
+    // No write for each datagram
+    trafficAccounting_Save();
+    stub_ResetFsWriteCount();
+    StubUdpSend(100);
+    StubUdpReceive(100);
+    LE_ASSERT(0 == stub_GetFsWriteCount());
+
+    // Write once the threshold is reached
+    StubDownload(TRAFFICACCOUNTING_PURPOSE_FOTA, SAVE_THRESHOLD_BYTES);
+    LE_ASSERT(1 == stub_GetFsWriteCount());
+
+    // Explicit save only when the totals changed
+    trafficAccounting_Save();
+    LE_ASSERT(1 == stub_GetFsWriteCount());
+    StubPush(10);
+    trafficAccounting_Save();
+    LE_ASSERT(2 == stub_GetFsWriteCount());
+
+    // Restart: the stored totals are restored
+    LE_ASSERT_OK(trafficAccounting_Init());
+    CheckPurposeCounters();
+
+    // Restart without saving: the unsaved bytes are lost
+    StubUdpSend(100);
+    LE_ASSERT_OK(trafficAccounting_Init());
+    Expected[TRAFFICACCOUNTING_PURPOSE_SESSION].txBytes -= 100;
+    CheckPurposeCounters();
+
+    // Reset is stored
+    trafficAccounting_ResetPurposeCounters();
+    memset(Expected, 0, sizeof(Expected));
+    LE_ASSERT_OK(trafficAccounting_Init());
+    CheckPurposeCounters();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the test.
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start trafficAccountingUnitTest =====================");
+
+    // Test - interface counters parsing
+    TestInterfaceCounters();
+
+    // Test - bearer counters across bearer changes
+    TestBearerCollection();
+
+    // Test - traffic per purpose
+    TestPurposeCounters();
+
+    // Test - storage of the totals
+    TestPersistence();
+
+    unlink(COUNTERS_FILE);
+
+    LE_INFO("=============== trafficAccountingUnitTest successful ===================");
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,151 @@
+/**
+ * This module implements some stubs for trafficAccounting unit tests.
+ *
+ * The AVC filesystem is stubbed with a single in-memory file counting its writes.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "avcFs.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of the stubbed file
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_FILE_MAX_BYTES     256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stubbed file
+ */
+//--------------------------------------------------------------------------------------------------
+static char    FilePath[PATH_MAX];
+static uint8_t FileData[STUB_FILE_MAX_BYTES];
+static size_t  FileSize = 0;
+static bool    FileExists = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of file writes since the last reset
+ */
+//--------------------------------------------------------------------------------------------------
+static int WriteCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of file writes since the last reset
+ */
+//--------------------------------------------------------------------------------------------------
+int stub_GetFsWriteCount
+(
+    void
+)
+{
+    return WriteCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the number of file writes
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_ResetFsWriteCount
+(
+    void
+)
+{
+    WriteCount = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete the stubbed file
+ */
+//--------------------------------------------------------------------------------------------------
+void stub_EraseFs
+(
+    void
+)
+{
+    FileExists = false;
+    FileSize = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// File system stubbing
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * ReadFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t ReadFs
+(
+    const char* pathPtr,   ///< File path
+    uint8_t*    bufPtr,    ///< Data buffer
+    size_t*     sizePtr    ///< Buffer size
+)
+{
+    if ((!FileExists) || (0 != strcmp(pathPtr, FilePath)))
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (*sizePtr < FileSize)
+    {
+        return LE_OVERFLOW;
+    }
+
+    memcpy(bufPtr, FileData, FileSize);
+    *sizePtr = FileSize;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * WriteFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t WriteFs
+(
+    const char* pathPtr,   ///< File path
+    uint8_t*    bufPtr,    ///< Data buffer
+    size_t      size       ///< Buffer size
+)
+{
+    WriteCount++;
+
+    if (size > STUB_FILE_MAX_BYTES)
+    {
+        return LE_NO_MEMORY;
+    }
+
+    LE_ASSERT(LE_OK == le_utf8_Copy(FilePath, pathPtr, sizeof(FilePath), NULL));
+    memcpy(FileData, bufPtr, size);
+    FileSize = size;
+    FileExists = true;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * ExistsFs() stub.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t ExistsFs
+(
+    const char* pathPtr ///< File path
+)
+{
+    if ((FileExists) && (0 == strcmp(pathPtr, FilePath)))
+    {
+        return LE_OK;
+    }
+
+    return LE_NOT_FOUND;
+}
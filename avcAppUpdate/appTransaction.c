@@ -0,0 +1,1065 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file appTransaction.c
+ *
+ * Implementation of the atomic installation of several application packages and uninstalls.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "appTransaction.h"
+#include "avcFs.h"
+#include "avcFsConfig.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Staged operation with the dependencies of its application
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    appTransaction_Item_t item;                                 ///< Operation
+    char   dependencies[APP_TRANSACTION_MAX_DEPENDENCIES][LE_LIMIT_APP_NAME_LEN + 1];
+                                                                ///< Applications serving its
+                                                                ///< bindings
+    size_t dependencyCount;                                     ///< Number of dependencies
+}
+Item_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Journal of a transaction being installed
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    appTransaction_State_t state;                               ///< Transaction state
+    int32_t                rollbackIndex;                       ///< System of the transaction start
+    size_t                 count;                               ///< Number of operations
+    appTransaction_Item_t  items[APP_TRANSACTION_MAX_ITEMS];    ///< Operations
+}
+Journal_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Transaction state
+ */
+//--------------------------------------------------------------------------------------------------
+static appTransaction_State_t State = APP_TRANSACTION_STATE_IDLE;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Staged operations
+ */
+//--------------------------------------------------------------------------------------------------
+static Item_t Items[APP_TRANSACTION_MAX_ITEMS];
+static size_t ItemCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operations in the order they are applied, and index of the current one
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t Order[APP_TRANSACTION_MAX_ITEMS];
+static size_t Step = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * System index at the start of the transaction
+ */
+//--------------------------------------------------------------------------------------------------
+static int32_t RollbackIndex = -1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Whether the probation of the installed system is locked by the transaction
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsProbationLocked = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result of the last transaction
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t LastResult = LE_OK;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Directory of the staged packages
+ */
+//--------------------------------------------------------------------------------------------------
+static char StagingDir[PATH_MAX] = "";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handlers registered by the application update module
+ */
+//--------------------------------------------------------------------------------------------------
+static appTransaction_StepHandlerFunc_t StepHandler = NULL;
+static appTransaction_ResultHandlerFunc_t ResultHandler = NULL;
+static void* HandlerContextPtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the path of a staged package
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetPackagePath
+(
+    uint16_t instanceId,            ///< [IN] Object 9 instance of the package
+    char* pathPtr,                  ///< [OUT] Path of the staged package
+    size_t pathSize                 ///< [IN] Size of the path buffer
+)
+{
+    snprintf(pathPtr, pathSize, "%s/%"PRIu16".update", StagingDir, instanceId);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find a staged operation by application name
+ *
+ * @return
+ *  - Staged operation, NULL if not found
+ */
+//--------------------------------------------------------------------------------------------------
+static Item_t* FindItemByApp
+(
+    const char* appNamePtr          ///< [IN] Application name
+)
+{
+    size_t i;
+
+    if ('\0' == appNamePtr[0])
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < ItemCount; i++)
+    {
+        if (0 == strcmp(Items[i].item.appName, appNamePtr))
+        {
+            return &Items[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if an operation can be staged
+ *
+ * @return
+ *  - LE_OK             The operation can be staged
+ *  - LE_BAD_PARAMETER  No transaction is open or the application name is invalid
+ *  - LE_DUPLICATE      An operation is already staged for the instance or the application
+ *  - LE_NO_MEMORY      Too many operations
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CheckNewItem
+(
+    uint16_t instanceId,            ///< [IN] Object 9 instance
+    const char* appNamePtr          ///< [IN] Application name
+)
+{
+    size_t i;
+
+    if ((APP_TRANSACTION_STATE_STAGING != State) || (NULL == appNamePtr) ||
+        (strlen(appNamePtr) > LE_LIMIT_APP_NAME_LEN))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    for (i = 0; i < ItemCount; i++)
+    {
+        if (Items[i].item.instanceId == instanceId)
+        {
+            return LE_DUPLICATE;
+        }
+    }
+
+    if (FindItemByApp(appNamePtr))
+    {
+        return LE_DUPLICATE;
+    }
+
+    if (ItemCount >= APP_TRANSACTION_MAX_ITEMS)
+    {
+        LE_ERROR("Too many operations in the transaction");
+        return LE_NO_MEMORY;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a staged operation
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddItem
+(
+    appTransaction_Operation_t operation,   ///< [IN] Operation
+    uint16_t instanceId,                    ///< [IN] Object 9 instance
+    const char* appNamePtr                  ///< [IN] Application name
+)
+{
+    Item_t* itemPtr = &Items[ItemCount++];
+
+    memset(itemPtr, 0, sizeof(Item_t));
+    itemPtr->item.operation = operation;
+    itemPtr->item.instanceId = instanceId;
+    le_utf8_Copy(itemPtr->item.appName, appNamePtr, sizeof(itemPtr->item.appName), NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if an application depends on another one
+ *
+ * @return
+ *  - true if the application uses an interface served by the other one
+ */
+//--------------------------------------------------------------------------------------------------
+static bool DependsOn
+(
+    const Item_t* itemPtr,          ///< [IN] Staged operation of the application
+    const char* appNamePtr          ///< [IN] Other application
+)
+{
+    size_t i;
+
+    if ('\0' == appNamePtr[0])
+    {
+        return false;
+    }
+
+    for (i = 0; i < itemPtr->dependencyCount; i++)
+    {
+        if (0 == strcmp(itemPtr->dependencies[i], appNamePtr))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the order of the operations: the packages are installed before their clients, then the
+ * applications are removed after their clients.
+ *
+ * @return
+ *  - LE_OK             The order is computed
+ *  - LE_NOT_PERMITTED  The operations are inconsistent
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t OrderItems
+(
+    void
+)
+{
+    bool isOrdered[APP_TRANSACTION_MAX_ITEMS] = {false};
+    size_t orderCount = 0;
+    size_t i;
+    size_t j;
+
+    // A new package cannot depend on an application which is removed
+    for (i = 0; i < ItemCount; i++)
+    {
+        for (j = 0; j < ItemCount; j++)
+        {
+            if ((APP_TRANSACTION_INSTALL == Items[i].item.operation) &&
+                (APP_TRANSACTION_UNINSTALL == Items[j].item.operation) &&
+                (DependsOn(&Items[i], Items[j].item.appName)))
+            {
+                LE_ERROR("%s depends on %s, which is removed",
+                         Items[i].item.appName, Items[j].item.appName);
+                return LE_NOT_PERMITTED;
+            }
+        }
+    }
+
+    while (orderCount < ItemCount)
+    {
+        size_t previousCount = orderCount;
+
+        for (i = 0; (i < ItemCount) && (orderCount == previousCount); i++)
+        {
+            bool isReady = !isOrdered[i];
+
+            for (j = 0; (j < ItemCount) && (isReady); j++)
+            {
+                if ((isOrdered[j]) || (i == j) ||
+                    (Items[i].item.operation != Items[j].item.operation))
+                {
+                    continue;
+                }
+
+                // The uninstalls start when all the operations are installed
+                if (APP_TRANSACTION_UNINSTALL == Items[i].item.operation)
+                {
+                    isReady = (!DependsOn(&Items[j], Items[i].item.appName));
+                }
+                else
+                {
+                    isReady = (!DependsOn(&Items[i], Items[j].item.appName));
+                }
+            }
+
+            for (j = 0; (j < ItemCount) && (isReady); j++)
+            {
+                if ((APP_TRANSACTION_UNINSTALL == Items[i].item.operation) &&
+                    (APP_TRANSACTION_INSTALL == Items[j].item.operation) && (!isOrdered[j]))
+                {
+                    isReady = false;
+                }
+            }
+
+            if (isReady)
+            {
+                isOrdered[i] = true;
+                Order[orderCount++] = i;
+            }
+        }
+
+        if (orderCount == previousCount)
+        {
+            LE_ERROR("Circular dependency between the applications of the transaction");
+            return LE_NOT_PERMITTED;
+        }
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the journal of the transaction
+ */
+//--------------------------------------------------------------------------------------------------
+static void SaveJournal
+(
+    void
+)
+{
+    Journal_t journal;
+    size_t i;
+
+    memset(&journal, 0, sizeof(journal));
+    journal.state = State;
+    journal.rollbackIndex = RollbackIndex;
+    journal.count = ItemCount;
+    for (i = 0; i < ItemCount; i++)
+    {
+        journal.items[i] = Items[i].item;
+    }
+
+    if (LE_OK != WriteFs(SW_UPDATE_TRANSACTION_PATH, (uint8_t*)&journal, sizeof(journal)))
+    {
+        LE_ERROR("Failed to save the transaction journal");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the transaction and delete the staged packages
+ */
+//--------------------------------------------------------------------------------------------------
+static void Reset
+(
+    void
+)
+{
+    if (IsProbationLocked)
+    {
+        le_updateCtrl_UnlockProbation();
+        IsProbationLocked = false;
+    }
+
+    DeleteFs(SW_UPDATE_TRANSACTION_PATH);
+
+    if ((le_dir_IsDir(StagingDir)) && (LE_OK != le_dir_RemoveRecursive(StagingDir)))
+    {
+        LE_WARN("Failed to delete '%s'", StagingDir);
+    }
+
+    State = APP_TRANSACTION_STATE_IDLE;
+    ItemCount = 0;
+    Step = 0;
+    RollbackIndex = -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End the transaction and report its result
+ */
+//--------------------------------------------------------------------------------------------------
+static void Finish
+(
+    le_result_t result              ///< [IN] Result of the transaction
+)
+{
+    appTransaction_Item_t items[APP_TRANSACTION_MAX_ITEMS];
+    size_t count = ItemCount;
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        items[i] = Items[i].item;
+    }
+
+    Reset();
+    LastResult = result;
+
+    LE_INFO("Transaction of %zu operations ended: %s", count, LE_RESULT_TXT(result));
+
+    if (ResultHandler)
+    {
+        ResultHandler(result, items, count, HandlerContextPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restart on the system of the start of the transaction
+ */
+//--------------------------------------------------------------------------------------------------
+static void RollBack
+(
+    void
+)
+{
+    LE_WARN("Rolling back to system %"PRId32, RollbackIndex);
+
+    State = APP_TRANSACTION_STATE_ROLLING_BACK;
+    SaveJournal();
+
+    // The supervisor restarts the framework on the last good system, the result is reported by
+    // appTransaction_Init() after the restart
+    le_updateCtrl_FailProbation();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle the failure of an operation
+ */
+//--------------------------------------------------------------------------------------------------
+static void Fail
+(
+    void
+)
+{
+    size_t i;
+
+    for (i = 0; i < ItemCount; i++)
+    {
+        if (Items[i].item.isDone)
+        {
+            RollBack();
+            return;
+        }
+    }
+
+    // Nothing was applied to the system
+    Finish(LE_FAULT);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stream a staged package to the update daemon
+ *
+ * @return
+ *  - LE_OK             The package is being unpacked
+ *  - LE_FAULT          The package cannot be read or the update daemon is busy
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartPackage
+(
+    const Item_t* itemPtr           ///< [IN] Staged installation
+)
+{
+    char path[PATH_MAX];
+    int fd;
+
+    GetPackagePath(itemPtr->item.instanceId, path, sizeof(path));
+
+    fd = open(path, O_RDONLY);
+    if (-1 == fd)
+    {
+        LE_ERROR("Unable to open '%s' (%m)", path);
+        return LE_FAULT;
+    }
+
+    // The file descriptor is closed by the messaging API
+    if (LE_OK != le_update_Start(fd))
+    {
+        LE_ERROR("Unable to start the update of instance %"PRIu16, itemPtr->item.instanceId);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lock the probation, so that the system modified by the transaction is not marked good before
+ * the transaction ends
+ *
+ * @return
+ *  - LE_OK             The probation is locked
+ *  - LE_DUPLICATE      The current system is already marked good, there is no probation to lock
+ *  - Other error of le_updateCtrl_LockProbation()
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t LockProbation
+(
+    void
+)
+{
+    le_result_t result;
+
+    if (IsProbationLocked)
+    {
+        return LE_OK;
+    }
+
+    result = le_updateCtrl_LockProbation();
+    if (LE_OK == result)
+    {
+        IsProbationLocked = true;
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mark the current operation as applied. The probation of the new system must be locked, else
+ * the system is rolled back.
+ *
+ * @return
+ *  - LE_OK             The next operation can be applied
+ *  - LE_FAULT          The probation could not be locked, the system is being rolled back
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CompleteStep
+(
+    void
+)
+{
+    le_result_t result;
+
+    Items[Order[Step]].item.isDone = true;
+    Step++;
+    SaveJournal();
+
+    result = LockProbation();
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to lock the probation (%s)", LE_RESULT_TXT(result));
+        RollBack();
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Apply the operations from the current one, until an operation waits for the update daemon
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunSteps
+(
+    void
+)
+{
+    while (Step < ItemCount)
+    {
+        Item_t* itemPtr = &Items[Order[Step]];
+
+        LE_INFO("Transaction step %zu/%zu: %s %s (instance %"PRIu16")", Step + 1, ItemCount,
+                (APP_TRANSACTION_INSTALL == itemPtr->item.operation) ? "install" : "remove",
+                itemPtr->item.appName, itemPtr->item.instanceId);
+
+        if (StepHandler)
+        {
+            StepHandler(&itemPtr->item, HandlerContextPtr);
+        }
+
+        if (APP_TRANSACTION_INSTALL == itemPtr->item.operation)
+        {
+            if (LE_OK != StartPackage(itemPtr))
+            {
+                Fail();
+            }
+            return;
+        }
+
+        if (LE_OK != le_appRemove_Remove(itemPtr->item.appName))
+        {
+            LE_ERROR("Failed to remove %s", itemPtr->item.appName);
+            Fail();
+            return;
+        }
+
+        if (LE_OK != CompleteStep())
+        {
+            return;
+        }
+    }
+
+    Finish(LE_OK);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the staged packages from the current one, then start to apply the operations
+ */
+//--------------------------------------------------------------------------------------------------
+static void ValidateNext
+(
+    void
+)
+{
+    // The installations are ordered first
+    if ((Step < ItemCount) && (APP_TRANSACTION_INSTALL == Items[Order[Step]].item.operation))
+    {
+        if (LE_OK != StartPackage(&Items[Order[Step]]))
+        {
+            Finish(LE_FORMAT_ERROR);
+        }
+        return;
+    }
+
+    // The probation is locked before the system is modified. The current system may already be
+    // marked good: the probation of the system created by the first operation is then locked by
+    // CompleteStep().
+    le_result_t result = LockProbation();
+    if ((LE_OK != result) && (LE_DUPLICATE != result))
+    {
+        LE_ERROR("Failed to lock the probation (%s)", LE_RESULT_TXT(result));
+        Finish(LE_NOT_POSSIBLE);
+        return;
+    }
+
+    State = APP_TRANSACTION_STATE_INSTALLING;
+    Step = 0;
+    SaveJournal();
+    RunSteps();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the transactions, and report the result of a transaction interrupted by a restart.
+ */
+//--------------------------------------------------------------------------------------------------
+void appTransaction_Init
+(
+    const char* stagingDirPtr,                      ///< [IN] Directory of the staged packages
+    appTransaction_StepHandlerFunc_t stepHandler,   ///< [IN] Handler called before an operation
+    appTransaction_ResultHandlerFunc_t resultHandler,
+                                                    ///< [IN] Handler of the result
+    void* contextPtr                                ///< [IN] Context of the handlers
+)
+{
+    Journal_t journal;
+    size_t size = sizeof(journal);
+    bool isAllDone = true;
+    int32_t currentIndex;
+    size_t i;
+
+    le_utf8_Copy(StagingDir, stagingDirPtr, sizeof(StagingDir), NULL);
+    StepHandler = stepHandler;
+    ResultHandler = resultHandler;
+    HandlerContextPtr = contextPtr;
+    State = APP_TRANSACTION_STATE_IDLE;
+    IsProbationLocked = false;
+
+    if ((LE_OK != ReadFs(SW_UPDATE_TRANSACTION_PATH, (uint8_t*)&journal, &size)) ||
+        (sizeof(journal) != size) || (journal.count > APP_TRANSACTION_MAX_ITEMS))
+    {
+        // Operations staged before the restart are discarded
+        Reset();
+        return;
+    }
+
+    memset(Items, 0, sizeof(Items));
+    for (i = 0; i < journal.count; i++)
+    {
+        Items[i].item = journal.items[i];
+        isAllDone = isAllDone && journal.items[i].isDone;
+    }
+    ItemCount = journal.count;
+    RollbackIndex = journal.rollbackIndex;
+    State = journal.state;
+
+    currentIndex = le_update_GetCurrentSysIndex();
+    LE_INFO("Transaction interrupted in state %d, system %"PRId32" (started on %"PRId32")",
+            State, currentIndex, RollbackIndex);
+
+    if (currentIndex == RollbackIndex)
+    {
+        Finish(LE_FAULT);
+    }
+    else if ((APP_TRANSACTION_STATE_INSTALLING == State) && (isAllDone))
+    {
+        Finish(LE_OK);
+    }
+    else if (APP_TRANSACTION_STATE_INSTALLING == State)
+    {
+        RollBack();
+    }
+    else
+    {
+        LE_CRIT("System %"PRId32" not restored", RollbackIndex);
+        Finish(LE_UNAVAILABLE);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the state of the transaction
+ *
+ * @return
+ *  - State of the transaction
+ */
+//--------------------------------------------------------------------------------------------------
+appTransaction_State_t appTransaction_GetState
+(
+    void
+)
+{
+    return State;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the transaction drives the update daemon
+ *
+ * @return
+ *  - true if the update progress must be reported to appTransaction_UpdateProgress()
+ */
+//--------------------------------------------------------------------------------------------------
+bool appTransaction_IsRunning
+(
+    void
+)
+{
+    return ((APP_TRANSACTION_STATE_VALIDATING == State) ||
+            (APP_TRANSACTION_STATE_INSTALLING == State));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a transaction
+ *
+ * @return
+ *  - LE_OK             The transaction is open
+ *  - LE_BUSY           A transaction is already open
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_Begin
+(
+    void
+)
+{
+    if (APP_TRANSACTION_STATE_IDLE != State)
+    {
+        return LE_BUSY;
+    }
+
+    Reset();
+
+    if (LE_OK != le_dir_MakePath(StagingDir, S_IRWXU))
+    {
+        LE_ERROR("Failed to create '%s'", StagingDir);
+        return LE_FAULT;
+    }
+
+    State = APP_TRANSACTION_STATE_STAGING;
+    LE_INFO("Transaction open");
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stage the installation of a downloaded package. The package is moved to the staging directory.
+ *
+ * @return
+ *  - LE_OK             The installation is staged
+ *  - LE_BAD_PARAMETER  No transaction is open or a parameter is invalid
+ *  - LE_DUPLICATE      An operation is already staged for the instance
+ *  - LE_NO_MEMORY      Too many operations
+ *  - LE_FAULT          The package cannot be moved
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_StageInstall
+(
+    uint16_t instanceId,            ///< [IN] Object 9 instance of the package
+    const char* appNamePtr,         ///< [IN] Application name, empty if not known yet
+    const char* packagePathPtr      ///< [IN] Downloaded package
+)
+{
+    char path[PATH_MAX];
+    le_result_t result;
+
+    if (NULL == packagePathPtr)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    result = CheckNewItem(instanceId, appNamePtr);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    GetPackagePath(instanceId, path, sizeof(path));
+    if (0 != rename(packagePathPtr, path))
+    {
+        LE_ERROR("Failed to move '%s' to '%s' (%m)", packagePathPtr, path);
+        return LE_FAULT;
+    }
+
+    AddItem(APP_TRANSACTION_INSTALL, instanceId, appNamePtr);
+    LE_INFO("Install of instance %"PRIu16" (%s) staged", instanceId, appNamePtr);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stage the removal of an application
+ *
+ * @return
+ *  - LE_OK             The removal is staged
+ *  - LE_BAD_PARAMETER  No transaction is open or a parameter is invalid
+ *  - LE_DUPLICATE      An operation is already staged for the instance
+ *  - LE_NO_MEMORY      Too many operations
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_StageUninstall
+(
+    uint16_t instanceId,            ///< [IN] Object 9 instance of the application
+    const char* appNamePtr          ///< [IN] Application name
+)
+{
+    le_result_t result;
+
+    if ((NULL == appNamePtr) || ('\0' == appNamePtr[0]))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    result = CheckNewItem(instanceId, appNamePtr);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    AddItem(APP_TRANSACTION_UNINSTALL, instanceId, appNamePtr);
+    LE_INFO("Removal of %s staged", appNamePtr);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Declare that an application uses an interface served by another application
+ *
+ * @return
+ *  - LE_OK             The dependency is recorded
+ *  - LE_BAD_PARAMETER  No transaction is open or a parameter is invalid
+ *  - LE_NOT_FOUND      The application is not staged
+ *  - LE_NO_MEMORY      Too many dependencies
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_AddDependency
+(
+    const char* appNamePtr,         ///< [IN] Staged application
+    const char* serverAppNamePtr    ///< [IN] Application serving one of its bindings
+)
+{
+    Item_t* itemPtr;
+
+    if ((APP_TRANSACTION_STATE_STAGING != State) || (NULL == appNamePtr) ||
+        (NULL == serverAppNamePtr) || ('\0' == serverAppNamePtr[0]) ||
+        (strlen(serverAppNamePtr) > LE_LIMIT_APP_NAME_LEN))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    itemPtr = FindItemByApp(appNamePtr);
+    if (NULL == itemPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if ((0 == strcmp(appNamePtr, serverAppNamePtr)) || (DependsOn(itemPtr, serverAppNamePtr)))
+    {
+        return LE_OK;
+    }
+
+    if (itemPtr->dependencyCount >= APP_TRANSACTION_MAX_DEPENDENCIES)
+    {
+        return LE_NO_MEMORY;
+    }
+
+    le_utf8_Copy(itemPtr->dependencies[itemPtr->dependencyCount++], serverAppNamePtr,
+                 sizeof(itemPtr->dependencies[0]), NULL);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check and apply the staged operations. The result is reported to the result handler, which can
+ * be called before this function returns.
+ *
+ * @return
+ *  - LE_OK             The transaction is started
+ *  - LE_BAD_PARAMETER  No transaction is open
+ *  - LE_BUSY           The current system is not marked good yet, the transaction stays open
+ *  - Result of the transaction if it ended
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_Commit
+(
+    void
+)
+{
+    le_result_t result;
+
+    if (APP_TRANSACTION_STATE_STAGING != State)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if (0 == ItemCount)
+    {
+        Finish(LE_OK);
+        return LE_OK;
+    }
+
+    // The rollback restores the last good system, which must be the current one
+    if (LE_UPDATECTRL_SYSTEMSTATE_GOOD != le_updateCtrl_GetSystemState())
+    {
+        LE_WARN("Current system in probation, transaction postponed");
+        return LE_BUSY;
+    }
+
+    result = OrderItems();
+    if (LE_OK != result)
+    {
+        Finish(result);
+        return result;
+    }
+
+    RollbackIndex = le_update_GetCurrentSysIndex();
+    LE_INFO("Commit transaction of %zu operations on system %"PRId32, ItemCount, RollbackIndex);
+
+    State = APP_TRANSACTION_STATE_VALIDATING;
+    Step = 0;
+    ValidateNext();
+
+    return (APP_TRANSACTION_STATE_IDLE == State) ? LastResult : LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Discard the staged operations of an open transaction
+ *
+ * @return
+ *  - LE_OK             The transaction is closed
+ *  - LE_BAD_PARAMETER  No transaction is open
+ *  - LE_BUSY           The transaction is already committed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_Abort
+(
+    void
+)
+{
+    if (APP_TRANSACTION_STATE_IDLE == State)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if (APP_TRANSACTION_STATE_STAGING != State)
+    {
+        return LE_BUSY;
+    }
+
+    Reset();
+    LE_INFO("Transaction aborted");
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the progress of the update daemon while the transaction is running
+ */
+//--------------------------------------------------------------------------------------------------
+void appTransaction_UpdateProgress
+(
+    le_update_State_t updateState   ///< [IN] State of the update daemon
+)
+{
+    if (APP_TRANSACTION_STATE_VALIDATING == State)
+    {
+        switch (updateState)
+        {
+            case LE_UPDATE_STATE_DOWNLOAD_SUCCESS:
+                // The package is valid, the unpacked update is discarded
+                le_update_End();
+                Step++;
+                ValidateNext();
+                break;
+
+            case LE_UPDATE_STATE_FAILED:
+                LE_ERROR("Invalid package for instance %"PRIu16,
+                         Items[Order[Step]].item.instanceId);
+                le_update_End();
+                Finish(LE_FORMAT_ERROR);
+                break;
+
+            default:
+                break;
+        }
+    }
+    else if (APP_TRANSACTION_STATE_INSTALLING == State)
+    {
+        switch (updateState)
+        {
+            case LE_UPDATE_STATE_DOWNLOAD_SUCCESS:
+                if (LE_OK != le_update_Install())
+                {
+                    LE_ERROR("Could not start the install");
+                    le_update_End();
+                    Fail();
+                }
+                break;
+
+            case LE_UPDATE_STATE_SUCCESS:
+                le_update_End();
+                if (LE_OK == CompleteStep())
+                {
+                    RunSteps();
+                }
+                break;
+
+            case LE_UPDATE_STATE_FAILED:
+                LE_ERROR("Install of instance %"PRIu16" failed",
+                         Items[Order[Step]].item.instanceId);
+                le_update_End();
+                Fail();
+                break;
+
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,265 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file appTransaction.h
+ *
+ * Atomic installation of several application packages and uninstalls.
+ *
+ * A transaction stages downloaded packages and uninstalls, then commits them together:
+ *  - Validation: every staged package is unpacked by the update daemon and discarded, so that a
+ *    bad package is found before the system is modified.
+ *  - Installation: the packages are installed in dependency order (the applications serving the
+ *    bindings of another application first), then the applications are removed (the clients of
+ *    the bindings first).
+ *  - Rollback: if a step fails after the system was modified, the probation of the new system is
+ *    failed. The supervisor then restarts the framework on the last good system, which is the
+ *    system of the start of the transaction as the probation is locked during the transaction.
+ *
+ * The transaction is saved in a journal once the installation starts, so that its result can be
+ * reported after the rollback restart, or after a restart during the installation.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef LEGATO_APP_TRANSACTION_INCLUDE_GUARD
+#define LEGATO_APP_TRANSACTION_INCLUDE_GUARD
+
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of operations in a transaction
+ */
+//--------------------------------------------------------------------------------------------------
+#define APP_TRANSACTION_MAX_ITEMS           16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of dependencies of an application
+ */
+//--------------------------------------------------------------------------------------------------
+#define APP_TRANSACTION_MAX_DEPENDENCIES    8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the transaction
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    APP_TRANSACTION_STATE_IDLE = 0,         ///< No transaction
+    APP_TRANSACTION_STATE_STAGING,          ///< Operations are being staged
+    APP_TRANSACTION_STATE_VALIDATING,       ///< Staged packages are being checked
+    APP_TRANSACTION_STATE_INSTALLING,       ///< Operations are being applied
+    APP_TRANSACTION_STATE_ROLLING_BACK      ///< Waiting for the restart on the previous system
+}
+appTransaction_State_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operation staged in a transaction
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    APP_TRANSACTION_INSTALL = 0,            ///< Install a package
+    APP_TRANSACTION_UNINSTALL               ///< Remove an application
+}
+appTransaction_Operation_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Staged operation
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    appTransaction_Operation_t operation;           ///< Operation
+    uint16_t                   instanceId;          ///< Object 9 instance of the application
+    char                       appName[LE_LIMIT_APP_NAME_LEN + 1];
+                                                    ///< Application name, empty if not known yet
+    bool                       isDone;              ///< Operation applied to the system
+}
+appTransaction_Item_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called before an operation is applied
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*appTransaction_StepHandlerFunc_t)
+(
+    const appTransaction_Item_t* itemPtr,   ///< [IN] Operation
+    void* contextPtr                        ///< [IN] Context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called with the result of a transaction:
+ *  - LE_OK             All the operations are applied
+ *  - LE_FORMAT_ERROR   A package is invalid, the system is not modified
+ *  - LE_NOT_PERMITTED  The operations are inconsistent, the system is not modified
+ *  - LE_NOT_POSSIBLE   The probation could not be locked, the system is not modified
+ *  - LE_FAULT          An operation failed, the system of the start of the transaction is restored
+ *  - LE_UNAVAILABLE    An operation failed and the system could not be restored
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*appTransaction_ResultHandlerFunc_t)
+(
+    le_result_t result,                     ///< [IN] Result of the transaction
+    const appTransaction_Item_t* itemsPtr,  ///< [IN] Operations, in the order they were staged
+    size_t count,                           ///< [IN] Number of operations
+    void* contextPtr                        ///< [IN] Context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the transactions, and report the result of a transaction interrupted by a restart.
+ */
+//--------------------------------------------------------------------------------------------------
+void appTransaction_Init
+(
+    const char* stagingDirPtr,                      ///< [IN] Directory of the staged packages
+    appTransaction_StepHandlerFunc_t stepHandler,   ///< [IN] Handler called before an operation
+    appTransaction_ResultHandlerFunc_t resultHandler,
+                                                    ///< [IN] Handler of the result
+    void* contextPtr                                ///< [IN] Context of the handlers
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the state of the transaction
+ *
+ * @return
+ *  - State of the transaction
+ */
+//--------------------------------------------------------------------------------------------------
+appTransaction_State_t appTransaction_GetState
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the transaction drives the update daemon
+ *
+ * @return
+ *  - true if the update progress must be reported to appTransaction_UpdateProgress()
+ */
+//--------------------------------------------------------------------------------------------------
+bool appTransaction_IsRunning
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a transaction
+ *
+ * @return
+ *  - LE_OK             The transaction is open
+ *  - LE_BUSY           A transaction is already open
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_Begin
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stage the installation of a downloaded package. The package is moved to the staging directory.
+ *
+ * @return
+ *  - LE_OK             The installation is staged
+ *  - LE_BAD_PARAMETER  No transaction is open or a parameter is invalid
+ *  - LE_DUPLICATE      An operation is already staged for the instance
+ *  - LE_NO_MEMORY      Too many operations
+ *  - LE_FAULT          The package cannot be moved
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_StageInstall
+(
+    uint16_t instanceId,            ///< [IN] Object 9 instance of the package
+    const char* appNamePtr,         ///< [IN] Application name, empty if not known yet
+    const char* packagePathPtr      ///< [IN] Downloaded package
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stage the removal of an application
+ *
+ * @return
+ *  - LE_OK             The removal is staged
+ *  - LE_BAD_PARAMETER  No transaction is open or a parameter is invalid
+ *  - LE_DUPLICATE      An operation is already staged for the instance
+ *  - LE_NO_MEMORY      Too many operations
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_StageUninstall
+(
+    uint16_t instanceId,            ///< [IN] Object 9 instance of the application
+    const char* appNamePtr          ///< [IN] Application name
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Declare that an application uses an interface served by another application
+ *
+ * @return
+ *  - LE_OK             The dependency is recorded
+ *  - LE_BAD_PARAMETER  No transaction is open or a parameter is invalid
+ *  - LE_NOT_FOUND      The application is not staged
+ *  - LE_NO_MEMORY      Too many dependencies
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_AddDependency
+(
+    const char* appNamePtr,         ///< [IN] Staged application
+    const char* serverAppNamePtr    ///< [IN] Application serving one of its bindings
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check and apply the staged operations. The result is reported to the result handler, which can
+ * be called before this function returns.
+ *
+ * @return
+ *  - LE_OK             The transaction is started
+ *  - LE_BAD_PARAMETER  No transaction is open
+ *  - LE_BUSY           The current system is not marked good yet, the transaction stays open
+ *  - Result of the transaction if it ended
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_Commit
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Discard the staged operations of an open transaction
+ *
+ * @return
+ *  - LE_OK             The transaction is closed
+ *  - LE_BAD_PARAMETER  No transaction is open
+ *  - LE_BUSY           The transaction is already committed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t appTransaction_Abort
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the progress of the update daemon while the transaction is running
+ */
+//--------------------------------------------------------------------------------------------------
+void appTransaction_UpdateProgress
+(
+    le_update_State_t updateState   ///< [IN] State of the update daemon
+);
+
+#endif /* LEGATO_APP_TRANSACTION_INCLUDE_GUARD */
@@ -16,9 +16,12 @@
 #include "avcServer.h"
 #include "packageDownloader.h"
 #include "avcAppUpdate.h"
+#include "appTransaction.h"
+#include "healthCheck.h"
 #include "avcFsConfig.h"
 #include "avcFs.h"
 #include "avcClient.h"
+#include "avData.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -93,6 +96,13 @@ static int UpdateReadFd = -1;
 //--------------------------------------------------------------------------------------------------
 static int UpdateStoreFd = -1;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Flag to indicate whether the blocks of the package are allocated in the store file.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsStorePreallocated = false;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Flag to indicate whether install was requested (used during sota resume).
@@ -121,6 +131,21 @@ static size_t TotalCount = 0;
 //--------------------------------------------------------------------------------------------------
 static const char* AppDownloadPath = "/legato/download";
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Directory of the packages staged in a transaction. It is kept out of the download directory,
+ *  which is deleted at the end of each download.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* AppTransactionPath = "/legato/transaction";
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Config tree path of the installed applications, to read their bindings.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_SYSTEM_APPS_PATH "system:/apps"
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Indices for all of the fields of object 9.
@@ -169,6 +194,27 @@ static bool AvmsInstall = false;
 //--------------------------------------------------------------------------------------------------
 static bool UpdateStarted = false;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Application installed from AVMS, whose install is only complete once it passed the health check
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    assetData_InstanceDataRef_t instanceRef;                ///< Object 9 instance
+    char                        appName[LE_LIMIT_APP_NAME_LEN + 1];
+                                                            ///< Application name
+}
+CheckedApp_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Applications waiting for the health check of their install
+ */
+//--------------------------------------------------------------------------------------------------
+static CheckedApp_t CheckedApps[HEALTH_CHECK_MAX_APPS];
+static size_t CheckedAppCount = 0;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Event ID to start download.
@@ -815,6 +861,46 @@ static void MarkInstallComplete
                  LWM2MCORE_SW_UPDATE_RESULT_INSTALLED);
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Defer the install completion of an application to the health check
+ *
+ * @return
+ *      - LE_OK if the application is checked after the install
+ *      - LE_NOT_PERMITTED if the installs are not checked
+ *      - LE_NO_MEMORY if too many applications are checked
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddCheckedApp
+(
+    const char* appNamePtr,                         ///< Application name
+    assetData_InstanceDataRef_t instanceRef         ///< Instance reference
+)
+{
+    if (!healthCheck_IsEnabled())
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    if (CheckedAppCount >= HEALTH_CHECK_MAX_APPS)
+    {
+        LE_WARN("Too many installed applications, %s is not checked", appNamePtr);
+        return LE_NO_MEMORY;
+    }
+
+    CheckedApps[CheckedAppCount].instanceRef = instanceRef;
+    le_utf8_Copy(CheckedApps[CheckedAppCount].appName,
+                 appNamePtr,
+                 sizeof(CheckedApps[CheckedAppCount].appName),
+                 NULL);
+    CheckedAppCount++;
+
+    // Sync file systems, the object 9 instance is marked installed at the end of the check
+    sync();
+
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Delete the setting entry from config tree
@@ -884,8 +970,12 @@ static void AppInstallHandler
             return;
         }
 
-        // Sync file system and mark object 9 status as install completed
-        MarkInstallComplete(instanceRef);
+        // Sync file system and mark object 9 status as install completed, unless the application
+        // needs to pass the health check first
+        if (LE_OK != AddCheckedApp(appNamePtr, instanceRef))
+        {
+            MarkInstallComplete(instanceRef);
+        }
 
         // App is installed but other ancillary works (starting app by supervisor, notifying update
         // agent i.e. avcDaemon via status call back handler etc) may not be finished yet. So don't
@@ -958,6 +1048,13 @@ static void AppUninstallHandler
 
     LE_INFO("Application, '%s,' has been uninstalled.", appNamePtr);
 
+    // The asset data resources of the application are not restored anymore
+    le_result_t result = avData_DeleteAppResources(appNamePtr);
+    if ((LE_OK != result) && (LE_NOT_FOUND != result))
+    {
+        LE_WARN("Resources of %s not deleted: %s", appNamePtr, LE_RESULT_TXT(result));
+    }
+
     if (true == IsHiddenApp(appNamePtr))
     {
         LE_INFO("Application is hidden.");
@@ -990,8 +1087,13 @@ static void AppUninstallHandler
         sync();
 
         LE_DEBUG("Uninstall of application completed.");
-        avcServer_UpdateStatus(LE_AVC_UNINSTALL_COMPLETE, LE_AVC_APPLICATION_UPDATE,
-                               -1, -1, LE_AVC_ERR_NONE, NULL, NULL);
+
+        // The result of a transaction is reported once all its operations are applied
+        if (!appTransaction_IsRunning())
+        {
+            avcServer_UpdateStatus(LE_AVC_UNINSTALL_COMPLETE, LE_AVC_APPLICATION_UPDATE,
+                                   -1, -1, LE_AVC_ERR_NONE, NULL, NULL);
+        }
     }
     else
     {
@@ -1532,6 +1634,111 @@ static void RequestConnection
     avcServer_QueryConnection(LE_AVC_APPLICATION_UPDATE, NULL, NULL);
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Called with the result of the health check of the installed applications. On failure, the
+ *  result is reported before the rollback restarts the framework.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AppHealthCheckHandler
+(
+    le_result_t result,             ///< [IN] Result of the health check
+    bool isRollingBack,             ///< [IN] Whether the last good system is being restored
+    void* contextPtr                ///< [IN] Context
+)
+{
+    size_t i;
+
+    for (i = 0; i < CheckedAppCount; i++)
+    {
+        if (LE_OK == result)
+        {
+            MarkInstallComplete(CheckedApps[i].instanceRef);
+        }
+        else
+        {
+            // Distinct from the install failures reported by the update daemon
+            SetObj9State(CheckedApps[i].instanceRef,
+                         LWM2MCORE_SW_UPDATE_STATE_INITIAL,
+                         LWM2MCORE_SW_UPDATE_RESULT_DEVICE_ERROR);
+        }
+    }
+    CheckedAppCount = 0;
+
+    if (LE_OK == result)
+    {
+        avcServer_UpdateStatus(LE_AVC_INSTALL_COMPLETE, LE_AVC_APPLICATION_UPDATE,
+                               -1, 100, LE_AVC_ERR_NONE, NULL, NULL);
+    }
+    else
+    {
+        LE_ERROR("Installed applications failed their health check%s",
+                 isRollingBack ? ", rolling back" : "");
+        avcServer_UpdateStatus(LE_AVC_INSTALL_FAILED, LE_AVC_APPLICATION_UPDATE,
+                               -1, -1, LE_AVC_ERR_INTERNAL, NULL, NULL);
+    }
+
+    RequestConnection();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Start the health check of the applications installed from AVMS.
+ *
+ * @return
+ *      - LE_OK if the result is reported at the end of the health check
+ *      - LE_NOT_FOUND if no application is checked
+ *      - LE_FAULT if the health check cannot start, the installs are complete
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartHealthCheck
+(
+    void
+)
+{
+    const char* appNames[HEALTH_CHECK_MAX_APPS];
+    size_t appCount = 0;
+    size_t i;
+
+    if (0 == CheckedAppCount)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    // Only the applications started by the supervisor are expected to run
+    for (i = 0; i < CheckedAppCount; i++)
+    {
+        appCfg_Iter_t appIterRef = appCfg_FindApp(CheckedApps[i].appName);
+
+        if (NULL != appIterRef)
+        {
+            if (APPCFG_START_MODE_AUTO == appCfg_GetStartMode(appIterRef))
+            {
+                appNames[appCount++] = CheckedApps[i].appName;
+            }
+            appCfg_DeleteIter(appIterRef);
+        }
+    }
+
+    if (LE_OK != healthCheck_Start(HEALTH_CHECK_APPLICATION,
+                                   appNames,
+                                   appCount,
+                                   AppHealthCheckHandler,
+                                   NULL))
+    {
+        LE_ERROR("Failed to start the health check");
+
+        for (i = 0; i < CheckedAppCount; i++)
+        {
+            MarkInstallComplete(CheckedApps[i].instanceRef);
+        }
+        CheckedAppCount = 0;
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Called during an application install.
@@ -1546,6 +1753,13 @@ static void UpdateProgressHandler
 {
     le_avc_ErrorCode_t avcErrorCode = LE_AVC_ERR_NONE;
 
+    // The packages of a transaction are driven by the transaction
+    if (appTransaction_IsRunning())
+    {
+        appTransaction_UpdateProgress(updateState);
+        return;
+    }
+
     switch (updateState)
     {
         case LE_UPDATE_STATE_UNPACKING:
@@ -1579,19 +1793,26 @@ static void UpdateProgressHandler
 
         case LE_UPDATE_STATE_SUCCESS:
             LE_DEBUG("Install completed.");
-            avcServer_UpdateStatus(LE_AVC_INSTALL_COMPLETE,
-                                   LE_AVC_APPLICATION_UPDATE,
-                                   -1,
-                                   100,
-                                   LE_AVC_ERR_NONE,
-                                   NULL,
-                                   NULL);
+
+            // With a health check, the install result is reported at its end. The connection
+            // is requested anyway, as the registration is one of the probes.
+            if (LE_OK != StartHealthCheck())
+            {
+                avcServer_UpdateStatus(LE_AVC_INSTALL_COMPLETE,
+                                       LE_AVC_APPLICATION_UPDATE,
+                                       -1,
+                                       100,
+                                       LE_AVC_ERR_NONE,
+                                       NULL,
+                                       NULL);
+            }
             RequestConnection();
             le_update_End();
             break;
 
         case LE_UPDATE_STATE_FAILED:
             LE_ERROR("Install/uninstall failed.");
+            CheckedAppCount = 0;
 
             // Get the error code.
             switch (le_update_GetErrorCode())
@@ -1677,6 +1898,13 @@ static void StopStoringPackage
     {
         LE_INFO("Download suspended");
     }
+    else if (result == LE_NO_MEMORY)
+    {
+        SetObj9State(CurrentObj9,
+                     LWM2MCORE_SW_UPDATE_STATE_INITIAL,
+                     LWM2MCORE_SW_UPDATE_RESULT_NOT_ENOUGH_MEMORY);
+        LE_INFO("Download Failed, not enough space");
+    }
     else if (result == LE_OK)
     {
        SetObj9State(CurrentObj9,
@@ -1828,7 +2056,25 @@ static void StoreFdEventHandler
     if (events & POLLIN)
     {
         ssize_t bytesCopied = 0;
-        le_result_t result = CopyBytesToFd(UpdateReadFd, UpdateStoreFd, &bytesCopied);
+        le_result_t result;
+
+        // The package size is known once the download started: the blocks of the whole package
+        // are allocated before the first write
+        if (!IsStorePreallocated)
+        {
+            uint64_t packageSize = 0;
+
+            IsStorePreallocated = true;
+            if (   (LE_OK == packageDownloader_GetUpdatePackageSize(&packageSize))
+                && (packageSize > 0)
+                && (LE_NO_MEMORY == packageDownloader_PreallocateFile(UpdateStoreFd, packageSize)))
+            {
+                StopStoringPackage(LE_NO_MEMORY);
+                return;
+            }
+        }
+
+        result = CopyBytesToFd(UpdateReadFd, UpdateStoreFd, &bytesCopied);
 
         if (LE_FAULT == result)
         {
@@ -1952,6 +2198,7 @@ static le_result_t StartStoringPackage
 
     // Total count should begin from the stored offset for resume.
     TotalCount = offset;
+    IsStorePreallocated = false;
 
     // Create FD monitor for the input FD
     StoreFdMonitor = le_fdMonitor_Create("store", UpdateReadFd, StoreFdEventHandler, POLLIN);
@@ -2232,6 +2479,195 @@ static void SotaRestore
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Declare the applications serving the bindings of an installed application to the transaction,
+ * so that the operations are applied in dependency order.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddAppDependencies
+(
+    const char* appNamePtr          ///< [IN] Staged application
+)
+{
+    char serverAppName[MAX_APP_NAME_BYTES];
+    le_cfg_IteratorRef_t iterRef;
+
+    // The bindings of a new application are not known before its installation
+    if (0 == strlen(appNamePtr))
+    {
+        return;
+    }
+
+    iterRef = le_cfg_CreateReadTxn(CFG_SYSTEM_APPS_PATH);
+    le_cfg_GoToNode(iterRef, appNamePtr);
+    le_cfg_GoToNode(iterRef, "bindings");
+
+    if (LE_OK == le_cfg_GoToFirstChild(iterRef))
+    {
+        do
+        {
+            if ((LE_OK == le_cfg_GetString(iterRef, "app", serverAppName, sizeof(serverAppName),
+                                           "")) && (0 != strlen(serverAppName)))
+            {
+                LE_WARN_IF(LE_OK != appTransaction_AddDependency(appNamePtr, serverAppName),
+                           "Dependency of %s on %s ignored", appNamePtr, serverAppName);
+            }
+        }
+        while (LE_OK == le_cfg_GoToNextSibling(iterRef));
+    }
+
+    le_cfg_CancelTxn(iterRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stage the downloaded package of an object 9 instance in the open transaction
+ *
+ * @return
+ *      - LE_OK if the package is staged.
+ *      - LE_FAULT if there is an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StagePackage
+(
+    uint16_t instanceId,                        ///< [IN] Instance id of the package
+    assetData_InstanceDataRef_t instanceRef     ///< [IN] Instance reference of the package
+)
+{
+    char appName[MAX_APP_NAME_BYTES] = "";
+    char downloadFile[MAX_FILE_PATH_BYTES];
+    le_result_t result;
+
+    // The update daemon only holds one unpacked package: it is unpacked again by the commit
+    if (UpdateStarted)
+    {
+        UpdateStarted = false;
+        le_update_End();
+    }
+
+    // The application name is only known for an upgrade
+    if (LE_OK != assetData_client_GetString(instanceRef, O9F_PKG_NAME, appName, sizeof(appName)))
+    {
+        appName[0] = '\0';
+    }
+
+    le_utf8_Copy(downloadFile, AppDownloadPath, sizeof(downloadFile), NULL);
+    le_utf8_Append(downloadFile, NAME_DOWNLOAD_FILE, sizeof(downloadFile), NULL);
+
+    result = appTransaction_StageInstall(instanceId, appName, downloadFile);
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to stage instance %d (%s)", instanceId, LE_RESULT_TXT(result));
+        SetObj9State(instanceRef,
+                     LWM2MCORE_SW_UPDATE_STATE_INITIAL,
+                     LWM2MCORE_SW_UPDATE_RESULT_INSTALL_FAILURE);
+        CurrentObj9 = NULL;
+        DeletePackage();
+        return LE_FAULT;
+    }
+
+    AddAppDependencies(appName);
+
+    // The instance stays delivered until the commit, and the next package can be downloaded
+    CurrentObj9 = NULL;
+    DeletePackage();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called before an operation of the transaction is applied
+ */
+//--------------------------------------------------------------------------------------------------
+static void TransactionStepHandler
+(
+    const appTransaction_Item_t* itemPtr,   ///< [IN] Operation
+    void* contextPtr                        ///< [IN] Context
+)
+{
+    assetData_InstanceDataRef_t instanceRef = NULL;
+
+    if (LE_OK != assetData_GetInstanceRefById(LWM2M_NAME,
+                                              LWM2M_OBJ9,
+                                              itemPtr->instanceId,
+                                              &instanceRef))
+    {
+        LE_WARN("Object 9 instance %d not found", itemPtr->instanceId);
+        instanceRef = NULL;
+    }
+
+    // The install and uninstall handlers update the object 9 instance of the operation
+    CurrentObj9 = instanceRef;
+    AvmsInstall = (APP_TRANSACTION_INSTALL == itemPtr->operation);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called with the result of a transaction, reported to the server as a single result
+ */
+//--------------------------------------------------------------------------------------------------
+static void TransactionResultHandler
+(
+    le_result_t result,                     ///< [IN] Result of the transaction
+    const appTransaction_Item_t* itemsPtr,  ///< [IN] Operations
+    size_t count,                           ///< [IN] Number of operations
+    void* contextPtr                        ///< [IN] Context
+)
+{
+    le_avc_ErrorCode_t avcErrorCode = LE_AVC_ERR_INTERNAL;
+    assetData_InstanceDataRef_t instanceRef;
+    size_t i;
+
+    CurrentObj9 = NULL;
+    AvmsInstall = false;
+
+    // A session without SOTA operation, nothing to report
+    if (0 == count)
+    {
+        return;
+    }
+
+    if (LE_OK == result)
+    {
+        // With a health check, the transaction result is reported at its end
+        if (LE_OK != StartHealthCheck())
+        {
+            avcServer_UpdateStatus(LE_AVC_INSTALL_COMPLETE, LE_AVC_APPLICATION_UPDATE,
+                                   -1, 100, LE_AVC_ERR_NONE, NULL, NULL);
+        }
+        RequestConnection();
+        return;
+    }
+
+    CheckedAppCount = 0;
+
+    if (LE_FORMAT_ERROR == result)
+    {
+        avcErrorCode = LE_AVC_ERR_BAD_PACKAGE;
+    }
+
+    // All the packages are reported as failed, including the ones installed before the rollback
+    for (i = 0; i < count; i++)
+    {
+        if ((APP_TRANSACTION_INSTALL == itemsPtr[i].operation) &&
+            (LE_OK == assetData_GetInstanceRefById(LWM2M_NAME,
+                                                   LWM2M_OBJ9,
+                                                   itemsPtr[i].instanceId,
+                                                   &instanceRef)))
+        {
+            SetObj9State(instanceRef,
+                         LWM2MCORE_SW_UPDATE_STATE_INITIAL,
+                         LWM2MCORE_SW_UPDATE_RESULT_INSTALL_FAILURE);
+        }
+    }
+
+    avcServer_UpdateStatus(LE_AVC_INSTALL_FAILED, LE_AVC_APPLICATION_UPDATE,
+                           -1, -1, avcErrorCode, NULL, NULL);
+    RequestConnection();
+}
+
 //--------------------------------------------------------------------------------------------------
 // Public functions
 //--------------------------------------------------------------------------------------------------
@@ -2277,6 +2713,12 @@ le_result_t avcApp_StartInstall
         return LE_FAULT;
     }
 
+    // In a transaction, the package is installed with the other ones by the commit
+    if (APP_TRANSACTION_STATE_STAGING == appTransaction_GetState())
+    {
+        return StagePackage(instanceId, instanceRef);
+    }
+
     result = le_update_Install();
 
     if (result == LE_OK)
@@ -2795,6 +3237,15 @@ le_result_t avcApp_DeleteObj9Instance
                 assetData_DeleteInstance(instanceRef);
                 CurrentObj9 = NULL;
             }
+            else if (APP_TRANSACTION_STATE_STAGING == appTransaction_GetState())
+            {
+                // The application is removed by the commit of the transaction
+                result = appTransaction_StageUninstall(instanceId, appName);
+                if (LE_OK == result)
+                {
+                    AddAppDependencies(appName);
+                }
+            }
             else
             {
                 result = StartUninstall(appName);
@@ -2940,6 +3391,43 @@ le_result_t avcApp_GetResumePosition
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a package can be stored in the download directory. The blocks already allocated to the
+ * downloaded package are reused.
+ *
+ * @return
+ *      - LE_OK if the package can be stored.
+ *      - LE_NO_MEMORY if there is not enough free space.
+ *      - LE_FAULT if there is an error.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_CheckStorage
+(
+    uint64_t packageSize    ///< [IN] Package size
+)
+{
+    char downloadFile[MAX_FILE_PATH_BYTES];
+    struct stat fileStat;
+    uint64_t allocatedBytes = 0;
+
+    le_utf8_Copy(downloadFile, AppDownloadPath, sizeof(downloadFile), NULL);
+    le_utf8_Append(downloadFile, NAME_DOWNLOAD_FILE, sizeof(downloadFile), NULL);
+
+    // st_blocks is in 512-byte units
+    if (0 == stat(downloadFile, &fileStat))
+    {
+        allocatedBytes = (uint64_t)fileStat.st_blocks * 512;
+    }
+
+    if (allocatedBytes >= packageSize)
+    {
+        return LE_OK;
+    }
+
+    return packageDownloader_CheckStorage(AppDownloadPath, packageSize - allocatedBytes);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set software update result in asset data and SW update workspace for ongoing update.
@@ -3407,6 +3895,72 @@ le_result_t avcApp_CheckNotificationToSend
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a SOTA transaction. Until the transaction is committed, the install commands stage the
+ * downloaded packages and the object 9 deletions stage the uninstalls.
+ *
+ * When enabled by /apps/avcService/sotaTransaction, avcServer opens a transaction at the start of
+ * each device management session and commits it at the end of the session.
+ *
+ * @return
+ *      - LE_OK if the transaction is open.
+ *      - LE_BUSY if a transaction is already open.
+ *      - LE_FAULT if there is an error.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_BeginTransaction
+(
+    void
+)
+{
+    return appTransaction_Begin();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Commit the SOTA transaction: check the staged packages, install them in dependency order and
+ * roll the system back if an operation fails. The result is reported to the server once.
+ *
+ * @return
+ *      - LE_OK if the transaction is started.
+ *      - LE_BAD_PARAMETER if no transaction is open.
+ *      - LE_BUSY if a package is being downloaded or the system is in probation.
+ *      - Result of the transaction if it ended.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_CommitTransaction
+(
+    void
+)
+{
+    if (NULL != CurrentObj9)
+    {
+        LE_WARN("SOTA operation in progress on %p", CurrentObj9);
+        return LE_BUSY;
+    }
+
+    return appTransaction_Commit();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Abort the SOTA transaction and discard the staged packages.
+ *
+ * @return
+ *      - LE_OK if the transaction is closed.
+ *      - LE_BAD_PARAMETER if no transaction is open.
+ *      - LE_BUSY if the transaction is already committed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_AbortTransaction
+(
+    void
+)
+{
+    return appTransaction_Abort();
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialization function avcApp. Should be called only once.
@@ -3442,4 +3996,7 @@ void avcApp_Init
 
     // Restore SOTA data
     SotaRestore();
+
+    // Report the result of a transaction interrupted by a restart
+    appTransaction_Init(AppTransactionPath, TransactionStepHandler, TransactionResultHandler, NULL);
 }
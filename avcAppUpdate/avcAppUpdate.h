@@ -460,4 +460,72 @@ le_result_t avcApp_GetResumePosition
     size_t* positionPtr
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a package can be stored in the download directory. The blocks already allocated to the
+ * downloaded package are reused.
+ *
+ * @return
+ *      - LE_OK if the package can be stored.
+ *      - LE_NO_MEMORY if there is not enough free space.
+ *      - LE_FAULT if there is an error.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_CheckStorage
+(
+    uint64_t packageSize    ///< [IN] Package size
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a SOTA transaction. Until the transaction is committed, the install commands stage the
+ * downloaded packages and the object 9 deletions stage the uninstalls.
+ *
+ * When enabled by /apps/avcService/sotaTransaction, avcServer opens a transaction at the start of
+ * each device management session and commits it at the end of the session.
+ *
+ * @return
+ *      - LE_OK if the transaction is open.
+ *      - LE_BUSY if a transaction is already open.
+ *      - LE_FAULT if there is an error.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_BeginTransaction
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Commit the SOTA transaction: check the staged packages, install them in dependency order and
+ * roll the system back if an operation fails. The result is reported to the server once.
+ *
+ * @return
+ *      - LE_OK if the transaction is started.
+ *      - LE_BAD_PARAMETER if no transaction is open.
+ *      - LE_BUSY if a package is being downloaded or the system is in probation.
+ *      - Result of the transaction if it ended.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_CommitTransaction
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Abort the SOTA transaction and discard the staged packages.
+ *
+ * @return
+ *      - LE_OK if the transaction is closed.
+ *      - LE_BAD_PARAMETER if no transaction is open.
+ *      - LE_BUSY if the transaction is already committed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcApp_AbortTransaction
+(
+    void
+);
+
 #endif
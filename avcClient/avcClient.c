@@ -13,11 +13,15 @@
 #include <lwm2mcore/lwm2mcore.h>
 #include <lwm2mcore/timer.h>
 #include <lwm2mcore/security.h>
+#include <lwm2mcore/connectivity.h>
 
 #include "legato.h"
 #include "interfaces.h"
 #include "avcClient.h"
 #include "avcServer.h"
+#include "trafficAccounting.h"
+#include "natKeepalive.h"
+#include "osUdp.h"
 
 //--------------------------------------------------------------------------------------------------
 // Definitions
@@ -58,6 +62,20 @@
 //--------------------------------------------------------------------------------------------------
 #define ACTIVITY_TIMER_EVENTS_POOL_SIZE  5
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Length of a short server Id string, including NULL-terminator.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SERVER_ID_BYTES  8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree path of the additional LwM2M servers.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AVC_CLIENT_SERVERS_CFG  "/apps/avcService/servers"
+
 
 //--------------------------------------------------------------------------------------------------
 // Local variables.
@@ -156,6 +174,25 @@ static le_mem_PoolRef_t ActivityTimerEventsPool;
 //--------------------------------------------------------------------------------------------------
 static bool RetryPending = false;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configured LwM2M server: short server Id, 0 if the entry is free, and name
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint16_t serverId;                              ///< LwM2M short server Id
+    char     name[AVC_CLIENT_SERVER_NAME_BYTES];    ///< Server name
+}
+Server_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configured LwM2M servers. The first entry is always the default AirVantage server.
+ */
+//--------------------------------------------------------------------------------------------------
+static Server_t Servers[AVC_CLIENT_MAX_SERVERS];
+
 //--------------------------------------------------------------------------------------------------
 // Local functions
 //--------------------------------------------------------------------------------------------------
@@ -517,6 +554,102 @@ static int PackageEventHandler
     return result;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler sending a NAT keepalive probe through the DTLS session: the registration update is
+ * answered by the server through the binding of the session.
+ *
+ * @return
+ *      - LE_OK if the registration update is sent
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t NatProbeHandler
+(
+    void
+)
+{
+    return avcClient_Update();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of a NAT binding lost by a keepalive probe: the registration update reaches the server
+ * through the new binding.
+ */
+//--------------------------------------------------------------------------------------------------
+static void NatBindingLostHandler
+(
+    void
+)
+{
+    LE_WARN_IF(LE_OK != avcClient_Update(),
+               "Registration update after the NAT binding loss failed");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of a server which did not answer on the address family in use: the session is
+ * reconnected at once, on the other family of the server.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FamilyFallbackHandler
+(
+    void
+)
+{
+    // If the LWM2MCORE_TIMER_STEP timer is running, this means that a connection is active.
+    if ((NULL == Lwm2mInstanceRef) || (!lwm2mcore_TimerIsRunning(LWM2MCORE_TIMER_STEP)))
+    {
+        return;
+    }
+
+    // The session is not reported as stopped while it reconnects
+    RetryPending = true;
+    lwm2mcore_Disconnect(Lwm2mInstanceRef);
+    RetryPending = false;
+
+    if (!lwm2mcore_Connect(Lwm2mInstanceRef))
+    {
+        LE_ERROR("Connect error on the fallback family");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the NAT keepalive of the DM session. The keepalive interval depends on the bearer and on
+ * the operator of the data connection.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartNatKeepalive
+(
+    void
+)
+{
+    char key[NAT_KEEPALIVE_KEY_LEN + 1];
+    lwm2mcore_networkBearer_enum_t bearer;
+    uint16_t mnc = 0;
+    uint16_t mcc = 0;
+    le_result_t result;
+
+    if (LWM2MCORE_ERR_COMPLETED_OK != lwm2mcore_GetNetworkBearer(&bearer))
+    {
+        LE_WARN("Unknown bearer, no NAT keepalive");
+        return;
+    }
+
+    if (LWM2MCORE_ERR_COMPLETED_OK == lwm2mcore_GetMncMcc(&mnc, &mcc))
+    {
+        snprintf(key, sizeof(key), "bearer%d_%03u%02u", bearer, mcc, mnc);
+    }
+    else
+    {
+        snprintf(key, sizeof(key), "bearer%d", bearer);
+    }
+
+    result = natKeepalive_Start(key, NatProbeHandler, NatBindingLostHandler);
+    LE_DEBUG_IF(LE_OK != result, "NAT keepalive not started: %s", LE_RESULT_TXT(result));
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Callback for the LwM2M events.
@@ -565,6 +698,10 @@ static int EventHandler
 
             SessionStarted = false;
             AuthenticationPhase = false;
+            natKeepalive_Stop();
+
+            // Store the session traffic accounted since the last update
+            trafficAccounting_Save();
             break;
 
         case LWM2MCORE_EVENT_LWM2M_SESSION_TYPE_START:
@@ -581,6 +718,7 @@ static int EventHandler
                                        -1, -1, LE_AVC_ERR_NONE, NULL, NULL);
 
                 SessionStarted = true;
+                StartNatKeepalive();
             }
             AuthenticationPhase = false;
             break;
@@ -706,6 +844,7 @@ static void StopBearer
             // Remove the data handler.
             le_data_RemoveConnectionStateHandler(DataHandler);
             DataRef = NULL;
+            DataConnected = false;
         }
 
         // The data connection is closed.
@@ -795,6 +934,87 @@ static void avcClient_RetryTimer
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a configured server.
+ *
+ * @return
+ *      - Server
+ *      - NULL if the server is not configured
+ */
+//--------------------------------------------------------------------------------------------------
+static Server_t* GetServer
+(
+    uint16_t serverId   ///< [IN] LwM2M short server Id
+)
+{
+    int i;
+
+    if (AVC_CLIENT_ANY_SERVER_ID == serverId)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < AVC_CLIENT_MAX_SERVERS; i++)
+    {
+        if (serverId == Servers[i].serverId)
+        {
+            return &Servers[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load the additional LwM2M servers from the AVC service configuration.
+ *
+ * Each server is configured as a node named by its short server Id, e.g.
+ * /apps/avcService/servers/2/name.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadServers
+(
+    void
+)
+{
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(AVC_CLIENT_SERVERS_CFG);
+
+    if (LE_OK == le_cfg_GoToFirstChild(iterRef))
+    {
+        do
+        {
+            char idStr[SERVER_ID_BYTES] = {0};
+            char name[AVC_CLIENT_SERVER_NAME_BYTES] = {0};
+            char* endPtr = NULL;
+            unsigned long serverId;
+
+            if (LE_OK != le_cfg_GetNodeName(iterRef, "", idStr, sizeof(idStr)))
+            {
+                continue;
+            }
+
+            errno = 0;
+            serverId = strtoul(idStr, &endPtr, BASE10);
+            if ((0 != errno) || ('\0' != *endPtr) || (UINT16_MAX < serverId))
+            {
+                LE_ERROR("Invalid server Id '%s'", idStr);
+                continue;
+            }
+
+            le_cfg_GetString(iterRef, "name", name, sizeof(name), "");
+            if (LE_OK != avcClient_AddServer((uint16_t)serverId, name))
+            {
+                LE_ERROR("Unable to add server %lu", serverId);
+            }
+        }
+        while (LE_OK == le_cfg_GoToNextSibling(iterRef));
+    }
+
+    le_cfg_CancelTxn(iterRef);
+}
+
 //--------------------------------------------------------------------------------------------------
 // Public functions
 //--------------------------------------------------------------------------------------------------
@@ -1016,6 +1236,7 @@ le_result_t avcClient_Push
     switch (rc)
     {
         case LWM2MCORE_PUSH_INITIATED:
+            trafficAccounting_Add(TRAFFICACCOUNTING_PURPOSE_PUSH, payloadLength, 0);
             return LE_OK;
         case LWM2MCORE_PUSH_BUSY:
             return LE_BUSY;
@@ -1076,6 +1297,164 @@ le_avc_SessionType_t avcClient_GetSessionType
     return LE_AVC_SESSION_INVALID;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a LwM2M server to the server list. Its device management credentials are read from its own
+ * secure storage namespace when the server objects of the LwM2MCore instance address it.
+ * The AVC client opens a single session, to the default server: the LwM2MCore port does not
+ * support concurrent sessions.
+ *
+ * @return
+ *      - LE_OK if the server is added.
+ *      - LE_BAD_PARAMETER if the server Id is invalid.
+ *      - LE_DUPLICATE if the server is already configured.
+ *      - LE_OVERFLOW if the maximum number of servers is reached.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_AddServer
+(
+    uint16_t serverId,          ///< [IN] LwM2M short server Id
+    const char* namePtr         ///< [IN] Server name
+)
+{
+    int i;
+
+    if ((AVC_CLIENT_ANY_SERVER_ID == serverId) || (NULL == namePtr))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if (NULL != GetServer(serverId))
+    {
+        return LE_DUPLICATE;
+    }
+
+    for (i = 0; i < AVC_CLIENT_MAX_SERVERS; i++)
+    {
+        if (AVC_CLIENT_ANY_SERVER_ID == Servers[i].serverId)
+        {
+            Servers[i].serverId = serverId;
+            if (LE_OK != le_utf8_Copy(Servers[i].name, namePtr, sizeof(Servers[i].name), NULL))
+            {
+                LE_WARN("Server name '%s' truncated", namePtr);
+            }
+            LE_INFO("Server %" PRIu16 " '%s' added", serverId, Servers[i].name);
+            return LE_OK;
+        }
+    }
+
+    LE_ERROR("Too many servers, unable to add server %" PRIu16, serverId);
+    return LE_OVERFLOW;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a LwM2M server from the server list.
+ *
+ * @return
+ *      - LE_OK if the server is removed.
+ *      - LE_NOT_FOUND if the server is not configured.
+ *      - LE_NOT_PERMITTED if the server is the default AirVantage server.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_RemoveServer
+(
+    uint16_t serverId           ///< [IN] LwM2M short server Id
+)
+{
+    Server_t* serverPtr = GetServer(serverId);
+
+    if (NULL == serverPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (AVC_CLIENT_DEFAULT_SERVER_ID == serverId)
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    memset(serverPtr, 0, sizeof(Server_t));
+
+    LE_INFO("Server %" PRIu16 " removed", serverId);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the list of configured LwM2M servers. The default AirVantage server is always the first one.
+ *
+ * @return
+ *      - LE_OK on success.
+ *      - LE_BAD_PARAMETER if a parameter is invalid.
+ *      - LE_OVERFLOW if the list is too small; the list is filled with the first servers.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_GetServerList
+(
+    uint16_t* serverIdListPtr,  ///< [OUT] Short server Ids
+    size_t* numServersPtr       ///< [INOUT] Size of the list, number of servers
+)
+{
+    size_t numServers = 0;
+    int i;
+
+    if ((NULL == serverIdListPtr) || (NULL == numServersPtr))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    for (i = 0; i < AVC_CLIENT_MAX_SERVERS; i++)
+    {
+        if (AVC_CLIENT_ANY_SERVER_ID == Servers[i].serverId)
+        {
+            continue;
+        }
+
+        if (numServers >= *numServersPtr)
+        {
+            return LE_OVERFLOW;
+        }
+        serverIdListPtr[numServers++] = Servers[i].serverId;
+    }
+
+    *numServersPtr = numServers;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the name of a configured LwM2M server.
+ *
+ * @return
+ *      - LE_OK on success.
+ *      - LE_BAD_PARAMETER if a parameter is invalid.
+ *      - LE_NOT_FOUND if the server is not configured.
+ *      - LE_OVERFLOW if the name buffer is too small.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_GetServerName
+(
+    uint16_t serverId,          ///< [IN]  LwM2M short server Id
+    char* namePtr,              ///< [OUT] Server name
+    size_t nameSize             ///< [IN]  Size of the name buffer
+)
+{
+    Server_t* serverPtr = GetServer(serverId);
+
+    if (NULL == namePtr)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if (NULL == serverPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    return le_utf8_Copy(namePtr, serverPtr->name, nameSize, NULL);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function sets up the activity timer.
@@ -1200,9 +1579,19 @@ void avcClient_Init
     // Create retry timer for avcClient connection.
     RetryTimerRef = le_timer_Create("AvcRetryTimer");
 
+    // The default AirVantage server, then the additional servers.
+    LE_ASSERT_OK(avcClient_AddServer(AVC_CLIENT_DEFAULT_SERVER_ID, "AirVantage"));
+    LoadServers();
+
     // Store the calling thread reference.
     LegatoThread = le_thread_GetCurrent();
 
+    // Read the NAT keepalive configuration.
+    natKeepalive_Init();
+
+    // Reconnect the session on the other address family of a server which does not answer.
+    osUdp_SetFamilyFallbackHandler(FamilyFallbackHandler);
+
     // Create pool to report activity timer events.
     ActivityTimerEventsPool = le_mem_CreatePool("ActivityTimerEventsPool", sizeof(bool));
     le_mem_ExpandPool(ActivityTimerEventsPool, ACTIVITY_TIMER_EVENTS_POOL_SIZE);
@@ -16,6 +16,34 @@
 #include "interfaces.h"
 #include <lwm2mcore/lwm2mcore.h>
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of LwM2M servers, including the default AirVantage server.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AVC_CLIENT_MAX_SERVERS          4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Short server Id of the default AirVantage server.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AVC_CLIENT_DEFAULT_SERVER_ID    1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Short server Id used when a credential or a request is not linked to a specific server.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AVC_CLIENT_ANY_SERVER_ID        0
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a server name, including NULL-terminator.
+ */
+//--------------------------------------------------------------------------------------------------
+#define AVC_CLIENT_SERVER_NAME_BYTES    32
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Starts a periodic connection attempt to the AirVantage server.
@@ -119,6 +147,75 @@ le_avc_SessionType_t avcClient_GetSessionType
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a LwM2M server to the server list. Its device management credentials are read from its own
+ * secure storage namespace when the server objects of the LwM2MCore instance address it.
+ * The AVC client opens a single session, to the default server: the LwM2MCore port does not
+ * support concurrent sessions.
+ *
+ * @return
+ *      - LE_OK if the server is added.
+ *      - LE_BAD_PARAMETER if the server Id is invalid.
+ *      - LE_DUPLICATE if the server is already configured.
+ *      - LE_OVERFLOW if the maximum number of servers is reached.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_AddServer
+(
+    uint16_t serverId,          ///< [IN] LwM2M short server Id
+    const char* namePtr         ///< [IN] Server name
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a LwM2M server from the server list.
+ *
+ * @return
+ *      - LE_OK if the server is removed.
+ *      - LE_NOT_FOUND if the server is not configured.
+ *      - LE_NOT_PERMITTED if the server is the default AirVantage server.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_RemoveServer
+(
+    uint16_t serverId           ///< [IN] LwM2M short server Id
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the list of configured LwM2M servers. The default AirVantage server is always the first one.
+ *
+ * @return
+ *      - LE_OK on success.
+ *      - LE_BAD_PARAMETER if a parameter is invalid.
+ *      - LE_OVERFLOW if the list is too small; the list is filled with the first servers.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_GetServerList
+(
+    uint16_t* serverIdListPtr,  ///< [OUT] Short server Ids
+    size_t* numServersPtr       ///< [INOUT] Size of the list, number of servers
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the name of a configured LwM2M server.
+ *
+ * @return
+ *      - LE_OK on success.
+ *      - LE_BAD_PARAMETER if a parameter is invalid.
+ *      - LE_NOT_FOUND if the server is not configured.
+ *      - LE_OVERFLOW if the name buffer is too small.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_GetServerName
+(
+    uint16_t serverId,          ///< [IN]  LwM2M short server Id
+    char* namePtr,              ///< [OUT] Server name
+    size_t nameSize             ///< [IN]  Size of the name buffer
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This function sets up the activity timer.
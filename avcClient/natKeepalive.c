@@ -0,0 +1,568 @@
+/**
+ * @file natKeepalive.c
+ *
+ * Implementation of the NAT keepalive of the LwM2M session.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "natKeepalive.h"
+#include "osUdp.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree path of the keepalive, and node of the discovered intervals
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_NAT_KEEPALIVE_PATH          "/apps/avcService/natKeepalive"
+#define CFG_INTERVALS_NODE              "intervals"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default configuration, in seconds. The keepalive is disabled by default.
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFAULT_MIN_INTERVAL            30
+#define DEFAULT_MAX_INTERVAL            0
+#define DEFAULT_RESOLUTION              15
+#define DEFAULT_PROBE_TIMEOUT           5
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP header of a ping: version 1, confirmable, no token, empty code
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_VERSION_MASK               0xC0
+#define COAP_VERSION_1                  0x40
+#define COAP_TYPE_MASK                  0x30
+#define COAP_TYPE_CON                   0x00
+#define COAP_TYPE_ACK                   0x20
+#define COAP_TYPE_RST                   0x30
+#define COAP_TOKEN_LEN_MASK             0x0F
+#define COAP_CODE_EMPTY                 0x00
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keepalive state
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    STATE_STOPPED = 0,              ///< No session
+    STATE_RUNNING,                  ///< Pinging at the keepalive interval
+    STATE_DISCOVERY_IDLE,           ///< Silent for the candidate interval
+    STATE_DISCOVERY_PROBE           ///< Waiting for the answer of the probe
+}
+State_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configuration, in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t MinInterval = DEFAULT_MIN_INTERVAL;
+static uint32_t MaxInterval = DEFAULT_MAX_INTERVAL;
+static uint32_t Resolution = DEFAULT_RESOLUTION;
+static uint32_t ProbeTimeout = DEFAULT_PROBE_TIMEOUT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current state, bearer and operator, handler sending the probes of a secured session and handler
+ * of a lost binding
+ */
+//--------------------------------------------------------------------------------------------------
+static State_t State = STATE_STOPPED;
+static char Key[NAT_KEEPALIVE_KEY_LEN + 1] = "";
+static natKeepalive_ProbeFunc_t ProbeFunc = NULL;
+static natKeepalive_BindingLostFunc_t LostFunc = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keepalive interval, or candidate interval during the discovery, in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t Interval = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Discovery bounds, in seconds: the lower bound passed, the upper bound failed
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t LowerBound = 0;
+static uint32_t UpperBound = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Message ID of the last ping, and whether the answer of the last ping or probe is expected
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t MessageId = 0;
+static bool IsPingPending = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timers of the silence and of the probe answer
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t IdleTimerRef = NULL;
+static le_timer_Ref_t ProbeTimerRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is the session secured by DTLS? The server does not answer a ping sent in clear, the probes go
+ * through the DTLS session.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSecured = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restart the silence of the interval
+ */
+//--------------------------------------------------------------------------------------------------
+static void RestartIdleTimer
+(
+    void
+)
+{
+    le_timer_Stop(IdleTimerRef);
+    le_timer_SetMsInterval(IdleTimerRef, Interval * 1000);
+    le_timer_Start(IdleTimerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a ping on the session socket. A secured session sends an empty datagram instead, which
+ * refreshes the binding but is not answered.
+ *
+ * @return
+ *  - LE_OK on success
+ *  - LE_FAULT on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SendPing
+(
+    void
+)
+{
+    uint8_t ping[NAT_KEEPALIVE_PING_LEN];
+    le_result_t result;
+
+    if (IsSecured)
+    {
+        result = osUdp_SendPing(NULL, 0);
+        LE_DEBUG("Empty datagram sent after %"PRIu32" s: %s", Interval, LE_RESULT_TXT(result));
+        return result;
+    }
+
+    MessageId++;
+    ping[0] = COAP_VERSION_1 | COAP_TYPE_CON;
+    ping[1] = COAP_CODE_EMPTY;
+    ping[2] = (uint8_t)(MessageId >> 8);
+    ping[3] = (uint8_t)(MessageId & 0xFF);
+
+    result = osUdp_SendPing(ping, sizeof(ping));
+    IsPingPending = (LE_OK == result);
+    LE_DEBUG("Ping %u sent after %"PRIu32" s: %s", MessageId, Interval, LE_RESULT_TXT(result));
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send the probe of a candidate interval: a ping, or a request through the DTLS session of a
+ * secured session. The server answers the probe through the binding of the session.
+ *
+ * @return
+ *  - LE_OK on success
+ *  - LE_FAULT on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SendProbe
+(
+    void
+)
+{
+    le_result_t result;
+
+    if (!IsSecured)
+    {
+        return SendPing();
+    }
+
+    result = ProbeFunc();
+    IsPingPending = (LE_OK == result);
+    LE_DEBUG("Probe sent through DTLS after %"PRIu32" s: %s", Interval, LE_RESULT_TXT(result));
+
+    return (LE_OK == result) ? LE_OK : LE_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store the discovered interval of the bearer and operator
+ */
+//--------------------------------------------------------------------------------------------------
+static void StoreInterval
+(
+    void
+)
+{
+    char path[LE_CFG_STR_LEN_BYTES];
+    le_cfg_IteratorRef_t iterRef;
+
+    snprintf(path, sizeof(path), "%s/%s", CFG_INTERVALS_NODE, Key);
+
+    iterRef = le_cfg_CreateWriteTxn(CFG_NAT_KEEPALIVE_PATH);
+    le_cfg_SetInt(iterRef, path, (int32_t)Interval);
+    le_cfg_CommitTxn(iterRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Probe the next candidate interval, or end the discovery when the bounds are close enough
+ */
+//--------------------------------------------------------------------------------------------------
+static void NextCandidate
+(
+    void
+)
+{
+    if ((UpperBound - LowerBound) <= Resolution)
+    {
+        Interval = LowerBound;
+        State = STATE_RUNNING;
+        LE_INFO("NAT keepalive interval of %s: %"PRIu32" s", Key, Interval);
+        StoreInterval();
+        RestartIdleTimer();
+        return;
+    }
+
+    // Round up so that the candidate always moves away from the lower bound
+    Interval = LowerBound + ((UpperBound - LowerBound + 1) / 2);
+    if (Interval > MaxInterval)
+    {
+        Interval = MaxInterval;
+    }
+
+    State = STATE_DISCOVERY_IDLE;
+    LE_DEBUG("Probing a NAT keepalive interval of %"PRIu32" s", Interval);
+    RestartIdleTimer();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End of the silence: ping to keep the binding, or probe the candidate interval
+ */
+//--------------------------------------------------------------------------------------------------
+static void IdleTimerHandler
+(
+    le_timer_Ref_t timerRef             ///< [IN] Timer reference
+)
+{
+    if (STATE_RUNNING == State)
+    {
+        SendPing();
+        RestartIdleTimer();
+        return;
+    }
+
+    if (STATE_DISCOVERY_IDLE == State)
+    {
+        State = STATE_DISCOVERY_PROBE;
+        if (LE_OK != SendProbe())
+        {
+            // The probe is not sent: retry the same candidate after a new silence
+            State = STATE_DISCOVERY_IDLE;
+            RestartIdleTimer();
+            return;
+        }
+        le_timer_Start(ProbeTimerRef);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The probe was not answered: the binding expired during the silence
+ */
+//--------------------------------------------------------------------------------------------------
+static void ProbeTimerHandler
+(
+    le_timer_Ref_t timerRef             ///< [IN] Timer reference
+)
+{
+    if (STATE_DISCOVERY_PROBE != State)
+    {
+        return;
+    }
+
+    LE_INFO("NAT binding lost after %"PRIu32" s of silence", Interval);
+    IsPingPending = false;
+    UpperBound = Interval;
+
+    // The handler can send on the new binding, the next silence starts after it
+    NextCandidate();
+    if (LostFunc)
+    {
+        LostFunc();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the keepalive: read the configuration
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_Init
+(
+    void
+)
+{
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(CFG_NAT_KEEPALIVE_PATH);
+    int32_t value;
+
+    value = le_cfg_GetInt(iterRef, "minInterval", DEFAULT_MIN_INTERVAL);
+    MinInterval = (value > 0) ? (uint32_t)value : DEFAULT_MIN_INTERVAL;
+    value = le_cfg_GetInt(iterRef, "maxInterval", DEFAULT_MAX_INTERVAL);
+    MaxInterval = (value > 0) ? (uint32_t)value : 0;
+    value = le_cfg_GetInt(iterRef, "resolution", DEFAULT_RESOLUTION);
+    Resolution = (value > 0) ? (uint32_t)value : DEFAULT_RESOLUTION;
+    value = le_cfg_GetInt(iterRef, "probeTimeout", DEFAULT_PROBE_TIMEOUT);
+    ProbeTimeout = (value > 0) ? (uint32_t)value : DEFAULT_PROBE_TIMEOUT;
+    le_cfg_CancelTxn(iterRef);
+
+    if ((MaxInterval) && (MaxInterval < MinInterval))
+    {
+        LE_WARN("NAT keepalive maximum interval %"PRIu32" s below the minimum %"PRIu32" s",
+                MaxInterval, MinInterval);
+        MaxInterval = MinInterval;
+    }
+
+    if (NULL == IdleTimerRef)
+    {
+        IdleTimerRef = le_timer_Create("NatKeepaliveIdle");
+        le_timer_SetHandler(IdleTimerRef, IdleTimerHandler);
+
+        ProbeTimerRef = le_timer_Create("NatKeepaliveProbe");
+        le_timer_SetHandler(ProbeTimerRef, ProbeTimerHandler);
+    }
+    le_timer_SetMsInterval(ProbeTimerRef, ProbeTimeout * 1000);
+
+    MessageId = (uint16_t)le_clk_GetRelativeTime().usec;
+
+    LE_DEBUG("NAT keepalive: interval %"PRIu32"-%"PRIu32" s, resolution %"PRIu32" s",
+             MinInterval, MaxInterval, Resolution);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the keepalive when the session to the DM server is open. The stored interval of the bearer
+ * and operator is used, or discovered if there is none. The discovery of a session secured by DTLS
+ * probes the binding with the probe handler.
+ *
+ * @return
+ *  - LE_OK             The keepalive is started
+ *  - LE_BAD_PARAMETER  The key or the probe handler is invalid
+ *  - LE_NOT_PERMITTED  The keepalive is disabled
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t natKeepalive_Start
+(
+    const char* keyPtr,                             ///< [IN] Key of the bearer and operator
+    natKeepalive_ProbeFunc_t probeFunc,             ///< [IN] Handler sending a probe through DTLS
+    natKeepalive_BindingLostFunc_t lostFunc         ///< [IN] Handler of a lost binding, or NULL
+)
+{
+    char path[LE_CFG_STR_LEN_BYTES];
+    le_cfg_IteratorRef_t iterRef;
+    int32_t storedInterval;
+
+    // The key is a node name of the config tree
+    if ((NULL == keyPtr) || ('\0' == keyPtr[0]) || (strchr(keyPtr, '/'))
+     || (strlen(keyPtr) > NAT_KEEPALIVE_KEY_LEN) || (NULL == probeFunc))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if (0 == MaxInterval)
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    natKeepalive_Stop();
+    le_utf8_Copy(Key, keyPtr, sizeof(Key), NULL);
+    ProbeFunc = probeFunc;
+    LostFunc = lostFunc;
+    IsSecured = osUdp_IsSecured();
+
+    snprintf(path, sizeof(path), "%s/%s", CFG_INTERVALS_NODE, Key);
+    iterRef = le_cfg_CreateReadTxn(CFG_NAT_KEEPALIVE_PATH);
+    storedInterval = le_cfg_GetInt(iterRef, path, 0);
+    le_cfg_CancelTxn(iterRef);
+
+    if (storedInterval > 0)
+    {
+        Interval = (uint32_t)storedInterval;
+        State = STATE_RUNNING;
+        LE_INFO("NAT keepalive interval of %s: %"PRIu32" s", Key, Interval);
+        RestartIdleTimer();
+        return LE_OK;
+    }
+
+    // The minimum is assumed safe. The maximum is probed as well.
+    LE_INFO("Discovering the NAT keepalive interval of %s", Key);
+    LowerBound = MinInterval;
+    UpperBound = MaxInterval + Resolution;
+    NextCandidate();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the keepalive when the session is closed. An ongoing discovery is abandoned.
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_Stop
+(
+    void
+)
+{
+    if (STATE_STOPPED == State)
+    {
+        return;
+    }
+
+    LE_DEBUG("NAT keepalive stopped");
+    le_timer_Stop(IdleTimerRef);
+    le_timer_Stop(ProbeTimerRef);
+    State = STATE_STOPPED;
+    Interval = 0;
+    IsPingPending = false;
+    ProbeFunc = NULL;
+    LostFunc = NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report a datagram sent on the session socket: the binding is refreshed, the next ping is delayed
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_ReportSent
+(
+    void
+)
+{
+    // A probe measures the binding when it is sent, the traffic does not change its verdict
+    if ((STATE_RUNNING == State) || (STATE_DISCOVERY_IDLE == State))
+    {
+        RestartIdleTimer();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The last ping or probe was answered: the candidate interval kept the binding
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportAnswer
+(
+    void
+)
+{
+    IsPingPending = false;
+
+    if (STATE_DISCOVERY_PROBE == State)
+    {
+        le_timer_Stop(ProbeTimerRef);
+        LowerBound = Interval;
+        NextCandidate();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a datagram received on the session socket answers the last ping. On a secured session,
+ * any datagram of the server answers the probe sent through DTLS, and is left to the DTLS layer.
+ *
+ * @return
+ *  - true if the datagram answers the ping, it is consumed by the keepalive
+ */
+//--------------------------------------------------------------------------------------------------
+bool natKeepalive_ReceiveMessage
+(
+    const uint8_t* bufferPtr,                       ///< [IN] Datagram
+    size_t len                                      ///< [IN] Datagram length
+)
+{
+    uint8_t type;
+
+    if ((!IsPingPending) || (NULL == bufferPtr))
+    {
+        return false;
+    }
+
+    if (IsSecured)
+    {
+        LE_DEBUG("Probe answered through DTLS");
+        ReportAnswer();
+        return false;
+    }
+
+    if (NAT_KEEPALIVE_PING_LEN != len)
+    {
+        return false;
+    }
+
+    // A ping is answered by a reset, or by an empty acknowledgement
+    type = bufferPtr[0] & COAP_TYPE_MASK;
+    if (((bufferPtr[0] & COAP_VERSION_MASK) != COAP_VERSION_1)
+     || ((bufferPtr[0] & COAP_TOKEN_LEN_MASK) != 0)
+     || ((COAP_TYPE_RST != type) && (COAP_TYPE_ACK != type))
+     || (COAP_CODE_EMPTY != bufferPtr[1])
+     || (MessageId != (uint16_t)((bufferPtr[2] << 8) | bufferPtr[3])))
+    {
+        return false;
+    }
+
+    LE_DEBUG("Ping %u answered", MessageId);
+    ReportAnswer();
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the keepalive interval
+ *
+ * @return
+ *  - Interval in seconds, the candidate interval during the discovery, 0 if stopped
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t natKeepalive_GetInterval
+(
+    void
+)
+{
+    return Interval;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the keepalive interval is being discovered
+ *
+ * @return
+ *  - true if the discovery is ongoing
+ */
+//--------------------------------------------------------------------------------------------------
+bool natKeepalive_IsDiscovering
+(
+    void
+)
+{
+    return (STATE_DISCOVERY_IDLE == State) || (STATE_DISCOVERY_PROBE == State);
+}
@@ -0,0 +1,175 @@
+/**
+ * @file natKeepalive.h
+ *
+ * NAT keepalive of the LwM2M session.
+ *
+ * A NAT binding of the cellular network can expire before the LwM2M lifetime. Server-initiated
+ * requests are then lost and the next exchange needs a new DTLS handshake and registration. While
+ * the session to the DM server is open, the keepalive sends a CoAP ping (empty confirmable message)
+ * on the session socket when no datagram was sent during the keepalive interval.
+ *
+ * The interval is discovered by binary search between the configured minimum and maximum: the
+ * session stays silent for a candidate interval, then a ping probes the binding. The server answers
+ * the ping through the binding of the session, the answer is therefore only received if the
+ * binding survived the silence. A failed probe reports the loss of the binding, so that the session
+ * registers again. The largest interval that passed is stored per bearer and operator, and used as
+ * is by the next sessions on the same network.
+ *
+ * A session secured by DTLS cannot send the ping in clear: the server would drop it unanswered.
+ * Its probes are sent through the DTLS session by the probe handler of the client, as a
+ * registration update, and any datagram of the server answers them. The server only knows the
+ * DTLS session by the address of its binding, so a probe sent through a new binding is not
+ * answered. Between the probes, a secured session keeps the binding with empty datagrams, which
+ * are not answered.
+ *
+ * The keepalive follows the single session of the client, on the socket of its server.
+ *
+ * The keepalive is configured in the config tree:
+ *
+ * @verbatim
+   /apps/avcService/natKeepalive/minInterval        Minimum interval in seconds
+   /apps/avcService/natKeepalive/maxInterval        Maximum interval in seconds, 0 to disable
+   /apps/avcService/natKeepalive/resolution         Precision of the discovered interval in seconds
+   /apps/avcService/natKeepalive/probeTimeout       Delay to answer a probe in seconds
+   /apps/avcService/natKeepalive/intervals/<key>    Discovered interval of a bearer and operator
+   @endverbatim
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_NAT_KEEPALIVE_INCLUDE_GUARD
+#define LEGATO_NAT_KEEPALIVE_INCLUDE_GUARD
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of the key of a bearer and operator
+ */
+//--------------------------------------------------------------------------------------------------
+#define NAT_KEEPALIVE_KEY_LEN           31
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Length of a CoAP ping
+ */
+//--------------------------------------------------------------------------------------------------
+#define NAT_KEEPALIVE_PING_LEN          4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler sending a probe through the DTLS session of a secured session, answered by the server
+ *
+ * @return
+ *  - LE_OK if the probe is sent
+ */
+//--------------------------------------------------------------------------------------------------
+typedef le_result_t (*natKeepalive_ProbeFunc_t)
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called when a probe failed: the NAT binding of the session was lost
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*natKeepalive_BindingLostFunc_t)
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the keepalive: read the configuration
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the keepalive when the session to the DM server is open. The stored interval of the bearer
+ * and operator is used, or discovered if there is none. The discovery of a session secured by DTLS
+ * probes the binding with the probe handler.
+ *
+ * @return
+ *  - LE_OK             The keepalive is started
+ *  - LE_BAD_PARAMETER  The key or the probe handler is invalid
+ *  - LE_NOT_PERMITTED  The keepalive is disabled
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t natKeepalive_Start
+(
+    const char* keyPtr,                             ///< [IN] Key of the bearer and operator
+    natKeepalive_ProbeFunc_t probeFunc,             ///< [IN] Handler sending a probe through DTLS
+    natKeepalive_BindingLostFunc_t lostFunc         ///< [IN] Handler of a lost binding, or NULL
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the keepalive when the session is closed. An ongoing discovery is abandoned.
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_Stop
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report a datagram sent on the session socket: the binding is refreshed, the next ping is delayed
+ */
+//--------------------------------------------------------------------------------------------------
+void natKeepalive_ReportSent
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a datagram received on the session socket answers the last ping. On a secured session,
+ * any datagram of the server answers the probe sent through DTLS, and is left to the DTLS layer.
+ *
+ * @return
+ *  - true if the datagram answers the ping, it is consumed by the keepalive
+ */
+//--------------------------------------------------------------------------------------------------
+bool natKeepalive_ReceiveMessage
+(
+    const uint8_t* bufferPtr,                       ///< [IN] Datagram
+    size_t len                                      ///< [IN] Datagram length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the keepalive interval
+ *
+ * @return
+ *  - Interval in seconds, the candidate interval during the discovery, 0 if stopped
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t natKeepalive_GetInterval
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the keepalive interval is being discovered
+ *
+ * @return
+ *  - true if the discovery is ongoing
+ */
+//--------------------------------------------------------------------------------------------------
+bool natKeepalive_IsDiscovering
+(
+    void
+);
+
+#endif /* LEGATO_NAT_KEEPALIVE_INCLUDE_GUARD */
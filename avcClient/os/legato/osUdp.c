@@ -20,6 +20,9 @@
 #include <lwm2mcore/udp.h>
 #include "legato.h"
 #include "interfaces.h"
+#include "trafficAccounting.h"
+#include "natKeepalive.h"
+#include "osUdp.h"
 
 
 //--------------------------------------------------------------------------------------------------
@@ -40,6 +43,372 @@ lwm2mcore_SocketConfig_t SocketConfig;
 
 static lwm2mcore_UdpCb_t udpCb = NULL;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Address of a peer, comparable with memcmp(). IPv4-mapped IPv6 addresses are stored as IPv4.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    sa_family_t family;             ///< AF_INET or AF_INET6
+    in_port_t   port;               ///< Port, network order
+    uint8_t     addr[16];           ///< IPv4 or IPv6 address
+}
+PeerAddr_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Server allowed to send datagrams to the session socket, and its token bucket
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    PeerAddr_t              addr;           ///< Comparable address
+    struct sockaddr_storage sockAddr;       ///< Socket address, to connect the socket
+    socklen_t               sockAddrLen;    ///< Socket address length
+    uint64_t                tokens;         ///< Tokens, in thousandths of datagram
+    uint64_t                refillTimeMs;   ///< Time of the last refill
+}
+Peer_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allow-list of the servers, oldest first
+ */
+//--------------------------------------------------------------------------------------------------
+static Peer_t Peers[OS_UDP_MAX_PEERS];
+static size_t PeerCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is the session socket connected to its single server?
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsConnected = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is the first server the session connected to a coaps server?
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSecured = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rate limit of a source: datagrams per second (0 if disabled) and burst
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t Rate = OS_UDP_DEFAULT_RATE;
+static uint32_t Burst = OS_UDP_DEFAULT_BURST;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Datagram counters
+ */
+//--------------------------------------------------------------------------------------------------
+static osUdp_Counters_t Counters;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the cache of the preferred address families, and length of a cache key
+ */
+//--------------------------------------------------------------------------------------------------
+#define FAMILY_CACHE_SIZE       8
+#define FAMILY_KEY_BYTES        256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connection attempt to a server address
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    struct sockaddr_storage addr;           ///< Server address
+    socklen_t               addrLen;        ///< Server address length
+}
+Attempt_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Address family that answered first for a server and bearer
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char        key[FAMILY_KEY_BYTES];      ///< Server and bearer, empty if free
+    int         family;                     ///< AF_INET or AF_INET6
+    uint64_t    timeMs;                     ///< Time of the connection
+}
+FamilyCache_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Preferred address families
+ */
+//--------------------------------------------------------------------------------------------------
+static FamilyCache_t FamilyCache[FAMILY_CACHE_SIZE];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Family fallback: delay for the session server to answer and validity of a preferred family
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t AnswerTimeoutMs = OS_UDP_DEFAULT_ANSWER_TIMEOUT;
+static uint32_t FamilyExpirySec = OS_UDP_DEFAULT_FAMILY_EXPIRY;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Answer expected from the session server: its cache key and address, the family in use and the
+ * other family of the server (AF_UNSPEC if it has none)
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsAnswerPending = false;
+static char SessionKey[FAMILY_KEY_BYTES];
+static PeerAddr_t SessionAddr;
+static int SessionFamily = AF_UNSPEC;
+static int FallbackFamily = AF_UNSPEC;
+static le_timer_Ref_t AnswerTimerRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler reconnecting the session when the server does not answer, and cache key of the server
+ * being reconnected on its other family. The reconnected session does not fall back again.
+ */
+//--------------------------------------------------------------------------------------------------
+static osUdp_FamilyFallbackFunc_t FallbackFunc = NULL;
+static char FallbackKey[FAMILY_KEY_BYTES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current time in ms
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetTimeMs
+(
+    void
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+
+    return ((uint64_t)now.sec * 1000) + ((uint64_t)now.usec / 1000);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the comparable address of a socket address
+ *
+ * @return
+ *      - true on success
+ *      - false if the address family is not supported
+ */
+//--------------------------------------------------------------------------------------------------
+static bool GetPeerAddr
+(
+    const struct sockaddr* saPtr,   ///< [IN] Socket address
+    socklen_t saLen,                ///< [IN] Socket address length
+    PeerAddr_t* addrPtr             ///< [OUT] Comparable address
+)
+{
+    memset(addrPtr, 0, sizeof(PeerAddr_t));
+
+    if ((AF_INET == saPtr->sa_family) && (saLen >= sizeof(struct sockaddr_in)))
+    {
+        const struct sockaddr_in* sinPtr = (const struct sockaddr_in*)saPtr;
+
+        addrPtr->family = AF_INET;
+        addrPtr->port = sinPtr->sin_port;
+        memcpy(addrPtr->addr, &sinPtr->sin_addr, sizeof(sinPtr->sin_addr));
+        return true;
+    }
+
+    if ((AF_INET6 == saPtr->sa_family) && (saLen >= sizeof(struct sockaddr_in6)))
+    {
+        const struct sockaddr_in6* sin6Ptr = (const struct sockaddr_in6*)saPtr;
+
+        addrPtr->port = sin6Ptr->sin6_port;
+        if (IN6_IS_ADDR_V4MAPPED(&sin6Ptr->sin6_addr))
+        {
+            addrPtr->family = AF_INET;
+            memcpy(addrPtr->addr, &sin6Ptr->sin6_addr.s6_addr[12], 4);
+        }
+        else
+        {
+            addrPtr->family = AF_INET6;
+            memcpy(addrPtr->addr, &sin6Ptr->sin6_addr, sizeof(sin6Ptr->sin6_addr));
+        }
+        return true;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the server of a datagram source in the allow-list
+ *
+ * @return
+ *      - Server
+ *      - NULL if the source is not allowed
+ */
+//--------------------------------------------------------------------------------------------------
+static Peer_t* FindPeer
+(
+    const struct sockaddr* saPtr,   ///< [IN] Datagram source
+    socklen_t saLen                 ///< [IN] Datagram source length
+)
+{
+    PeerAddr_t addr;
+    size_t i;
+
+    if (!GetPeerAddr(saPtr, saLen, &addr))
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < PeerCount; i++)
+    {
+        if (0 == memcmp(&Peers[i].addr, &addr, sizeof(addr)))
+        {
+            return &Peers[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take a token from the bucket of a server
+ *
+ * @return
+ *      - true if the datagram is within the rate limit
+ */
+//--------------------------------------------------------------------------------------------------
+static bool TakeToken
+(
+    Peer_t* peerPtr                 ///< [IN] Server
+)
+{
+    uint64_t nowMs = GetTimeMs();
+
+    if (0 == Rate)
+    {
+        return true;
+    }
+
+    // A rate in datagrams per second refills the thousandths of datagram per ms
+    peerPtr->tokens += (nowMs - peerPtr->refillTimeMs) * Rate;
+    peerPtr->refillTimeMs = nowMs;
+    if (peerPtr->tokens > ((uint64_t)Burst * 1000))
+    {
+        peerPtr->tokens = (uint64_t)Burst * 1000;
+    }
+
+    if (peerPtr->tokens < 1000)
+    {
+        return false;
+    }
+
+    peerPtr->tokens -= 1000;
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connect the session socket to its server if it has a single one, so that the kernel drops the
+ * foreign traffic. With several servers, the socket is disconnected and only the allow-list
+ * filters the traffic.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateSocketConnection
+(
+    void
+)
+{
+    if (SocketConfig.sock < 0)
+    {
+        return;
+    }
+
+    if (1 == PeerCount)
+    {
+        if (-1 == connect(SocketConfig.sock, (struct sockaddr*)&Peers[0].sockAddr,
+                          Peers[0].sockAddrLen))
+        {
+            LE_WARN("Session socket not connected, filtered by the allow-list: %d %s.",
+                    errno, strerror(errno));
+            IsConnected = false;
+        }
+        else
+        {
+            IsConnected = true;
+        }
+    }
+    else if (IsConnected)
+    {
+        struct sockaddr unspec;
+
+        memset(&unspec, 0, sizeof(unspec));
+        unspec.sa_family = AF_UNSPEC;
+        LE_ERROR_IF(-1 == connect(SocketConfig.sock, &unspec, sizeof(unspec)),
+                    "Failed to disconnect the session socket: %d %s.", errno, strerror(errno));
+        IsConnected = false;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a server to the allow-list, replacing the oldest one if the list is full
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddPeer
+(
+    const struct sockaddr* saPtr,   ///< [IN] Server address
+    socklen_t saLen                 ///< [IN] Server address length
+)
+{
+    PeerAddr_t addr;
+    Peer_t* peerPtr;
+
+    if ((!GetPeerAddr(saPtr, saLen, &addr)) || (saLen > sizeof(struct sockaddr_storage)))
+    {
+        LE_ERROR("Unsupported server address family %d", saPtr->sa_family);
+        return;
+    }
+
+    if (NULL != FindPeer(saPtr, saLen))
+    {
+        return;
+    }
+
+    if (OS_UDP_MAX_PEERS == PeerCount)
+    {
+        memmove(&Peers[0], &Peers[1], (OS_UDP_MAX_PEERS - 1) * sizeof(Peer_t));
+        PeerCount--;
+    }
+
+    peerPtr = &Peers[PeerCount];
+    memset(peerPtr, 0, sizeof(Peer_t));
+    peerPtr->addr = addr;
+    memcpy(&peerPtr->sockAddr, saPtr, saLen);
+    peerPtr->sockAddrLen = saLen;
+    peerPtr->tokens = (uint64_t)Burst * 1000;
+    peerPtr->refillTimeMs = GetTimeMs();
+    PeerCount++;
+
+    UpdateSocketConnection();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the answer of the session server, see ReportAnswer() below.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportAnswer
+(
+    void
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  lwm2m client receive monitor.
@@ -78,6 +447,28 @@ static void Lwm2mClientReceive
         }
         else if (0 < numBytes)
         {
+            // Drop the foreign and excess datagrams before any parsing or log formatting
+            Peer_t* peerPtr = FindPeer((struct sockaddr*)&addr, addrLen);
+            if (NULL == peerPtr)
+            {
+                Counters.droppedForeign++;
+                return;
+            }
+
+            if (!TakeToken(peerPtr))
+            {
+                Counters.droppedRateLimit++;
+                return;
+            }
+
+            Counters.received++;
+
+            if ((IsAnswerPending) && (0 == memcmp(&peerPtr->addr, &SessionAddr,
+                                                  sizeof(SessionAddr))))
+            {
+                ReportAnswer();
+            }
+
             char s[INET6_ADDRSTRLEN];
             in_port_t port = 0;
 
@@ -97,8 +488,15 @@ static void Lwm2mClientReceive
             }
 
             LE_DEBUG("%d bytes received from [%s]:%hu.", numBytes, s, ntohs(port));
+            trafficAccounting_Add(TRAFFICACCOUNTING_PURPOSE_SESSION, 0, (size_t)numBytes);
             //lwm2mcore_DataDump ("received bytes", buffer, numBytes);
 
+            // The answers of the keepalive pings are not for the LwM2M stack
+            if (natKeepalive_ReceiveMessage(buffer, (size_t)numBytes))
+            {
+                return;
+            }
+
             if (udpCb != NULL)
             {
                 /* Call the registered UDP callback */
@@ -144,6 +542,14 @@ static int CreateSocket
         s = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
         if (s >= 0)
         {
+            // An IPv6 socket also reaches the IPv4 servers, through IPv4-mapped addresses
+            if (AF_INET6 == p->ai_family)
+            {
+                int v6Only = 0;
+                LE_WARN_IF(-1 == setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, &v6Only, sizeof(v6Only)),
+                           "IPv6 only session socket: %d %s.", errno, strerror(errno));
+            }
+
             if (-1 == bind(s, p->ai_addr, p->ai_addrlen))
             {
                 close(s);
@@ -159,109 +565,344 @@ static int CreateSocket
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Resolve the server address name
+ * Get the cache key of a server on the current bearer
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetFamilyKey
+(
+    const char* hostPtr,            ///< [IN] Server host
+    const char* portPtr,            ///< [IN] Server port
+    char* keyPtr                    ///< [OUT] Key, FAMILY_KEY_BYTES long
+)
+{
+    snprintf(keyPtr, FAMILY_KEY_BYTES, "%s:%s#%d/%d", hostPtr, portPtr,
+             le_data_GetTechnology(), le_data_GetCellularProfileIndex());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the cache entry of a key
  *
  * @return
- *      - LE_OK     on success
- *      - LE_FAULT  on failure
+ *      - Cache entry
+ *      - NULL if the key has no valid entry
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t ResolveIpAddress
+static FamilyCache_t* FindFamily
 (
-    char* urlStrPtr,    ///< [IN] Server name to resolve
-    char* ipStrPtr      ///< [IN] Resolved server IP address
+    const char* keyPtr              ///< [IN] Server and bearer
 )
 {
-    int rc;
-    struct addrinfo* resultPtr;
-    struct addrinfo* nextPtr;
-    struct addrinfo hints;
-    struct sockaddr_in *serverPtr;
-
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
+    uint64_t nowMs = GetTimeMs();
+    size_t i;
 
-    rc = getaddrinfo(urlStrPtr, NULL, &hints, &resultPtr);
-    if (rc)
+    for (i = 0; i < FAMILY_CACHE_SIZE; i++)
     {
-        LE_ERROR("IP %s not resolved: %s", urlStrPtr,  gai_strerror(rc));
-        return LE_FAULT;
+        if (('\0' != FamilyCache[i].key[0]) && (0 == strcmp(FamilyCache[i].key, keyPtr)))
+        {
+            if ((nowMs - FamilyCache[i].timeMs) >= ((uint64_t)FamilyExpirySec * 1000))
+            {
+                FamilyCache[i].key[0] = '\0';
+                return NULL;
+            }
+            return &FamilyCache[i];
+        }
     }
 
-    for (nextPtr = resultPtr; nextPtr != NULL; nextPtr = nextPtr->ai_next)
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store the family that answered first for a server, replacing the oldest entry if the cache is
+ * full
+ */
+//--------------------------------------------------------------------------------------------------
+static void StoreFamily
+(
+    const char* keyPtr,             ///< [IN] Server and bearer
+    int family                      ///< [IN] AF_INET or AF_INET6
+)
+{
+    FamilyCache_t* entryPtr = FindFamily(keyPtr);
+    size_t i;
+
+    if (NULL == entryPtr)
     {
-        serverPtr = (struct sockaddr_in*) nextPtr->ai_addr;
-        strncpy(ipStrPtr, inet_ntoa(serverPtr->sin_addr), strlen(inet_ntoa(serverPtr->sin_addr)));
-        LE_DEBUG("Hostname IP Address %s", ipStrPtr);
-        freeaddrinfo(resultPtr);
-        return LE_OK;
+        entryPtr = &FamilyCache[0];
+        for (i = 0; i < FAMILY_CACHE_SIZE; i++)
+        {
+            if ('\0' == FamilyCache[i].key[0])
+            {
+                entryPtr = &FamilyCache[i];
+                break;
+            }
+            if (FamilyCache[i].timeMs < entryPtr->timeMs)
+            {
+                entryPtr = &FamilyCache[i];
+            }
+        }
+        le_utf8_Copy(entryPtr->key, keyPtr, sizeof(entryPtr->key), NULL);
     }
-    LE_ERROR("IP %s not resolved", urlStrPtr);
-    return LE_FAULT;
+
+    entryPtr->family = family;
+    entryPtr->timeMs = GetTimeMs();
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Extract the server name to be resolved
+ * Order the server addresses for the connection: the families alternate, starting with the
+ * preferred one. The session socket must be able to reach the addresses.
  *
  * @return
- *      - char*     server name to be resolved
+ *      - Number of attempts
  */
 //--------------------------------------------------------------------------------------------------
-static char* ExtractServerName
+static size_t OrderAttempts
 (
-    char* urlStrPtr     ///< [IN] Server URL to extract
+    const struct addrinfo* servinfoPtr, ///< [IN] Resolved server addresses
+    int preferredFamily,                ///< [IN] Family of the first attempt
+    Attempt_t* attemptsPtr              ///< [OUT] Attempts, OS_UDP_MAX_ATTEMPTS long
 )
 {
-    // Check if protocol is present in the URL
-    char* urlTempPtr = strrchr(urlStrPtr, '/');
-    if(urlTempPtr)
+    const struct addrinfo* nextPtr[2] = { servinfoPtr, servinfoPtr };
+    int families[2];
+    size_t count = 0;
+    size_t i = 0;
+    struct sockaddr_storage sessionAddr;
+    socklen_t sessionAddrLen = sizeof(sessionAddr);
+    bool isIpv6Reachable = true;
+
+    if ((0 == getsockname(SocketConfig.sock, (struct sockaddr*)&sessionAddr, &sessionAddrLen))
+     && (AF_INET == sessionAddr.ss_family))
     {
-        urlStrPtr = urlTempPtr + 1;
+        isIpv6Reachable = false;
     }
 
-    // Check if port is present in the url
-    urlTempPtr = strchr(urlStrPtr, ':');
-    if (urlTempPtr)
+    families[0] = (AF_INET == preferredFamily) ? AF_INET : AF_INET6;
+    families[1] = (AF_INET == preferredFamily) ? AF_INET6 : AF_INET;
+
+    while (count < OS_UDP_MAX_ATTEMPTS)
     {
-        // Stop URL string on ':' char
-        *urlTempPtr = '\0';
+        const struct addrinfo* p = nextPtr[i];
+
+        while ((NULL != p) && ((p->ai_family != families[i])
+                           || ((AF_INET6 == p->ai_family) && (!isIpv6Reachable))
+                           || (p->ai_addrlen > sizeof(struct sockaddr_storage))))
+        {
+            p = p->ai_next;
+        }
+
+        if (NULL != p)
+        {
+            memcpy(&attemptsPtr[count].addr, p->ai_addr, p->ai_addrlen);
+            attemptsPtr[count].addrLen = p->ai_addrlen;
+            count++;
+            p = p->ai_next;
+        }
+        nextPtr[i] = p;
+
+        if ((NULL == nextPtr[0]) && (NULL == nextPtr[1]))
+        {
+            break;
+        }
+        i = 1 - i;
     }
-    return urlStrPtr;
+
+    return count;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Resolve server IP address name
+ * Connect a socket to the first address of the attempts accepted by the network stack. An address
+ * without a route is rejected at once, the other failures are only known from the server answers.
  *
  * @return
- *      - LE_OK             on success
- *      - LE_BAD_PARAMETER  NULL pointer provided
- *      - LE_FAULT          on failure
+ *      - Index of the connected attempt
+ *      - -1 if no address is reachable
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t ResolveServerIp
+static int ConnectAttempts
 (
-    char * urlStrPtr,   ///< [IN] Server URL to resolve
-    char * ipStrPtr     ///< [OUT] Resolved server IP address
+    const Attempt_t* attemptsPtr,   ///< [IN] Attempts
+    size_t count,                   ///< [IN] Number of attempts
+    int* sockPtr                    ///< [OUT] Socket connected to the address
 )
 {
-    if ((NULL == urlStrPtr)
-     || (NULL == ipStrPtr) )
+    size_t i;
+
+    for (i = 0; i < count; i++)
     {
-        return LE_BAD_PARAMETER;
+        int sock = socket(attemptsPtr[i].addr.ss_family, SOCK_DGRAM, 0);
+
+        if (sock < 0)
+        {
+            continue;
+        }
+
+        if (-1 == connect(sock, (const struct sockaddr*)&attemptsPtr[i].addr,
+                          attemptsPtr[i].addrLen))
+        {
+            LE_DEBUG("Address of family %d unreachable: %d %s.", attemptsPtr[i].addr.ss_family,
+                     errno, strerror(errno));
+            close(sock);
+            continue;
+        }
+
+        *sockPtr = sock;
+        return (int)i;
+    }
+
+    return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The session server answered: its family is preferred for the next connections
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportAnswer
+(
+    void
+)
+{
+    IsAnswerPending = false;
+    FallbackKey[0] = '\0';
+    le_timer_Stop(AnswerTimerRef);
+
+    LE_INFO("Server answered on family %d", SessionFamily);
+    StoreFamily(SessionKey, SessionFamily);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The session server did not answer: the session is reconnected at once on the other family of
+ * the server, which is also tried first by the next connections
+ */
+//--------------------------------------------------------------------------------------------------
+static void AnswerTimerHandler
+(
+    le_timer_Ref_t timerRef         ///< [IN] Timer reference
+)
+{
+    bool isFallback = ('\0' != FallbackKey[0]);
+
+    FallbackKey[0] = '\0';
+    if (!IsAnswerPending)
+    {
+        return;
     }
 
-    if (!strlen(urlStrPtr))
+    IsAnswerPending = false;
+    if (AF_UNSPEC == FallbackFamily)
     {
-        return LE_FAULT;
+        return;
+    }
+
+    StoreFamily(SessionKey, FallbackFamily);
+
+    // A session already reconnected on its fallback family waits for the LwM2M retransmissions
+    if ((NULL == FallbackFunc) || (isFallback))
+    {
+        LE_WARN("No answer from the server on family %d, family %d preferred for the next "
+                "connection", SessionFamily, FallbackFamily);
+        return;
     }
 
-    LE_DEBUG("Try to resolve %s", urlStrPtr);
+    LE_WARN("No answer from the server on family %d, reconnecting on family %d",
+            SessionFamily, FallbackFamily);
+    le_utf8_Copy(FallbackKey, SessionKey, sizeof(FallbackKey), NULL);
+    FallbackFunc();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the first answer of the session server on the family in use
+ */
+//--------------------------------------------------------------------------------------------------
+static void WaitAnswer
+(
+    const char* keyPtr,             ///< [IN] Server and bearer
+    const Attempt_t* attemptsPtr,   ///< [IN] Attempts
+    size_t count,                   ///< [IN] Number of attempts
+    int used,                       ///< [IN] Index of the attempt in use
+    const struct sockaddr* saPtr,   ///< [IN] Server address as seen by the session socket
+    socklen_t saLen                 ///< [IN] Server address length
+)
+{
+    size_t i;
+
+    if (!GetPeerAddr(saPtr, saLen, &SessionAddr))
+    {
+        return;
+    }
 
-    // Resolve server address
-    return ResolveIpAddress(ExtractServerName(urlStrPtr), ipStrPtr);
+    // Only the reconnection of the server falling back keeps the fallback state
+    if (0 != strcmp(FallbackKey, keyPtr))
+    {
+        FallbackKey[0] = '\0';
+    }
+
+    le_utf8_Copy(SessionKey, keyPtr, sizeof(SessionKey), NULL);
+    SessionFamily = attemptsPtr[used].addr.ss_family;
+    FallbackFamily = AF_UNSPEC;
+    for (i = 0; i < count; i++)
+    {
+        if (attemptsPtr[i].addr.ss_family != SessionFamily)
+        {
+            FallbackFamily = attemptsPtr[i].addr.ss_family;
+            break;
+        }
+    }
+
+    if (NULL == AnswerTimerRef)
+    {
+        AnswerTimerRef = le_timer_Create("UdpAnswerTimer");
+        le_timer_SetHandler(AnswerTimerRef, AnswerTimerHandler);
+    }
+    le_timer_Stop(AnswerTimerRef);
+    le_timer_SetMsInterval(AnswerTimerRef, AnswerTimeoutMs);
+    le_timer_Start(AnswerTimerRef);
+    IsAnswerPending = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the address of a server as seen by the session socket: an IPv6 session socket reaches an
+ * IPv4 server through its IPv4-mapped address
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetSessionAddr
+(
+    const Attempt_t* attemptPtr,    ///< [IN] Attempt
+    struct sockaddr* saPtr,         ///< [OUT] Server address
+    socklen_t* slPtr                ///< [OUT] Server address length
+)
+{
+    struct sockaddr_storage sessionAddr;
+    socklen_t sessionAddrLen = sizeof(sessionAddr);
+
+    if ((AF_INET == attemptPtr->addr.ss_family)
+     && (0 == getsockname(SocketConfig.sock, (struct sockaddr*)&sessionAddr, &sessionAddrLen))
+     && (AF_INET6 == sessionAddr.ss_family))
+    {
+        const struct sockaddr_in* sinPtr = (const struct sockaddr_in*)&attemptPtr->addr;
+        struct sockaddr_in6 sin6;
+
+        memset(&sin6, 0, sizeof(sin6));
+        sin6.sin6_family = AF_INET6;
+        sin6.sin6_port = sinPtr->sin_port;
+        sin6.sin6_addr.s6_addr[10] = 0xFF;
+        sin6.sin6_addr.s6_addr[11] = 0xFF;
+        memcpy(&sin6.sin6_addr.s6_addr[12], &sinPtr->sin_addr, 4);
+
+        memcpy(saPtr, &sin6, sizeof(sin6));
+        *slPtr = sizeof(sin6);
+        return;
+    }
+
+    memcpy(saPtr, &attemptPtr->addr, attemptPtr->addrLen);
+    *slPtr = attemptPtr->addrLen;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -287,7 +928,8 @@ bool lwm2mcore_UdpOpen
 
     le_mdc_ProfileRef_t profileRef = le_mdc_GetProfile(le_data_GetCellularProfileIndex());
 
-    if (le_mdc_IsIPv6(profileRef) && !le_mdc_IsIPv4(profileRef))
+    // A dual-stack profile opens a dual-stack socket, to reach both address families
+    if (le_mdc_IsIPv6(profileRef))
     {
         SocketConfig.af = AF_INET6;
     }
@@ -347,6 +989,17 @@ bool lwm2mcore_UdpClose
 
     rc = close (config.sock);
     LE_DEBUG ("close sock %d -> %d", config.sock, rc);
+
+    // The next session connects to its servers again
+    natKeepalive_Stop();
+    IsAnswerPending = false;
+    if (AnswerTimerRef)
+    {
+        le_timer_Stop(AnswerTimerRef);
+    }
+    PeerCount = 0;
+    IsConnected = false;
+    IsSecured = false;
     if (0 == rc)
     {
         result = true;
@@ -378,7 +1031,15 @@ ssize_t lwm2mcore_UdpSend
     socklen_t addrlen
 )
 {
-    return sendto(sockfd, bufferPtr, length, flags, dest_addrPtr, addrlen);
+    ssize_t numBytes = sendto(sockfd, bufferPtr, length, flags, dest_addrPtr, addrlen);
+
+    if (0 < numBytes)
+    {
+        trafficAccounting_Add(TRAFFICACCOUNTING_PURPOSE_SESSION, (size_t)numBytes, 0);
+        natKeepalive_ReportSent();
+    }
+
+    return numBytes;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -387,6 +1048,14 @@ ssize_t lwm2mcore_UdpSend
  * This function is called by the LWM2MCore and must be adapted to the platform
  * The aim of this function is to send data on a socket
  *
+ * The IPv6 and IPv4 addresses of the server are tried as described by RFC 8305, across the
+ * connections: LwM2MCore needs the socket at once, so the attempts cannot overlap without blocking
+ * the event loop. The preferred family of the server on the bearer is tried first, IPv6 if there
+ * is none. The first answer of the server confirms the family in use. When the server does not
+ * answer before the answer timeout, the session is reconnected at once on its other family by the
+ * handler set with osUdp_SetFamilyFallbackHandler(), and that family is preferred for the next
+ * connections. No datagram is sent in clear to a coaps server.
+ *
  * @return
  *      - true  on success
  *      - false on error
@@ -404,60 +1073,263 @@ bool lwm2mcore_UdpConnect
     int* sockPtr                        ///< [IN] socket file descriptor
 )
 {
-    char ipAddressStr[LE_MDC_IPV6_ADDR_MAX_BYTES] = {0};
-    le_result_t res;
+    struct addrinfo hints;
+    struct addrinfo* servinfoPtr = NULL;
+    Attempt_t attempts[OS_UDP_MAX_ATTEMPTS];
+    char key[FAMILY_KEY_BYTES];
+    FamilyCache_t* familyPtr;
+    size_t count;
+    size_t i;
+    int winner;
+
+    if ((NULL == hostPtr) || (NULL == portPtr) || ('\0' == hostPtr[0]))
+    {
+        return false;
+    }
 
     // Resolve the server address
-    res = ResolveServerIp(serverAddressPtr, ipAddressStr);
-    if (LE_OK == res)
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = addressFamily;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    if ((0 != getaddrinfo(hostPtr, portPtr, &hints, &servinfoPtr)) || (servinfoPtr == NULL))
     {
-        struct addrinfo hints;
-        struct addrinfo* servinfoPtr = NULL;
-        struct addrinfo* p;
-        int sockfd;
+        LE_ERROR("Server %s not resolved", hostPtr);
+        return false;
+    }
 
-        // Add the route if the default route is not set by the data connection service
-        if (!le_data_GetDefaultRouteStatus())
+    GetFamilyKey(hostPtr, portPtr, key);
+    familyPtr = FindFamily(key);
+    count = OrderAttempts(servinfoPtr, familyPtr ? familyPtr->family : AF_INET6, attempts);
+    freeaddrinfo(servinfoPtr);
+
+    if (0 == count)
+    {
+        LE_ERROR("No address of %s reachable by the session socket", hostPtr);
+        return false;
+    }
+
+    // Add the routes if the default route is not set by the data connection service
+    if (!le_data_GetDefaultRouteStatus())
+    {
+        for (i = 0; i < count; i++)
         {
+            char ipAddressStr[LE_MDC_IPV6_ADDR_MAX_BYTES] = {0};
+            le_result_t res;
+
+            if (0 != getnameinfo((struct sockaddr*)&attempts[i].addr, attempts[i].addrLen,
+                                 ipAddressStr, sizeof(ipAddressStr), NULL, 0, NI_NUMERICHOST))
+            {
+                continue;
+            }
+
             LE_INFO("Add route %s", ipAddressStr);
             res = le_data_AddRoute(ipAddressStr);
             LE_ERROR_IF((LE_OK != res), "Not able to add the route (%s)", LE_RESULT_TXT(res));
         }
+    }
 
-        // connect
-        memset(&hints, 0, sizeof(hints));
-        hints.ai_family = addressFamily;
-        hints.ai_socktype = SOCK_DGRAM;
+    // The session gets no socket if no address of the server is reachable
+    winner = ConnectAttempts(attempts, count, sockPtr);
+    if (winner < 0)
+    {
+        LE_ERROR("No address of %s reachable", hostPtr);
+        *sockPtr = -1;
+        return true;
+    }
 
-        if ((0 != getaddrinfo(hostPtr, portPtr, &hints, &servinfoPtr)) || (servinfoPtr == NULL))
-        {
-            return false;
-        }
+    LE_INFO("Connecting to %s on family %d", hostPtr, attempts[winner].addr.ss_family);
+    GetSessionAddr(&attempts[winner], saPtr, slPtr);
 
-        // we test the various addresses
-        sockfd = -1;
-        for(p = servinfoPtr; (p != NULL) && (sockfd == -1); p = p->ai_next)
-        {
-            sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+    // Only the servers the session connects to can send datagrams to the session socket
+    if (0 == PeerCount)
+    {
+        IsSecured = (NULL != serverAddressPtr)
+                    && (0 == strncasecmp(serverAddressPtr, "coaps://", 8));
+        WaitAnswer(key, attempts, count, winner, saPtr, *slPtr);
+    }
+    AddPeer(saPtr, *slPtr);
+    return true;
+}
 
-            if (sockfd >= 0)
-            {
-                *slPtr = p->ai_addrlen;
-                memcpy(saPtr, p->ai_addr, p->ai_addrlen);
-
-                if (-1 == connect(sockfd, p->ai_addr, p->ai_addrlen))
-                {
-                    close(sockfd);
-                    sockfd = -1;
-                }
-            }
-        }
-        *sockPtr = sockfd;
-        if (NULL != servinfoPtr)
-        {
-            freeaddrinfo(servinfoPtr);
-        }
-        return true;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the datagram counters of the session socket
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_GetCounters
+(
+    osUdp_Counters_t* countersPtr   ///< [OUT] Datagram counters
+)
+{
+    *countersPtr = Counters;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the rate limit of each source. The buckets of the sources are refilled.
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_SetRateLimit
+(
+    uint32_t rate,                  ///< [IN] Datagrams per second, 0 to disable the limit
+    uint32_t burst                  ///< [IN] Datagrams accepted at once
+)
+{
+    size_t i;
+
+    Rate = rate;
+    Burst = burst;
+
+    for (i = 0; i < PeerCount; i++)
+    {
+        Peers[i].tokens = (uint64_t)Burst * 1000;
+        Peers[i].refillTimeMs = GetTimeMs();
     }
-    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a keepalive ping on the session socket, to the first server the session connected to.
+ * An empty datagram refreshes the NAT binding without being processed by the server.
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the ping is invalid
+ *      - LE_NOT_FOUND if the session socket is not connected to a server
+ *      - LE_FAULT on failure
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t osUdp_SendPing
+(
+    const uint8_t* bufferPtr,       ///< [IN] CoAP ping, NULL for an empty datagram
+    size_t len                      ///< [IN] CoAP ping length, 0 for an empty datagram
+)
+{
+    ssize_t numBytes;
+
+    if ((NULL == bufferPtr) != (0 == len))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((SocketConfig.sock < 0) || (0 == PeerCount))
+    {
+        return LE_NOT_FOUND;
+    }
+
+    numBytes = sendto(SocketConfig.sock, bufferPtr, len, 0,
+                      IsConnected ? NULL : (struct sockaddr*)&Peers[0].sockAddr,
+                      IsConnected ? 0 : Peers[0].sockAddrLen);
+    if ((ssize_t)len != numBytes)
+    {
+        LE_WARN("Failed to send the ping: %d %s.", errno, strerror(errno));
+        return LE_FAULT;
+    }
+
+    trafficAccounting_Add(TRAFFICACCOUNTING_PURPOSE_SESSION, len, 0);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the session socket is connected to its server, the kernel then drops the foreign
+ * traffic
+ *
+ * @return
+ *      - true if the socket is connected
+ */
+//--------------------------------------------------------------------------------------------------
+bool osUdp_IsConnected
+(
+    void
+)
+{
+    return IsConnected;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the session is secured by DTLS: the first server the session connected to is a coaps
+ * server, which does not answer the CoAP pings sent in clear
+ *
+ * @return
+ *      - true if the session is secured
+ */
+//--------------------------------------------------------------------------------------------------
+bool osUdp_IsSecured
+(
+    void
+)
+{
+    return IsSecured;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the family fallback: delay for the session server to answer and validity of the preferred
+ * family of a server
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_SetFamilyFallback
+(
+    uint32_t answerTimeoutMs,       ///< [IN] Delay for the session server to answer, in ms
+    uint32_t familyExpirySec        ///< [IN] Validity of a preferred family, in seconds
+)
+{
+    AnswerTimeoutMs = answerTimeoutMs;
+    FamilyExpirySec = familyExpirySec;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the handler reconnecting the session when the server does not answer on the family in use.
+ * The handler must close the session and connect it again: the connection then starts on the
+ * other family of the server.
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_SetFamilyFallbackHandler
+(
+    osUdp_FamilyFallbackFunc_t handlerPtr   ///< [IN] Handler, NULL to only change the preference
+)
+{
+    FallbackFunc = handlerPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the preferred family of a server on the current bearer
+ *
+ * @return
+ *      - AF_INET or AF_INET6
+ *      - AF_UNSPEC if there is no valid preference
+ */
+//--------------------------------------------------------------------------------------------------
+int osUdp_GetPreferredFamily
+(
+    const char* hostPtr,            ///< [IN] Server host
+    const char* portPtr             ///< [IN] Server port
+)
+{
+    char key[FAMILY_KEY_BYTES];
+    FamilyCache_t* familyPtr;
+
+    GetFamilyKey(hostPtr, portPtr, key);
+    familyPtr = FindFamily(key);
+
+    return familyPtr ? familyPtr->family : AF_UNSPEC;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the preferred families of the servers
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_ClearPreferredFamilies
+(
+    void
+)
+{
+    memset(FamilyCache, 0, sizeof(FamilyCache));
+    FallbackKey[0] = '\0';
 }
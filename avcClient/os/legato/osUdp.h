@@ -0,0 +1,199 @@
+/**
+ * @file osUdp.h
+ *
+ * Source filtering of the LwM2M session socket.
+ *
+ * The datagrams are only accepted from the servers the session connected to. When a single server
+ * is used, the socket is connected to it and the kernel drops the foreign traffic. Otherwise, the
+ * source of each datagram is checked against the allow-list of the servers before any parsing.
+ * The accepted datagrams are then limited per source by a token bucket.
+ *
+ * The connection to a dual-stack server falls back between its IPv6 and IPv4 addresses (RFC 8305),
+ * so that a broken family does not stall the next sessions. The connection never blocks: the
+ * session starts on the preferred family, and the family is confirmed by the first answer of the
+ * server. Without an answer within the answer timeout, the session is reconnected at once on the
+ * other family, which is also preferred for the next connections to the server on the same bearer.
+ * A preference expires after a while.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_OS_UDP_INCLUDE_GUARD
+#define LEGATO_OS_UDP_INCLUDE_GUARD
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of servers in the allow-list
+ */
+//--------------------------------------------------------------------------------------------------
+#define OS_UDP_MAX_PEERS            4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default rate limit of a source: datagrams per second, and burst
+ */
+//--------------------------------------------------------------------------------------------------
+#define OS_UDP_DEFAULT_RATE         50
+#define OS_UDP_DEFAULT_BURST        100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of server addresses tried
+ */
+//--------------------------------------------------------------------------------------------------
+#define OS_UDP_MAX_ATTEMPTS         4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default family fallback: delay for the session server to answer in ms, validity of the
+ * preferred family of a server in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define OS_UDP_DEFAULT_ANSWER_TIMEOUT   5000
+#define OS_UDP_DEFAULT_FAMILY_EXPIRY    600
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler reconnecting the session on the other family of its server
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*osUdp_FamilyFallbackFunc_t)
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Datagram counters of the session socket
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t received;              ///< Datagrams forwarded to the LwM2M stack
+    uint64_t droppedForeign;        ///< Datagrams dropped as their source is not a server
+    uint64_t droppedRateLimit;      ///< Datagrams dropped as their source exceeds its rate
+}
+osUdp_Counters_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the datagram counters of the session socket
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_GetCounters
+(
+    osUdp_Counters_t* countersPtr   ///< [OUT] Datagram counters
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the rate limit of each source. The buckets of the sources are refilled.
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_SetRateLimit
+(
+    uint32_t rate,                  ///< [IN] Datagrams per second, 0 to disable the limit
+    uint32_t burst                  ///< [IN] Datagrams accepted at once
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the session socket is connected to its server, the kernel then drops the foreign
+ * traffic
+ *
+ * @return
+ *      - true if the socket is connected
+ */
+//--------------------------------------------------------------------------------------------------
+bool osUdp_IsConnected
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a keepalive ping on the session socket, to the first server the session connected to.
+ * An empty datagram refreshes the NAT binding without being processed by the server.
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the ping is invalid
+ *      - LE_NOT_FOUND if the session socket is not connected to a server
+ *      - LE_FAULT on failure
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t osUdp_SendPing
+(
+    const uint8_t* bufferPtr,       ///< [IN] CoAP ping, NULL for an empty datagram
+    size_t len                      ///< [IN] CoAP ping length, 0 for an empty datagram
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the session is secured by DTLS: the first server the session connected to is a coaps
+ * server, which does not answer the CoAP pings sent in clear
+ *
+ * @return
+ *      - true if the session is secured
+ */
+//--------------------------------------------------------------------------------------------------
+bool osUdp_IsSecured
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the family fallback: delay for the session server to answer and validity of the preferred
+ * family of a server
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_SetFamilyFallback
+(
+    uint32_t answerTimeoutMs,       ///< [IN] Delay for the session server to answer, in ms
+    uint32_t familyExpirySec        ///< [IN] Validity of a preferred family, in seconds
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the handler reconnecting the session when the server does not answer on the family in use.
+ * The handler must close the session and connect it again: the connection then starts on the
+ * other family of the server.
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_SetFamilyFallbackHandler
+(
+    osUdp_FamilyFallbackFunc_t handlerPtr   ///< [IN] Handler, NULL to only change the preference
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the preferred family of a server on the current bearer
+ *
+ * @return
+ *      - AF_INET or AF_INET6
+ *      - AF_UNSPEC if there is no valid preference
+ */
+//--------------------------------------------------------------------------------------------------
+int osUdp_GetPreferredFamily
+(
+    const char* hostPtr,            ///< [IN] Server host
+    const char* portPtr             ///< [IN] Server port
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the preferred families of the servers
+ */
+//--------------------------------------------------------------------------------------------------
+void osUdp_ClearPreferredFamilies
+(
+    void
+);
+
+#endif /* LEGATO_OS_UDP_INCLUDE_GUARD */
@@ -10,6 +10,7 @@
 #include <lwm2mcore/connectivity.h>
 #include "legato.h"
 #include "interfaces.h"
+#include "trafficAccounting.h"
 
 //--------------------------------------------------------------------------------------------------
 // Symbol and Enum definitions
@@ -2228,8 +2229,23 @@ lwm2mcore_Sid_t lwm2mcore_GetTxData
         break;
 
         case LE_DATA_WIFI:
-            sID = LWM2MCORE_ERR_NOT_YET_IMPLEMENTED;
-            break;
+        {
+            trafficAccounting_Counters_t counters;
+
+            // Bytes exchanged on the Wi-Fi interface, read from the kernel interface counters
+            if (LE_OK == trafficAccounting_GetBearerCounters(&counters))
+            {
+                *valuePtr = counters.txBytes / KILOBYTE;
+                LE_DEBUG("txBytes: %"PRIu64" -> Tx Data = %"PRIu64" kB",
+                         counters.txBytes, *valuePtr);
+                sID = LWM2MCORE_ERR_COMPLETED_OK;
+            }
+            else
+            {
+                sID = LWM2MCORE_ERR_GENERAL_ERROR;
+            }
+        }
+        break;
 
         default:
             sID = LWM2MCORE_ERR_GENERAL_ERROR;
@@ -2287,8 +2303,23 @@ lwm2mcore_Sid_t lwm2mcore_GetRxData
         break;
 
         case LE_DATA_WIFI:
-            sID = LWM2MCORE_ERR_NOT_YET_IMPLEMENTED;
-            break;
+        {
+            trafficAccounting_Counters_t counters;
+
+            // Bytes exchanged on the Wi-Fi interface, read from the kernel interface counters
+            if (LE_OK == trafficAccounting_GetBearerCounters(&counters))
+            {
+                *valuePtr = counters.rxBytes / KILOBYTE;
+                LE_DEBUG("rxBytes: %"PRIu64" -> Rx Data = %"PRIu64" kB",
+                         counters.rxBytes, *valuePtr);
+                sID = LWM2MCORE_ERR_COMPLETED_OK;
+            }
+            else
+            {
+                sID = LWM2MCORE_ERR_GENERAL_ERROR;
+            }
+        }
+        break;
 
         default:
             sID = LWM2MCORE_ERR_GENERAL_ERROR;
@@ -2318,6 +2349,9 @@ lwm2mcore_Sid_t lwm2mcore_StartConnectivityCounters
     le_sms_ResetCount();
     le_sms_StartCount();
 
+    // Reset and start the bearer interface counters, used when the bearer is not cellular
+    trafficAccounting_StartBearerCollection();
+
     // Reset and start cellular data counters
     if (LE_DATA_CELLULAR == le_data_GetTechnology())
     {
@@ -2349,6 +2383,9 @@ lwm2mcore_Sid_t lwm2mcore_StopConnectivityCounters
     // Stop SMS counters without resetting the counters
     le_sms_StopCount();
 
+    // Stop the bearer interface counters without resetting the counters
+    trafficAccounting_StopBearerCollection();
+
     // Stop cellular data counters without resetting the counters
     if (LE_DATA_CELLULAR == le_data_GetTechnology())
     {
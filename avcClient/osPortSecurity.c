@@ -10,6 +10,7 @@
  *
  */
 
+#include <sys/mman.h>
 #include <zlib.h>
 #include <openssl/sha.h>
 #include <openssl/bio.h>
@@ -40,6 +41,55 @@
 //--------------------------------------------------------------------------------------------------
 #define LWM2M_CERT_MAX_SIZE     4000
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the secure storage directory holding the credentials of a non-default server, followed
+ * by the server Id.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SERVER_CREDENTIALS_DIR  "server"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of credential namespaces tracked by the presence bitmap and the credential cache: the
+ * device-wide namespace and one namespace per additional server.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CREDENTIAL_NAMESPACES   AVC_CLIENT_MAX_SERVERS
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of cached credentials per namespace: bootstrap and device management credentials.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CACHED_CREDENTIALS      8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of a credential cache slot. Larger credentials are always read from secure storage.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CACHE_SLOT_BYTES        512
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time during which a credential known to be absent or empty is not read again, in seconds.
+ * Credentials may be provisioned in the secure storage by another application, which is not
+ * notified to the AVC: their absence is only trusted for a while.
+ */
+//--------------------------------------------------------------------------------------------------
+#define ABSENCE_VALIDITY_SEC    30
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition on the credential cache.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&CredentialMutex)!=0), \
+                              "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&CredentialMutex)!=0), \
+                              "Could not unlock the mutex")
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Array to describe the location of a specific credential type in the secure storage.
@@ -59,6 +109,439 @@ static const char* CredentialLocations[LWM2MCORE_CREDENTIAL_MAX] = {
     "LWM2M_DM_SERVER_ADDR",             ///< LWM2MCORE_CREDENTIAL_DM_ADDRESS
 };
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Presence of a credential in the secure storage
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    PRESENCE_UNKNOWN,   ///< Presence not known, the secure storage has to be read
+    PRESENCE_ABSENT,    ///< Credential not stored
+    PRESENCE_EMPTY,     ///< Credential stored with an empty value
+    PRESENCE_PRESENT    ///< Credential stored with a value
+}
+Presence_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Presence of the credentials of a namespace, as bitmaps indexed by credential identifier.
+ * The bitmaps are filled by the secure storage accesses and maintained on set and delete, so that
+ * the presence of a credential is checked without reading it.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool            isUsed;         ///< Is the namespace used?
+    uint16_t        serverId;       ///< Server Id, AVC_CLIENT_ANY_SERVER_ID for device-wide
+                                    ///< namespace
+    uint32_t        knownMask;      ///< Credentials whose presence is known
+    uint32_t        presentMask;    ///< Credentials present in secure storage
+    uint32_t        emptyMask;      ///< Credentials present in secure storage with an empty value
+    uint32_t        oversizeMask;   ///< Credentials too large for the credential cache
+    le_clk_Time_t   expiry[LWM2MCORE_CREDENTIAL_MAX];   ///< Time after which the absence of a
+                                                        ///< credential is no longer trusted
+}
+CredentialNamespace_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Credential cache slot
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t      len;                        ///< Credential length, 0 if the slot is empty
+    uint8_t     data[CACHE_SLOT_BYTES];     ///< Credential
+}
+CacheSlot_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Credential cache, indexed by namespace then by cached credential. The cache is allocated in its
+ * own locked pages, so that the credentials are never swapped out nor dumped, and every slot is
+ * zeroized when it is invalidated.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef CacheSlot_t CredentialCache_t[CREDENTIAL_NAMESPACES][CACHED_CREDENTIALS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Credential namespaces. The first one is the device-wide namespace.
+ */
+//--------------------------------------------------------------------------------------------------
+static CredentialNamespace_t CredentialNamespaces[CREDENTIAL_NAMESPACES] =
+{
+    { .isUsed = true, .serverId = AVC_CLIENT_ANY_SERVER_ID }
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Credential cache, allocated on first use
+ */
+//--------------------------------------------------------------------------------------------------
+static CredentialCache_t* CredentialCachePtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is the credential cache disabled, i.e. could not be allocated in locked memory?
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsCacheDisabled = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex protecting the presence bitmap and the credential cache, which are accessed by the
+ * package downloader thread too.
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t CredentialMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a credential belongs to a specific LwM2M server, i.e. is a device management credential.
+ * The other credentials (package keys, certificate, bootstrap credentials) are device-wide.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsServerCredential
+(
+    lwm2mcore_Credentials_t credId      ///< [IN] Credential identifier
+)
+{
+    switch (credId)
+    {
+        case LWM2MCORE_CREDENTIAL_DM_PUBLIC_KEY:
+        case LWM2MCORE_CREDENTIAL_DM_SERVER_PUBLIC_KEY:
+        case LWM2MCORE_CREDENTIAL_DM_SECRET_KEY:
+        case LWM2MCORE_CREDENTIAL_DM_ADDRESS:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a credential is stored in the namespace of an additional server.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsInServerNamespace
+(
+    lwm2mcore_Credentials_t credId,     ///< [IN] Credential identifier
+    uint16_t                serverId    ///< [IN] Server Id
+)
+{
+    return (   IsServerCredential(credId)
+            && (AVC_CLIENT_ANY_SERVER_ID != serverId)
+            && (LWM2MCORE_NO_SERVER_ID != serverId)
+            && (AVC_CLIENT_DEFAULT_SERVER_ID != serverId));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the secure storage path of a credential.
+ *
+ * The device management credentials of an additional server are stored in their own namespace,
+ * e.g. /avms/server2/LWM2M_DM_PSK_SECRET. The device-wide credentials and the credentials of the
+ * default AirVantage server keep their historical location, e.g. /avms/LWM2M_DM_PSK_SECRET.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetCredentialPath
+(
+    lwm2mcore_Credentials_t credId,     ///< [IN] Credential identifier
+    uint16_t                serverId,   ///< [IN] Server Id
+    char*                   pathPtr,    ///< [OUT] Credential path
+    size_t                  pathSize    ///< [IN] Credential path buffer size
+)
+{
+    LE_FATAL_IF(LE_OK != le_utf8_Copy(pathPtr, SECURE_STORAGE_PREFIX, pathSize, NULL),
+                "Buffer is not long enough");
+
+    if (IsInServerNamespace(credId, serverId))
+    {
+        char serverDir[sizeof(SERVER_CREDENTIALS_DIR) + 5] = {0};
+
+        snprintf(serverDir, sizeof(serverDir), SERVER_CREDENTIALS_DIR "%" PRIu16, serverId);
+        LE_FATAL_IF(LE_OK != le_path_Concat("/", pathPtr, pathSize, serverDir, NULL),
+                    "Buffer is not long enough");
+    }
+
+    LE_FATAL_IF(LE_OK != le_path_Concat("/", pathPtr, pathSize, CredentialLocations[credId], NULL),
+                "Buffer is not long enough");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the index of a credential in the cache of a namespace.
+ *
+ * @return
+ *      - Index of the credential
+ *      - -1 if the credential is not cached
+ */
+//--------------------------------------------------------------------------------------------------
+static int GetCacheIndex
+(
+    lwm2mcore_Credentials_t credId      ///< [IN] Credential identifier
+)
+{
+    if (   (credId < LWM2MCORE_CREDENTIAL_BS_PUBLIC_KEY)
+        || (credId > LWM2MCORE_CREDENTIAL_DM_ADDRESS))
+    {
+        // Package keys and certificate are not used by the handshake
+        return -1;
+    }
+
+    return (int)(credId - LWM2MCORE_CREDENTIAL_BS_PUBLIC_KEY);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the namespace of a credential, allocating it if necessary.
+ *
+ * @note Must be called with the credential mutex locked.
+ *
+ * @return
+ *      - Index of the namespace
+ *      - -1 if no namespace is available
+ */
+//--------------------------------------------------------------------------------------------------
+static int GetNamespaceIndex
+(
+    lwm2mcore_Credentials_t credId,     ///< [IN] Credential identifier
+    uint16_t                serverId    ///< [IN] Server Id
+)
+{
+    int freeIndex = -1;
+    int i;
+
+    if (!IsInServerNamespace(credId, serverId))
+    {
+        return 0;
+    }
+
+    for (i = 1; i < CREDENTIAL_NAMESPACES; i++)
+    {
+        if (!CredentialNamespaces[i].isUsed)
+        {
+            if (freeIndex < 0)
+            {
+                freeIndex = i;
+            }
+        }
+        else if (CredentialNamespaces[i].serverId == serverId)
+        {
+            return i;
+        }
+    }
+
+    if (freeIndex < 0)
+    {
+        LE_WARN("No credential namespace available for server %" PRIu16, serverId);
+        return -1;
+    }
+
+    memset(&CredentialNamespaces[freeIndex], 0, sizeof(CredentialNamespace_t));
+    CredentialNamespaces[freeIndex].isUsed = true;
+    CredentialNamespaces[freeIndex].serverId = serverId;
+    return freeIndex;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Erase a memory area in a way the compiler can not optimize out.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Zeroize
+(
+    void*   dataPtr,    ///< [IN] Memory area
+    size_t  len         ///< [IN] Memory area length
+)
+{
+    volatile uint8_t* bytePtr = dataPtr;
+
+    while (len--)
+    {
+        *bytePtr++ = 0;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the cache slot of a credential, allocating the credential cache on first use.
+ *
+ * @note Must be called with the credential mutex locked.
+ *
+ * @return
+ *      - Cache slot
+ *      - NULL if the credential is not cached
+ */
+//--------------------------------------------------------------------------------------------------
+static CacheSlot_t* GetCacheSlot
+(
+    int                     nsIndex,    ///< [IN] Namespace index
+    lwm2mcore_Credentials_t credId      ///< [IN] Credential identifier
+)
+{
+    int cacheIndex = GetCacheIndex(credId);
+
+    if ((nsIndex < 0) || (cacheIndex < 0) || IsCacheDisabled)
+    {
+        return NULL;
+    }
+
+    if (!CredentialCachePtr)
+    {
+        void* cachePtr = mmap(NULL, sizeof(CredentialCache_t), PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == cachePtr)
+        {
+            LE_WARN("Unable to allocate credential cache: %m");
+            IsCacheDisabled = true;
+            return NULL;
+        }
+
+        if (0 != mlock(cachePtr, sizeof(CredentialCache_t)))
+        {
+            LE_WARN("Unable to lock credential cache, credentials are not cached: %m");
+            munmap(cachePtr, sizeof(CredentialCache_t));
+            IsCacheDisabled = true;
+            return NULL;
+        }
+
+#ifdef MADV_DONTDUMP
+        if (0 != madvise(cachePtr, sizeof(CredentialCache_t), MADV_DONTDUMP))
+        {
+            LE_WARN("Unable to exclude credential cache from core dumps: %m");
+        }
+#endif
+
+        // Anonymous mapping is zero-filled
+        CredentialCachePtr = cachePtr;
+    }
+
+    return &(*CredentialCachePtr)[nsIndex][cacheIndex];
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Invalidate the cached copy of a credential.
+ *
+ * @note Must be called with the credential mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EvictCredential
+(
+    int                     nsIndex,    ///< [IN] Namespace index
+    lwm2mcore_Credentials_t credId      ///< [IN] Credential identifier
+)
+{
+    int cacheIndex = GetCacheIndex(credId);
+
+    if ((nsIndex < 0) || (cacheIndex < 0) || (!CredentialCachePtr))
+    {
+        return;
+    }
+
+    CacheSlot_t* slotPtr = &(*CredentialCachePtr)[nsIndex][cacheIndex];
+    Zeroize(slotPtr->data, sizeof(slotPtr->data));
+    slotPtr->len = 0;
+    CredentialNamespaces[nsIndex].oversizeMask &= ~(1U << credId);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update the presence of a credential.
+ *
+ * @note Must be called with the credential mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetPresence
+(
+    int                     nsIndex,    ///< [IN] Namespace index
+    lwm2mcore_Credentials_t credId,     ///< [IN] Credential identifier
+    Presence_t              presence    ///< [IN] Presence of the credential
+)
+{
+    if (nsIndex < 0)
+    {
+        return;
+    }
+
+    CredentialNamespace_t* nsPtr = &CredentialNamespaces[nsIndex];
+    uint32_t mask = (1U << credId);
+
+    nsPtr->knownMask &= ~mask;
+    nsPtr->presentMask &= ~mask;
+    nsPtr->emptyMask &= ~mask;
+
+    switch (presence)
+    {
+        case PRESENCE_ABSENT:
+            nsPtr->knownMask |= mask;
+            break;
+
+        case PRESENCE_EMPTY:
+            nsPtr->knownMask |= mask;
+            nsPtr->presentMask |= mask;
+            nsPtr->emptyMask |= mask;
+            break;
+
+        case PRESENCE_PRESENT:
+            nsPtr->knownMask |= mask;
+            nsPtr->presentMask |= mask;
+            break;
+
+        default:
+            return;
+    }
+
+    if (PRESENCE_PRESENT != presence)
+    {
+        le_clk_Time_t validity = { .sec = ABSENCE_VALIDITY_SEC, .usec = 0 };
+        nsPtr->expiry[credId] = le_clk_Add(le_clk_GetRelativeTime(), validity);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the presence of a credential. The absence of a credential, or its empty value, is
+ * forgotten when it expires, so that a credential provisioned meanwhile is read.
+ *
+ * @note Must be called with the credential mutex locked.
+ *
+ * @return Presence of the credential
+ */
+//--------------------------------------------------------------------------------------------------
+static Presence_t GetPresence
+(
+    int                     nsIndex,    ///< [IN] Namespace index
+    lwm2mcore_Credentials_t credId      ///< [IN] Credential identifier
+)
+{
+    uint32_t mask = (1U << credId);
+
+    if ((nsIndex < 0) || (!(CredentialNamespaces[nsIndex].knownMask & mask)))
+    {
+        return PRESENCE_UNKNOWN;
+    }
+
+    CredentialNamespace_t* nsPtr = &CredentialNamespaces[nsIndex];
+
+    if ((nsPtr->presentMask & mask) && (!(nsPtr->emptyMask & mask)))
+    {
+        return PRESENCE_PRESENT;
+    }
+
+    if (le_clk_GreaterThan(le_clk_GetRelativeTime(), nsPtr->expiry[credId]))
+    {
+        SetPresence(nsIndex, credId, PRESENCE_UNKNOWN);
+        return PRESENCE_UNKNOWN;
+    }
+
+    return (nsPtr->emptyMask & mask) ? PRESENCE_EMPTY : PRESENCE_ABSENT;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Retrieve a credential.
@@ -80,21 +563,111 @@ lwm2mcore_Sid_t lwm2mcore_GetCredential
                                         ///< returned data
 )
 {
-    (void)serverId;
-
     if ((bufferPtr == NULL) || (lenPtr == NULL) || (credId >= LWM2MCORE_CREDENTIAL_MAX))
     {
         return LWM2MCORE_ERR_INVALID_ARG;
     }
 
-    char credsPathStr[LE_SECSTORE_MAX_NAME_BYTES] = SECURE_STORAGE_PREFIX;
+    char credsPathStr[LE_SECSTORE_MAX_NAME_BYTES];
+    le_result_t result = LE_OVERFLOW;
+
+    GetCredentialPath(credId, serverId, credsPathStr, sizeof(credsPathStr));
+
+    LOCK();
+
+    int nsIndex = GetNamespaceIndex(credId, serverId);
+
+    // Do not access the secure storage for a credential known to be absent or empty
+    switch (GetPresence(nsIndex, credId))
+    {
+        case PRESENCE_ABSENT:
+            UNLOCK();
+            LE_DEBUG("credId %d not present", credId);
+            return LWM2MCORE_ERR_GENERAL_ERROR;
+
+        case PRESENCE_EMPTY:
+            UNLOCK();
+            LE_DEBUG("credId %d, len 0", credId);
+            *lenPtr = 0;
+            return LWM2MCORE_ERR_COMPLETED_OK;
+
+        default:
+            break;
+    }
+
+    CacheSlot_t* slotPtr = GetCacheSlot(nsIndex, credId);
+    if ((slotPtr) && (!(CredentialNamespaces[nsIndex].oversizeMask & (1U << credId))))
+    {
+        if (!slotPtr->len)
+        {
+            // Read the credential directly in the locked memory
+            size_t len = sizeof(slotPtr->data);
+            result = le_secStore_Read(credsPathStr, slotPtr->data, &len);
+            if (LE_OK == result)
+            {
+                slotPtr->len = len;
+                if (!len)
+                {
+                    // Empty credential, only its presence is tracked
+                    *lenPtr = 0;
+                }
+            }
+            else
+            {
+                Zeroize(slotPtr->data, sizeof(slotPtr->data));
+                if (LE_OVERFLOW == result)
+                {
+                    CredentialNamespaces[nsIndex].oversizeMask |= (1U << credId);
+                }
+            }
+        }
+
+        if (slotPtr->len)
+        {
+            if (*lenPtr < slotPtr->len)
+            {
+                UNLOCK();
+                LE_ERROR("Buffer too small for credentials %d: %zu < %zu",
+                         credId, *lenPtr, slotPtr->len);
+                return LWM2MCORE_ERR_GENERAL_ERROR;
+            }
+
+            memcpy(bufferPtr, slotPtr->data, slotPtr->len);
+            *lenPtr = slotPtr->len;
+            SetPresence(nsIndex, credId, PRESENCE_PRESENT);
+            UNLOCK();
+
+            LE_DEBUG("credId %d, len %zu", credId, *lenPtr);
+            return LWM2MCORE_ERR_COMPLETED_OK;
+        }
+    }
+
+    // Credential not cached or too large for the cache
+    if (LE_OVERFLOW == result)
+    {
+        result = le_secStore_Read(credsPathStr, (uint8_t*)bufferPtr, lenPtr);
+    }
+
+    switch (result)
+    {
+        case LE_OK:
+            SetPresence(nsIndex, credId, (0 != *lenPtr) ? PRESENCE_PRESENT : PRESENCE_EMPTY);
+            break;
+
+        case LE_OVERFLOW:
+            SetPresence(nsIndex, credId, PRESENCE_PRESENT);
+            break;
+
+        case LE_NOT_FOUND:
+            SetPresence(nsIndex, credId, PRESENCE_ABSENT);
+            break;
+
+        default:
+            break;
+    }
+
+    UNLOCK();
 
-    LE_FATAL_IF(LE_OK != le_path_Concat("/",
-                                        credsPathStr,
-                                        sizeof(credsPathStr),
-                                        CredentialLocations[credId],
-                                        NULL), "Buffer is not long enough");
-    le_result_t result = le_secStore_Read(credsPathStr, (uint8_t*)bufferPtr, lenPtr);
     if (LE_OK != result)
     {
         LE_ERROR("Unable to retrieve credentials for %d: %s: %d %s",
@@ -126,22 +699,33 @@ lwm2mcore_Sid_t lwm2mcore_SetCredential
     size_t                  len         ///< [IN] length of input buffer
 )
 {
-    (void)serverId;
-
     if ((bufferPtr == NULL) || (credId >= LWM2MCORE_CREDENTIAL_MAX))
     {
         return LWM2MCORE_ERR_INVALID_ARG;
     }
 
-    char credsPathStr[LE_SECSTORE_MAX_NAME_BYTES] = SECURE_STORAGE_PREFIX;
+    char credsPathStr[LE_SECSTORE_MAX_NAME_BYTES];
+
+    GetCredentialPath(credId, serverId, credsPathStr, sizeof(credsPathStr));
 
-    LE_FATAL_IF(LE_OK != le_path_Concat("/",
-                                        credsPathStr,
-                                        sizeof(credsPathStr),
-                                        CredentialLocations[credId],
-                                        NULL), "Buffer is not long enough");
+    LOCK();
 
+    int nsIndex = GetNamespaceIndex(credId, serverId);
     le_result_t result = le_secStore_Write(credsPathStr, (uint8_t*)bufferPtr, len);
+
+    // The cached copy is stale in any case, the presence is unknown if the write failed
+    EvictCredential(nsIndex, credId);
+    if (LE_OK == result)
+    {
+        SetPresence(nsIndex, credId, (0 != len) ? PRESENCE_PRESENT : PRESENCE_EMPTY);
+    }
+    else
+    {
+        SetPresence(nsIndex, credId, PRESENCE_UNKNOWN);
+    }
+
+    UNLOCK();
+
     if (LE_OK != result)
     {
         LE_ERROR("Unable to write credentials for %d", credId);
@@ -157,8 +741,9 @@ lwm2mcore_Sid_t lwm2mcore_SetCredential
 /**
  * Function to check if one credential is present in platform storage.
  *
- * Since there is no GetSize in the le_secStore.api, tries to retrieve the credentials with a buffer
- * too small.
+ * The presence bitmap is used when the presence of the credential is already known. Otherwise,
+ * since there is no GetSize in the le_secStore.api, tries to retrieve the credentials, which also
+ * fills the presence bitmap.
  *
  * @return
  *      - true if the credential is present
@@ -174,20 +759,39 @@ bool lwm2mcore_CheckCredential
 {
     char buffer[LWM2MCORE_PUBLICKEY_LEN] = {0};
     size_t bufferSz = sizeof(buffer);
-    bool ret = false;
-    const char* retTxt = "Not Present";
+    bool ret;
+    Presence_t presence;
     lwm2mcore_Sid_t result;
 
-    (void)serverId;
+    if (credId >= LWM2MCORE_CREDENTIAL_MAX)
+    {
+        return false;
+    }
+
+    LOCK();
+    presence = GetPresence(GetNamespaceIndex(credId, serverId), credId);
+    UNLOCK();
 
-    result = lwm2mcore_GetCredential(credId, serverId, buffer, &bufferSz);
-    if ((LWM2MCORE_ERR_COMPLETED_OK == result) && bufferSz)
+    if (PRESENCE_UNKNOWN == presence)
     {
-        ret = true;
-        retTxt = "Present";
+        result = lwm2mcore_GetCredential(credId, serverId, buffer, &bufferSz);
+        Zeroize(buffer, sizeof(buffer));
+
+        LOCK();
+        presence = GetPresence(GetNamespaceIndex(credId, serverId), credId);
+        UNLOCK();
+
+        if (PRESENCE_UNKNOWN == presence)
+        {
+            presence = ((LWM2MCORE_ERR_COMPLETED_OK == result) && bufferSz) ?
+                       PRESENCE_PRESENT : PRESENCE_ABSENT;
+        }
     }
 
-    LE_DEBUG("credId %d result %s [%d]", credId, retTxt, ret);
+    // An empty credential is not usable
+    ret = (PRESENCE_PRESENT == presence);
+
+    LE_DEBUG("credId %d result %s [%d]", credId, ret ? "Present" : "Not Present", ret);
     return ret;
 }
 
@@ -206,23 +810,28 @@ bool lwm2mcore_DeleteCredential
     uint16_t                serverId    ///< [IN] server Id
 )
 {
-    (void)serverId;
-
     if (credId >= LWM2MCORE_CREDENTIAL_MAX)
     {
         LE_ERROR("Bad parameter credId[%u]", credId);
         return LE_BAD_PARAMETER;
     }
 
-    char credsPathStr[LE_SECSTORE_MAX_NAME_BYTES] = SECURE_STORAGE_PREFIX;
+    char credsPathStr[LE_SECSTORE_MAX_NAME_BYTES];
+
+    GetCredentialPath(credId, serverId, credsPathStr, sizeof(credsPathStr));
 
-    LE_FATAL_IF(LE_OK != le_path_Concat("/",
-                                        credsPathStr,
-                                        sizeof(credsPathStr),
-                                        CredentialLocations[credId],
-                                        NULL), "Buffer is not long enough");
+    LOCK();
 
+    int nsIndex = GetNamespaceIndex(credId, serverId);
     le_result_t result = le_secStore_Delete(credsPathStr);
+
+    // The cached copy is dropped in any case, the presence is unknown if the deletion failed
+    EvictCredential(nsIndex, credId);
+    SetPresence(nsIndex, credId, ((LE_OK == result) || (LE_NOT_FOUND == result)) ?
+                                 PRESENCE_ABSENT : PRESENCE_UNKNOWN);
+
+    UNLOCK();
+
     if ((LE_OK != result) && (LE_NOT_FOUND != result))
     {
         LE_ERROR("Unable to delete credentials for %d: %d %s",
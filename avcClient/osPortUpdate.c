@@ -10,6 +10,8 @@
 #include <lwm2mcore/update.h>
 #include <packageDownloader.h>
 #include <packageDownloaderCallbacks.h>
+#include <packagePush.h>
+#include <packageLocal.h>
 #include "legato.h"
 #include "interfaces.h"
 #include "avcAppUpdate.h"
@@ -109,6 +111,7 @@ static void StartDownloadTimerExpiryHandler
 )
 {
     uint64_t packageSize;
+    le_result_t result;
     StartDownloadCtx_t* startDwlCtxPtr = (StartDownloadCtx_t*)le_timer_GetContextPtr(timerRef);
 
     if (!startDwlCtxPtr)
@@ -117,8 +120,17 @@ static void StartDownloadTimerExpiryHandler
         return;
     }
 
-    // Retrieve update package size from server
-    if (LE_OK != pkgDwlCb_GetPackageSize((char*)startDwlCtxPtr->uri, &packageSize))
+    // Retrieve update package size from server, or from the local file or feeder
+    if (packageLocal_IsLocalUri((char*)startDwlCtxPtr->uri))
+    {
+        result = packageLocal_GetPackageSize((char*)startDwlCtxPtr->uri, &packageSize);
+    }
+    else
+    {
+        result = pkgDwlCb_GetPackageSize((char*)startDwlCtxPtr->uri, &packageSize);
+    }
+
+    if (LE_OK != result)
     {
         LE_ERROR("Unable to retrieve package size, request user agreement anyway");
         packageSize = 0;
@@ -180,10 +192,100 @@ static bool IsPackageDownloading
 
 //--------------------------------------------------------------------------------------------------
 /**
- * The server pushes a package to the LWM2M client
+ * Prepare a new package download: store the resume information and reset the update state
  *
  * @return
- *      - LWM2MCORE_ERR_OP_NOT_SUPPORTED  if the resource is not supported
+ *      - LE_OK if the treatment succeeds
+ *      - LE_FAULT if the treatment fails
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t PrepareUpdate
+(
+    lwm2mcore_UpdateType_t type,    ///< [IN] Update type
+    uint16_t instanceId,            ///< [IN] Instance Id (0 for FW, any value for SW)
+    char* uriPtr                    ///< [IN] Package URI
+)
+{
+    // Store URI and update type to be able to resume the download if necessary. This should be
+    // the very first step to reduce the window between receiving uri and storing it flash storage.
+    if (LE_OK != packageDownloader_SetResumeInfo(uriPtr, type))
+    {
+        return LE_FAULT;
+    }
+    // Delete all unfinished/aborted SOTA/FOTA job info. Also, reset the update state
+    switch (type)
+    {
+        case LWM2MCORE_FW_UPDATE_TYPE:
+            // Delete aborted/stale stored SOTA job info. Otherwise, they may create problem during
+            // FOTA suspend resume activity.
+            avcApp_DeletePackage();
+
+            // Now reset the state
+            if (DWL_OK != packageDownloader_SetFwUpdateResult(
+                                                    LWM2MCORE_FW_UPDATE_RESULT_DEFAULT_NORMAL))
+            {
+                return LE_FAULT;
+            }
+            break;
+
+        case LWM2MCORE_SW_UPDATE_TYPE:
+            // Delete aborted/stale stored FOTA job info. Otherwise, they may create problem during
+            // SOTA suspend resume activity.
+            packageDownloader_DeleteFwUpdateInfo();
+
+            // For SOTA upgrade, no create command is issued. So if device reboots after uninstall,
+            // there is a chance that no SOTA object is dedicated for this uri. So create a SOTA
+            // object if there is currently none.
+            if (LE_FAULT == avcApp_CreateObj9Instance(instanceId))
+            {
+                return LE_FAULT;
+            }
+            break;
+
+        default:
+            LE_ERROR("Unknown download type");
+            return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a pushed package of the given type can be resumed
+ *
+ * @return
+ *  true if the pushed package was partially stored, false otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsPushResumable
+(
+    lwm2mcore_UpdateType_t type     ///< [IN] Update type
+)
+{
+    char uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES];
+    size_t uriSize = sizeof(uri);
+    lwm2mcore_UpdateType_t storedType = LWM2MCORE_MAX_UPDATE_TYPE;
+
+    return ((LE_OK == packageDownloader_GetResumeInfo(uri, &uriSize, &storedType))
+            && (packagePush_IsPushUri(uri))
+            && (storedType == type)
+            && (IsPackageDownloading(type)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The server pushes a package to the LWM2M client: the package is written in the Package resource
+ * instead of a package URI, and is stored as a downloaded package. An empty package resets the
+ * update as an empty package URI.
+ *
+ * If a pushed package was interrupted, it is resumed: the bytes already stored are dropped.
+ *
+ * @return
+ *      - LWM2MCORE_ERR_COMPLETED_OK if the treatment succeeds
+ *      - LWM2MCORE_ERR_INVALID_ARG if a parameter is invalid in resource handler
+ *      - LWM2MCORE_ERR_INVALID_STATE if the package should be sent again later
+ *      - LWM2MCORE_ERR_GENERAL_ERROR if the treatment fails
  */
 //--------------------------------------------------------------------------------------------------
 lwm2mcore_Sid_t lwm2mcore_PushUpdatePackage
@@ -194,7 +296,55 @@ lwm2mcore_Sid_t lwm2mcore_PushUpdatePackage
     size_t len                      ///< [IN] Length of input buffer
 )
 {
-    return LWM2MCORE_ERR_OP_NOT_SUPPORTED;
+    bool resume;
+
+    if (0 == len)
+    {
+        return lwm2mcore_SetUpdatePackageUri(type, instanceId, bufferPtr, len);
+    }
+
+    if ((!bufferPtr) || (LWM2MCORE_MAX_UPDATE_TYPE <= type))
+    {
+        LE_ERROR("lwm2mcore_PushUpdatePackage: bad parameter");
+        return LWM2MCORE_ERR_INVALID_ARG;
+    }
+
+    // The package is copied before the update state is changed
+    switch (packagePush_Prepare((uint8_t*)bufferPtr, len))
+    {
+        case LE_OK:
+            break;
+
+        case LE_BAD_PARAMETER:
+            return LWM2MCORE_ERR_INVALID_ARG;
+
+        case LE_BUSY:
+            return LWM2MCORE_ERR_INVALID_STATE;
+
+        default:
+            return LWM2MCORE_ERR_GENERAL_ERROR;
+    }
+
+    resume = IsPushResumable(type);
+    if ((!resume) && (LE_OK != PrepareUpdate(type, instanceId, PACKAGEPUSH_URI)))
+    {
+        packagePush_Cancel();
+        return LWM2MCORE_ERR_GENERAL_ERROR;
+    }
+
+    if (!resume)
+    {
+        // Received a new package: clear all query handler references which might be left by
+        // previous aborted or stale SOTA/FOTA jobs.
+        avcServer_ResetQueryHandlers();
+    }
+
+    if (LE_OK != packagePush_Start(type, resume))
+    {
+        return LWM2MCORE_ERR_GENERAL_ERROR;
+    }
+
+    return LWM2MCORE_ERR_COMPLETED_OK;
 }
 
 
@@ -248,46 +398,10 @@ lwm2mcore_Sid_t lwm2mcore_SetUpdatePackageUri
     memcpy(downloadUri, bufferPtr, len);
     LE_DEBUG("Request to download update package from URL : %s, len %zd", downloadUri, len);
 
-    // Store URI and update type to be able to resume the download if necessary. This should be
-    // the very first step to reduce the window between receiving uri and storing it flash storage.
-    if (LE_OK != packageDownloader_SetResumeInfo((char *)downloadUri, type))
+    if (LE_OK != PrepareUpdate(type, instanceId, (char*)downloadUri))
     {
         return LWM2MCORE_ERR_GENERAL_ERROR;
     }
-    // Delete all unfinished/aborted SOTA/FOTA job info. Also, reset the update state
-    switch (type)
-    {
-        case LWM2MCORE_FW_UPDATE_TYPE:
-            // Delete aborted/stale stored SOTA job info. Otherwise, they may create problem during
-            // FOTA suspend resume activity.
-            avcApp_DeletePackage();
-
-            // Now reset the state
-            if (DWL_OK != packageDownloader_SetFwUpdateResult(
-                                                    LWM2MCORE_FW_UPDATE_RESULT_DEFAULT_NORMAL))
-            {
-                return LWM2MCORE_ERR_GENERAL_ERROR;
-            }
-            break;
-
-        case LWM2MCORE_SW_UPDATE_TYPE:
-            // Delete aborted/stale stored FOTA job info. Otherwise, they may create problem during
-            // SOTA suspend resume activity.
-            packageDownloader_DeleteFwUpdateInfo();
-
-            // For SOTA upgrade, no create command is issued. So if device reboots after uninstall,
-            // there is a chance that no SOTA object is dedicated for this uri. So create a SOTA
-            // object if there is currently none.
-            if (LE_FAULT == avcApp_CreateObj9Instance(instanceId))
-            {
-                return LWM2MCORE_ERR_GENERAL_ERROR;
-            }
-            break;
-
-        default:
-            LE_ERROR("Unknown download type");
-            return LWM2MCORE_ERR_GENERAL_ERROR;
-    }
 
     // Acknowledge the update package URI notification and launch the download later
     memset(DownloadCtx.uri, 0, LWM2MCORE_PACKAGE_URI_MAX_BYTES);
@@ -860,6 +974,13 @@ lwm2mcore_Sid_t lwm2mcore_ResumePackageDownload
 
     LE_DEBUG("Download to resume");
 
+    // A pushed package is resumed when the server writes it again
+    if (packagePush_IsPushUri(downloadUri))
+    {
+        LE_INFO("Pushed package to resume by the server");
+        return LWM2MCORE_ERR_COMPLETED_OK;
+    }
+
     if (   (0 == strncmp(downloadUri, "", LWM2MCORE_PACKAGE_URI_MAX_BYTES))
         || (LWM2MCORE_MAX_UPDATE_TYPE == updateType)
        )
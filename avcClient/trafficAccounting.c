@@ -0,0 +1,558 @@
+/**
+ * @file trafficAccounting.c
+ *
+ * Traffic accounting of the AirVantage connector.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include <legato.h>
+#include <interfaces.h>
+#include <avcFs.h>
+#include <avcFsConfig.h>
+#include "trafficAccounting.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default file providing the network interface counters
+ */
+//--------------------------------------------------------------------------------------------------
+#define INTERFACE_COUNTERS_FILE         "/proc/net/dev"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a line of the network interface counters file
+ */
+//--------------------------------------------------------------------------------------------------
+#define INTERFACE_COUNTERS_LINE_BYTES   256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of accounted bytes after which the totals are stored in the filesystem
+ */
+//--------------------------------------------------------------------------------------------------
+#define TOTALS_SAVE_THRESHOLD_BYTES     (64 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Totals per purpose, stored in the filesystem
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    trafficAccounting_Counters_t purpose[TRAFFICACCOUNTING_PURPOSE_MAX];    ///< Purpose totals
+}
+Totals_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bearer counters collection
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char                         ifName[TRAFFICACCOUNTING_IFNAME_BYTES]; ///< Bearer interface
+    bool                         isCollecting;  ///< Collection is ongoing
+    trafficAccounting_Counters_t base;          ///< Interface counters at the collection start
+    trafficAccounting_Counters_t collected;     ///< Bytes collected on the previous interfaces
+}
+BearerCollection_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current totals per purpose
+ */
+//--------------------------------------------------------------------------------------------------
+static Totals_t Totals;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes accounted since the last time the totals were stored
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t UnsavedBytes = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bearer counters collection
+ */
+//--------------------------------------------------------------------------------------------------
+static BearerCollection_t Bearer;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * File providing the network interface counters
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* InterfaceCountersFilePtr = INTERFACE_COUNTERS_FILE;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex to prevent race condition between the download thread and the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t AccountingMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&AccountingMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&AccountingMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store the totals. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SaveTotals
+(
+    void
+)
+{
+    le_result_t result = WriteFs(TRAFFIC_ACCOUNTING_FILENAME, (uint8_t*)&Totals, sizeof(Totals_t));
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to write %s: %s", TRAFFIC_ACCOUNTING_FILENAME, LE_RESULT_TXT(result));
+        return;
+    }
+
+    UnsavedBytes = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the counters of a network interface from the interface counters file
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_NOT_FOUND      The interface does not exist
+ *  - LE_FAULT          The interface counters could not be read
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadInterfaceCounters
+(
+    const char*                     ifNamePtr,      ///< [IN] Interface name
+    trafficAccounting_Counters_t*   countersPtr     ///< [OUT] Interface counters
+)
+{
+    char line[INTERFACE_COUNTERS_LINE_BYTES];
+    le_result_t result = LE_NOT_FOUND;
+    FILE* filePtr;
+
+    filePtr = fopen(InterfaceCountersFilePtr, "r");
+    if (!filePtr)
+    {
+        LE_ERROR("Unable to open %s: %m", InterfaceCountersFilePtr);
+        return LE_FAULT;
+    }
+
+    // Each interface line is "<name>: <rx bytes> <7 rx fields> <tx bytes> <7 tx fields>", the
+    // header lines do not have any colon before the counters
+    while (NULL != fgets(line, sizeof(line), filePtr))
+    {
+        char* separatorPtr = strchr(line, ':');
+        char* namePtr = line;
+
+        if (!separatorPtr)
+        {
+            continue;
+        }
+        *separatorPtr = '\0';
+
+        while (isspace((unsigned char)*namePtr))
+        {
+            namePtr++;
+        }
+
+        if (0 != strcmp(namePtr, ifNamePtr))
+        {
+            continue;
+        }
+
+        if (2 != sscanf(separatorPtr + 1,
+                        "%" SCNu64 " %*u %*u %*u %*u %*u %*u %*u %" SCNu64,
+                        &countersPtr->rxBytes,
+                        &countersPtr->txBytes))
+        {
+            LE_ERROR("Malformed counters for interface %s", ifNamePtr);
+            result = LE_FAULT;
+        }
+        else
+        {
+            result = LE_OK;
+        }
+        break;
+    }
+
+    fclose(filePtr);
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the bytes exchanged on the bearer interface since the collection start or the last
+ * interface change. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadBearerDelta
+(
+    trafficAccounting_Counters_t* deltaPtr      ///< [OUT] Bytes exchanged on the bearer interface
+)
+{
+    trafficAccounting_Counters_t current;
+
+    memset(deltaPtr, 0, sizeof(trafficAccounting_Counters_t));
+
+    if (   ('\0' == Bearer.ifName[0])
+        || (LE_OK != ReadInterfaceCounters(Bearer.ifName, &current)))
+    {
+        return;
+    }
+
+    // The interface counters restart from zero when the interface is recreated
+    deltaPtr->txBytes = (current.txBytes >= Bearer.base.txBytes) ?
+                        (current.txBytes - Bearer.base.txBytes) : current.txBytes;
+    deltaPtr->rxBytes = (current.rxBytes >= Bearer.base.rxBytes) ?
+                        (current.rxBytes - Bearer.base.rxBytes) : current.rxBytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the current counters of the bearer interface as the new collection base. Should be called
+ * with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetBearerBase
+(
+    void
+)
+{
+    memset(&Bearer.base, 0, sizeof(Bearer.base));
+
+    if ('\0' != Bearer.ifName[0])
+    {
+        ReadInterfaceCounters(Bearer.ifName, &Bearer.base);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the traffic accounting: read the stored totals
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficAccounting_Init
+(
+    void
+)
+{
+    Totals_t totals;
+    size_t size;
+
+    LOCK();
+
+    memset(&Totals, 0, sizeof(Totals));
+    if (LE_OK == ExistsFs(TRAFFIC_ACCOUNTING_FILENAME))
+    {
+        size = sizeof(Totals_t);
+        if (   (LE_OK == ReadFs(TRAFFIC_ACCOUNTING_FILENAME, (uint8_t*)&totals, &size))
+            && (sizeof(Totals_t) == size))
+        {
+            Totals = totals;
+        }
+        else
+        {
+            LE_ERROR("Failed to read %s", TRAFFIC_ACCOUNTING_FILENAME);
+        }
+    }
+
+    UnsavedBytes = 0;
+
+    LE_DEBUG("Session traffic: %"PRIu64" bytes sent, %"PRIu64" bytes received",
+             Totals.purpose[TRAFFICACCOUNTING_PURPOSE_SESSION].txBytes,
+             Totals.purpose[TRAFFICACCOUNTING_PURPOSE_SESSION].rxBytes);
+
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Account bytes sent and received by avcService for a given purpose.
+ *
+ * @note Can be called from any thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_Add
+(
+    trafficAccounting_Purpose_t purpose,    ///< [IN] Traffic purpose
+    size_t                      txBytes,    ///< [IN] Bytes sent
+    size_t                      rxBytes     ///< [IN] Bytes received
+)
+{
+    if (purpose >= TRAFFICACCOUNTING_PURPOSE_MAX)
+    {
+        LE_ERROR("Invalid purpose %d", purpose);
+        return;
+    }
+
+    LOCK();
+
+    Totals.purpose[purpose].txBytes += txBytes;
+    Totals.purpose[purpose].rxBytes += rxBytes;
+    UnsavedBytes += txBytes + rxBytes;
+
+    // Limit the number of writes in the filesystem, the last bytes are stored at the end of the
+    // session or of the download
+    if (UnsavedBytes >= TOTALS_SAVE_THRESHOLD_BYTES)
+    {
+        SaveTotals();
+    }
+
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the bytes sent and received by avcService for a given purpose since the last reset
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Invalid purpose or null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficAccounting_GetPurposeCounters
+(
+    trafficAccounting_Purpose_t     purpose,        ///< [IN] Traffic purpose
+    trafficAccounting_Counters_t*   countersPtr     ///< [OUT] Traffic counters
+)
+{
+    if ((purpose >= TRAFFICACCOUNTING_PURPOSE_MAX) || (!countersPtr))
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+    *countersPtr = Totals.purpose[purpose];
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset and store the totals of all purposes
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_ResetPurposeCounters
+(
+    void
+)
+{
+    LOCK();
+    memset(&Totals, 0, sizeof(Totals));
+    SaveTotals();
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store the totals in the filesystem if they changed since the last time they were stored
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_Save
+(
+    void
+)
+{
+    LOCK();
+    if (UnsavedBytes)
+    {
+        SaveTotals();
+    }
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the counters of a network interface
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ *  - LE_NOT_FOUND      The interface does not exist
+ *  - LE_FAULT          The interface counters could not be read
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficAccounting_GetInterfaceCounters
+(
+    const char*                     ifNamePtr,      ///< [IN] Interface name
+    trafficAccounting_Counters_t*   countersPtr     ///< [OUT] Interface counters
+)
+{
+    if ((!ifNamePtr) || (!countersPtr))
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    return ReadInterfaceCounters(ifNamePtr, countersPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the network interface of the data connection bearer. The bytes exchanged on the previous
+ * interface are kept in the collected counters.
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_SetBearerInterface
+(
+    const char* ifNamePtr       ///< [IN] Interface name
+)
+{
+    if (!ifNamePtr)
+    {
+        return;
+    }
+
+    LOCK();
+
+    if (0 == strcmp(Bearer.ifName, ifNamePtr))
+    {
+        UNLOCK();
+        return;
+    }
+
+    if (Bearer.isCollecting)
+    {
+        trafficAccounting_Counters_t delta;
+
+        ReadBearerDelta(&delta);
+        Bearer.collected.txBytes += delta.txBytes;
+        Bearer.collected.rxBytes += delta.rxBytes;
+    }
+
+    if (LE_OK != le_utf8_Copy(Bearer.ifName, ifNamePtr, sizeof(Bearer.ifName), NULL))
+    {
+        LE_ERROR("Interface name too long: %s", ifNamePtr);
+        Bearer.ifName[0] = '\0';
+    }
+
+    LE_DEBUG("Bearer interface: %s", Bearer.ifName);
+
+    if (Bearer.isCollecting)
+    {
+        ResetBearerBase();
+    }
+
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the bearer counters and start to collect the bytes exchanged on the bearer interface
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_StartBearerCollection
+(
+    void
+)
+{
+    LOCK();
+    memset(&Bearer.collected, 0, sizeof(Bearer.collected));
+    ResetBearerBase();
+    Bearer.isCollecting = true;
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop to collect the bytes exchanged on the bearer interface, without resetting the counters
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_StopBearerCollection
+(
+    void
+)
+{
+    LOCK();
+
+    if (Bearer.isCollecting)
+    {
+        trafficAccounting_Counters_t delta;
+
+        ReadBearerDelta(&delta);
+        Bearer.collected.txBytes += delta.txBytes;
+        Bearer.collected.rxBytes += delta.rxBytes;
+        Bearer.isCollecting = false;
+    }
+
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the bytes exchanged on the bearer interfaces during the collection period
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficAccounting_GetBearerCounters
+(
+    trafficAccounting_Counters_t*   countersPtr     ///< [OUT] Bearer counters
+)
+{
+    if (!countersPtr)
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+
+    *countersPtr = Bearer.collected;
+
+    if (Bearer.isCollecting)
+    {
+        trafficAccounting_Counters_t delta;
+
+        ReadBearerDelta(&delta);
+        countersPtr->txBytes += delta.txBytes;
+        countersPtr->rxBytes += delta.rxBytes;
+    }
+
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the file providing the network interface counters, in the /proc/net/dev format.
+ *
+ * @note Only used by the unit tests, the default file is /proc/net/dev.
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_SetInterfaceCountersFile
+(
+    const char* pathPtr         ///< [IN] Path of the interface counters file
+)
+{
+    LOCK();
+    InterfaceCountersFilePtr = (pathPtr) ? pathPtr : INTERFACE_COUNTERS_FILE;
+    UNLOCK();
+}
@@ -0,0 +1,196 @@
+/**
+ * @file trafficAccounting.h
+ *
+ * Traffic accounting of the AirVantage connector.
+ *
+ * Two kinds of counters are maintained:
+ * - the bytes sent and received by avcService itself, per purpose (LwM2M session, push, firmware
+ *   and software package downloads). These totals are persisted in the AVC filesystem so that
+ *   they survive a restart.
+ * - the bytes sent and received on the network interface of the data connection bearer, read
+ *   from the kernel interface counters. They are collected between the start and the stop of the
+ *   connectivity statistics (LwM2M object 7) and follow the bearer changes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _TRAFFICACCOUNTING_H
+#define _TRAFFICACCOUNTING_H
+
+#include <legato.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a network interface name, including the null-terminator
+ */
+//--------------------------------------------------------------------------------------------------
+#define TRAFFICACCOUNTING_IFNAME_BYTES      16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Purposes of the traffic caused by avcService
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    TRAFFICACCOUNTING_PURPOSE_SESSION = 0,  ///< LwM2M session: DTLS/CoAP datagrams
+    TRAFFICACCOUNTING_PURPOSE_PUSH,         ///< Pushed data payload, also part of the session
+    TRAFFICACCOUNTING_PURPOSE_FOTA,         ///< Firmware package download
+    TRAFFICACCOUNTING_PURPOSE_SOTA,         ///< Software package download
+    TRAFFICACCOUNTING_PURPOSE_MAX           ///< Number of purposes
+}
+trafficAccounting_Purpose_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Traffic counters
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t txBytes;       ///< Bytes sent
+    uint64_t rxBytes;       ///< Bytes received
+}
+trafficAccounting_Counters_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the traffic accounting: read the stored totals
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficAccounting_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Account bytes sent and received by avcService for a given purpose.
+ *
+ * @note Can be called from any thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_Add
+(
+    trafficAccounting_Purpose_t purpose,    ///< [IN] Traffic purpose
+    size_t                      txBytes,    ///< [IN] Bytes sent
+    size_t                      rxBytes     ///< [IN] Bytes received
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the bytes sent and received by avcService for a given purpose since the last reset
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Invalid purpose or null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficAccounting_GetPurposeCounters
+(
+    trafficAccounting_Purpose_t     purpose,        ///< [IN] Traffic purpose
+    trafficAccounting_Counters_t*   countersPtr     ///< [OUT] Traffic counters
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset and store the totals of all purposes
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_ResetPurposeCounters
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store the totals in the filesystem if they changed since the last time they were stored
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_Save
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the counters of a network interface
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ *  - LE_NOT_FOUND      The interface does not exist
+ *  - LE_FAULT          The interface counters could not be read
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficAccounting_GetInterfaceCounters
+(
+    const char*                     ifNamePtr,      ///< [IN] Interface name
+    trafficAccounting_Counters_t*   countersPtr     ///< [OUT] Interface counters
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the network interface of the data connection bearer. The bytes exchanged on the previous
+ * interface are kept in the collected counters.
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_SetBearerInterface
+(
+    const char* ifNamePtr       ///< [IN] Interface name
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the bearer counters and start to collect the bytes exchanged on the bearer interface
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_StartBearerCollection
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop to collect the bytes exchanged on the bearer interface, without resetting the counters
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_StopBearerCollection
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the bytes exchanged on the bearer interfaces during the collection period
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficAccounting_GetBearerCounters
+(
+    trafficAccounting_Counters_t*   countersPtr     ///< [OUT] Bearer counters
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the file providing the network interface counters, in the /proc/net/dev format.
+ *
+ * @note Only used by the unit tests, the default file is /proc/net/dev.
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficAccounting_SetInterfaceCountersFile
+(
+    const char* pathPtr         ///< [IN] Path of the interface counters file
+);
+
+#endif /* _TRAFFICACCOUNTING_H */
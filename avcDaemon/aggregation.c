@@ -0,0 +1,715 @@
+/**
+ * @file aggregation.c
+ *
+ * Implementation of the timeseries aggregation windows.
+ *
+ * A window is split in panes of one hop each: a fixed window has a single pane, a sliding window
+ * has window length / hop panes stored in a ring. Each pane keeps running statistics, so a closed
+ * window is computed by combining its panes, and sliding by one hop only resets the oldest pane.
+ *
+ * Quantiles are estimated with a merging t-digest (T. Dunning, "Computing extremely accurate
+ * quantiles using t-digests") of bounded size, using the k1 scale function which keeps the
+ * centroids small at both tails.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "aggregation.h"
+
+#include <math.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * t-digest compression factor. A centroid near the median holds about 1/20 of the samples.
+ */
+//--------------------------------------------------------------------------------------------------
+#define TDIGEST_COMPRESSION     64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of centroids of a t-digest. With the k1 scale function, two adjacent centroids
+ * always span more than one unit of a scale of length compression / 2, which bounds the number of
+ * centroids to the compression factor.
+ */
+//--------------------------------------------------------------------------------------------------
+#define TDIGEST_MAX_CENTROIDS   TDIGEST_COMPRESSION
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of samples buffered before being merged in the t-digest centroids
+ */
+//--------------------------------------------------------------------------------------------------
+#define TDIGEST_BUFFER_SIZE     32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Centroid of a t-digest: mean of a cluster of samples and number of samples
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    double mean;
+    double weight;
+}
+Centroid_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * t-digest quantile sketch
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    Centroid_t centroids[TDIGEST_MAX_CENTROIDS];    ///< Merged centroids, sorted by mean
+    size_t     numCentroids;                        ///< Number of merged centroids
+    Centroid_t buffer[TDIGEST_BUFFER_SIZE];         ///< Samples not merged yet
+    size_t     numBuffered;                         ///< Number of samples not merged yet
+    double     totalWeight;                         ///< Total weight, buffered samples included
+    double     min;                                 ///< Smallest sample
+    double     max;                                 ///< Largest sample
+}
+TDigest_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Running statistics of one hop of a window
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t   count;           ///< Number of samples
+    double     min;             ///< Smallest sample
+    double     max;             ///< Largest sample
+    double     sum;             ///< Sum of the samples
+    double     last;            ///< Last added sample
+    TDigest_t* digestPtr;       ///< Quantile sketch, NULL if no quantile is configured
+}
+Pane_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregation window
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct aggregation_Window
+{
+    aggregation_Config_t config;                    ///< Window configuration
+    uint32_t   hopMs;                               ///< Pane length in milliseconds
+    uint32_t   numPanes;                            ///< Number of panes in a window
+    bool       isStarted;                           ///< A sample has been added
+    uint64_t   paneStart;                           ///< Start of the current pane
+    uint32_t   currentPane;                         ///< Index of the current pane
+    Pane_t     panes[AGGREGATION_MAX_PANES];        ///< Ring of panes, current one is the newest
+}
+Window_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregation window pool.  Initialized in aggregation_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t WindowPoolRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * t-digest pool.  Initialized in aggregation_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t DigestPoolRef = NULL;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset a t-digest
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetDigest
+(
+    TDigest_t* digestPtr
+)
+{
+    digestPtr->numCentroids = 0;
+    digestPtr->numBuffered = 0;
+    digestPtr->totalWeight = 0;
+    digestPtr->min = INFINITY;
+    digestPtr->max = -INFINITY;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare two centroids by mean, for qsort
+ */
+//--------------------------------------------------------------------------------------------------
+static int CompareCentroids
+(
+    const void* aPtr,
+    const void* bPtr
+)
+{
+    double a = ((const Centroid_t*)aPtr)->mean;
+    double b = ((const Centroid_t*)bPtr)->mean;
+
+    return (a > b) - (a < b);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * k1 scale function of the t-digest, mapping a quantile to a centroid index
+ */
+//--------------------------------------------------------------------------------------------------
+static double ScaleToIndex
+(
+    double q
+)
+{
+    return (TDIGEST_COMPRESSION / (2 * M_PI)) * asin((2 * q) - 1);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Inverse of the k1 scale function
+ */
+//--------------------------------------------------------------------------------------------------
+static double IndexToScale
+(
+    double k
+)
+{
+    double x = k * (2 * M_PI) / TDIGEST_COMPRESSION;
+
+    if (x >= M_PI / 2)
+    {
+        return 1;
+    }
+    if (x <= -M_PI / 2)
+    {
+        return 0;
+    }
+
+    return (sin(x) + 1) / 2;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Merge the buffered samples in the centroids. Adjacent centroids are merged as long as the merged
+ * centroid does not span more than one unit of the scale function.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CompressDigest
+(
+    TDigest_t* digestPtr
+)
+{
+    Centroid_t sorted[TDIGEST_MAX_CENTROIDS + TDIGEST_BUFFER_SIZE];
+    size_t numSorted = digestPtr->numCentroids + digestPtr->numBuffered;
+    size_t i;
+
+    if (0 == digestPtr->numBuffered)
+    {
+        return;
+    }
+
+    memcpy(sorted, digestPtr->centroids, digestPtr->numCentroids * sizeof(Centroid_t));
+    memcpy(&sorted[digestPtr->numCentroids], digestPtr->buffer,
+           digestPtr->numBuffered * sizeof(Centroid_t));
+    qsort(sorted, numSorted, sizeof(Centroid_t), CompareCentroids);
+
+    double total = digestPtr->totalWeight;
+    double weightSoFar = 0;
+    double weightLimit = total * IndexToScale(ScaleToIndex(0) + 1);
+    size_t last = 0;
+
+    digestPtr->centroids[0] = sorted[0];
+
+    for (i = 1; i < numSorted; i++)
+    {
+        Centroid_t* currentPtr = &digestPtr->centroids[last];
+        double proposed = weightSoFar + currentPtr->weight + sorted[i].weight;
+
+        // The last centroid absorbs everything if the bound is ever reached.
+        if ((proposed <= weightLimit) || (TDIGEST_MAX_CENTROIDS - 1 == last))
+        {
+            currentPtr->weight += sorted[i].weight;
+            currentPtr->mean += (sorted[i].mean - currentPtr->mean) * sorted[i].weight /
+                                currentPtr->weight;
+        }
+        else
+        {
+            weightSoFar += currentPtr->weight;
+            weightLimit = total * IndexToScale(ScaleToIndex(weightSoFar / total) + 1);
+            digestPtr->centroids[++last] = sorted[i];
+        }
+    }
+
+    digestPtr->numCentroids = last + 1;
+    digestPtr->numBuffered = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a weighted sample to a t-digest
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddToDigest
+(
+    TDigest_t* digestPtr,
+    double value,
+    double weight
+)
+{
+    if (TDIGEST_BUFFER_SIZE == digestPtr->numBuffered)
+    {
+        CompressDigest(digestPtr);
+    }
+
+    digestPtr->buffer[digestPtr->numBuffered].mean = value;
+    digestPtr->buffer[digestPtr->numBuffered].weight = weight;
+    digestPtr->numBuffered++;
+    digestPtr->totalWeight += weight;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Merge a t-digest into another one
+ */
+//--------------------------------------------------------------------------------------------------
+static void MergeDigest
+(
+    TDigest_t* destPtr,
+    const TDigest_t* srcPtr
+)
+{
+    size_t i;
+
+    for (i = 0; i < srcPtr->numCentroids; i++)
+    {
+        AddToDigest(destPtr, srcPtr->centroids[i].mean, srcPtr->centroids[i].weight);
+    }
+    for (i = 0; i < srcPtr->numBuffered; i++)
+    {
+        AddToDigest(destPtr, srcPtr->buffer[i].mean, srcPtr->buffer[i].weight);
+    }
+
+    destPtr->min = fmin(destPtr->min, srcPtr->min);
+    destPtr->max = fmax(destPtr->max, srcPtr->max);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Estimate a quantile from a t-digest, by interpolating between the centroid centers. The
+ * smallest and largest samples are exact.
+ */
+//--------------------------------------------------------------------------------------------------
+static double GetQuantile
+(
+    TDigest_t* digestPtr,
+    double q
+)
+{
+    size_t i;
+
+    CompressDigest(digestPtr);
+
+    if (0 == digestPtr->numCentroids)
+    {
+        return NAN;
+    }
+
+    double total = digestPtr->totalWeight;
+    double target = q * total;
+    const Centroid_t* firstPtr = &digestPtr->centroids[0];
+    const Centroid_t* lastPtr = &digestPtr->centroids[digestPtr->numCentroids - 1];
+    double estimate;
+
+    if ((1 == digestPtr->numCentroids) && (1 == firstPtr->weight))
+    {
+        return firstPtr->mean;
+    }
+
+    if (target < (firstPtr->weight / 2))
+    {
+        estimate = digestPtr->min + (firstPtr->mean - digestPtr->min) * target /
+                                    (firstPtr->weight / 2);
+    }
+    else if (target > (total - (lastPtr->weight / 2)))
+    {
+        estimate = lastPtr->mean + (digestPtr->max - lastPtr->mean) *
+                                   (target - (total - (lastPtr->weight / 2))) /
+                                   (lastPtr->weight / 2);
+    }
+    else
+    {
+        double cumulative = 0;
+        estimate = lastPtr->mean;
+
+        for (i = 0; (i + 1) < digestPtr->numCentroids; i++)
+        {
+            const Centroid_t* leftPtr = &digestPtr->centroids[i];
+            const Centroid_t* rightPtr = &digestPtr->centroids[i + 1];
+            double leftCenter = cumulative + (leftPtr->weight / 2);
+            double rightCenter = cumulative + leftPtr->weight + (rightPtr->weight / 2);
+
+            if (target <= rightCenter)
+            {
+                estimate = leftPtr->mean + (rightPtr->mean - leftPtr->mean) *
+                                           (target - leftCenter) / (rightCenter - leftCenter);
+                break;
+            }
+
+            cumulative += leftPtr->weight;
+        }
+    }
+
+    return fmax(digestPtr->min, fmin(digestPtr->max, estimate));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the statistics of a pane
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetPane
+(
+    Pane_t* panePtr
+)
+{
+    panePtr->count = 0;
+    panePtr->min = INFINITY;
+    panePtr->max = -INFINITY;
+    panePtr->sum = 0;
+    panePtr->last = 0;
+
+    if (NULL != panePtr->digestPtr)
+    {
+        ResetDigest(panePtr->digestPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the start of the pane holding a timestamp. Panes are aligned on the epoch, so that windows
+ * of all the resources are aligned.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetPaneStart
+(
+    const Window_t* windowPtr,
+    uint64_t timestamp
+)
+{
+    return timestamp - (timestamp % windowPtr->hopMs);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check an aggregation window configuration.
+ *
+ * @return:
+ *      - LE_OK if the configuration is valid
+ *      - LE_BAD_PARAMETER otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t aggregation_CheckConfig
+(
+    const aggregation_Config_t* configPtr   ///< [IN] Window configuration
+)
+{
+    if (NULL == configPtr)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    uint32_t hopMs = (0 == configPtr->hopMs) ? configPtr->windowMs : configPtr->hopMs;
+
+    if ((0 == configPtr->windowMs) || (hopMs > configPtr->windowMs) ||
+        (0 != (configPtr->windowMs % hopMs)) ||
+        ((configPtr->windowMs / hopMs) > AGGREGATION_MAX_PANES))
+    {
+        LE_ERROR("Invalid window %" PRIu32 " ms, hop %" PRIu32 " ms",
+                 configPtr->windowMs, configPtr->hopMs);
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((0 == configPtr->stats) || (0 != (configPtr->stats & ~AGGREGATION_STAT_ALL)))
+    {
+        LE_ERROR("Invalid statistics 0x%" PRIx32, configPtr->stats);
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((configPtr->stats & AGGREGATION_STAT_QUANTILE) &&
+        (!((configPtr->quantile >= 0) && (configPtr->quantile <= 1))))
+    {
+        LE_ERROR("Invalid quantile %f", configPtr->quantile);
+        return LE_BAD_PARAMETER;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create an aggregation window.
+ *
+ * @return:
+ *      - Reference to the window
+ *      - NULL if the configuration is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+aggregation_Ref_t aggregation_Create
+(
+    const aggregation_Config_t* configPtr   ///< [IN] Window configuration
+)
+{
+    uint32_t i;
+
+    if (LE_OK != aggregation_CheckConfig(configPtr))
+    {
+        return NULL;
+    }
+
+    Window_t* windowPtr = le_mem_ForceAlloc(WindowPoolRef);
+    memset(windowPtr, 0, sizeof(Window_t));
+
+    windowPtr->config = *configPtr;
+    windowPtr->hopMs = (0 == configPtr->hopMs) ? configPtr->windowMs : configPtr->hopMs;
+    windowPtr->numPanes = configPtr->windowMs / windowPtr->hopMs;
+    windowPtr->isStarted = false;
+
+    for (i = 0; i < windowPtr->numPanes; i++)
+    {
+        if (configPtr->stats & AGGREGATION_STAT_QUANTILE)
+        {
+            windowPtr->panes[i].digestPtr = le_mem_ForceAlloc(DigestPoolRef);
+        }
+        ResetPane(&windowPtr->panes[i]);
+    }
+
+    return windowPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete an aggregation window. Samples of the window not yet closed are lost.
+ */
+//--------------------------------------------------------------------------------------------------
+void aggregation_Delete
+(
+    aggregation_Ref_t windowRef             ///< [IN] Window reference
+)
+{
+    uint32_t i;
+
+    for (i = 0; i < windowRef->numPanes; i++)
+    {
+        if (NULL != windowRef->panes[i].digestPtr)
+        {
+            le_mem_Release(windowRef->panes[i].digestPtr);
+        }
+    }
+
+    le_mem_Release(windowRef);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of the oldest window closed at a given time, if any. The window is only
+ * released by aggregation_Advance(), so the statistics can be requested again if they could not be
+ * stored.
+ *
+ * @return:
+ *      - true if a window is closed, resultPtr is filled
+ *      - false otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+bool aggregation_GetClosedWindow
+(
+    aggregation_Ref_t windowRef,            ///< [IN] Window reference
+    uint64_t timestamp,                     ///< [IN] Current time in milliseconds
+    aggregation_Result_t* resultPtr         ///< [OUT] Statistics of the closed window
+)
+{
+    uint64_t windowEnd = windowRef->paneStart + windowRef->hopMs;
+    uint32_t count = 0;
+    uint32_t i;
+
+    if ((!windowRef->isStarted) || (timestamp < windowEnd))
+    {
+        return false;
+    }
+
+    for (i = 0; i < windowRef->numPanes; i++)
+    {
+        count += windowRef->panes[i].count;
+    }
+
+    // Nothing left to report: jump over the empty windows.
+    if (0 == count)
+    {
+        windowRef->paneStart = GetPaneStart(windowRef, timestamp);
+        return false;
+    }
+
+    memset(resultPtr, 0, sizeof(aggregation_Result_t));
+    resultPtr->timestamp = (windowEnd > windowRef->config.windowMs) ?
+                           (windowEnd - windowRef->config.windowMs) : 0;
+    resultPtr->count = count;
+    resultPtr->min = INFINITY;
+    resultPtr->max = -INFINITY;
+
+    TDigest_t mergedDigest;
+    TDigest_t* digestPtr = NULL;
+    double sum = 0;
+
+    if (windowRef->config.stats & AGGREGATION_STAT_QUANTILE)
+    {
+        if (1 == windowRef->numPanes)
+        {
+            digestPtr = windowRef->panes[0].digestPtr;
+        }
+        else
+        {
+            ResetDigest(&mergedDigest);
+            digestPtr = &mergedDigest;
+        }
+    }
+
+    // Walk the ring from the oldest pane to the newest one, so that the last sample is the last
+    // one of the newest non-empty pane.
+    for (i = 1; i <= windowRef->numPanes; i++)
+    {
+        const Pane_t* panePtr =
+            &windowRef->panes[(windowRef->currentPane + i) % windowRef->numPanes];
+
+        if (0 == panePtr->count)
+        {
+            continue;
+        }
+
+        resultPtr->min = fmin(resultPtr->min, panePtr->min);
+        resultPtr->max = fmax(resultPtr->max, panePtr->max);
+        resultPtr->last = panePtr->last;
+        sum += panePtr->sum;
+
+        if ((NULL != digestPtr) && (digestPtr != panePtr->digestPtr))
+        {
+            MergeDigest(digestPtr, panePtr->digestPtr);
+        }
+    }
+
+    resultPtr->mean = sum / count;
+
+    if (NULL != digestPtr)
+    {
+        resultPtr->quantile = GetQuantile(digestPtr, windowRef->config.quantile);
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the oldest closed window, returned by aggregation_GetClosedWindow().
+ */
+//--------------------------------------------------------------------------------------------------
+void aggregation_Advance
+(
+    aggregation_Ref_t windowRef             ///< [IN] Window reference
+)
+{
+    windowRef->paneStart += windowRef->hopMs;
+    windowRef->currentPane = (windowRef->currentPane + 1) % windowRef->numPanes;
+    ResetPane(&windowRef->panes[windowRef->currentPane]);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a sample to the current window. A sample older than the current window is accounted in the
+ * current window.
+ */
+//--------------------------------------------------------------------------------------------------
+void aggregation_Add
+(
+    aggregation_Ref_t windowRef,            ///< [IN] Window reference
+    uint64_t timestamp,                     ///< [IN] Sample time in milliseconds
+    double value                            ///< [IN] Sample value
+)
+{
+    if (!windowRef->isStarted)
+    {
+        windowRef->paneStart = GetPaneStart(windowRef, timestamp);
+        windowRef->isStarted = true;
+    }
+
+    Pane_t* panePtr = &windowRef->panes[windowRef->currentPane];
+
+    panePtr->count++;
+    panePtr->min = fmin(panePtr->min, value);
+    panePtr->max = fmax(panePtr->max, value);
+    panePtr->sum += value;
+    panePtr->last = value;
+
+    if (NULL != panePtr->digestPtr)
+    {
+        AddToDigest(panePtr->digestPtr, value, 1);
+        panePtr->digestPtr->min = fmin(panePtr->digestPtr->min, value);
+        panePtr->digestPtr->max = fmax(panePtr->digestPtr->max, value);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the memory used by an aggregation window. It does not depend on the number of samples.
+ *
+ * @return:
+ *      - Memory footprint in bytes
+ */
+//--------------------------------------------------------------------------------------------------
+size_t aggregation_GetMemorySize
+(
+    aggregation_Ref_t windowRef             ///< [IN] Window reference
+)
+{
+    size_t size = sizeof(Window_t);
+
+    if (windowRef->config.stats & AGGREGATION_STAT_QUANTILE)
+    {
+        size += windowRef->numPanes * sizeof(TDigest_t);
+    }
+
+    return size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Init this sub-component
+ */
+//--------------------------------------------------------------------------------------------------
+void aggregation_Init
+(
+    void
+)
+{
+    WindowPoolRef = le_mem_CreatePool("Aggregation window pool", sizeof(Window_t));
+    DigestPoolRef = le_mem_CreatePool("t-digest pool", sizeof(TDigest_t));
+}
@@ -0,0 +1,203 @@
+/**
+ * @file aggregation.h
+ *
+ * Interface of the timeseries aggregation windows. Samples of a resource are reduced to running
+ * statistics (min, max, mean, count, last and optionally a quantile estimated with a t-digest)
+ * over fixed or sliding windows, with a memory footprint independent of the sample rate.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_AGGREGATION_INCLUDE_GUARD
+#define LEGATO_AGGREGATION_INCLUDE_GUARD
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+// Definitions.
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of hops in a sliding window, i.e. window length / hop length
+ */
+//--------------------------------------------------------------------------------------------------
+#define AGGREGATION_MAX_PANES   8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Statistics computed over a window, to be combined in a bitmask
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    AGGREGATION_STAT_MIN      = 0x01,   ///< Smallest sample
+    AGGREGATION_STAT_MAX      = 0x02,   ///< Largest sample
+    AGGREGATION_STAT_MEAN     = 0x04,   ///< Arithmetic mean of the samples
+    AGGREGATION_STAT_COUNT    = 0x08,   ///< Number of samples
+    AGGREGATION_STAT_LAST     = 0x10,   ///< Last recorded sample
+    AGGREGATION_STAT_QUANTILE = 0x20,   ///< Quantile estimated with a t-digest
+    AGGREGATION_STAT_ALL      = 0x3F
+}
+aggregation_Stat_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregation window configuration
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t windowMs;      ///< Window length in milliseconds
+    uint32_t hopMs;         ///< Sliding window hop in milliseconds, 0 for fixed windows. The window
+                            ///< length must be a multiple of the hop.
+    uint32_t stats;         ///< Statistics to compute, bitmask of aggregation_Stat_t
+    double   quantile;      ///< Quantile in [0, 1] estimated with AGGREGATION_STAT_QUANTILE
+}
+aggregation_Config_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Statistics of a closed window
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t timestamp;     ///< Start of the window in milliseconds
+    uint32_t count;         ///< Number of samples
+    double   min;           ///< Smallest sample
+    double   max;           ///< Largest sample
+    double   mean;          ///< Arithmetic mean of the samples
+    double   last;          ///< Last recorded sample
+    double   quantile;      ///< Estimated quantile, if configured
+}
+aggregation_Result_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference to an aggregation window
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct aggregation_Window* aggregation_Ref_t;
+
+
+//--------------------------------------------------------------------------------------------------
+// Interface functions
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check an aggregation window configuration.
+ *
+ * @return:
+ *      - LE_OK if the configuration is valid
+ *      - LE_BAD_PARAMETER otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t aggregation_CheckConfig
+(
+    const aggregation_Config_t* configPtr   ///< [IN] Window configuration
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create an aggregation window.
+ *
+ * @return:
+ *      - Reference to the window
+ *      - NULL if the configuration is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED aggregation_Ref_t aggregation_Create
+(
+    const aggregation_Config_t* configPtr   ///< [IN] Window configuration
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete an aggregation window. Samples of the window not yet closed are lost.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED void aggregation_Delete
+(
+    aggregation_Ref_t windowRef             ///< [IN] Window reference
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of the oldest window closed at a given time, if any. The window is only
+ * released by aggregation_Advance(), so the statistics can be requested again if they could not be
+ * stored.
+ *
+ * Windows are closed by time: the caller must drain the closed windows with this function and
+ * aggregation_Advance() before adding a sample with aggregation_Add().
+ *
+ * @return:
+ *      - true if a window is closed, resultPtr is filled
+ *      - false otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED bool aggregation_GetClosedWindow
+(
+    aggregation_Ref_t windowRef,            ///< [IN] Window reference
+    uint64_t timestamp,                     ///< [IN] Current time in milliseconds
+    aggregation_Result_t* resultPtr         ///< [OUT] Statistics of the closed window
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the oldest closed window, returned by aggregation_GetClosedWindow().
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED void aggregation_Advance
+(
+    aggregation_Ref_t windowRef             ///< [IN] Window reference
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a sample to the current window. A sample older than the current window is accounted in the
+ * current window.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED void aggregation_Add
+(
+    aggregation_Ref_t windowRef,            ///< [IN] Window reference
+    uint64_t timestamp,                     ///< [IN] Sample time in milliseconds
+    double value                            ///< [IN] Sample value
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the memory used by an aggregation window. It does not depend on the number of samples.
+ *
+ * @return:
+ *      - Memory footprint in bytes
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED size_t aggregation_GetMemorySize
+(
+    aggregation_Ref_t windowRef             ///< [IN] Window reference
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Init this sub-component
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED void aggregation_Init
+(
+    void
+);
+
+#endif // LEGATO_AGGREGATION_INCLUDE_GUARD
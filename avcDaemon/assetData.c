@@ -162,14 +162,50 @@ typedef struct
         assetData_AssetActionHandlerFunc_t assetActionHandlerPtr;
                             ///< User supplied handler for asset actions
     };
-    void* contextPtr;       ///< User supplied context pointer
-    int fieldId;            ///< If action is on a field
-    bool isClient;          ///< Is handler registered by client or server
-    le_dls_Link_t link;     ///< For adding to field or asset action list
+    void* contextPtr;           ///< User supplied context pointer
+    int fieldId;                ///< If action is on a field
+    bool isClient;              ///< Is handler registered by client or server
+    AssetData_t* assetDataPtr;  ///< If action is on a field, asset the handler is registered on
+    bool isRemoved;             ///< Removed while the handlers of its field are called
+    le_dls_Link_t link;         ///< For adding to field or asset action list
+    le_dls_Link_t fieldLink;    ///< For adding to the handler list of a FieldActionMap entry
 }
 ActionHandlerData_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Key of the field action dispatch table: handlers are indexed by field, and by the origin of the
+ * registration, since client registered handlers are only called on server actions and vice versa.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    AssetData_t* assetDataPtr;  ///< Asset the handlers are registered on
+    int fieldId;                ///< Field the handlers are registered on
+    bool isClient;              ///< Are the handlers registered by the client or the server
+}
+FieldActionKey_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Entry of the field action dispatch table. It only exists while at least one handler is
+ * registered on the field.
+ *
+ * The handlers removed while the handlers of the field are called are only marked, and are
+ * released from the list once the calls are done.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    FieldActionKey_t key;       ///< Key of the entry in FieldActionMap
+    le_dls_List_t handlerList;  ///< Handlers registered on the field, in registration order
+    int callDepth;              ///< Number of ongoing calls of the handlers of the field
+}
+FieldActionEntry_t;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Entry in table mapping data type strings to DataType_t values. All strings must be literals,
@@ -222,6 +258,14 @@ static le_mem_PoolRef_t AssetDataPoolRef = NULL;
 static le_mem_PoolRef_t ActionHandlerDataPoolRef = NULL;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Field action dispatch table entry memory pool.  Initialized in assetData_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t FieldActionEntryPoolRef = NULL;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * This pool is used for the string representation of a LWM2M address, which is used as a key in a
@@ -255,6 +299,16 @@ static le_hashmap_Ref_t AssetMap = NULL;
 static le_hashmap_Ref_t AssetMapByName = NULL;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maps (asset, fieldId, isClient) to the handlers registered on that field, so that an action on
+ * a field without handler is dispatched without walking the handler lists.  Initialized in
+ * assetData_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t FieldActionMap = NULL;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Used to delay reporting REG_UPDATE, so that we don't generate too much message traffic.
@@ -1170,6 +1224,189 @@ static le_result_t GetField
 
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash function for FieldActionMap keys
+ *
+ * @return:
+ *      - Hash of the (asset, fieldId, isClient) key
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t HashFieldActionKey
+(
+    const void* keyPtr              ///< [IN] FieldActionKey_t to hash
+)
+{
+    const FieldActionKey_t* fieldKeyPtr = keyPtr;
+    size_t hash = (size_t)(uintptr_t)fieldKeyPtr->assetDataPtr;
+
+    hash = (hash * 31) + (size_t)(unsigned int)fieldKeyPtr->fieldId;
+    hash = (hash * 2) + (fieldKeyPtr->isClient ? 1 : 0);
+
+    return hash;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Equality function for FieldActionMap keys
+ *
+ * @return:
+ *      - true if both keys designate the same field and registration origin
+ *      - false otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static bool EqualsFieldActionKey
+(
+    const void* firstKeyPtr,        ///< [IN] First FieldActionKey_t
+    const void* secondKeyPtr        ///< [IN] Second FieldActionKey_t
+)
+{
+    const FieldActionKey_t* firstPtr = firstKeyPtr;
+    const FieldActionKey_t* secondPtr = secondKeyPtr;
+
+    return ( (firstPtr->assetDataPtr == secondPtr->assetDataPtr) &&
+             (firstPtr->fieldId == secondPtr->fieldId) &&
+             (firstPtr->isClient == secondPtr->isClient) );
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the FieldActionMap entry holding the handlers registered on a field
+ *
+ * @return:
+ *      - Pointer to the entry
+ *      - NULL if no handler is registered on the field with this origin
+ */
+//--------------------------------------------------------------------------------------------------
+static FieldActionEntry_t* GetFieldActionEntry
+(
+    AssetData_t* assetDataPtr,      ///< [IN] Asset containing the field
+    int fieldId,                    ///< [IN] Field id
+    bool isClient                   ///< [IN] Are the handlers registered by client or server
+)
+{
+    FieldActionKey_t key =
+    {
+        .assetDataPtr = assetDataPtr,
+        .fieldId = fieldId,
+        .isClient = isClient
+    };
+
+    return le_hashmap_Get(FieldActionMap, &key);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the handlers removed while the handlers of the field were called, and the
+ * FieldActionMap entry if no handler is left on the field.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SweepFieldActionHandlers
+(
+    FieldActionEntry_t* entryPtr            ///< [IN] Dispatch table entry
+)
+{
+    le_dls_Link_t* linkPtr = le_dls_Peek(&entryPtr->handlerList);
+
+    while ( linkPtr != NULL )
+    {
+        ActionHandlerData_t* handlerDataPtr = CONTAINER_OF(linkPtr, ActionHandlerData_t, fieldLink);
+
+        linkPtr = le_dls_PeekNext(&entryPtr->handlerList, linkPtr);
+
+        if ( handlerDataPtr->isRemoved )
+        {
+            le_dls_Remove(&entryPtr->handlerList, &handlerDataPtr->fieldLink);
+            le_mem_Release(handlerDataPtr);
+        }
+    }
+
+    if ( le_dls_IsEmpty(&entryPtr->handlerList) )
+    {
+        le_hashmap_Remove(FieldActionMap, &entryPtr->key);
+        le_mem_Release(entryPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a field action handler from the dispatch table, and release the FieldActionMap entry if
+ * it was the last handler registered on the field. The handler itself is not released.
+ *
+ * While the handlers of the field are called, the handler is only marked as removed and is kept
+ * in the list until the calls are done.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UnindexFieldActionHandler
+(
+    ActionHandlerData_t* handlerDataPtr     ///< [IN] Handler to remove from the dispatch table
+)
+{
+    FieldActionEntry_t* entryPtr = GetFieldActionEntry(handlerDataPtr->assetDataPtr,
+                                                       handlerDataPtr->fieldId,
+                                                       handlerDataPtr->isClient);
+
+    if ( entryPtr == NULL )
+    {
+        LE_ERROR("Handler for field %i is not indexed", handlerDataPtr->fieldId);
+        return;
+    }
+
+    if ( entryPtr->callDepth > 0 )
+    {
+        // Keep the handler linked for the ongoing calls, it is released by the sweep
+        handlerDataPtr->isRemoved = true;
+        le_mem_AddRef(handlerDataPtr);
+        return;
+    }
+
+    le_dls_Remove(&entryPtr->handlerList, &handlerDataPtr->fieldLink);
+
+    if ( le_dls_IsEmpty(&entryPtr->handlerList) )
+    {
+        le_hashmap_Remove(FieldActionMap, &entryPtr->key);
+        le_mem_Release(entryPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a handler registered on field actions, checking that it was registered with the same
+ * origin, i.e. client or server.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RemoveFieldActionHandler
+(
+    assetData_FieldActionHandlerRef_t handlerRef,   ///< [IN] Handler to remove
+    bool isClient                                   ///< [IN] Is it client or server access
+)
+{
+    ActionHandlerData_t* handlerDataPtr = (ActionHandlerData_t*)handlerRef;
+
+    if ( handlerDataPtr == NULL )
+    {
+        LE_ERROR("Invalid field action handler reference");
+        return;
+    }
+
+    if ( handlerDataPtr->isClient != isClient )
+    {
+        LE_ERROR("Field action handler was registered by the %s",
+                 handlerDataPtr->isClient ? "client" : "server");
+        return;
+    }
+
+    UnindexFieldActionHandler(handlerDataPtr);
+    le_dls_Remove(&handlerDataPtr->assetDataPtr->fieldActionList, &handlerDataPtr->link);
+    le_mem_Release(handlerDataPtr);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Check if a registered handler exists for a field read action.
@@ -1185,9 +1422,6 @@ static bool IsFieldReadCallBackExist
     FieldData_t* fieldDataPtr               ///< [IN] Field data ptr
 )
 {
-    ActionHandlerData_t* handlerDataPtr;
-    le_dls_Link_t* linkPtr;
-
     LE_PRINT_VALUE("%d", fieldDataPtr->access);
 
     // Verify that the field is writeable by the client.
@@ -1196,24 +1430,13 @@ static bool IsFieldReadCallBackExist
         return false;
     }
 
-    // Get the start of the handler list
-    linkPtr = le_dls_Peek(&instanceDataPtr->assetDataPtr->fieldActionList);
-
-    // Loop through the list looking for a handler.
-    while ( linkPtr != NULL )
-    {
-        handlerDataPtr = CONTAINER_OF(linkPtr, ActionHandlerData_t, link);
-
-        // Return true if we find a handler.
-        if ( fieldDataPtr->fieldId == handlerDataPtr->fieldId )
-        {
-           return true;
-        }
-
-        linkPtr = le_dls_PeekNext(&instanceDataPtr->assetDataPtr->fieldActionList, linkPtr);
-    }
-
-    return false;
+    // A handler registered by either the client or the server is enough.
+    return ( ( GetFieldActionEntry(instanceDataPtr->assetDataPtr,
+                                   fieldDataPtr->fieldId,
+                                   true) != NULL ) ||
+             ( GetFieldActionEntry(instanceDataPtr->assetDataPtr,
+                                   fieldDataPtr->fieldId,
+                                   false) != NULL ) );
 }
 
 
@@ -1234,36 +1457,49 @@ static le_result_t CallFieldActionHandlers
     bool isClient                           ///< [IN] Is action from client or server
 )
 {
+    FieldActionEntry_t* entryPtr;
     ActionHandlerData_t* handlerDataPtr;
     le_dls_Link_t* linkPtr;
 
-    // Get the start of the handler list
-    linkPtr = le_dls_Peek(&instanceDataPtr->assetDataPtr->fieldActionList);
+    // Client registered handlers should only be called by server actions, and server registered
+    // handlers should only be called by client actions.
+    entryPtr = GetFieldActionEntry(instanceDataPtr->assetDataPtr, fieldId, !isClient);
+    if ( entryPtr == NULL )
+    {
+        return LE_OK;
+    }
 
-    // Loop through the list, calling the handlers
+    // Keep the entry while the handlers are called. The handlers removed by a handler, including
+    // itself, stay linked until the calls are done, so the list can be walked safely.
+    le_mem_AddRef(entryPtr);
+    entryPtr->callDepth++;
+
+    linkPtr = le_dls_Peek(&entryPtr->handlerList);
+
+    // Loop through the handlers registered on this field, calling them
     while ( linkPtr != NULL )
     {
-        handlerDataPtr = CONTAINER_OF(linkPtr, ActionHandlerData_t, link);
+        handlerDataPtr = CONTAINER_OF(linkPtr, ActionHandlerData_t, fieldLink);
 
-        // The list contains registered handlers for all fields of the given asset, so call only
-        // those handlers that are applicable for this field.
-        if ( fieldId == handlerDataPtr->fieldId )
+        if ( !handlerDataPtr->isRemoved )
         {
-            // Client registered handlers should only be called by server actions, and server
-            // registered handlers should only be called by client actions.
-            if ( ( ( handlerDataPtr->isClient) && (!isClient) ) ||
-                 ( (!handlerDataPtr->isClient) && ( isClient) ) )
-            {
-                handlerDataPtr->fieldActionHandlerPtr(instanceDataPtr,
-                                                      fieldId,
-                                                      action,
-                                                      handlerDataPtr->contextPtr);
-            }
+            handlerDataPtr->fieldActionHandlerPtr(instanceDataPtr,
+                                                  fieldId,
+                                                  action,
+                                                  handlerDataPtr->contextPtr);
         }
 
-        linkPtr = le_dls_PeekNext(&instanceDataPtr->assetDataPtr->fieldActionList, linkPtr);
+        linkPtr = le_dls_PeekNext(&entryPtr->handlerList, linkPtr);
+    }
+
+    entryPtr->callDepth--;
+    if ( entryPtr->callDepth == 0 )
+    {
+        SweepFieldActionHandlers(entryPtr);
     }
 
+    le_mem_Release(entryPtr);
+
     return LE_OK;
 }
 
@@ -1881,15 +2117,36 @@ static assetData_FieldActionHandlerRef_t AddFieldActionHandler
 {
     ActionHandlerData_t* newHandlerDataPtr;
 
+    FieldActionEntry_t* entryPtr;
+
     newHandlerDataPtr = le_mem_ForceAlloc(ActionHandlerDataPoolRef);
     newHandlerDataPtr->fieldActionHandlerPtr = handlerPtr;
     newHandlerDataPtr->contextPtr = contextPtr;
     newHandlerDataPtr->fieldId = fieldId;
     newHandlerDataPtr->isClient = isClient;
+    newHandlerDataPtr->assetDataPtr = assetRef;
+    newHandlerDataPtr->isRemoved = false;
 
     newHandlerDataPtr->link = LE_DLS_LINK_INIT;
     le_dls_Queue(&assetRef->fieldActionList, &newHandlerDataPtr->link);
 
+    // Index the handler by field, creating the dispatch table entry for the first handler
+    entryPtr = GetFieldActionEntry(assetRef, fieldId, isClient);
+    if ( entryPtr == NULL )
+    {
+        entryPtr = le_mem_ForceAlloc(FieldActionEntryPoolRef);
+        entryPtr->key.assetDataPtr = assetRef;
+        entryPtr->key.fieldId = fieldId;
+        entryPtr->key.isClient = isClient;
+        entryPtr->handlerList = LE_DLS_LIST_INIT;
+        entryPtr->callDepth = 0;
+
+        le_hashmap_Put(FieldActionMap, &entryPtr->key, entryPtr);
+    }
+
+    newHandlerDataPtr->fieldLink = LE_DLS_LINK_INIT;
+    le_dls_Queue(&entryPtr->handlerList, &newHandlerDataPtr->fieldLink);
+
     // return something unique as a reference
     return (assetData_FieldActionHandlerRef_t)newHandlerDataPtr;
 }
@@ -1919,6 +2176,7 @@ static assetData_AssetActionHandlerRef_t AddAssetActionHandler
     newHandlerDataPtr->contextPtr = contextPtr;
     newHandlerDataPtr->fieldId = -1;
     newHandlerDataPtr->isClient = isClient;
+    newHandlerDataPtr->assetDataPtr = NULL;
 
     newHandlerDataPtr->link = LE_DLS_LINK_INIT;
     le_dls_Queue(&assetRef->assetActionList, &newHandlerDataPtr->link);
@@ -2244,10 +2502,11 @@ void assetData_DeleteInstanceAndAsset
         // Get the first item from the handler list
         linkPtr = le_dls_Pop(&assetDataPtr->fieldActionList);
 
-        // Loop through the list, deleting each item
+        // Loop through the list, deleting each item and its dispatch table entry
         while ( linkPtr != NULL )
         {
             handlerDataPtr = CONTAINER_OF(linkPtr, ActionHandlerData_t, link);
+            UnindexFieldActionHandler(handlerDataPtr);
             le_mem_Release(handlerDataPtr);
 
             linkPtr = le_dls_Pop(&assetDataPtr->fieldActionList);
@@ -2796,7 +3055,7 @@ void assetData_client_RemoveFieldActionHandler
     assetData_FieldActionHandlerRef_t handlerRef
 )
 {
-    // IMPLEMENT LATER
+    RemoveFieldActionHandler(handlerRef, true);
 }
 
 
@@ -3191,7 +3450,7 @@ void assetData_server_RemoveFieldActionHandler
     assetData_FieldActionHandlerRef_t handlerRef
 )
 {
-    // IMPLEMENT LATER
+    RemoveFieldActionHandler(handlerRef, false);
 }
 
 
@@ -3281,6 +3540,8 @@ le_result_t assetData_Init
     AssetDataPoolRef = le_mem_CreatePool("Asset data pool", sizeof(AssetData_t));
     ActionHandlerDataPoolRef = le_mem_CreatePool("Action handler data pool",
                                                  sizeof(ActionHandlerData_t));
+    FieldActionEntryPoolRef = le_mem_CreatePool("Field action entry pool",
+                                                sizeof(FieldActionEntry_t));
 
     StringValuePoolRef = le_mem_CreatePool("String value pool", STRING_VALUE_NUMBYTES);
     AddressStringPoolRef = le_mem_CreatePool("Address pool", 100);
@@ -3294,6 +3555,11 @@ le_result_t assetData_Init
                                        le_hashmap_HashString,
                                        le_hashmap_EqualsString);
 
+    // Create FieldActionMap that maps (asset, fieldId, isClient) to the registered handlers.
+    FieldActionMap = le_hashmap_Create("Field action map",
+                                       31,
+                                       HashFieldActionKey,
+                                       EqualsFieldActionKey);
 
     // Use a timer to delay reporting instance creation events to the modem for 1 second after
     // the last creation event.  The timer will only be started when the creation event happens.
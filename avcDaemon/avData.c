@@ -17,9 +17,14 @@
 #include "timeseriesData.h"
 #include "avcServer.h"
 #include "avcClient.h"
+#include "avData.h"
+#include "changeStream.h"
+#include "senml.h"
 #include "le_print.h"
 #include "limit.h"
 #include "push.h"
+#include "quota.h"
+#include "resourceIndex.h"
 #include "sessionManager.h"
 #include "appCfg.h"
 #include "watchdogChain.h"
@@ -81,6 +86,67 @@
 //--------------------------------------------------------------------------------------------------
 #define SLASH_DELIMITER_CHAR '/'
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP FETCH method code (RFC 8132), used by the server for composite reads. It is not part of
+ * coap_method_t.
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_FETCH_METHOD 5
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP response codes which are not part of lwm2mcore_CoapResponseCode_t: 4.13 Request Entity Too
+ * Large, 5.03 Service Unavailable and 5.04 Gateway Timeout.
+ */
+//--------------------------------------------------------------------------------------------------
+#define COAP_ENTITY_TOO_LARGE_CODE ((lwm2mcore_CoapResponseCode_t)141)
+#define COAP_SERVICE_UNAVAILABLE_CODE ((lwm2mcore_CoapResponseCode_t)163)
+#define COAP_GATEWAY_TIMEOUT_CODE ((lwm2mcore_CoapResponseCode_t)164)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree path of the AVC service, and default deadline of a command execution in seconds.
+ * The deadline is read from the execTimeout node, 0 waits for the result without deadline.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_AVC_SERVICE_PATH "/apps/avcService"
+#define DEFAULT_EXEC_TIMEOUT 60
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffer size in bytes for a SenML read response. A read whose SenML pack does not fit is
+ * rejected with 4.13 Request Entity Too Large, the server has to split it into smaller reads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SENML_READ_BUFFER_BYTES 4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config node of the SenML representation of the read responses, relative to the AVC service
+ * path, and its values. Any other value keeps the legacy CBOR representation.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_READ_FORMAT             "readFormat"
+#define CFG_READ_FORMAT_SENML_CBOR  "senml+cbor"
+#define CFG_READ_FORMAT_SENML_JSON  "senml+json"
+#define CFG_READ_FORMAT_BYTES       16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Quota name of the clients which are not part of an application. They share the same quotas.
+ */
+//--------------------------------------------------------------------------------------------------
+#define NON_APP_CLIENT_NAME "_noApp"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delay before saving the resource index after a change of the asset data tree, in seconds. The
+ * changes done while an application creates its resources are saved at once.
+ */
+//--------------------------------------------------------------------------------------------------
+#define RESOURCE_INDEX_SAVE_DELAY 1
+
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -219,6 +285,8 @@ typedef struct
 {
     le_msg_SessionRef_t msgRef;                 ///< Session reference.
     le_avdata_Namespace_t namespace;            ///< Asset data namespace
+    char appName[LE_LIMIT_APP_NAME_LEN + 1];    ///< Client application name
+    quota_AppRef_t quotaRef;                    ///< Quotas of the client application
     le_dls_Link_t link;
 }
 AssetDataClient_t;
@@ -255,10 +323,76 @@ typedef struct
     void* contextPtr;                           ///< Client context for the handler.
     le_dls_List_t arguments;                    ///< Argument list for the handler.
     le_msg_SessionRef_t msgRef;                 ///< Session reference.
+    le_avdata_Namespace_t namespace;            ///< Namespace of the owning application.
+    char ownerApp[LE_LIMIT_APP_NAME_LEN + 1];   ///< Owning application, empty if unknown.
+    bool isPendingOwner;                        ///< Restored from the resource index, waiting
+                                                ///< for the owning application to claim it.
+    uint32_t execTimeoutMs;                     ///< Deadline of a command execution, 0 for the
+                                                ///< default one.
+    struct PendingExec* pendingExecPtr;         ///< Command execution waiting for its result.
 }
 AssetData_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Command execution requested by the server and waiting for le_avdata_ReplyExecResult(). The
+ * request and its response are kept here, as the next server requests overwrite the global ones.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct PendingExec
+{
+    le_avdata_ArgumentListRef_t argListRef;     ///< Argument list given to the command handler.
+    AssetData_t* assetDataPtr;                  ///< Executed asset data.
+    lwm2mcore_Ref_t instanceRef;                ///< AVC client session instance of the request.
+    lwm2mcore_CoapRequest_t* serverReqRef;      ///< Server request to answer.
+    lwm2mcore_CoapResponse_t response;          ///< Response, filled with the request token.
+    le_timer_Ref_t timerRef;                    ///< Deadline of the command execution, NULL if
+                                                ///< none.
+}
+PendingExec_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pending command execution memory pool. Initialized in avData_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t PendingExecPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool for the SenML read response buffers
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t SenmlBufferPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool for the SenML record arrays of the read responses, AVDATA_COMPOSITE_READ_MAX_ENTRIES
+ * records per block
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t SenmlRecordPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SenML representation of the read responses. LwM2MCore does not give the Accept option of a
+ * request, so the representation is configured for the device instead of negotiated per request.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSenmlRead = false;
+static senml_Format_t SenmlReadFormat = SENML_FORMAT_CBOR;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default deadline of a command execution in ms, 0 if none. Read in avData_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t DefaultExecTimeoutMs;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Structure representing an argument in an Argument List.
@@ -284,10 +418,38 @@ typedef struct
 {
     le_avdata_RecordRef_t recRef;               ///< Record ref
     le_msg_SessionRef_t clientSessionRef;       ///< Client using this record ref
+    quota_AppRef_t quotaRef;                    ///< Quotas of the client application
+    size_t chargedBytes;                        ///< Record bytes accounted in the quotas
 }
 RecordRefData_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Context of a push requested by a client, to account the push in the client quotas until its
+ * result is known.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    quota_AppRef_t quotaRef;                    ///< Quotas of the client application
+    le_avdata_CallbackResultFunc_t handlerPtr;  ///< Client push result callback
+    void* contextPtr;                           ///< Client context
+    bool isQueued;                              ///< Push queued, the context is released by the
+                                                ///< result callback
+    bool isCompleted;                           ///< Result callback already called
+}
+PushContext_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push context memory pool. Initialized in avData_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t PushContextPoolRef = NULL;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Record reference data memory pool. Used for keeping track of the client that is using a
@@ -353,6 +515,14 @@ static le_clk_Time_t AvServerWriteStartTime;
 static le_cfg_IteratorRef_t AssetDataCfgIterRef;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer saving the resource index after a change of the asset data tree
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t ResourceIndexTimerRef = NULL;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Lazily restore settings from config tree when asset data setting is read or created.
@@ -360,7 +530,42 @@ static le_cfg_IteratorRef_t AssetDataCfgIterRef;
 //--------------------------------------------------------------------------------------------------
 static void RestoreSetting
 (
-    const char* path                  ///< [IN] Asset data path
+    const char* path,                 ///< [IN] Asset data path
+    le_msg_SessionRef_t sessionRef    ///< [IN] Session owning the restored setting
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the resource index after a delay, to group the changes of the asset data tree.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScheduleResourceIndexSave
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the quotas of the application of a client session.
+ */
+//--------------------------------------------------------------------------------------------------
+static quota_AppRef_t GetClientQuota
+(
+    le_msg_SessionRef_t sessionRef      ///< [IN] Client session
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of bytes of a string value accounted in the quotas.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetStringBytes
+(
+    AssetValue_t value,                 ///< [IN] Asset value
+    le_avdata_DataType_t dataType       ///< [IN] Asset value data type
 );
 
 
@@ -369,6 +574,118 @@ static void RestoreSetting
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * End a command execution: clean up the argument list and safe ref, and respond to AV server with
+ * the command execution result.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EndPendingExec
+(
+    PendingExec_t* execPtr,                 ///< [IN] Command execution
+    lwm2mcore_CoapResponseCode_t code,      ///< [IN] Response code
+    const uint8_t* payload,                 ///< [IN] Response payload
+    size_t payloadLength                    ///< [IN] Response payload length
+)
+{
+    le_dls_List_t* argListPtr = &execPtr->assetDataPtr->arguments;
+    le_dls_Link_t* argLinkPtr = le_dls_Pop(argListPtr);
+
+    while (argLinkPtr != NULL)
+    {
+        le_mem_Release(CONTAINER_OF(argLinkPtr, Argument_t, link));
+        argLinkPtr = le_dls_Pop(argListPtr);
+    }
+
+    le_ref_DeleteRef(ArgListRefMap, execPtr->argListRef);
+
+    if (NULL != execPtr->timerRef)
+    {
+        le_timer_Delete(execPtr->timerRef);
+    }
+
+    execPtr->response.code = code;
+    execPtr->response.payload = (uint8_t*)payload;
+    execPtr->response.payloadLength = payloadLength;
+    lwm2mcore_SendAsyncResponse(execPtr->instanceRef, execPtr->serverReqRef, &execPtr->response);
+
+    execPtr->assetDataPtr->pendingExecPtr = NULL;
+    le_mem_Release(execPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deadline of a command execution: AV server is answered with a timeout, and the result replied
+ * later by the client is ignored.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ExecTimerHandler
+(
+    le_timer_Ref_t timerRef     ///< [IN] Deadline timer
+)
+{
+    PendingExec_t* execPtr = le_timer_GetContextPtr(timerRef);
+
+    LE_WARN("Command execution timed out, argument list (%p) released", execPtr->argListRef);
+    EndPendingExec(execPtr, COAP_GATEWAY_TIMEOUT_CODE, NULL, 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the command execution of an argument list reference.
+ *
+ * @return:
+ *      - command execution if found
+ *      - NULL if the reference is not the one of a pending command execution
+ */
+//--------------------------------------------------------------------------------------------------
+static PendingExec_t* GetPendingExec
+(
+    le_avdata_ArgumentListRef_t argListRef  ///< [IN] Argument list ref.
+)
+{
+    le_dls_List_t* argListPtr = le_ref_Lookup(ArgListRefMap, argListRef);
+    if (NULL == argListPtr)
+    {
+        return NULL;
+    }
+
+    // The argument lists are the ones of the asset data.
+    PendingExec_t* execPtr = CONTAINER_OF(argListPtr, AssetData_t, arguments)->pendingExecPtr;
+    if ((NULL == execPtr) || (execPtr->argListRef != argListRef))
+    {
+        return NULL;
+    }
+
+    return execPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove an asset data from the asset data tree and free it. The quotas of its owner must already
+ * be released.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DeleteAssetData
+(
+    char* assetPathPtr,             ///< [IN] Asset data path, key of the asset data map
+    AssetData_t* assetDataPtr       ///< [IN] Asset data
+)
+{
+    if ((LE_AVDATA_DATA_TYPE_STRING == assetDataPtr->dataType) &&
+        (NULL != assetDataPtr->value.strValuePtr))
+    {
+        le_mem_Release(assetDataPtr->value.strValuePtr);
+    }
+    le_hashmap_Remove(AssetDataMap, assetPathPtr);
+    le_mem_Release(assetPathPtr);
+    le_mem_Release(assetDataPtr);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Handler for client session closes
@@ -392,10 +709,30 @@ static void ClientCloseSessionHandler
         assetDataPtr = le_hashmap_GetValue(iter);
         if (assetDataPtr->msgRef == sessionRef)
         {
+            quota_AppRef_t quotaRef = GetClientQuota(sessionRef);
+            quota_Release(quotaRef, QUOTA_STRING_BYTES,
+                          GetStringBytes(assetDataPtr->value, assetDataPtr->dataType));
+            quota_Release(quotaRef, QUOTA_RESOURCES, 1);
+            if (NULL != assetDataPtr->pendingExecPtr)
+            {
+                LE_WARN("Aborting the command execution on %s", assetPathPtr);
+                EndPendingExec(assetDataPtr->pendingExecPtr, COAP_INTERNAL_ERROR, NULL, 0);
+            }
+
+            // The resources of a known application stay in the tree and in the resource index,
+            // until the application claims them again or is uninstalled.
+            if ('\0' != assetDataPtr->ownerApp[0])
+            {
+                LE_DEBUG("Asset data %s waiting for %s", assetPathPtr, assetDataPtr->ownerApp);
+                assetDataPtr->msgRef = NULL;
+                assetDataPtr->handlerPtr = NULL;
+                assetDataPtr->contextPtr = NULL;
+                assetDataPtr->isPendingOwner = true;
+                continue;
+            }
+
             LE_DEBUG("Removing asset data: %s", assetPathPtr);
-            le_hashmap_Remove(AssetDataMap, assetPathPtr);
-            le_mem_Release(assetPathPtr);
-            le_mem_Release(assetDataPtr);
+            DeleteAssetData(assetPathPtr, assetDataPtr);
         }
     }
 
@@ -411,6 +748,7 @@ static void ClientCloseSessionHandler
         {
             // Delete instance data, and also delete asset data, if last instance is deleted
             timeSeries_Delete(recRefDataPtr->recRef);
+            quota_Release(recRefDataPtr->quotaRef, QUOTA_RECORD_BYTES, recRefDataPtr->chargedBytes);
 
             // Delete safe reference and associated data
             le_mem_Release((void*)recRefDataPtr);
@@ -774,12 +1112,36 @@ static AssetData_t* GetAssetData
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the application name of a new client session. The processes which are not part of an
+ * application share the same name.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetSessionAppName
+(
+    le_msg_SessionRef_t sessionRef,     ///< [IN] Client session
+    char* appNamePtr,                   ///< [OUT] Application name
+    size_t appNameSize                  ///< [IN] Size of the application name buffer
+)
+{
+    pid_t pid;
+    uid_t uid;
+
+    if ((LE_OK != le_msg_GetClientUserCreds(sessionRef, &uid, &pid)) ||
+        (LE_OK != le_appInfo_GetName(pid, appNamePtr, appNameSize)))
+    {
+        LE_ASSERT(LE_OK == le_utf8_Copy(appNamePtr, NON_APP_CLIENT_NAME, appNameSize, NULL));
+    }
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Create asset data client with specified namespace
  */
 //--------------------------------------------------------------------------------------------------
-static void CreateAssetDataClient
+static AssetDataClient_t* CreateAssetDataClient
 (
     le_avdata_Namespace_t namespace
 )
@@ -788,8 +1150,14 @@ static void CreateAssetDataClient
     memset(assetDataClientPtr, 0, sizeof(AssetDataClient_t));
     assetDataClientPtr->msgRef = le_avdata_GetClientSessionRef();
     assetDataClientPtr->namespace = namespace;
+    GetSessionAppName(assetDataClientPtr->msgRef,
+                      assetDataClientPtr->appName,
+                      sizeof(assetDataClientPtr->appName));
+    assetDataClientPtr->quotaRef = quota_GetApp(assetDataClientPtr->appName);
     assetDataClientPtr->link = LE_DLS_LINK_INIT;
     le_dls_Queue(&AssetDataClientList, &assetDataClientPtr->link);
+
+    return assetDataClientPtr;
 }
 
 
@@ -851,50 +1219,147 @@ static le_avdata_Namespace_t GetClientSessionNamespace
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the namespaced path. The namespaced path is the application name concatenated with the
- * asset data path by default. However, the user can override this with the global namespace which
- * will not concatenate the path with the app name.
+ * Get the quotas of the application of a client session.
+ *
+ * @return
+ *  - Quotas of the client application, NULL if the session is not a known client
  */
 //--------------------------------------------------------------------------------------------------
-static void GetNamespacedPath
+static quota_AppRef_t GetClientQuota
 (
-    const char* path,
-    char* namespacedPathPtr,
-    size_t namespacedSize
+    le_msg_SessionRef_t sessionRef      ///< [IN] Client session
 )
 {
-    // Get the client's credentials.
-    pid_t pid;
-    uid_t uid;
-
-    le_msg_SessionRef_t sessionRef = le_avdata_GetClientSessionRef();
-
-    if (GetClientSessionNamespace(sessionRef) != LE_AVDATA_NAMESPACE_APPLICATION)
-    {
-        LE_ASSERT(le_utf8_Copy(namespacedPathPtr, path, namespacedSize, NULL) == LE_OK);
-    }
-    else
-    {
-        if (le_msg_GetClientUserCreds(sessionRef, &uid, &pid) != LE_OK)
-        {
-            LE_KILL_CLIENT("Could not get credentials for the client.");
-            return;
-        }
+    AssetDataClient_t* assetDataClientPtr = GetAssetDataClient(sessionRef);
 
-        // Look up the process's application name.
-        char appName[LE_LIMIT_APP_NAME_LEN+1];
+    return (assetDataClientPtr) ? assetDataClientPtr->quotaRef : NULL;
+}
 
-        le_result_t result = le_appInfo_GetName(pid, appName, sizeof(appName));
-        LE_FATAL_IF(result == LE_OVERFLOW, "Buffer too small to contain the application name.");
 
-        if (result != LE_OK)
-        {
-            LE_KILL_CLIENT("Could not get app name");
-        }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the quotas of the application of the current client, created with the default namespace if
+ * the client is not known yet.
+ */
+//--------------------------------------------------------------------------------------------------
+static quota_AppRef_t GetCurrentClientQuota
+(
+    void
+)
+{
+    AssetDataClient_t* assetDataClientPtr = GetAssetDataClient(le_avdata_GetClientSessionRef());
 
-        char namespacedPath[LE_AVDATA_PATH_NAME_BYTES];
-        snprintf(namespacedPath, sizeof(namespacedPath), "%s%s%s", SLASH_DELIMITER_STRING, appName, path);
-        LE_ASSERT(le_utf8_Copy(namespacedPathPtr, namespacedPath, namespacedSize, NULL) == LE_OK);
+    if (NULL == assetDataClientPtr)
+    {
+        assetDataClientPtr = CreateAssetDataClient(LE_AVDATA_NAMESPACE_APPLICATION);
+    }
+
+    return assetDataClientPtr->quotaRef;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of bytes of a string value accounted in the quotas.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetStringBytes
+(
+    AssetValue_t value,                 ///< [IN] Asset value
+    le_avdata_DataType_t dataType       ///< [IN] Asset value data type
+)
+{
+    if ((LE_AVDATA_DATA_TYPE_STRING != dataType) || (NULL == value.strValuePtr))
+    {
+        return 0;
+    }
+
+    return strlen(value.strValuePtr) + 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Claim a resource restored from the resource index, if the client is its owning application.
+ *
+ * @return
+ *  - true if the resource is now owned by the client session
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ClaimResource
+(
+    AssetData_t* assetDataPtr,          ///< [IN] Asset data
+    le_msg_SessionRef_t sessionRef      ///< [IN] Client session
+)
+{
+    AssetDataClient_t* assetDataClientPtr = GetAssetDataClient(sessionRef);
+
+    if ((!assetDataPtr->isPendingOwner) || (NULL == assetDataClientPtr) ||
+        (assetDataPtr->namespace != assetDataClientPtr->namespace) ||
+        (0 != strcmp(assetDataPtr->ownerApp, assetDataClientPtr->appName)))
+    {
+        return false;
+    }
+
+    assetDataPtr->msgRef = sessionRef;
+    assetDataPtr->isPendingOwner = false;
+
+    // The resource was already defined: it is accounted without checking the limits
+    quota_Charge(assetDataClientPtr->quotaRef, QUOTA_RESOURCES, 1);
+    quota_Charge(assetDataClientPtr->quotaRef, QUOTA_STRING_BYTES,
+                 GetStringBytes(assetDataPtr->value, assetDataPtr->dataType));
+
+    LE_DEBUG("Asset data claimed by %s", assetDataClientPtr->appName);
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the namespaced path. The namespaced path is the application name concatenated with the
+ * asset data path by default. However, the user can override this with the global namespace which
+ * will not concatenate the path with the app name.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetNamespacedPath
+(
+    const char* path,
+    char* namespacedPathPtr,
+    size_t namespacedSize
+)
+{
+    // Get the client's credentials.
+    pid_t pid;
+    uid_t uid;
+
+    le_msg_SessionRef_t sessionRef = le_avdata_GetClientSessionRef();
+
+    if (GetClientSessionNamespace(sessionRef) != LE_AVDATA_NAMESPACE_APPLICATION)
+    {
+        LE_ASSERT(le_utf8_Copy(namespacedPathPtr, path, namespacedSize, NULL) == LE_OK);
+    }
+    else
+    {
+        if (le_msg_GetClientUserCreds(sessionRef, &uid, &pid) != LE_OK)
+        {
+            LE_KILL_CLIENT("Could not get credentials for the client.");
+            return;
+        }
+
+        // Look up the process's application name.
+        char appName[LE_LIMIT_APP_NAME_LEN+1];
+
+        le_result_t result = le_appInfo_GetName(pid, appName, sizeof(appName));
+        LE_FATAL_IF(result == LE_OVERFLOW, "Buffer too small to contain the application name.");
+
+        if (result != LE_OK)
+        {
+            LE_KILL_CLIENT("Could not get app name");
+        }
+
+        char namespacedPath[LE_AVDATA_PATH_NAME_BYTES];
+        snprintf(namespacedPath, sizeof(namespacedPath), "%s%s%s", SLASH_DELIMITER_STRING, appName, path);
+        LE_ASSERT(le_utf8_Copy(namespacedPathPtr, namespacedPath, namespacedSize, NULL) == LE_OK);
     }
 
 }
@@ -960,7 +1425,7 @@ static le_result_t GetVal
     }
 
     // Lazily restore setting from config tree to memory.
-    RestoreSetting(namespacedPath);
+    RestoreSetting(namespacedPath, le_avdata_GetClientSessionRef());
 
     // Get asset data from memory
     AssetData_t* assetDataPtr = GetAssetData(namespacedPath);
@@ -1043,6 +1508,50 @@ static void StoreData
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Notify a change of an asset data value to the local change streams
+ */
+//--------------------------------------------------------------------------------------------------
+static void NotifyChange
+(
+    const char* namespacedPath,    ///< [IN] Namespaced asset data path
+    AssetValue_t value,            ///< [IN] New asset value
+    le_avdata_DataType_t dataType, ///< [IN] Asset value data type
+    bool isClient                  ///< [IN] Is it client or server access
+)
+{
+    changeStream_Value_t changeValue;
+
+    memset(&changeValue, 0, sizeof(changeValue));
+
+    switch (dataType)
+    {
+        case LE_AVDATA_DATA_TYPE_INT:
+            changeValue.intValue = value.intValue;
+            break;
+
+        case LE_AVDATA_DATA_TYPE_FLOAT:
+            changeValue.floatValue = value.floatValue;
+            break;
+
+        case LE_AVDATA_DATA_TYPE_BOOL:
+            changeValue.boolValue = value.boolValue;
+            break;
+
+        case LE_AVDATA_DATA_TYPE_STRING:
+            changeValue.strValuePtr = value.strValuePtr;
+            break;
+
+        default:
+            break;
+    }
+
+    changeStream_Notify(namespacedPath, dataType, &changeValue,
+                        isClient ? CHANGESTREAM_ORIGIN_CLIENT : CHANGESTREAM_ORIGIN_SERVER);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Checks asset value associated with the provided asset data path if dry run flag is set.
@@ -1051,6 +1560,7 @@ static void StoreData
  * @return:
  *      - LE_NOT_FOUND - if the path is invalid and does not point to an asset data
  *      - LE_NOT_PERMITTED - asset data being accessed does not have the right permission
+ *      - LE_OUT_OF_RANGE - a client string value exceeds the quota of the application
  *      - LE_OK - access successful.
  */
 //--------------------------------------------------------------------------------------------------
@@ -1102,6 +1612,30 @@ static le_result_t SetVal
     // Don't set anything if dry run flag is set.
     if (!isDryRun)
     {
+        // Account the string bytes in the quotas of the application owning the asset data. Only
+        // the client writes are limited: a value written by the server is always accepted.
+        quota_AppRef_t quotaRef = GetClientQuota(assetDataPtr->msgRef);
+        uint64_t oldBytes = GetStringBytes(assetDataPtr->value, assetDataPtr->dataType);
+        uint64_t newBytes = GetStringBytes(value, dataType);
+
+        if (newBytes > oldBytes)
+        {
+            if (!isClient)
+            {
+                quota_Charge(quotaRef, QUOTA_STRING_BYTES, newBytes - oldBytes);
+            }
+            else if (LE_OK != quota_Reserve(quotaRef, QUOTA_STRING_BYTES, newBytes - oldBytes))
+            {
+                LE_ERROR("Asset (%s) string exceeds the quota of the application.",
+                         namespacedPath);
+                return QUOTA_EXCEEDED;
+            }
+        }
+        else
+        {
+            quota_Release(quotaRef, QUOTA_STRING_BYTES, oldBytes - newBytes);
+        }
+
         // If the current data type is string, we need to free the memory for the string before
         // assigning asset value to the new one.
         if (assetDataPtr->dataType == LE_AVDATA_DATA_TYPE_STRING)
@@ -1113,6 +1647,9 @@ static le_result_t SetVal
         assetDataPtr->value = value;
         assetDataPtr->dataType = dataType;
 
+        // Notify the local subscribers before the handler can set another value
+        NotifyChange(namespacedPath, value, dataType, isClient);
+
         // Call registered handler.
         if ((!isClient) && (assetDataPtr->handlerPtr != NULL))
         {
@@ -1165,6 +1702,12 @@ static le_result_t InitResource
         return LE_DUPLICATE;
     }
 
+    if (LE_OK != quota_Reserve(GetClientQuota(sessionRef), QUOTA_RESOURCES, 1))
+    {
+        LE_ERROR("Asset (%s) exceeds the resource quota of the application.", path);
+        return QUOTA_EXCEEDED;
+    }
+
     char* assetPathPtr = le_mem_ForceAlloc(AssetPathPool);
     AssetData_t* assetDataPtr = le_mem_ForceAlloc(AssetDataPool);
 
@@ -1183,6 +1726,16 @@ static le_result_t InitResource
     assetDataPtr->arguments = LE_DLS_LIST_INIT;
     assetDataPtr->msgRef = sessionRef;
 
+    // Only the resources of a known application are saved in the resource index
+    AssetDataClient_t* assetDataClientPtr = GetAssetDataClient(sessionRef);
+    if (NULL != assetDataClientPtr)
+    {
+        assetDataPtr->namespace = assetDataClientPtr->namespace;
+        LE_ASSERT(LE_OK == le_utf8_Copy(assetDataPtr->ownerApp, assetDataClientPtr->appName,
+                                        sizeof(assetDataPtr->ownerApp), NULL));
+        ScheduleResourceIndexSave();
+    }
+
     le_hashmap_Put(AssetDataMap, assetPathPtr, assetDataPtr);
 
     return LE_OK;
@@ -1196,7 +1749,8 @@ static le_result_t InitResource
 //--------------------------------------------------------------------------------------------------
 static void RestoreSetting
 (
-    const char* path                  ///< [IN] Asset data path
+    const char* path,                 ///< [IN] Asset data path
+    le_msg_SessionRef_t sessionRef    ///< [IN] Session owning the restored setting
 )
 {
     static le_cfg_IteratorRef_t iterRef;
@@ -1216,7 +1770,7 @@ static void RestoreSetting
 
         le_result_t result = InitResource(path,
                                           LE_AVDATA_ACCESS_SETTING,
-                                          le_avdata_GetClientSessionRef());
+                                          sessionRef);
 
         // Restore value from config tree for the new setting
         if (result == LE_OK)
@@ -1977,6 +2531,49 @@ static void RespondToAvServer
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gather the paths under a parent path which are readable by the server. The path array must be
+ * able to hold all the asset data paths. The gathered paths are sorted, so they are grouped at each
+ * level as expected by EncodeMultiData.
+ *
+ * @return:
+ *      - number of paths gathered in the path array
+ */
+//--------------------------------------------------------------------------------------------------
+static int GetReadableChildPaths
+(
+    const char* path,       ///< [IN] Parent path
+    char* pathArray[]       ///< [OUT] Child paths, pointing to the asset data map keys
+)
+{
+    AssetData_t* assetDataPtr;
+    int pathArrayIdx = 0;
+
+    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
+    const char* currentPath;
+
+    while (le_hashmap_NextNode(iter) == LE_OK)
+    {
+        currentPath = le_hashmap_GetKey(iter);
+        assetDataPtr = le_hashmap_GetValue(iter);
+
+        if ((le_path_IsSubpath(path, currentPath, SLASH_DELIMITER_STRING)) &&
+            ((assetDataPtr->serverAccess & LE_AVDATA_ACCESS_READ) == LE_AVDATA_ACCESS_READ))
+        {
+            // Put the currentPath in the path array.
+            pathArray[pathArrayIdx] = (char*)currentPath;
+            pathArrayIdx++;
+        }
+    }
+
+    // Sort the path array. Note that the paths just need to be grouped at each level.
+    qsort(pathArray, pathArrayIdx, sizeof(*pathArray), CompareStrings);
+
+    return pathArrayIdx;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Processes read request from AV server.
@@ -2028,30 +2625,8 @@ static void ProcessAvServerReadRequest
             LE_DEBUG(">>>>> path not found, but is parent path. Encoding all children nodes.");
 
             // Gather all eligible paths in a path array.
-            AssetData_t* assetDataPtr;
             char* pathArray[le_hashmap_Size(AssetDataMap)];
-            memset(pathArray, 0, sizeof(pathArray));
-            int pathArrayIdx = 0;
-
-            le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
-            const char* currentPath;
-
-            while (le_hashmap_NextNode(iter) == LE_OK)
-            {
-                currentPath = le_hashmap_GetKey(iter);
-                assetDataPtr = le_hashmap_GetValue(iter);
-
-                if ((le_path_IsSubpath(path, currentPath, SLASH_DELIMITER_STRING)) &&
-                    ((assetDataPtr->serverAccess & LE_AVDATA_ACCESS_READ) == LE_AVDATA_ACCESS_READ))
-                {
-                    // Put the currentPath in the path array.
-                    pathArray[pathArrayIdx] = (char*)currentPath;
-                    pathArrayIdx++;
-                }
-            }
-
-            // Sort the path array. Note that the paths just need to be grouped at each level.
-            qsort(pathArray, pathArrayIdx, sizeof(*pathArray), CompareStrings);
+            int pathArrayIdx = GetReadableChildPaths(path, pathArray);
 
             // Determine the path depth the encoding should start at.
             int levelCount = 0;
@@ -2300,24 +2875,48 @@ static void ProcessAvServerExecRequest
                 LE_ERROR("Server attempts to execute a command, but no command defined.");
                 RespondToAvServer(COAP_NOT_FOUND, NULL, 0);
             }
+            else if (assetDataPtr->pendingExecPtr != NULL)
+            {
+                // The argument list of the resource is still used by the previous execution.
+                LE_WARN("Server attempts to execute a command which is already executing.");
+                RespondToAvServer(COAP_SERVICE_UNAVAILABLE_CODE, NULL, 0);
+            }
             else
             {
                 le_result_t result = CreateArgList(payload, payloadLen, &assetDataPtr->arguments);
 
                 if (result == LE_OK)
                 {
+                    PendingExec_t* execPtr = le_mem_ForceAlloc(PendingExecPool);
+                    uint32_t timeoutMs = (0 != assetDataPtr->execTimeoutMs) ?
+                                         assetDataPtr->execTimeoutMs : DefaultExecTimeoutMs;
 
                     // Create a safe ref with the argument list, and pass that to the handler.
-                    le_avdata_ArgumentListRef_t argListRef =
-                                         le_ref_CreateRef(ArgListRefMap, &assetDataPtr->arguments);
+                    execPtr->argListRef = le_ref_CreateRef(ArgListRefMap,
+                                                           &assetDataPtr->arguments);
+                    execPtr->assetDataPtr = assetDataPtr;
+                    execPtr->instanceRef = AVCClientSessionInstanceRef;
+                    execPtr->serverReqRef = AVServerReqRef;
+                    execPtr->response = AVServerResponse;
+                    execPtr->timerRef = NULL;
+                    assetDataPtr->pendingExecPtr = execPtr;
+
+                    if (0 != timeoutMs)
+                    {
+                        execPtr->timerRef = le_timer_Create("Exec deadline");
+                        le_timer_SetMsInterval(execPtr->timerRef, timeoutMs);
+                        le_timer_SetContextPtr(execPtr->timerRef, execPtr);
+                        le_timer_SetHandler(execPtr->timerRef, ExecTimerHandler);
+                        le_timer_Start(execPtr->timerRef);
+                    }
 
                     // Execute the command with the argument list collected earlier.
-                    assetDataPtr->handlerPtr(path, LE_AVDATA_ACCESS_EXEC, argListRef,
+                    assetDataPtr->handlerPtr(path, LE_AVDATA_ACCESS_EXEC, execPtr->argListRef,
                                              assetDataPtr->contextPtr);
 
                     // Note that we are not repsonding to AV server yet. The response happens when
                     // the client app finishes command execution and calls
-                    // le_avdata_ReplyExecResult.
+                    // le_avdata_ReplyExecResult, or when the deadline passes.
                 }
                 else
                 {
@@ -2337,101 +2936,648 @@ static void ProcessAvServerExecRequest
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Handles requests from an AV server to read, write, or execute on an asset data.
+ * Append an entry to a composite read snapshot. The path and string value are copied, so the
+ * snapshot stays valid whatever happens to the asset data afterwards.
+ *
+ * @return:
+ *      - LE_OVERFLOW if the entry array is full.
+ *      - LE_OK if success.
  */
 //--------------------------------------------------------------------------------------------------
-static void AvServerRequestHandler
+static le_result_t AddReadEntry
 (
-    lwm2mcore_CoapRequest_t* serverReqRef
+    avData_ReadEntry_t* entryArr,   ///< [IN] Snapshot entries
+    size_t maxEntries,              ///< [IN] Entry array size
+    size_t* numEntriesPtr,          ///< [IN/OUT] Number of entries
+    const char* path,               ///< [IN] Asset data path
+    le_result_t result,             ///< [IN] Read result
+    le_avdata_DataType_t type,      ///< [IN] Asset value data type
+    AssetValue_t value              ///< [IN] Asset value
 )
 {
-    // Save the session context and server request ref, so when reply function such as
-    // le_avdata_ReplyExecResult is called at the end of the command execution,
-    // it can async reply AV server with them.
-    AVCClientSessionInstanceRef = avcClient_GetInstance();
-    if (NULL == AVCClientSessionInstanceRef)
+    if (*numEntriesPtr >= maxEntries)
     {
-        LE_ERROR("Cannot get AVC client session context. Stop processing AV server request.");
-        return;
+        return LE_OVERFLOW;
     }
 
-    AVServerReqRef = serverReqRef;
-
-    // Extract info from the server request.
-    const char* path = lwm2mcore_GetRequestUri(AVServerReqRef); // cannot have trailing slash.
-    coap_method_t method = lwm2mcore_GetRequestMethod(AVServerReqRef);
-    uint8_t* payload = (uint8_t *)lwm2mcore_GetRequestPayload(AVServerReqRef);
-    size_t payloadLen = lwm2mcore_GetRequestPayloadLength(AVServerReqRef);
-    uint8_t* token = (uint8_t *)lwm2mcore_GetToken(AVServerReqRef);
-    size_t tokenLength = lwm2mcore_GetTokenLength(AVServerReqRef);
-
-    // Partially fill in the response.
-    memcpy(AVServerResponse.token, token, tokenLength);
-    AVServerResponse.tokenLength = tokenLength;
-    AVServerResponse.contentType = LWM2MCORE_PUSH_CONTENT_CBOR;
+    avData_ReadEntry_t* entryPtr = &entryArr[*numEntriesPtr];
+    memset(entryPtr, 0, sizeof(avData_ReadEntry_t));
 
-    LE_INFO(">>>>> Request Uri is: [%s]", path);
+    // The path is only reported back to the server, truncation is not an issue.
+    entryPtr->path = le_mem_ForceAlloc(AssetPathPool);
+    le_utf8_Copy(entryPtr->path, path, LE_AVDATA_PATH_NAME_BYTES, NULL);
+    entryPtr->result = result;
+    entryPtr->dataType = LE_AVDATA_DATA_TYPE_NONE;
 
-    switch (method)
+    if (LE_OK == result)
     {
-        case COAP_GET: // server reads from device
-            ProcessAvServerReadRequest(path);
-            break;
-
-        case COAP_PUT: // server writes to device
-            ProcessAvServerWriteRequest(path, payload, payloadLen);
-            break;
+        entryPtr->dataType = type;
 
-        case COAP_POST: // server executes a command on device
-            ProcessAvServerExecRequest(path, payload, payloadLen);
-            break;
+        switch (type)
+        {
+            case LE_AVDATA_DATA_TYPE_INT:
+                entryPtr->value.intValue = value.intValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_FLOAT:
+                entryPtr->value.floatValue = value.floatValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_BOOL:
+                entryPtr->value.boolValue = value.boolValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_STRING:
+                entryPtr->value.strValuePtr = le_mem_ForceAlloc(StringPool);
+                le_utf8_Copy(entryPtr->value.strValuePtr, value.strValuePtr,
+                             LE_AVDATA_STRING_VALUE_BYTES, NULL);
+                break;
+
+            default:
+                break;
+        }
+    }
 
-        default:
-            LE_ERROR("unsupported coap method from an AirVantage server: %d", method);
+    (*numEntriesPtr)++;
 
-            RespondToAvServer(COAP_BAD_REQUEST, NULL, 0);
-    }
+    return LE_OK;
 }
 
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/* Public functions                                                                               */
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 //--------------------------------------------------------------------------------------------------
 /**
- * Registers a handler function to a asset data path when a resource event (read/write/execute)
- * occurs.
+ * Read one path of a composite read and append the result to the snapshot. A parent path is
+ * expanded into one entry per child path readable by the server.
  *
  * @return:
- *      - resource event handler ref - needed to remove the handler
- *      - NULL - invalid asset data path is provided
+ *      - LE_OVERFLOW if the entry array is full.
+ *      - LE_OK if success.
  */
 //--------------------------------------------------------------------------------------------------
-le_avdata_ResourceEventHandlerRef_t le_avdata_AddResourceEventHandler
+static le_result_t ReadCompositePath
 (
-    const char* path,                           ///< [IN] Asset data path
-    le_avdata_ResourceHandlerFunc_t handlerPtr, ///< [IN] Handler function for resource event
-    void* contextPtr                            ///< [IN] context pointer
+    const char* path,               ///< [IN] Requested asset data path
+    avData_ReadEntry_t* entryArr,   ///< [IN] Snapshot entries
+    size_t maxEntries,              ///< [IN] Entry array size
+    size_t* numEntriesPtr           ///< [IN/OUT] Number of entries
 )
 {
-    const char* key;
-    void* handlerRef = NULL;
-    AssetData_t* assetDataPtr = NULL;
-    char pathCopy[LE_AVDATA_PATH_NAME_LEN] = {0};
-    strncpy(pathCopy, path, LE_AVDATA_PATH_NAME_LEN);
-    pathCopy[LE_AVDATA_PATH_NAME_LEN - 1]= '\0';
+    AssetValue_t assetValue;
+    le_avdata_DataType_t type = LE_AVDATA_DATA_TYPE_NONE;
+    size_t pathLen = strnlen(path, LE_AVDATA_PATH_NAME_LEN);
 
-    // Format the path with correct delimiter
-    FormatPath(pathCopy);
+    memset(&assetValue, 0, sizeof(assetValue));
 
-    // Get namespaced path which is namespaced under the application name
-    char namespacedPath[LE_AVDATA_PATH_NAME_BYTES];
-    GetNamespacedPath(pathCopy, namespacedPath, sizeof(namespacedPath));
+    if ((0 == pathLen) || (LE_AVDATA_PATH_NAME_LEN <= pathLen) || (!IsAssetDataPathValid(path)))
+    {
+        LE_ERROR("Invalid path in composite read: %s", path);
+        return AddReadEntry(entryArr, maxEntries, numEntriesPtr, path,
+                            LE_BAD_PARAMETER, type, assetValue);
+    }
 
-    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
+    le_result_t result = GetVal(path, &assetValue, &type, false, true);
 
-    // Add handler to all children under this path
+    if ((LE_NOT_FOUND == result) && IsPathParent(path))
+    {
+        char* pathArray[le_hashmap_Size(AssetDataMap)];
+        int pathArrayIdx = GetReadableChildPaths(path, pathArray);
+        int i;
+
+        for (i = 0; i < pathArrayIdx; i++)
+        {
+            result = GetVal(pathArray[i], &assetValue, &type, false, true);
+
+            if (LE_OK != AddReadEntry(entryArr, maxEntries, numEntriesPtr, pathArray[i],
+                                      result, type, assetValue))
+            {
+                return LE_OVERFLOW;
+            }
+        }
+
+        return LE_OK;
+    }
+
+    return AddReadEntry(entryArr, maxEntries, numEntriesPtr, path, result, type, assetValue);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a per-path read result to the CoAP response code reported to the server.
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_CoapResponseCode_t ConvertReadResultToCoapCode
+(
+    le_result_t result      ///< [IN] Read result
+)
+{
+    switch (result)
+    {
+        case LE_OK:
+            return COAP_CONTENT_AVAILABLE;
+        case LE_NOT_PERMITTED:
+            return COAP_METHOD_UNAUTHORIZED;
+        case LE_NOT_FOUND:
+            return COAP_NOT_FOUND;
+        case LE_BAD_PARAMETER:
+            return COAP_BAD_REQUEST;
+        default:
+            return COAP_INTERNAL_ERROR;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy the asset data path from an item of a composite read request. The item is either a text
+ * string or a SenML record holding the path in its name.
+ *
+ * @return:
+ *      - LE_FAULT on any error.
+ *      - LE_OK if success.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t DecodeCompositePathItem
+(
+    CborValue* itemPtr,     ///< [IN] Request item
+    char* buf,              ///< [OUT] Path buffer
+    size_t bufSize          ///< [IN] Path buffer size
+)
+{
+    size_t strSize = bufSize;
+
+    if (cbor_value_is_text_string(itemPtr))
+    {
+        return CborSafeCopyString(itemPtr, buf, &strSize);
+    }
+
+    if (!cbor_value_is_map(itemPtr))
+    {
+        return LE_FAULT;
+    }
+
+    CborValue map;
+    bool isNameFound = false;
+
+    if (CborNoError != cbor_value_enter_container(itemPtr, &map))
+    {
+        return LE_FAULT;
+    }
+
+    while (!cbor_value_at_end(&map))
+    {
+        int label = -1;
+
+        // Labels which are not integers are skipped with their value.
+        if (cbor_value_is_integer(&map) &&
+            (CborNoError != cbor_value_get_int_checked(&map, &label)))
+        {
+            return LE_FAULT;
+        }
+
+        if ((CborNoError != cbor_value_advance(&map)) || cbor_value_at_end(&map))
+        {
+            return LE_FAULT;
+        }
+
+        if ((SENML_CBOR_LABEL_NAME == label) && cbor_value_is_text_string(&map))
+        {
+            strSize = bufSize;
+            if (LE_OK != CborSafeCopyString(&map, buf, &strSize))
+            {
+                return LE_FAULT;
+            }
+            isNameFound = true;
+        }
+
+        if (CborNoError != cbor_value_advance(&map))
+        {
+            return LE_FAULT;
+        }
+    }
+
+    if (CborNoError != cbor_value_leave_container(itemPtr, &map))
+    {
+        return LE_FAULT;
+    }
+
+    return isNameFound ? LE_OK : LE_FAULT;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the list of paths of a composite read request. The paths are relative to the request
+ * URI. Paths are allocated from the asset path pool and must be released by the caller.
+ *
+ * @return:
+ *      - LE_BAD_PARAMETER if the payload is invalid.
+ *      - LE_OVERFLOW if the request holds too many paths.
+ *      - LE_OK if success.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t DecodeCompositePaths
+(
+    const char* basePath,   ///< [IN] Request URI
+    uint8_t* payload,       ///< [IN] Request payload
+    size_t payloadLen,      ///< [IN] Request payload length
+    char* pathArr[],        ///< [OUT] Requested paths, AVDATA_COMPOSITE_READ_MAX_PATHS entries
+    size_t* numPathsPtr     ///< [OUT] Number of requested paths
+)
+{
+    CborParser parser;
+    CborValue value;
+    CborValue array;
+    le_result_t result = LE_OK;
+    size_t baseLen = strlen(basePath);
+
+    *numPathsPtr = 0;
+
+    // The root URI does not add any prefix to the requested paths.
+    if ((baseLen > 0) && (SLASH_DELIMITER_CHAR == basePath[baseLen - 1]))
+    {
+        baseLen--;
+    }
+
+    if ((CborNoError != cbor_parser_init(payload, payloadLen, 0, &parser, &value)) ||
+        (!cbor_value_is_array(&value)) ||
+        (CborNoError != cbor_value_enter_container(&value, &array)))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    while ((LE_OK == result) && (!cbor_value_at_end(&array)))
+    {
+        char buf[LE_AVDATA_PATH_NAME_BYTES] = {0};
+
+        if (*numPathsPtr >= AVDATA_COMPOSITE_READ_MAX_PATHS)
+        {
+            LE_ERROR("Too many paths in composite read, max %d", AVDATA_COMPOSITE_READ_MAX_PATHS);
+            result = LE_OVERFLOW;
+        }
+        else if ((LE_OK != DecodeCompositePathItem(&array, buf, sizeof(buf))) ||
+                 (SLASH_DELIMITER_CHAR != buf[0]))
+        {
+            result = LE_BAD_PARAMETER;
+        }
+        else
+        {
+            char* pathPtr = le_mem_ForceAlloc(AssetPathPool);
+            pathArr[(*numPathsPtr)++] = pathPtr;
+
+            if (LE_AVDATA_PATH_NAME_BYTES <= snprintf(pathPtr, LE_AVDATA_PATH_NAME_BYTES, "%.*s%s",
+                                                      (int)baseLen, basePath, buf))
+            {
+                LE_ERROR("Composite read path too long: %s", buf);
+                result = LE_BAD_PARAMETER;
+            }
+            else if (CborNoError != cbor_value_advance(&array))
+            {
+                result = LE_BAD_PARAMETER;
+            }
+        }
+    }
+
+    if (LE_OK != result)
+    {
+        while (*numPathsPtr > 0)
+        {
+            le_mem_Release(pathArr[--(*numPathsPtr)]);
+        }
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the SenML representation configured for the read responses.
+ *
+ * @return:
+ *      - true if a SenML representation is configured
+ *      - false otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static bool GetSenmlReadFormat
+(
+    senml_Format_t* formatPtr       ///< [OUT] Configured SenML representation
+)
+{
+    *formatPtr = SenmlReadFormat;
+
+    return IsSenmlRead;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a read snapshot as a SenML pack and send it to the server. Each record holds the path
+ * and either the value or the CoAP error code of this path. The records are factored, so the
+ * common path prefix is only sent once.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RespondSenmlToAvServer
+(
+    avData_ReadEntry_t* entryArr,   ///< [IN] Snapshot entries
+    size_t numEntries,              ///< [IN] Number of entries
+    senml_Format_t format           ///< [IN] SenML representation
+)
+{
+    senml_Record_t* recordArr;
+    uint8_t* bufPtr;
+    size_t len = SENML_READ_BUFFER_BYTES;
+    size_t i;
+    le_result_t result;
+
+    LE_ASSERT(numEntries <= AVDATA_COMPOSITE_READ_MAX_ENTRIES);
+
+    recordArr = le_mem_ForceAlloc(SenmlRecordPool);
+    bufPtr = le_mem_ForceAlloc(SenmlBufferPool);
+    memset(recordArr, 0, sizeof(senml_Record_t) * AVDATA_COMPOSITE_READ_MAX_ENTRIES);
+
+    for (i = 0; i < numEntries; i++)
+    {
+        avData_ReadEntry_t* entryPtr = &entryArr[i];
+        senml_Record_t* recordPtr = &recordArr[i];
+
+        recordPtr->name = entryPtr->path;
+
+        if (LE_OK != entryPtr->result)
+        {
+            recordPtr->errorCode = ConvertReadResultToCoapCode(entryPtr->result);
+            continue;
+        }
+
+        switch (entryPtr->dataType)
+        {
+            case LE_AVDATA_DATA_TYPE_INT:
+                recordPtr->type = SENML_VALUE_INT;
+                recordPtr->value.intValue = entryPtr->value.intValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_FLOAT:
+                recordPtr->type = SENML_VALUE_FLOAT;
+                recordPtr->value.floatValue = entryPtr->value.floatValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_BOOL:
+                recordPtr->type = SENML_VALUE_BOOL;
+                recordPtr->value.boolValue = entryPtr->value.boolValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_STRING:
+                recordPtr->type = SENML_VALUE_STRING;
+                recordPtr->value.strValuePtr = entryPtr->value.strValuePtr;
+                break;
+
+            default:
+                recordPtr->type = SENML_VALUE_NONE;
+                break;
+        }
+    }
+
+    AVServerResponse.contentType = push_GetSenmlContentType(format);
+
+    result = senml_EncodePack(format, recordArr, numEntries, true, bufPtr, &len);
+
+    if (LE_OK == result)
+    {
+        RespondToAvServer(COAP_CONTENT_AVAILABLE, bufPtr, len);
+    }
+    else if (LE_OVERFLOW == result)
+    {
+        LE_DEBUG(">>>>> SenML read response larger than %d bytes.", SENML_READ_BUFFER_BYTES);
+        RespondToAvServer(COAP_ENTITY_TOO_LARGE_CODE, NULL, 0);
+    }
+    else
+    {
+        LE_DEBUG(">>>>> Fail to encode SenML read response.");
+        RespondToAvServer(COAP_INTERNAL_ERROR, NULL, 0);
+    }
+
+    le_mem_Release(bufPtr);
+    le_mem_Release(recordArr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Processes read request from AV server, when a SenML representation is configured. A parent path
+ * is returned as one SenML record per readable child.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ProcessAvServerSenmlReadRequest
+(
+    const char* path,
+    senml_Format_t format
+)
+{
+    LE_DEBUG(">>>>> COAP_GET - Server reads SenML from device");
+
+    const char* const pathArr[] = { path };
+    avData_ReadEntry_t entryArr[AVDATA_COMPOSITE_READ_MAX_ENTRIES];
+    size_t numEntries = NUM_ARRAY_MEMBERS(entryArr);
+
+    le_result_t result = avData_ReadComposite(pathArr, 1, entryArr, &numEntries);
+
+    if (LE_OVERFLOW == result)
+    {
+        LE_DEBUG(">>>>> Too many data points for a SenML read.");
+        RespondToAvServer(COAP_ENTITY_TOO_LARGE_CODE, NULL, 0);
+        return;
+    }
+    else if (LE_OK != result)
+    {
+        RespondToAvServer(COAP_INTERNAL_ERROR, NULL, 0);
+        return;
+    }
+
+    // A single path which cannot be read is reported with the response code, as a legacy read.
+    if ((1 == numEntries) && (LE_OK != entryArr[0].result) && (0 == strcmp(entryArr[0].path, path)))
+    {
+        RespondToAvServer(ConvertReadResultToCoapCode(entryArr[0].result), NULL, 0);
+    }
+    else
+    {
+        RespondSenmlToAvServer(entryArr, numEntries, format);
+    }
+
+    avData_ReleaseComposite(entryArr, numEntries);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Processes composite read request from AV server. All the requested values are read in a single
+ * snapshot and returned in one SenML pack, errors are reported per path. SenML-CBOR is used
+ * unless SenML-JSON is configured.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ProcessAvServerCompositeReadRequest
+(
+    const char* path,
+    uint8_t* payload,
+    size_t payloadLen
+)
+{
+    LE_DEBUG(">>>>> COAP_FETCH - Server reads multiple paths from device");
+
+    char* pathArr[AVDATA_COMPOSITE_READ_MAX_PATHS];
+    size_t numPaths = 0;
+    avData_ReadEntry_t entryArr[AVDATA_COMPOSITE_READ_MAX_ENTRIES];
+    size_t numEntries = NUM_ARRAY_MEMBERS(entryArr);
+    senml_Format_t format;
+    size_t i;
+
+    if (!GetSenmlReadFormat(&format))
+    {
+        format = SENML_FORMAT_CBOR;
+    }
+
+    le_result_t result = DecodeCompositePaths(path, payload, payloadLen, pathArr, &numPaths);
+
+    if (LE_OK == result)
+    {
+        result = avData_ReadComposite((const char* const*)pathArr, numPaths,
+                                      entryArr, &numEntries);
+
+        for (i = 0; i < numPaths; i++)
+        {
+            le_mem_Release(pathArr[i]);
+        }
+    }
+
+    if (LE_OVERFLOW == result)
+    {
+        // Rejected before encoding: too many paths requested, or too many entries to return
+        LE_DEBUG(">>>>> Too many data points for a composite read.");
+        RespondToAvServer(COAP_ENTITY_TOO_LARGE_CODE, NULL, 0);
+        return;
+    }
+    else if (LE_OK != result)
+    {
+        LE_DEBUG(">>>>> Invalid composite read: %s", LE_RESULT_TXT(result));
+        RespondToAvServer(COAP_BAD_REQUEST, NULL, 0);
+        return;
+    }
+
+    RespondSenmlToAvServer(entryArr, numEntries, format);
+
+    avData_ReleaseComposite(entryArr, numEntries);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles requests from an AV server to read, write, or execute on an asset data.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AvServerRequestHandler
+(
+    lwm2mcore_CoapRequest_t* serverReqRef
+)
+{
+    // Save the session context and server request ref, so when reply function such as
+    // le_avdata_ReplyExecResult is called at the end of the command execution,
+    // it can async reply AV server with them.
+    AVCClientSessionInstanceRef = avcClient_GetInstance();
+    if (NULL == AVCClientSessionInstanceRef)
+    {
+        LE_ERROR("Cannot get AVC client session context. Stop processing AV server request.");
+        return;
+    }
+
+    AVServerReqRef = serverReqRef;
+
+    // Extract info from the server request.
+    const char* path = lwm2mcore_GetRequestUri(AVServerReqRef); // cannot have trailing slash.
+    coap_method_t method = lwm2mcore_GetRequestMethod(AVServerReqRef);
+    uint8_t* payload = (uint8_t *)lwm2mcore_GetRequestPayload(AVServerReqRef);
+    size_t payloadLen = lwm2mcore_GetRequestPayloadLength(AVServerReqRef);
+    uint8_t* token = (uint8_t *)lwm2mcore_GetToken(AVServerReqRef);
+    size_t tokenLength = lwm2mcore_GetTokenLength(AVServerReqRef);
+    senml_Format_t senmlFormat;
+
+    // Partially fill in the response.
+    memcpy(AVServerResponse.token, token, tokenLength);
+    AVServerResponse.tokenLength = tokenLength;
+    AVServerResponse.contentType = LWM2MCORE_PUSH_CONTENT_CBOR;
+
+    LE_INFO(">>>>> Request Uri is: [%s]", path);
+
+    // FETCH is not part of coap_method_t, hence the integer switch.
+    switch ((int)method)
+    {
+        case COAP_GET: // server reads from device
+            if (GetSenmlReadFormat(&senmlFormat))
+            {
+                ProcessAvServerSenmlReadRequest(path, senmlFormat);
+            }
+            else
+            {
+                ProcessAvServerReadRequest(path);
+            }
+            break;
+
+        case COAP_FETCH_METHOD: // server reads several paths from device
+            ProcessAvServerCompositeReadRequest(path, payload, payloadLen);
+            break;
+
+        case COAP_PUT: // server writes to device
+            ProcessAvServerWriteRequest(path, payload, payloadLen);
+            break;
+
+        case COAP_POST: // server executes a command on device
+            ProcessAvServerExecRequest(path, payload, payloadLen);
+            break;
+
+        default:
+            LE_ERROR("unsupported coap method from an AirVantage server: %d", method);
+
+            RespondToAvServer(COAP_BAD_REQUEST, NULL, 0);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/* Public functions                                                                               */
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registers a handler function to a asset data path when a resource event (read/write/execute)
+ * occurs.
+ *
+ * @return:
+ *      - resource event handler ref - needed to remove the handler
+ *      - NULL - invalid asset data path is provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_avdata_ResourceEventHandlerRef_t le_avdata_AddResourceEventHandler
+(
+    const char* path,                           ///< [IN] Asset data path
+    le_avdata_ResourceHandlerFunc_t handlerPtr, ///< [IN] Handler function for resource event
+    void* contextPtr                            ///< [IN] context pointer
+)
+{
+    const char* key;
+    void* handlerRef = NULL;
+    AssetData_t* assetDataPtr = NULL;
+    char pathCopy[LE_AVDATA_PATH_NAME_LEN] = {0};
+    strncpy(pathCopy, path, LE_AVDATA_PATH_NAME_LEN);
+    pathCopy[LE_AVDATA_PATH_NAME_LEN - 1]= '\0';
+
+    // Format the path with correct delimiter
+    FormatPath(pathCopy);
+
+    // Get namespaced path which is namespaced under the application name
+    char namespacedPath[LE_AVDATA_PATH_NAME_BYTES];
+    GetNamespacedPath(pathCopy, namespacedPath, sizeof(namespacedPath));
+
+    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
+
+    // Add handler to all children under this path
     while (le_hashmap_NextNode(iter) == LE_OK)
     {
         key = le_hashmap_GetKey(iter);
@@ -2442,6 +3588,7 @@ le_avdata_ResourceEventHandlerRef_t le_avdata_AddResourceEventHandler
         {
             LE_INFO("Registering handler on %s", key);
             assetDataPtr = le_hashmap_GetValue(iter);
+            ClaimResource(assetDataPtr, le_avdata_GetClientSessionRef());
             assetDataPtr->handlerPtr = handlerPtr;
             assetDataPtr->contextPtr = contextPtr;
 
@@ -2525,6 +3672,7 @@ void le_avdata_RemoveResourceEventHandler
  *      - LE_OK on success
  *      - LE_DUPLICATE if path has already been called by CreateResource before, or path is parent
  *        or child to an existing Asset Data path.
+ *      - LE_OUT_OF_RANGE if the application reached its quota of asset data.
  *      - LE_FAULT on any other error.
  */
 //--------------------------------------------------------------------------------------------------
@@ -2552,8 +3700,32 @@ le_result_t le_avdata_CreateResource
     char namespacedPath[LE_AVDATA_PATH_NAME_BYTES];
     GetNamespacedPath(pathCopy, namespacedPath, sizeof(namespacedPath));
 
+    // Claim the resource if it was restored from the resource index for this application
+    AssetData_t* assetDataPtr = GetAssetData(namespacedPath);
+    if ((NULL != assetDataPtr) && ClaimResource(assetDataPtr, le_avdata_GetClientSessionRef()))
+    {
+        if (assetDataPtr->accessMode != accessMode)
+        {
+            le_avdata_AccessType_t serverAccess = LE_AVDATA_ACCESS_READ;
+            le_avdata_AccessType_t clientAccess = LE_AVDATA_ACCESS_READ;
+            if ((ConvertAccessModeToServerAccess(accessMode, &serverAccess) != LE_OK) ||
+                (ConvertAccessModeToClientAccess(accessMode, &clientAccess) != LE_OK))
+            {
+                LE_KILL_CLIENT("Invalid access mode [%d].", accessMode);
+                return LE_FAULT;
+            }
+
+            assetDataPtr->accessMode = accessMode;
+            assetDataPtr->serverAccess = serverAccess;
+            assetDataPtr->clientAccess = clientAccess;
+            ScheduleResourceIndexSave();
+        }
+
+        return LE_OK;
+    }
+
     // Restore setting from config tree.
-    RestoreSetting(namespacedPath);
+    RestoreSetting(namespacedPath, le_avdata_GetClientSessionRef());
 
     return InitResource(namespacedPath, accessMode, le_avdata_GetClientSessionRef());
 }
@@ -2929,6 +4101,10 @@ le_result_t le_avdata_SetString
     iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
 
     le_result_t result = SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_STRING, true, false, iterRef);
+    if (LE_OK != result)
+    {
+        le_mem_Release(assetValue.strValuePtr);
+    }
 
     // Write setting to config tree
     le_cfg_CommitTxn(iterRef);
@@ -3179,34 +4355,241 @@ le_result_t le_avdata_GetStringArgLength
  * execution status.
  */
 //--------------------------------------------------------------------------------------------------
-void le_avdata_ReplyExecResult
+void le_avdata_ReplyExecResult
+(
+    le_avdata_ArgumentListRef_t argListRef,  ///< [IN] Argument list ref.
+    le_result_t result                       ///< [IN] Command execution status.
+)
+{
+    avData_ReplyExecResultPayload(argListRef, result, AVDATA_EXEC_RESULT_CBOR, NULL, 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reply command execution result to AVC Daemon with a payload, which is sent to AV server in the
+ * response: 2.05 Content if the command succeeded, 5.00 Internal Server Error otherwise. The payload
+ * is sent in a single response, and is limited to AVDATA_EXEC_RESULT_MAX_BYTES.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the format or the payload is invalid
+ *      - LE_OVERFLOW if the payload is larger than AVDATA_EXEC_RESULT_MAX_BYTES
+ *      - LE_FORMAT_ERROR if a CBOR payload is not a single well-formed CBOR item
+ *      - LE_NOT_FOUND if no command execution is pending on the argument list, e.g. its deadline
+ *        passed: the reply is ignored
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_ReplyExecResultPayload
+(
+    le_avdata_ArgumentListRef_t argListRef,
+        ///< [IN] Argument list ref.
+
+    le_result_t result,
+        ///< [IN] Command execution status.
+
+    avData_ExecResultFormat_t format,
+        ///< [IN] Payload format
+
+    const uint8_t* payloadPtr,
+        ///< [IN] Payload, NULL if none
+
+    size_t payloadLength
+        ///< [IN] Payload length
+)
+{
+    lwm2mcore_PushContent_t contentType = LWM2MCORE_PUSH_CONTENT_CBOR;
+
+    if ((NULL == payloadPtr) && (0 != payloadLength))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if (payloadLength > AVDATA_EXEC_RESULT_MAX_BYTES)
+    {
+        LE_ERROR("Command execution result too large: %zu bytes", payloadLength);
+        return LE_OVERFLOW;
+    }
+
+    switch (format)
+    {
+        case AVDATA_EXEC_RESULT_CBOR:
+            if (0 != payloadLength)
+            {
+                CborParser parser;
+                CborValue value;
+
+                if ((CborNoError != cbor_parser_init(payloadPtr, payloadLength, 0, &parser,
+                                                     &value)) ||
+                    (CborNoError != cbor_value_advance(&value)) ||
+                    (cbor_value_get_next_byte(&value) != payloadPtr + payloadLength))
+                {
+                    LE_ERROR("Command execution result is not a valid CBOR item");
+                    return LE_FORMAT_ERROR;
+                }
+            }
+            break;
+
+        case AVDATA_EXEC_RESULT_STRING:
+            contentType = PUSH_CONTENT_TEXT_PLAIN;
+            break;
+
+        default:
+            return LE_BAD_PARAMETER;
+    }
+
+    PendingExec_t* execPtr = GetPendingExec(argListRef);
+    if (NULL == execPtr)
+    {
+        LE_WARN("No command execution pending on argument list (%p), result ignored", argListRef);
+        return LE_NOT_FOUND;
+    }
+
+    // Respond to AV server with the command execution result.
+    lwm2mcore_CoapResponseCode_t code = COAP_INTERNAL_ERROR;
+    if (LE_OK == result)
+    {
+        code = (0 != payloadLength) ? COAP_CONTENT_AVAILABLE : COAP_RESOURCE_CHANGED;
+    }
+
+    execPtr->response.contentType = contentType;
+    EndPendingExec(execPtr, code, payloadPtr, payloadLength);
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the deadline of the command executions of an asset data resource, replacing the configured
+ * one. The deadline of a running execution is not changed.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the path is invalid
+ *      - LE_NOT_FOUND if the resource does not exist
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_SetExecTimeout
+(
+    const char* path,
+        ///< [IN] Namespaced asset data path
+
+    uint32_t timeoutMs
+        ///< [IN] Deadline in ms, 0 for the configured one
+)
+{
+    if (NULL == path)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    AssetData_t* assetDataPtr = le_hashmap_Get(AssetDataMap, path);
+
+    if (NULL == assetDataPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    assetDataPtr->execTimeoutMs = timeoutMs;
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push result handler of the client pushes: the push is no longer queued for the client quotas.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PushResultHandler
+(
+    le_avdata_PushStatus_t status,  ///< [IN] Push status
+    void* contextPtr                ///< [IN] Push context
+)
+{
+    PushContext_t* pushCtxPtr = contextPtr;
+
+    quota_Release(pushCtxPtr->quotaRef, QUOTA_QUEUED_PUSHES, 1);
+
+    if (pushCtxPtr->handlerPtr)
+    {
+        pushCtxPtr->handlerPtr(status, pushCtxPtr->contextPtr);
+    }
+
+    // The context is still used by the push request if the result is reported before it returns
+    if (pushCtxPtr->isQueued)
+    {
+        le_mem_Release(pushCtxPtr);
+    }
+    else
+    {
+        pushCtxPtr->isCompleted = true;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a client push request: the push is accounted in the quotas of the client application
+ * until its result is reported to PushResultHandler().
+ *
+ * @return
+ *      - Push context, to be given to PushResultHandler() and EndPushRequest()
+ *      - NULL if the application has too many pushes queued
+ */
+//--------------------------------------------------------------------------------------------------
+static PushContext_t* StartPushRequest
+(
+    le_avdata_CallbackResultFunc_t handlerPtr, ///< [IN] Client push result callback
+    void* contextPtr                           ///< [IN] Client context
+)
+{
+    quota_AppRef_t quotaRef = GetCurrentClientQuota();
+    PushContext_t* pushCtxPtr;
+
+    if (LE_OK != quota_Reserve(quotaRef, QUOTA_QUEUED_PUSHES, 1))
+    {
+        LE_ERROR("Push exceeds the queued push quota of the application.");
+        return NULL;
+    }
+
+    pushCtxPtr = le_mem_ForceAlloc(PushContextPoolRef);
+    memset(pushCtxPtr, 0, sizeof(PushContext_t));
+    pushCtxPtr->quotaRef = quotaRef;
+    pushCtxPtr->handlerPtr = handlerPtr;
+    pushCtxPtr->contextPtr = contextPtr;
+
+    return pushCtxPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End a client push request. The push stays accounted if it is queued, otherwise the quota and the
+ * push context are released.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EndPushRequest
 (
-    le_avdata_ArgumentListRef_t argListRef,  ///< [IN] Argument list ref.
-    le_result_t result                       ///< [IN] Command execution status.
+    PushContext_t* pushCtxPtr,  ///< [IN] Push context
+    le_result_t result          ///< [IN] Result of the push request
 )
 {
-    // Clean up the argument list and safe ref.
-    Argument_t* argPtr = NULL;
-    le_dls_List_t* argListPtr = le_ref_Lookup(ArgListRefMap, argListRef);
-    if (NULL == argListPtr)
+    if (pushCtxPtr->isCompleted)
     {
-        LE_ERROR("Invalid argument list (%p) provided!", argListRef);
+        le_mem_Release(pushCtxPtr);
         return;
     }
 
-    le_dls_Link_t* argLinkPtr = le_dls_Pop(argListPtr);
-
-    while (argLinkPtr != NULL)
+    if ((LE_OK == result) || (LE_BUSY == result))
     {
-        argPtr = CONTAINER_OF(argLinkPtr, Argument_t, link);
-        le_mem_Release(argPtr);
-        argLinkPtr = le_dls_Pop(argListPtr);
+        pushCtxPtr->isQueued = true;
+        return;
     }
 
-    le_ref_DeleteRef(ArgListRefMap, argListRef);
-
-    // Respond to AV server with the command execution result.
-    RespondToAvServer((result == LE_OK) ? COAP_RESOURCE_CHANGED : COAP_INTERNAL_ERROR, NULL, 0);
+    // The push was not queued and its result will never be reported
+    quota_Release(pushCtxPtr->quotaRef, QUOTA_QUEUED_PUSHES, 1);
+    le_mem_Release(pushCtxPtr);
 }
 
 
@@ -3220,6 +4603,7 @@ void le_avdata_ReplyExecResult
  *      - LE_BUSY if push service is busy. Data added to queue list for later push
  *      - LE_OVERFLOW if data size exceeds the maximum allowed size
  *      - LE_NO_MEMORY if push queue is full, try again later
+ *      - LE_OUT_OF_RANGE if the application reached its quota of queued pushes
  *      - LE_FAULT on any other error
  */
 //--------------------------------------------------------------------------------------------------
@@ -3304,11 +4688,19 @@ le_result_t le_avdata_Push
     if (result == LE_OK)
     {
         LE_DUMP(buf, cbor_encoder_get_buffer_size(&rootNode, buf));
+
+        PushContext_t* pushCtxPtr = StartPushRequest(handlerPtr, contextPtr);
+        if (NULL == pushCtxPtr)
+        {
+            return QUOTA_EXCEEDED;
+        }
+
         result = PushBuffer(buf,
                             cbor_encoder_get_buffer_size(&rootNode, buf),
                             LWM2MCORE_PUSH_CONTENT_CBOR,
-                            handlerPtr,
-                            contextPtr);
+                            PushResultHandler,
+                            pushCtxPtr);
+        EndPushRequest(pushCtxPtr, result);
     }
     else
     {
@@ -3329,6 +4721,7 @@ le_result_t le_avdata_Push
  *      - LE_BUSY if push service is busy. Data added to queue list for later push
  *      - LE_OVERFLOW if data size exceeds the maximum allowed size
  *      - LE_NO_MEMORY if push queue is full, try again later
+ *      - LE_OUT_OF_RANGE if the application reached its quota of queued pushes
  *      - LE_FAULT on any other error
  */
 //--------------------------------------------------------------------------------------------------
@@ -3392,11 +4785,18 @@ le_result_t le_avdata_PushStream
     cbor_encoder_close_container(&encoder, &mapEncoder);
     LE_DUMP(encodedBuf, cbor_encoder_get_buffer_size(&encoder, encodedBuf));
 
+    PushContext_t* pushCtxPtr = StartPushRequest(handlerPtr, contextPtr);
+    if (NULL == pushCtxPtr)
+    {
+        return QUOTA_EXCEEDED;
+    }
+
     le_result_t res = PushBuffer(encodedBuf,
                                 cbor_encoder_get_buffer_size(&encoder, encodedBuf),
                                 LWM2MCORE_PUSH_CONTENT_CBOR,
-                                handlerPtr,
-                                contextPtr);
+                                PushResultHandler,
+                                pushCtxPtr);
+    EndPushRequest(pushCtxPtr, res);
 
     return res;
 }
@@ -3404,10 +4804,10 @@ le_result_t le_avdata_PushStream
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the real record ref from the safe ref
+ * Get the record ref data from the safe ref
  */
 //--------------------------------------------------------------------------------------------------
-le_avdata_RecordRef_t GetRecRefFromSafeRef
+static RecordRefData_t* GetRecRefDataFromSafeRef
 (
     void* safeRef,
     const char* funcNamePtr
@@ -3421,7 +4821,93 @@ le_avdata_RecordRef_t GetRecRefFromSafeRef
         return NULL;
     }
 
-    return recRefDataPtr->recRef;
+    return recRefDataPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the real record ref from the safe ref
+ */
+//--------------------------------------------------------------------------------------------------
+le_avdata_RecordRef_t GetRecRefFromSafeRef
+(
+    void* safeRef,
+    const char* funcNamePtr
+)
+{
+    RecordRefData_t* recRefDataPtr = GetRecRefDataFromSafeRef(safeRef, funcNamePtr);
+
+    return (recRefDataPtr) ? recRefDataPtr->recRef : NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Limit the size of a record to the record bytes the client application can still use
+ *
+ * @return
+ *      - Size limit of the record, SIZE_MAX if not limited
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t LimitRecordSize
+(
+    RecordRefData_t* recRefDataPtr      ///< [IN] Record ref data
+)
+{
+    uint64_t available = quota_GetAvailable(recRefDataPtr->quotaRef, QUOTA_RECORD_BYTES);
+    size_t maxSize = SIZE_MAX;
+
+    if ((QUOTA_UNLIMITED != available) && (available < (SIZE_MAX - recRefDataPtr->chargedBytes)))
+    {
+        maxSize = recRefDataPtr->chargedBytes + available;
+    }
+
+    timeSeries_SetSizeLimit(recRefDataPtr->recRef, maxSize);
+
+    return maxSize;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Account the size of the data accumulated in a record in the quotas of the client application
+ *
+ * @return
+ *      - LE_OUT_OF_RANGE if the record is full because of the quota
+ *      - Result of the record operation otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t UpdateRecordUsage
+(
+    RecordRefData_t* recRefDataPtr,     ///< [IN] Record ref data
+    size_t maxSize,                     ///< [IN] Size limit of the record during the operation
+    le_result_t result                  ///< [IN] Result of the record operation
+)
+{
+    size_t size = timeSeries_GetEncodedSize(recRefDataPtr->recRef);
+
+    if (size > recRefDataPtr->chargedBytes)
+    {
+        quota_Charge(recRefDataPtr->quotaRef, QUOTA_RECORD_BYTES,
+                     size - recRefDataPtr->chargedBytes);
+    }
+    else
+    {
+        quota_Release(recRefDataPtr->quotaRef, QUOTA_RECORD_BYTES,
+                      recRefDataPtr->chargedBytes - size);
+    }
+    recRefDataPtr->chargedBytes = size;
+
+    // The record buffer is full before the quota if the quota allows more than its size
+    if ((LE_NO_MEMORY == result) && (maxSize < MAX_CBOR_BUFFER_NUMBYTES))
+    {
+        LE_ERROR("Record exceeds the record quota of the application.");
+        quota_CountRejected(recRefDataPtr->quotaRef, QUOTA_RECORD_BYTES);
+        return QUOTA_EXCEEDED;
+    }
+
+    return result;
 }
 
 
@@ -3448,6 +4934,8 @@ le_avdata_RecordRef_t le_avdata_CreateRecord
 
     recRefDataPtr->clientSessionRef = le_avdata_GetClientSessionRef();
     recRefDataPtr->recRef = recRef;
+    recRefDataPtr->quotaRef = GetCurrentClientQuota();
+    recRefDataPtr->chargedBytes = 0;
 
     return le_ref_CreateRef(RecordRefMap, recRefDataPtr);
 }
@@ -3485,6 +4973,7 @@ void le_avdata_DeleteRecord
 
         if ( recRefDataPtr->recRef == recordRef )
         {
+            quota_Release(recRefDataPtr->quotaRef, QUOTA_RECORD_BYTES, recRefDataPtr->chargedBytes);
             le_mem_Release((void*)recRefDataPtr);
             le_ref_DeleteRef(RecordRefMap, (void*)le_ref_GetSafeRef(iterRef));
             break;
@@ -3502,6 +4991,7 @@ void le_avdata_DeleteRecord
  * @return:
  *      - LE_OK on success
  *      - LE_NO_MEMORY if record is full
+ *      - LE_OUT_OF_RANGE if the application reached its quota of record data
  *      - LE_FAULT on any other error
  */
 //--------------------------------------------------------------------------------------------------
@@ -3521,18 +5011,20 @@ le_result_t le_avdata_RecordInt
 )
 {
     le_result_t result;
+    size_t maxSize;
 
     // Map safeRef to desired data
-    recordRef = GetRecRefFromSafeRef(recordRef, __func__);
+    RecordRefData_t* recRefDataPtr = GetRecRefDataFromSafeRef(recordRef, __func__);
 
-    if (recordRef == NULL)
+    if (recRefDataPtr == NULL)
     {
         return LE_FAULT;
     }
 
-    result = timeSeries_AddInt(recordRef, path, value, timestamp);
+    maxSize = LimitRecordSize(recRefDataPtr);
+    result = timeSeries_AddInt(recRefDataPtr->recRef, path, value, timestamp);
 
-    return result;
+    return UpdateRecordUsage(recRefDataPtr, maxSize, result);
 }
 
 
@@ -3545,6 +5037,7 @@ le_result_t le_avdata_RecordInt
  * @return:
  *      - LE_OK on success
  *      - LE_NO_MEMORY if record is full
+ *      - LE_OUT_OF_RANGE if the application reached its quota of record data
  *      - LE_FAULT on any other error
  */
 //--------------------------------------------------------------------------------------------------
@@ -3564,34 +5057,251 @@ le_result_t le_avdata_RecordFloat
 )
 {
     le_result_t result;
+    size_t maxSize;
 
     // Map safeRef to desired data
-    recordRef = GetRecRefFromSafeRef(recordRef, __func__);
+    RecordRefData_t* recRefDataPtr = GetRecRefDataFromSafeRef(recordRef, __func__);
+
+    if (recRefDataPtr == NULL)
+    {
+        return LE_FAULT;
+    }
+
+    maxSize = LimitRecordSize(recRefDataPtr);
+    result = timeSeries_AddFloat(recRefDataPtr->recRef, path, value, timestamp);
+
+    return UpdateRecordUsage(recRefDataPtr, maxSize, result);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Accumulate boolean data
+ *
+ * @note The client will be terminated if the recordRef is not valid, or the resource doesn't exist
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if record is full
+ *      - LE_OUT_OF_RANGE if the application reached its quota of record data
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_avdata_RecordBool
+(
+    le_avdata_RecordRef_t recordRef,
+        ///< [IN]
+
+    const char* path,
+        ///< [IN]
+
+    bool value,
+        ///< [IN]
+
+    uint64_t timestamp
+        ///< [IN]
+)
+{
+    le_result_t result;
+    size_t maxSize;
+
+    // Map safeRef to desired data
+    RecordRefData_t* recRefDataPtr = GetRecRefDataFromSafeRef(recordRef, __func__);
+
+    if (recRefDataPtr == NULL)
+    {
+        return LE_FAULT;
+    }
 
-    if (recordRef == NULL)
+    maxSize = LimitRecordSize(recRefDataPtr);
+    result = timeSeries_AddBool(recRefDataPtr->recRef, path, value, timestamp);
+
+    return UpdateRecordUsage(recRefDataPtr, maxSize, result);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Accumulate string data
+ *
+ * @note The client will be terminated if the recordRef is not valid, or the resource doesn't exist
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if record is full
+ *      - LE_OUT_OF_RANGE if the application reached its quota of record data
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_avdata_RecordString
+(
+    le_avdata_RecordRef_t recordRef,
+        ///< [IN]
+
+    const char* path,
+        ///< [IN]
+
+    const char* value,
+        ///< [IN]
+
+    uint64_t timestamp
+        ///< [IN]
+)
+{
+    le_result_t result;
+    size_t maxSize;
+
+    // Map safeRef to desired data
+    RecordRefData_t* recRefDataPtr = GetRecRefDataFromSafeRef(recordRef, __func__);
+
+    if (recRefDataPtr == NULL)
+    {
+        return LE_FAULT;
+    }
+
+    maxSize = LimitRecordSize(recRefDataPtr);
+    result = timeSeries_AddString(recRefDataPtr->recRef, path, value, timestamp);
+
+    return UpdateRecordUsage(recRefDataPtr, maxSize, result);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push record to the server
+ *
+* @return:
+ *      - LE_OK on success
+ *      - LE_BUSY if push service is busy. Data added to queue list for later push
+ *      - LE_OVERFLOW if data size exceeds the maximum allowed size
+ *      - LE_NO_MEMORY if push queue is full, try again later
+ *      - LE_OUT_OF_RANGE if the application reached its quota of queued pushes
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_avdata_PushRecord
+(
+    le_avdata_RecordRef_t recordRef,
+        ///< [IN]
+
+    le_avdata_CallbackResultFunc_t handlerPtr,
+        ///< [IN]
+
+    void* contextPtr
+        ///< [IN]
+)
+{
+    le_result_t result;
+
+    // Map safeRef to desired data
+    RecordRefData_t* recRefDataPtr = GetRecRefDataFromSafeRef(recordRef, __func__);
+
+    if (recRefDataPtr == NULL)
     {
         return LE_FAULT;
     }
 
-    result = timeSeries_AddFloat(recordRef, path, value, timestamp);
-
-    return result;
+    PushContext_t* pushCtxPtr = StartPushRequest(handlerPtr, contextPtr);
+    if (NULL == pushCtxPtr)
+    {
+        return QUOTA_EXCEEDED;
+    }
+
+    // The windows flushed by the push must not be rejected: the record is emptied by the push
+    timeSeries_SetSizeLimit(recRefDataPtr->recRef, SIZE_MAX);
+    result = timeSeries_PushRecord(recRefDataPtr->recRef, PushResultHandler, pushCtxPtr);
+    EndPushRequest(pushCtxPtr, result);
+
+    return UpdateRecordUsage(recRefDataPtr, SIZE_MAX, result);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the encoding used to push a timeseries record
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the record reference or the format is invalid
+ *      - LE_NO_MEMORY if the accumulated data does not fit in this encoding, the format is unchanged
+ *      - LE_OUT_OF_RANGE if the data in this encoding exceeds the record quota of the application,
+ *        the format is unchanged
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_SetRecordFormat
+(
+    le_avdata_RecordRef_t recordRef,
+        ///< [IN]
+
+    timeSeries_Format_t format
+        ///< [IN]
+)
+{
+    RecordRefData_t* recRefDataPtr = le_ref_Lookup(RecordRefMap, recordRef);
+
+    if (recRefDataPtr == NULL)
+    {
+        LE_ERROR("Invalid record reference %p", recordRef);
+        return LE_BAD_PARAMETER;
+    }
+
+    size_t maxSize = LimitRecordSize(recRefDataPtr);
+    le_result_t result = timeSeries_SetFormat(recRefDataPtr->recRef, format);
+
+    return UpdateRecordUsage(recRefDataPtr, maxSize, result);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregate the samples of a resource of a timeseries record over windows, or stop aggregating it
+ * if the configuration is NULL
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the record reference or the configuration is invalid
+ *      - LE_OVERFLOW if the path is too long for the aggregated resource names
+ *      - LE_NOT_FOUND if no aggregation is configured on the path and the configuration is NULL
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_SetRecordAggregation
+(
+    le_avdata_RecordRef_t recordRef,
+        ///< [IN]
+
+    const char* path,
+        ///< [IN]
+
+    const aggregation_Config_t* configPtr
+        ///< [IN]
+)
+{
+    RecordRefData_t* recRefDataPtr = le_ref_Lookup(RecordRefMap, recordRef);
+
+    if (recRefDataPtr == NULL)
+    {
+        LE_ERROR("Invalid record reference %p", recordRef);
+        return LE_BAD_PARAMETER;
+    }
+
+    return timeSeries_SetAggregation(recRefDataPtr->recRef, path, configPtr);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Accumulate boolean data
- *
- * @note The client will be terminated if the recordRef is not valid, or the resource doesn't exist
+ * Filter the samples of a resource of a timeseries record with deadbands, change-only mode and
+ * heartbeat, or record all of them again if the filter is NULL
  *
  * @return:
  *      - LE_OK on success
- *      - LE_NO_MEMORY if record is full
- *      - LE_FAULT on any other error
+ *      - LE_BAD_PARAMETER if the record reference or the filter is invalid
+ *      - LE_OVERFLOW if the path is too long
+ *      - LE_NOT_FOUND if no filter is set on the path and the filter is NULL
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_avdata_RecordBool
+le_result_t avData_SetRecordFilter
 (
     le_avdata_RecordRef_t recordRef,
         ///< [IN]
@@ -3599,42 +5309,34 @@ le_result_t le_avdata_RecordBool
     const char* path,
         ///< [IN]
 
-    bool value,
-        ///< [IN]
-
-    uint64_t timestamp
+    const timeSeries_Filter_t* filterPtr
         ///< [IN]
 )
 {
-    le_result_t result;
-
-    // Map safeRef to desired data
-    recordRef = GetRecRefFromSafeRef(recordRef, __func__);
+    RecordRefData_t* recRefDataPtr = le_ref_Lookup(RecordRefMap, recordRef);
 
-    if (recordRef == NULL)
+    if (recRefDataPtr == NULL)
     {
-        return LE_FAULT;
+        LE_ERROR("Invalid record reference %p", recordRef);
+        return LE_BAD_PARAMETER;
     }
 
-    result = timeSeries_AddBool(recordRef, path, value, timestamp);
-
-    return result;
+    return timeSeries_SetFilter(recRefDataPtr->recRef, path, filterPtr);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Accumulate string data
- *
- * @note The client will be terminated if the recordRef is not valid, or the resource doesn't exist
+ * Create an iterator over the samples accumulated in a timeseries record, to read them back
+ * locally without pushing them
  *
  * @return:
  *      - LE_OK on success
- *      - LE_NO_MEMORY if record is full
- *      - LE_FAULT on any other error
+ *      - LE_BAD_PARAMETER if the record reference or the time range is invalid
+ *      - LE_OVERFLOW if the path is too long
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_avdata_RecordString
+le_result_t avData_CreateRecordIterator
 (
     le_avdata_RecordRef_t recordRef,
         ///< [IN]
@@ -3642,66 +5344,61 @@ le_result_t le_avdata_RecordString
     const char* path,
         ///< [IN]
 
-    const char* value,
+    uint64_t startTime,
         ///< [IN]
 
-    uint64_t timestamp
+    uint64_t endTime,
         ///< [IN]
+
+    timeSeries_IteratorRef_t* iterRefPtr
+        ///< [OUT]
 )
 {
-    le_result_t result;
-
-    // Map safeRef to desired data
-    recordRef = GetRecRefFromSafeRef(recordRef, __func__);
+    RecordRefData_t* recRefDataPtr = le_ref_Lookup(RecordRefMap, recordRef);
 
-    if (recordRef == NULL)
+    if (recRefDataPtr == NULL)
     {
-        return LE_FAULT;
+        LE_ERROR("Invalid record reference %p", recordRef);
+        return LE_BAD_PARAMETER;
     }
 
-    result = timeSeries_AddString(recordRef, path, value, timestamp);
-
-    return result;
+    return timeSeries_CreateIterator(recRefDataPtr->recRef, path, startTime, endTime, iterRefPtr);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Push record to the server
+ * Drop the samples of a timeseries record older than a watermark without pushing them, and release
+ * their size from the record quota of the application
  *
-* @return:
+ * @return:
  *      - LE_OK on success
- *      - LE_BUSY if push service is busy. Data added to queue list for later push
- *      - LE_OVERFLOW if data size exceeds the maximum allowed size
- *      - LE_NO_MEMORY if push queue is full, try again later
- *      - LE_FAULT on any other error
+ *      - LE_BAD_PARAMETER if the record reference is invalid
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t le_avdata_PushRecord
+le_result_t avData_DropRecordSamples
 (
     le_avdata_RecordRef_t recordRef,
         ///< [IN]
 
-    le_avdata_CallbackResultFunc_t handlerPtr,
+    uint64_t watermark,
         ///< [IN]
 
-    void* contextPtr
-        ///< [IN]
+    size_t* numDroppedPtr
+        ///< [OUT]
 )
 {
-    le_result_t result;
-
-    // Map safeRef to desired data
-    recordRef = GetRecRefFromSafeRef(recordRef, __func__);
+    RecordRefData_t* recRefDataPtr = le_ref_Lookup(RecordRefMap, recordRef);
 
-    if (recordRef == NULL)
+    if (recRefDataPtr == NULL)
     {
-        return LE_FAULT;
+        LE_ERROR("Invalid record reference %p", recordRef);
+        return LE_BAD_PARAMETER;
     }
 
-    result = timeSeries_PushRecord(recordRef, handlerPtr, contextPtr);
+    *numDroppedPtr = timeSeries_DropSamples(recRefDataPtr->recRef, watermark);
 
-    return result;
+    return UpdateRecordUsage(recRefDataPtr, SIZE_MAX, LE_OK);
 }
 
 
@@ -3860,6 +5557,319 @@ void le_avdata_ReleaseSession
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read several asset data paths with server access in a single snapshot.
+ *
+ * Every requested path produces one entry with its own result, except parent paths which are
+ * expanded into one entry per readable child. The entries are filled in request order.
+ *
+ * @return:
+ *      - LE_OK on success, per-path errors are reported in the entries
+ *      - LE_BAD_PARAMETER if a parameter is invalid
+ *      - LE_OVERFLOW if the entry array is too small, no entry is returned
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_ReadComposite
+(
+    const char* const pathArr[],        ///< [IN] Requested asset data paths
+    size_t numPaths,                    ///< [IN] Number of requested paths
+    avData_ReadEntry_t* entryArr,       ///< [OUT] Snapshot entries
+    size_t* numEntriesPtr               ///< [IN/OUT] Entry array size / number of entries
+)
+{
+    if ((NULL == pathArr) || (NULL == entryArr) || (NULL == numEntriesPtr))
+    {
+        LE_ERROR("Null pointer provided");
+        return LE_BAD_PARAMETER;
+    }
+
+    size_t maxEntries = *numEntriesPtr;
+    size_t i;
+
+    *numEntriesPtr = 0;
+
+    // All the values are read in one pass from the main thread, before anything is encoded. No
+    // client update can be processed in between, so the entries form a consistent snapshot.
+    for (i = 0; i < numPaths; i++)
+    {
+        if ((NULL == pathArr[i]) ||
+            (LE_OK != ReadCompositePath(pathArr[i], entryArr, maxEntries, numEntriesPtr)))
+        {
+            LE_ERROR("Composite read of %zu paths failed after %zu entries", numPaths,
+                     *numEntriesPtr);
+            avData_ReleaseComposite(entryArr, *numEntriesPtr);
+            *numEntriesPtr = 0;
+            return (NULL == pathArr[i]) ? LE_BAD_PARAMETER : LE_OVERFLOW;
+        }
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the memory held by the entries of a composite read snapshot.
+ */
+//--------------------------------------------------------------------------------------------------
+void avData_ReleaseComposite
+(
+    avData_ReadEntry_t* entryArr,       ///< [IN] Snapshot entries
+    size_t numEntries                   ///< [IN] Number of entries
+)
+{
+    size_t i;
+
+    if (NULL == entryArr)
+    {
+        return;
+    }
+
+    for (i = 0; i < numEntries; i++)
+    {
+        if ((LE_OK == entryArr[i].result) &&
+            (LE_AVDATA_DATA_TYPE_STRING == entryArr[i].dataType) &&
+            (NULL != entryArr[i].value.strValuePtr))
+        {
+            le_mem_Release(entryArr[i].value.strValuePtr);
+        }
+
+        if (NULL != entryArr[i].path)
+        {
+            le_mem_Release(entryArr[i].path);
+        }
+
+        memset(&entryArr[i], 0, sizeof(avData_ReadEntry_t));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the next resource definition to save in the resource index
+ *
+ * @return
+ *      - true if the entry is filled, false if there is no more resource
+ */
+//--------------------------------------------------------------------------------------------------
+static bool NextResourceIndexEntry
+(
+    resourceIndex_Entry_t* entryPtr,    ///< [OUT] Resource definition
+    void* contextPtr                    ///< [IN] Asset data map iterator
+)
+{
+    le_hashmap_It_Ref_t iter = contextPtr;
+
+    while (LE_OK == le_hashmap_NextNode(iter))
+    {
+        const AssetData_t* assetDataPtr = le_hashmap_GetValue(iter);
+
+        // The resources restored lazily by a server access have no known owner
+        if ('\0' == assetDataPtr->ownerApp[0])
+        {
+            continue;
+        }
+
+        memset(entryPtr, 0, sizeof(resourceIndex_Entry_t));
+        LE_ASSERT(LE_OK == le_utf8_Copy(entryPtr->path, le_hashmap_GetKey(iter),
+                                        sizeof(entryPtr->path), NULL));
+        LE_ASSERT(LE_OK == le_utf8_Copy(entryPtr->appName, assetDataPtr->ownerApp,
+                                        sizeof(entryPtr->appName), NULL));
+        entryPtr->accessMode = assetDataPtr->accessMode;
+        entryPtr->namespace = assetDataPtr->namespace;
+        return true;
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore a resource definition read from the resource index. The resource waits for its owning
+ * application to claim it.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RestoreIndexEntry
+(
+    const resourceIndex_Entry_t* entryPtr,  ///< [IN] Resource definition
+    void* contextPtr                        ///< [IN] Unused
+)
+{
+    AssetData_t* assetDataPtr;
+
+    // The settings are restored with their value from the config tree
+    if (LE_AVDATA_ACCESS_SETTING == entryPtr->accessMode)
+    {
+        RestoreSetting(entryPtr->path, NULL);
+    }
+
+    if ((NULL == le_hashmap_Get(AssetDataMap, entryPtr->path)) &&
+        (LE_OK != InitResource(entryPtr->path, entryPtr->accessMode, NULL)))
+    {
+        LE_WARN("Resource %s of %s not restored", entryPtr->path, entryPtr->appName);
+        return;
+    }
+
+    assetDataPtr = le_hashmap_Get(AssetDataMap, entryPtr->path);
+    assetDataPtr->namespace = entryPtr->namespace;
+    LE_ASSERT(LE_OK == le_utf8_Copy(assetDataPtr->ownerApp, entryPtr->appName,
+                                    sizeof(assetDataPtr->ownerApp), NULL));
+    assetDataPtr->isPendingOwner = true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the resource index when the timer expires
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResourceIndexTimerHandler
+(
+    le_timer_Ref_t timerRef     ///< [IN] Timer
+)
+{
+    avData_SaveResourceIndex();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the resource index after a delay, to group the changes of the asset data tree.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScheduleResourceIndexSave
+(
+    void
+)
+{
+    // The tree restored at initialization is already in the index
+    if ((NULL != ResourceIndexTimerRef) && (!le_timer_IsRunning(ResourceIndexTimerRef)))
+    {
+        le_timer_Start(ResourceIndexTimerRef);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the definitions of the asset data resources in the resource index now
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_OVERFLOW if there are too many resources to index
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_SaveResourceIndex
+(
+    void
+)
+{
+    if ((NULL != ResourceIndexTimerRef) && (le_timer_IsRunning(ResourceIndexTimerRef)))
+    {
+        le_timer_Stop(ResourceIndexTimerRef);
+    }
+
+    return resourceIndex_Save(NextResourceIndexEntry, le_hashmap_GetIterator(AssetDataMap));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the owning application of an asset data resource
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if a parameter is invalid
+ *      - LE_NOT_FOUND if the resource does not exist
+ *      - LE_OVERFLOW if the application name does not fit in the buffer
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_GetResourceOwner
+(
+    const char* path,
+        ///< [IN] Namespaced asset data path
+
+    char* appNamePtr,
+        ///< [OUT] Owning application, empty if unknown
+
+    size_t appNameSize,
+        ///< [IN] Size of the application name buffer
+
+    bool* isPendingPtr
+        ///< [OUT] Restored from the resource index and not claimed yet by its application
+)
+{
+    if ((NULL == path) || (NULL == appNamePtr) || (NULL == isPendingPtr))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    AssetData_t* assetDataPtr = le_hashmap_Get(AssetDataMap, path);
+
+    if (NULL == assetDataPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    *isPendingPtr = assetDataPtr->isPendingOwner;
+    return le_utf8_Copy(appNamePtr, assetDataPtr->ownerApp, appNameSize, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete the asset data resources of an application which are waiting for it to claim them, and
+ * remove them from the resource index.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the application name is invalid
+ *      - LE_NOT_FOUND if the application has no pending resource
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_DeleteAppResources
+(
+    const char* appNamePtr
+        ///< [IN] Owning application
+)
+{
+    if ((NULL == appNamePtr) || ('\0' == appNamePtr[0]))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    bool isDeleted = false;
+    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
+
+    while (LE_OK == le_hashmap_NextNode(iter))
+    {
+        char* assetPathPtr = (char*)le_hashmap_GetKey(iter);
+        AssetData_t* assetDataPtr = le_hashmap_GetValue(iter);
+
+        // A resource owned by a running client is released when its session closes
+        if ((!assetDataPtr->isPendingOwner) || (0 != strcmp(assetDataPtr->ownerApp, appNamePtr)))
+        {
+            continue;
+        }
+
+        LE_DEBUG("Deleting asset data %s of %s", assetPathPtr, appNamePtr);
+        DeleteAssetData(assetPathPtr, assetDataPtr);
+        isDeleted = true;
+    }
+
+    if (!isDeleted)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    ScheduleResourceIndexSave();
+    return LE_OK;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialize the avData module
@@ -3878,6 +5888,39 @@ void avData_Init
     ArgumentPool = le_mem_CreatePool("AssetData Argument_t", sizeof(Argument_t));
     RecordRefDataPoolRef = le_mem_CreatePool("Record ref data pool", sizeof(RecordRefData_t));
     AssetDataHandlerPool = le_mem_CreatePool("AssetData Handlers", LE_AVDATA_PATH_NAME_BYTES);
+    PushContextPoolRef = le_mem_CreatePool("Push context pool", sizeof(PushContext_t));
+    PendingExecPool = le_mem_CreatePool("AssetData pending exec", sizeof(PendingExec_t));
+    SenmlBufferPool = le_mem_CreatePool("AssetData SenML buffer", SENML_READ_BUFFER_BYTES);
+    SenmlRecordPool = le_mem_CreatePool("AssetData SenML records",
+                                        sizeof(senml_Record_t) * AVDATA_COMPOSITE_READ_MAX_ENTRIES);
+
+    // Read the default deadline of the command executions
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(CFG_AVC_SERVICE_PATH);
+    int32_t execTimeout = le_cfg_GetInt(iterRef, "execTimeout", DEFAULT_EXEC_TIMEOUT);
+    char readFormat[CFG_READ_FORMAT_BYTES] = {0};
+
+    // Read the SenML representation of the read responses
+    if (LE_OK == le_cfg_GetString(iterRef, CFG_READ_FORMAT, readFormat, sizeof(readFormat), ""))
+    {
+        if (0 == strcmp(readFormat, CFG_READ_FORMAT_SENML_CBOR))
+        {
+            IsSenmlRead = true;
+            SenmlReadFormat = SENML_FORMAT_CBOR;
+        }
+        else if (0 == strcmp(readFormat, CFG_READ_FORMAT_SENML_JSON))
+        {
+            IsSenmlRead = true;
+            SenmlReadFormat = SENML_FORMAT_JSON;
+        }
+    }
+    le_cfg_CancelTxn(iterRef);
+    DefaultExecTimeoutMs = (execTimeout > 0) ? (uint32_t)execTimeout * 1000 : 0;
+
+    // Initialize the per-application quotas
+    quota_Init();
+
+    // Initialize the local change streams
+    changeStream_Init();
 
     // Initialize the asset data client list
     AssetDataClientList = LE_DLS_LIST_INIT;
@@ -3886,9 +5929,8 @@ void avData_Init
     AssetDataMap = le_hashmap_Create("Asset Data Map", MAX_EXPECTED_ASSETDATA,
                                      le_hashmap_HashString, le_hashmap_EqualsString);
 
-    // The argument list is used once at the command handler execution, so the map is really holding
-    // one object at a time. Therefore the map size isn't expected to be big - techinically 1 is
-    // enough.
+    // The argument list is used once at the command handler execution, and held until the command
+    // result is replied or its deadline passes. Few commands are expected to execute at a time.
     ArgListRefMap = le_ref_CreateMap("Argument List Ref Map", 1);
 
     // Create map to store the resource event handler.
@@ -3908,4 +5950,15 @@ void avData_Init
     // Create safe reference map for session request references. The size of the map should be based
     // on the expected number of simultaneous requests for session. 5 of them seems reasonable.
     AvSessionRequestRefMap = le_ref_CreateMap("AVSessionRequestRef", 5);
+
+    // Restore the resources defined before a restart, until their applications reconnect
+    le_result_t result = resourceIndex_Load(RestoreIndexEntry, NULL);
+    if ((LE_OK != result) && (LE_NOT_FOUND != result))
+    {
+        LE_WARN("Resource index not restored: %s", LE_RESULT_TXT(result));
+    }
+
+    ResourceIndexTimerRef = le_timer_Create("Resource index timer");
+    le_timer_SetInterval(ResourceIndexTimerRef, (le_clk_Time_t){RESOURCE_INDEX_SAVE_DELAY, 0});
+    le_timer_SetHandler(ResourceIndexTimerRef, ResourceIndexTimerHandler);
 }
@@ -13,11 +13,69 @@
 #define LEGATO_AVDATA_INCLUDE_GUARD
 
 #include "legato.h"
+#include "timeseriesData.h"
 
 //--------------------------------------------------------------------------------------------------
 // Definitions.
 //--------------------------------------------------------------------------------------------------
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of paths accepted in a composite read request from the server
+ */
+//--------------------------------------------------------------------------------------------------
+#define AVDATA_COMPOSITE_READ_MAX_PATHS     64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of entries returned by a composite read, once parent paths are expanded
+ */
+//--------------------------------------------------------------------------------------------------
+#define AVDATA_COMPOSITE_READ_MAX_ENTRIES   256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Entry of a composite read snapshot.
+ *
+ * The path and string value are owned by the snapshot and released by avData_ReleaseComposite().
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char*                path;          ///< Asset data path
+    le_result_t          result;        ///< Read result: LE_OK, LE_NOT_FOUND, LE_NOT_PERMITTED or
+                                        ///< LE_BAD_PARAMETER
+    le_avdata_DataType_t dataType;      ///< Data type of the value, valid if result is LE_OK
+    union
+    {
+        int    intValue;
+        double floatValue;
+        bool   boolValue;
+        char*  strValuePtr;
+    }
+    value;                              ///< Asset value, valid if result is LE_OK
+}
+avData_ReadEntry_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size in bytes of a command execution result payload
+ */
+//--------------------------------------------------------------------------------------------------
+#define AVDATA_EXEC_RESULT_MAX_BYTES        4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format of a command execution result payload
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    AVDATA_EXEC_RESULT_CBOR = 0,        ///< Single CBOR item
+    AVDATA_EXEC_RESULT_STRING           ///< UTF-8 string, sent as text/plain
+}
+avData_ExecResultFormat_t;
+
 
 //--------------------------------------------------------------------------------------------------
 // Interface functions
@@ -44,4 +102,242 @@ LE_SHARED void avData_ReportSessionState
     le_avdata_SessionState_t sessionState
 );
 
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read several asset data paths with server access in a single snapshot.
+ *
+ * Every requested path produces one entry with its own result, except parent paths which are
+ * expanded into one entry per readable child. The entries are filled in request order.
+ *
+ * @return:
+ *      - LE_OK on success, per-path errors are reported in the entries
+ *      - LE_BAD_PARAMETER if a parameter is invalid
+ *      - LE_OVERFLOW if the entry array is too small, no entry is returned
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_ReadComposite
+(
+    const char* const pathArr[],        ///< [IN] Requested asset data paths
+    size_t numPaths,                    ///< [IN] Number of requested paths
+    avData_ReadEntry_t* entryArr,       ///< [OUT] Snapshot entries
+    size_t* numEntriesPtr               ///< [IN/OUT] Entry array size / number of entries
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the memory held by the entries of a composite read snapshot.
+ */
+//--------------------------------------------------------------------------------------------------
+void avData_ReleaseComposite
+(
+    avData_ReadEntry_t* entryArr,       ///< [IN] Snapshot entries
+    size_t numEntries                   ///< [IN] Number of entries
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the encoding used to push a timeseries record, e.g. SenML instead of the default
+ * compressed CBOR layout.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the record reference or the format is invalid
+ *      - LE_NO_MEMORY if the accumulated data does not fit in this encoding, the format is unchanged
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_SetRecordFormat
+(
+    le_avdata_RecordRef_t recordRef,    ///< [IN] Record reference
+    timeSeries_Format_t format          ///< [IN] Push encoding
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregate the samples of a resource of a timeseries record over fixed or sliding windows: one
+ * entry per window and statistic is pushed instead of every sample. A NULL configuration stops the
+ * aggregation.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the record reference or the configuration is invalid
+ *      - LE_OVERFLOW if the path is too long for the aggregated resource names
+ *      - LE_NOT_FOUND if no aggregation is configured on the path and the configuration is NULL
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_SetRecordAggregation
+(
+    le_avdata_RecordRef_t recordRef,        ///< [IN] Record reference
+    const char* path,                       ///< [IN] Resource path
+    const aggregation_Config_t* configPtr   ///< [IN] Window configuration, NULL to stop
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Drop the samples of a resource of a timeseries record that do not differ enough from the last
+ * recorded one: absolute or percentage deadband, change-only mode for boolean and string values,
+ * and heartbeat forcing a sample from time to time. A NULL filter records all the samples again.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the record reference or the filter is invalid
+ *      - LE_OVERFLOW if the path is too long
+ *      - LE_NOT_FOUND if no filter is set on the path and the filter is NULL
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_SetRecordFilter
+(
+    le_avdata_RecordRef_t recordRef,        ///< [IN] Record reference
+    const char* path,                       ///< [IN] Resource path
+    const timeSeries_Filter_t* filterPtr    ///< [IN] Filter, NULL to record all the samples
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create an iterator over the samples accumulated in a timeseries record, to read them back
+ * locally without pushing them. The samples are filtered by resource and time range, and read with
+ * the timeSeries_NextSample() and timeSeries_GetSample*() accessors straight from the record,
+ * without encoding. The iterator is deleted with timeSeries_DeleteIterator().
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the record reference or the time range is invalid
+ *      - LE_OVERFLOW if the path is too long
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_CreateRecordIterator
+(
+    le_avdata_RecordRef_t recordRef,        ///< [IN] Record reference
+    const char* path,                       ///< [IN] Resource, or parent of the resources, to
+                                            ///<      iterate on. NULL for all the resources.
+    uint64_t startTime,                     ///< [IN] Timestamp of the first samples
+    uint64_t endTime,                       ///< [IN] Timestamp of the last samples, UINT64_MAX
+                                            ///<      for all
+    timeSeries_IteratorRef_t* iterRefPtr    ///< [OUT] Iterator
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Drop the samples of a timeseries record older than a watermark without pushing them, e.g. once
+ * they were consumed locally.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the record reference is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avData_DropRecordSamples
+(
+    le_avdata_RecordRef_t recordRef,        ///< [IN] Record reference
+    uint64_t watermark,                     ///< [IN] Samples with an earlier timestamp are dropped
+    size_t* numDroppedPtr                   ///< [OUT] Number of dropped samples
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the definitions of the asset data resources in the resource index now, instead of after
+ * the delay following a change of the asset data tree.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_OVERFLOW if there are too many resources to index
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t avData_SaveResourceIndex
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the owning application of an asset data resource. A resource restored from the resource
+ * index after a restart, or whose application closed its client session, is pending until its
+ * application creates it again or registers a handler on it.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if a parameter is invalid
+ *      - LE_NOT_FOUND if the resource does not exist
+ *      - LE_OVERFLOW if the application name does not fit in the buffer
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t avData_GetResourceOwner
+(
+    const char* path,                       ///< [IN] Namespaced asset data path
+    char* appNamePtr,                       ///< [OUT] Owning application, empty if unknown
+    size_t appNameSize,                     ///< [IN] Size of the application name buffer
+    bool* isPendingPtr                      ///< [OUT] Waiting for its application to claim it
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete the asset data resources of an application, and remove them from the resource index.
+ * The resources of an application stay in the tree when its client session closes: only the
+ * resources waiting for the application to claim them are deleted.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the application name is invalid
+ *      - LE_NOT_FOUND if the application has no pending resource
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t avData_DeleteAppResources
+(
+    const char* appNamePtr                  ///< [IN] Owning application
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reply command execution result with a payload, sent to the server in the response. This is the
+ * variant of le_avdata_ReplyExecResult() for commands returning data.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the format or the payload is invalid
+ *      - LE_OVERFLOW if the payload is larger than AVDATA_EXEC_RESULT_MAX_BYTES
+ *      - LE_FORMAT_ERROR if a CBOR payload is not a single well-formed CBOR item
+ *      - LE_NOT_FOUND if no command execution is pending on the argument list, e.g. its deadline
+ *        passed: the reply is ignored
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t avData_ReplyExecResultPayload
+(
+    le_avdata_ArgumentListRef_t argListRef, ///< [IN] Argument list reference
+    le_result_t result,                     ///< [IN] Command execution status
+    avData_ExecResultFormat_t format,       ///< [IN] Payload format
+    const uint8_t* payloadPtr,              ///< [IN] Payload, NULL if none
+    size_t payloadLength                    ///< [IN] Payload length
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the deadline of the command executions of an asset data resource, replacing the one
+ * configured in /apps/avcService/execTimeout. When the deadline passes, the server is answered with
+ * 5.04 Gateway Timeout and the late reply of the command result is ignored.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the path is invalid
+ *      - LE_NOT_FOUND if the resource does not exist
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t avData_SetExecTimeout
+(
+    const char* path,                       ///< [IN] Namespaced asset data path
+    uint32_t timeoutMs                      ///< [IN] Deadline in ms, 0 for the configured one
+);
+
 #endif // LEGATO_AVDATA_INCLUDE_GUARD
@@ -9,6 +9,9 @@
 #include <interfaces.h>
 #include <lwm2mcore/lwm2mcore.h>
 #include <lwm2mcore/udp.h>
+#include "avcComm.h"
+#include "downloadShaper.h"
+#include "trafficAccounting.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -50,6 +53,14 @@ static le_event_Id_t CommEventId = NULL;
 //--------------------------------------------------------------------------------------------------
 static le_data_ConnectionStateHandlerRef_t  DataHandlerRef = NULL;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Data connection state handler reference used to follow the bearer for the download shaper and
+ * the traffic accounting
+ */
+//--------------------------------------------------------------------------------------------------
+static le_data_ConnectionStateHandlerRef_t  BearerHandlerRef = NULL;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Data interface name
@@ -192,6 +203,40 @@ static void DataHandler
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Data connection state handler used to update the bearer class of the download shaper and the
+ * bearer interface of the traffic accounting
+ */
+//--------------------------------------------------------------------------------------------------
+static void BearerHandler
+(
+    const char  *ifNamePtr,
+    bool        isConnected,
+    void        *ctxPtr
+)
+{
+    if (!isConnected)
+    {
+        return;
+    }
+
+    trafficAccounting_SetBearerInterface(ifNamePtr);
+
+    switch (le_data_GetTechnology())
+    {
+        case LE_DATA_CELLULAR:
+            downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_CELLULAR);
+            break;
+        case LE_DATA_WIFI:
+            downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_WIFI);
+            break;
+        default:
+            downloadShaper_SetBearer(DOWNLOADSHAPER_BEARER_OTHER);
+            break;
+    }
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * The first-layer communication errors handler
@@ -303,3 +348,19 @@ void le_avc_RemoveCommInfoHandler
         le_event_RemoveHandler((le_event_HandlerRef_t)ref);
     }
 }
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the communication module: follow the data connection bearer
+ */
+//--------------------------------------------------------------------------------------------------
+void avcComm_Init
+(
+    void
+)
+{
+    if (NULL == BearerHandlerRef)
+    {
+        BearerHandlerRef = le_data_AddConnectionStateHandler(BearerHandler, NULL);
+    }
+}
@@ -0,0 +1,31 @@
+/**
+ * @file avcComm.h
+ *
+ * Interface for the communication information sub-component
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_AVCCOMM_INCLUDE_GUARD
+#define LEGATO_AVCCOMM_INCLUDE_GUARD
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+// Interface functions
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the communication module: follow the data connection bearer
+ */
+//--------------------------------------------------------------------------------------------------
+void avcComm_Init
+(
+    void
+);
+
+#endif // LEGATO_AVCCOMM_INCLUDE_GUARD
@@ -33,6 +33,13 @@
 //--------------------------------------------------------------------------------------------------
 #define SSLCERT_PATH                        PKGDWL_LEFS_DIR "/" "cert"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Traffic accounting totals path
+ */
+//--------------------------------------------------------------------------------------------------
+#define TRAFFIC_ACCOUNTING_FILENAME         PKGDWL_LEFS_DIR "/" "traffic"
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Firmware update information directory
@@ -117,6 +124,13 @@
 //--------------------------------------------------------------------------------------------------
 #define SW_UPDATE_RESULT_PATH               SW_UPDATE_INFO_DIR "/" "updateResult"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Software update transaction journal path
+ */
+//--------------------------------------------------------------------------------------------------
+#define SW_UPDATE_TRANSACTION_PATH          SW_UPDATE_INFO_DIR "/" "transaction"
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Package downloader update information directory
@@ -145,6 +159,27 @@
 //--------------------------------------------------------------------------------------------------
 #define UPDATE_TYPE_FILENAME                UPDATE_INFO_DIR "/" "updateType"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download shaper configuration path
+ */
+//--------------------------------------------------------------------------------------------------
+#define DOWNLOAD_SHAPER_CONFIG_FILENAME     UPDATE_INFO_DIR "/" "shaperConfig"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download budget usage path
+ */
+//--------------------------------------------------------------------------------------------------
+#define DOWNLOAD_BUDGET_USAGE_FILENAME      UPDATE_INFO_DIR "/" "budgetUsage"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Package mirror configuration path
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGE_MIRROR_CONFIG_FILENAME      UPDATE_INFO_DIR "/" "mirrorConfig"
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Name of the avc configuration file
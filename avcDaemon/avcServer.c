@@ -18,15 +18,22 @@
 #include "avcServer.h"
 #include "avData.h"
 #include "push.h"
+#include "avcComm.h"
+#include "trafficAccounting.h"
 #include "fsSys.h"
 #include "le_print.h"
 #include "avcAppUpdate.h"
 #include "packageDownloader.h"
 #include "packageDownloaderCallbacks.h"
+#include "packagePush.h"
+#include "packageLocal.h"
+#include "packageMirror.h"
+#include "downloadShaper.h"
 #include "avcFsConfig.h"
 #include "watchdogChain.h"
 #include "timeseriesData.h"
 #include "avcClient.h"
+#include "healthCheck.h"
 
 //--------------------------------------------------------------------------------------------------
 // Definitions
@@ -39,6 +46,27 @@
 //--------------------------------------------------------------------------------------------------
 #define AVC_SERVICE_CFG "/apps/avcService"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download shaper configuration path, see downloadShaper.h
+ */
+//--------------------------------------------------------------------------------------------------
+#define DOWNLOAD_SHAPER_CFG AVC_SERVICE_CFG "/downloadShaper"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Package mirror configuration path, see packageMirror.h
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGE_MIRROR_CFG AVC_SERVICE_CFG "/packageMirrors"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Local package configuration path, see packageLocal.h
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGE_LOCAL_CFG AVC_SERVICE_CFG "/packageLocal"
+
 //--------------------------------------------------------------------------------------------------
 /**
  * AVC configuration file
@@ -164,7 +192,8 @@ typedef enum
     AVC_REBOOT_PENDING,         ///< Received pending reboot; no response sent yet
     AVC_REBOOT_IN_PROGRESS,     ///< Accepted reboot, and in progress
     AVC_CONNECTION_PENDING,     ///< Received pending connection; no response sent yet
-    AVC_CONNECTION_IN_PROGRESS  ///< Accepted connection, and in progress
+    AVC_CONNECTION_IN_PROGRESS, ///< Accepted connection, and in progress
+    AVC_DOWNLOAD_HELD           ///< Download suspended until the metered-data budget allows it
 }
 AvcState_t;
 
@@ -539,6 +568,22 @@ static bool IsUserSession = false;
 // ------------------------------------------------------------------------------------------------
 static bool IsPkgReadyToInstall = false;
 
+// -------------------------------------------------------------------------------------------------
+/**
+ * Are the SOTA operations of a device management session applied as one transaction?
+ * Read from the config tree @ /apps/avcService/sotaTransaction, see avcApp_BeginTransaction().
+ */
+// ------------------------------------------------------------------------------------------------
+static bool IsSotaTransactionEnabled = false;
+
+// -------------------------------------------------------------------------------------------------
+/**
+ * Is the current firmware update started from the config tree? It is installed once downloaded,
+ * without waiting for the server.
+ */
+// ------------------------------------------------------------------------------------------------
+static bool IsLocalFwUpdate = false;
+
 //--------------------------------------------------------------------------------------------------
 // Local functions
 //--------------------------------------------------------------------------------------------------
@@ -612,6 +657,7 @@ static char* ConvertAvcStateToString
         case AVC_REBOOT_IN_PROGRESS:        result = "Reboot in progress";      break;
         case AVC_CONNECTION_PENDING:        result = "Connection pending";      break;
         case AVC_CONNECTION_IN_PROGRESS:    result = "Connection in progress";  break;
+        case AVC_DOWNLOAD_HELD:             result = "Download held for budget"; break;
         default:                            result = "Unknown";                 break;
 
     }
@@ -839,6 +885,221 @@ static void ReadUserAgreementConfiguration
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the download shaper configuration from the config tree. The configuration stored by the
+ * download shaper is kept if the config tree does not have a download shaper node.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadDownloadShaperConfiguration
+(
+    void
+)
+{
+    static const char* bearerNodes[DOWNLOADSHAPER_BEARER_MAX] = { "cellular", "wifi", "other" };
+    downloadShaper_Config_t config;
+    char nodePath[LE_CFG_STR_LEN_BYTES];
+    int32_t value;
+    int bearer;
+
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(DOWNLOAD_SHAPER_CFG);
+
+    if (!le_cfg_NodeExists(iterRef, ""))
+    {
+        le_cfg_CancelTxn(iterRef);
+        return;
+    }
+
+    memset(&config, 0, sizeof(config));
+
+    for (bearer = 0; bearer < DOWNLOADSHAPER_BEARER_MAX; bearer++)
+    {
+        snprintf(nodePath, sizeof(nodePath), "%s/rateLimit", bearerNodes[bearer]);
+        value = le_cfg_GetInt(iterRef, nodePath, 0);
+        config.rateLimit[bearer] = (value > 0) ? (uint32_t)value : 0;
+
+        // Only the cellular bearer is metered by default
+        snprintf(nodePath, sizeof(nodePath), "%s/metered", bearerNodes[bearer]);
+        config.isMetered[bearer] = le_cfg_GetBool(iterRef, nodePath,
+                                                  (DOWNLOADSHAPER_BEARER_CELLULAR == bearer));
+    }
+
+    // The budgets are configured in kilobytes to fit in the config tree integers
+    value = le_cfg_GetInt(iterRef, "dailyBudgetKB", 0);
+    config.dailyBudget = (value > 0) ? ((uint64_t)value * 1024) : 0;
+    value = le_cfg_GetInt(iterRef, "monthlyBudgetKB", 0);
+    config.monthlyBudget = (value > 0) ? ((uint64_t)value * 1024) : 0;
+
+    le_cfg_CancelTxn(iterRef);
+
+    LE_INFO("Download shaper: rate limits %"PRIu32"/%"PRIu32"/%"PRIu32" B/s, "
+            "budgets %"PRIu64"/%"PRIu64" bytes",
+            config.rateLimit[DOWNLOADSHAPER_BEARER_CELLULAR],
+            config.rateLimit[DOWNLOADSHAPER_BEARER_WIFI],
+            config.rateLimit[DOWNLOADSHAPER_BEARER_OTHER],
+            config.dailyBudget, config.monthlyBudget);
+
+    if (LE_OK != downloadShaper_SetConfig(&config))
+    {
+        LE_ERROR("Failed to set the download shaper configuration");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called when the download shaper configuration changes in the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+static void DownloadShaperConfigHandler
+(
+    void* contextPtr
+)
+{
+    ReadDownloadShaperConfiguration();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the package mirror configuration from the config tree. The configuration stored by the
+ * package mirrors is kept if the config tree does not have a package mirror node.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadPackageMirrorConfiguration
+(
+    void
+)
+{
+    packageMirror_Config_t config;
+    char nodePath[LE_CFG_STR_LEN_BYTES];
+    int32_t value;
+    int mirror;
+
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(PACKAGE_MIRROR_CFG);
+
+    if (!le_cfg_NodeExists(iterRef, ""))
+    {
+        le_cfg_CancelTxn(iterRef);
+        return;
+    }
+
+    memset(&config, 0, sizeof(config));
+
+    for (mirror = 0; mirror < PACKAGEMIRROR_MAX_MIRRORS; mirror++)
+    {
+        snprintf(nodePath, sizeof(nodePath), "baseUri/%d", mirror);
+        if (LE_OK != le_cfg_GetString(iterRef, nodePath, config.baseUri[mirror],
+                                      sizeof(config.baseUri[mirror]), ""))
+        {
+            LE_ERROR("Package mirror %d too long, not used", mirror);
+            config.baseUri[mirror][0] = '\0';
+        }
+    }
+
+    value = le_cfg_GetInt(iterRef, "rangeSize", PACKAGEMIRROR_DEFAULT_RANGE_SIZE);
+    config.rangeSize = (value > 0) ? (uint32_t)value : 0;
+    value = le_cfg_GetInt(iterRef, "lowThroughput", PACKAGEMIRROR_DEFAULT_LOW_THROUGHPUT);
+    config.lowThroughput = (value > 0) ? (uint32_t)value : 0;
+
+    le_cfg_CancelTxn(iterRef);
+
+    LE_INFO("Package mirrors: ranges of %"PRIu32" bytes, low throughput %"PRIu32" B/s",
+            config.rangeSize, config.lowThroughput);
+
+    if (LE_OK != packageMirror_SetConfig(&config))
+    {
+        LE_ERROR("Failed to set the package mirror configuration");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called when the package mirror configuration changes in the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+static void PackageMirrorConfigHandler
+(
+    void* contextPtr
+)
+{
+    ReadPackageMirrorConfiguration();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the local package configuration from the config tree. A firmware URI starts the update as
+ * if it was written by the server, and is removed so that the update is started only once.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadPackageLocalConfiguration
+(
+    void
+)
+{
+    char allowedDir[PATH_MAX] = {0};
+    char uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES] = {0};
+    le_result_t result;
+
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(PACKAGE_LOCAL_CFG);
+
+    if (!le_cfg_NodeExists(iterRef, ""))
+    {
+        le_cfg_CancelTxn(iterRef);
+        packageLocal_SetAllowedDir(PACKAGELOCAL_DEFAULT_DIR);
+        return;
+    }
+
+    if (   (LE_OK != le_cfg_GetString(iterRef, "allowedDir", allowedDir, sizeof(allowedDir),
+                                      PACKAGELOCAL_DEFAULT_DIR))
+        || (LE_OK != packageLocal_SetAllowedDir(allowedDir)))
+    {
+        LE_ERROR("Invalid local package directory, using %s", PACKAGELOCAL_DEFAULT_DIR);
+        packageLocal_SetAllowedDir(PACKAGELOCAL_DEFAULT_DIR);
+    }
+
+    result = le_cfg_GetString(iterRef, "firmwareUri", uri, sizeof(uri), "");
+    le_cfg_CancelTxn(iterRef);
+
+    if ((LE_OK == result) && ('\0' == uri[0]))
+    {
+        return;
+    }
+
+    // Removing the node calls this handler again, with no firmware URI
+    iterRef = le_cfg_CreateWriteTxn(PACKAGE_LOCAL_CFG);
+    le_cfg_DeleteNode(iterRef, "firmwareUri");
+    le_cfg_CommitTxn(iterRef);
+
+    if ((LE_OK != result) || (!packageLocal_IsLocalUri(uri)))
+    {
+        LE_ERROR("Invalid local firmware package URI");
+        return;
+    }
+
+    LE_INFO("Local firmware update from %s", uri);
+
+    if (LWM2MCORE_ERR_COMPLETED_OK != lwm2mcore_SetUpdatePackageUri(LWM2MCORE_FW_UPDATE_TYPE, 0,
+                                                                    uri, strlen(uri)))
+    {
+        LE_ERROR("Failed to start the local firmware update");
+        return;
+    }
+
+    IsLocalFwUpdate = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called when the local package configuration changes in the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+static void PackageLocalConfigHandler
+(
+    void* contextPtr
+)
+{
+    ReadPackageLocalConfiguration();
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Accept the currently pending download.
@@ -1565,6 +1826,18 @@ static void ProcessUpdateStatus
                 // End download and start unpack
                 avcApp_EndDownload();
             }
+
+            // A local firmware update is installed as if the server requested it, the user
+            // agreement still applies
+            if ((LE_AVC_FIRMWARE_UPDATE == data->updateType) && (IsLocalFwUpdate))
+            {
+                IsLocalFwUpdate = false;
+                if (LWM2MCORE_ERR_COMPLETED_OK != lwm2mcore_LaunchUpdate(LWM2MCORE_FW_UPDATE_TYPE,
+                                                                         0, NULL, 0))
+                {
+                    LE_ERROR("Failed to install the local firmware update");
+                }
+            }
             break;
 
         case LE_AVC_INSTALL_PENDING:
@@ -1601,6 +1874,10 @@ static void ProcessUpdateStatus
             {
                 avcApp_DeletePackage();
             }
+            else if (LE_AVC_FIRMWARE_UPDATE == data->updateType)
+            {
+                IsLocalFwUpdate = false;
+            }
 
             avcClient_StartActivityTimer();
             AvcErrorCode = data->errorCode;
@@ -1623,10 +1900,19 @@ static void ProcessUpdateStatus
 
         case LE_AVC_SESSION_STARTED:
             avcClient_StartActivityTimer();
+            // A registration is one of the probes of the post-install health check
+            healthCheck_ReportRegistration();
             // Update object9 list managed by legato to lwm2mcore
             avcApp_NotifyObj9List();
             avData_ReportSessionState(LE_AVDATA_SESSION_STARTED);
 
+            // The SOTA operations of the session are staged until the session ends. A
+            // transaction postponed by a previous session is still open.
+            if (IsSotaTransactionEnabled)
+            {
+                LE_WARN_IF(LE_FAULT == avcApp_BeginTransaction(), "Failed to open transaction");
+            }
+
             // Push items waiting in queue
             push_Retry();
             break;
@@ -1643,6 +1929,14 @@ static void ProcessUpdateStatus
                 StartInstall();
             }
 
+            // Apply the SOTA operations staged during the session. The transaction stays open
+            // while a package is being downloaded or the system is in probation, and is committed
+            // at the end of a later session.
+            if ((IsSotaTransactionEnabled) && (LE_BUSY == avcApp_CommitTransaction()))
+            {
+                LE_INFO("SOTA transaction postponed");
+            }
+
             break;
 
         case LE_AVC_SESSION_FAILED:
@@ -1713,6 +2007,31 @@ void avcServer_UpdateStatus
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report that a package download is held because the metered-data budget is exhausted, or that
+ * it resumes
+ */
+//--------------------------------------------------------------------------------------------------
+void avcServer_ReportDownloadHold
+(
+    bool isHeld,                    ///< [IN] The download is held, or resumes
+    lwm2mcore_UpdateType_t type     ///< [IN] Update type
+)
+{
+    if (isHeld)
+    {
+        LE_INFO("Download held until the metered-data budget allows it");
+        CurrentState = AVC_DOWNLOAD_HELD;
+        CurrentUpdateType = ConvertToAvcType(type);
+    }
+    else if (AVC_DOWNLOAD_HELD == CurrentState)
+    {
+        LE_INFO("Held download resumes");
+        CurrentState = AVC_DOWNLOAD_IN_PROGRESS;
+    }
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Handler for client session closes for clients that use the block/unblock API.
@@ -2167,10 +2486,85 @@ static void InitPollingTimer
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the firmware update state and result at the end of an install, and notify the applications.
+ *
+ * @return
+ *      - LE_OK     The function succeeded
+ *      - LE_FAULT  An error occurred
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t EndFwInstall
+(
+   lwm2mcore_FwUpdateResult_t fwUpdateResult,    ///< New firmware update result
+   le_avc_Status_t            updateStatus,      ///< Status notified to the applications
+   le_avc_ErrorCode_t         errorCode,         ///< Error code notified to the applications
+   le_avc_StatusHandlerFunc_t statusHandlerPtr,  ///< Pointer on handler function
+   void*                      contextPtr         ///< Context
+)
+{
+    // Set the update state to IDLE in all cases
+    if (DWL_OK != packageDownloader_SetFwUpdateState(LWM2MCORE_FW_UPDATE_STATE_IDLE))
+    {
+        LE_ERROR("Error while setting FW update state");
+        return LE_FAULT;
+    }
+
+    avcServer_UpdateStatus(updateStatus,
+                           LE_AVC_FIRMWARE_UPDATE,
+                           -1,
+                           -1,
+                           errorCode,
+                           statusHandlerPtr,
+                           contextPtr
+                          );
+    packageDownloader_SetFwUpdateNotification(true, updateStatus, errorCode);
+    LE_DEBUG("Set FW update result to %d", fwUpdateResult);
+    if (DWL_OK != packageDownloader_SetFwUpdateResult(fwUpdateResult))
+    {
+        LE_ERROR("Error while setting FW update result");
+        return LE_FAULT;
+    }
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called with the result of the health check of a new firmware. On failure, the result is stored
+ * before the rollback restarts the framework.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FwHealthCheckHandler
+(
+    le_result_t result,             ///< [IN] Result of the health check
+    bool isRollingBack,             ///< [IN] Whether the last good system is being restored
+    void* contextPtr                ///< [IN] Context
+)
+{
+    if (LE_OK == result)
+    {
+        EndFwInstall(LWM2MCORE_FW_UPDATE_RESULT_INSTALLED_SUCCESSFUL,
+                     LE_AVC_INSTALL_COMPLETE, LE_AVC_ERR_NONE, NULL, NULL);
+    }
+    else
+    {
+        LE_ERROR("New firmware failed its health check");
+        EndFwInstall(LWM2MCORE_FW_UPDATE_RESULT_INSTALL_FAILURE,
+                     LE_AVC_INSTALL_FAILED, LE_AVC_ERR_INTERNAL, NULL, NULL);
+    }
+
+    if (!isRollingBack)
+    {
+        avcServer_QueryConnection(LE_AVC_FIRMWARE_UPDATE, NULL, NULL);
+    }
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * In case a firmware was installed, check the install result and update the firmware update state
- * and result accordingly.
+ * and result accordingly. A successful install is only reported once the new firmware passed its
+ * health check.
  *
  * @return
  *      - LE_OK     The function succeeded
@@ -2186,6 +2580,12 @@ static le_result_t CheckFwInstallResult
     lwm2mcore_FwUpdateState_t fwUpdateState = LWM2MCORE_FW_UPDATE_STATE_IDLE;
     lwm2mcore_FwUpdateResult_t fwUpdateResult = LWM2MCORE_FW_UPDATE_RESULT_DEFAULT_NORMAL;
 
+    // The result is reported at the end of the health check
+    if (healthCheck_IsRunning())
+    {
+        return LE_OK;
+    }
+
     // Check if a FW update was ongoing
     if (   (LE_OK == packageDownloader_GetFwUpdateState(&fwUpdateState))
         && (LE_OK == packageDownloader_GetFwUpdateResult(&fwUpdateResult))
@@ -2195,10 +2595,7 @@ static le_result_t CheckFwInstallResult
     {
         // Retrieve FW update result
         le_fwupdate_UpdateStatus_t fwUpdateStatus;
-        lwm2mcore_FwUpdateResult_t newFwUpdateResult;
         char statusStr[LE_FWUPDATE_STATUS_LABEL_LENGTH_MAX];
-        le_avc_ErrorCode_t errorCode;
-        le_avc_Status_t updateStatus;
 
         if (LE_OK != le_fwupdate_GetUpdateStatus(&fwUpdateStatus, statusStr, sizeof(statusStr)))
         {
@@ -2208,48 +2605,35 @@ static le_result_t CheckFwInstallResult
 
         LE_DEBUG("Update status: %s (%d)", statusStr, fwUpdateStatus);
 
-        // Set the update state to IDLE in all cases
-        if (DWL_OK != packageDownloader_SetFwUpdateState(LWM2MCORE_FW_UPDATE_STATE_IDLE))
-        {
-            LE_ERROR("Error while setting FW update state");
-            return LE_FAULT;
-        }
-
         // Set the update result according to the FW update status
         if (LE_FWUPDATE_UPDATE_STATUS_OK == fwUpdateStatus)
         {
-            newFwUpdateResult = LWM2MCORE_FW_UPDATE_RESULT_INSTALLED_SUCCESSFUL;
-            updateStatus = LE_AVC_INSTALL_COMPLETE;
-            errorCode = LE_AVC_ERR_NONE;
-        }
-        else
-        {
-            newFwUpdateResult = LWM2MCORE_FW_UPDATE_RESULT_INSTALL_FAILURE;
-            updateStatus = LE_AVC_INSTALL_FAILED;
-            if (LE_FWUPDATE_UPDATE_STATUS_PARTITION_ERROR == fwUpdateStatus)
-            {
-                errorCode = LE_AVC_ERR_BAD_PACKAGE;
-            }
-            else
+            // The new firmware needs to register to the server to pass its health check
+            if (LE_OK == healthCheck_Start(HEALTH_CHECK_FIRMWARE, NULL, 0,
+                                           FwHealthCheckHandler, NULL))
             {
-                errorCode = LE_AVC_ERR_INTERNAL;
+                if (healthCheck_IsRunning())
+                {
+                    avcServer_QueryConnection(LE_AVC_FIRMWARE_UPDATE, statusHandlerPtr, contextPtr);
+                }
+                return LE_OK;
             }
+
+            return EndFwInstall(LWM2MCORE_FW_UPDATE_RESULT_INSTALLED_SUCCESSFUL,
+                                LE_AVC_INSTALL_COMPLETE, LE_AVC_ERR_NONE,
+                                statusHandlerPtr, contextPtr);
         }
-        avcServer_UpdateStatus(updateStatus,
-                               LE_AVC_FIRMWARE_UPDATE,
-                               -1,
-                               -1,
-                               errorCode,
-                               statusHandlerPtr,
-                               contextPtr
-                              );
-        packageDownloader_SetFwUpdateNotification(true, updateStatus, errorCode);
-        LE_DEBUG("Set FW update result to %d", newFwUpdateResult);
-        if (DWL_OK != packageDownloader_SetFwUpdateResult(newFwUpdateResult))
+
+        if (LE_FWUPDATE_UPDATE_STATUS_PARTITION_ERROR == fwUpdateStatus)
         {
-            LE_ERROR("Error while setting FW update result");
-            return LE_FAULT;
+            return EndFwInstall(LWM2MCORE_FW_UPDATE_RESULT_INSTALL_FAILURE,
+                                LE_AVC_INSTALL_FAILED, LE_AVC_ERR_BAD_PACKAGE,
+                                statusHandlerPtr, contextPtr);
         }
+
+        return EndFwInstall(LWM2MCORE_FW_UPDATE_RESULT_INSTALL_FAILURE,
+                            LE_AVC_INSTALL_FAILED, LE_AVC_ERR_INTERNAL,
+                            statusHandlerPtr, contextPtr);
     }
     return LE_OK;
 }
@@ -2360,6 +2744,13 @@ static void CheckNotificationToSend
                 LE_DEBUG("No download to resume.");
                 return;
             }
+
+            // A pushed package is resumed by the server, no download is pending
+            if (packagePush_IsPushUri(downloadUri))
+            {
+                LE_DEBUG("Pushed package to resume by the server.");
+                return;
+            }
         }
 
         if (QueryDownloadHandlerRef == NULL)
@@ -4316,15 +4707,31 @@ COMPONENT_INIT
         LE_ERROR("failed to initialize package downloader");
     }
 
+    // The download shaper configuration of the config tree replaces the stored one
+    ReadDownloadShaperConfiguration();
+    le_cfg_AddChangeHandler(DOWNLOAD_SHAPER_CFG, DownloadShaperConfigHandler, NULL);
+
+    // The package mirror configuration of the config tree replaces the stored one
+    ReadPackageMirrorConfiguration();
+    le_cfg_AddChangeHandler(PACKAGE_MIRROR_CFG, PackageMirrorConfigHandler, NULL);
+
+    if (LE_OK != trafficAccounting_Init())
+    {
+        LE_ERROR("failed to initialize traffic accounting");
+    }
+
+    avcComm_Init();
     assetData_Init();
     avData_Init();
     timeSeries_Init();
     push_Init();
     avcClient_Init();
 
-    // Read the user defined timeout from config tree @ /apps/avcService/activityTimeout
+    // Read the user defined timeout from config tree @ /apps/avcService/activityTimeout, and
+    // whether the SOTA operations are applied as transactions @ /apps/avcService/sotaTransaction
     le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(AVC_SERVICE_CFG);
     int timeout = le_cfg_GetInt(iterRef, "activityTimeout", 20);
+    IsSotaTransactionEnabled = le_cfg_GetBool(iterRef, "sotaTransaction", false);
     le_cfg_CancelTxn(iterRef);
     avcClient_SetActivityTimeout(timeout);
 
@@ -4363,6 +4770,9 @@ COMPONENT_INIT
         fsSys_RemoveNewSysFlag();
     }
 
+    // Read the probation of the installs before checking their results
+    healthCheck_Init();
+
     // Initialize application update module
     avcApp_Init();
 
@@ -4370,6 +4780,10 @@ COMPONENT_INIT
     // firmware update and application update
     CheckNotificationToSend(NULL, NULL);
 
+    // Set the local package directory and start a firmware update set in the config tree
+    ReadPackageLocalConfiguration();
+    le_cfg_AddChangeHandler(PACKAGE_LOCAL_CFG, PackageLocalConfigHandler, NULL);
+
     // Start watchdog on the main AVC event loop.
     // Try to kick a couple of times before each timeout.
     le_clk_Time_t watchdogInterval = { .sec = 8 };
@@ -212,6 +212,19 @@ LE_SHARED void avcServer_UpdateStatus
     void* contextPtr
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report that a package download is held because the metered-data budget is exhausted, or that
+ * it resumes. The held download has its own AVC state, distinct from a download suspended by the
+ * server or pending a user agreement: it resumes without any user agreement.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED void avcServer_ReportDownloadHold
+(
+    bool isHeld,                    ///< [IN] The download is held, or resumes
+    lwm2mcore_UpdateType_t type     ///< [IN] Update type
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Start a session with the AirVantage server
@@ -0,0 +1,705 @@
+/**
+ * @file changeStream.c
+ *
+ * Implementation of the local streams of the asset data changes.
+ *
+ * A change is copied once into an event shared by the queues of all its subscribers. The delivery
+ * is queued on the event loop by the first change following a delivery, so the changes made during
+ * an event loop turn are delivered together.
+ *
+ * The clients of the le_avdataStream service are subscribers whose batches are passed to their
+ * handler one change at a time. Their subscriptions are released when their session is closed.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "changeStream.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Expected number of subscribers
+ */
+//--------------------------------------------------------------------------------------------------
+#define CHANGESTREAM_EXPECTED_SUBSCRIBERS   8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Expected number of handlers of the le_avdataStream clients
+ */
+//--------------------------------------------------------------------------------------------------
+#define CHANGESTREAM_EXPECTED_CLIENT_HANDLERS   8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change event, shared by the queues of the subscribers
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char                  path[LE_AVDATA_PATH_NAME_BYTES];  ///< Namespaced asset data path
+    le_avdata_DataType_t  dataType;                         ///< Data type of the new value
+    changeStream_Value_t  value;                            ///< New value, the string is
+                                                            ///< allocated from the string pool
+    changeStream_Origin_t origin;                           ///< Origin of the change
+}
+Event_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Entry of the queue of a subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_dls_Link_t link;             ///< Link in the queue of the subscriber
+    Event_t*      eventPtr;         ///< Queued event, one reference held by the entry
+}
+QueueEntry_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_dls_Link_t                link;          ///< Link in the subscriber list
+    changeStream_SubscriberRef_t ref;           ///< Safe reference of the subscriber
+    char                         path[LE_AVDATA_PATH_NAME_BYTES];
+                                                ///< Observed path, without trailing slash
+    size_t                       pathLen;       ///< Length of the observed path, 0 for all
+    size_t                       maxEvents;     ///< Maximum number of queued events
+    le_dls_List_t                queue;         ///< Queued events, oldest first
+    size_t                       numQueued;     ///< Number of queued events
+    uint32_t                     numLost;       ///< Number of events dropped since the last batch
+    uint64_t                     delivered;     ///< Number of delivered events
+    uint64_t                     lost;          ///< Number of dropped events
+    changeStream_HandlerFunc_t   handlerPtr;    ///< Handler of the change events
+    void*                        contextPtr;    ///< Context passed to the handler
+    bool                         isDeleted;     ///< Unsubscribed during a delivery
+}
+Subscriber_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of a client of the le_avdataStream service
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_dls_Link_t                       link;       ///< Link in the client handler list
+    le_avdataStream_ChangeHandlerRef_t  ref;        ///< Safe reference of the handler
+    changeStream_SubscriberRef_t        subRef;     ///< Subscription of the handler
+    le_msg_SessionRef_t                 sessionRef; ///< Session of the client
+    le_avdataStream_ChangeHandlerFunc_t handlerPtr; ///< Handler of the client
+    void*                               contextPtr; ///< Context of the client handler
+}
+ClientHandler_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pools of the events, queue entries, event string values and subscribers
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t EventPool;
+static le_mem_PoolRef_t QueueEntryPool;
+static le_mem_PoolRef_t StringPool;
+static le_mem_PoolRef_t SubscriberPool;
+static le_mem_PoolRef_t ClientHandlerPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Map of the subscriber safe references
+ */
+//--------------------------------------------------------------------------------------------------
+static le_ref_MapRef_t SubscriberRefMap;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Subscribers, in subscription order
+ */
+//--------------------------------------------------------------------------------------------------
+static le_dls_List_t SubscriberList = LE_DLS_LIST_INIT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Map of the client handler safe references, and client handlers
+ */
+//--------------------------------------------------------------------------------------------------
+static le_ref_MapRef_t ClientHandlerRefMap;
+static le_dls_List_t ClientHandlerList = LE_DLS_LIST_INIT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Events passed to a handler, filled from the queue of a subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+static changeStream_Event_t EventArr[CHANGESTREAM_MAX_EVENTS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A delivery is queued on the event loop
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsDeliveryQueued = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The handlers are being called: the unsubscribed subscribers are released after the delivery
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsDelivering = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Destructor of an event: release its string value
+ */
+//--------------------------------------------------------------------------------------------------
+static void EventDestructor
+(
+    void* objPtr                    ///< [IN] Event
+)
+{
+    Event_t* eventPtr = objPtr;
+
+    if (LE_AVDATA_DATA_TYPE_STRING == eventPtr->dataType)
+    {
+        le_mem_Release((void*)eventPtr->value.strValuePtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the events queued for a subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearQueue
+(
+    le_dls_List_t* queuePtr         ///< [IN] Queue
+)
+{
+    le_dls_Link_t* linkPtr;
+
+    while (NULL != (linkPtr = le_dls_Pop(queuePtr)))
+    {
+        QueueEntry_t* entryPtr = CONTAINER_OF(linkPtr, QueueEntry_t, link);
+        le_mem_Release(entryPtr->eventPtr);
+        le_mem_Release(entryPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a subscriber and its queued events
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReleaseSubscriber
+(
+    Subscriber_t* subPtr            ///< [IN] Subscriber
+)
+{
+    ClearQueue(&subPtr->queue);
+    le_dls_Remove(&SubscriberList, &subPtr->link);
+    le_mem_Release(subPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a path is the observed path of a subscriber or belongs to its subtree
+ *
+ * @return
+ *  - true if the changes of the path are delivered to the subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsPathObserved
+(
+    const Subscriber_t* subPtr,     ///< [IN] Subscriber
+    const char* path                ///< [IN] Namespaced asset data path
+)
+{
+    if (0 == subPtr->pathLen)
+    {
+        return true;
+    }
+
+    return ((0 == strncmp(path, subPtr->path, subPtr->pathLen)) &&
+            (('\0' == path[subPtr->pathLen]) || ('/' == path[subPtr->pathLen])));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deliver the queued events, one batch per subscriber. Called from the event loop.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DeliverEvents
+(
+    void* param1Ptr,                ///< [IN] Unused
+    void* param2Ptr                 ///< [IN] Unused
+)
+{
+    le_dls_Link_t* linkPtr;
+
+    // Changes made by the handlers are delivered on the next turn
+    IsDeliveryQueued = false;
+    IsDelivering = true;
+
+    for (linkPtr = le_dls_Peek(&SubscriberList);
+         NULL != linkPtr;
+         linkPtr = le_dls_PeekNext(&SubscriberList, linkPtr))
+    {
+        Subscriber_t* subPtr = CONTAINER_OF(linkPtr, Subscriber_t, link);
+
+        if ((subPtr->isDeleted) || ((0 == subPtr->numQueued) && (0 == subPtr->numLost)))
+        {
+            continue;
+        }
+
+        // Detach the queue: the events queued by the handler go to the next batch
+        le_dls_List_t batch = subPtr->queue;
+        uint32_t numLost = subPtr->numLost;
+        size_t numEvents = 0;
+        le_dls_Link_t* entryLinkPtr;
+
+        subPtr->queue = LE_DLS_LIST_INIT;
+        subPtr->numQueued = 0;
+        subPtr->numLost = 0;
+
+        for (entryLinkPtr = le_dls_Peek(&batch);
+             NULL != entryLinkPtr;
+             entryLinkPtr = le_dls_PeekNext(&batch, entryLinkPtr))
+        {
+            const Event_t* eventPtr = CONTAINER_OF(entryLinkPtr, QueueEntry_t, link)->eventPtr;
+
+            EventArr[numEvents].path = eventPtr->path;
+            EventArr[numEvents].dataType = eventPtr->dataType;
+            EventArr[numEvents].value = eventPtr->value;
+            EventArr[numEvents].origin = eventPtr->origin;
+            numEvents++;
+        }
+
+        subPtr->delivered += numEvents;
+        subPtr->handlerPtr(EventArr, numEvents, numLost, subPtr->contextPtr);
+
+        ClearQueue(&batch);
+    }
+
+    IsDelivering = false;
+
+    // Release the subscribers unsubscribed by the handlers
+    linkPtr = le_dls_Peek(&SubscriberList);
+    while (NULL != linkPtr)
+    {
+        Subscriber_t* subPtr = CONTAINER_OF(linkPtr, Subscriber_t, link);
+        linkPtr = le_dls_PeekNext(&SubscriberList, linkPtr);
+
+        if (subPtr->isDeleted)
+        {
+            ReleaseSubscriber(subPtr);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change handler of a client of the le_avdataStream service: the batch is passed to the handler of
+ * the client one change at a time, the lost changes are reported with the first one
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClientChangeHandler
+(
+    const changeStream_Event_t* eventArr,   ///< [IN] Change events
+    size_t numEvents,                       ///< [IN] Number of events
+    uint32_t numLost,                       ///< [IN] Number of events dropped since the last batch
+    void* contextPtr                        ///< [IN] Client handler
+)
+{
+    ClientHandler_t* clientPtr = contextPtr;
+    size_t i;
+
+    for (i = 0; i < numEvents; i++)
+    {
+        const changeStream_Event_t* eventPtr = &eventArr[i];
+        le_avdataStream_Origin_t origin = (CHANGESTREAM_ORIGIN_SERVER == eventPtr->origin) ?
+                                          LE_AVDATASTREAM_ORIGIN_SERVER :
+                                          LE_AVDATASTREAM_ORIGIN_CLIENT;
+        int32_t intValue = 0;
+        double floatValue = 0;
+        bool boolValue = false;
+        const char* strValuePtr = "";
+
+        switch (eventPtr->dataType)
+        {
+            case LE_AVDATA_DATA_TYPE_INT:
+                intValue = eventPtr->value.intValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_FLOAT:
+                floatValue = eventPtr->value.floatValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_BOOL:
+                boolValue = eventPtr->value.boolValue;
+                break;
+
+            case LE_AVDATA_DATA_TYPE_STRING:
+                strValuePtr = eventPtr->value.strValuePtr;
+                break;
+
+            default:
+                break;
+        }
+
+        clientPtr->handlerPtr(eventPtr->path, eventPtr->dataType, intValue, floatValue,
+                              boolValue, strValuePtr, origin, (0 == i) ? numLost : 0,
+                              clientPtr->contextPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the handler of a client of the le_avdataStream service and its subscription
+ */
+//--------------------------------------------------------------------------------------------------
+static void RemoveClientHandler
+(
+    ClientHandler_t* clientPtr      ///< [IN] Client handler
+)
+{
+    changeStream_Unsubscribe(clientPtr->subRef);
+    le_ref_DeleteRef(ClientHandlerRefMap, clientPtr->ref);
+    le_dls_Remove(&ClientHandlerList, &clientPtr->link);
+    le_mem_Release(clientPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called when a client session of the le_avdataStream service is closed: the handlers of
+ * the client are removed
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClientCloseSessionHandler
+(
+    le_msg_SessionRef_t sessionRef, ///< [IN] Session
+    void* contextPtr                ///< [IN] Unused
+)
+{
+    le_dls_Link_t* linkPtr = le_dls_Peek(&ClientHandlerList);
+
+    while (NULL != linkPtr)
+    {
+        ClientHandler_t* clientPtr = CONTAINER_OF(linkPtr, ClientHandler_t, link);
+        linkPtr = le_dls_PeekNext(&ClientHandlerList, linkPtr);
+
+        if (clientPtr->sessionRef == sessionRef)
+        {
+            LE_DEBUG("Remove the change handler %p of a closed client", clientPtr->ref);
+            RemoveClientHandler(clientPtr);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the change streams
+ */
+//--------------------------------------------------------------------------------------------------
+void changeStream_Init
+(
+    void
+)
+{
+    EventPool = le_mem_CreatePool("Change events", sizeof(Event_t));
+    le_mem_SetDestructor(EventPool, EventDestructor);
+    QueueEntryPool = le_mem_CreatePool("Change queue entries", sizeof(QueueEntry_t));
+    StringPool = le_mem_CreatePool("Change strings", LE_AVDATA_STRING_VALUE_BYTES);
+    SubscriberPool = le_mem_CreatePool("Change subscribers", sizeof(Subscriber_t));
+    SubscriberRefMap = le_ref_CreateMap("Change subscribers", CHANGESTREAM_EXPECTED_SUBSCRIBERS);
+
+    ClientHandlerPool = le_mem_CreatePool("Change client handlers", sizeof(ClientHandler_t));
+    ClientHandlerRefMap = le_ref_CreateMap("Change client handlers",
+                                           CHANGESTREAM_EXPECTED_CLIENT_HANDLERS);
+
+    // Release the subscriptions of the clients when they go away
+    le_msg_AddServiceCloseHandler(le_avdataStream_GetServiceRef(), ClientCloseSessionHandler,
+                                  NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Subscribe to the changes of an asset data path and of its subtree. The handler is called from
+ * the event loop, it can subscribe, unsubscribe and set asset data values.
+ *
+ * @return
+ *  - Reference to the subscriber
+ *  - NULL if a parameter is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+changeStream_SubscriberRef_t changeStream_Subscribe
+(
+    const char* path,                       ///< [IN] Namespaced asset data path, "" or "/" for
+                                            ///<      the whole asset data tree
+    size_t maxEvents,                       ///< [IN] Maximum number of queued events, up to
+                                            ///<      CHANGESTREAM_MAX_EVENTS
+    changeStream_HandlerFunc_t handlerPtr,  ///< [IN] Handler of the change events
+    void* contextPtr                        ///< [IN] Context passed to the handler
+)
+{
+    char observedPath[LE_AVDATA_PATH_NAME_BYTES];
+    size_t pathLen;
+
+    if ((NULL == path) || (NULL == handlerPtr) ||
+        (0 == maxEvents) || (maxEvents > CHANGESTREAM_MAX_EVENTS))
+    {
+        LE_ERROR("Invalid change subscription");
+        return NULL;
+    }
+
+    if (LE_OK != le_utf8_Copy(observedPath, path, sizeof(observedPath), &pathLen))
+    {
+        LE_ERROR("Change subscription path too long");
+        return NULL;
+    }
+
+    // The subtree of a path is observed with or without a trailing slash
+    while ((pathLen > 0) && ('/' == observedPath[pathLen - 1]))
+    {
+        observedPath[--pathLen] = '\0';
+    }
+
+    Subscriber_t* subPtr = le_mem_ForceAlloc(SubscriberPool);
+    memset(subPtr, 0, sizeof(Subscriber_t));
+    memcpy(subPtr->path, observedPath, pathLen + 1);
+    subPtr->link = LE_DLS_LINK_INIT;
+    subPtr->pathLen = pathLen;
+    subPtr->maxEvents = maxEvents;
+    subPtr->queue = LE_DLS_LIST_INIT;
+    subPtr->handlerPtr = handlerPtr;
+    subPtr->contextPtr = contextPtr;
+    subPtr->ref = le_ref_CreateRef(SubscriberRefMap, subPtr);
+
+    le_dls_Queue(&SubscriberList, &subPtr->link);
+
+    LE_DEBUG("Subscribed to the changes of '%s', up to %zu events", subPtr->path, maxEvents);
+
+    return subPtr->ref;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unsubscribe. The queued events are dropped.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Invalid subscriber reference provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t changeStream_Unsubscribe
+(
+    changeStream_SubscriberRef_t subRef     ///< [IN] Subscriber
+)
+{
+    Subscriber_t* subPtr = le_ref_Lookup(SubscriberRefMap, subRef);
+
+    if (NULL == subPtr)
+    {
+        LE_ERROR("Invalid change subscriber reference %p", subRef);
+        return LE_BAD_PARAMETER;
+    }
+
+    le_ref_DeleteRef(SubscriberRefMap, subRef);
+
+    // The subscriber list is being walked by the delivery, it is released afterwards
+    if (IsDelivering)
+    {
+        subPtr->isDeleted = true;
+        ClearQueue(&subPtr->queue);
+        subPtr->numQueued = 0;
+        subPtr->numLost = 0;
+    }
+    else
+    {
+        ReleaseSubscriber(subPtr);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of a subscriber
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Invalid subscriber reference or null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t changeStream_GetStats
+(
+    changeStream_SubscriberRef_t subRef,    ///< [IN] Subscriber
+    changeStream_Stats_t* statsPtr          ///< [OUT] Statistics
+)
+{
+    Subscriber_t* subPtr = le_ref_Lookup(SubscriberRefMap, subRef);
+
+    if ((NULL == subPtr) || (NULL == statsPtr))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    statsPtr->delivered = subPtr->delivered;
+    statsPtr->lost = subPtr->lost;
+    statsPtr->queued = subPtr->numQueued;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Notify a change of an asset data value to the subscribers of its path. The value is copied, the
+ * events are delivered on the next event loop turn.
+ */
+//--------------------------------------------------------------------------------------------------
+void changeStream_Notify
+(
+    const char* path,                       ///< [IN] Namespaced asset data path
+    le_avdata_DataType_t dataType,          ///< [IN] Data type of the new value
+    const changeStream_Value_t* valuePtr,   ///< [IN] New value
+    changeStream_Origin_t origin            ///< [IN] Origin of the change
+)
+{
+    Event_t* eventPtr = NULL;
+    le_dls_Link_t* linkPtr;
+
+    // Nothing to copy when nobody observes the asset data
+    if (le_dls_IsEmpty(&SubscriberList))
+    {
+        return;
+    }
+
+    for (linkPtr = le_dls_Peek(&SubscriberList);
+         NULL != linkPtr;
+         linkPtr = le_dls_PeekNext(&SubscriberList, linkPtr))
+    {
+        Subscriber_t* subPtr = CONTAINER_OF(linkPtr, Subscriber_t, link);
+
+        if ((subPtr->isDeleted) || (!IsPathObserved(subPtr, path)))
+        {
+            continue;
+        }
+
+        // The event is created for the first subscriber observing the path
+        if (NULL == eventPtr)
+        {
+            eventPtr = le_mem_ForceAlloc(EventPool);
+            le_utf8_Copy(eventPtr->path, path, sizeof(eventPtr->path), NULL);
+            eventPtr->dataType = dataType;
+            eventPtr->value = *valuePtr;
+            eventPtr->origin = origin;
+
+            if (LE_AVDATA_DATA_TYPE_STRING == dataType)
+            {
+                char* strPtr = le_mem_ForceAlloc(StringPool);
+                le_utf8_Copy(strPtr, valuePtr->strValuePtr, LE_AVDATA_STRING_VALUE_BYTES, NULL);
+                eventPtr->value.strValuePtr = strPtr;
+            }
+        }
+        else
+        {
+            le_mem_AddRef(eventPtr);
+        }
+
+        // Drop the oldest event when the queue is full
+        if (subPtr->numQueued >= subPtr->maxEvents)
+        {
+            QueueEntry_t* oldestPtr = CONTAINER_OF(le_dls_Pop(&subPtr->queue), QueueEntry_t, link);
+            le_mem_Release(oldestPtr->eventPtr);
+            le_mem_Release(oldestPtr);
+            subPtr->numQueued--;
+            subPtr->numLost++;
+            subPtr->lost++;
+        }
+
+        QueueEntry_t* entryPtr = le_mem_ForceAlloc(QueueEntryPool);
+        entryPtr->link = LE_DLS_LINK_INIT;
+        entryPtr->eventPtr = eventPtr;
+        le_dls_Queue(&subPtr->queue, &entryPtr->link);
+        subPtr->numQueued++;
+    }
+
+    if ((NULL != eventPtr) && (!IsDeliveryQueued))
+    {
+        le_event_QueueFunction(DeliverEvents, NULL, NULL);
+        IsDeliveryQueued = true;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add handler function for EVENT 'le_avdataStream_Change'
+ *
+ * This event provides the changes of an asset data path and of its subtree.
+ *
+ * @return
+ *  - Reference to the handler
+ *  - NULL if a parameter is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+le_avdataStream_ChangeHandlerRef_t le_avdataStream_AddChangeHandler
+(
+    const char* path,                               ///< [IN] Namespaced asset data path
+    uint32_t maxEvents,                             ///< [IN] Maximum number of queued changes
+    le_avdataStream_ChangeHandlerFunc_t handlerPtr, ///< [IN] Handler of the client
+    void* contextPtr                                ///< [IN] Context of the client handler
+)
+{
+    ClientHandler_t* clientPtr;
+
+    if (NULL == handlerPtr)
+    {
+        LE_ERROR("Handler function is NULL");
+        return NULL;
+    }
+
+    clientPtr = le_mem_ForceAlloc(ClientHandlerPool);
+    clientPtr->subRef = changeStream_Subscribe(path, maxEvents, ClientChangeHandler, clientPtr);
+    if (NULL == clientPtr->subRef)
+    {
+        le_mem_Release(clientPtr);
+        return NULL;
+    }
+
+    clientPtr->link = LE_DLS_LINK_INIT;
+    clientPtr->sessionRef = le_avdataStream_GetClientSessionRef();
+    clientPtr->handlerPtr = handlerPtr;
+    clientPtr->contextPtr = contextPtr;
+    clientPtr->ref = le_ref_CreateRef(ClientHandlerRefMap, clientPtr);
+    le_dls_Queue(&ClientHandlerList, &clientPtr->link);
+
+    return clientPtr->ref;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove handler function for EVENT 'le_avdataStream_Change'
+ */
+//--------------------------------------------------------------------------------------------------
+void le_avdataStream_RemoveChangeHandler
+(
+    le_avdataStream_ChangeHandlerRef_t handlerRef   ///< [IN] Reference to the handler
+)
+{
+    ClientHandler_t* clientPtr = le_ref_Lookup(ClientHandlerRefMap, handlerRef);
+
+    if ((NULL == clientPtr) || (clientPtr->sessionRef != le_avdataStream_GetClientSessionRef()))
+    {
+        LE_ERROR("Invalid change handler reference %p", handlerRef);
+        return;
+    }
+
+    RemoveClientHandler(clientPtr);
+}
@@ -0,0 +1,184 @@
+/**
+ * @file changeStream.h
+ *
+ * Local streams of the asset data changes.
+ *
+ * A local subscriber observes an asset data path, or a subtree of the asset data, and receives an
+ * event for each value set on it, by a client application or by the server. The paths are the
+ * namespaced asset data paths, e.g. /<appName>/<path> for a resource in an application namespace.
+ *
+ * The events are queued per subscriber and delivered in batches, once per event loop turn. The
+ * queue of a subscriber is bounded: when it is full, the oldest event is dropped and the loss is
+ * reported with the next batch.
+ *
+ * The local applications subscribe through the le_avdataStream service provided by avcService,
+ * changeStream_Subscribe() is the interface of the modules of the daemon.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_CHANGESTREAM_INCLUDE_GUARD
+#define LEGATO_CHANGESTREAM_INCLUDE_GUARD
+
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of events queued for a subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+#define CHANGESTREAM_MAX_EVENTS     64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Origin of a change
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    CHANGESTREAM_ORIGIN_SERVER = 0, ///< Value written by the server
+    CHANGESTREAM_ORIGIN_CLIENT      ///< Value set by a client application
+}
+changeStream_Origin_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Value of an asset data
+ */
+//--------------------------------------------------------------------------------------------------
+typedef union
+{
+    int         intValue;
+    double      floatValue;
+    bool        boolValue;
+    const char* strValuePtr;
+}
+changeStream_Value_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change event. The path and string value are only valid during the call of the handler.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char*           path;     ///< Namespaced asset data path
+    le_avdata_DataType_t  dataType; ///< Data type of the new value, LE_AVDATA_DATA_TYPE_NONE for
+                                    ///< a null value
+    changeStream_Value_t  value;    ///< New value
+    changeStream_Origin_t origin;   ///< Origin of the change
+}
+changeStream_Event_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Statistics of a subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t delivered;             ///< Number of delivered events
+    uint64_t lost;                  ///< Number of events dropped because the queue was full
+    size_t   queued;                ///< Number of events waiting for the next batch
+}
+changeStream_Stats_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference to a subscriber
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct changeStream_Subscriber* changeStream_SubscriberRef_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler receiving a batch of change events, in the order of the changes
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*changeStream_HandlerFunc_t)
+(
+    const changeStream_Event_t* eventArr,   ///< [IN] Change events
+    size_t numEvents,                       ///< [IN] Number of events
+    uint32_t numLost,                       ///< [IN] Number of events dropped since the last
+                                            ///<      batch because the queue was full
+    void* contextPtr                        ///< [IN] Context of the subscriber
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the change streams
+ */
+//--------------------------------------------------------------------------------------------------
+void changeStream_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Subscribe to the changes of an asset data path and of its subtree. The handler is called from
+ * the event loop, it can subscribe, unsubscribe and set asset data values.
+ *
+ * @return
+ *  - Reference to the subscriber
+ *  - NULL if a parameter is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+changeStream_SubscriberRef_t changeStream_Subscribe
+(
+    const char* path,                       ///< [IN] Namespaced asset data path, "" or "/" for
+                                            ///<      the whole asset data tree
+    size_t maxEvents,                       ///< [IN] Maximum number of queued events, up to
+                                            ///<      CHANGESTREAM_MAX_EVENTS
+    changeStream_HandlerFunc_t handlerPtr,  ///< [IN] Handler of the change events
+    void* contextPtr                        ///< [IN] Context passed to the handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unsubscribe. The queued events are dropped.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Invalid subscriber reference provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t changeStream_Unsubscribe
+(
+    changeStream_SubscriberRef_t subRef     ///< [IN] Subscriber
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of a subscriber
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Invalid subscriber reference or null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t changeStream_GetStats
+(
+    changeStream_SubscriberRef_t subRef,    ///< [IN] Subscriber
+    changeStream_Stats_t* statsPtr          ///< [OUT] Statistics
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Notify a change of an asset data value to the subscribers of its path. The value is copied, the
+ * events are delivered on the next event loop turn.
+ */
+//--------------------------------------------------------------------------------------------------
+void changeStream_Notify
+(
+    const char* path,                       ///< [IN] Namespaced asset data path
+    le_avdata_DataType_t dataType,          ///< [IN] Data type of the new value
+    const changeStream_Value_t* valuePtr,   ///< [IN] New value
+    changeStream_Origin_t origin            ///< [IN] Origin of the change
+);
+
+#endif // LEGATO_CHANGESTREAM_INCLUDE_GUARD
@@ -0,0 +1,496 @@
+/**
+ * @file healthCheck.c
+ *
+ * Implementation of the health check of the device after an install.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "healthCheck.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree path of the health check
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_HEALTH_CHECK_PATH           "/apps/avcService/healthCheck"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default interval between two probe evaluations, in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFAULT_POLL_INTERVAL           10
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Probe added with healthCheck_AddProbe()
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct healthCheck_Probe
+{
+    char                    name[HEALTH_CHECK_PROBE_NAME_LEN + 1];  ///< Name, empty if free
+    healthCheck_ProbeFunc_t func;                                   ///< Probe function
+    void*                   contextPtr;                             ///< Context
+    bool                    isPassed;                               ///< Passed during the probation
+}
+Probe_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Application checked for liveness
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char appName[LE_LIMIT_APP_NAME_LEN + 1];    ///< Application name
+    bool isStarted;                             ///< Seen running during the probation
+}
+CheckedApp_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Probes added with healthCheck_AddProbe()
+ */
+//--------------------------------------------------------------------------------------------------
+static Probe_t Probes[HEALTH_CHECK_MAX_PROBES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Running check: checked update, applications and result handler
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsRunning = false;
+static healthCheck_Update_t Update;
+static CheckedApp_t Apps[HEALTH_CHECK_MAX_APPS];
+static size_t AppCount = 0;
+static healthCheck_ResultHandlerFunc_t ResultHandler = NULL;
+static void* ResultContextPtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Whether the probation of the current system is locked by the running check
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsProbationLocked = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Whether the daemon registered to the server since the probation started
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsRegistered = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configured probation period and interval between two probe evaluations, in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+static int ProbationPeriod = 0;
+static int PollInterval = DEFAULT_POLL_INTERVAL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timers of the probation end and of the probe evaluations
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t ProbationTimerRef = NULL;
+static le_timer_Ref_t PollTimerRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End the running check and report its result
+ */
+//--------------------------------------------------------------------------------------------------
+static void End
+(
+    le_result_t result              ///< [IN] Result of the check
+)
+{
+    bool isRollingBack = false;
+    bool isLocked = IsProbationLocked;
+    healthCheck_ResultHandlerFunc_t handler = ResultHandler;
+
+    // The handler can start another check
+    le_timer_Stop(ProbationTimerRef);
+    le_timer_Stop(PollTimerRef);
+    IsRunning = false;
+    IsProbationLocked = false;
+    ResultHandler = NULL;
+
+    if (LE_OK == result)
+    {
+        LE_INFO("Health check passed");
+    }
+    else
+    {
+        // Only a system in probation can be rolled back
+        isRollingBack = (LE_UPDATECTRL_SYSTEMSTATE_PROBATION == le_updateCtrl_GetSystemState());
+        LE_ERROR("Health check failed (%s), %s", LE_RESULT_TXT(result),
+                 isRollingBack ? "rolling back to the last good system" : "no system to restore");
+    }
+
+    if (handler)
+    {
+        handler(result, isRollingBack, ResultContextPtr);
+    }
+
+    if (isRollingBack)
+    {
+        // The supervisor restarts the framework on the last good system
+        le_updateCtrl_FailProbation();
+    }
+    else if (isLocked)
+    {
+        le_updateCtrl_UnlockProbation();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Evaluate the probes
+ *
+ * @return
+ *  - LE_OK             All the probes passed
+ *  - LE_BUSY           Some probes did not pass yet
+ *  - LE_FAULT          A probe failed
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t EvaluateProbes
+(
+    void
+)
+{
+    le_result_t result = LE_OK;
+    size_t i;
+
+    // Liveness: an application stopping after it started is a crash
+    for (i = 0; i < AppCount; i++)
+    {
+        if (LE_APPINFO_STATE_RUNNING == le_appInfo_GetState(Apps[i].appName))
+        {
+            Apps[i].isStarted = true;
+        }
+        else if (Apps[i].isStarted)
+        {
+            LE_ERROR("Application %s stopped", Apps[i].appName);
+            return LE_FAULT;
+        }
+        else
+        {
+            LE_DEBUG("Application %s not started yet", Apps[i].appName);
+            result = LE_BUSY;
+        }
+    }
+
+    for (i = 0; i < HEALTH_CHECK_MAX_PROBES; i++)
+    {
+        if ('\0' == Probes[i].name[0])
+        {
+            continue;
+        }
+
+        switch (Probes[i].func(Update, Probes[i].contextPtr))
+        {
+            case LE_OK:
+                Probes[i].isPassed = true;
+                break;
+
+            case LE_BUSY:
+                break;
+
+            default:
+                LE_ERROR("Probe %s failed", Probes[i].name);
+                return LE_FAULT;
+        }
+
+        if (!Probes[i].isPassed)
+        {
+            LE_DEBUG("Probe %s not passed yet", Probes[i].name);
+            result = LE_BUSY;
+        }
+    }
+
+    if (!IsRegistered)
+    {
+        LE_DEBUG("Not registered yet");
+        result = LE_BUSY;
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Poll timer handler: a failed probe ends the check
+ */
+//--------------------------------------------------------------------------------------------------
+static void PollTimerHandler
+(
+    le_timer_Ref_t timerRef         ///< [IN] Timer reference
+)
+{
+    if (LE_FAULT == EvaluateProbes())
+    {
+        End(LE_FAULT);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Probation timer handler: the probes are evaluated a last time
+ */
+//--------------------------------------------------------------------------------------------------
+static void ProbationTimerHandler
+(
+    le_timer_Ref_t timerRef         ///< [IN] Timer reference
+)
+{
+    le_result_t result = EvaluateProbes();
+
+    End((LE_BUSY == result) ? LE_TIMEOUT : result);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the health check and read its configuration
+ */
+//--------------------------------------------------------------------------------------------------
+void healthCheck_Init
+(
+    void
+)
+{
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(CFG_HEALTH_CHECK_PATH);
+
+    ProbationPeriod = le_cfg_GetInt(iterRef, "probationPeriod", 0);
+    PollInterval = le_cfg_GetInt(iterRef, "pollInterval", DEFAULT_POLL_INTERVAL);
+    le_cfg_CancelTxn(iterRef);
+
+    if (PollInterval <= 0)
+    {
+        PollInterval = DEFAULT_POLL_INTERVAL;
+    }
+
+    if (NULL == ProbationTimerRef)
+    {
+        ProbationTimerRef = le_timer_Create("Health check probation");
+        le_timer_SetHandler(ProbationTimerRef, ProbationTimerHandler);
+
+        PollTimerRef = le_timer_Create("Health check poll");
+        le_timer_SetRepeat(PollTimerRef, 0);
+        le_timer_SetHandler(PollTimerRef, PollTimerHandler);
+    }
+
+    LE_INFO("Health check probation period: %d s", ProbationPeriod);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the installs are checked
+ *
+ * @return
+ *  - true if a probation period is configured
+ */
+//--------------------------------------------------------------------------------------------------
+bool healthCheck_IsEnabled
+(
+    void
+)
+{
+    return (ProbationPeriod > 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a health check is running
+ *
+ * @return
+ *  - true if the probation of an install is running
+ */
+//--------------------------------------------------------------------------------------------------
+bool healthCheck_IsRunning
+(
+    void
+)
+{
+    return IsRunning;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a probe evaluated during the probation of the installs
+ *
+ * @return
+ *  - Reference to the probe
+ *  - NULL if the name is invalid or too many probes are added
+ */
+//--------------------------------------------------------------------------------------------------
+healthCheck_ProbeRef_t healthCheck_AddProbe
+(
+    const char* namePtr,            ///< [IN] Name of the probe, for the logs
+    healthCheck_ProbeFunc_t func,   ///< [IN] Probe function
+    void* contextPtr                ///< [IN] Context of the probe function
+)
+{
+    size_t i;
+
+    if ((NULL == namePtr) || ('\0' == namePtr[0]) || (NULL == func))
+    {
+        LE_ERROR("Invalid probe");
+        return NULL;
+    }
+
+    for (i = 0; i < HEALTH_CHECK_MAX_PROBES; i++)
+    {
+        if ('\0' == Probes[i].name[0])
+        {
+            if (LE_OK != le_utf8_Copy(Probes[i].name, namePtr, sizeof(Probes[i].name), NULL))
+            {
+                LE_ERROR("Probe name too long: %s", namePtr);
+                Probes[i].name[0] = '\0';
+                return NULL;
+            }
+            Probes[i].func = func;
+            Probes[i].contextPtr = contextPtr;
+            Probes[i].isPassed = false;
+
+            LE_DEBUG("Probe %s added", namePtr);
+            return &Probes[i];
+        }
+    }
+
+    LE_ERROR("Too many probes, %s not added", namePtr);
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a probe
+ */
+//--------------------------------------------------------------------------------------------------
+void healthCheck_RemoveProbe
+(
+    healthCheck_ProbeRef_t probeRef ///< [IN] Probe reference
+)
+{
+    if ((probeRef < &Probes[0]) || (probeRef >= &Probes[HEALTH_CHECK_MAX_PROBES]))
+    {
+        LE_ERROR("Invalid probe reference %p", probeRef);
+        return;
+    }
+
+    LE_DEBUG("Probe %s removed", probeRef->name);
+    memset(probeRef, 0, sizeof(Probe_t));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the probation of an install. The probes are evaluated immediately, so the result handler
+ * can be called before this function returns.
+ *
+ * @return
+ *  - LE_OK             The probation is started
+ *  - LE_NOT_PERMITTED  No probation period is configured
+ *  - LE_BUSY           A probation is already running
+ *  - LE_BAD_PARAMETER  Invalid parameter
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t healthCheck_Start
+(
+    healthCheck_Update_t update,                ///< [IN] Checked update
+    const char* const* appNamesPtr,             ///< [IN] Installed applications checked for
+                                                ///<      liveness
+    size_t appCount,                            ///< [IN] Number of applications
+    healthCheck_ResultHandlerFunc_t handler,    ///< [IN] Handler of the result
+    void* contextPtr                            ///< [IN] Context of the handler
+)
+{
+    le_clk_Time_t interval = {.sec = 0, .usec = 0};
+    size_t i;
+
+    if (!healthCheck_IsEnabled())
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    if (IsRunning)
+    {
+        return LE_BUSY;
+    }
+
+    if ((appCount > HEALTH_CHECK_MAX_APPS) || ((appCount > 0) && (NULL == appNamesPtr)))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    for (i = 0; i < appCount; i++)
+    {
+        if (LE_OK != le_utf8_Copy(Apps[i].appName, appNamesPtr[i], sizeof(Apps[i].appName), NULL))
+        {
+            return LE_BAD_PARAMETER;
+        }
+        Apps[i].isStarted = false;
+    }
+    AppCount = appCount;
+
+    for (i = 0; i < HEALTH_CHECK_MAX_PROBES; i++)
+    {
+        Probes[i].isPassed = false;
+    }
+
+    // The daemon restarted with the new firmware, so any registration is done with it
+    if (HEALTH_CHECK_APPLICATION == update)
+    {
+        IsRegistered = false;
+    }
+
+    // Keep the supervisor from marking the new system good before the end of the probation
+    if ((LE_UPDATECTRL_SYSTEMSTATE_PROBATION == le_updateCtrl_GetSystemState()) &&
+        (LE_OK == le_updateCtrl_LockProbation()))
+    {
+        IsProbationLocked = true;
+    }
+
+    Update = update;
+    ResultHandler = handler;
+    ResultContextPtr = contextPtr;
+    IsRunning = true;
+
+    LE_INFO("Health check of %s install started for %d s, %zu applications",
+            (HEALTH_CHECK_FIRMWARE == update) ? "firmware" : "application",
+            ProbationPeriod, appCount);
+
+    interval.sec = ProbationPeriod;
+    le_timer_SetInterval(ProbationTimerRef, interval);
+    le_timer_Start(ProbationTimerRef);
+
+    interval.sec = PollInterval;
+    le_timer_SetInterval(PollTimerRef, interval);
+    le_timer_Start(PollTimerRef);
+
+    if (LE_FAULT == EvaluateProbes())
+    {
+        End(LE_FAULT);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report a registration to the AirVantage server
+ */
+//--------------------------------------------------------------------------------------------------
+void healthCheck_ReportRegistration
+(
+    void
+)
+{
+    IsRegistered = true;
+}
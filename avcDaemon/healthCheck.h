@@ -0,0 +1,202 @@
+/**
+ * @file healthCheck.h
+ *
+ * Health check of the device after a firmware or application install.
+ *
+ * An install is only reported successful once the device proved healthy during a probation period.
+ * During the probation, the health probes are evaluated periodically:
+ *  - Liveness: the installed applications are running, and none of them stopped after it started.
+ *  - Registration: the daemon registered to the AirVantage server.
+ *  - Probes added with healthCheck_AddProbe(), e.g. by the applications.
+ *
+ * The check fails as soon as a probe fails, and times out if a probe did not pass before the end of
+ * the probation. On failure, the probation of the current system is failed if it is still in
+ * probation: the supervisor then restarts the framework on the last good system.
+ *
+ * The probation is configured in the config tree:
+ *
+ * @verbatim
+   /apps/avcService/healthCheck/probationPeriod     Probation period in seconds, 0 to disable
+   /apps/avcService/healthCheck/pollInterval        Interval between two probe evaluations
+   @endverbatim
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_HEALTH_CHECK_INCLUDE_GUARD
+#define LEGATO_HEALTH_CHECK_INCLUDE_GUARD
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of probes added with healthCheck_AddProbe()
+ */
+//--------------------------------------------------------------------------------------------------
+#define HEALTH_CHECK_MAX_PROBES         8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of applications checked for liveness
+ */
+//--------------------------------------------------------------------------------------------------
+#define HEALTH_CHECK_MAX_APPS           16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a probe name
+ */
+//--------------------------------------------------------------------------------------------------
+#define HEALTH_CHECK_PROBE_NAME_LEN     31
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checked update
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    HEALTH_CHECK_FIRMWARE = 0,      ///< Firmware install, checked after the reboot
+    HEALTH_CHECK_APPLICATION        ///< Application install
+}
+healthCheck_Update_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference to a probe
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct healthCheck_Probe* healthCheck_ProbeRef_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Probe function, called at each evaluation during the probation
+ *
+ * @return
+ *  - LE_OK             The device is healthy
+ *  - LE_BUSY           The probe cannot tell yet
+ *  - Any other value   The device is not healthy
+ */
+//--------------------------------------------------------------------------------------------------
+typedef le_result_t (*healthCheck_ProbeFunc_t)
+(
+    healthCheck_Update_t update,    ///< [IN] Checked update
+    void* contextPtr                ///< [IN] Context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called with the result of a health check:
+ *  - LE_OK         All the probes passed during the probation
+ *  - LE_FAULT      A probe failed
+ *  - LE_TIMEOUT    A probe did not pass before the end of the probation
+ *
+ * On failure, the handler is called before the rollback, so that the failure can be stored before
+ * the framework restarts.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*healthCheck_ResultHandlerFunc_t)
+(
+    le_result_t result,             ///< [IN] Result of the health check
+    bool isRollingBack,             ///< [IN] Whether the last good system is being restored
+    void* contextPtr                ///< [IN] Context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the health check and read its configuration
+ */
+//--------------------------------------------------------------------------------------------------
+void healthCheck_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the installs are checked
+ *
+ * @return
+ *  - true if a probation period is configured
+ */
+//--------------------------------------------------------------------------------------------------
+bool healthCheck_IsEnabled
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a health check is running
+ *
+ * @return
+ *  - true if the probation of an install is running
+ */
+//--------------------------------------------------------------------------------------------------
+bool healthCheck_IsRunning
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a probe evaluated during the probation of the installs
+ *
+ * @return
+ *  - Reference to the probe
+ *  - NULL if the name is invalid or too many probes are added
+ */
+//--------------------------------------------------------------------------------------------------
+healthCheck_ProbeRef_t healthCheck_AddProbe
+(
+    const char* namePtr,            ///< [IN] Name of the probe, for the logs
+    healthCheck_ProbeFunc_t func,   ///< [IN] Probe function
+    void* contextPtr                ///< [IN] Context of the probe function
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a probe
+ */
+//--------------------------------------------------------------------------------------------------
+void healthCheck_RemoveProbe
+(
+    healthCheck_ProbeRef_t probeRef ///< [IN] Probe reference
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the probation of an install. The probes are evaluated immediately, so the result handler
+ * can be called before this function returns.
+ *
+ * @return
+ *  - LE_OK             The probation is started
+ *  - LE_NOT_PERMITTED  No probation period is configured
+ *  - LE_BUSY           A probation is already running
+ *  - LE_BAD_PARAMETER  Invalid parameter
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t healthCheck_Start
+(
+    healthCheck_Update_t update,                ///< [IN] Checked update
+    const char* const* appNamesPtr,             ///< [IN] Installed applications checked for
+                                                ///<      liveness
+    size_t appCount,                            ///< [IN] Number of applications
+    healthCheck_ResultHandlerFunc_t handler,    ///< [IN] Handler of the result
+    void* contextPtr                            ///< [IN] Context of the handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report a registration to the AirVantage server
+ */
+//--------------------------------------------------------------------------------------------------
+void healthCheck_ReportRegistration
+(
+    void
+);
+
+#endif /* LEGATO_HEALTH_CHECK_INCLUDE_GUARD */
@@ -237,6 +237,37 @@ le_result_t PushBuffer
     return result;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the content type of a SenML representation
+ *
+ * @return
+ *  - Content type of the SenML payload
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_PushContent_t push_GetSenmlContentType
+(
+    senml_Format_t format
+)
+{
+    lwm2mcore_PushContent_t contentType;
+
+    switch (format)
+    {
+        case SENML_FORMAT_JSON:
+            contentType = PUSH_CONTENT_SENML_JSON;
+            break;
+
+        case SENML_FORMAT_CBOR:
+        default:
+            contentType = PUSH_CONTENT_SENML_CBOR;
+            break;
+    }
+
+    return contentType;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Retry pushing items queued in the list after AV connection reset
@@ -8,6 +8,20 @@
  */
 
 #include <lwm2mcore/lwm2mcore.h>
+#include "senml.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Content types of the text and SenML (RFC 8428) payloads, in addition to the LwM2MCore ones.
+ * LwM2MCore sends the content type as the CoAP content format of the push or of the response.
+ */
+//--------------------------------------------------------------------------------------------------
+enum
+{
+    PUSH_CONTENT_TEXT_PLAIN = 0,                            ///< text/plain
+    PUSH_CONTENT_SENML_JSON = SENML_CONTENT_FORMAT_JSON,    ///< application/senml+json
+    PUSH_CONTENT_SENML_CBOR = SENML_CONTENT_FORMAT_CBOR     ///< application/senml+cbor
+};
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -57,6 +71,20 @@ LE_SHARED le_result_t PushBuffer
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the content type of a SenML representation
+ *
+ * @return
+ *  - Content type of the SenML payload
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED lwm2mcore_PushContent_t push_GetSenmlContentType
+(
+    senml_Format_t format
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Retry pushing items queued in the list after AV connection reset
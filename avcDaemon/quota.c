@@ -0,0 +1,404 @@
+/**
+ * @file quota.c
+ *
+ * Implementation of the per-application quotas of the asset data resources.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "limit.h"
+#include "quota.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree path of the quotas
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_QUOTA_PATH              "/apps/avcService/quotas"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Expected number of applications using the avdata service
+ */
+//--------------------------------------------------------------------------------------------------
+#define QUOTA_EXPECTED_APPS         31
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Quotas of an application
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct quota_App
+{
+    char          appName[LE_LIMIT_APP_NAME_LEN + 1];   ///< Application name
+    quota_Usage_t usage[QUOTA_MAX];                     ///< Usage of each resource
+}
+App_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree node of the limit of each resource
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* LimitNodes[QUOTA_MAX] =
+{
+    "maxResources",
+    "maxStringBytes",
+    "maxRecordBytes",
+    "maxQueuedPushes"
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of each resource in the logs
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* TypeNames[QUOTA_MAX] =
+{
+    "resources",
+    "string bytes",
+    "record bytes",
+    "queued pushes"
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Application quotas pool
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t AppPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Map of the application quotas, by application name. The applications are kept when their
+ * sessions close, as the pushes they requested may still be waiting for an acknowledgement.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t AppMap;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the limit of a resource in the config tree
+ *
+ * @return
+ *  - Limit, QUOTA_UNLIMITED if not limited
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t ReadLimit
+(
+    le_cfg_IteratorRef_t iterRef,   ///< [IN] Read transaction on the quotas
+    const char* appNamePtr,         ///< [IN] Application name
+    quota_Type_t type               ///< [IN] Resource
+)
+{
+    char path[LE_CFG_STR_LEN_BYTES];
+    int32_t defaultLimit;
+    int32_t limit;
+
+    snprintf(path, sizeof(path), "%s/%s", QUOTA_DEFAULT_NODE, LimitNodes[type]);
+    defaultLimit = le_cfg_GetInt(iterRef, path, 0);
+
+    snprintf(path, sizeof(path), "%s/%s", appNamePtr, LimitNodes[type]);
+    limit = le_cfg_GetInt(iterRef, path, defaultLimit);
+
+    return (limit > 0) ? (uint64_t)limit : QUOTA_UNLIMITED;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Log the usage of an application
+ */
+//--------------------------------------------------------------------------------------------------
+static void DumpApp
+(
+    const App_t* appPtr             ///< [IN] Application quotas
+)
+{
+    char line[256];
+    size_t length = 0;
+    int type;
+
+    for (type = 0; (type < QUOTA_MAX) && (length < sizeof(line)); type++)
+    {
+        const quota_Usage_t* usagePtr = &appPtr->usage[type];
+        char limit[24] = "-";
+
+        if (QUOTA_UNLIMITED != usagePtr->limit)
+        {
+            snprintf(limit, sizeof(limit), "%"PRIu64, usagePtr->limit);
+        }
+
+        length += snprintf(line + length, sizeof(line) - length,
+                           "%s%s %"PRIu64"/%s (peak %"PRIu64", %"PRIu32" rejected)",
+                           (type) ? ", " : "", TypeNames[type], usagePtr->used, limit,
+                           usagePtr->peak, usagePtr->rejected);
+    }
+
+    LE_INFO("%s: %s", appPtr->appName, line);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reject a request because of the limit of a resource
+ */
+//--------------------------------------------------------------------------------------------------
+static void Reject
+(
+    App_t* appPtr,                  ///< [IN] Application quotas
+    quota_Type_t type               ///< [IN] Resource
+)
+{
+    appPtr->usage[type].rejected++;
+
+    // Only the first rejection is reported, to avoid flooding the log with a runaway application
+    if (1 == appPtr->usage[type].rejected)
+    {
+        LE_WARN("Quota of %s exceeded by %s", TypeNames[type], appPtr->appName);
+        DumpApp(appPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the quotas
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_Init
+(
+    void
+)
+{
+    AppPool = le_mem_CreatePool("Quota apps", sizeof(App_t));
+    AppMap = le_hashmap_Create("Quota apps", QUOTA_EXPECTED_APPS,
+                               le_hashmap_HashString, le_hashmap_EqualsString);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the quotas of an application, created with the limits of the config tree if it is not known
+ * yet.
+ *
+ * @return
+ *  - Reference to the quotas of the application
+ */
+//--------------------------------------------------------------------------------------------------
+quota_AppRef_t quota_GetApp
+(
+    const char* appNamePtr          ///< [IN] Application name
+)
+{
+    App_t* appPtr = le_hashmap_Get(AppMap, appNamePtr);
+    le_cfg_IteratorRef_t iterRef;
+    int type;
+
+    if (appPtr)
+    {
+        return appPtr;
+    }
+
+    appPtr = le_mem_ForceAlloc(AppPool);
+    memset(appPtr, 0, sizeof(App_t));
+    le_utf8_Copy(appPtr->appName, appNamePtr, sizeof(appPtr->appName), NULL);
+
+    iterRef = le_cfg_CreateReadTxn(CFG_QUOTA_PATH);
+    for (type = 0; type < QUOTA_MAX; type++)
+    {
+        appPtr->usage[type].limit = ReadLimit(iterRef, appPtr->appName, type);
+    }
+    le_cfg_CancelTxn(iterRef);
+
+    le_hashmap_Put(AppMap, appPtr->appName, appPtr);
+    LE_DEBUG("Quotas of %s created", appPtr->appName);
+
+    return appPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reserve an amount of a resource, if the limit of the application allows it
+ *
+ * @return
+ *  - LE_OK             The amount is reserved
+ *  - QUOTA_EXCEEDED    The limit would be exceeded, nothing is reserved
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t quota_Reserve
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type,           ///< [IN] Resource
+    uint64_t        amount          ///< [IN] Amount to reserve
+)
+{
+    if ((!appRef) || (type >= QUOTA_MAX))
+    {
+        return LE_OK;
+    }
+
+    if (amount > quota_GetAvailable(appRef, type))
+    {
+        Reject(appRef, type);
+        return QUOTA_EXCEEDED;
+    }
+
+    quota_Charge(appRef, type, amount);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Account an amount of a resource without checking the limit, e.g. for a value written by the
+ * server
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_Charge
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type,           ///< [IN] Resource
+    uint64_t        amount          ///< [IN] Amount to account
+)
+{
+    quota_Usage_t* usagePtr;
+
+    if ((!appRef) || (type >= QUOTA_MAX))
+    {
+        return;
+    }
+
+    usagePtr = &appRef->usage[type];
+    usagePtr->used += amount;
+    if (usagePtr->used > usagePtr->peak)
+    {
+        usagePtr->peak = usagePtr->used;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release an amount of a resource previously reserved or charged
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_Release
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type,           ///< [IN] Resource
+    uint64_t        amount          ///< [IN] Amount to release
+)
+{
+    quota_Usage_t* usagePtr;
+
+    if ((!appRef) || (type >= QUOTA_MAX))
+    {
+        return;
+    }
+
+    usagePtr = &appRef->usage[type];
+    if (amount > usagePtr->used)
+    {
+        LE_ERROR("%s of %s released twice: %"PRIu64" > %"PRIu64,
+                 TypeNames[type], appRef->appName, amount, usagePtr->used);
+        amount = usagePtr->used;
+    }
+    usagePtr->used -= amount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Count a request rejected because of the limit of a resource, when the limit is not checked by
+ * quota_Reserve()
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_CountRejected
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type            ///< [IN] Resource
+)
+{
+    if ((appRef) && (type < QUOTA_MAX))
+    {
+        Reject(appRef, type);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the amount of a resource that the application can still use
+ *
+ * @return
+ *  - Available amount, QUOTA_UNLIMITED if the usage is not limited
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t quota_GetAvailable
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type            ///< [IN] Resource
+)
+{
+    const quota_Usage_t* usagePtr;
+
+    if ((!appRef) || (type >= QUOTA_MAX) || (QUOTA_UNLIMITED == appRef->usage[type].limit))
+    {
+        return QUOTA_UNLIMITED;
+    }
+
+    usagePtr = &appRef->usage[type];
+    return (usagePtr->used < usagePtr->limit) ? (usagePtr->limit - usagePtr->used) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the usage of a resource by an application
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Invalid resource or null pointer provided
+ *  - LE_NOT_FOUND      The application never used the avdata service
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t quota_GetUsage
+(
+    const char*     appNamePtr,     ///< [IN] Application name
+    quota_Type_t    type,           ///< [IN] Resource
+    quota_Usage_t*  usagePtr        ///< [OUT] Usage of the resource
+)
+{
+    App_t* appPtr;
+
+    if ((!appNamePtr) || (!usagePtr) || (type >= QUOTA_MAX))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    appPtr = le_hashmap_Get(AppMap, appNamePtr);
+    if (!appPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    *usagePtr = appPtr->usage[type];
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Log the usage of all the applications
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_Dump
+(
+    void
+)
+{
+    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AppMap);
+
+    LE_INFO("Asset data usage of %zu applications (used/limit):", le_hashmap_Size(AppMap));
+
+    while (LE_OK == le_hashmap_NextNode(iter))
+    {
+        DumpApp(le_hashmap_GetValue(iter));
+    }
+}
@@ -0,0 +1,207 @@
+/**
+ * @file quota.h
+ *
+ * Per-application quotas of the asset data resources.
+ *
+ * All the applications share the asset data, timeseries and push memory of avcService. The usage
+ * of each application is accounted, and can be limited in the config tree:
+ *
+ * @verbatim
+   /apps/avcService/quotas/<appName>/maxResources       Number of asset data resources
+   /apps/avcService/quotas/<appName>/maxStringBytes     Bytes of the string values
+   /apps/avcService/quotas/<appName>/maxRecordBytes     Bytes of data accumulated in records
+   /apps/avcService/quotas/<appName>/maxQueuedPushes    Number of pushes waiting for an ack
+   @endverbatim
+ *
+ * The limits of the "default" node apply to the applications without their own node. A missing or
+ * non-positive limit means that the usage is not limited. The limits are read when the application
+ * first opens a session to the avdata service.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_QUOTA_INCLUDE_GUARD
+#define LEGATO_QUOTA_INCLUDE_GUARD
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result code returned by the avdata functions when a quota is exceeded
+ */
+//--------------------------------------------------------------------------------------------------
+#define QUOTA_EXCEEDED              LE_OUT_OF_RANGE
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the config tree node holding the limits of the applications without their own node
+ */
+//--------------------------------------------------------------------------------------------------
+#define QUOTA_DEFAULT_NODE          "default"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Limit value of an unlimited usage
+ */
+//--------------------------------------------------------------------------------------------------
+#define QUOTA_UNLIMITED             UINT64_MAX
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Accounted resources
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    QUOTA_RESOURCES = 0,            ///< Number of asset data resources
+    QUOTA_STRING_BYTES,             ///< Bytes of the asset data string values
+    QUOTA_RECORD_BYTES,             ///< Bytes of data accumulated in timeseries records, encoded
+    QUOTA_QUEUED_PUSHES,            ///< Number of pushes waiting for an acknowledgement
+    QUOTA_MAX                       ///< Number of accounted resources
+}
+quota_Type_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Usage of a resource by an application
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t used;                  ///< Current usage
+    uint64_t peak;                  ///< Highest usage
+    uint64_t limit;                 ///< Limit, QUOTA_UNLIMITED if not limited
+    uint32_t rejected;              ///< Number of requests rejected because of the limit
+}
+quota_Usage_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference to the quotas of an application. A NULL reference is accepted by all the functions,
+ * its usage is not accounted.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct quota_App* quota_AppRef_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the quotas
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the quotas of an application, created with the limits of the config tree if it is not known
+ * yet.
+ *
+ * @return
+ *  - Reference to the quotas of the application
+ */
+//--------------------------------------------------------------------------------------------------
+quota_AppRef_t quota_GetApp
+(
+    const char* appNamePtr          ///< [IN] Application name
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reserve an amount of a resource, if the limit of the application allows it
+ *
+ * @return
+ *  - LE_OK             The amount is reserved
+ *  - QUOTA_EXCEEDED    The limit would be exceeded, nothing is reserved
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t quota_Reserve
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type,           ///< [IN] Resource
+    uint64_t        amount          ///< [IN] Amount to reserve
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Account an amount of a resource without checking the limit, e.g. for a value written by the
+ * server
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_Charge
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type,           ///< [IN] Resource
+    uint64_t        amount          ///< [IN] Amount to account
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release an amount of a resource previously reserved or charged
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_Release
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type,           ///< [IN] Resource
+    uint64_t        amount          ///< [IN] Amount to release
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Count a request rejected because of the limit of a resource, when the limit is not checked by
+ * quota_Reserve()
+ */
+//--------------------------------------------------------------------------------------------------
+void quota_CountRejected
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type            ///< [IN] Resource
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the amount of a resource that the application can still use
+ *
+ * @return
+ *  - Available amount, QUOTA_UNLIMITED if the usage is not limited
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t quota_GetAvailable
+(
+    quota_AppRef_t  appRef,         ///< [IN] Application quotas
+    quota_Type_t    type            ///< [IN] Resource
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the usage of a resource by an application
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Invalid resource or null pointer provided
+ *  - LE_NOT_FOUND      The application never used the avdata service
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t quota_GetUsage
+(
+    const char*     appNamePtr,     ///< [IN] Application name
+    quota_Type_t    type,           ///< [IN] Resource
+    quota_Usage_t*  usagePtr        ///< [OUT] Usage of the resource
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Log the usage of all the applications
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED void quota_Dump
+(
+    void
+);
+
+#endif /* LEGATO_QUOTA_INCLUDE_GUARD */
@@ -0,0 +1,371 @@
+/**
+ * @file resourceIndex.c
+ *
+ * Implementation of the on-disk index of the asset data resource definitions.
+ *
+ * The index is a header followed by one record per definition:
+ *
+ * @verbatim
+   header: magic (4) | version (1) | reserved (1) | count (2) | CRC32 of the records (4)
+   record: access mode (1) | namespace (1) | name length (1) | path length (2) | name | path
+   @endverbatim
+ *
+ * The integers are little endian and the strings are not null-terminated.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "resourceIndex.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Temporary file written before replacing the index
+ */
+//--------------------------------------------------------------------------------------------------
+#define RESOURCE_INDEX_TMP_PATH     RESOURCE_INDEX_PATH ".tmp"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Index magic number ("AVRI") and format version
+ */
+//--------------------------------------------------------------------------------------------------
+#define INDEX_MAGIC                 0x49525641
+#define INDEX_VERSION               1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the header and of the fixed part of a record
+ */
+//--------------------------------------------------------------------------------------------------
+#define INDEX_HEADER_SIZE           12
+#define INDEX_RECORD_HEADER_SIZE    5
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of definitions in the index
+ */
+//--------------------------------------------------------------------------------------------------
+#define INDEX_MAX_COUNT             UINT16_MAX
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a little endian integer
+ */
+//--------------------------------------------------------------------------------------------------
+static void PutUint
+(
+    uint8_t* bufPtr,    ///< [OUT] Buffer
+    uint32_t value,     ///< [IN] Value
+    size_t size         ///< [IN] Size of the integer in bytes
+)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        bufPtr[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a little endian integer
+ *
+ * @return
+ *  - Value
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetUint
+(
+    const uint8_t* bufPtr,  ///< [IN] Buffer
+    size_t size             ///< [IN] Size of the integer in bytes
+)
+{
+    uint32_t value = 0;
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        value |= (uint32_t)bufPtr[i] << (8 * i);
+    }
+
+    return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read exactly a number of bytes from the index
+ *
+ * @return
+ *  - LE_OK             The bytes are read
+ *  - LE_FAULT          The index is truncated or cannot be read
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadExact
+(
+    le_fs_FileRef_t fileRef,    ///< [IN] Index file
+    uint8_t* bufPtr,            ///< [OUT] Buffer
+    size_t size                 ///< [IN] Number of bytes to read
+)
+{
+    size_t readSize = size;
+
+    if (0 == size)
+    {
+        return LE_OK;
+    }
+
+    if ((LE_OK != le_fs_Read(fileRef, bufPtr, &readSize)) || (readSize != size))
+    {
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the records of the index, and report them if a handler is given
+ *
+ * @return
+ *  - LE_OK             The records are valid
+ *  - LE_FAULT          A record is invalid or cannot be read
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadRecords
+(
+    le_fs_FileRef_t fileRef,                        ///< [IN] Index file, after the header
+    uint32_t count,                                 ///< [IN] Number of records
+    uint32_t* crcPtr,                               ///< [OUT] CRC32 of the records
+    resourceIndex_EntryHandlerFunc_t handlerFunc,   ///< [IN] Handler of the definitions, or NULL
+    void* contextPtr                                ///< [IN] Context of the handler
+)
+{
+    uint8_t header[INDEX_RECORD_HEADER_SIZE];
+    resourceIndex_Entry_t entry;
+    uint32_t crc = LE_CRC_START_CRC32;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        size_t appNameLen;
+        size_t pathLen;
+
+        if (LE_OK != ReadExact(fileRef, header, sizeof(header)))
+        {
+            LE_ERROR("Record %"PRIu32" truncated", i);
+            return LE_FAULT;
+        }
+
+        memset(&entry, 0, sizeof(entry));
+        entry.accessMode = header[0];
+        entry.namespace = header[1];
+        appNameLen = header[2];
+        pathLen = GetUint(&header[3], 2);
+
+        if ((entry.accessMode > LE_AVDATA_ACCESS_COMMAND) ||
+            (entry.namespace > LE_AVDATA_NAMESPACE_GLOBAL) ||
+            (0 == appNameLen) || (appNameLen >= sizeof(entry.appName)) ||
+            (0 == pathLen) || (pathLen >= sizeof(entry.path)))
+        {
+            LE_ERROR("Record %"PRIu32" invalid", i);
+            return LE_FAULT;
+        }
+
+        if ((LE_OK != ReadExact(fileRef, (uint8_t*)entry.appName, appNameLen)) ||
+            (LE_OK != ReadExact(fileRef, (uint8_t*)entry.path, pathLen)))
+        {
+            LE_ERROR("Record %"PRIu32" truncated", i);
+            return LE_FAULT;
+        }
+
+        crc = le_crc_Crc32(header, sizeof(header), crc);
+        crc = le_crc_Crc32((uint8_t*)entry.appName, appNameLen, crc);
+        crc = le_crc_Crc32((uint8_t*)entry.path, pathLen, crc);
+
+        if (handlerFunc)
+        {
+            handlerFunc(&entry, contextPtr);
+        }
+    }
+
+    *crcPtr = crc;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the index. The previous index is replaced atomically: it is kept if the save fails.
+ *
+ * @return
+ *  - LE_OK             The index is saved
+ *  - LE_OVERFLOW       Too many definitions
+ *  - LE_FAULT          The index cannot be written
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resourceIndex_Save
+(
+    resourceIndex_NextEntryFunc_t nextFunc, ///< [IN] Function returning the definitions
+    void* contextPtr                        ///< [IN] Context of the function
+)
+{
+    uint8_t header[INDEX_HEADER_SIZE] = {0};
+    uint8_t record[INDEX_RECORD_HEADER_SIZE + LE_LIMIT_APP_NAME_LEN + LE_AVDATA_PATH_NAME_BYTES];
+    resourceIndex_Entry_t entry;
+    le_fs_FileRef_t fileRef;
+    uint32_t crc = LE_CRC_START_CRC32;
+    uint32_t count = 0;
+    int32_t offset;
+    le_result_t result;
+
+    result = le_fs_Open(RESOURCE_INDEX_TMP_PATH, LE_FS_WRONLY | LE_FS_CREAT | LE_FS_TRUNC,
+                        &fileRef);
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to open %s: %s", RESOURCE_INDEX_TMP_PATH, LE_RESULT_TXT(result));
+        return LE_FAULT;
+    }
+
+    // The header is written once the records are known
+    result = le_fs_Write(fileRef, header, sizeof(header));
+
+    while ((LE_OK == result) && (nextFunc(&entry, contextPtr)))
+    {
+        size_t appNameLen = strnlen(entry.appName, sizeof(entry.appName));
+        size_t pathLen = strnlen(entry.path, sizeof(entry.path));
+        size_t recordLen = INDEX_RECORD_HEADER_SIZE + appNameLen + pathLen;
+
+        if (count >= INDEX_MAX_COUNT)
+        {
+            LE_ERROR("Too many resources to index");
+            result = LE_OVERFLOW;
+            break;
+        }
+
+        record[0] = (uint8_t)entry.accessMode;
+        record[1] = (uint8_t)entry.namespace;
+        record[2] = (uint8_t)appNameLen;
+        PutUint(&record[3], pathLen, 2);
+        memcpy(&record[INDEX_RECORD_HEADER_SIZE], entry.appName, appNameLen);
+        memcpy(&record[INDEX_RECORD_HEADER_SIZE + appNameLen], entry.path, pathLen);
+
+        crc = le_crc_Crc32(record, recordLen, crc);
+        count++;
+
+        result = le_fs_Write(fileRef, record, recordLen);
+    }
+
+    if (LE_OK == result)
+    {
+        PutUint(&header[0], INDEX_MAGIC, 4);
+        header[4] = INDEX_VERSION;
+        PutUint(&header[6], count, 2);
+        PutUint(&header[8], crc, 4);
+
+        result = le_fs_Seek(fileRef, 0, LE_FS_SEEK_SET, &offset);
+        if (LE_OK == result)
+        {
+            result = le_fs_Write(fileRef, header, sizeof(header));
+        }
+    }
+
+    if ((LE_OK != le_fs_Close(fileRef)) && (LE_OK == result))
+    {
+        result = LE_FAULT;
+    }
+
+    if (LE_OK == result)
+    {
+        result = le_fs_Move(RESOURCE_INDEX_TMP_PATH, RESOURCE_INDEX_PATH);
+    }
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to save the resource index: %s", LE_RESULT_TXT(result));
+        le_fs_Delete(RESOURCE_INDEX_TMP_PATH);
+        return (LE_OVERFLOW == result) ? LE_OVERFLOW : LE_FAULT;
+    }
+
+    LE_DEBUG("%"PRIu32" resources indexed", count);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load the index. The definitions are only reported if the whole index is valid.
+ *
+ * @return
+ *  - LE_OK             The definitions are reported
+ *  - LE_NOT_FOUND      There is no index
+ *  - LE_FAULT          The index is corrupted or cannot be read
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resourceIndex_Load
+(
+    resourceIndex_EntryHandlerFunc_t handlerFunc,   ///< [IN] Handler of the definitions
+    void* contextPtr                                ///< [IN] Context of the handler
+)
+{
+    uint8_t header[INDEX_HEADER_SIZE];
+    le_fs_FileRef_t fileRef;
+    uint32_t count;
+    uint32_t crc;
+    int32_t offset;
+    le_result_t result;
+
+    result = le_fs_Open(RESOURCE_INDEX_PATH, LE_FS_RDONLY, &fileRef);
+    if (LE_NOT_FOUND == result)
+    {
+        return LE_NOT_FOUND;
+    }
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to open %s: %s", RESOURCE_INDEX_PATH, LE_RESULT_TXT(result));
+        return LE_FAULT;
+    }
+
+    result = ReadExact(fileRef, header, sizeof(header));
+    if ((LE_OK != result) || (INDEX_MAGIC != GetUint(&header[0], 4)) ||
+        (INDEX_VERSION != header[4]))
+    {
+        LE_ERROR("Invalid resource index header");
+        result = LE_FAULT;
+    }
+    else
+    {
+        count = GetUint(&header[6], 2);
+
+        // Check the whole index before reporting the first definition
+        result = ReadRecords(fileRef, count, &crc, NULL, NULL);
+        if ((LE_OK == result) && (crc != GetUint(&header[8], 4)))
+        {
+            LE_ERROR("Resource index CRC mismatch");
+            result = LE_FAULT;
+        }
+
+        if (LE_OK == result)
+        {
+            result = le_fs_Seek(fileRef, INDEX_HEADER_SIZE, LE_FS_SEEK_SET, &offset);
+        }
+
+        if (LE_OK == result)
+        {
+            result = ReadRecords(fileRef, count, &crc, handlerFunc, contextPtr);
+        }
+    }
+
+    le_fs_Close(fileRef);
+
+    if (LE_OK != result)
+    {
+        return LE_FAULT;
+    }
+
+    LE_INFO("%"PRIu32" resources restored from the index", count);
+    return LE_OK;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file resourceIndex.h
+ *
+ * On-disk index of the asset data resource definitions.
+ *
+ * The definitions of the resources created by the client applications (path, access mode,
+ * namespace and owning application) are saved in a compact index, so that the asset data tree can
+ * be restored when avcService restarts, before the applications reconnect. The values are not part
+ * of the index: the settings are restored from the config tree.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_RESOURCEINDEX_INCLUDE_GUARD
+#define LEGATO_RESOURCEINDEX_INCLUDE_GUARD
+
+#include "legato.h"
+#include "interfaces.h"
+#include "limit.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Path of the index file
+ */
+//--------------------------------------------------------------------------------------------------
+#define RESOURCE_INDEX_PATH         "/avc/resourceIndex"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Definition of a resource
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char path[LE_AVDATA_PATH_NAME_BYTES];           ///< Namespaced asset data path
+    le_avdata_AccessMode_t accessMode;              ///< Access mode
+    le_avdata_Namespace_t namespace;                ///< Namespace of the owning application
+    char appName[LE_LIMIT_APP_NAME_LEN + 1];        ///< Owning application
+}
+resourceIndex_Entry_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the next definition to save
+ *
+ * @return
+ *  - true if the entry is filled, false if there is no more definition
+ */
+//--------------------------------------------------------------------------------------------------
+typedef bool (*resourceIndex_NextEntryFunc_t)
+(
+    resourceIndex_Entry_t* entryPtr,    ///< [OUT] Definition
+    void* contextPtr                    ///< [IN] Context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a definition read from the index
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*resourceIndex_EntryHandlerFunc_t)
+(
+    const resourceIndex_Entry_t* entryPtr,  ///< [IN] Definition
+    void* contextPtr                        ///< [IN] Context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the index. The previous index is replaced atomically: it is kept if the save fails.
+ *
+ * @return
+ *  - LE_OK             The index is saved
+ *  - LE_OVERFLOW       Too many definitions
+ *  - LE_FAULT          The index cannot be written
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resourceIndex_Save
+(
+    resourceIndex_NextEntryFunc_t nextFunc, ///< [IN] Function returning the definitions
+    void* contextPtr                        ///< [IN] Context of the function
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load the index. The definitions are only reported if the whole index is valid.
+ *
+ * @return
+ *  - LE_OK             The definitions are reported
+ *  - LE_NOT_FOUND      There is no index
+ *  - LE_FAULT          The index is corrupted or cannot be read
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resourceIndex_Load
+(
+    resourceIndex_EntryHandlerFunc_t handlerFunc,   ///< [IN] Handler of the definitions
+    void* contextPtr                                ///< [IN] Context of the handler
+);
+
+#endif /* LEGATO_RESOURCEINDEX_INCLUDE_GUARD */
@@ -0,0 +1,1062 @@
+/**
+ * @file senml.c
+ *
+ * Implementation of the SenML (RFC 8428) encoder.
+ *
+ * The pack layout (which fields go in which record, base field factoring) is computed once, and
+ * written through a table of encoder operations. Each SenML representation provides its own
+ * operations, so a new representation only has to implement how a field is written.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "senml.h"
+#include "cbor.h"
+
+#include <math.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * String value encoded for a record without value, same as a read of a null asset data
+ */
+//--------------------------------------------------------------------------------------------------
+#define NULL_VALUE_STRING "(null)"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Largest magnitude of a double which is still exactly represented as an integer
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_EXACT_INTEGER_DOUBLE    9007199254740992.0
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of significant digits needed to print a double back to the same value
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_DOUBLE_DIGITS           17
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffer size to print a JSON number
+ */
+//--------------------------------------------------------------------------------------------------
+#define JSON_NUMBER_BYTES           32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SenML fields written by the encoder
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    FIELD_BASE_NAME,
+    FIELD_BASE_TIME,
+    FIELD_BASE_VALUE,
+    FIELD_NAME,
+    FIELD_TIME,
+    FIELD_VALUE,
+    FIELD_STRING_VALUE,
+    FIELD_BOOL_VALUE,
+    FIELD_ERROR,
+    FIELD_MAX
+}
+Field_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Labels of a SenML field in each representation. The "err" extension field has no registered
+ * CBOR label, the JSON label is used as a text string label.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    int         cborLabel;      ///< CBOR integer label
+    bool        isCborText;     ///< Use the JSON label as CBOR text string label
+    const char* jsonLabel;      ///< JSON label
+}
+Label_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Labels of the SenML fields
+ */
+//--------------------------------------------------------------------------------------------------
+static const Label_t Labels[FIELD_MAX] =
+{
+    [FIELD_BASE_NAME]    = { -2, false, "bn" },
+    [FIELD_BASE_TIME]    = { -3, false, "bt" },
+    [FIELD_BASE_VALUE]   = { -5, false, "bv" },
+    [FIELD_NAME]         = {  0, false, "n" },
+    [FIELD_TIME]         = {  6, false, "t" },
+    [FIELD_VALUE]        = {  2, false, "v" },
+    [FIELD_STRING_VALUE] = {  3, false, "vs" },
+    [FIELD_BOOL_VALUE]   = {  4, false, "vb" },
+    [FIELD_ERROR]        = {  0, true,  "err" },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of an encoding in progress
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t*    bufPtr;         ///< Output buffer
+    size_t      bufSize;        ///< Output buffer size
+    size_t      len;            ///< JSON: number of bytes written
+    bool        isFirstItem;    ///< JSON: no separator needed before the next record or field
+    CborEncoder stream;         ///< CBOR: stream encoder
+    CborEncoder pack;           ///< CBOR: pack array encoder
+    CborEncoder record;         ///< CBOR: record map encoder
+}
+Writer_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encoder operations of a SenML representation
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_result_t (*startPack)(Writer_t* writerPtr, size_t numRecords);
+    le_result_t (*startRecord)(Writer_t* writerPtr, size_t numFields);
+    le_result_t (*addString)(Writer_t* writerPtr, Field_t field, const char* strPtr, size_t len);
+    le_result_t (*addInt)(Writer_t* writerPtr, Field_t field, int64_t value);
+    le_result_t (*addDouble)(Writer_t* writerPtr, Field_t field, double value);
+    le_result_t (*addBool)(Writer_t* writerPtr, Field_t field, bool value);
+    le_result_t (*endRecord)(Writer_t* writerPtr);
+    le_result_t (*endPack)(Writer_t* writerPtr, size_t* lenPtr);
+}
+Encoder_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Base fields of a pack
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t   nameLen;           ///< Length of the base name, 0 if none
+    bool     hasTime;           ///< Base time is set
+    uint64_t time;              ///< Base time in milliseconds
+    bool     hasValue;          ///< Base value is set
+    int64_t  value;             ///< Base value
+}
+Base_t;
+
+
+//--------------------------------------------------------------------------------------------------
+// CBOR representation
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a tinyCBOR error to a result
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ConvertCborError
+(
+    CborError err
+)
+{
+    if (CborNoError == err)
+    {
+        return LE_OK;
+    }
+
+    return (CborErrorOutOfMemory == err) ? LE_OVERFLOW : LE_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the label of a field in the current CBOR record
+ */
+//--------------------------------------------------------------------------------------------------
+static CborError CborAddLabel
+(
+    Writer_t* writerPtr,
+    Field_t field
+)
+{
+    if (Labels[field].isCborText)
+    {
+        return cbor_encode_text_stringz(&writerPtr->record, Labels[field].jsonLabel);
+    }
+
+    return cbor_encode_int(&writerPtr->record, Labels[field].cborLabel);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a CBOR pack, i.e. a definite length array of records
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CborStartPack
+(
+    Writer_t* writerPtr,
+    size_t numRecords
+)
+{
+    cbor_encoder_init(&writerPtr->stream, writerPtr->bufPtr, writerPtr->bufSize, 0);
+
+    return ConvertCborError(cbor_encoder_create_array(&writerPtr->stream, &writerPtr->pack,
+                                                      numRecords));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a CBOR record, i.e. a definite length map of fields
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CborStartRecord
+(
+    Writer_t* writerPtr,
+    size_t numFields
+)
+{
+    return ConvertCborError(cbor_encoder_create_map(&writerPtr->pack, &writerPtr->record,
+                                                    numFields));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a text string field in the current CBOR record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CborAddString
+(
+    Writer_t* writerPtr,
+    Field_t field,
+    const char* strPtr,
+    size_t len
+)
+{
+    CborError err = CborAddLabel(writerPtr, field);
+    err |= cbor_encode_text_string(&writerPtr->record, strPtr, len);
+
+    return ConvertCborError(err);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write an integer field in the current CBOR record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CborAddInt
+(
+    Writer_t* writerPtr,
+    Field_t field,
+    int64_t value
+)
+{
+    CborError err = CborAddLabel(writerPtr, field);
+    err |= cbor_encode_int(&writerPtr->record, value);
+
+    return ConvertCborError(err);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a number in its shortest CBOR form: integer when it has no fractional part, single
+ * precision float when no precision is lost, double precision float otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CborAddDouble
+(
+    Writer_t* writerPtr,
+    Field_t field,
+    double value
+)
+{
+    CborError err = CborAddLabel(writerPtr, field);
+
+    if ((value >= -MAX_EXACT_INTEGER_DOUBLE) && (value <= MAX_EXACT_INTEGER_DOUBLE) &&
+        (value == (double)(int64_t)value))
+    {
+        err |= cbor_encode_int(&writerPtr->record, (int64_t)value);
+    }
+    else if ((double)(float)value == value)
+    {
+        err |= cbor_encode_float(&writerPtr->record, (float)value);
+    }
+    else
+    {
+        err |= cbor_encode_double(&writerPtr->record, value);
+    }
+
+    return ConvertCborError(err);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a boolean field in the current CBOR record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CborAddBool
+(
+    Writer_t* writerPtr,
+    Field_t field,
+    bool value
+)
+{
+    CborError err = CborAddLabel(writerPtr, field);
+    err |= cbor_encode_boolean(&writerPtr->record, value);
+
+    return ConvertCborError(err);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the current CBOR record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CborEndRecord
+(
+    Writer_t* writerPtr
+)
+{
+    return ConvertCborError(cbor_encoder_close_container(&writerPtr->pack, &writerPtr->record));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the CBOR pack and return the encoded length
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CborEndPack
+(
+    Writer_t* writerPtr,
+    size_t* lenPtr
+)
+{
+    le_result_t result = ConvertCborError(cbor_encoder_close_container(&writerPtr->stream,
+                                                                       &writerPtr->pack));
+    if (LE_OK == result)
+    {
+        *lenPtr = cbor_encoder_get_buffer_size(&writerPtr->stream, writerPtr->bufPtr);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encoder operations of the SenML-CBOR representation
+ */
+//--------------------------------------------------------------------------------------------------
+static const Encoder_t CborSenmlEncoder =
+{
+    .startPack   = CborStartPack,
+    .startRecord = CborStartRecord,
+    .addString   = CborAddString,
+    .addInt      = CborAddInt,
+    .addDouble   = CborAddDouble,
+    .addBool     = CborAddBool,
+    .endRecord   = CborEndRecord,
+    .endPack     = CborEndPack,
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// JSON representation
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append raw bytes to the JSON output
+ *
+ * @return:
+ *      - LE_OVERFLOW if the buffer is full
+ *      - LE_OK on success
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonAppend
+(
+    Writer_t* writerPtr,
+    const char* strPtr,
+    size_t len
+)
+{
+    if ((writerPtr->bufSize - writerPtr->len) < len)
+    {
+        return LE_OVERFLOW;
+    }
+
+    memcpy(writerPtr->bufPtr + writerPtr->len, strPtr, len);
+    writerPtr->len += len;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a quoted JSON string, escaping the characters not allowed in a JSON string
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonAppendString
+(
+    Writer_t* writerPtr,
+    const char* strPtr,
+    size_t len
+)
+{
+    le_result_t result = JsonAppend(writerPtr, "\"", 1);
+    size_t i;
+
+    for (i = 0; (i < len) && (LE_OK == result); i++)
+    {
+        unsigned char c = (unsigned char)strPtr[i];
+        char escape[8];
+
+        switch (c)
+        {
+            case '"':  result = JsonAppend(writerPtr, "\\\"", 2); break;
+            case '\\': result = JsonAppend(writerPtr, "\\\\", 2); break;
+            case '\b': result = JsonAppend(writerPtr, "\\b", 2);  break;
+            case '\f': result = JsonAppend(writerPtr, "\\f", 2);  break;
+            case '\n': result = JsonAppend(writerPtr, "\\n", 2);  break;
+            case '\r': result = JsonAppend(writerPtr, "\\r", 2);  break;
+            case '\t': result = JsonAppend(writerPtr, "\\t", 2);  break;
+            default:
+                if (c < 0x20)
+                {
+                    snprintf(escape, sizeof(escape), "\\u%04x", c);
+                    result = JsonAppend(writerPtr, escape, 6);
+                }
+                else
+                {
+                    result = JsonAppend(writerPtr, (const char*)&strPtr[i], 1);
+                }
+                break;
+        }
+    }
+
+    if (LE_OK == result)
+    {
+        result = JsonAppend(writerPtr, "\"", 1);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append the separator if needed and the label of a field
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonAppendLabel
+(
+    Writer_t* writerPtr,
+    Field_t field
+)
+{
+    le_result_t result = LE_OK;
+
+    if (!writerPtr->isFirstItem)
+    {
+        result = JsonAppend(writerPtr, ",", 1);
+    }
+    writerPtr->isFirstItem = false;
+
+    if (LE_OK == result)
+    {
+        result = JsonAppendString(writerPtr, Labels[field].jsonLabel,
+                                  strlen(Labels[field].jsonLabel));
+    }
+
+    if (LE_OK == result)
+    {
+        result = JsonAppend(writerPtr, ":", 1);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a JSON pack, i.e. an array of records
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonStartPack
+(
+    Writer_t* writerPtr,
+    size_t numRecords
+)
+{
+    writerPtr->len = 0;
+    writerPtr->isFirstItem = true;
+
+    return JsonAppend(writerPtr, "[", 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a JSON record, i.e. an object of fields
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonStartRecord
+(
+    Writer_t* writerPtr,
+    size_t numFields
+)
+{
+    le_result_t result = LE_OK;
+
+    if (!writerPtr->isFirstItem)
+    {
+        result = JsonAppend(writerPtr, ",", 1);
+    }
+    writerPtr->isFirstItem = true;
+
+    if (LE_OK == result)
+    {
+        result = JsonAppend(writerPtr, "{", 1);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a string field in the current JSON record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonAddString
+(
+    Writer_t* writerPtr,
+    Field_t field,
+    const char* strPtr,
+    size_t len
+)
+{
+    le_result_t result = JsonAppendLabel(writerPtr, field);
+
+    if (LE_OK == result)
+    {
+        result = JsonAppendString(writerPtr, strPtr, len);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write an integer field in the current JSON record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonAddInt
+(
+    Writer_t* writerPtr,
+    Field_t field,
+    int64_t value
+)
+{
+    char number[JSON_NUMBER_BYTES];
+    int len = snprintf(number, sizeof(number), "%" PRId64, value);
+    le_result_t result = JsonAppendLabel(writerPtr, field);
+
+    if (LE_OK == result)
+    {
+        result = JsonAppend(writerPtr, number, len);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a number with the fewest digits which still read back to the same value. JSON has no
+ * representation for infinity and NaN.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonAddDouble
+(
+    Writer_t* writerPtr,
+    Field_t field,
+    double value
+)
+{
+    char number[JSON_NUMBER_BYTES];
+    int len = 0;
+    int precision;
+
+    if (!isfinite(value))
+    {
+        LE_ERROR("Number %f cannot be represented in JSON", value);
+        return LE_BAD_PARAMETER;
+    }
+
+    for (precision = 1; precision <= MAX_DOUBLE_DIGITS; precision++)
+    {
+        len = snprintf(number, sizeof(number), "%.*g", precision, value);
+        if (strtod(number, NULL) == value)
+        {
+            break;
+        }
+    }
+
+    le_result_t result = JsonAppendLabel(writerPtr, field);
+
+    if (LE_OK == result)
+    {
+        result = JsonAppend(writerPtr, number, len);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a boolean field in the current JSON record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonAddBool
+(
+    Writer_t* writerPtr,
+    Field_t field,
+    bool value
+)
+{
+    le_result_t result = JsonAppendLabel(writerPtr, field);
+
+    if (LE_OK == result)
+    {
+        result = value ? JsonAppend(writerPtr, "true", 4) : JsonAppend(writerPtr, "false", 5);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the current JSON record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonEndRecord
+(
+    Writer_t* writerPtr
+)
+{
+    writerPtr->isFirstItem = false;
+
+    return JsonAppend(writerPtr, "}", 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the JSON pack and return the encoded length
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t JsonEndPack
+(
+    Writer_t* writerPtr,
+    size_t* lenPtr
+)
+{
+    le_result_t result = JsonAppend(writerPtr, "]", 1);
+
+    if (LE_OK == result)
+    {
+        *lenPtr = writerPtr->len;
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encoder operations of the SenML-JSON representation
+ */
+//--------------------------------------------------------------------------------------------------
+static const Encoder_t JsonSenmlEncoder =
+{
+    .startPack   = JsonStartPack,
+    .startRecord = JsonStartRecord,
+    .addString   = JsonAddString,
+    .addInt      = JsonAddInt,
+    .addDouble   = JsonAddDouble,
+    .addBool     = JsonAddBool,
+    .endRecord   = JsonEndRecord,
+    .endPack     = JsonEndPack,
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// Representation independent encoding
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encoder operations of each SenML representation
+ */
+//--------------------------------------------------------------------------------------------------
+static const Encoder_t* Encoders[SENML_FORMAT_MAX] =
+{
+    [SENML_FORMAT_CBOR] = &CborSenmlEncoder,
+    [SENML_FORMAT_JSON] = &JsonSenmlEncoder,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP content format of each SenML representation
+ */
+//--------------------------------------------------------------------------------------------------
+static const uint16_t ContentFormats[SENML_FORMAT_MAX] =
+{
+    [SENML_FORMAT_CBOR] = SENML_CONTENT_FORMAT_CBOR,
+    [SENML_FORMAT_JSON] = SENML_CONTENT_FORMAT_JSON,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a record carries a numeric value
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsNumeric
+(
+    const senml_Record_t* recordPtr
+)
+{
+    return (0 == recordPtr->errorCode) &&
+           ((SENML_VALUE_INT == recordPtr->type) || (SENML_VALUE_FLOAT == recordPtr->type));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the base fields factoring the records.
+ *
+ * The base name is the longest common prefix ending with a path delimiter, so the record names
+ * stay meaningful path segments. The base time is the oldest timestamp, and is only used when all
+ * the records are timestamped. The base value is the smallest numeric value, and is only used when
+ * there are several numeric values which are all integers, to avoid floating point rounding.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ComputeBase
+(
+    const senml_Record_t* recordArr,
+    size_t numRecords,
+    Base_t* basePtr
+)
+{
+    size_t numNumeric = 0;
+    bool isIntOnly = true;
+    size_t prefixLen = strlen(recordArr[0].name);
+    size_t i;
+
+    memset(basePtr, 0, sizeof(Base_t));
+    basePtr->hasTime = true;
+    basePtr->time = UINT64_MAX;
+    basePtr->value = INT64_MAX;
+
+    for (i = 0; i < numRecords; i++)
+    {
+        const senml_Record_t* recordPtr = &recordArr[i];
+        size_t j = 0;
+
+        while ((j < prefixLen) && (recordPtr->name[j] == recordArr[0].name[j]))
+        {
+            j++;
+        }
+        prefixLen = j;
+
+        if (0 == recordPtr->timestamp)
+        {
+            basePtr->hasTime = false;
+        }
+        else if (recordPtr->timestamp < basePtr->time)
+        {
+            basePtr->time = recordPtr->timestamp;
+        }
+
+        if (IsNumeric(recordPtr))
+        {
+            numNumeric++;
+            if (SENML_VALUE_INT != recordPtr->type)
+            {
+                isIntOnly = false;
+            }
+            else if (recordPtr->value.intValue < basePtr->value)
+            {
+                basePtr->value = recordPtr->value.intValue;
+            }
+        }
+    }
+
+    while ((prefixLen > 0) && ('/' != recordArr[0].name[prefixLen - 1]))
+    {
+        prefixLen--;
+    }
+
+    // Every record keeps a name, and a base name of "/" is not worth it.
+    for (i = 0; (i < numRecords) && (prefixLen > 1); i++)
+    {
+        if (strlen(recordArr[i].name) == prefixLen)
+        {
+            prefixLen = 0;
+        }
+    }
+    basePtr->nameLen = (prefixLen > 1) ? prefixLen : 0;
+
+    basePtr->hasValue = (numNumeric > 1) && isIntOnly;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a time field, in seconds as required by SenML. Whole seconds are written as integers.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddTime
+(
+    const Encoder_t* encoderPtr,
+    Writer_t* writerPtr,
+    Field_t field,
+    uint64_t timeMs
+)
+{
+    if (0 == (timeMs % 1000))
+    {
+        return encoderPtr->addInt(writerPtr, field, (int64_t)(timeMs / 1000));
+    }
+
+    return encoderPtr->addDouble(writerPtr, field, (double)timeMs / 1000.0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the value field of a record
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddValue
+(
+    const Encoder_t* encoderPtr,
+    Writer_t* writerPtr,
+    const senml_Record_t* recordPtr,
+    const Base_t* basePtr
+)
+{
+    if (0 != recordPtr->errorCode)
+    {
+        return encoderPtr->addInt(writerPtr, FIELD_ERROR, recordPtr->errorCode);
+    }
+
+    switch (recordPtr->type)
+    {
+        case SENML_VALUE_INT:
+            return encoderPtr->addInt(writerPtr, FIELD_VALUE, (int64_t)recordPtr->value.intValue -
+                                      (basePtr->hasValue ? basePtr->value : 0));
+
+        case SENML_VALUE_FLOAT:
+            return encoderPtr->addDouble(writerPtr, FIELD_VALUE, recordPtr->value.floatValue);
+
+        case SENML_VALUE_BOOL:
+            return encoderPtr->addBool(writerPtr, FIELD_BOOL_VALUE, recordPtr->value.boolValue);
+
+        case SENML_VALUE_STRING:
+            if (NULL == recordPtr->value.strValuePtr)
+            {
+                return LE_BAD_PARAMETER;
+            }
+            return encoderPtr->addString(writerPtr, FIELD_STRING_VALUE,
+                                         recordPtr->value.strValuePtr,
+                                         strlen(recordPtr->value.strValuePtr));
+
+        case SENML_VALUE_NONE:
+            return encoderPtr->addString(writerPtr, FIELD_STRING_VALUE, NULL_VALUE_STRING,
+                                         strlen(NULL_VALUE_STRING));
+
+        default:
+            return LE_BAD_PARAMETER;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write one record of the pack, with the base fields if this is the first one
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t EncodeRecord
+(
+    const Encoder_t* encoderPtr,
+    Writer_t* writerPtr,
+    const senml_Record_t* recordPtr,
+    const Base_t* basePtr,
+    bool isFirst
+)
+{
+    bool hasTime = (0 != recordPtr->timestamp) &&
+                   ((!basePtr->hasTime) || (recordPtr->timestamp != basePtr->time));
+    size_t numFields = 2 + (hasTime ? 1 : 0);
+    le_result_t result;
+
+    if (isFirst)
+    {
+        numFields += ((0 != basePtr->nameLen) ? 1 : 0) + (basePtr->hasTime ? 1 : 0) +
+                     (basePtr->hasValue ? 1 : 0);
+    }
+
+    result = encoderPtr->startRecord(writerPtr, numFields);
+
+    if ((LE_OK == result) && isFirst && (0 != basePtr->nameLen))
+    {
+        result = encoderPtr->addString(writerPtr, FIELD_BASE_NAME, recordPtr->name,
+                                       basePtr->nameLen);
+    }
+    if ((LE_OK == result) && isFirst && basePtr->hasTime)
+    {
+        result = AddTime(encoderPtr, writerPtr, FIELD_BASE_TIME, basePtr->time);
+    }
+    if ((LE_OK == result) && isFirst && basePtr->hasValue)
+    {
+        result = encoderPtr->addInt(writerPtr, FIELD_BASE_VALUE, basePtr->value);
+    }
+    if (LE_OK == result)
+    {
+        result = encoderPtr->addString(writerPtr, FIELD_NAME, recordPtr->name + basePtr->nameLen,
+                                       strlen(recordPtr->name) - basePtr->nameLen);
+    }
+    if ((LE_OK == result) && hasTime)
+    {
+        result = AddTime(encoderPtr, writerPtr, FIELD_TIME,
+                         recordPtr->timestamp - (basePtr->hasTime ? basePtr->time : 0));
+    }
+    if (LE_OK == result)
+    {
+        result = AddValue(encoderPtr, writerPtr, recordPtr, basePtr);
+    }
+    if (LE_OK == result)
+    {
+        result = encoderPtr->endRecord(writerPtr);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Interface functions
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a list of records as a SenML pack.
+ *
+ * @return:
+ *      - LE_OK on success, lenPtr is set to the encoded length
+ *      - LE_BAD_PARAMETER if a parameter or a record is invalid
+ *      - LE_OVERFLOW if the buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t senml_EncodePack
+(
+    senml_Format_t format,              ///< [IN] SenML representation
+    const senml_Record_t* recordArr,    ///< [IN] Records to encode
+    size_t numRecords,                  ///< [IN] Number of records
+    bool isFactored,                    ///< [IN] Use base fields to factor the records
+    uint8_t* bufPtr,                    ///< [OUT] Encoded pack
+    size_t* lenPtr                      ///< [IN/OUT] Buffer size / encoded length
+)
+{
+    Writer_t writer;
+    Base_t base;
+    size_t i;
+
+    if ((format >= SENML_FORMAT_MAX) || (NULL == bufPtr) || (NULL == lenPtr) ||
+        ((NULL == recordArr) && (0 != numRecords)))
+    {
+        LE_ERROR("Invalid parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    for (i = 0; i < numRecords; i++)
+    {
+        if (NULL == recordArr[i].name)
+        {
+            LE_ERROR("Record %zu has no name", i);
+            return LE_BAD_PARAMETER;
+        }
+    }
+
+    memset(&writer, 0, sizeof(writer));
+    writer.bufPtr = bufPtr;
+    writer.bufSize = *lenPtr;
+
+    memset(&base, 0, sizeof(base));
+    if (isFactored && (numRecords > 0))
+    {
+        ComputeBase(recordArr, numRecords, &base);
+    }
+
+    const Encoder_t* encoderPtr = Encoders[format];
+    le_result_t result = encoderPtr->startPack(&writer, numRecords);
+
+    for (i = 0; (i < numRecords) && (LE_OK == result); i++)
+    {
+        result = EncodeRecord(encoderPtr, &writer, &recordArr[i], &base, (0 == i));
+    }
+
+    if (LE_OK == result)
+    {
+        result = encoderPtr->endPack(&writer, lenPtr);
+    }
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to encode %zu SenML records: %s", numRecords, LE_RESULT_TXT(result));
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the CoAP content format of a SenML representation.
+ *
+ * @return:
+ *      - CoAP content format
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t senml_GetContentFormat
+(
+    senml_Format_t format               ///< [IN] SenML representation
+)
+{
+    LE_ASSERT(format < SENML_FORMAT_MAX);
+
+    return ContentFormats[format];
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the SenML representation matching a CoAP content format.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NOT_FOUND if the content format is not a SenML one
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t senml_GetFormat
+(
+    uint16_t contentFormat,             ///< [IN] CoAP content format
+    senml_Format_t* formatPtr           ///< [OUT] SenML representation
+)
+{
+    senml_Format_t format;
+
+    for (format = 0; format < SENML_FORMAT_MAX; format++)
+    {
+        if (ContentFormats[format] == contentFormat)
+        {
+            *formatPtr = format;
+            return LE_OK;
+        }
+    }
+
+    return LE_NOT_FOUND;
+}
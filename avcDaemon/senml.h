@@ -0,0 +1,149 @@
+/**
+ * @file senml.h
+ *
+ * Interface of the SenML (RFC 8428) encoder. The same list of records can be encoded in
+ * SenML-CBOR or SenML-JSON, with base name, base time and base value factoring.
+ *
+ * <hr>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef LEGATO_SENML_INCLUDE_GUARD
+#define LEGATO_SENML_INCLUDE_GUARD
+
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+// Definitions.
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP content formats registered for SenML (RFC 8428)
+ */
+//--------------------------------------------------------------------------------------------------
+#define SENML_CONTENT_FORMAT_JSON   110
+#define SENML_CONTENT_FORMAT_CBOR   112
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SenML CBOR label of the record name
+ */
+//--------------------------------------------------------------------------------------------------
+#define SENML_CBOR_LABEL_NAME       0
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SenML representations
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    SENML_FORMAT_CBOR,              ///< SenML-CBOR, content format 112
+    SENML_FORMAT_JSON,              ///< SenML-JSON, content format 110
+    SENML_FORMAT_MAX
+}
+senml_Format_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Type of the value held by a SenML record
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    SENML_VALUE_NONE,               ///< No value, encoded as the "(null)" string value
+    SENML_VALUE_INT,                ///< Numeric value "v", integer
+    SENML_VALUE_FLOAT,              ///< Numeric value "v", floating point
+    SENML_VALUE_BOOL,               ///< Boolean value "vb"
+    SENML_VALUE_STRING              ///< String value "vs"
+}
+senml_ValueType_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SenML record to encode.
+ *
+ * When errorCode is not 0, the record carries the "err" extension field with this code instead of
+ * a value.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char*       name;         ///< Full name of the record, i.e. the asset data path
+    uint64_t          timestamp;    ///< Time in milliseconds since epoch, 0 if not timestamped
+    senml_ValueType_t type;         ///< Type of the value
+    union
+    {
+        int32_t     intValue;
+        double      floatValue;
+        bool        boolValue;
+        const char* strValuePtr;
+    }
+    value;                          ///< Value of the record
+    uint16_t          errorCode;    ///< CoAP error code of the record, 0 if none
+}
+senml_Record_t;
+
+
+//--------------------------------------------------------------------------------------------------
+// Interface functions
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a list of records as a SenML pack.
+ *
+ * With factoring, the first record holds the base name (common path prefix), the base time (when
+ * all the records are timestamped) and the base value (when all the numeric values are integers),
+ * and the following records only hold what differs from them.
+ *
+ * @return:
+ *      - LE_OK on success, lenPtr is set to the encoded length
+ *      - LE_BAD_PARAMETER if a parameter or a record is invalid
+ *      - LE_OVERFLOW if the buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t senml_EncodePack
+(
+    senml_Format_t format,              ///< [IN] SenML representation
+    const senml_Record_t* recordArr,    ///< [IN] Records to encode
+    size_t numRecords,                  ///< [IN] Number of records
+    bool isFactored,                    ///< [IN] Use base fields to factor the records
+    uint8_t* bufPtr,                    ///< [OUT] Encoded pack
+    size_t* lenPtr                      ///< [IN/OUT] Buffer size / encoded length
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the CoAP content format of a SenML representation.
+ *
+ * @return:
+ *      - CoAP content format
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED uint16_t senml_GetContentFormat
+(
+    senml_Format_t format               ///< [IN] SenML representation
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the SenML representation matching a CoAP content format.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NOT_FOUND if the content format is not a SenML one
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t senml_GetFormat
+(
+    uint16_t contentFormat,             ///< [IN] CoAP content format
+    senml_Format_t* formatPtr           ///< [OUT] SenML representation
+);
+
+#endif // LEGATO_SENML_INCLUDE_GUARD
@@ -13,11 +13,31 @@
 #include "limit.h"
 #include "timeseriesData.h"
 #include "push.h"
+#include "senml.h"
 #include "le_print.h"
 
 #include "cbor.h"
 #include "zlib.h"
 
+#include <math.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Smallest size of a factored SenML record: map header, name label, one character name, value
+ * label and one byte value.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SENML_MIN_RECORD_NUMBYTES 6
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of samples of a record pushed in SenML. More samples cannot fit in the buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SENML_MAX_RECORDS (MAX_CBOR_BUFFER_NUMBYTES / SENML_MIN_RECORD_NUMBYTES)
+
+
 //--------------------------------------------------------------------------------------------------
 /**
 * Record data pool.  Initialized in timeSeries_Init().
@@ -66,6 +86,30 @@ static le_mem_PoolRef_t StringValuePoolRef = NULL;
 static le_mem_PoolRef_t CborBufferPoolRef = NULL;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregated resource pool.  Initialized in timeSeries_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t AggregationDataPoolRef = NULL;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Filtered resource pool.  Initialized in timeSeries_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t FilterDataPoolRef = NULL;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Sample iterator pool.  Initialized in timeSeries_Init().
+*/
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t IteratorDataPoolRef = NULL;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
 * Supported data types.  TODO: Share with asset data
@@ -91,6 +135,8 @@ typedef struct le_avdata_Record
 {
     le_dls_List_t timestampList;    ///< List of timestamps for this record
     le_dls_List_t resourceList;     ///< List of resources for this record
+    le_dls_List_t aggregationList;  ///< List of aggregated resources for this record
+    le_dls_List_t filterList;       ///< List of filtered resources for this record
 
     uint8_t* bufferPtr;             ///< Buffer for accumulating history data.
     size_t bufferSize;              ///< Buffer size of history data.
@@ -102,6 +148,13 @@ typedef struct le_avdata_Record
     CborEncoder factorArray;        ///< CBOR encoded factor reference
     CborEncoder sampleArray;        ///< CBOR encoded sample data reference.
 
+    timeSeries_Format_t format;     ///< Encoding used to push the record
+    size_t encodedSize;             ///< Size of the SenML encoded data
+    size_t maxEncodedSize;          ///< Maximum size of the encoded data, e.g. for a quota
+
+    uint32_t generation;            ///< Incremented when samples are removed, for the iterators
+    uint32_t nextResourceId;        ///< Identifier of the next created resource
+
     bool isEncoded;
 }
 RecordData_t;
@@ -133,11 +186,67 @@ typedef struct
     double factor;                          ///< Factor of data
     int32_t lastIntValue;                   ///< Last recorded int value
     double lastFloatValue;                  ///< Last recorded float value
+    uint32_t id;                            ///< Creation order of the resource in the record
     le_dls_Link_t link;                     ///< For adding to the resource list
 }
 ResourceData_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+* Resource of a timeseries record whose samples are aggregated over windows
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char name[LE_AVDATA_PATH_NAME_BYTES];   ///< The name of the aggregated resource
+    DataType_t type;                        ///< Type of the samples, none until the first one
+    aggregation_Config_t config;            ///< Window configuration
+    aggregation_Ref_t windowRef;            ///< Running statistics of the open window
+    le_dls_Link_t link;                     ///< For adding to the aggregation list
+}
+AggregationData_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Resource of a timeseries record whose samples are filtered, with its last recorded sample
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char name[LE_AVDATA_PATH_NAME_BYTES];   ///< The name of the filtered resource
+    timeSeries_Filter_t config;             ///< Filter configuration
+    bool hasLastValue;                      ///< A sample has been recorded
+    uint64_t lastTimestamp;                 ///< Time of the last recorded sample
+    double lastNumValue;                    ///< Last recorded numeric or boolean value
+    char* lastStrValuePtr;                  ///< Last recorded string value, NULL if none
+    le_dls_Link_t link;                     ///< For adding to the filter list
+}
+FilterData_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Names of the child resources holding the aggregated statistics. The quantile name is built from
+* the configured quantile.
+*/
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    aggregation_Stat_t stat;
+    const char* namePtr;
+}
+AggregatedResourceNames[] =
+{
+    { AGGREGATION_STAT_MIN,   "min"   },
+    { AGGREGATION_STAT_MAX,   "max"   },
+    { AGGREGATION_STAT_MEAN,  "mean"  },
+    { AGGREGATION_STAT_COUNT, "count" },
+    { AGGREGATION_STAT_LAST,  "last"  },
+};
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Supported data types
@@ -158,6 +267,29 @@ typedef struct
 Data_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+* Iterator over the samples of a timeseries record. The current sample is kept by value, to find
+* the position again when samples were removed from the record.
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct timeSeries_Iterator
+{
+    timeSeries_RecordRef_t recRef;          ///< Iterated record, referenced by the iterator
+    char path[LE_AVDATA_PATH_NAME_BYTES];   ///< Resource or parent path filter, empty if none
+    uint64_t startTime;                     ///< Timestamp of the first samples
+    uint64_t endTime;                       ///< Timestamp of the last samples
+    bool hasSample;                         ///< A sample has been returned
+    uint64_t timestamp;                     ///< Timestamp of the current sample
+    uint32_t resourceId;                    ///< Resource identifier of the current sample
+    uint32_t generation;                    ///< Record generation of the pointers below
+    TimestampData_t* timestampPtr;          ///< Timestamp of the current sample, NULL if removed
+    ResourceData_t* resourcePtr;            ///< Resource of the current sample, NULL if removed
+    Data_t* dataPtr;                        ///< Current sample, NULL if removed
+}
+IteratorData_t;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get the number of unique timestamps in a timeseries record
@@ -315,40 +447,23 @@ static void AddTimestamp
         timestampPtr->timestamp = timestamp;
         timestampPtr->link = LE_DLS_LINK_INIT;
 
-        if (le_dls_IsEmpty(&recRef->timestampList))
+        le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->timestampList);
+
+        // add value before the first later timestamp, including the first one of the list
+        while ((linkPtr != NULL) &&
+               (CONTAINER_OF(linkPtr, TimestampData_t, link)->timestamp < timestamp))
         {
-            le_dls_Queue(&recRef->timestampList, &timestampPtr->link);
+            linkPtr = le_dls_PeekNext(&recRef->timestampList, linkPtr);
+        }
+
+        if (linkPtr != NULL)
+        {
+            le_dls_AddBefore(&recRef->timestampList, linkPtr, &timestampPtr->link);
         }
         else
         {
-            le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->timestampList);
-            le_dls_Link_t* nextLinkPtr = NULL;
-
-            while (linkPtr != NULL)
-            {
-                nextLinkPtr = le_dls_PeekNext(&recRef->timestampList, linkPtr);
-
-                if (nextLinkPtr != NULL)
-                {
-                    TimestampData_t* nextTimestampPtr;
-                    nextTimestampPtr = CONTAINER_OF(nextLinkPtr, TimestampData_t, link);
-
-                    // add value before next timestamp
-                    if (timestamp < nextTimestampPtr->timestamp)
-                    {
-                        le_dls_AddBefore(&recRef->timestampList, nextLinkPtr, &timestampPtr->link);
-                        break;
-                    }
-
-                    linkPtr = le_dls_PeekNext(&recRef->timestampList, linkPtr);
-                }
-                else
-                {
-                    // queue timestamp if there's not next value to compare to
-                    le_dls_Queue(&recRef->timestampList, &timestampPtr->link);
-                    break;
-                }
-            }
+            // queue timestamp if there's not later value
+            le_dls_Queue(&recRef->timestampList, &timestampPtr->link);
         }
     }
 }
@@ -468,7 +583,7 @@ static void DeleteTimestamp
         }
         else
         {
-            linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
+            linkPtr = le_dls_PeekNext(&recRef->timestampList, linkPtr);
         }
     }
 }
@@ -511,6 +626,7 @@ static void DeleteResourceData
 
                 le_mem_Release(dataPtr);
                 le_dls_Remove(&resourceDataPtr->dataList, &dataPtr->link);
+                recRef->generation++;
 
                 // Delete this resource if this is the only data entry
                 if (0 == le_dls_NumLinks(&resourceDataPtr->dataList))
@@ -568,6 +684,7 @@ static void ResetRecord
     ClearResources(recRef);
     ClearTimestamp(recRef);
     recRef->timestampFactor = 1;
+    recRef->generation++;
     recRef->isEncoded = false;
 }
 
@@ -588,6 +705,10 @@ static size_t GetEncodedDataSize
     {
         cborStreamSize = 0;
     }
+    else if (TIMESERIES_FORMAT_ZCBOR != recRef->format)
+    {
+        cborStreamSize = recRef->encodedSize;
+    }
     else
     {
         cborStreamSize = cbor_encoder_get_buffer_size(&recRef->streamRef, recRef->bufferPtr);
@@ -878,6 +999,127 @@ static le_result_t EncodeResourceDataToCborArray
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the SenML representation of a record format
+ */
+//--------------------------------------------------------------------------------------------------
+static senml_Format_t GetSenmlFormat
+(
+    timeSeries_Format_t format
+)
+{
+    return (TIMESERIES_FORMAT_SENML_JSON == format) ? SENML_FORMAT_JSON : SENML_FORMAT_CBOR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the data accumulated as a SenML pack, with one SenML record per sample. Samples are
+ * ordered by timestamp, then by resource, and factored with the SenML base fields.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if buffer is full
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t EncodeSenml
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    size_t numRecords = 0;
+    le_dls_Link_t* rdLinkPtr = le_dls_Peek(&recRef->resourceList);
+    ResourceData_t* resourceDataPtr;
+
+    while (rdLinkPtr != NULL)
+    {
+        resourceDataPtr = CONTAINER_OF(rdLinkPtr, ResourceData_t, link);
+        numRecords += le_dls_NumLinks(&resourceDataPtr->dataList);
+        rdLinkPtr = le_dls_PeekNext(&recRef->resourceList, rdLinkPtr);
+    }
+
+    if (numRecords > SENML_MAX_RECORDS)
+    {
+        return LE_NO_MEMORY;
+    }
+
+    senml_Record_t recordArr[(numRecords > 0) ? numRecords : 1];
+    size_t recordIdx = 0;
+    le_dls_Link_t* tsLinkPtr = le_dls_Peek(&recRef->timestampList);
+
+    while ((tsLinkPtr != NULL) && (recordIdx < numRecords))
+    {
+        TimestampData_t* timestampPtr = CONTAINER_OF(tsLinkPtr, TimestampData_t, link);
+
+        rdLinkPtr = le_dls_Peek(&recRef->resourceList);
+        while ((rdLinkPtr != NULL) && (recordIdx < numRecords))
+        {
+            resourceDataPtr = CONTAINER_OF(rdLinkPtr, ResourceData_t, link);
+            Data_t* dataPtr = GetTimestampData(resourceDataPtr, timestampPtr->timestamp);
+
+            if (dataPtr != NULL)
+            {
+                senml_Record_t* recordPtr = &recordArr[recordIdx++];
+
+                memset(recordPtr, 0, sizeof(senml_Record_t));
+                recordPtr->name = resourceDataPtr->name;
+                recordPtr->timestamp = dataPtr->timestamp;
+
+                switch (resourceDataPtr->type)
+                {
+                    case DATA_TYPE_INT:
+                        recordPtr->type = SENML_VALUE_INT;
+                        recordPtr->value.intValue = dataPtr->intValue;
+                        break;
+
+                    case DATA_TYPE_FLOAT:
+                        recordPtr->type = SENML_VALUE_FLOAT;
+                        recordPtr->value.floatValue = dataPtr->floatValue;
+                        break;
+
+                    case DATA_TYPE_BOOL:
+                        recordPtr->type = SENML_VALUE_BOOL;
+                        recordPtr->value.boolValue = dataPtr->boolValue;
+                        break;
+
+                    case DATA_TYPE_STRING:
+                        recordPtr->type = SENML_VALUE_STRING;
+                        recordPtr->value.strValuePtr = dataPtr->strValuePtr;
+                        break;
+
+                    default:
+                        recordPtr->type = SENML_VALUE_NONE;
+                        break;
+                }
+            }
+
+            rdLinkPtr = le_dls_PeekNext(&recRef->resourceList, rdLinkPtr);
+        }
+
+        tsLinkPtr = le_dls_PeekNext(&recRef->timestampList, tsLinkPtr);
+    }
+
+    size_t len = recRef->bufferSize;
+    le_result_t result = senml_EncodePack(GetSenmlFormat(recRef->format), recordArr, recordIdx,
+                                          true, recRef->bufferPtr, &len);
+
+    switch (result)
+    {
+        case LE_OK:
+            recRef->encodedSize = len;
+            return LE_OK;
+
+        case LE_OVERFLOW:
+            return LE_NO_MEMORY;
+
+        default:
+            return LE_FAULT;
+    }
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Encode the data accumulated
@@ -897,7 +1139,17 @@ static le_result_t Encode
     le_result_t result = LE_OK;
 
     // only encode if it hasn't been encoded
-    if (false == recRef->isEncoded)
+    if ((false == recRef->isEncoded) && (TIMESERIES_FORMAT_ZCBOR != recRef->format))
+    {
+        result = EncodeSenml(recRef);
+        if (result != LE_OK)
+        {
+            return result;
+        }
+
+        recRef->isEncoded = true;
+    }
+    else if (false == recRef->isEncoded)
     {
         // clear buffer
         memset(recRef->bufferPtr, 0, recRef->bufferSize);
@@ -991,6 +1243,15 @@ static le_result_t Encode
         recRef->isEncoded = true;
     }
 
+    // The size limit is handled as a full buffer: the data just added is removed by the caller
+    if (GetEncodedDataSize(recRef) > recRef->maxEncodedSize)
+    {
+        LE_DEBUG("Encoded size %zd over the limit %zd",
+                 GetEncodedDataSize(recRef), recRef->maxEncodedSize);
+        recRef->isEncoded = false;
+        return LE_NO_MEMORY;
+    }
+
     LE_DEBUG("Encoded size: %zd", GetEncodedDataSize(recRef));
     LE_DUMP(recRef->bufferPtr, GetEncodedDataSize(recRef));
 
@@ -998,6 +1259,28 @@ static le_result_t Encode
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop aggregating all the resources of a record
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearAggregations
+(
+    timeSeries_RecordRef_t recRef
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the filters of all the resources of a record
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearFilters
+(
+    timeSeries_RecordRef_t recRef
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Create a timeseries record
@@ -1017,9 +1300,16 @@ le_result_t timeSeries_Create
     recordDataPtr = le_mem_ForceAlloc(RecordDataPoolRef);
     recordDataPtr->timestampList = LE_DLS_LIST_INIT;
     recordDataPtr->resourceList = LE_DLS_LIST_INIT;
+    recordDataPtr->aggregationList = LE_DLS_LIST_INIT;
+    recordDataPtr->filterList = LE_DLS_LIST_INIT;
     recordDataPtr->bufferPtr = le_mem_ForceAlloc(CborBufferPoolRef);
     recordDataPtr->bufferSize = MAX_CBOR_BUFFER_NUMBYTES;
     recordDataPtr->timestampFactor = 1;
+    recordDataPtr->format = TIMESERIES_FORMAT_ZCBOR;
+    recordDataPtr->encodedSize = 0;
+    recordDataPtr->maxEncodedSize = SIZE_MAX;
+    recordDataPtr->generation = 0;
+    recordDataPtr->nextResourceId = 0;
     recordDataPtr->isEncoded = false;
     *recRefPtr = recordDataPtr;
 
@@ -1038,11 +1328,96 @@ void timeSeries_Delete
 )
 {
     ResetRecord(recRef);
+    ClearAggregations(recRef);
+    ClearFilters(recRef);
     le_mem_Release(recRef->bufferPtr);
     le_mem_Release(recRef);
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the encoding used to push a record. The data already accumulated is re-encoded.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the format is invalid
+ *      - LE_NO_MEMORY if the accumulated data does not fit in this encoding, the format is unchanged
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_SetFormat
+(
+    timeSeries_RecordRef_t recRef,
+    timeSeries_Format_t format
+)
+{
+    le_result_t result;
+    timeSeries_Format_t previousFormat = recRef->format;
+
+    if ((TIMESERIES_FORMAT_ZCBOR != format) &&
+        (TIMESERIES_FORMAT_SENML_CBOR != format) &&
+        (TIMESERIES_FORMAT_SENML_JSON != format))
+    {
+        LE_ERROR("Invalid record format %d", format);
+        return LE_BAD_PARAMETER;
+    }
+
+    recRef->format = format;
+    recRef->isEncoded = false;
+    result = Encode(recRef);
+
+    // keep the previous encoding if the accumulated data does not fit in the new one
+    if (result != LE_OK)
+    {
+        LE_ERROR("Cannot encode record in format %d: %s", format, LE_RESULT_TXT(result));
+        recRef->format = previousFormat;
+        recRef->isEncoded = false;
+        Encode(recRef);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Limit the size of the data accumulated in a record, once encoded and before compression. The
+ * data which would exceed the limit is rejected as if the record buffer was full.
+ */
+//--------------------------------------------------------------------------------------------------
+void timeSeries_SetSizeLimit
+(
+    timeSeries_RecordRef_t recRef,
+    size_t maxSize
+)
+{
+    recRef->maxEncodedSize = maxSize;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the size of the data accumulated in a record, once encoded and before compression
+ *
+ * @return:
+ *      - Encoded size in bytes
+ */
+//--------------------------------------------------------------------------------------------------
+size_t timeSeries_GetEncodedSize
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    if (Encode(recRef) != LE_OK)
+    {
+        return 0;
+    }
+
+    return GetEncodedDataSize(recRef);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get the specified resource from the given record
@@ -1120,6 +1495,7 @@ static le_result_t CreateResourceData
     }
 
     resourceDataPtr->type = type;
+    resourceDataPtr->id = recRef->nextResourceId++;
     resourceDataPtr->dataList = LE_DLS_LIST_INIT;
     resourceDataPtr->link = LE_DLS_LINK_INIT;
 
@@ -1328,26 +1704,636 @@ static le_result_t AddStringResourceData
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add the integer value for the specified resource
+ * Get the aggregation configured on a resource
  *
  * @return:
- *      - LE_OK on success
- *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
- *      - LE_FAULT on any other error
+ *      - Aggregated resource
+ *      - NULL if the resource is not aggregated
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t timeSeries_AddInt
+static AggregationData_t* GetAggregationData
 (
     timeSeries_RecordRef_t recRef,
-    const char* path,
-    int32_t value,
-    uint64_t timestamp
+    const char* path
 )
 {
-    le_result_t result;
-    ResourceData_t* resourceDataPtr;
+    le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->aggregationList);
 
-    result = GetResourceData(recRef, path, DATA_TYPE_INT, &resourceDataPtr);
+    while (linkPtr != NULL)
+    {
+        AggregationData_t* aggregationDataPtr = CONTAINER_OF(linkPtr, AggregationData_t, link);
+
+        if (strcmp(aggregationDataPtr->name, path) == 0)
+        {
+            return aggregationDataPtr;
+        }
+
+        linkPtr = le_dls_PeekNext(&recRef->aggregationList, linkPtr);
+    }
+
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop aggregating a resource
+ */
+//--------------------------------------------------------------------------------------------------
+static void DeleteAggregationData
+(
+    timeSeries_RecordRef_t recRef,
+    AggregationData_t* aggregationDataPtr
+)
+{
+    le_dls_Remove(&recRef->aggregationList, &aggregationDataPtr->link);
+    aggregation_Delete(aggregationDataPtr->windowRef);
+    le_mem_Release(aggregationDataPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop aggregating all the resources of a record
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearAggregations
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    le_dls_Link_t* linkPtr;
+
+    while ((linkPtr = le_dls_Peek(&recRef->aggregationList)) != NULL)
+    {
+        DeleteAggregationData(recRef, CONTAINER_OF(linkPtr, AggregationData_t, link));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the name of the child resource holding an aggregated statistic
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_OVERFLOW if the name does not fit in a resource path
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetAggregatedResourceName
+(
+    const char* path,
+    const aggregation_Config_t* configPtr,
+    aggregation_Stat_t stat,
+    char* namePtr
+)
+{
+    int len;
+    size_t i;
+
+    if (AGGREGATION_STAT_QUANTILE == stat)
+    {
+        len = snprintf(namePtr, LE_AVDATA_PATH_NAME_BYTES, "%s/p%g",
+                       path, configPtr->quantile * 100);
+    }
+    else
+    {
+        for (i = 0; i < NUM_ARRAY_MEMBERS(AggregatedResourceNames); i++)
+        {
+            if (AggregatedResourceNames[i].stat == stat)
+            {
+                break;
+            }
+        }
+        LE_ASSERT(i < NUM_ARRAY_MEMBERS(AggregatedResourceNames));
+
+        len = snprintf(namePtr, LE_AVDATA_PATH_NAME_BYTES, "%s/%s",
+                       path, AggregatedResourceNames[i].namePtr);
+    }
+
+    if ((len < 0) || (len >= LE_AVDATA_PATH_NAME_BYTES))
+    {
+        return LE_OVERFLOW;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the statistics of a closed window to the record. Minimum, maximum and last value keep the
+ * type of the samples, the count is an integer and the mean and quantile are floats.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if the time series buffer is full. The statistics already added are updated
+ *        in place if the window is added again.
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddAggregatedResult
+(
+    timeSeries_RecordRef_t recRef,
+    const AggregationData_t* aggregationDataPtr,
+    const aggregation_Result_t* resultPtr
+)
+{
+    char name[LE_AVDATA_PATH_NAME_BYTES];
+    uint32_t stat;
+    le_result_t result = LE_OK;
+
+    for (stat = AGGREGATION_STAT_MIN;
+         (stat <= AGGREGATION_STAT_QUANTILE) && (LE_OK == result);
+         stat <<= 1)
+    {
+        double value;
+        bool isInt = (DATA_TYPE_INT == aggregationDataPtr->type);
+
+        if (0 == (aggregationDataPtr->config.stats & stat))
+        {
+            continue;
+        }
+
+        switch (stat)
+        {
+            case AGGREGATION_STAT_MIN:
+                value = resultPtr->min;
+                break;
+            case AGGREGATION_STAT_MAX:
+                value = resultPtr->max;
+                break;
+            case AGGREGATION_STAT_LAST:
+                value = resultPtr->last;
+                break;
+            case AGGREGATION_STAT_COUNT:
+                value = resultPtr->count;
+                isInt = true;
+                break;
+            case AGGREGATION_STAT_MEAN:
+                value = resultPtr->mean;
+                isInt = false;
+                break;
+            default:
+                value = resultPtr->quantile;
+                isInt = false;
+                break;
+        }
+
+        result = GetAggregatedResourceName(aggregationDataPtr->name, &aggregationDataPtr->config,
+                                           stat, name);
+        if (LE_OK != result)
+        {
+            return LE_FAULT;
+        }
+
+        if (isInt)
+        {
+            result = timeSeries_AddInt(recRef, name, (int32_t)value, resultPtr->timestamp);
+        }
+        else
+        {
+            result = timeSeries_AddFloat(recRef, name, value, resultPtr->timestamp);
+        }
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add to the record the statistics of the windows of a resource closed at a given time
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if the time series buffer is full, the window is kept open
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CloseAggregationWindows
+(
+    timeSeries_RecordRef_t recRef,
+    AggregationData_t* aggregationDataPtr,
+    uint64_t timestamp
+)
+{
+    aggregation_Result_t windowResult;
+
+    while (aggregation_GetClosedWindow(aggregationDataPtr->windowRef, timestamp, &windowResult))
+    {
+        le_result_t result = AddAggregatedResult(recRef, aggregationDataPtr, &windowResult);
+
+        if (LE_OK != result)
+        {
+            return result;
+        }
+
+        aggregation_Advance(aggregationDataPtr->windowRef);
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a sample to an aggregated resource, after adding the windows it closes to the record
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
+ *      - LE_FAULT if the sample type differs from the previous ones
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddAggregatedSample
+(
+    timeSeries_RecordRef_t recRef,
+    AggregationData_t* aggregationDataPtr,
+    DataType_t type,
+    double value,
+    uint64_t timestamp
+)
+{
+    le_result_t result;
+
+    if ((DATA_TYPE_NONE != aggregationDataPtr->type) && (type != aggregationDataPtr->type))
+    {
+        LE_ERROR("Invalid type %d for aggregated resource %s", type, aggregationDataPtr->name);
+        return LE_FAULT;
+    }
+    aggregationDataPtr->type = type;
+
+    result = CloseAggregationWindows(recRef, aggregationDataPtr, timestamp);
+
+    if (LE_OK == result)
+    {
+        aggregation_Add(aggregationDataPtr->windowRef, timestamp, value);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add to the record the statistics of all the windows closed at a given time
+ */
+//--------------------------------------------------------------------------------------------------
+static void FlushAggregations
+(
+    timeSeries_RecordRef_t recRef,
+    uint64_t timestamp
+)
+{
+    le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->aggregationList);
+
+    while (linkPtr != NULL)
+    {
+        AggregationData_t* aggregationDataPtr = CONTAINER_OF(linkPtr, AggregationData_t, link);
+
+        if (CloseAggregationWindows(recRef, aggregationDataPtr, timestamp) != LE_OK)
+        {
+            LE_WARN("Aggregated windows of %s kept for the next push", aggregationDataPtr->name);
+        }
+
+        linkPtr = le_dls_PeekNext(&recRef->aggregationList, linkPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregate the samples of a resource over windows. A NULL configuration stops the aggregation;
+ * the samples of the open window are then lost.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the configuration is invalid
+ *      - LE_OVERFLOW if the path is too long for the aggregated resource names
+ *      - LE_NOT_FOUND if no aggregation is configured on the path and the configuration is NULL
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_SetAggregation
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    const aggregation_Config_t* configPtr
+)
+{
+    char name[LE_AVDATA_PATH_NAME_BYTES];
+    uint32_t stat;
+    AggregationData_t* aggregationDataPtr = GetAggregationData(recRef, path);
+
+    if (NULL == configPtr)
+    {
+        if (NULL == aggregationDataPtr)
+        {
+            return LE_NOT_FOUND;
+        }
+
+        DeleteAggregationData(recRef, aggregationDataPtr);
+        return LE_OK;
+    }
+
+    if (aggregation_CheckConfig(configPtr) != LE_OK)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    for (stat = AGGREGATION_STAT_MIN; stat <= AGGREGATION_STAT_QUANTILE; stat <<= 1)
+    {
+        if ((configPtr->stats & stat) &&
+            (GetAggregatedResourceName(path, configPtr, stat, name) != LE_OK))
+        {
+            LE_ERROR("Path too long for aggregated resources: %s", path);
+            return LE_OVERFLOW;
+        }
+    }
+
+    // a new configuration restarts the aggregation
+    if (NULL != aggregationDataPtr)
+    {
+        DeleteAggregationData(recRef, aggregationDataPtr);
+    }
+
+    aggregationDataPtr = le_mem_ForceAlloc(AggregationDataPoolRef);
+    LE_ASSERT(le_utf8_Copy(aggregationDataPtr->name, path, sizeof(aggregationDataPtr->name), NULL)
+              == LE_OK);
+    aggregationDataPtr->type = DATA_TYPE_NONE;
+    aggregationDataPtr->config = *configPtr;
+    aggregationDataPtr->windowRef = aggregation_Create(configPtr);
+    aggregationDataPtr->link = LE_DLS_LINK_INIT;
+    le_dls_Queue(&recRef->aggregationList, &aggregationDataPtr->link);
+
+    LE_DEBUG("Aggregating %s: window %" PRIu32 " ms, hop %" PRIu32 " ms, %zu bytes",
+             path, configPtr->windowMs, configPtr->hopMs,
+             aggregation_GetMemorySize(aggregationDataPtr->windowRef));
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the filter set on a resource
+ *
+ * @return:
+ *      - Filtered resource
+ *      - NULL if the resource is not filtered
+ */
+//--------------------------------------------------------------------------------------------------
+static FilterData_t* GetFilterData
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path
+)
+{
+    le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->filterList);
+
+    while (linkPtr != NULL)
+    {
+        FilterData_t* filterDataPtr = CONTAINER_OF(linkPtr, FilterData_t, link);
+
+        if (strcmp(filterDataPtr->name, path) == 0)
+        {
+            return filterDataPtr;
+        }
+
+        linkPtr = le_dls_PeekNext(&recRef->filterList, linkPtr);
+    }
+
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the filter of a resource
+ */
+//--------------------------------------------------------------------------------------------------
+static void DeleteFilterData
+(
+    timeSeries_RecordRef_t recRef,
+    FilterData_t* filterDataPtr
+)
+{
+    le_dls_Remove(&recRef->filterList, &filterDataPtr->link);
+
+    if (filterDataPtr->lastStrValuePtr != NULL)
+    {
+        le_mem_Release(filterDataPtr->lastStrValuePtr);
+    }
+    le_mem_Release(filterDataPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the filters of all the resources of a record
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearFilters
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    le_dls_Link_t* linkPtr;
+
+    while ((linkPtr = le_dls_Peek(&recRef->filterList)) != NULL)
+    {
+        DeleteFilterData(recRef, CONTAINER_OF(linkPtr, FilterData_t, link));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a sample passes the filter of its resource
+ *
+ * @return:
+ *      - true if the sample must be recorded
+ *      - false if it must be dropped
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSampleRecorded
+(
+    const FilterData_t* filterDataPtr,
+    DataType_t type,
+    double numValue,            ///< Numeric or boolean sample
+    const char* strValuePtr,    ///< String sample
+    uint64_t timestamp
+)
+{
+    const timeSeries_Filter_t* configPtr = &filterDataPtr->config;
+
+    if (!filterDataPtr->hasLastValue)
+    {
+        return true;
+    }
+
+    if ((configPtr->heartbeatMs != 0) && (timestamp >= filterDataPtr->lastTimestamp) &&
+        ((timestamp - filterDataPtr->lastTimestamp) >= configPtr->heartbeatMs))
+    {
+        return true;
+    }
+
+    if (type == DATA_TYPE_STRING)
+    {
+        return !(configPtr->isChangeOnly && (filterDataPtr->lastStrValuePtr != NULL) &&
+                 (strcmp(filterDataPtr->lastStrValuePtr, strValuePtr) == 0));
+    }
+
+    double delta = fabs(numValue - filterDataPtr->lastNumValue);
+
+    if (type != DATA_TYPE_BOOL)
+    {
+        double deadband = fmax(configPtr->absDeadband,
+                               fabs(filterDataPtr->lastNumValue) * configPtr->pctDeadband / 100);
+
+        if ((deadband > 0) && (delta <= deadband))
+        {
+            return false;
+        }
+    }
+
+    return !(configPtr->isChangeOnly && (delta == 0));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save a recorded sample as the reference of the filter of its resource
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetFilterLastValue
+(
+    FilterData_t* filterDataPtr,
+    double numValue,            ///< Numeric or boolean sample
+    const char* strValuePtr,    ///< String sample, NULL for other types
+    uint64_t timestamp
+)
+{
+    filterDataPtr->hasLastValue = true;
+    filterDataPtr->lastTimestamp = timestamp;
+    filterDataPtr->lastNumValue = numValue;
+
+    if (strValuePtr != NULL)
+    {
+        if (filterDataPtr->lastStrValuePtr == NULL)
+        {
+            filterDataPtr->lastStrValuePtr = le_mem_ForceAlloc(StringValuePoolRef);
+        }
+        le_utf8_Copy(filterDataPtr->lastStrValuePtr, strValuePtr, LE_AVDATA_STRING_VALUE_BYTES,
+                     NULL);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Filter the samples of a resource before they are added to the record. A NULL filter records all
+ * the samples again.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the filter is invalid or filters nothing
+ *      - LE_OVERFLOW if the path is too long
+ *      - LE_NOT_FOUND if no filter is set on the path and the filter is NULL
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_SetFilter
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    const timeSeries_Filter_t* filterPtr
+)
+{
+    FilterData_t* filterDataPtr = GetFilterData(recRef, path);
+
+    if (filterPtr == NULL)
+    {
+        if (filterDataPtr == NULL)
+        {
+            return LE_NOT_FOUND;
+        }
+
+        DeleteFilterData(recRef, filterDataPtr);
+        return LE_OK;
+    }
+
+    // negated comparisons also reject NaN
+    if ((!(filterPtr->absDeadband >= 0)) || (!(filterPtr->pctDeadband >= 0)) ||
+        isinf(filterPtr->absDeadband) || isinf(filterPtr->pctDeadband) ||
+        ((filterPtr->absDeadband == 0) && (filterPtr->pctDeadband == 0) &&
+         (!filterPtr->isChangeOnly)))
+    {
+        LE_ERROR("Invalid filter for %s", path);
+        return LE_BAD_PARAMETER;
+    }
+
+    if (strlen(path) >= LE_AVDATA_PATH_NAME_BYTES)
+    {
+        return LE_OVERFLOW;
+    }
+
+    // a new configuration restarts from the next sample
+    if (filterDataPtr != NULL)
+    {
+        DeleteFilterData(recRef, filterDataPtr);
+    }
+
+    filterDataPtr = le_mem_ForceAlloc(FilterDataPoolRef);
+    memset(filterDataPtr, 0, sizeof(FilterData_t));
+    le_utf8_Copy(filterDataPtr->name, path, sizeof(filterDataPtr->name), NULL);
+    filterDataPtr->config = *filterPtr;
+    filterDataPtr->hasLastValue = false;
+    filterDataPtr->lastStrValuePtr = NULL;
+    filterDataPtr->link = LE_DLS_LINK_INIT;
+    le_dls_Queue(&recRef->filterList, &filterDataPtr->link);
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the integer value for the specified resource
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_AddInt
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    int32_t value,
+    uint64_t timestamp
+)
+{
+    le_result_t result;
+    ResourceData_t* resourceDataPtr;
+    FilterData_t* filterDataPtr;
+
+    AggregationData_t* aggregationDataPtr = GetAggregationData(recRef, path);
+
+    if (aggregationDataPtr != NULL)
+    {
+        return AddAggregatedSample(recRef, aggregationDataPtr, DATA_TYPE_INT, value, timestamp);
+    }
+
+    filterDataPtr = GetFilterData(recRef, path);
+
+    if ((filterDataPtr != NULL) &&
+        (!IsSampleRecorded(filterDataPtr, DATA_TYPE_INT, value, NULL, timestamp)))
+    {
+        return LE_OK;
+    }
+
+    result = GetResourceData(recRef, path, DATA_TYPE_INT, &resourceDataPtr);
 
     // create or add resource data
     if (result != LE_FAULT)
@@ -1357,131 +2343,688 @@ le_result_t timeSeries_AddInt
         // resource data does not exists
         if (result == LE_NOT_FOUND)
         {
-            result = CreateResourceData(recRef, path, DATA_TYPE_INT);
+            result = CreateResourceData(recRef, path, DATA_TYPE_INT);
+
+            if (result != LE_OK)
+            {
+                return result;
+            }
+
+            result = GetResourceData(recRef, path, DATA_TYPE_INT, &resourceDataPtr);
+
+            // if creating it and we still cannot the resource, there is an issue
+            if (result != LE_OK)
+            {
+                return result;
+            }
+        }
+
+        result = AddIntResourceData(recRef, resourceDataPtr, value, timestamp);
+    }
+
+    if ((result == LE_OK) && (filterDataPtr != NULL))
+    {
+        SetFilterLastValue(filterDataPtr, value, NULL, timestamp);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the float value for the specified resource
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_AddFloat
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    double value,
+    uint64_t timestamp
+)
+{
+    le_result_t result;
+    ResourceData_t* resourceDataPtr;
+    FilterData_t* filterDataPtr;
+
+    AggregationData_t* aggregationDataPtr = GetAggregationData(recRef, path);
+
+    if (aggregationDataPtr != NULL)
+    {
+        return AddAggregatedSample(recRef, aggregationDataPtr, DATA_TYPE_FLOAT, value, timestamp);
+    }
+
+    filterDataPtr = GetFilterData(recRef, path);
+
+    if ((filterDataPtr != NULL) &&
+        (!IsSampleRecorded(filterDataPtr, DATA_TYPE_FLOAT, value, NULL, timestamp)))
+    {
+        return LE_OK;
+    }
+
+    result = GetResourceData(recRef, path, DATA_TYPE_FLOAT, &resourceDataPtr);
+
+    // cmust be ok or not found
+    if (result != LE_FAULT)
+    {
+        AddTimestamp(recRef, timestamp);
+
+        // resource data does not exists
+        if (result == LE_NOT_FOUND)
+        {
+            result = CreateResourceData(recRef, path, DATA_TYPE_FLOAT);
+
+            if (result != LE_OK)
+            {
+                return result;
+            }
+
+            result = GetResourceData(recRef, path, DATA_TYPE_FLOAT, &resourceDataPtr);
+
+            // if creating it and we still cannot the resource, there is an issue
+            if (result != LE_OK)
+            {
+                return result;
+            }
+        }
+
+        result = AddFloatResourceData(recRef, resourceDataPtr, value, timestamp);
+    }
+
+    if ((result == LE_OK) && (filterDataPtr != NULL))
+    {
+        SetFilterLastValue(filterDataPtr, value, NULL, timestamp);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the boolean value for the specified resource
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_AddBool
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    bool value,
+    uint64_t timestamp
+)
+{
+    le_result_t result;
+    ResourceData_t* resourceDataPtr;
+    FilterData_t* filterDataPtr;
+
+    // only numeric samples can be aggregated
+    if (GetAggregationData(recRef, path) != NULL)
+    {
+        LE_ERROR("Invalid type %d for aggregated resource %s", DATA_TYPE_BOOL, path);
+        return LE_FAULT;
+    }
+
+    filterDataPtr = GetFilterData(recRef, path);
+
+    if ((filterDataPtr != NULL) &&
+        (!IsSampleRecorded(filterDataPtr, DATA_TYPE_BOOL, value, NULL, timestamp)))
+    {
+        return LE_OK;
+    }
+
+    result = GetResourceData(recRef, path, DATA_TYPE_BOOL, &resourceDataPtr);
+
+    // cmust be ok or not found
+    if (result != LE_FAULT)
+    {
+        AddTimestamp(recRef, timestamp);
+
+        // resource data does not exists
+        if (result == LE_NOT_FOUND)
+        {
+            result = CreateResourceData(recRef, path, DATA_TYPE_BOOL);
+
+            if (result != LE_OK)
+            {
+                return result;
+            }
+
+            result = GetResourceData(recRef, path, DATA_TYPE_BOOL, &resourceDataPtr);
+
+            // if creating it and we still cannot the resource, there is an issue
+            if (result != LE_OK)
+            {
+                return result;
+            }
+        }
+
+        result = AddBoolResourceData(recRef, resourceDataPtr, value, timestamp);
+    }
+
+    if ((result == LE_OK) && (filterDataPtr != NULL))
+    {
+        SetFilterLastValue(filterDataPtr, value, NULL, timestamp);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the string value for the specified resource
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_AddString
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    const char* value,
+    uint64_t timestamp
+)
+{
+    le_result_t result;
+    ResourceData_t* resourceDataPtr;
+    FilterData_t* filterDataPtr;
+
+    // only numeric samples can be aggregated
+    if (GetAggregationData(recRef, path) != NULL)
+    {
+        LE_ERROR("Invalid type %d for aggregated resource %s", DATA_TYPE_STRING, path);
+        return LE_FAULT;
+    }
+
+    filterDataPtr = GetFilterData(recRef, path);
+
+    if ((filterDataPtr != NULL) &&
+        (!IsSampleRecorded(filterDataPtr, DATA_TYPE_STRING, 0, value, timestamp)))
+    {
+        return LE_OK;
+    }
+
+    result = GetResourceData(recRef, path, DATA_TYPE_STRING, &resourceDataPtr);
+
+    // cmust be ok or not found
+    if (result != LE_FAULT)
+    {
+        AddTimestamp(recRef, timestamp);
+
+        // resource data does not exists
+        if (result == LE_NOT_FOUND)
+        {
+            result = CreateResourceData(recRef, path, DATA_TYPE_STRING);
+
+            if (result != LE_OK)
+            {
+                return result;
+            }
+
+            result = GetResourceData(recRef, path, DATA_TYPE_STRING, &resourceDataPtr);
 
+            // if creating it and we still cannot the resource, there is an issue
             if (result != LE_OK)
             {
                 return result;
             }
+        }
+
+        result = AddStringResourceData(recRef, resourceDataPtr, value, timestamp);
+    }
+
+    if ((result == LE_OK) && (filterDataPtr != NULL))
+    {
+        SetFilterLastValue(filterDataPtr, 0, value, timestamp);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compress the accumulated time series data and send it to server.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BUSY if push service is busy. Data added to queue list for later push
+ *      - LE_OVERFLOW if data size exceeds the maximum allowed size
+ *      - LE_NO_MEMORY if push queue is full, try again later
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_PushRecord
+(
+    timeSeries_RecordRef_t recRef,
+    le_avdata_CallbackResultFunc_t handlerPtr,
+    void* contextPtr
+)
+{
+
+    le_result_t result;
+    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];
+    size_t bufferLength;
+    z_stream defstream;
+    le_clk_Time_t now = le_clk_GetAbsoluteTime();
+
+    // report the windows ended by now
+    FlushAggregations(recRef, ((uint64_t)now.sec * 1000) + (now.usec / 1000));
+
+    result = Encode(recRef);
+
+    // SenML is a standard representation, pushed as is
+    if ((result == LE_OK) && (TIMESERIES_FORMAT_ZCBOR != recRef->format))
+    {
+        result = PushBuffer(recRef->bufferPtr,
+                            GetEncodedDataSize(recRef),
+                            push_GetSenmlContentType(GetSenmlFormat(recRef->format)),
+                            handlerPtr,
+                            contextPtr);
+
+        if ((result == LE_OK) || (result == LE_BUSY))
+        {
+            LE_DEBUG("Data push success");
+            ResetRecord(recRef);
+        }
+    }
+    // Compress the cbor encoded data
+    else if (result == LE_OK)
+    {
+        defstream.zalloc = Z_NULL;
+        defstream.zfree = Z_NULL;
+        defstream.opaque = Z_NULL;
+
+        defstream.avail_in = GetEncodedDataSize(recRef);
+        defstream.next_in = (Bytef *)recRef->bufferPtr;
+        defstream.avail_out = (uInt)sizeof(buffer);
+        defstream.next_out = (Bytef *)buffer;
+
+        deflateInit(&defstream, Z_BEST_COMPRESSION);
+        deflate(&defstream, Z_FINISH);
+        deflateEnd(&defstream);
+
+        bufferLength = defstream.total_out;
+
+        result = PushBuffer(buffer,
+                            bufferLength,
+                            LWM2MCORE_PUSH_CONTENT_ZCBOR,
+                            handlerPtr,
+                            contextPtr);
+
+        // if data was successfully pushed, reset our record
+        if ((result == LE_OK) || (result == LE_BUSY))
+        {
+            LE_DEBUG("Data push success");
+            ResetRecord(recRef); // clear all data accumulated for this record
+        }
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a resource is iterated, i.e. it is the resource of the iterator path or one of its
+ * children
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsResourceIterated
+(
+    const IteratorData_t* iterPtr,
+    const ResourceData_t* resourceDataPtr
+)
+{
+    size_t pathLen = strlen(iterPtr->path);
+
+    if (0 == pathLen)
+    {
+        return true;
+    }
+
+    return ((0 == strncmp(resourceDataPtr->name, iterPtr->path, pathLen)) &&
+            (('\0' == resourceDataPtr->name[pathLen]) ||
+             ('/' == resourceDataPtr->name[pathLen]) ||
+             ('.' == resourceDataPtr->name[pathLen])));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the current sample of an iterator again if samples were removed from the record since it
+ * was reached
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateIterator
+(
+    IteratorData_t* iterPtr
+)
+{
+    timeSeries_RecordRef_t recRef = iterPtr->recRef;
+    le_dls_Link_t* linkPtr;
+    ResourceData_t* resourceDataPtr;
+
+    if (iterPtr->generation == recRef->generation)
+    {
+        return;
+    }
+
+    iterPtr->generation = recRef->generation;
+    iterPtr->timestampPtr = NULL;
+    iterPtr->resourcePtr = NULL;
+    iterPtr->dataPtr = NULL;
+
+    if ((!iterPtr->hasSample) ||
+        (GetTimestamp(recRef, iterPtr->timestamp, &iterPtr->timestampPtr) != LE_OK))
+    {
+        iterPtr->timestampPtr = NULL;
+        return;
+    }
+
+    linkPtr = le_dls_Peek(&recRef->resourceList);
+    while (linkPtr != NULL)
+    {
+        resourceDataPtr = CONTAINER_OF(linkPtr, ResourceData_t, link);
+
+        if (resourceDataPtr->id == iterPtr->resourceId)
+        {
+            iterPtr->resourcePtr = resourceDataPtr;
+            iterPtr->dataPtr = GetTimestampData(resourceDataPtr, iterPtr->timestamp);
+            break;
+        }
+
+        linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current sample of an iterator
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_FAULT if the sample is not of the requested type
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetIteratorData
+(
+    IteratorData_t* iterPtr,
+    DataType_t type,                    ///< Requested type, DATA_TYPE_NONE for any
+    Data_t** dataPtrPtr
+)
+{
+    UpdateIterator(iterPtr);
+
+    if (NULL == iterPtr->dataPtr)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if ((DATA_TYPE_NONE != type) && (iterPtr->resourcePtr->type != type))
+    {
+        return LE_FAULT;
+    }
+
+    *dataPtrPtr = iterPtr->dataPtr;
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create an iterator over the samples accumulated in a record, without encoding them
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the time range is invalid
+ *      - LE_OVERFLOW if the path is too long
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_CreateIterator
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    uint64_t startTime,
+    uint64_t endTime,
+    timeSeries_IteratorRef_t* iterRefPtr
+)
+{
+    IteratorData_t* iterPtr;
 
-            result = GetResourceData(recRef, path, DATA_TYPE_INT, &resourceDataPtr);
+    if (startTime > endTime)
+    {
+        LE_ERROR("Invalid time range %" PRIu64 " - %" PRIu64, startTime, endTime);
+        return LE_BAD_PARAMETER;
+    }
 
-            // if creating it and we still cannot the resource, there is an issue
-            if (result != LE_OK)
-            {
-                return result;
-            }
-        }
+    if ((NULL != path) && (strlen(path) >= LE_AVDATA_PATH_NAME_BYTES))
+    {
+        return LE_OVERFLOW;
+    }
 
-        result = AddIntResourceData(recRef, resourceDataPtr, value, timestamp);
+    iterPtr = le_mem_ForceAlloc(IteratorDataPoolRef);
+    memset(iterPtr, 0, sizeof(IteratorData_t));
+    if (NULL != path)
+    {
+        le_utf8_Copy(iterPtr->path, path, sizeof(iterPtr->path), NULL);
     }
 
-    return result;
+    // the record is kept until the iterator is deleted
+    le_mem_AddRef(recRef);
+    iterPtr->recRef = recRef;
+    iterPtr->startTime = startTime;
+    iterPtr->endTime = endTime;
+    iterPtr->hasSample = false;
+    iterPtr->generation = recRef->generation;
+    iterPtr->timestampPtr = NULL;
+    iterPtr->resourcePtr = NULL;
+    iterPtr->dataPtr = NULL;
+    *iterRefPtr = iterPtr;
+
+    return LE_OK;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add the float value for the specified resource
+ * Delete an iterator
+ */
+//--------------------------------------------------------------------------------------------------
+void timeSeries_DeleteIterator
+(
+    timeSeries_IteratorRef_t iterRef
+)
+{
+    le_mem_Release(iterRef->recRef);
+    le_mem_Release(iterRef);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Move an iterator to the next sample
  *
  * @return:
  *      - LE_OK on success
- *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
- *      - LE_FAULT on any other error
+ *      - LE_NOT_FOUND if there is no more sample, the iterator stays on the last one
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t timeSeries_AddFloat
+le_result_t timeSeries_NextSample
 (
-    timeSeries_RecordRef_t recRef,
-    const char* path,
-    double value,
-    uint64_t timestamp
+    timeSeries_IteratorRef_t iterRef
 )
 {
-    le_result_t result;
+    IteratorData_t* iterPtr = iterRef;
+    timeSeries_RecordRef_t recRef = iterPtr->recRef;
+    le_dls_Link_t* tsLinkPtr;
+    le_dls_Link_t* rdLinkPtr;
+    TimestampData_t* timestampPtr;
     ResourceData_t* resourceDataPtr;
+    Data_t* dataPtr;
 
-    result = GetResourceData(recRef, path, DATA_TYPE_FLOAT, &resourceDataPtr);
+    UpdateIterator(iterPtr);
 
-    // cmust be ok or not found
-    if (result != LE_FAULT)
+    // Start from the timestamp of the current sample, or from the next one if it was removed
+    if (NULL != iterPtr->timestampPtr)
     {
-        AddTimestamp(recRef, timestamp);
+        tsLinkPtr = &iterPtr->timestampPtr->link;
+    }
+    else
+    {
+        tsLinkPtr = le_dls_Peek(&recRef->timestampList);
+        while ((tsLinkPtr != NULL) && (iterPtr->hasSample) &&
+               (CONTAINER_OF(tsLinkPtr, TimestampData_t, link)->timestamp < iterPtr->timestamp))
+        {
+            tsLinkPtr = le_dls_PeekNext(&recRef->timestampList, tsLinkPtr);
+        }
+    }
 
-        // resource data does not exists
-        if (result == LE_NOT_FOUND)
+    // The timestamps are sorted, and the resources are in creation order
+    while (tsLinkPtr != NULL)
+    {
+        timestampPtr = CONTAINER_OF(tsLinkPtr, TimestampData_t, link);
+
+        if (timestampPtr->timestamp > iterPtr->endTime)
         {
-            result = CreateResourceData(recRef, path, DATA_TYPE_FLOAT);
+            break;
+        }
 
-            if (result != LE_OK)
-            {
-                return result;
-            }
+        rdLinkPtr = (timestampPtr->timestamp >= iterPtr->startTime) ?
+                    le_dls_Peek(&recRef->resourceList) : NULL;
 
-            result = GetResourceData(recRef, path, DATA_TYPE_FLOAT, &resourceDataPtr);
+        while (rdLinkPtr != NULL)
+        {
+            resourceDataPtr = CONTAINER_OF(rdLinkPtr, ResourceData_t, link);
 
-            // if creating it and we still cannot the resource, there is an issue
-            if (result != LE_OK)
+            // skip the samples already returned with the current timestamp
+            if (((!iterPtr->hasSample) || (timestampPtr->timestamp != iterPtr->timestamp) ||
+                 (resourceDataPtr->id > iterPtr->resourceId)) &&
+                (IsResourceIterated(iterPtr, resourceDataPtr)))
             {
-                return result;
+                dataPtr = GetTimestampData(resourceDataPtr, timestampPtr->timestamp);
+                if (dataPtr != NULL)
+                {
+                    iterPtr->hasSample = true;
+                    iterPtr->timestamp = timestampPtr->timestamp;
+                    iterPtr->resourceId = resourceDataPtr->id;
+                    iterPtr->timestampPtr = timestampPtr;
+                    iterPtr->resourcePtr = resourceDataPtr;
+                    iterPtr->dataPtr = dataPtr;
+                    return LE_OK;
+                }
             }
+
+            rdLinkPtr = le_dls_PeekNext(&recRef->resourceList, rdLinkPtr);
         }
 
-        result = AddFloatResourceData(recRef, resourceDataPtr, value, timestamp);
+        tsLinkPtr = le_dls_PeekNext(&recRef->timestampList, tsLinkPtr);
     }
 
-    return result;
+    return LE_NOT_FOUND;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add the boolean value for the specified resource
+ * Get the resource, type and timestamp of the current sample of an iterator
  *
  * @return:
  *      - LE_OK on success
- *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
- *      - LE_FAULT on any other error
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t timeSeries_AddBool
+le_result_t timeSeries_GetSampleInfo
 (
-    timeSeries_RecordRef_t recRef,
-    const char* path,
-    bool value,
-    uint64_t timestamp
+    timeSeries_IteratorRef_t iterRef,
+    const char** pathPtr,
+    le_avdata_DataType_t* typePtr,
+    uint64_t* timestampPtr
 )
 {
-    le_result_t result;
-    ResourceData_t* resourceDataPtr;
+    Data_t* dataPtr;
+    le_result_t result = GetIteratorData(iterRef, DATA_TYPE_NONE, &dataPtr);
 
-    result = GetResourceData(recRef, path, DATA_TYPE_BOOL, &resourceDataPtr);
+    if (result != LE_OK)
+    {
+        return result;
+    }
 
-    // cmust be ok or not found
-    if (result != LE_FAULT)
+    if (NULL != pathPtr)
     {
-        AddTimestamp(recRef, timestamp);
+        *pathPtr = iterRef->resourcePtr->name;
+    }
 
-        // resource data does not exists
-        if (result == LE_NOT_FOUND)
+    if (NULL != typePtr)
+    {
+        switch (iterRef->resourcePtr->type)
         {
-            result = CreateResourceData(recRef, path, DATA_TYPE_BOOL);
+            case DATA_TYPE_INT:
+                *typePtr = LE_AVDATA_DATA_TYPE_INT;
+                break;
+            case DATA_TYPE_FLOAT:
+                *typePtr = LE_AVDATA_DATA_TYPE_FLOAT;
+                break;
+            case DATA_TYPE_BOOL:
+                *typePtr = LE_AVDATA_DATA_TYPE_BOOL;
+                break;
+            case DATA_TYPE_STRING:
+                *typePtr = LE_AVDATA_DATA_TYPE_STRING;
+                break;
+            default:
+                *typePtr = LE_AVDATA_DATA_TYPE_NONE;
+                break;
+        }
+    }
 
-            if (result != LE_OK)
-            {
-                return result;
-            }
+    if (NULL != timestampPtr)
+    {
+        *timestampPtr = dataPtr->timestamp;
+    }
 
-            result = GetResourceData(recRef, path, DATA_TYPE_BOOL, &resourceDataPtr);
+    return LE_OK;
+}
 
-            // if creating it and we still cannot the resource, there is an issue
-            if (result != LE_OK)
-            {
-                return result;
-            }
-        }
 
-        result = AddBoolResourceData(recRef, resourceDataPtr, value, timestamp);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of the current integer sample of an iterator
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_FAULT if the sample is not an integer
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_GetSampleInt
+(
+    timeSeries_IteratorRef_t iterRef,
+    int32_t* valuePtr
+)
+{
+    Data_t* dataPtr;
+    le_result_t result = GetIteratorData(iterRef, DATA_TYPE_INT, &dataPtr);
+
+    if (result == LE_OK)
+    {
+        *valuePtr = dataPtr->intValue;
     }
 
     return result;
@@ -1490,52 +3033,54 @@ le_result_t timeSeries_AddBool
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add the string value for the specified resource
+ * Get the value of the current float sample of an iterator
  *
  * @return:
  *      - LE_OK on success
- *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
- *      - LE_FAULT on any other error
+ *      - LE_FAULT if the sample is not a float
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t timeSeries_AddString
+le_result_t timeSeries_GetSampleFloat
 (
-    timeSeries_RecordRef_t recRef,
-    const char* path,
-    const char* value,
-    uint64_t timestamp
+    timeSeries_IteratorRef_t iterRef,
+    double* valuePtr
 )
 {
-    le_result_t result;
-    ResourceData_t* resourceDataPtr;
-
-    result = GetResourceData(recRef, path, DATA_TYPE_STRING, &resourceDataPtr);
+    Data_t* dataPtr;
+    le_result_t result = GetIteratorData(iterRef, DATA_TYPE_FLOAT, &dataPtr);
 
-    // cmust be ok or not found
-    if (result != LE_FAULT)
+    if (result == LE_OK)
     {
-        AddTimestamp(recRef, timestamp);
-
-        // resource data does not exists
-        if (result == LE_NOT_FOUND)
-        {
-            result = CreateResourceData(recRef, path, DATA_TYPE_STRING);
+        *valuePtr = dataPtr->floatValue;
+    }
 
-            if (result != LE_OK)
-            {
-                return result;
-            }
+    return result;
+}
 
-            result = GetResourceData(recRef, path, DATA_TYPE_STRING, &resourceDataPtr);
 
-            // if creating it and we still cannot the resource, there is an issue
-            if (result != LE_OK)
-            {
-                return result;
-            }
-        }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of the current boolean sample of an iterator
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_FAULT if the sample is not a boolean
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t timeSeries_GetSampleBool
+(
+    timeSeries_IteratorRef_t iterRef,
+    bool* valuePtr
+)
+{
+    Data_t* dataPtr;
+    le_result_t result = GetIteratorData(iterRef, DATA_TYPE_BOOL, &dataPtr);
 
-        result = AddStringResourceData(recRef, resourceDataPtr, value, timestamp);
+    if (result == LE_OK)
+    {
+        *valuePtr = dataPtr->boolValue;
     }
 
     return result;
@@ -1544,64 +3089,108 @@ le_result_t timeSeries_AddString
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Compress the accumulated time series data and send it to server.
+ * Get the value of the current string sample of an iterator, without copying it
  *
  * @return:
  *      - LE_OK on success
- *      - LE_BUSY if push service is busy. Data added to queue list for later push
- *      - LE_OVERFLOW if data size exceeds the maximum allowed size
- *      - LE_NO_MEMORY if push queue is full, try again later
- *      - LE_FAULT on any other error
+ *      - LE_FAULT if the sample is not a string
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t timeSeries_PushRecord
+le_result_t timeSeries_GetSampleString
 (
-    timeSeries_RecordRef_t recRef,
-    le_avdata_CallbackResultFunc_t handlerPtr,
-    void* contextPtr
+    timeSeries_IteratorRef_t iterRef,
+    const char** valuePtr
 )
 {
+    Data_t* dataPtr;
+    le_result_t result = GetIteratorData(iterRef, DATA_TYPE_STRING, &dataPtr);
 
-    le_result_t result;
-    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];
-    size_t bufferLength;
-    z_stream defstream;
-
-    result = Encode(recRef);
-
-    // Compress the cbor encoded data
     if (result == LE_OK)
     {
-        defstream.zalloc = Z_NULL;
-        defstream.zfree = Z_NULL;
-        defstream.opaque = Z_NULL;
+        *valuePtr = dataPtr->strValuePtr;
+    }
 
-        defstream.avail_in = GetEncodedDataSize(recRef);
-        defstream.next_in = (Bytef *)recRef->bufferPtr;
-        defstream.avail_out = (uInt)sizeof(buffer);
-        defstream.next_out = (Bytef *)buffer;
+    return result;
+}
 
-        deflateInit(&defstream, Z_BEST_COMPRESSION);
-        deflate(&defstream, Z_FINISH);
-        deflateEnd(&defstream);
 
-        bufferLength = defstream.total_out;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Drop the samples of a record older than a watermark, without pushing them
+ *
+ * @return:
+ *      - Number of dropped samples
+ */
+//--------------------------------------------------------------------------------------------------
+size_t timeSeries_DropSamples
+(
+    timeSeries_RecordRef_t recRef,
+    uint64_t watermark
+)
+{
+    size_t numDropped = 0;
+    le_dls_Link_t* rdLinkPtr = le_dls_Peek(&recRef->resourceList);
+    le_dls_Link_t* nextRdLinkPtr;
+    le_dls_Link_t* dataLinkPtr;
+    le_dls_Link_t* nextDataLinkPtr;
+    le_dls_Link_t* tsLinkPtr;
+    ResourceData_t* resourceDataPtr;
+    Data_t* dataPtr;
 
-        result = PushBuffer(buffer,
-                            bufferLength,
-                            LWM2MCORE_PUSH_CONTENT_ZCBOR,
-                            handlerPtr,
-                            contextPtr);
+    while (rdLinkPtr != NULL)
+    {
+        resourceDataPtr = CONTAINER_OF(rdLinkPtr, ResourceData_t, link);
+        nextRdLinkPtr = le_dls_PeekNext(&recRef->resourceList, rdLinkPtr);
 
-        // if data was successfully pushed, reset our record
-        if ((result == LE_OK) || (result == LE_BUSY))
+        dataLinkPtr = le_dls_Peek(&resourceDataPtr->dataList);
+        while (dataLinkPtr != NULL)
         {
-            LE_DEBUG("Data push success");
-            ResetRecord(recRef); // clear all data accumulated for this record
+            dataPtr = CONTAINER_OF(dataLinkPtr, Data_t, link);
+            nextDataLinkPtr = le_dls_PeekNext(&resourceDataPtr->dataList, dataLinkPtr);
+
+            if (dataPtr->timestamp < watermark)
+            {
+                le_dls_Remove(&resourceDataPtr->dataList, dataLinkPtr);
+                if (resourceDataPtr->type == DATA_TYPE_STRING)
+                {
+                    le_mem_Release(dataPtr->strValuePtr);
+                }
+                le_mem_Release(dataPtr);
+                numDropped++;
+            }
+
+            dataLinkPtr = nextDataLinkPtr;
+        }
+
+        // a resource exists only with samples
+        if (le_dls_IsEmpty(&resourceDataPtr->dataList))
+        {
+            le_dls_Remove(&recRef->resourceList, rdLinkPtr);
+            le_mem_Release(resourceDataPtr);
         }
+
+        rdLinkPtr = nextRdLinkPtr;
     }
 
-    return result;
+    // The timestamps are sorted
+    tsLinkPtr = le_dls_Peek(&recRef->timestampList);
+    while ((tsLinkPtr != NULL) &&
+           (CONTAINER_OF(tsLinkPtr, TimestampData_t, link)->timestamp < watermark))
+    {
+        le_dls_Remove(&recRef->timestampList, tsLinkPtr);
+        le_mem_Release(CONTAINER_OF(tsLinkPtr, TimestampData_t, link));
+        tsLinkPtr = le_dls_Peek(&recRef->timestampList);
+    }
+
+    if (numDropped > 0)
+    {
+        LE_DEBUG("Dropped %zu samples older than %" PRIu64, numDropped, watermark);
+        recRef->generation++;
+        recRef->isEncoded = false;
+    }
+
+    return numDropped;
 }
 
 
@@ -1618,6 +3207,11 @@ le_result_t timeSeries_Init
     StringValuePoolRef = le_mem_CreatePool("String pool", LE_AVDATA_STRING_VALUE_BYTES);
 
     CborBufferPoolRef = le_mem_CreatePool("CBOR buffer pool", MAX_CBOR_BUFFER_NUMBYTES);
+    AggregationDataPoolRef = le_mem_CreatePool("Aggregation pool", sizeof(AggregationData_t));
+    FilterDataPoolRef = le_mem_CreatePool("Filter pool", sizeof(FilterData_t));
+    IteratorDataPoolRef = le_mem_CreatePool("Iterator pool", sizeof(IteratorData_t));
+
+    aggregation_Init();
 
     return LE_OK;
 }
@@ -11,6 +11,7 @@
 #define LEGATO_TIMESERIES_DATA_INCLUDE_GUARD
 
 #include "legato.h"
+#include "aggregation.h"
 
 #define NUM_TIME_SERIES_MAPS 3
 
@@ -23,6 +24,50 @@
 typedef struct le_avdata_Record* timeSeries_RecordRef_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encoding used to push a record.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    TIMESERIES_FORMAT_ZCBOR = 0,    ///< Compressed AirVantage CBOR layout (default)
+    TIMESERIES_FORMAT_SENML_CBOR,   ///< SenML-CBOR pack, one record per sample
+    TIMESERIES_FORMAT_SENML_JSON    ///< SenML-JSON pack, one record per sample
+}
+timeSeries_Format_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Filter dropping the samples of a resource that do not differ enough from the last recorded one.
+ *
+ * A numeric sample is dropped when it is within the deadband of the last recorded sample, i.e.
+ * closer than the largest of the absolute deadband and the percentage deadband of the last
+ * recorded value. With the change-only mode, a sample equal to the last recorded one is dropped;
+ * this is the only filter applied to boolean and string samples.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    double   absDeadband;   ///< Absolute deadband of numeric samples, 0 if none
+    double   pctDeadband;   ///< Deadband of numeric samples in % of the last recorded value, 0 if
+                            ///< none
+    bool     isChangeOnly;  ///< Drop the samples equal to the last recorded one
+    uint32_t heartbeatMs;   ///< Record a sample when the last recorded one is at least this old
+                            ///< (in milliseconds), even if unchanged. 0 if none.
+}
+timeSeries_Filter_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference to an iterator over the samples accumulated in a record.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct timeSeries_Iterator* timeSeries_IteratorRef_t;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Checks the return value from the tinyCBOR encoder and returns from function if an error is found.
@@ -69,6 +114,96 @@ LE_SHARED void timeSeries_Delete
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the encoding used to push a record. The data already accumulated is re-encoded.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the format is invalid
+ *      - LE_NO_MEMORY if the accumulated data does not fit in this encoding, the format is unchanged
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t timeSeries_SetFormat
+(
+    timeSeries_RecordRef_t recRef,
+    timeSeries_Format_t format
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Aggregate the samples of a resource over windows. Instead of every sample, one entry per closed
+ * window and statistic is added to the record, as child resources of the path: "<path>/min",
+ * "<path>/max", "<path>/mean", "<path>/count", "<path>/last" and "<path>/p<quantile in %>".
+ * A NULL configuration stops the aggregation; the samples of the open window are then lost.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the configuration is invalid
+ *      - LE_OVERFLOW if the path is too long for the aggregated resource names
+ *      - LE_NOT_FOUND if no aggregation is configured on the path and the configuration is NULL
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t timeSeries_SetAggregation
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    const aggregation_Config_t* configPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Filter the samples of a resource before they are added to the record. A NULL filter records all
+ * the samples again. The samples of an aggregated resource are not filtered, but a filter can be
+ * set on its aggregated statistics.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the filter is invalid or filters nothing
+ *      - LE_OVERFLOW if the path is too long
+ *      - LE_NOT_FOUND if no filter is set on the path and the filter is NULL
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t timeSeries_SetFilter
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,
+    const timeSeries_Filter_t* filterPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Limit the size of the data accumulated in a record, once encoded and before compression. The
+ * data which would exceed the limit is rejected as if the record buffer was full.
+ *
+ * @note SIZE_MAX removes the limit.
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED void timeSeries_SetSizeLimit
+(
+    timeSeries_RecordRef_t recRef,
+    size_t maxSize
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the size of the data accumulated in a record, once encoded and before compression
+ *
+ * @return:
+ *      - Encoded size in bytes
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED size_t timeSeries_GetEncodedSize
+(
+    timeSeries_RecordRef_t recRef
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Add the integer value for the specified resource
@@ -162,6 +297,139 @@ LE_SHARED le_result_t timeSeries_PushRecord
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create an iterator over the samples accumulated in a record, without encoding them. The samples
+ * are returned by timestamp, then by resource in their order of creation in the record.
+ *
+ * Samples added while iterating are returned if they come after the current sample. Once the end
+ * is reached, timeSeries_NextSample() returns the samples added since. Samples removed while
+ * iterating, e.g. by a push, are skipped.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_BAD_PARAMETER if the time range is invalid
+ *      - LE_OVERFLOW if the path is too long
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t timeSeries_CreateIterator
+(
+    timeSeries_RecordRef_t recRef,
+    const char* path,                   ///< Resource, or parent of the resources, to iterate on.
+                                        ///< NULL for all the resources.
+    uint64_t startTime,                 ///< Timestamp of the first samples
+    uint64_t endTime,                   ///< Timestamp of the last samples, UINT64_MAX for all
+    timeSeries_IteratorRef_t* iterRefPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete an iterator
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED void timeSeries_DeleteIterator
+(
+    timeSeries_IteratorRef_t iterRef
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Move an iterator to the next sample
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NOT_FOUND if there is no more sample, the iterator stays on the last one
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t timeSeries_NextSample
+(
+    timeSeries_IteratorRef_t iterRef
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the resource, type and timestamp of the current sample of an iterator. The path is valid
+ * until the record is modified.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t timeSeries_GetSampleInfo
+(
+    timeSeries_IteratorRef_t iterRef,
+    const char** pathPtr,               ///< Resource path, NULL if not needed
+    le_avdata_DataType_t* typePtr,      ///< Sample type, NULL if not needed
+    uint64_t* timestampPtr              ///< Sample timestamp, NULL if not needed
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of the current sample of an iterator
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_FAULT if the sample is not of this type
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t timeSeries_GetSampleInt
+(
+    timeSeries_IteratorRef_t iterRef,
+    int32_t* valuePtr
+);
+
+LE_SHARED le_result_t timeSeries_GetSampleFloat
+(
+    timeSeries_IteratorRef_t iterRef,
+    double* valuePtr
+);
+
+LE_SHARED le_result_t timeSeries_GetSampleBool
+(
+    timeSeries_IteratorRef_t iterRef,
+    bool* valuePtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of the current string sample of an iterator. The value is not copied: it is valid
+ * until the record is modified.
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_FAULT if the sample is not a string
+ *      - LE_NOT_FOUND if there is no current sample, or if it was removed
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t timeSeries_GetSampleString
+(
+    timeSeries_IteratorRef_t iterRef,
+    const char** valuePtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Drop the samples of a record older than a watermark, without pushing them
+ *
+ * @return:
+ *      - Number of dropped samples
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED size_t timeSeries_DropSamples
+(
+    timeSeries_RecordRef_t recRef,
+    uint64_t watermark                  ///< Samples with an earlier timestamp are dropped
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Init this sub-component
@@ -0,0 +1,873 @@
+/**
+ * @file downloadShaper.c
+ *
+ * Bandwidth shaping and metered-data budget for package downloads.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include <legato.h>
+#include <interfaces.h>
+#include <lwm2mcore/update.h>
+#include <avcFs.h>
+#include <avcFsConfig.h>
+#include "downloadShaper.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of microseconds in a second
+ */
+//--------------------------------------------------------------------------------------------------
+#define SECS_TO_USECS                   1000000ULL
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of seconds in a day
+ */
+//--------------------------------------------------------------------------------------------------
+#define SECS_PER_DAY                    86400
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of consumed bytes after which the budget usage is stored in the filesystem
+ */
+//--------------------------------------------------------------------------------------------------
+#define USAGE_SAVE_THRESHOLD_BYTES      (64 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Budget usage structure, stored in the filesystem
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t dailyBytes;        ///< Bytes consumed during the current day
+    uint64_t monthlyBytes;      ///< Bytes consumed during the current month
+    int32_t  day;               ///< Current day (days since the Epoch, UTC)
+    int32_t  month;             ///< Current month (months since 1900, UTC)
+}
+BudgetUsage_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Token bucket structure
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    double        tokens;       ///< Available tokens, in bytes
+    le_clk_Time_t lastTime;     ///< Last refill time
+    bool          isStarted;    ///< Indicates if the last refill time is valid
+}
+TokenBucket_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Held download structure
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool                        isHeld;                                 ///< A download is held
+    char                        uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES];   ///< Package URI
+    lwm2mcore_UpdateType_t      type;                                   ///< Update type
+    downloadShaper_ResumeFunc_t resumeFunc;                             ///< Resume function
+}
+HeldDownload_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current configuration
+ */
+//--------------------------------------------------------------------------------------------------
+static downloadShaper_Config_t Config =
+{
+    .rateLimit = { 0 },
+    .isMetered = { [DOWNLOADSHAPER_BEARER_CELLULAR] = true },
+    .dailyBudget = 0,
+    .monthlyBudget = 0,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current budget usage
+ */
+//--------------------------------------------------------------------------------------------------
+static BudgetUsage_t Usage;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes consumed since the last time the usage was stored
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t UnsavedBytes = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current bearer class. The bearer is considered cellular until the data connection reports
+ * otherwise, so that the metered budget applies by default.
+ */
+//--------------------------------------------------------------------------------------------------
+static downloadShaper_Bearer_t Bearer = DOWNLOADSHAPER_BEARER_CELLULAR;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Token bucket of the current bearer
+ */
+//--------------------------------------------------------------------------------------------------
+static TokenBucket_t Bucket;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download held because of an exhausted budget
+ */
+//--------------------------------------------------------------------------------------------------
+static HeldDownload_t HeldDownload;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer used to check the budget reset when a download is held
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t BudgetResetTimerRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex to prevent race condition between the download thread and the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t ShaperMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&ShaperMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&ShaperMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default sleep function
+ */
+//--------------------------------------------------------------------------------------------------
+static void Sleep
+(
+    le_clk_Time_t duration      ///< [IN] Time to wait
+)
+{
+    struct timespec req, rem;
+
+    req.tv_sec = duration.sec;
+    req.tv_nsec = duration.usec * 1000;
+
+    while (-1 == nanosleep(&req, &rem))
+    {
+        if (EINTR != errno)
+        {
+            LE_ERROR("nanosleep(): %m");
+            return;
+        }
+        req = rem;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function used to get the current time
+ */
+//--------------------------------------------------------------------------------------------------
+static downloadShaper_GetTimeFunc_t GetTime = le_clk_GetAbsoluteTime;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function used to wait
+ */
+//--------------------------------------------------------------------------------------------------
+static downloadShaper_SleepFunc_t Wait = Sleep;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a time to microseconds
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t TimeToUsecs
+(
+    le_clk_Time_t time
+)
+{
+    return ((uint64_t)time.sec * SECS_TO_USECS) + (uint64_t)time.usec;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current day and month
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetPeriod
+(
+    int32_t* dayPtr,        ///< [OUT] Days since the Epoch
+    int32_t* monthPtr       ///< [OUT] Months since 1900
+)
+{
+    time_t now = (time_t)GetTime().sec;
+    struct tm tm;
+
+    gmtime_r(&now, &tm);
+
+    *dayPtr = (int32_t)(now / SECS_PER_DAY);
+    *monthPtr = (int32_t)((tm.tm_year * 12) + tm.tm_mon);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store the budget usage. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SaveUsage
+(
+    void
+)
+{
+    le_result_t result = WriteFs(DOWNLOAD_BUDGET_USAGE_FILENAME,
+                                 (uint8_t*)&Usage,
+                                 sizeof(BudgetUsage_t));
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to write %s: %s", DOWNLOAD_BUDGET_USAGE_FILENAME, LE_RESULT_TXT(result));
+        return;
+    }
+
+    UnsavedBytes = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the budget usage if a new period started. Should be called with the mutex locked.
+ *
+ * @return
+ *      True    The usage was reset
+ *      False   The usage is unchanged
+ */
+//--------------------------------------------------------------------------------------------------
+static bool UpdatePeriod
+(
+    void
+)
+{
+    int32_t day, month;
+    bool isReset = false;
+
+    GetPeriod(&day, &month);
+
+    if (day != Usage.day)
+    {
+        LE_DEBUG("New day, %"PRIu64" bytes consumed the previous day", Usage.dailyBytes);
+        Usage.day = day;
+        Usage.dailyBytes = 0;
+        isReset = true;
+    }
+
+    if (month != Usage.month)
+    {
+        LE_DEBUG("New month, %"PRIu64" bytes consumed the previous month", Usage.monthlyBytes);
+        Usage.month = month;
+        Usage.monthlyBytes = 0;
+        isReset = true;
+    }
+
+    if (isReset)
+    {
+        SaveUsage();
+    }
+
+    return isReset;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the budget is exhausted for a bearer. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsExhausted
+(
+    downloadShaper_Bearer_t bearer
+)
+{
+    if (!Config.isMetered[bearer])
+    {
+        return false;
+    }
+
+    if ((Config.dailyBudget) && (Usage.dailyBytes >= Config.dailyBudget))
+    {
+        return true;
+    }
+
+    if ((Config.monthlyBudget) && (Usage.monthlyBytes >= Config.monthlyBudget))
+    {
+        return true;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restart the token bucket. Should be called with the mutex locked.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetBucket
+(
+    void
+)
+{
+    Bucket.tokens = (double)Config.rateLimit[Bearer];
+    Bucket.isStarted = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resume the held download if the budget allows it
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResumeHeldDownload
+(
+    void
+)
+{
+    HeldDownload_t held;
+
+    LOCK();
+    if ((!HeldDownload.isHeld) || (IsExhausted(Bearer)))
+    {
+        UNLOCK();
+        return;
+    }
+    held = HeldDownload;
+    HeldDownload.isHeld = false;
+    UNLOCK();
+
+    if (BudgetResetTimerRef)
+    {
+        le_timer_Stop(BudgetResetTimerRef);
+    }
+
+    LE_INFO("Resume download held for budget");
+    if (held.resumeFunc)
+    {
+        held.resumeFunc(held.uri, held.type, true);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Budget reset timer handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void BudgetResetTimerHandler
+(
+    le_timer_Ref_t timerRef    ///< [IN] Timer reference
+)
+{
+    downloadShaper_CheckBudgetReset();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the timer expiring at the beginning of the next day
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartBudgetResetTimer
+(
+    void
+)
+{
+    le_clk_Time_t interval;
+
+    if (!BudgetResetTimerRef)
+    {
+        BudgetResetTimerRef = le_timer_Create("download budget timer");
+        le_timer_SetHandler(BudgetResetTimerRef, BudgetResetTimerHandler);
+    }
+
+    // One extra second to be sure to be in the next day when the timer expires
+    interval.sec = SECS_PER_DAY - (GetTime().sec % SECS_PER_DAY) + 1;
+    interval.usec = 0;
+
+    le_timer_Stop(BudgetResetTimerRef);
+    le_timer_SetInterval(BudgetResetTimerRef, interval);
+    le_timer_Start(BudgetResetTimerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the download shaper: read the stored configuration and budget usage
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_Init
+(
+    void
+)
+{
+    downloadShaper_Config_t config;
+    BudgetUsage_t usage;
+    size_t size;
+
+    LOCK();
+
+    if (LE_OK == ExistsFs(DOWNLOAD_SHAPER_CONFIG_FILENAME))
+    {
+        size = sizeof(downloadShaper_Config_t);
+        if (   (LE_OK == ReadFs(DOWNLOAD_SHAPER_CONFIG_FILENAME, (uint8_t*)&config, &size))
+            && (sizeof(downloadShaper_Config_t) == size))
+        {
+            Config = config;
+        }
+        else
+        {
+            LE_ERROR("Failed to read %s", DOWNLOAD_SHAPER_CONFIG_FILENAME);
+        }
+    }
+
+    memset(&Usage, 0, sizeof(Usage));
+    if (LE_OK == ExistsFs(DOWNLOAD_BUDGET_USAGE_FILENAME))
+    {
+        size = sizeof(BudgetUsage_t);
+        if (   (LE_OK == ReadFs(DOWNLOAD_BUDGET_USAGE_FILENAME, (uint8_t*)&usage, &size))
+            && (sizeof(BudgetUsage_t) == size))
+        {
+            Usage = usage;
+        }
+        else
+        {
+            LE_ERROR("Failed to read %s", DOWNLOAD_BUDGET_USAGE_FILENAME);
+        }
+    }
+
+    UnsavedBytes = 0;
+    UpdatePeriod();
+    ResetBucket();
+
+    LE_DEBUG("Budget usage: %"PRIu64" bytes today, %"PRIu64" bytes this month",
+             Usage.dailyBytes, Usage.monthlyBytes);
+
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set and store the download shaper configuration
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_SetConfig
+(
+    const downloadShaper_Config_t* configPtr    ///< [IN] New configuration
+)
+{
+    le_result_t result;
+
+    if (!configPtr)
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+    Config = *configPtr;
+    ResetBucket();
+    result = WriteFs(DOWNLOAD_SHAPER_CONFIG_FILENAME,
+                     (uint8_t*)&Config,
+                     sizeof(downloadShaper_Config_t));
+    UNLOCK();
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to write %s: %s", DOWNLOAD_SHAPER_CONFIG_FILENAME, LE_RESULT_TXT(result));
+        return LE_FAULT;
+    }
+
+    // A larger budget might allow a held download to continue
+    ResumeHeldDownload();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the download shaper configuration
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_GetConfig
+(
+    downloadShaper_Config_t* configPtr          ///< [OUT] Current configuration
+)
+{
+    if (!configPtr)
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+    *configPtr = Config;
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the bearer class currently used for the data connection.
+ *
+ * A held download is resumed if the budget does not apply to the new bearer.
+ *
+ * @note Should be called from the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_SetBearer
+(
+    downloadShaper_Bearer_t bearer              ///< [IN] New bearer class
+)
+{
+    if (bearer >= DOWNLOADSHAPER_BEARER_MAX)
+    {
+        LE_ERROR("Invalid bearer %d", bearer);
+        return;
+    }
+
+    LOCK();
+    if (bearer == Bearer)
+    {
+        UNLOCK();
+        return;
+    }
+    LE_DEBUG("Bearer class changed from %d to %d", Bearer, bearer);
+    Bearer = bearer;
+    ResetBucket();
+    UNLOCK();
+
+    ResumeHeldDownload();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the bearer class currently used for the data connection
+ */
+//--------------------------------------------------------------------------------------------------
+downloadShaper_Bearer_t downloadShaper_GetBearer
+(
+    void
+)
+{
+    downloadShaper_Bearer_t bearer;
+
+    LOCK();
+    bearer = Bearer;
+    UNLOCK();
+
+    return bearer;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until the token bucket of the current bearer allows the reception of count bytes.
+ *
+ * The bucket holds at most one second worth of data. When the received data exceeds the
+ * available tokens, the thread waits for the time needed to receive the excess at the
+ * configured rate.
+ *
+ * @note Called from the download thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_Throttle
+(
+    size_t count                                ///< [IN] Number of received bytes
+)
+{
+    le_clk_Time_t now;
+    le_clk_Time_t delay;
+    uint64_t rate;
+    uint64_t delayUsecs;
+    double deficit;
+
+    LOCK();
+
+    rate = Config.rateLimit[Bearer];
+    if (!rate)
+    {
+        UNLOCK();
+        return;
+    }
+
+    now = GetTime();
+    if (Bucket.isStarted)
+    {
+        uint64_t elapsedUsecs = TimeToUsecs(le_clk_Sub(now, Bucket.lastTime));
+        Bucket.tokens += ((double)rate * (double)elapsedUsecs) / (double)SECS_TO_USECS;
+        if (Bucket.tokens > (double)rate)
+        {
+            Bucket.tokens = (double)rate;
+        }
+    }
+    Bucket.lastTime = now;
+    Bucket.isStarted = true;
+
+    if (Bucket.tokens >= (double)count)
+    {
+        Bucket.tokens -= (double)count;
+        UNLOCK();
+        return;
+    }
+
+    deficit = (double)count - Bucket.tokens;
+    Bucket.tokens = 0;
+    delayUsecs = (uint64_t)((deficit * (double)SECS_TO_USECS) / (double)rate);
+
+    // The waiting time is already paid: the next refill starts at the end of the wait
+    delay.sec = (time_t)(delayUsecs / SECS_TO_USECS);
+    delay.usec = (long)(delayUsecs % SECS_TO_USECS);
+    Bucket.lastTime = le_clk_Add(now, delay);
+
+    UNLOCK();
+
+    LE_DEBUG("Throttling download for %"PRIu64" us", delayUsecs);
+    Wait(delay);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Account received bytes in the budget if the current bearer is metered
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_Consume
+(
+    size_t count                                ///< [IN] Number of received bytes
+)
+{
+    LOCK();
+
+    if (!Config.isMetered[Bearer])
+    {
+        UNLOCK();
+        return;
+    }
+
+    UpdatePeriod();
+
+    Usage.dailyBytes += count;
+    Usage.monthlyBytes += count;
+    UnsavedBytes += count;
+
+    // Limit the number of writes in the filesystem, the last bytes are stored at the end of
+    // the download
+    if (UnsavedBytes >= USAGE_SAVE_THRESHOLD_BYTES)
+    {
+        SaveUsage();
+    }
+
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the budget applying to the current bearer is exhausted
+ *
+ * @return
+ *      True    The budget is exhausted, the download should be suspended
+ *      False   The download can continue
+ */
+//--------------------------------------------------------------------------------------------------
+bool downloadShaper_IsBudgetExhausted
+(
+    void
+)
+{
+    bool isExhausted;
+
+    LOCK();
+    UpdatePeriod();
+    isExhausted = IsExhausted(Bearer);
+    UNLOCK();
+
+    return isExhausted;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the bytes consumed in the current day and month
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_GetUsage
+(
+    uint64_t* dailyBytesPtr,                    ///< [OUT] Bytes consumed today
+    uint64_t* monthlyBytesPtr                   ///< [OUT] Bytes consumed this month
+)
+{
+    if ((!dailyBytesPtr) || (!monthlyBytesPtr))
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+    UpdatePeriod();
+    *dailyBytesPtr = Usage.dailyBytes;
+    *monthlyBytesPtr = Usage.monthlyBytes;
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store the budget usage in the filesystem
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_SaveUsage
+(
+    void
+)
+{
+    LOCK();
+    if (UnsavedBytes)
+    {
+        SaveUsage();
+    }
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hold a download suspended because of an exhausted budget. The resume function is called when
+ * the budget is reset or when the bearer changes to a bearer the budget does not apply to.
+ *
+ * @note Should be called from the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_HoldDownload
+(
+    const char*                 uriPtr,         ///< [IN] Package URI
+    lwm2mcore_UpdateType_t      type,           ///< [IN] Update type
+    downloadShaper_ResumeFunc_t resumeFunc      ///< [IN] Function called to resume the download
+)
+{
+    if ((!uriPtr) || (strlen(uriPtr) >= LWM2MCORE_PACKAGE_URI_MAX_BYTES))
+    {
+        LE_ERROR("Invalid package URI");
+        return;
+    }
+
+    LE_INFO("Download budget exhausted, holding download");
+
+    LOCK();
+    memset(HeldDownload.uri, 0, sizeof(HeldDownload.uri));
+    memcpy(HeldDownload.uri, uriPtr, strlen(uriPtr));
+    HeldDownload.type = type;
+    HeldDownload.resumeFunc = resumeFunc;
+    HeldDownload.isHeld = true;
+    UNLOCK();
+
+    // The download is not resumed from here even if the budget allows it: the download thread
+    // might still be running. The budget reset timer or the next bearer change resumes it.
+    StartBudgetResetTimer();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a download is held because of an exhausted budget
+ *
+ * @return
+ *      True    A download is held
+ *      False   No download is held
+ */
+//--------------------------------------------------------------------------------------------------
+bool downloadShaper_IsDownloadHeld
+(
+    void
+)
+{
+    bool isHeld;
+
+    LOCK();
+    isHeld = HeldDownload.isHeld;
+    UNLOCK();
+
+    return isHeld;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the budget usage if a new day or month started and resume the held download if the
+ * budget is available again.
+ *
+ * @note Should be called from the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_CheckBudgetReset
+(
+    void
+)
+{
+    bool isHeld;
+
+    LOCK();
+    UpdatePeriod();
+    isHeld = HeldDownload.isHeld;
+    UNLOCK();
+
+    if (!isHeld)
+    {
+        return;
+    }
+
+    ResumeHeldDownload();
+
+    // The monthly budget might still be exhausted: check again the next day
+    if (downloadShaper_IsDownloadHeld())
+    {
+        StartBudgetResetTimer();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the time functions used by the shaper. NULL restores the default functions.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_SetClock
+(
+    downloadShaper_GetTimeFunc_t getTimeFunc,   ///< [IN] Function returning the current time
+    downloadShaper_SleepFunc_t   sleepFunc      ///< [IN] Function waiting for a given duration
+)
+{
+    LOCK();
+    GetTime = (getTimeFunc) ? getTimeFunc : le_clk_GetAbsoluteTime;
+    Wait = (sleepFunc) ? sleepFunc : Sleep;
+    Bucket.isStarted = false;
+    UNLOCK();
+}
@@ -0,0 +1,274 @@
+/**
+ * @file downloadShaper.h
+ *
+ * Bandwidth shaping and metered-data budget for package downloads.
+ *
+ * The download throughput is limited per bearer class with a token bucket applied in the curl
+ * write callback. Bytes received over a metered bearer are accounted in a daily and a monthly
+ * budget which are persisted in the AVC filesystem. When a budget is exhausted, the ongoing
+ * download is suspended and held until the budget is reset or the bearer changes.
+ *
+ * The configuration is read by avcServer from the config tree and is reloaded when it changes:
+ * @verbatim
+   /apps/avcService/downloadShaper/<cellular|wifi|other>/rateLimit   bytes per second, 0: none
+   /apps/avcService/downloadShaper/<cellular|wifi|other>/metered     bearer counts in the budget
+   /apps/avcService/downloadShaper/dailyBudgetKB                     0: no daily budget
+   /apps/avcService/downloadShaper/monthlyBudgetKB                   0: no monthly budget
+   @endverbatim
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _DOWNLOADSHAPER_H
+#define _DOWNLOADSHAPER_H
+
+#include <lwm2mcore/update.h>
+#include <legato.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bearer classes used to select the download rate limit
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    DOWNLOADSHAPER_BEARER_CELLULAR = 0,     ///< Cellular bearer
+    DOWNLOADSHAPER_BEARER_WIFI,             ///< Wi-Fi bearer
+    DOWNLOADSHAPER_BEARER_OTHER,            ///< Any other bearer (ethernet, ...)
+    DOWNLOADSHAPER_BEARER_MAX               ///< Number of bearer classes
+}
+downloadShaper_Bearer_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download shaper configuration
+ *
+ * A value of 0 for a rate limit or a budget means unlimited.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t rateLimit[DOWNLOADSHAPER_BEARER_MAX];  ///< Rate limit in bytes per second
+    bool     isMetered[DOWNLOADSHAPER_BEARER_MAX];  ///< Bytes are accounted in the budget
+    uint64_t dailyBudget;                           ///< Daily budget in bytes
+    uint64_t monthlyBudget;                         ///< Monthly budget in bytes
+}
+downloadShaper_Config_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prototype of the function used to get the current time
+ */
+//--------------------------------------------------------------------------------------------------
+typedef le_clk_Time_t (*downloadShaper_GetTimeFunc_t)
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prototype of the function used to wait for a given duration
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*downloadShaper_SleepFunc_t)
+(
+    le_clk_Time_t duration      ///< [IN] Time to wait
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prototype of the function called to resume a held download
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*downloadShaper_ResumeFunc_t)
+(
+    const char*            uriPtr,  ///< Package URI
+    lwm2mcore_UpdateType_t type,    ///< Update type (FW/SW)
+    bool                   resume   ///< Indicates if it is a download resume
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the download shaper: read the stored configuration and budget usage
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set and store the download shaper configuration
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_SetConfig
+(
+    const downloadShaper_Config_t* configPtr    ///< [IN] New configuration
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the download shaper configuration
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_GetConfig
+(
+    downloadShaper_Config_t* configPtr          ///< [OUT] Current configuration
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the bearer class currently used for the data connection.
+ *
+ * A held download is resumed if the budget does not apply to the new bearer.
+ *
+ * @note Should be called from the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_SetBearer
+(
+    downloadShaper_Bearer_t bearer              ///< [IN] New bearer class
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the bearer class currently used for the data connection
+ */
+//--------------------------------------------------------------------------------------------------
+downloadShaper_Bearer_t downloadShaper_GetBearer
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until the token bucket of the current bearer allows the reception of count bytes.
+ *
+ * @note Called from the download thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_Throttle
+(
+    size_t count                                ///< [IN] Number of received bytes
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Account received bytes in the budget if the current bearer is metered
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_Consume
+(
+    size_t count                                ///< [IN] Number of received bytes
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the budget applying to the current bearer is exhausted
+ *
+ * @return
+ *      True    The budget is exhausted, the download should be suspended
+ *      False   The download can continue
+ */
+//--------------------------------------------------------------------------------------------------
+bool downloadShaper_IsBudgetExhausted
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the bytes consumed in the current day and month
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t downloadShaper_GetUsage
+(
+    uint64_t* dailyBytesPtr,                    ///< [OUT] Bytes consumed today
+    uint64_t* monthlyBytesPtr                   ///< [OUT] Bytes consumed this month
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store the budget usage in the filesystem
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_SaveUsage
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hold a download suspended because of an exhausted budget. The resume function is called when
+ * the budget is reset or when the bearer changes to a bearer the budget does not apply to.
+ *
+ * @note Should be called from the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_HoldDownload
+(
+    const char*                 uriPtr,         ///< [IN] Package URI
+    lwm2mcore_UpdateType_t      type,           ///< [IN] Update type
+    downloadShaper_ResumeFunc_t resumeFunc      ///< [IN] Function called to resume the download
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a download is held because of an exhausted budget
+ *
+ * @return
+ *      True    A download is held
+ *      False   No download is held
+ */
+//--------------------------------------------------------------------------------------------------
+bool downloadShaper_IsDownloadHeld
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the budget usage if a new day or month started and resume the held download if the
+ * budget is available again.
+ *
+ * @note Should be called from the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_CheckBudgetReset
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the time functions used by the shaper. NULL restores the default functions.
+ */
+//--------------------------------------------------------------------------------------------------
+void downloadShaper_SetClock
+(
+    downloadShaper_GetTimeFunc_t getTimeFunc,   ///< [IN] Function returning the current time
+    downloadShaper_SleepFunc_t   sleepFunc      ///< [IN] Function waiting for a given duration
+);
+
+#endif /* _DOWNLOADSHAPER_H */
@@ -12,8 +12,13 @@
 #include <lwm2mcorePackageDownloader.h>
 #include <lwm2mcore/update.h>
 #include <lwm2mcore/security.h>
+#include <sys/statvfs.h>
 #include "packageDownloaderCallbacks.h"
 #include "packageDownloader.h"
+#include "downloadShaper.h"
+#include "packageMirror.h"
+#include "packagePush.h"
+#include "packageLocal.h"
 #include "avcAppUpdate.h"
 #include "avcFs.h"
 #include "avcFsConfig.h"
@@ -59,6 +64,13 @@ static lwm2mcore_PackageDownloader_t PkgDwl;
 //--------------------------------------------------------------------------------------------------
 static uint8_t DownloadStatus = DOWNLOAD_STATUS_IDLE;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Indicates if the current suspend was triggered by an exhausted download budget.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsBudgetSuspend = false;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Mutex to prevent race condition between threads.
@@ -89,6 +101,68 @@ typedef struct
 }
 FwUpdateNotif_t;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Package source structure: package downloader callbacks used for the package URIs matched by the
+ * source
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool (*isSourceUri)(const char* uriPtr);                            ///< URI matching
+    lwm2mcore_DwlResult_t (*initDownload)(char* uriPtr, void* ctxPtr);  ///< Initialize download
+    lwm2mcore_DwlResult_t (*getInfo)(lwm2mcore_PackageDownloaderData_t* dataPtr,
+                                     void* ctxPtr);                     ///< Get package info
+    lwm2mcore_DwlResult_t (*download)(uint64_t startOffset, void* ctxPtr); ///< Download
+    lwm2mcore_DwlResult_t (*endDownload)(void* ctxPtr);                 ///< End download
+}
+PackageSource_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Package sources other than HTTP(S) servers: packages pushed on the LwM2M session and local
+ * packages. The first source matching the package URI is used, HTTP(S) otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static const PackageSource_t PackageSources[] =
+{
+    {
+        packagePush_IsPushUri,
+        packagePush_InitDownload,
+        packagePush_GetInfo,
+        packagePush_Download,
+        packagePush_EndDownload
+    },
+    {
+        packageLocal_IsLocalUri,
+        packageLocal_InitDownload,
+        packageLocal_GetInfo,
+        packageLocal_Download,
+        packageLocal_EndDownload
+    },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * HTTP(S) package source
+ */
+//--------------------------------------------------------------------------------------------------
+static const PackageSource_t HttpSource =
+{
+    NULL,
+    pkgDwlCb_InitDownload,
+    pkgDwlCb_GetInfo,
+    pkgDwlCb_Download,
+    pkgDwlCb_EndDownload
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Package source of the current download
+ */
+//--------------------------------------------------------------------------------------------------
+static const PackageSource_t* CurrentSourcePtr = &HttpSource;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Send a registration update to the server in order to follow the update treatment
@@ -137,6 +211,42 @@ static uint8_t GetDownloadStatus
     return currentDownloadStatus;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resume a download held because of an exhausted budget. Called in the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResumeDownloadForBudget
+(
+    const char*            uriPtr,  ///< Package URI
+    lwm2mcore_UpdateType_t type,    ///< Update type (FW/SW)
+    bool                   resume   ///< Indicates if it is a download resume
+)
+{
+    avcServer_ReportDownloadHold(false, type);
+    packageDownloader_StartDownload(uriPtr, type, resume);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hold a download suspended because of an exhausted budget, until the budget is reset or the
+ * bearer changes. Called in the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void HoldDownloadForBudget
+(
+    void* param1Ptr,    ///< Package downloader data
+    void* param2Ptr
+)
+{
+    lwm2mcore_PackageDownloaderData_t* dataPtr = (lwm2mcore_PackageDownloaderData_t*)param1Ptr;
+
+    avcServer_ReportDownloadHold(true, dataPtr->updateType);
+    downloadShaper_HoldDownload(dataPtr->packageUri,
+                                dataPtr->updateType,
+                                ResumeDownloadForBudget);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Abort current download
@@ -197,6 +307,47 @@ bool packageDownloader_CheckDownloadToSuspend
     return false;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the current download is suspended because the metered-data budget is exhausted
+ *
+ * @return
+ *      True    Download is suspended for budget
+ *      False   Otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+bool packageDownloader_CheckDownloadSuspendedForBudget
+(
+    void
+)
+{
+    bool isBudgetSuspend;
+
+    LOCK();
+    isBudgetSuspend = (DOWNLOAD_STATUS_SUSPEND == DownloadStatus) && IsBudgetSuspend;
+    UNLOCK();
+
+    return isBudgetSuspend;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a download is in progress, i.e. if the download or store threads are still running.
+ * A new download cannot be started until they end.
+ *
+ * @return
+ *      True    A download is in progress
+ *      False   No download is in progress
+ */
+//--------------------------------------------------------------------------------------------------
+bool packageDownloader_IsDownloadInProgress
+(
+    void
+)
+{
+    return ((NULL != DownloadRef) || (NULL != StoreFwRef));
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Store package information necessary to resume a download if necessary (URI and package type)
@@ -299,6 +450,7 @@ void packageDownloader_DeleteFwUpdateInfo
  * @return
  *  - LE_OK             The function succeeded
  *  - LE_BAD_PARAMETER  Incorrect parameter provided
+ *  - LE_NOT_FOUND      No resume information is stored
  *  - LE_FAULT          The function failed
  */
 //--------------------------------------------------------------------------------------------------
@@ -324,6 +476,13 @@ le_result_t packageDownloader_GetResumeInfo
         return result;
     }
 
+    // An empty file is left if the power was lost before the URI was written
+    if (0 == *uriSizePtr)
+    {
+        LE_ERROR("Empty package URI");
+        return LE_NOT_FOUND;
+    }
+
     if (*uriSizePtr > LWM2MCORE_PACKAGE_URI_MAX_LEN)
     {
         LE_ERROR("Uri length too big. Max allowed: %d, Found: %zd",
@@ -340,7 +499,7 @@ le_result_t packageDownloader_GetResumeInfo
     {
         LE_ERROR("Failed to read %s: %s", UPDATE_TYPE_FILENAME, LE_RESULT_TXT(result));
         *typePtr = LWM2MCORE_MAX_UPDATE_TYPE;
-        return result;
+        return (LE_OK != result) ? result : LE_FAULT;
     }
 
     return LE_OK;
@@ -378,6 +537,16 @@ le_result_t packageDownloader_Init
         return LE_FAULT;
     }
 
+    if (LE_OK != downloadShaper_Init())
+    {
+        LE_ERROR("Failed to initialize the download shaper");
+    }
+
+    if (LE_OK != packageMirror_Init())
+    {
+        LE_ERROR("Failed to initialize the package mirrors");
+    }
+
     return LE_OK;
 }
 
@@ -883,6 +1052,60 @@ le_result_t packageDownloader_GetSwUpdateResult
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get package information callback function: the information is retrieved from the package
+ * source, then a software package is admitted only if it can be stored. The firmware packages are
+ * stored by the firmware update service.
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted, e.g. the package cannot be stored
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_DwlResult_t GetInfo
+(
+    lwm2mcore_PackageDownloaderData_t* dataPtr, ///< [IN] Package downloader data pointer
+    void*                              ctxPtr   ///< [IN] Context pointer
+)
+{
+    lwm2mcore_DwlResult_t dwlResult;
+
+    dwlResult = CurrentSourcePtr->getInfo(dataPtr, ctxPtr);
+
+    // The size of a pushed package is unknown
+    if (   (DWL_OK != dwlResult)
+        || (LWM2MCORE_SW_UPDATE_TYPE != dataPtr->updateType)
+        || (0 == dataPtr->packageSize))
+    {
+        return dwlResult;
+    }
+
+    // The download is not rejected if the free space cannot be checked
+    if (LE_NO_MEMORY != avcApp_CheckStorage(dataPtr->packageSize))
+    {
+        return DWL_OK;
+    }
+
+    LE_ERROR("Not enough space to store the package of %"PRIu64" bytes", dataPtr->packageSize);
+
+    packageDownloader_SetSwUpdateState(LWM2MCORE_SW_UPDATE_STATE_INITIAL);
+    packageDownloader_SetSwUpdateResult(LWM2MCORE_SW_UPDATE_RESULT_NOT_ENOUGH_MEMORY);
+    packageDownloader_DeleteResumeInfo();
+    avcServer_UpdateStatus(LE_AVC_DOWNLOAD_FAILED,
+                           LE_AVC_APPLICATION_UPDATE,
+                           -1,
+                           -1,
+                           LE_AVC_ERR_INTERNAL,
+                           NULL,
+                           NULL
+                          );
+    AbortDownload();
+
+    return DWL_ABORTED;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Download package thread function
@@ -1037,6 +1260,25 @@ static void* DownloadThread
         {
             uint64_t numBytesToDownload;
 
+            // A pushed package is resumed when the server writes it again, there is nothing to
+            // download.
+            if (packagePush_IsPushUri(pkgDwlPtr->data.packageUri))
+            {
+                LE_INFO("Pushed package suspended, waiting for the server");
+                break;
+            }
+
+            // Suspended by the download shaper: the download is automatically resumed when the
+            // budget is reset or the bearer changes, no user agreement is requested.
+            if (packageDownloader_CheckDownloadSuspendedForBudget())
+            {
+                le_event_QueueFunctionToThread(dwlCtxPtr->mainRef,
+                                               HoldDownloadForBudget,
+                                               (void*)&pkgDwlPtr->data,
+                                               NULL);
+                break;
+            }
+
             le_fwupdate_ConnectService();
 
             // Retrieve number of bytes left to download
@@ -1235,6 +1477,7 @@ void packageDownloader_StartDownload
 {
     static packageDownloader_DownloadCtx_t dwlCtx;
     lwm2mcore_PackageDownloaderData_t data;
+    size_t i;
     char* dwlType[2] = {
         [0] = "FW_UPDATE",
         [1] = "SW_UPDATE",
@@ -1242,7 +1485,7 @@ void packageDownloader_StartDownload
 
     // Do not start a new download if a previous one is still in progress.
     // A download pending notification will be sent when it is over in order to resume the download.
-    if ((DownloadRef) || (StoreFwRef))
+    if (packageDownloader_IsDownloadInProgress())
     {
         LE_WARN("A download is still in progress, wait for its end");
         return;
@@ -1262,16 +1505,25 @@ void packageDownloader_StartDownload
     data.isResume = resume;
     PkgDwl.data = data;
 
-    // Set the package downloader callbacks
-    PkgDwl.initDownload = pkgDwlCb_InitDownload;
-    PkgDwl.getInfo = pkgDwlCb_GetInfo;
+    // Set the package downloader callbacks of the package source
+    CurrentSourcePtr = &HttpSource;
+    for (i = 0; i < NUM_ARRAY_MEMBERS(PackageSources); i++)
+    {
+        if (PackageSources[i].isSourceUri(uriPtr))
+        {
+            CurrentSourcePtr = &PackageSources[i];
+            break;
+        }
+    }
+    PkgDwl.initDownload = CurrentSourcePtr->initDownload;
+    PkgDwl.getInfo = GetInfo;
+    PkgDwl.download = CurrentSourcePtr->download;
+    PkgDwl.endDownload = CurrentSourcePtr->endDownload;
     PkgDwl.setFwUpdateState = packageDownloader_SetFwUpdateState;
     PkgDwl.setFwUpdateResult = packageDownloader_SetFwUpdateResult;
     PkgDwl.setSwUpdateState = packageDownloader_SetSwUpdateState;
     PkgDwl.setSwUpdateResult = packageDownloader_SetSwUpdateResult;
-    PkgDwl.download = pkgDwlCb_Download;
     PkgDwl.storeRange = pkgDwlCb_StoreRange;
-    PkgDwl.endDownload = pkgDwlCb_EndDownload;
 
     dwlCtx.fifoPtr = FIFO_PATH;
     dwlCtx.mainRef = le_thread_GetCurrent();
@@ -1308,6 +1560,9 @@ void packageDownloader_StartDownload
     PkgDwl.ctxPtr = (void*)&dwlCtx;
 
     // Download starts
+    LOCK();
+    IsBudgetSuspend = false;
+    UNLOCK();
     SetDownloadStatus(DOWNLOAD_STATUS_ACTIVE);
 
     DownloadRef = le_thread_Create("Downloader", (void*)dwlCtx.downloadPackage, (void*)&PkgDwl);
@@ -1402,7 +1657,39 @@ le_result_t packageDownloader_SuspendDownload
     LE_DEBUG("Suspend download, download status was %d", GetDownloadStatus());
 
     // Suspend ongoing download
-    SetDownloadStatus(DOWNLOAD_STATUS_SUSPEND);
+    LOCK();
+    DownloadStatus = DOWNLOAD_STATUS_SUSPEND;
+    IsBudgetSuspend = false;
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Suspend a package download because the metered-data budget is exhausted.
+ * The download is held and resumed automatically when the budget is reset or the bearer changes.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageDownloader_SuspendDownloadForBudget
+(
+    void
+)
+{
+    LE_DEBUG("Suspend download for budget, download status was %d", GetDownloadStatus());
+
+    LOCK();
+    // Do not override an abort or a suspend requested by the server or the user
+    if (DOWNLOAD_STATUS_ACTIVE == DownloadStatus)
+    {
+        DownloadStatus = DOWNLOAD_STATUS_SUSPEND;
+        IsBudgetSuspend = true;
+    }
+    UNLOCK();
 
     return LE_OK;
 }
@@ -1584,3 +1871,113 @@ le_result_t packageDownloader_BytesLeftToDownload
 
     return LE_FAULT;
 }
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the filesystem of a path can store a number of bytes, keeping the storage margin free.
+ * The nearest existing parent is checked if the path does not exist yet.
+ *
+ * @return
+ *  - LE_OK             The bytes can be stored
+ *  - LE_BAD_PARAMETER  The path is invalid
+ *  - LE_NO_MEMORY      Not enough free space
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageDownloader_CheckStorage
+(
+    const char* pathPtr,        ///< [IN] Path where the bytes are stored
+    uint64_t    numBytes        ///< [IN] Number of bytes to store
+)
+{
+    char path[PATH_MAX];
+    struct statvfs fsInfo;
+    uint64_t freeBytes;
+
+    if ((NULL == pathPtr) || ('/' != pathPtr[0]))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if (LE_OK != le_utf8_Copy(path, pathPtr, sizeof(path), NULL))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    while (-1 == statvfs(path, &fsInfo))
+    {
+        char* lastSlashPtr = strrchr(path, '/');
+
+        if ((ENOENT != errno) || (NULL == lastSlashPtr) || (0 == strcmp(path, "/")))
+        {
+            LE_ERROR("Unable to get the free space of %s: %m", pathPtr);
+            return LE_FAULT;
+        }
+
+        // Keep the root directory
+        lastSlashPtr[(path == lastSlashPtr) ? 1 : 0] = '\0';
+    }
+
+    freeBytes = (uint64_t)fsInfo.f_bavail * (uint64_t)fsInfo.f_frsize;
+
+    LE_DEBUG("%"PRIu64" bytes to store in %s, %"PRIu64" bytes free",
+             numBytes, path, freeBytes);
+
+    if (   (freeBytes < PACKAGEDOWNLOADER_STORAGE_MARGIN)
+        || (numBytes > (freeBytes - PACKAGEDOWNLOADER_STORAGE_MARGIN)))
+    {
+        LE_WARN("Not enough space in %s: %"PRIu64" bytes to store, %"PRIu64" bytes free",
+                path, numBytes, freeBytes);
+        return LE_NO_MEMORY;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Preallocate the blocks of a file, so that the writes up to the given size never fail for lack
+ * of space
+ *
+ * The file size is kept: the stored data can be shorter than the allocation, e.g. the payload of
+ * a package without its headers and signature.
+ *
+ * @return
+ *  - LE_OK             The blocks are allocated
+ *  - LE_NO_MEMORY      Not enough free space
+ *  - LE_UNSUPPORTED    The filesystem does not support preallocation
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageDownloader_PreallocateFile
+(
+    int      fd,                ///< [IN] File descriptor
+    uint64_t size               ///< [IN] File size to allocate
+)
+{
+    if ((-1 == fd) || (size > (uint64_t)INT64_MAX))
+    {
+        return LE_FAULT;
+    }
+
+    if (-1 == fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)size))
+    {
+        switch (errno)
+        {
+            case ENOSPC:
+                LE_ERROR("Not enough space to allocate %"PRIu64" bytes", size);
+                return LE_NO_MEMORY;
+
+            case EOPNOTSUPP:
+            case ENOSYS:
+                LE_DEBUG("Preallocation not supported");
+                return LE_UNSUPPORTED;
+
+            default:
+                LE_ERROR("Failed to allocate %"PRIu64" bytes: %m", size);
+                return LE_FAULT;
+        }
+    }
+
+    return LE_OK;
+}
@@ -15,6 +15,14 @@
 #include <legato.h>
 #include <interfaces.h>
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Space kept free on the filesystem storing a package, in bytes: a package which would leave less
+ * free space is rejected before being downloaded
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGEDOWNLOADER_STORAGE_MARGIN    (1024 * 1024)
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Download context data structure
@@ -327,6 +335,7 @@ void packageDownloader_DeleteFwUpdateInfo
  * @return
  *  - LE_OK             The function succeeded
  *  - LE_BAD_PARAMETER  Incorrect parameter provided
+ *  - LE_NOT_FOUND      No resume information is stored
  *  - LE_FAULT          The function failed
  */
 //--------------------------------------------------------------------------------------------------
@@ -379,6 +388,50 @@ le_result_t packageDownloader_SuspendDownload
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Suspend a package download because the metered-data budget is exhausted.
+ * The download is held and resumed automatically when the budget is reset or the bearer changes.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageDownloader_SuspendDownloadForBudget
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the current download is suspended because the metered-data budget is exhausted
+ *
+ * @return
+ *      True    Download is suspended for budget
+ *      False   Otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+bool packageDownloader_CheckDownloadSuspendedForBudget
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a download is in progress, i.e. if the download or store threads are still running.
+ * A new download cannot be started until they end.
+ *
+ * @return
+ *      True    A download is in progress
+ *      False   No download is in progress
+ */
+//--------------------------------------------------------------------------------------------------
+bool packageDownloader_IsDownloadInProgress
+(
+    void
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get the number of bytes to download on resume. Function will give valid data if suspend
@@ -398,4 +451,40 @@ le_result_t packageDownloader_BytesLeftToDownload
                                 ///<       Otherwise undefined.
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if the filesystem of a path can store a number of bytes, keeping the storage margin free.
+ * The nearest existing parent is checked if the path does not exist yet.
+ *
+ * @return
+ *  - LE_OK             The bytes can be stored
+ *  - LE_BAD_PARAMETER  The path is invalid
+ *  - LE_NO_MEMORY      Not enough free space
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageDownloader_CheckStorage
+(
+    const char* pathPtr,        ///< [IN] Path where the bytes are stored
+    uint64_t    numBytes        ///< [IN] Number of bytes to store
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Preallocate the blocks of a file, so that the writes up to the given size never fail for lack
+ * of space
+ *
+ * @return
+ *  - LE_OK             The blocks are allocated
+ *  - LE_NO_MEMORY      Not enough free space
+ *  - LE_UNSUPPORTED    The filesystem does not support preallocation
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageDownloader_PreallocateFile
+(
+    int      fd,                ///< [IN] File descriptor
+    uint64_t size               ///< [IN] File size to allocate
+);
+
 #endif /*_PACKAGEDOWNLOADER_H */
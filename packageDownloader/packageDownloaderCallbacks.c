@@ -16,6 +16,9 @@
 #include <avcFsConfig.h>
 #include "packageDownloader.h"
 #include "packageDownloaderCallbacks.h"
+#include "downloadShaper.h"
+#include "packageMirror.h"
+#include "trafficAccounting.h"
 #include "avcServer.h"
 #include "file.h"
 
@@ -74,6 +77,7 @@
  * HTTP status codes
  */
 //--------------------------------------------------------------------------------------------------
+#define PARTIAL_CONTENT                 206
 #define NOT_FOUND                       404
 #define INTERNAL_SERVER_ERROR           500
 #define BAD_GATEWAY                     502
@@ -110,7 +114,11 @@ typedef struct
     const char*             uriPtr;     ///< package URI pointer
     PackageInfo_t           pkgInfo;    ///< package information
     size_t                  size;       ///< package current size
+    uint64_t                packageSize;///< package size served by the sources, 0 if unknown
+    bool                    isRanged;   ///< a range of the package is requested to a source
+    bool                    isSourceError; ///< the source sent an unexpected response
     lwm2mcore_DwlResult_t   result;     ///< download result
+    trafficAccounting_Purpose_t purpose;///< traffic accounting purpose (FOTA/SOTA)
 }
 Package_t;
 
@@ -121,6 +129,31 @@ Package_t;
 //--------------------------------------------------------------------------------------------------
 static long HttpRespCode = LE_AVC_HTTP_STATUS_INVALID;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sources of the package being downloaded and their health
+ */
+//--------------------------------------------------------------------------------------------------
+static packageMirror_List_t Sources;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex to prevent race condition between the download thread, which updates the sources, and the
+ * main thread, which reads their health.
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t SourcesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&SourcesMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&SourcesMutex)!=0), \
+                               "Could not unlock the mutex")
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Send downloaded data to the package downloader
@@ -142,6 +175,32 @@ static size_t Write
 
     pkgPtr->result = DWL_FAULT;
 
+    // Only the requested range of a source is given to the package parser
+    if (pkgPtr->isRanged)
+    {
+        long code = 0;
+
+        if (   (CURLE_OK != curl_easy_getinfo(pkgPtr->curlPtr, CURLINFO_RESPONSE_CODE, &code))
+            || (PARTIAL_CONTENT != code))
+        {
+            LE_ERROR("Unexpected HTTP response %ld to a range request", code);
+            pkgPtr->isSourceError = true;
+            return 0;
+        }
+    }
+
+    // Stop the transfer if the metered-data budget is exhausted
+    if (true == downloadShaper_IsBudgetExhausted())
+    {
+        LE_INFO("Download budget exhausted");
+        packageDownloader_SuspendDownloadForBudget();
+        pkgPtr->result = DWL_SUSPEND;
+        return 0;
+    }
+
+    // Limit the download rate according to the current bearer
+    downloadShaper_Throttle(count);
+
     // Process the downloaded data
     if (DWL_OK != lwm2mcore_PackageDownloaderReceiveData(contentsPtr, count))
     {
@@ -155,6 +214,8 @@ static size_t Write
     }
 
     pkgPtr->size += count;
+    downloadShaper_Consume(count);
+    trafficAccounting_Add(pkgPtr->purpose, 0, count);
 
     return count;
 }
@@ -294,6 +355,107 @@ static int GetDownloadInfo
     return 0;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the download information from the current source
+ *
+ * @return
+ *      - 0 if the source serves the package
+ *      - -1 otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static int GetSourceInfo
+(
+    Package_t* pkgPtr   ///< [IN] Package data pointer
+)
+{
+    CURLcode rc;
+
+    pkgPtr->result = DWL_FAULT;
+    pkgPtr->isRanged = false;
+
+    rc = curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_URL, packageMirror_GetCurrentUri(&Sources));
+    if (CURLE_OK != rc)
+    {
+        LE_ERROR("failed to set URI: %s", curl_easy_strerror(rc));
+        return -1;
+    }
+
+    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_RANGE, NULL);
+
+    if (-1 == GetDownloadInfo(pkgPtr))
+    {
+        return -1;
+    }
+
+    if (-1 == CheckHttpStatusCode(pkgPtr->pkgInfo.httpRespCode))
+    {
+        LE_ERROR("HTTP error %ld", pkgPtr->pkgInfo.httpRespCode);
+        return -1;
+    }
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that the current source serves the package of the first source: a source serving a
+ * package of another size is not used. The content of the package is verified by the package
+ * parser whatever the sources.
+ *
+ * @return
+ *      - DWL_OK        The source serves the package
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_SUSPEND   The download is suspended
+ *      - DWL_FAULT     The source can not be used
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_DwlResult_t VerifySource
+(
+    Package_t* pkgPtr   ///< [IN] Package data pointer
+)
+{
+    if (-1 == GetSourceInfo(pkgPtr))
+    {
+        if ((DWL_ABORTED == pkgPtr->result) || (DWL_SUSPEND == pkgPtr->result))
+        {
+            return pkgPtr->result;
+        }
+        return DWL_FAULT;
+    }
+
+    if ((double)pkgPtr->packageSize != pkgPtr->pkgInfo.totalSize)
+    {
+        LE_ERROR("Package size %g instead of %"PRIu64,
+                 pkgPtr->pkgInfo.totalSize, pkgPtr->packageSize);
+        return DWL_FAULT;
+    }
+
+    LOCK();
+    Sources.source[Sources.current].isVerified = true;
+    UNLOCK();
+
+    return DWL_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the curl options used to receive the package body
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetBodyOptions
+(
+    Package_t* pkgPtr   ///< [IN] Package data pointer
+)
+{
+    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_NOBODY, 0L);
+    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_WRITEFUNCTION, Write);
+    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_WRITEDATA, (void *)pkgPtr);
+    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_XFERINFOFUNCTION, Progress);
+    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_XFERINFODATA, (void *)pkgPtr);
+    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_NOPROGRESS, 0L);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * A simple function to calculate the power of an unsigned integer to an unsigned integer
@@ -353,6 +515,161 @@ static void Wait
     } while (rc);
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download the package by ranges from its sources, starting at startOffset.
+ *
+ * After each range, the source used for the next range is selected according to the measured
+ * throughputs. When a source fails, the download resumes from the current offset on the next
+ * source still in use; a source which already failed is retried after 2^(failures-1) seconds, as
+ * for a single source.
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_SUSPEND   The download is suspended
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_DwlResult_t DownloadRanges
+(
+    Package_t*  pkgPtr,         ///< [IN] Package data pointer
+    uint64_t    startOffset     ///< [IN] Start offset for the download
+)
+{
+    packageMirror_Config_t config;
+    packageMirror_Source_t* sourcePtr;
+    lwm2mcore_DwlResult_t result;
+    le_clk_Time_t startTime;
+    le_clk_Time_t elapsed;
+    uint64_t offset = startOffset;
+    uint64_t endOffset;
+    uint64_t received;
+    CURLcode rc;
+    long osErrno;
+    bool isFatal;
+    le_result_t selectResult;
+    char buf[BUF_SIZE];
+
+    packageMirror_GetConfig(&config);
+    pkgPtr->size = (size_t)startOffset;
+
+    while (offset < pkgPtr->packageSize)
+    {
+        sourcePtr = &Sources.source[Sources.current];
+        received = 0;
+        isFatal = true;
+
+        // A source is used only if it serves the same package
+        if (false == sourcePtr->isVerified)
+        {
+            result = VerifySource(pkgPtr);
+            if ((DWL_ABORTED == result) || (DWL_SUSPEND == result))
+            {
+                return result;
+            }
+        }
+        else if (CURLE_OK == curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_URL, sourcePtr->uri))
+        {
+            result = DWL_OK;
+        }
+        else
+        {
+            result = DWL_FAULT;
+        }
+
+        if (DWL_OK == result)
+        {
+            endOffset = offset + config.rangeSize;
+            if (endOffset > pkgPtr->packageSize)
+            {
+                endOffset = pkgPtr->packageSize;
+            }
+
+            SetBodyOptions(pkgPtr);
+            memset(buf, 0, BUF_SIZE);
+            snprintf(buf, BUF_SIZE, "%"PRIu64"-%"PRIu64, offset, endOffset - 1);
+            curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_RANGE, buf);
+            pkgPtr->isRanged = true;
+            pkgPtr->isSourceError = false;
+
+            startTime = le_clk_GetRelativeTime();
+            rc = curl_easy_perform(pkgPtr->curlPtr);
+            elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+            pkgPtr->isRanged = false;
+            received = pkgPtr->size - offset;
+            offset = pkgPtr->size;
+
+            if (CURLE_OK != curl_easy_getinfo(pkgPtr->curlPtr, CURLINFO_RESPONSE_CODE,
+                                              &HttpRespCode))
+            {
+                LE_WARN("failed to get response code");
+            }
+
+            switch (rc)
+            {
+                case CURLE_OK:
+                    if (offset >= endOffset)
+                    {
+                        LOCK();
+                        packageMirror_RecordRange(&Sources, received,
+                                                  (uint32_t)(elapsed.sec * SECS_TO_MSECS
+                                                             + elapsed.usec / SECS_TO_MSECS));
+                        packageMirror_SelectAfterRange(&Sources);
+                        UNLOCK();
+                        continue;
+                    }
+                    LE_ERROR("Range %s ended at %"PRIu64, buf, offset);
+                    isFatal = false;
+                    break;
+                case CURLE_WRITE_ERROR:
+                    if (false == pkgPtr->isSourceError)
+                    {
+                        // Stopped by the package parser or by the budget
+                        return pkgPtr->result;
+                    }
+                    break;
+                case CURLE_ABORTED_BY_CALLBACK:
+                    return pkgPtr->result;
+                case CURLE_COULDNT_RESOLVE_PROXY:
+                case CURLE_COULDNT_RESOLVE_HOST:
+                case CURLE_OPERATION_TIMEDOUT:
+                case CURLE_RECV_ERROR:
+                case CURLE_PARTIAL_FILE:
+                    LE_DEBUG("Received error: %s", curl_easy_strerror(rc));
+                    isFatal = false;
+                    break;
+                case CURLE_COULDNT_CONNECT:
+                    curl_easy_getinfo(pkgPtr->curlPtr, CURLINFO_OS_ERRNO, &osErrno);
+                    isFatal = (ECONNREFUSED != osErrno);
+                    break;
+                default:
+                    LE_ERROR("failed to perform curl request: %s", curl_easy_strerror(rc));
+                    break;
+            }
+        }
+
+        // Resume from the current offset on the next source
+        LOCK();
+        packageMirror_RecordFailure(&Sources, received, isFatal);
+        selectResult = packageMirror_SelectAfterFailure(&Sources);
+        UNLOCK();
+        if (LE_OK != selectResult)
+        {
+            return DWL_FAULT;
+        }
+
+        sourcePtr = &Sources.source[Sources.current];
+        if (sourcePtr->consecutiveFailures)
+        {
+            Wait(Power(2, sourcePtr->consecutiveFailures - 1));
+        }
+    }
+
+    return DWL_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get package download HTTP response code
@@ -370,6 +687,40 @@ uint16_t pkgDwlCb_GetHttpStatus
     return (uint16_t)HttpRespCode;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a source of the current or last package download and its health
+ *
+ * @return
+ *      - LE_OK             The function succeeded
+ *      - LE_BAD_PARAMETER  Null pointer provided
+ *      - LE_OUT_OF_RANGE   No source at this index
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pkgDwlCb_GetSource
+(
+    size_t                  index,      ///< [IN]  Index of the source, in preference order
+    packageMirror_Source_t* sourcePtr   ///< [OUT] Source and its health
+)
+{
+    if (!sourcePtr)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+    if (index >= Sources.count)
+    {
+        UNLOCK();
+        return LE_OUT_OF_RANGE;
+    }
+
+    *sourcePtr = Sources.source[index];
+    UNLOCK();
+
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get update package size
@@ -389,6 +740,8 @@ le_result_t pkgDwlCb_GetPackageSize
     CURLcode rc;
     CURL* curlPtr;
     double packageSize;
+    packageMirror_List_t sources;
+    size_t i;
 
     if ((!packageUri) || ('\0' == packageUri[0]))
     {
@@ -404,6 +757,11 @@ le_result_t pkgDwlCb_GetPackageSize
 
     *packageSizePtr = 0;
 
+    if (LE_OK != packageMirror_BuildList(packageUri, &sources))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
     // Initialize everything possible
     rc = curl_global_init(CURL_GLOBAL_ALL);
     if (CURLE_OK != rc)
@@ -428,14 +786,6 @@ le_result_t pkgDwlCb_GetPackageSize
         goto easy_cleanup;
     }
 
-    // Set URL to get here
-    rc= curl_easy_setopt(curlPtr, CURLOPT_URL, packageUri);
-    if (CURLE_OK != rc)
-    {
-        LE_ERROR("Failed to set URI: %s", curl_easy_strerror(rc));
-        goto easy_cleanup;
-    }
-
     // Set the path to CA bundle
     if (file_Exists(PEMCERT_PATH))
     {
@@ -458,11 +808,26 @@ le_result_t pkgDwlCb_GetPackageSize
     curl_easy_setopt(curlPtr, CURLOPT_NOBODY, 1L);
     curl_easy_setopt(curlPtr, CURLOPT_WRITEFUNCTION, NULL);
 
-    // Retrieve the header
-    rc = curl_easy_perform(curlPtr);
-    if (CURLE_OK != rc)
+    // Retrieve the header from the first source answering
+    for (i = 0; i < sources.count; i++)
     {
+        rc = curl_easy_setopt(curlPtr, CURLOPT_URL, sources.source[i].uri);
+        if (CURLE_OK != rc)
+        {
+            LE_ERROR("Failed to set URI: %s", curl_easy_strerror(rc));
+            continue;
+        }
+
+        rc = curl_easy_perform(curlPtr);
+        if (CURLE_OK == rc)
+        {
+            break;
+        }
         LE_ERROR("Failed to perform curl request: %s", curl_easy_strerror(rc));
+    }
+
+    if (i == sources.count)
+    {
         goto easy_cleanup;
     }
 
@@ -504,11 +869,13 @@ lwm2mcore_DwlResult_t pkgDwlCb_InitDownload
 {
     static Package_t pkg;
     CURLcode rc;
+    le_result_t result;
     packageDownloader_DownloadCtx_t* dwlCtxPtr;
 
     dwlCtxPtr = (packageDownloader_DownloadCtx_t*)ctxPtr;
 
     pkg.curlPtr = NULL;
+    pkg.purpose = TRAFFICACCOUNTING_PURPOSE_FOTA;
 
     dwlCtxPtr->ctxPtr = (void *)&pkg;
 
@@ -563,14 +930,6 @@ lwm2mcore_DwlResult_t pkgDwlCb_InitDownload
         return DWL_FAULT;
     }
 
-    // set URL to get here
-    rc= curl_easy_setopt(pkg.curlPtr, CURLOPT_URL, uriPtr);
-    if (CURLE_OK != rc)
-    {
-        LE_ERROR("failed to set URI: %s", curl_easy_strerror(rc));
-        return DWL_FAULT;
-    }
-
     // set the path to CA bundle
     if (file_Exists(dwlCtxPtr->certPtr))
     {
@@ -589,24 +948,36 @@ lwm2mcore_DwlResult_t pkgDwlCb_InitDownload
         return DWL_FAULT;
     }
 
-    if (-1 == GetDownloadInfo(&pkg))
+    LOCK();
+    result = packageMirror_BuildList(uriPtr, &Sources);
+    UNLOCK();
+    if (LE_OK != result)
+    {
+        return DWL_FAULT;
+    }
+
+    // The package is downloaded from the first source serving it
+    while (-1 == GetSourceInfo(&pkg))
     {
         if ((DWL_ABORTED == pkg.result) || (DWL_SUSPEND == pkg.result))
         {
             return pkg.result;
         }
-        else
+
+        LOCK();
+        packageMirror_RecordFailure(&Sources, 0, true);
+        result = packageMirror_SelectAfterFailure(&Sources);
+        UNLOCK();
+        if (LE_OK != result)
         {
             return DWL_FAULT;
         }
     }
 
-    if (-1 == CheckHttpStatusCode(pkg.pkgInfo.httpRespCode))
-    {
-        LE_ERROR("HTTP error %ld", pkg.pkgInfo.httpRespCode);
-        return DWL_FAULT;
-    }
-
+    LOCK();
+    Sources.source[Sources.current].isVerified = true;
+    UNLOCK();
+    pkg.packageSize = (pkg.pkgInfo.totalSize > 0) ? (uint64_t)pkg.pkgInfo.totalSize : 0;
     pkg.uriPtr = uriPtr;
 
     return DWL_OK;
@@ -652,11 +1023,13 @@ lwm2mcore_DwlResult_t pkgDwlCb_GetInfo
     {
         LE_INFO("FW update type");
         packageDownloader_SetUpdatePackageSize(dataPtr->packageSize);
+        pkgPtr->purpose = TRAFFICACCOUNTING_PURPOSE_FOTA;
     }
     else if (LWM2MCORE_SW_UPDATE_TYPE == dataPtr->updateType)
     {
         LE_INFO("SW update type");
         packageDownloader_SetUpdatePackageSize(dataPtr->packageSize);
+        pkgPtr->purpose = TRAFFICACCOUNTING_PURPOSE_SOTA;
     }
     else
     {
@@ -690,6 +1063,11 @@ lwm2mcore_DwlResult_t pkgDwlCb_GetInfo
  * sometime later the download fails again
  * first attempt: wait for 1 second ...
  *
+ * The download rate is limited according to the current bearer and the transfer is suspended
+ * when the metered-data budget is exhausted, see downloadShaper.h.
+ *
+ * When the package has mirrors, it is downloaded by ranges from its sources, see packageMirror.h.
+ *
  * @return
  *      - DWL_OK        The function succeeded
  *      - DWL_SUSPENDED The download is suspended
@@ -715,12 +1093,21 @@ lwm2mcore_DwlResult_t pkgDwlCb_Download
 
     pkgPtr->size = 0;
 
-    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_NOBODY, 0L);
-    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_WRITEFUNCTION, Write);
-    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_WRITEDATA, (void *)pkgPtr);
-    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_XFERINFOFUNCTION, Progress);
-    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_XFERINFODATA, (void *)pkgPtr);
-    curl_easy_setopt(pkgPtr->curlPtr, CURLOPT_NOPROGRESS, 0L);
+    SetBodyOptions(pkgPtr);
+
+    // Do not start the transfer if the metered-data budget is already exhausted
+    if (true == downloadShaper_IsBudgetExhausted())
+    {
+        LE_INFO("Download budget exhausted");
+        packageDownloader_SuspendDownloadForBudget();
+        return DWL_SUSPEND;
+    }
+
+    // Download by ranges when the package is served by several sources
+    if ((1 < Sources.count) && (0 != pkgPtr->packageSize))
+    {
+        return DownloadRanges(pkgPtr, startOffset);
+    }
 
     // Start download at offset given by startOffset
     if (startOffset)
@@ -852,6 +1239,23 @@ lwm2mcore_DwlResult_t pkgDwlCb_EndDownload
 
     dwlCtxPtr = (packageDownloader_DownloadCtx_t*)ctxPtr;
 
+    // Store the bytes consumed since the last budget usage update
+    downloadShaper_SaveUsage();
+    trafficAccounting_Save();
+
+    // Report the health of the sources
+    if (1 < Sources.count)
+    {
+        size_t i;
+
+        for (i = 0; i < Sources.count; i++)
+        {
+            LE_INFO("Source %zu: %"PRIu64" bytes, %"PRIu32" bytes/s, %"PRIu32" failure(s)%s",
+                    i, Sources.source[i].bytes, Sources.source[i].throughput,
+                    Sources.source[i].failures, Sources.source[i].isDisabled ? ", not used" : "");
+        }
+    }
+
     // Clean up the curl context only if it was previously set
     if (NULL != dwlCtxPtr->ctxPtr)
     {
@@ -13,6 +13,7 @@
 #include <lwm2mcore/update.h>
 #include <lwm2mcorePackageDownloader.h>
 #include <legato.h>
+#include "packageMirror.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -28,6 +29,22 @@ uint16_t pkgDwlCb_GetHttpStatus
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a source of the current or last package download and its health
+ *
+ * @return
+ *      - LE_OK             The function succeeded
+ *      - LE_BAD_PARAMETER  Null pointer provided
+ *      - LE_OUT_OF_RANGE   No source at this index
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pkgDwlCb_GetSource
+(
+    size_t                  index,      ///< [IN]  Index of the source, in preference order
+    packageMirror_Source_t* sourcePtr   ///< [OUT] Source and its health
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get update package size
@@ -0,0 +1,760 @@
+/**
+ * @file packageLocal.c
+ *
+ * Local sources of update packages: package files and feeder processes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include <legato.h>
+#include <interfaces.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <lwm2mcore/update.h>
+#include <lwm2mcorePackageDownloader.h>
+#include "packageDownloader.h"
+#include "packageLocal.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the buffer used to read the package
+ */
+//--------------------------------------------------------------------------------------------------
+#define READ_BUFFER_SIZE                4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a size or offset line exchanged with a feeder, '\n' included
+ */
+//--------------------------------------------------------------------------------------------------
+#define FEEDER_LINE_MAX_LEN             24
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Period used to check the download status while waiting for the feeder, in ms
+ */
+//--------------------------------------------------------------------------------------------------
+#define POLL_PERIOD_MS                  200
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum delay without any data from the feeder, in ms
+ */
+//--------------------------------------------------------------------------------------------------
+#define FEEDER_TIMEOUT_MS               30000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Local source of the current download: file or feeder socket, and package size
+ */
+//--------------------------------------------------------------------------------------------------
+static int SourceFd = -1;
+static bool IsFeeder = false;
+static uint64_t PackageSize = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Directory of the local packages: files and feeder sockets outside of it are rejected
+ */
+//--------------------------------------------------------------------------------------------------
+static char AllowedDir[PATH_MAX] = PACKAGELOCAL_DEFAULT_DIR;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex to prevent race condition between the download thread and the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t AllowedDirMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&AllowedDirMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&AllowedDirMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a resolved path is in the allowed directory
+ *
+ * @return
+ *  - true if the path is in the allowed directory or one of its subdirectories
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsAllowedPath
+(
+    const char* pathPtr     ///< [IN] Resolved path of the file or socket
+)
+{
+    char dir[PATH_MAX];
+    char resolvedDir[PATH_MAX];
+    size_t len;
+
+    LOCK();
+    memcpy(dir, AllowedDir, sizeof(dir));
+    UNLOCK();
+
+    // The allowed directory is resolved too, it can be a symbolic link to a removable storage
+    if (NULL == realpath(dir, resolvedDir))
+    {
+        LE_ERROR("Local package directory %s is not available: %m", dir);
+        return false;
+    }
+
+    if (0 == strcmp(resolvedDir, "/"))
+    {
+        return true;
+    }
+
+    len = strlen(resolvedDir);
+    return ((0 == strncmp(pathPtr, resolvedDir, len)) && ('/' == pathPtr[len]));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the resolved path of a local package URI
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  The URI is not a valid local URI
+ *  - LE_NOT_PERMITTED  The path is outside of the allowed directory
+ *  - LE_FAULT          The file or socket does not exist
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetPath
+(
+    const char* uriPtr,     ///< [IN]  Package URI
+    bool* isFeederPtr,      ///< [OUT] Is the source a feeder?
+    char* pathPtr           ///< [OUT] Resolved path of the file or socket, PATH_MAX bytes
+)
+{
+    const char* uriPathPtr;
+
+    if (NULL == uriPtr)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if (0 == strncmp(uriPtr, PACKAGELOCAL_FILE_SCHEME, sizeof(PACKAGELOCAL_FILE_SCHEME) - 1))
+    {
+        *isFeederPtr = false;
+        uriPathPtr = uriPtr + sizeof(PACKAGELOCAL_FILE_SCHEME) - 1;
+    }
+    else if (0 == strncmp(uriPtr, PACKAGELOCAL_FEEDER_SCHEME,
+                          sizeof(PACKAGELOCAL_FEEDER_SCHEME) - 1))
+    {
+        *isFeederPtr = true;
+        uriPathPtr = uriPtr + sizeof(PACKAGELOCAL_FEEDER_SCHEME) - 1;
+    }
+    else
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    // Only absolute paths on the local host are accepted
+    if ('/' != uriPathPtr[0])
+    {
+        LE_ERROR("Local package path is not absolute: %s", uriPtr);
+        return LE_BAD_PARAMETER;
+    }
+
+    // Symbolic links and '..' components are resolved before checking the directory
+    if (NULL == realpath(uriPathPtr, pathPtr))
+    {
+        LE_ERROR("Local package %s is not available: %m", uriPathPtr);
+        return LE_FAULT;
+    }
+
+    if (!IsAllowedPath(pathPtr))
+    {
+        LE_ERROR("Local package %s is outside of the allowed directory", uriPathPtr);
+        return LE_NOT_PERMITTED;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for data from a feeder, checking the download status periodically
+ *
+ * @return
+ *  - DWL_OK        Data are available
+ *  - DWL_SUSPEND   The download is suspended
+ *  - DWL_ABORTED   The download is aborted
+ *  - DWL_FAULT     The feeder is stalled or the function failed
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_DwlResult_t WaitFeeder
+(
+    int fd,                 ///< [IN] Feeder socket
+    bool checkStatus        ///< [IN] Check the download abort and suspend requests
+)
+{
+    uint32_t idleMs = 0;
+
+    while (idleMs < FEEDER_TIMEOUT_MS)
+    {
+        struct pollfd pfd;
+        int rc;
+
+        if (checkStatus)
+        {
+            if (true == packageDownloader_CheckDownloadToAbort())
+            {
+                LE_INFO("Download aborted");
+                return DWL_ABORTED;
+            }
+
+            if (true == packageDownloader_CheckDownloadToSuspend())
+            {
+                LE_INFO("Download suspended");
+                return DWL_SUSPEND;
+            }
+        }
+
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        rc = poll(&pfd, 1, POLL_PERIOD_MS);
+        if (rc > 0)
+        {
+            return DWL_OK;
+        }
+
+        if ((-1 == rc) && (EINTR != errno))
+        {
+            LE_ERROR("Failed to poll the feeder: %m");
+            return DWL_FAULT;
+        }
+
+        if (0 == rc)
+        {
+            idleMs += POLL_PERIOD_MS;
+        }
+    }
+
+    LE_ERROR("No data from the feeder during %d ms", FEEDER_TIMEOUT_MS);
+    return DWL_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a decimal value terminated by '\n' from a feeder
+ *
+ * @return
+ *  - DWL_OK        The value is read
+ *  - DWL_ABORTED   The download is aborted
+ *  - DWL_FAULT     The feeder closed the connection, sent an invalid value or is stalled
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_DwlResult_t ReadFeederValue
+(
+    int fd,                 ///< [IN]  Feeder socket
+    bool checkStatus,       ///< [IN]  Check the download abort and suspend requests
+    uint64_t* valuePtr      ///< [OUT] Value
+)
+{
+    char line[FEEDER_LINE_MAX_LEN];
+    size_t len = 0;
+    char* endPtr;
+
+    // Read byte by byte: the package data follow the line
+    while (len < (sizeof(line) - 1))
+    {
+        lwm2mcore_DwlResult_t result;
+        ssize_t count;
+
+        result = WaitFeeder(fd, checkStatus);
+        if (DWL_OK != result)
+        {
+            return result;
+        }
+
+        count = read(fd, &line[len], 1);
+        if ((-1 == count) && (EINTR == errno))
+        {
+            continue;
+        }
+
+        if (count <= 0)
+        {
+            LE_ERROR("Feeder connection closed");
+            return DWL_FAULT;
+        }
+
+        if ('\n' == line[len])
+        {
+            line[len] = '\0';
+
+            errno = 0;
+            *valuePtr = strtoull(line, &endPtr, 10);
+            if ((0 == len) || ('\0' != *endPtr) || (!isdigit((unsigned char)line[0])) || errno)
+            {
+                LE_ERROR("Invalid value from the feeder: '%s'", line);
+                return DWL_FAULT;
+            }
+
+            return DWL_OK;
+        }
+
+        len++;
+    }
+
+    LE_ERROR("Value from the feeder too long");
+    return DWL_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a decimal value terminated by '\n' to a feeder
+ *
+ * @return
+ *  - LE_OK     The value is sent
+ *  - LE_FAULT  The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SendFeederValue
+(
+    int fd,                 ///< [IN] Feeder socket
+    uint64_t value          ///< [IN] Value
+)
+{
+    char line[FEEDER_LINE_MAX_LEN];
+    size_t len;
+    size_t written = 0;
+
+    len = (size_t)snprintf(line, sizeof(line), "%"PRIu64"\n", value);
+
+    while (written < len)
+    {
+        ssize_t count = send(fd, line + written, len - written, MSG_NOSIGNAL);
+        if (-1 == count)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            LE_ERROR("Failed to send to the feeder: %m");
+            return LE_FAULT;
+        }
+        written += (size_t)count;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open a local source and get the package size. A feeder sends the package size on connection.
+ *
+ * @return
+ *  - DWL_OK        The source is opened
+ *  - DWL_ABORTED   The download is aborted
+ *  - DWL_FAULT     The source is not available
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_DwlResult_t OpenSource
+(
+    const char* pathPtr,    ///< [IN]  Resolved path of the file or socket
+    bool isFeeder,          ///< [IN]  Is the source a feeder?
+    bool checkStatus,       ///< [IN]  Check the download abort and suspend requests
+    int* fdPtr,             ///< [OUT] File descriptor of the source
+    uint64_t* sizePtr       ///< [OUT] Package size
+)
+{
+    lwm2mcore_DwlResult_t result;
+    int fd;
+
+    if (!isFeeder)
+    {
+        struct stat st;
+
+        // The path is resolved: a link created since then is not followed out of the directory
+        fd = open(pathPtr, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+        if (-1 == fd)
+        {
+            LE_ERROR("Failed to open package file %s: %m", pathPtr);
+            return DWL_FAULT;
+        }
+
+        if ((-1 == fstat(fd, &st)) || (!S_ISREG(st.st_mode)))
+        {
+            LE_ERROR("%s is not a package file", pathPtr);
+            close(fd);
+            return DWL_FAULT;
+        }
+
+        *sizePtr = (uint64_t)st.st_size;
+        *fdPtr = fd;
+        return DWL_OK;
+    }
+
+    struct sockaddr_un addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (LE_OK != le_utf8_Copy(addr.sun_path, pathPtr, sizeof(addr.sun_path), NULL))
+    {
+        LE_ERROR("Feeder socket path too long: %s", pathPtr);
+        return DWL_FAULT;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (-1 == fd)
+    {
+        LE_ERROR("Failed to create the feeder socket: %m");
+        return DWL_FAULT;
+    }
+
+    if (-1 == connect(fd, (struct sockaddr*)&addr, sizeof(addr)))
+    {
+        LE_ERROR("Failed to connect to the feeder %s: %m", pathPtr);
+        close(fd);
+        return DWL_FAULT;
+    }
+
+    result = ReadFeederValue(fd, checkStatus, sizePtr);
+    if (DWL_OK != result)
+    {
+        close(fd);
+        return result;
+    }
+
+    *fdPtr = fd;
+    return DWL_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the directory of the local packages. The package files and feeder sockets must be in this
+ * directory or one of its subdirectories.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  The directory is not an absolute path
+ *  - LE_OVERFLOW       The directory path is too long
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageLocal_SetAllowedDir
+(
+    const char* dirPtr      ///< [IN] Absolute path of the directory
+)
+{
+    le_result_t result;
+
+    if ((NULL == dirPtr) || ('/' != dirPtr[0]))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+    result = le_utf8_Copy(AllowedDir, dirPtr, sizeof(AllowedDir), NULL);
+    if (LE_OK != result)
+    {
+        // Fall back to the default directory rather than to a truncated path
+        le_utf8_Copy(AllowedDir, PACKAGELOCAL_DEFAULT_DIR, sizeof(AllowedDir), NULL);
+    }
+    UNLOCK();
+
+    if (LE_OK == result)
+    {
+        LE_INFO("Local packages allowed in %s", dirPtr);
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a package URI designates a local source
+ *
+ * @return
+ *  - true if the package is read from a local file or feeder
+ */
+//--------------------------------------------------------------------------------------------------
+bool packageLocal_IsLocalUri
+(
+    const char* uriPtr      ///< [IN] Package URI
+)
+{
+    if (NULL == uriPtr)
+    {
+        return false;
+    }
+
+    return (   (0 == strncmp(uriPtr, PACKAGELOCAL_FILE_SCHEME,
+                             sizeof(PACKAGELOCAL_FILE_SCHEME) - 1))
+            || (0 == strncmp(uriPtr, PACKAGELOCAL_FEEDER_SCHEME,
+                             sizeof(PACKAGELOCAL_FEEDER_SCHEME) - 1)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the size of a local package
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  The URI is not a valid local URI
+ *  - LE_NOT_PERMITTED  The package is outside of the allowed directory
+ *  - LE_FAULT          The package is not available
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageLocal_GetPackageSize
+(
+    const char* uriPtr,         ///< [IN]  Package URI
+    uint64_t* packageSizePtr    ///< [OUT] Package size
+)
+{
+    char path[PATH_MAX];
+    bool isFeeder;
+    le_result_t result;
+    int fd;
+
+    if (NULL == packageSizePtr)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    result = GetPath(uriPtr, &isFeeder, path);
+    if (LE_OK != result)
+    {
+        return result;
+    }
+
+    *packageSizePtr = 0;
+
+    // The feeder ends the connection without receiving a start offset
+    if (DWL_OK != OpenSource(path, isFeeder, false, &fd, packageSizePtr))
+    {
+        return LE_FAULT;
+    }
+    close(fd);
+
+    packageDownloader_SetUpdatePackageSize(*packageSizePtr);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize download callback function of a local package: the file is opened or the feeder is
+ * connected
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packageLocal_InitDownload
+(
+    char* uriPtr,   ///< [IN] Package URI
+    void* ctxPtr    ///< [IN] Context pointer
+)
+{
+    packageDownloader_DownloadCtx_t* dwlCtxPtr = (packageDownloader_DownloadCtx_t*)ctxPtr;
+    char path[PATH_MAX];
+    lwm2mcore_DwlResult_t result;
+
+    dwlCtxPtr->ctxPtr = NULL;
+
+    LE_DEBUG("Initialize local package download");
+
+    if (true == packageDownloader_CheckDownloadToAbort())
+    {
+        LE_INFO("Download aborted");
+        return DWL_ABORTED;
+    }
+
+    if (-1 != SourceFd)
+    {
+        close(SourceFd);
+        SourceFd = -1;
+    }
+
+    // The allowed directory is checked again: it can change between the size request and the
+    // download
+    if (LE_OK != GetPath(uriPtr, &IsFeeder, path))
+    {
+        return DWL_FAULT;
+    }
+
+    result = OpenSource(path, IsFeeder, true, &SourceFd, &PackageSize);
+    if (DWL_OK != result)
+    {
+        SourceFd = -1;
+        return result;
+    }
+
+    LE_INFO("Local package %s: %"PRIu64" bytes", uriPtr, PackageSize);
+
+    return DWL_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get package information callback function of a local package
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packageLocal_GetInfo
+(
+    lwm2mcore_PackageDownloaderData_t* dataPtr, ///< [IN] Package downloader data pointer
+    void*                              ctxPtr   ///< [IN] Context pointer
+)
+{
+    LE_DEBUG("updateType: %d", dataPtr->updateType);
+
+    if (true == packageDownloader_CheckDownloadToAbort())
+    {
+        LE_INFO("Download aborted");
+        return DWL_ABORTED;
+    }
+
+    dataPtr->packageSize = PackageSize;
+    packageDownloader_SetUpdatePackageSize(dataPtr->packageSize);
+
+    return DWL_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download callback function of a local package: the package is read from startOffset
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_SUSPEND   The download is suspended
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packageLocal_Download
+(
+    uint64_t    startOffset,    ///< [IN] Start offset for the download
+    void*       ctxPtr          ///< [IN] Context pointer
+)
+{
+    uint8_t buffer[READ_BUFFER_SIZE];
+    uint64_t offset = startOffset;
+
+    if (-1 == SourceFd)
+    {
+        LE_ERROR("No local package opened");
+        return DWL_FAULT;
+    }
+
+    if (startOffset > PackageSize)
+    {
+        LE_ERROR("Resume offset %"PRIu64" beyond the package size %"PRIu64,
+                 startOffset, PackageSize);
+        return DWL_FAULT;
+    }
+
+    LE_INFO("Local package read from offset %"PRIu64, startOffset);
+
+    // Start the download at offset given by startOffset
+    if (IsFeeder)
+    {
+        if (LE_OK != SendFeederValue(SourceFd, startOffset))
+        {
+            return DWL_FAULT;
+        }
+    }
+    else if ((off_t)-1 == lseek(SourceFd, (off_t)startOffset, SEEK_SET))
+    {
+        LE_ERROR("Failed to seek to offset %"PRIu64": %m", startOffset);
+        return DWL_FAULT;
+    }
+
+    while (true)
+    {
+        ssize_t count;
+
+        if (true == packageDownloader_CheckDownloadToAbort())
+        {
+            LE_INFO("Download aborted");
+            return DWL_ABORTED;
+        }
+
+        if (true == packageDownloader_CheckDownloadToSuspend())
+        {
+            LE_INFO("Download suspended");
+            return DWL_SUSPEND;
+        }
+
+        if (IsFeeder)
+        {
+            lwm2mcore_DwlResult_t result = WaitFeeder(SourceFd, true);
+            if (DWL_OK != result)
+            {
+                return result;
+            }
+        }
+
+        count = read(SourceFd, buffer, sizeof(buffer));
+        if (-1 == count)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            LE_ERROR("Failed to read the local package: %m");
+            return DWL_FAULT;
+        }
+
+        if (0 == count)
+        {
+            // The package parser rejects a package shorter than its header announces, a source
+            // ending before its own size was interrupted
+            if (offset < PackageSize)
+            {
+                LE_ERROR("Local package ended at %"PRIu64" of %"PRIu64" bytes",
+                         offset, PackageSize);
+                return DWL_FAULT;
+            }
+
+            LE_INFO("Local package read: %"PRIu64" bytes", offset);
+            return DWL_OK;
+        }
+
+        offset += (uint64_t)count;
+
+        if (DWL_OK != lwm2mcore_PackageDownloaderReceiveData(buffer, (size_t)count))
+        {
+            LE_ERROR("Data processing stopped by DWL parser");
+            return DWL_FAULT;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End download callback function of a local package
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packageLocal_EndDownload
+(
+    void* ctxPtr    ///< [IN] Context pointer
+)
+{
+    if (-1 != SourceFd)
+    {
+        close(SourceFd);
+        SourceFd = -1;
+    }
+
+    return DWL_OK;
+}
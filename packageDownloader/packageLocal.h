@@ -0,0 +1,167 @@
+/**
+ * @file packageLocal.h
+ *
+ * Local sources of update packages, used to update a device without connectivity.
+ *
+ * A package URI written in the Package URI resource of the firmware or software update object can
+ * designate a local source instead of an HTTP(S) server:
+ *  - file:///<path>: a package file stored on the device or on a removable storage
+ *  - unix:///<path>: a feeder process listening on a Unix stream socket
+ *
+ * The package is fed to the same package parser and store paths as an HTTP download: it is
+ * verified, resumed from the stored offset and reported in the update objects the same way.
+ *
+ * The path is resolved and must be in the allowed directory, PACKAGELOCAL_DEFAULT_DIR by default,
+ * or one of its subdirectories.
+ *
+ * A local URI is written by the server during a device management session. A firmware update can
+ * also be started without connectivity from the config tree: the firmware URI is removed once
+ * read, and the package is installed when downloaded. The configuration is read by avcServer and
+ * is reloaded when it changes:
+ * @verbatim
+   /apps/avcService/packageLocal/allowedDir     directory of the local packages
+   /apps/avcService/packageLocal/firmwareUri    local URI of a firmware package to install
+   @endverbatim
+ *
+ * A feeder serves one download per connection:
+ *  - on connection, the feeder sends the package size in decimal, terminated by '\n'
+ *  - the client sends the start offset in decimal, terminated by '\n'
+ *  - the feeder sends the package from the start offset and closes the connection
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _PACKAGELOCAL_H
+#define _PACKAGELOCAL_H
+
+#include <lwm2mcore/update.h>
+#include <lwm2mcorePackageDownloader.h>
+#include <legato.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Schemes of the local package URIs
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGELOCAL_FILE_SCHEME        "file://"
+#define PACKAGELOCAL_FEEDER_SCHEME      "unix://"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default directory of the local packages
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGELOCAL_DEFAULT_DIR        "/legato/packages"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the directory of the local packages. The package files and feeder sockets must be in this
+ * directory or one of its subdirectories.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  The directory is not an absolute path
+ *  - LE_OVERFLOW       The directory path is too long
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageLocal_SetAllowedDir
+(
+    const char* dirPtr      ///< [IN] Absolute path of the directory
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a package URI designates a local source
+ *
+ * @return
+ *  - true if the package is read from a local file or feeder
+ */
+//--------------------------------------------------------------------------------------------------
+bool packageLocal_IsLocalUri
+(
+    const char* uriPtr      ///< [IN] Package URI
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the size of a local package
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  The URI is not a valid local URI
+ *  - LE_NOT_PERMITTED  The package is outside of the allowed directory
+ *  - LE_FAULT          The package is not available
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageLocal_GetPackageSize
+(
+    const char* uriPtr,         ///< [IN]  Package URI
+    uint64_t* packageSizePtr    ///< [OUT] Package size
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize download callback function of a local package: the file is opened or the feeder is
+ * connected
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packageLocal_InitDownload
+(
+    char* uriPtr,   ///< [IN] Package URI
+    void* ctxPtr    ///< [IN] Context pointer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get package information callback function of a local package
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packageLocal_GetInfo
+(
+    lwm2mcore_PackageDownloaderData_t* dataPtr, ///< [IN] Package downloader data pointer
+    void*                              ctxPtr   ///< [IN] Context pointer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download callback function of a local package: the package is read from startOffset
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_SUSPEND   The download is suspended
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packageLocal_Download
+(
+    uint64_t    startOffset,    ///< [IN] Start offset for the download
+    void*       ctxPtr          ///< [IN] Context pointer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End download callback function of a local package
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packageLocal_EndDownload
+(
+    void* ctxPtr    ///< [IN] Context pointer
+);
+
+#endif /* _PACKAGELOCAL_H */
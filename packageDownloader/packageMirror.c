@@ -0,0 +1,570 @@
+/**
+ * @file packageMirror.c
+ *
+ * Alternate sources of an HTTP(S) update package.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include <legato.h>
+#include <interfaces.h>
+#include <lwm2mcore/update.h>
+#include <avcFs.h>
+#include <avcFsConfig.h>
+#include "packageMirror.h"
+#include "downloadShaper.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of milliseconds in a second
+ */
+//--------------------------------------------------------------------------------------------------
+#define SECS_TO_MSECS                   1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Throughput ratio above which a faster source is selected
+ */
+//--------------------------------------------------------------------------------------------------
+#define SWITCH_THROUGHPUT_RATIO         2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Current configuration
+ */
+//--------------------------------------------------------------------------------------------------
+static packageMirror_Config_t Config =
+{
+    .baseUri = { { 0 } },
+    .rangeSize = PACKAGEMIRROR_DEFAULT_RANGE_SIZE,
+    .lowThroughput = PACKAGEMIRROR_DEFAULT_LOW_THROUGHPUT,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex to prevent race condition between the download thread and the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t MirrorMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&MirrorMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&MirrorMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a configuration is valid
+ *
+ * @return
+ *  - true if the configuration can be used
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsConfigValid
+(
+    const packageMirror_Config_t* configPtr     ///< [IN] Configuration
+)
+{
+    int i;
+
+    if (PACKAGEMIRROR_MIN_RANGE_SIZE > configPtr->rangeSize)
+    {
+        return false;
+    }
+
+    for (i = 0; i < PACKAGEMIRROR_MAX_MIRRORS; i++)
+    {
+        if (NULL == memchr(configPtr->baseUri[i], '\0', sizeof(configPtr->baseUri[i])))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a source at the end of the list, unless it is already in the list
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddSource
+(
+    packageMirror_List_t*  listPtr,             ///< [IN] Sources of the package
+    const char*            uriPtr,              ///< [IN] Source URI, not necessarily terminated
+    size_t                 len,                 ///< [IN] Length of the source URI
+    packageMirror_Origin_t origin               ///< [IN] Origin of the source
+)
+{
+    packageMirror_Source_t* sourcePtr;
+    size_t i;
+
+    if ((0 == len) || (LWM2MCORE_PACKAGE_URI_MAX_BYTES <= len))
+    {
+        LE_WARN("Invalid source length %zu", len);
+        return;
+    }
+
+    if (PACKAGEMIRROR_MAX_SOURCES <= listPtr->count)
+    {
+        LE_WARN("Too many sources, %.*s skipped", (int)len, uriPtr);
+        return;
+    }
+
+    for (i = 0; i < listPtr->count; i++)
+    {
+        if (   (len == strlen(listPtr->source[i].uri))
+            && (0 == strncmp(listPtr->source[i].uri, uriPtr, len)))
+        {
+            return;
+        }
+    }
+
+    sourcePtr = &listPtr->source[listPtr->count];
+    memset(sourcePtr, 0, sizeof(packageMirror_Source_t));
+    memcpy(sourcePtr->uri, uriPtr, len);
+    sourcePtr->uri[len] = '\0';
+    sourcePtr->origin = origin;
+    listPtr->count++;
+
+    LE_DEBUG("Source %zu: %s", listPtr->count - 1, sourcePtr->uri);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the path of a URI, after the scheme and the host. A URI without scheme is a path.
+ *
+ * @return
+ *  - Path of the URI, empty if the URI has no path
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* GetPath
+(
+    const char* uriPtr      ///< [IN] URI
+)
+{
+    const char* hostPtr = strstr(uriPtr, "://");
+    const char* pathPtr;
+
+    if (NULL == hostPtr)
+    {
+        return uriPtr;
+    }
+
+    pathPtr = strchr(hostPtr + strlen("://"), '/');
+
+    return (NULL == pathPtr) ? "" : pathPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the mirrors: read the stored configuration
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_Init
+(
+    void
+)
+{
+    packageMirror_Config_t config;
+    size_t size;
+
+    if (LE_OK != ExistsFs(PACKAGE_MIRROR_CONFIG_FILENAME))
+    {
+        return LE_OK;
+    }
+
+    size = sizeof(packageMirror_Config_t);
+    if (   (LE_OK != ReadFs(PACKAGE_MIRROR_CONFIG_FILENAME, (uint8_t*)&config, &size))
+        || (sizeof(packageMirror_Config_t) != size)
+        || (false == IsConfigValid(&config)))
+    {
+        LE_ERROR("Failed to read %s", PACKAGE_MIRROR_CONFIG_FILENAME);
+        return LE_FAULT;
+    }
+
+    LOCK();
+    Config = config;
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set and store the mirror configuration
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer or invalid range size provided
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_SetConfig
+(
+    const packageMirror_Config_t* configPtr     ///< [IN] New configuration
+)
+{
+    le_result_t result;
+
+    if ((!configPtr) || (false == IsConfigValid(configPtr)))
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+    Config = *configPtr;
+    result = WriteFs(PACKAGE_MIRROR_CONFIG_FILENAME,
+                     (uint8_t*)&Config,
+                     sizeof(packageMirror_Config_t));
+    UNLOCK();
+
+    if (LE_OK != result)
+    {
+        LE_ERROR("Failed to write %s: %s", PACKAGE_MIRROR_CONFIG_FILENAME, LE_RESULT_TXT(result));
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the mirror configuration
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_GetConfig
+(
+    packageMirror_Config_t* configPtr           ///< [OUT] Current configuration
+)
+{
+    if (!configPtr)
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    LOCK();
+    *configPtr = Config;
+    UNLOCK();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the list of the sources of a package. The package URI is the first source, without its
+ * fragment. Duplicated sources and mirrors too long to be stored are skipped.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer or empty package URI provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_BuildList
+(
+    const char*           uriPtr,               ///< [IN] Package URI
+    packageMirror_List_t* listPtr               ///< [OUT] Sources of the package
+)
+{
+    packageMirror_Config_t config;
+    char uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES];
+    const char* fragmentPtr;
+    const char* pathPtr;
+    size_t len;
+    int i;
+
+    if ((!uriPtr) || (!listPtr) || ('\0' == uriPtr[0]) || ('#' == uriPtr[0]))
+    {
+        LE_ERROR("Invalid input parameter");
+        return LE_BAD_PARAMETER;
+    }
+
+    memset(listPtr, 0, sizeof(packageMirror_List_t));
+
+    // Package URI, without its fragment
+    fragmentPtr = strchr(uriPtr, '#');
+    len = (NULL == fragmentPtr) ? strlen(uriPtr) : (size_t)(fragmentPtr - uriPtr);
+    AddSource(listPtr, uriPtr, len, PACKAGEMIRROR_ORIGIN_PACKAGE_URI);
+    if (0 == listPtr->count)
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    // Mirrors provided by the server
+    if (   (NULL != fragmentPtr)
+        && (0 == strncmp(fragmentPtr, PACKAGEMIRROR_FRAGMENT, strlen(PACKAGEMIRROR_FRAGMENT))))
+    {
+        const char* mirrorPtr = fragmentPtr + strlen(PACKAGEMIRROR_FRAGMENT);
+        size_t maxCount = listPtr->count + PACKAGEMIRROR_MAX_MIRRORS;
+
+        while (('\0' != *mirrorPtr) && (listPtr->count < maxCount))
+        {
+            len = strcspn(mirrorPtr, ",");
+            if (len)
+            {
+                AddSource(listPtr, mirrorPtr, len, PACKAGEMIRROR_ORIGIN_SERVER);
+            }
+            mirrorPtr += len;
+            if (',' == *mirrorPtr)
+            {
+                mirrorPtr++;
+            }
+        }
+    }
+
+    // Mirrors configured on the device: the package path is appended to the base URI
+    packageMirror_GetConfig(&config);
+    pathPtr = GetPath(listPtr->source[0].uri);
+
+    for (i = 0; i < PACKAGEMIRROR_MAX_MIRRORS; i++)
+    {
+        len = strlen(config.baseUri[i]);
+        if (0 == len)
+        {
+            continue;
+        }
+
+        if (('/' == config.baseUri[i][len - 1]) && ('/' == pathPtr[0]))
+        {
+            len--;
+        }
+
+        if (sizeof(uri) <= (size_t)snprintf(uri, sizeof(uri), "%.*s%s",
+                                            (int)len, config.baseUri[i], pathPtr))
+        {
+            LE_WARN("Mirror URI too long, %s skipped", config.baseUri[i]);
+            continue;
+        }
+
+        AddSource(listPtr, uri, strlen(uri), PACKAGEMIRROR_ORIGIN_CONFIG);
+    }
+
+    LE_INFO("%zu source(s) for the package", listPtr->count);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the URI of the current source
+ *
+ * @return
+ *  - URI of the current source
+ */
+//--------------------------------------------------------------------------------------------------
+const char* packageMirror_GetCurrentUri
+(
+    const packageMirror_List_t* listPtr         ///< [IN] Sources of the package
+)
+{
+    return listPtr->source[listPtr->current].uri;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a range received from the current source and update its throughput
+ */
+//--------------------------------------------------------------------------------------------------
+void packageMirror_RecordRange
+(
+    packageMirror_List_t* listPtr,              ///< [IN] Sources of the package
+    uint64_t              numBytes,             ///< [IN] Number of bytes received
+    uint32_t              elapsedMs             ///< [IN] Duration of the range in milliseconds
+)
+{
+    packageMirror_Source_t* sourcePtr = &listPtr->source[listPtr->current];
+    uint64_t throughput;
+
+    throughput = (numBytes * SECS_TO_MSECS) / ((0 == elapsedMs) ? 1 : elapsedMs);
+    if (UINT32_MAX < throughput)
+    {
+        throughput = UINT32_MAX;
+    }
+    else if (0 == throughput)
+    {
+        // 0 means not measured
+        throughput = 1;
+    }
+
+    // Smooth the throughput over the ranges
+    if (sourcePtr->throughput)
+    {
+        throughput = (throughput + sourcePtr->throughput) / 2;
+    }
+
+    sourcePtr->throughput = (uint32_t)throughput;
+    sourcePtr->bytes += numBytes;
+    sourcePtr->ranges++;
+    sourcePtr->consecutiveFailures = 0;
+
+    LE_DEBUG("Source %zu: %"PRIu64" bytes in %"PRIu32" ms, %"PRIu32" bytes/s",
+             listPtr->current, numBytes, elapsedMs, sourcePtr->throughput);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a failure of the current source. A source failing too often, or with a fatal error, is
+ * not used anymore for the download.
+ */
+//--------------------------------------------------------------------------------------------------
+void packageMirror_RecordFailure
+(
+    packageMirror_List_t* listPtr,              ///< [IN] Sources of the package
+    uint64_t              numBytes,             ///< [IN] Bytes received before the failure
+    bool                  isFatal               ///< [IN] The source can not serve the package
+)
+{
+    packageMirror_Source_t* sourcePtr = &listPtr->source[listPtr->current];
+
+    sourcePtr->bytes += numBytes;
+    sourcePtr->failures++;
+    sourcePtr->consecutiveFailures++;
+
+    if ((isFatal) || (PACKAGEMIRROR_MAX_FAILURES <= sourcePtr->consecutiveFailures))
+    {
+        LE_WARN("Source %zu not used anymore: %s", listPtr->current, sourcePtr->uri);
+        sourcePtr->isDisabled = true;
+    }
+    else
+    {
+        LE_WARN("Source %zu failed %"PRIu32" time(s)",
+                listPtr->current, sourcePtr->consecutiveFailures);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the source used after a failure: the next source still in use, in preference order.
+ * The caller should wait before retrying a source which already failed, see consecutiveFailures.
+ *
+ * @return
+ *  - LE_OK         A source is selected
+ *  - LE_NOT_FOUND  No source can be used anymore
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_SelectAfterFailure
+(
+    packageMirror_List_t* listPtr               ///< [IN] Sources of the package
+)
+{
+    size_t i;
+
+    for (i = 1; i <= listPtr->count; i++)
+    {
+        size_t index = (listPtr->current + i) % listPtr->count;
+
+        if (false == listPtr->source[index].isDisabled)
+        {
+            if (index != listPtr->current)
+            {
+                LE_INFO("Switch to source %zu: %s", index, listPtr->source[index].uri);
+            }
+            listPtr->current = index;
+            return LE_OK;
+        }
+    }
+
+    LE_ERROR("No source available");
+    return LE_NOT_FOUND;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the source used for the next range, according to the measured throughputs:
+ *  - if the current source is slower than the configured low throughput, the next source not
+ *    measured yet or faster than the current one is tried
+ *  - otherwise, a source measured at least twice as fast as the current one is selected
+ *
+ * Sources which failed since their last range are not selected. The throughputs are not compared
+ * when the download shaper limits the rate below the low throughput.
+ *
+ * @return
+ *  - true if another source is selected
+ */
+//--------------------------------------------------------------------------------------------------
+bool packageMirror_SelectAfterRange
+(
+    packageMirror_List_t* listPtr               ///< [IN] Sources of the package
+)
+{
+    packageMirror_Source_t* currentPtr = &listPtr->source[listPtr->current];
+    downloadShaper_Config_t shaperConfig;
+    uint32_t lowThroughput;
+    uint32_t rateLimit;
+    size_t selected = listPtr->current;
+    size_t i;
+
+    LOCK();
+    lowThroughput = Config.lowThroughput;
+    UNLOCK();
+
+    // A throughput limited by the shaper says nothing about the source
+    downloadShaper_GetConfig(&shaperConfig);
+    rateLimit = shaperConfig.rateLimit[downloadShaper_GetBearer()];
+    if ((0 != rateLimit) && (rateLimit <= lowThroughput))
+    {
+        return false;
+    }
+
+    for (i = 1; i < listPtr->count; i++)
+    {
+        size_t index = (listPtr->current + i) % listPtr->count;
+        packageMirror_Source_t* sourcePtr = &listPtr->source[index];
+
+        // A failing source is only used when the others fail
+        if ((sourcePtr->isDisabled) || (sourcePtr->consecutiveFailures))
+        {
+            continue;
+        }
+
+        if ((lowThroughput) && (currentPtr->throughput < lowThroughput))
+        {
+            // Try the next source which might be faster
+            if (   (0 == sourcePtr->throughput)
+                || (currentPtr->throughput < sourcePtr->throughput))
+            {
+                selected = index;
+                break;
+            }
+        }
+        else if (((uint64_t)currentPtr->throughput * SWITCH_THROUGHPUT_RATIO)
+                 <= (uint64_t)sourcePtr->throughput)
+        {
+            // Select the fastest source
+            if (   (selected == listPtr->current)
+                || (listPtr->source[selected].throughput < sourcePtr->throughput))
+            {
+                selected = index;
+            }
+        }
+    }
+
+    if (selected == listPtr->current)
+    {
+        return false;
+    }
+
+    LE_INFO("Switch to source %zu (%"PRIu32" bytes/s on source %zu): %s",
+            selected, currentPtr->throughput, listPtr->current, listPtr->source[selected].uri);
+    listPtr->current = selected;
+
+    return true;
+}
@@ -0,0 +1,276 @@
+/**
+ * @file packageMirror.h
+ *
+ * Alternate sources of an HTTP(S) update package.
+ *
+ * Besides the package URI written by the server, a package can be downloaded from mirrors:
+ *  - mirrors provided by the server in the package URI fragment, which is never sent to the
+ *    HTTP server: <uri>#mirrors=<uri1>,<uri2>
+ *  - mirrors configured on the device, e.g. an on-site cache. A configured mirror is a base URI
+ *    to which the path of the package URI is appended.
+ *
+ * The sources are tried in this order: package URI, server mirrors, configured mirrors. When
+ * several sources are available, the package is downloaded by ranges. A source is left at a range
+ * boundary when it fails or when its throughput is too low, and the download resumes from the
+ * current offset on the next source. A source is used only if it serves a package of the same
+ * size, and all the sources feed the same package parser, which verifies the package hash and
+ * signature at the end of the download.
+ *
+ * The health of each source (received bytes, throughput, failures) is recorded for the current
+ * download.
+ *
+ * The configuration is read by avcServer from the config tree and is reloaded when it changes:
+ * @verbatim
+   /apps/avcService/packageMirrors/baseUri/<0|1|2>  base URI of a configured mirror
+   /apps/avcService/packageMirrors/rangeSize        bytes, at least 1024
+   /apps/avcService/packageMirrors/lowThroughput    bytes per second, 0: switch on failures only
+   @endverbatim
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _PACKAGEMIRROR_H
+#define _PACKAGEMIRROR_H
+
+#include <lwm2mcore/update.h>
+#include <legato.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fragment of the package URI introducing the server mirrors, separated by commas
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGEMIRROR_FRAGMENT              "#mirrors="
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of mirrors provided by the server and of mirrors configured on the device
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGEMIRROR_MAX_MIRRORS           3
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of sources of a package, including the package URI
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGEMIRROR_MAX_SOURCES           (2 * PACKAGEMIRROR_MAX_MIRRORS + 1)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default and minimum size of the ranges requested when several sources are available
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGEMIRROR_DEFAULT_RANGE_SIZE    (256 * 1024)
+#define PACKAGEMIRROR_MIN_RANGE_SIZE        1024
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default throughput, in bytes per second, under which another source is tried
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGEMIRROR_DEFAULT_LOW_THROUGHPUT (16 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of consecutive failures after which a source is not used anymore for the download
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGEMIRROR_MAX_FAILURES          5
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mirror configuration
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char     baseUri[PACKAGEMIRROR_MAX_MIRRORS][LWM2MCORE_PACKAGE_URI_MAX_BYTES];
+                                ///< Base URIs of the configured mirrors, empty if not used
+    uint32_t rangeSize;         ///< Size of the ranges requested when several sources are available
+    uint32_t lowThroughput;     ///< Throughput in bytes per second under which another source is
+                                ///< tried, 0 to leave a source only when it fails
+}
+packageMirror_Config_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Origin of a source
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    PACKAGEMIRROR_ORIGIN_PACKAGE_URI = 0,   ///< Package URI written by the server
+    PACKAGEMIRROR_ORIGIN_SERVER,            ///< Mirror provided in the package URI fragment
+    PACKAGEMIRROR_ORIGIN_CONFIG             ///< Mirror configured on the device
+}
+packageMirror_Origin_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Source of a package and its health
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char                   uri[LWM2MCORE_PACKAGE_URI_MAX_BYTES];    ///< Source URI
+    packageMirror_Origin_t origin;              ///< Origin of the source
+    bool                   isVerified;          ///< The source serves the same package
+    bool                   isDisabled;          ///< The source is not used anymore
+    uint32_t               failures;            ///< Number of failures
+    uint32_t               consecutiveFailures; ///< Number of failures since the last range
+    uint32_t               ranges;              ///< Number of ranges received
+    uint64_t               bytes;               ///< Number of bytes received
+    uint32_t               throughput;          ///< Smoothed throughput in bytes per second,
+                                                ///< 0 if not measured
+}
+packageMirror_Source_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sources of a package
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    packageMirror_Source_t source[PACKAGEMIRROR_MAX_SOURCES];   ///< Sources, in preference order
+    size_t                 count;                               ///< Number of sources
+    size_t                 current;                             ///< Index of the current source
+}
+packageMirror_List_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the mirrors: read the stored configuration
+ *
+ * @return
+ *  - LE_OK     The function succeeded
+ *  - LE_FAULT  The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set and store the mirror configuration
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer or invalid range size provided
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_SetConfig
+(
+    const packageMirror_Config_t* configPtr     ///< [IN] New configuration
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the mirror configuration
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_GetConfig
+(
+    packageMirror_Config_t* configPtr           ///< [OUT] Current configuration
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the list of the sources of a package. The package URI is the first source, without its
+ * fragment. Duplicated sources and mirrors too long to be stored are skipped.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_BAD_PARAMETER  Null pointer or empty package URI provided
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_BuildList
+(
+    const char*           uriPtr,               ///< [IN] Package URI
+    packageMirror_List_t* listPtr               ///< [OUT] Sources of the package
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the URI of the current source
+ *
+ * @return
+ *  - URI of the current source
+ */
+//--------------------------------------------------------------------------------------------------
+const char* packageMirror_GetCurrentUri
+(
+    const packageMirror_List_t* listPtr         ///< [IN] Sources of the package
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a range received from the current source and update its throughput
+ */
+//--------------------------------------------------------------------------------------------------
+void packageMirror_RecordRange
+(
+    packageMirror_List_t* listPtr,              ///< [IN] Sources of the package
+    uint64_t              numBytes,             ///< [IN] Number of bytes received
+    uint32_t              elapsedMs             ///< [IN] Duration of the range in milliseconds
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a failure of the current source. A source failing too often, or with a fatal error, is
+ * not used anymore for the download.
+ */
+//--------------------------------------------------------------------------------------------------
+void packageMirror_RecordFailure
+(
+    packageMirror_List_t* listPtr,              ///< [IN] Sources of the package
+    uint64_t              numBytes,             ///< [IN] Bytes received before the failure
+    bool                  isFatal               ///< [IN] The source can not serve the package
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the source used after a failure: the next source still in use, in preference order.
+ * The caller should wait before retrying a source which already failed, see consecutiveFailures.
+ *
+ * @return
+ *  - LE_OK         A source is selected
+ *  - LE_NOT_FOUND  No source can be used anymore
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packageMirror_SelectAfterFailure
+(
+    packageMirror_List_t* listPtr               ///< [IN] Sources of the package
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the source used for the next range, according to the measured throughputs:
+ *  - if the current source is slower than the configured low throughput, the next source not
+ *    measured yet or faster than the current one is tried
+ *  - otherwise, a source measured at least twice as fast as the current one is selected
+ *
+ * Sources which failed since their last range are not selected. The throughputs are not compared
+ * when the download shaper limits the rate below the low throughput.
+ *
+ * @return
+ *  - true if another source is selected
+ */
+//--------------------------------------------------------------------------------------------------
+bool packageMirror_SelectAfterRange
+(
+    packageMirror_List_t* listPtr               ///< [IN] Sources of the package
+);
+
+#endif /* _PACKAGEMIRROR_H */
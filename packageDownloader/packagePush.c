@@ -0,0 +1,563 @@
+/**
+ * @file packagePush.c
+ *
+ * Push delivery of update packages over the LwM2M session.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include <legato.h>
+#include <interfaces.h>
+#include <poll.h>
+#include <pthread.h>
+#include <lwm2mcore/update.h>
+#include <lwm2mcorePackageDownloader.h>
+#include "packageDownloader.h"
+#include "packagePush.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the buffer used to read the package in the package downloader thread
+ */
+//--------------------------------------------------------------------------------------------------
+#define READ_BUFFER_SIZE                4096
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Period used to check the download status while waiting for the package, in ms
+ */
+//--------------------------------------------------------------------------------------------------
+#define POLL_PERIOD_MS                  200
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write end of the pipe of the transfer, used by the main thread
+ */
+//--------------------------------------------------------------------------------------------------
+static int WriteFd = -1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read end of the pipe of the transfer, until it is taken by the package downloader thread in
+ * packagePush_InitDownload(). The main thread closes it only if it was not taken.
+ */
+//--------------------------------------------------------------------------------------------------
+static int ReadFd = -1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read end of the pipe taken by the package downloader thread, and closed by this thread at the
+ * end of the download. Only used by the package downloader thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static int DownloadFd = -1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mutex to prevent race condition between the download thread and the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_mutex_t PushMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro used to prevent race condition between threads.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOCK()    LE_FATAL_IF((pthread_mutex_lock(&PushMutex)!=0), \
+                               "Could not lock the mutex")
+#define UNLOCK()  LE_FATAL_IF((pthread_mutex_unlock(&PushMutex)!=0), \
+                               "Could not unlock the mutex")
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy of the pushed package, and number of bytes already written in the pipe
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t* PackagePtr = NULL;
+static size_t PackageLen = 0;
+static size_t WrittenLen = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Monitor of the write end of the pipe: the package is written when the pipe is writable
+ */
+//--------------------------------------------------------------------------------------------------
+static le_fdMonitor_Ref_t WriteMonitorRef = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the transfer: the package downloader reads the end of the pipe
+ */
+//--------------------------------------------------------------------------------------------------
+static void CloseTransfer
+(
+    void
+)
+{
+    if (NULL != WriteMonitorRef)
+    {
+        le_fdMonitor_Delete(WriteMonitorRef);
+        WriteMonitorRef = NULL;
+    }
+
+    free(PackagePtr);
+    PackagePtr = NULL;
+    PackageLen = 0;
+    WrittenLen = 0;
+
+    if (-1 != WriteFd)
+    {
+        close(WriteFd);
+        WriteFd = -1;
+    }
+
+    // The read end not taken by the package downloader is closed here
+    LOCK();
+    if (-1 != ReadFd)
+    {
+        close(ReadFd);
+        ReadFd = -1;
+    }
+    UNLOCK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the package in the pipe of the transfer, as much as the pipe accepts
+ *
+ * @return
+ *  - LE_OK         The pipe accepted what it could, the rest is written when it is writable
+ *  - LE_CLOSED     The package downloader closed the pipe
+ *  - LE_FAULT      The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WritePackage
+(
+    void
+)
+{
+    while (WrittenLen < PackageLen)
+    {
+        ssize_t count = write(WriteFd, PackagePtr + WrittenLen, PackageLen - WrittenLen);
+
+        if (count >= 0)
+        {
+            WrittenLen += (size_t)count;
+            continue;
+        }
+
+        if (EINTR == errno)
+        {
+            continue;
+        }
+
+        if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+        {
+            break;
+        }
+
+        if (EPIPE == errno)
+        {
+            LE_WARN("Transfer closed by the package downloader");
+            return LE_CLOSED;
+        }
+
+        LE_ERROR("Failed to write the package: %m");
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The pipe of the transfer is writable: write the package, and end the transfer once it is fully
+ * written
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteMonitorHandler
+(
+    int fd,                         ///< [IN] Write end of the pipe
+    short events                    ///< [IN] Events
+)
+{
+    if (LE_OK != WritePackage())
+    {
+        packageDownloader_SuspendDownload();
+        CloseTransfer();
+        return;
+    }
+
+    if (WrittenLen == PackageLen)
+    {
+        LE_INFO("Pushed package written: %zu bytes", PackageLen);
+        CloseTransfer();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a package URI identifies a pushed package
+ *
+ * @return
+ *  - true if the package is pushed by the server
+ */
+//--------------------------------------------------------------------------------------------------
+bool packagePush_IsPushUri
+(
+    const char* uriPtr      ///< [IN] Package URI
+)
+{
+    return ((NULL != uriPtr) && (0 == strcmp(uriPtr, PACKAGEPUSH_URI)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a transfer is started. A transfer whose download ended, e.g. suspended, is closed.
+ *
+ * @return
+ *  - true if the package of a transfer is still written to the package downloader
+ */
+//--------------------------------------------------------------------------------------------------
+bool packagePush_IsStarted
+(
+    void
+)
+{
+    if ((NULL != WriteMonitorRef) && (!packageDownloader_IsDownloadInProgress()))
+    {
+        LE_INFO("Download of the pushed package ended at %zu bytes", WrittenLen);
+        CloseTransfer();
+    }
+
+    return (NULL != WriteMonitorRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prepare a transfer: the package is copied, to be written in the pipe of the transfer once the
+ * package downloader is started by packagePush_Start(). Nothing is started yet, a prepared
+ * transfer which is not started is released by packagePush_Cancel().
+ *
+ * @return
+ *  - LE_OK             The transfer is prepared
+ *  - LE_BAD_PARAMETER  A parameter is invalid
+ *  - LE_BUSY           A transfer or a download is in progress
+ *  - LE_NO_MEMORY      The package cannot be copied
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packagePush_Prepare
+(
+    const uint8_t* bufferPtr,       ///< [IN] Package
+    size_t len                      ///< [IN] Package length
+)
+{
+    int fds[2];
+
+    if ((NULL == bufferPtr) || (0 == len))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((packagePush_IsStarted()) || (packageDownloader_IsDownloadInProgress()))
+    {
+        LE_WARN("A download is still in progress, wait for its end");
+        return LE_BUSY;
+    }
+
+    CloseTransfer();
+
+    PackagePtr = malloc(len);
+    if (NULL == PackagePtr)
+    {
+        LE_ERROR("Unable to copy a package of %zu bytes", len);
+        return LE_NO_MEMORY;
+    }
+    memcpy(PackagePtr, bufferPtr, len);
+    PackageLen = len;
+
+    if (-1 == pipe2(fds, O_CLOEXEC))
+    {
+        LE_ERROR("Failed to create the pipe: %m");
+        CloseTransfer();
+        return LE_FAULT;
+    }
+
+    // The main thread never blocks on a full pipe, see WritePackage()
+    if (-1 == fcntl(fds[1], F_SETFL, O_NONBLOCK))
+    {
+        LE_ERROR("Failed to configure the pipe: %m");
+        close(fds[0]);
+        close(fds[1]);
+        CloseTransfer();
+        return LE_FAULT;
+    }
+
+    LOCK();
+    ReadFd = fds[0];
+    UNLOCK();
+    WriteFd = fds[1];
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the prepared transfer: the package downloader is started and reads the package
+ *
+ * @return
+ *  - LE_OK     The transfer is started
+ *  - LE_FAULT  The function failed, the transfer is released
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packagePush_Start
+(
+    lwm2mcore_UpdateType_t type,    ///< [IN] Update type
+    bool resume                     ///< [IN] Is it the resume of a pushed package?
+)
+{
+    if ((-1 == WriteFd) || (NULL != WriteMonitorRef))
+    {
+        LE_ERROR("No transfer prepared");
+        return LE_FAULT;
+    }
+
+    LE_INFO("Start the transfer of a pushed package of %zu bytes, resume %d", PackageLen, resume);
+    packageDownloader_StartDownload(PACKAGEPUSH_URI, type, resume);
+
+    if (!packageDownloader_IsDownloadInProgress())
+    {
+        LE_ERROR("Unable to start the package downloader");
+        CloseTransfer();
+        return LE_FAULT;
+    }
+
+    // The package is written from the event loop, when the pipe is writable
+    WriteMonitorRef = le_fdMonitor_Create("PackagePush", WriteFd, WriteMonitorHandler, POLLOUT);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a prepared transfer which is not started
+ */
+//--------------------------------------------------------------------------------------------------
+void packagePush_Cancel
+(
+    void
+)
+{
+    if (NULL == WriteMonitorRef)
+    {
+        CloseTransfer();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize download callback function of a pushed package
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packagePush_InitDownload
+(
+    char* uriPtr,   ///< [IN] Package URI
+    void* ctxPtr    ///< [IN] Context pointer
+)
+{
+    packageDownloader_DownloadCtx_t* dwlCtxPtr = (packageDownloader_DownloadCtx_t*)ctxPtr;
+
+    dwlCtxPtr->ctxPtr = NULL;
+
+    LE_DEBUG("Initialize pushed package download");
+
+    if (true == packageDownloader_CheckDownloadToAbort())
+    {
+        LE_INFO("Download aborted");
+        return DWL_ABORTED;
+    }
+
+    // The read end is owned by the package downloader thread from now on
+    LOCK();
+    DownloadFd = ReadFd;
+    ReadFd = -1;
+    UNLOCK();
+
+    if (-1 == DownloadFd)
+    {
+        LE_ERROR("No transfer started");
+        return DWL_FAULT;
+    }
+
+    return DWL_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get package information callback function of a pushed package: the size is unknown
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packagePush_GetInfo
+(
+    lwm2mcore_PackageDownloaderData_t* dataPtr, ///< [IN] Package downloader data pointer
+    void*                              ctxPtr   ///< [IN] Context pointer
+)
+{
+    LE_DEBUG("updateType: %d", dataPtr->updateType);
+
+    if (true == packageDownloader_CheckDownloadToAbort())
+    {
+        LE_INFO("Download aborted");
+        return DWL_ABORTED;
+    }
+
+    dataPtr->packageSize = 0;
+
+    return DWL_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download callback function of a pushed package: the package is fed to the package downloader
+ * from startOffset until the end of the transfer
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_SUSPEND   The download is suspended
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packagePush_Download
+(
+    uint64_t    startOffset,    ///< [IN] Start offset for the download
+    void*       ctxPtr          ///< [IN] Context pointer
+)
+{
+    uint8_t buffer[READ_BUFFER_SIZE];
+    uint64_t offset = 0;
+
+    LE_INFO("Pushed package stored from offset %"PRIu64, startOffset);
+
+    while (true)
+    {
+        struct pollfd pfd;
+        ssize_t count;
+        size_t skip = 0;
+        int rc;
+
+        if (true == packageDownloader_CheckDownloadToAbort())
+        {
+            LE_INFO("Download aborted");
+            return DWL_ABORTED;
+        }
+
+        if (true == packageDownloader_CheckDownloadToSuspend())
+        {
+            LE_INFO("Download suspended");
+            return DWL_SUSPEND;
+        }
+
+        pfd.fd = DownloadFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        rc = poll(&pfd, 1, POLL_PERIOD_MS);
+        if (-1 == rc)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            LE_ERROR("Failed to poll the pipe: %m");
+            return DWL_FAULT;
+        }
+
+        if (0 == rc)
+        {
+            continue;
+        }
+
+        count = read(DownloadFd, buffer, sizeof(buffer));
+        if (-1 == count)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            LE_ERROR("Failed to read the pipe: %m");
+            return DWL_FAULT;
+        }
+
+        // End of the transfer
+        if (0 == count)
+        {
+            if (true == packageDownloader_CheckDownloadToSuspend())
+            {
+                LE_INFO("Download suspended");
+                return DWL_SUSPEND;
+            }
+
+            if (offset < startOffset)
+            {
+                LE_ERROR("Transfer ended at %"PRIu64" before the resume offset", offset);
+                return DWL_FAULT;
+            }
+
+            LE_INFO("Pushed package received: %"PRIu64" bytes", offset);
+            return DWL_OK;
+        }
+
+        // The bytes already stored before the resume are dropped
+        if (offset < startOffset)
+        {
+            skip = ((startOffset - offset) < (uint64_t)count) ? (size_t)(startOffset - offset)
+                                                              : (size_t)count;
+        }
+        offset += (uint64_t)count;
+
+        if (   ((size_t)count > skip)
+            && (DWL_OK != lwm2mcore_PackageDownloaderReceiveData(buffer + skip,
+                                                                  (size_t)count - skip)))
+        {
+            LE_ERROR("Data processing stopped by DWL parser");
+            return DWL_FAULT;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End download callback function of a pushed package
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packagePush_EndDownload
+(
+    void* ctxPtr    ///< [IN] Context pointer
+)
+{
+    // The rest of the package written by the main thread fails with EPIPE
+    if (-1 != DownloadFd)
+    {
+        close(DownloadFd);
+        DownloadFd = -1;
+    }
+
+    return DWL_OK;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file packagePush.h
+ *
+ * Push delivery of update packages over the LwM2M session.
+ *
+ * Instead of writing a package URI, the server writes the package itself in the Package resource
+ * of the firmware or software update object. LwM2MCore calls lwm2mcore_PushUpdatePackage() with
+ * the whole package written in the resource, on the DTLS session. The package is copied and
+ * streamed through a pipe to the package downloader thread, which feeds it to the same package
+ * parser and store paths as an HTTP download: the package is verified and stored without a second
+ * connection.
+ *
+ * When a pushed package is resumed after an interruption, the server writes the whole package
+ * again: the bytes below the resume offset of the package downloader are dropped, the following
+ * ones are stored.
+ *
+ * The main thread never waits for the package downloader: the copy of the package is written in
+ * the pipe when the pipe is writable, and the pipe is closed once the whole package is written.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _PACKAGEPUSH_H
+#define _PACKAGEPUSH_H
+
+#include <lwm2mcore/lwm2mcore.h>
+#include <lwm2mcore/update.h>
+#include <lwm2mcorePackageDownloader.h>
+#include <legato.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Package URI stored in the resume information of a pushed package
+ */
+//--------------------------------------------------------------------------------------------------
+#define PACKAGEPUSH_URI                 "push:"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a package URI identifies a pushed package
+ *
+ * @return
+ *  - true if the package is pushed by the server
+ */
+//--------------------------------------------------------------------------------------------------
+bool packagePush_IsPushUri
+(
+    const char* uriPtr      ///< [IN] Package URI
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a transfer is started. A transfer whose download ended, e.g. suspended, is closed.
+ *
+ * @return
+ *  - true if the package of a transfer is still written to the package downloader
+ */
+//--------------------------------------------------------------------------------------------------
+bool packagePush_IsStarted
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prepare a transfer: the package is copied, to be written in the pipe of the transfer once the
+ * package downloader is started by packagePush_Start(). Nothing is started yet, a prepared
+ * transfer which is not started is released by packagePush_Cancel().
+ *
+ * @return
+ *  - LE_OK             The transfer is prepared
+ *  - LE_BAD_PARAMETER  A parameter is invalid
+ *  - LE_BUSY           A transfer or a download is in progress
+ *  - LE_NO_MEMORY      The package cannot be copied
+ *  - LE_FAULT          The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packagePush_Prepare
+(
+    const uint8_t* bufferPtr,       ///< [IN] Package
+    size_t len                      ///< [IN] Package length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the prepared transfer: the package downloader is started and reads the package
+ *
+ * @return
+ *  - LE_OK     The transfer is started
+ *  - LE_FAULT  The function failed, the transfer is released
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t packagePush_Start
+(
+    lwm2mcore_UpdateType_t type,    ///< [IN] Update type
+    bool resume                     ///< [IN] Is it the resume of a pushed package?
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a prepared transfer which is not started
+ */
+//--------------------------------------------------------------------------------------------------
+void packagePush_Cancel
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize download callback function of a pushed package
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packagePush_InitDownload
+(
+    char* uriPtr,   ///< [IN] Package URI
+    void* ctxPtr    ///< [IN] Context pointer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get package information callback function of a pushed package: the size is unknown
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_ABORTED   The download is aborted
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packagePush_GetInfo
+(
+    lwm2mcore_PackageDownloaderData_t* dataPtr, ///< [IN] Package downloader data pointer
+    void*                              ctxPtr   ///< [IN] Context pointer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download callback function of a pushed package: the package is fed to the package downloader
+ * from startOffset until the end of the transfer
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ *      - DWL_SUSPEND   The download is suspended
+ *      - DWL_ABORTED   The download is aborted
+ *      - DWL_FAULT     The function failed
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packagePush_Download
+(
+    uint64_t    startOffset,    ///< [IN] Start offset for the download
+    void*       ctxPtr          ///< [IN] Context pointer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End download callback function of a pushed package
+ *
+ * @return
+ *      - DWL_OK        The function succeeded
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_DwlResult_t packagePush_EndDownload
+(
+    void* ctxPtr    ///< [IN] Context pointer
+);
+
+#endif /* _PACKAGEPUSH_H */